@@ -46,7 +46,13 @@ load('jstests/libs/analyze_plan.js');
     explained = coll.explain().aggregate([{$match: {foo: {$gt: 0}}}, {$count: "count"}]);
     assert(planHasStage(db, explained.stages[0].$cursor.queryPlanner.winningPlan, "COUNT_SCAN"));
 
-    // A $match that is not a single range cannot use the COUNT_SCAN optimization.
-    explained = coll.explain().aggregate([{$match: {foo: {$in: [0, 1]}}}, {$count: "count"}]);
-    assert(!planHasStage(db, explained.stages[0].$cursor.queryPlanner.winningPlan, "COUNT_SCAN"));
+    // A $match on several intervals can also use the COUNT_SCAN optimization, which seeks over the
+    // keys between the intervals.
+    const multiIntervalPipeline = [{$match: {foo: {$in: [0, 2]}}}, {$count: "count"}];
+    assert.eq(coll.aggregate(multiIntervalPipeline).toArray(), [{count: 10}]);
+    explained = coll.explain("executionStats").aggregate(multiIntervalPipeline);
+    const countScan = getAggPlanStage(explained, "COUNT_SCAN");
+    assert.neq(null, countScan, explained);
+    assert.eq({foo: ["[0.0, 0.0]", "[2.0, 2.0]"]}, countScan.indexBounds, countScan);
+    assert.eq(2, countScan.seeks, countScan);
 }());
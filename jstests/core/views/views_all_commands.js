@@ -407,6 +407,12 @@
         refineCollectionShardKey: {skip: isUnrelated},
         refreshLogicalSessionCacheNow: {skip: isAnInternalCommand},
         reapLogicalSessionCacheNow: {skip: isAnInternalCommand},
+        refreshMaterializedView: {
+            command: {refreshMaterializedView: "view"},
+            expectFailure: true,
+            expectedErrorCode: ErrorCodes.NamespaceNotFound,
+            skipSharded: true,
+        },
         refreshSessions: {skip: isUnrelated},
         restartCatalog: {skip: isAnInternalCommand},
         reIndex: {command: {reIndex: "view"}, expectFailure: true},
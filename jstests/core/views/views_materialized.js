@@ -0,0 +1,103 @@
+// Tests creating, reading, maintaining and refreshing materialized views.
+// @tags: [
+//   assumes_against_mongod_not_mongos,
+//   assumes_superuser_permissions,
+//   does_not_support_stepdowns,
+//   requires_non_retryable_commands,
+//   requires_non_retryable_writes,
+// ]
+
+(function() {
+    "use strict";
+
+    // For arrayEq.
+    load("jstests/aggregation/extras/utils.js");
+
+    let viewsDB = db.getSiblingDB("views_materialized");
+    assert.commandWorked(viewsDB.dropDatabase());
+
+    let coll = viewsDB.getCollection("collection");
+    let bulk = coll.initializeUnorderedBulkOp();
+    bulk.insert({_id: "New York", state: "NY", pop: 7});
+    bulk.insert({_id: "Oakland", state: "CA", pop: 3});
+    bulk.insert({_id: "Palo Alto", state: "CA", pop: 10});
+    bulk.insert({_id: "San Francisco", state: "CA", pop: 4});
+    bulk.insert({_id: "Trenton", state: "NJ", pop: 5});
+    assert.writeOK(bulk.execute());
+
+    let isStale = function(viewName) {
+        let res = viewsDB.runCommand({listCollections: 1, filter: {name: viewName}});
+        assert.commandWorked(res);
+        assert.eq(res.cursor.firstBatch.length, 1, tojson(res));
+        let entry = res.cursor.firstBatch[0];
+        assert.eq(entry.type, "view", tojson(entry));
+        assert(entry.options.materialized, tojson(entry));
+        return entry.info.stale;
+    };
+
+    // Checks that the view returns the results of its pipeline run on the collection.
+    let assertViewMatchesPipeline = function(viewName, pipeline) {
+        let expected = coll.aggregate(pipeline).toArray();
+        let actual = viewsDB.getCollection(viewName).find().toArray();
+        assert(arrayEq(actual, expected),
+               "actual: " + tojson(actual) + ", expected: " + tojson(expected));
+    };
+
+    // Creating a materialized view fills its backing collection, which is read from from then on.
+    const popByState = [{$match: {pop: {$gt: 0}}}, {$group: {_id: "$state", pop: {$sum: "$pop"}}}];
+    assert.commandWorked(viewsDB.runCommand(
+        {create: "popByState", viewOn: "collection", pipeline: popByState, materialized: true}));
+    assert(!isStale("popByState"));
+    assert.eq(viewsDB.getCollection("system.materialized.popByState").count(), 3);
+    assertViewMatchesPipeline("popByState", popByState);
+
+    // Clients cannot write to the backing collection.
+    assert.writeErrorWithCode(
+        viewsDB.getCollection("system.materialized.popByState").insert({_id: "TX"}),
+        ErrorCodes.InvalidNamespace);
+
+    // Inserts, updates and deletes are applied to the backing collection as they happen.
+    assert.writeOK(coll.insert({_id: "Austin", state: "TX", pop: 9}));
+    assert.writeOK(coll.update({_id: "Oakland"}, {$inc: {pop: 2}}));
+    assert.writeOK(coll.update({_id: "New York"}, {_id: "New York", state: "NY", pop: 8}));
+    assert.writeOK(coll.remove({_id: "Trenton"}));
+    assert(!isStale("popByState"));
+    assertViewMatchesPipeline("popByState", popByState);
+
+    // A view which cannot be maintained incrementally becomes stale on the first write, and is read
+    // through its pipeline until it is refreshed.
+    const largestCities = [{$sort: {pop: -1}}, {$limit: 2}, {$project: {_id: 1, pop: 1}}];
+    assert.commandWorked(viewsDB.runCommand({
+        create: "largestCities",
+        viewOn: "collection",
+        pipeline: largestCities,
+        materialized: true
+    }));
+    assert(!isStale("largestCities"));
+    assertViewMatchesPipeline("largestCities", largestCities);
+
+    assert.writeOK(coll.insert({_id: "Los Angeles", state: "CA", pop: 12}));
+    assert(isStale("largestCities"));
+    assertViewMatchesPipeline("largestCities", largestCities);
+
+    assert.commandWorked(viewsDB.runCommand({refreshMaterializedView: "largestCities"}));
+    assert(!isStale("largestCities"));
+    assertViewMatchesPipeline("largestCities", largestCities);
+
+    // Refreshing a view which is up to date recomputes the same results.
+    assert.commandWorked(viewsDB.runCommand({refreshMaterializedView: "popByState"}));
+    assert(!isStale("popByState"));
+    assertViewMatchesPipeline("popByState", popByState);
+
+    // Only materialized views can be refreshed.
+    assert.commandWorked(
+        viewsDB.createView("californiaCities", "collection", [{$match: {state: "CA"}}]));
+    assert.commandFailedWithCode(viewsDB.runCommand({refreshMaterializedView: "californiaCities"}),
+                                 ErrorCodes.NamespaceNotFound);
+    assert.commandFailedWithCode(viewsDB.runCommand({refreshMaterializedView: "collection"}),
+                                 ErrorCodes.NamespaceNotFound);
+
+    // Dropping a materialized view drops its backing collection.
+    assert(viewsDB.getCollection("popByState").drop());
+    assert.eq(viewsDB.getCollectionInfos({name: "system.materialized.popByState"}).length, 0);
+}());
@@ -49,16 +49,20 @@
     countScan = getAggPlanStage(explain, "COUNT_SCAN");
     assert.eq(null, countScan, explain);
 
-    // When the count consists of multiple intervals, we cannot use COUNT_SCAN.
-    assert.eq(2, coll.count({a: {$in: [3, 4]}}));
-    assert.eq(2, coll.find({a: {$in: [3, 4]}}).itcount());
-    assert.eq(2, coll.aggregate([{$match: {a: {$in: [3, 4]}}}, {$count: "count"}]).next().count);
-    explain = coll.explain().aggregate([{$match: {a: {$in: [3, 4]}}}, {$count: "count"}]);
+    // When the count consists of multiple intervals, COUNT_SCAN seeks over the keys between them.
+    assert.eq(2, coll.count({a: {$in: [0, 4]}}));
+    assert.eq(2, coll.find({a: {$in: [0, 4]}}).itcount());
+    assert.eq(2, coll.aggregate([{$match: {a: {$in: [0, 4]}}}, {$count: "count"}]).next().count);
+    explain = coll.explain("executionStats").aggregate([
+        {$match: {a: {$in: [0, 4]}}},
+        {$count: "count"}
+    ]);
     countScan = getAggPlanStage(explain, "COUNT_SCAN");
-    assert.eq(null, countScan, explain);
-    let ixscan = getAggPlanStage(explain, "IXSCAN");
-    assert.neq(null, ixscan, explain);
-    assert.eq({$_path: 1, a: 1}, ixscan.keyPattern, ixscan);
+    assert.neq(null, countScan, explain);
+    assert.eq({$_path: 1, a: 1}, countScan.keyPattern, countScan);
+    assert.eq(["[0.0, 0.0]", "[4.0, 4.0]"], countScan.indexBounds.a, countScan);
+    assert.eq(2, countScan.seeks, countScan);
+    assert.eq(null, getAggPlanStage(explain, "IXSCAN"), explain);
 
     // Count with an equality match on an empty array cannot use COUNT_SCAN.
     assert.eq(2, coll.count({a: {$eq: []}}));
@@ -67,7 +71,7 @@
     explain = coll.explain().count({a: {$eq: []}});
     countScan = getPlanStage(explain.queryPlanner.winningPlan, "COUNT_SCAN");
     assert.eq(null, countScan, explain);
-    ixscan = getPlanStage(explain.queryPlanner.winningPlan, "IXSCAN");
+    let ixscan = getPlanStage(explain.queryPlanner.winningPlan, "IXSCAN");
     assert.neq(null, ixscan, explain);
     assert.eq({$_path: 1, a: 1}, ixscan.keyPattern, ixscan);
 
@@ -72,6 +72,7 @@
 #include "monger/db/storage/key_string.h"
 #include "monger/db/storage/record_store.h"
 #include "monger/db/update/update_driver.h"
+#include "monger/db/views/materialized_view_op_observer.h"
 
 #include "monger/db/auth/user_document_parser.h"  // XXX-ANDY
 #include "monger/rpc/object_check.h"
@@ -733,6 +734,13 @@ StatusWith<RecordData> CollectionImpl::updateDocumentWithDamages(
     invariant(oldRec.snapshotId() == opCtx->recoveryUnit()->getSnapshotId());
     invariant(updateWithDamagesSupported());
 
+    // The caller provides the pre-image when the oplog needs it. It is otherwise only copied for
+    // the materialized views on this collection, and must be taken before the record is modified
+    // in place.
+    if (!args->preImageDoc && MaterializedViewOpObserver::needsPreImages(opCtx, ns())) {
+        args->preImageDoc = oldRec.value().toBson().getOwned();
+    }
+
     auto newRecStatus =
         _recordStore->updateWithDamages(opCtx, loc, oldRec.value(), damageSource, damages);
 
@@ -243,6 +243,8 @@ Status CollectionOptions::parse(const BSONObj& options, ParseKind kind) {
             }
 
             pipeline = e.Obj().getOwned();
+        } else if (fieldName == "materialized") {
+            materialized = e.trueValue();
         } else if (fieldName == "idIndex" && kind == parseForCommand) {
             if (e.type() != monger::Object) {
                 return Status(ErrorCodes::TypeMismatch, "'idIndex' has to be an object.");
@@ -266,6 +268,10 @@ Status CollectionOptions::parse(const BSONObj& options, ParseKind kind) {
         return Status(ErrorCodes::BadValue, "'pipeline' cannot be specified without 'viewOn'");
     }
 
+    if (viewOn.empty() && materialized) {
+        return Status(ErrorCodes::BadValue, "'materialized' cannot be specified without 'viewOn'");
+    }
+
     return Status::OK();
 }
 
@@ -331,6 +337,10 @@ void CollectionOptions::appendBSON(BSONObjBuilder* builder) const {
         builder->appendArray("pipeline", pipeline);
     }
 
+    if (materialized) {
+        builder->appendBool("materialized", true);
+    }
+
     if (!idIndex.isEmpty()) {
         builder->append("idIndex", idIndex);
     }
@@ -412,6 +422,10 @@ bool CollectionOptions::matchesStorageOptions(const CollectionOptions& other,
         return false;
     }
 
+    if (materialized != other.materialized) {
+        return false;
+    }
+
     return true;
 }
 }
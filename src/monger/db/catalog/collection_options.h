@@ -142,5 +142,7 @@ struct CollectionOptions {
     std::string viewOn;
     // The aggregation pipeline that defines this view.
     BSONObj pipeline;
+    // Whether the results of this view are stored in a backing collection.
+    bool materialized = false;
 };
 }
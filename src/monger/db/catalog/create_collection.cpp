@@ -46,6 +46,7 @@
 #include "monger/db/operation_context.h"
 #include "monger/db/ops/insert.h"
 #include "monger/db/repl/replication_coordinator.h"
+#include "monger/db/views/view.h"
 #include "monger/logger/redaction.h"
 #include "monger/util/log.h"
 
@@ -59,6 +60,11 @@ Status _createView(OperationContext* opCtx,
     return writeConflictRetry(opCtx, "create", nss.ns(), [&] {
         AutoGetOrCreateDb autoDb(opCtx, nss.db(), MODE_IX);
         Lock::CollectionLock collLock(opCtx, nss, MODE_IX);
+        // A materialized view is created along with its backing collection.
+        boost::optional<Lock::CollectionLock> backingCollLock;
+        if (collectionOptions.materialized) {
+            backingCollLock.emplace(opCtx, ViewDefinition::makeBackingNss(nss), MODE_X);
+        }
         // Operations all lock system.views in the end to prevent deadlock.
         Lock::CollectionLock systemViewsLock(
             opCtx,
@@ -303,9 +303,15 @@ Status DatabaseImpl::dropView(OperationContext* opCtx, NamespaceString viewName)
     dassert(opCtx->lockState()->isCollectionLockedForMode(NamespaceString(_viewsName), MODE_X));
 
     auto views = ViewCatalog::get(this);
+    auto view = views->lookup(opCtx, viewName.ns());
     Status status = views->dropView(opCtx, viewName);
     Top::get(opCtx->getServiceContext()).collectionDropped(viewName);
-    return status;
+    if (!status.isOK() || !view || !view->isMaterialized())
+        return status;
+
+    // The backing collection goes away with the materialized view.
+    invariant(opCtx->lockState()->isCollectionLockedForMode(view->backingNss(), MODE_X));
+    return dropCollectionEvenIfSystem(opCtx, view->backingNss(), {});
 }
 
 Status DatabaseImpl::dropCollection(OperationContext* opCtx,
@@ -590,8 +596,44 @@ Status DatabaseImpl::createView(OperationContext* opCtx,
         return Status(ErrorCodes::InvalidNamespace,
                       str::stream() << "invalid namespace name for a view: " + viewName.toString());
 
-    return ViewCatalog::get(this)->createView(
-        opCtx, viewName, viewOnNss, BSONArray(options.pipeline), options.collation);
+    const auto backingNss = ViewDefinition::makeBackingNss(viewName);
+    if (options.materialized) {
+        dassert(opCtx->lockState()->isCollectionLockedForMode(backingNss, MODE_X));
+
+        if (serverGlobalParams.clusterRole == ClusterRole::ShardServer)
+            return Status(ErrorCodes::OptionNotSupportedOnView,
+                          "materialized views are not supported on shard servers");
+
+        if (!options.collation.isEmpty())
+            return Status(ErrorCodes::OptionNotSupportedOnView,
+                          "materialized views do not support a collation");
+
+        // Changes are only observed on the collection the view is defined on.
+        if (viewOnNss.isSystem() || ViewCatalog::get(this)->lookup(opCtx, viewOnNss.ns()))
+            return Status(ErrorCodes::OptionNotSupportedOnView,
+                          str::stream() << "materialized views must be defined on a collection "
+                                           "which is not a system collection, but "
+                                        << viewOnNss
+                                        << " is not");
+
+        if (getCollection(opCtx, backingNss))
+            return Status(ErrorCodes::NamespaceExists,
+                          str::stream() << "backing collection " << backingNss
+                                        << " already exists");
+    }
+
+    Status status = ViewCatalog::get(this)->createView(opCtx,
+                                                       viewName,
+                                                       viewOnNss,
+                                                       BSONArray(options.pipeline),
+                                                       options.collation,
+                                                       options.materialized);
+    if (!status.isOK() || !options.materialized)
+        return status;
+
+    // The view stays stale, and so is not read from this collection, until it is refreshed.
+    invariant(createCollection(opCtx, backingNss));
+    return Status::OK();
 }
 
 Collection* DatabaseImpl::createCollection(OperationContext* opCtx,
@@ -64,6 +64,11 @@ Status _dropView(OperationContext* opCtx,
         return Status(ErrorCodes::NamespaceNotFound, "ns not found");
     }
     Lock::CollectionLock collLock(opCtx, collectionName, MODE_IX);
+    // The backing collection of a materialized view is dropped along with it.
+    boost::optional<Lock::CollectionLock> backingCollLock;
+    if (view->isMaterialized()) {
+        backingCollLock.emplace(opCtx, view->backingNss(), MODE_X);
+    }
     // Operations all lock system.views in the end to prevent deadlock.
     Lock::CollectionLock systemViewsLock(opCtx, db->getSystemViewsName(), MODE_X);
 
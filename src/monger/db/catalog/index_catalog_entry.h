@@ -31,6 +31,7 @@
 
 #include <boost/optional.hpp>
 #include <functional>
+#include <memory>
 #include <string>
 
 #include "monger/base/owned_pointer_vector.h"
@@ -50,6 +51,7 @@ class CollectionInfoCache;
 class IndexAccessMethod;
 class IndexBuildInterceptor;
 class IndexDescriptor;
+class IndexStatistics;
 class MatchExpression;
 class OperationContext;
 
@@ -140,6 +142,13 @@ public:
     virtual void setMinimumVisibleSnapshot(const Timestamp name) = 0;
 
     virtual void setNs(NamespaceString ns) = 0;
+
+    /**
+     * Returns the statistics on this index's keys gathered by the analyze command, or null if the
+     * index has not been analyzed. They are loaded from the durable catalog when the entry is
+     * created, so refreshEntry() picks up newly persisted statistics.
+     */
+    virtual std::shared_ptr<IndexStatistics> getStatistics() const = 0;
 };
 
 class IndexCatalogEntryContainer {
@@ -49,6 +49,7 @@
 #include "monger/db/multi_key_path_tracker.h"
 #include "monger/db/operation_context.h"
 #include "monger/db/query/collation/collator_factory_interface.h"
+#include "monger/db/query/index_statistics.h"
 #include "monger/db/service_context.h"
 #include "monger/db/storage/durable_catalog.h"
 #include "monger/db/storage/durable_catalog.h"
@@ -112,6 +113,20 @@ IndexCatalogEntryImpl::IndexCatalogEntryImpl(OperationContext* const opCtx,
         LOG(2) << "have filter expression for " << _ns << " " << _descriptor->indexName() << " "
                << redact(filter);
     }
+
+    const BSONObj statistics = DurableCatalog::get(opCtx)->getIndexStatistics(
+        opCtx, collection->ns(), _descriptor->indexName());
+    if (!statistics.isEmpty()) {
+        auto swStatistics = IndexStatistics::parse(statistics);
+        if (swStatistics.isOK()) {
+            _statistics = std::move(swStatistics.getValue());
+        } else {
+            // Statistics only guide plan selection, so rather than fail, plan without them until
+            // the index is analyzed again.
+            warning() << "Ignoring statistics for index " << _descriptor->indexName() << " on "
+                      << _ns << ": " << swStatistics.getStatus();
+        }
+    }
 }
 
 IndexCatalogEntryImpl::~IndexCatalogEntryImpl() {
@@ -177,6 +177,10 @@ public:
      */
     void setMinimumVisibleSnapshot(Timestamp newMinimumVisibleSnapshot) final;
 
+    std::shared_ptr<IndexStatistics> getStatistics() const final {
+        return _statistics;
+    }
+
 private:
     class SetMultikeyChange;
 
@@ -242,5 +246,9 @@ private:
 
     // The earliest snapshot that is allowed to read this index.
     boost::optional<Timestamp> _minVisibleSnapshot;
+
+    // Loaded from the durable catalog when this entry is created. Null if the index has not been
+    // analyzed.
+    std::shared_ptr<IndexStatistics> _statistics;
 };
 }  // namespace monger
@@ -61,6 +61,7 @@
 #include "monger/db/ops/delete.h"
 #include "monger/db/query/collation/collation_spec.h"
 #include "monger/db/query/collation/collator_factory_interface.h"
+#include "monger/db/query/index_statistics.h"
 #include "monger/db/query/internal_plans.h"
 #include "monger/db/repl/replication_coordinator.h"
 #include "monger/db/server_options.h"
@@ -1282,6 +1283,11 @@ Status IndexCatalogImpl::_indexKeys(OperationContext* opCtx,
         if (keysInsertedOut) {
             *keysInsertedOut += result.numInserted;
         }
+        if (status.isOK()) {
+            if (auto statistics = index->getStatistics()) {
+                statistics->recordInsertedKeys(keys);
+            }
+        }
     }
 
     return status;
@@ -1379,6 +1385,12 @@ Status IndexCatalogImpl::_updateRecord(OperationContext* const opCtx,
                             &keysInserted);
     } else {
         status = iam->update(opCtx, updateTicket, &keysInserted, &keysDeleted);
+        if (status.isOK()) {
+            if (auto statistics = index->getStatistics()) {
+                statistics->recordDeletedKeys(updateTicket.removed);
+                statistics->recordInsertedKeys(updateTicket.added);
+            }
+        }
     }
 
     if (!status.isOK())
@@ -1444,6 +1456,8 @@ void IndexCatalogImpl::_unindexKeys(OperationContext* opCtx,
     if (!status.isOK()) {
         log() << "Couldn't unindex record " << redact(obj) << " from collection "
               << _collection->ns() << ". Status: " << redact(status);
+    } else if (auto statistics = index->getStatistics()) {
+        statistics->recordDeletedKeys(keys);
     }
 
     if (keysDeletedOut) {
@@ -0,0 +1,237 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::monger::logger::LogComponent::kStorage
+
+#include "monger/platform/basic.h"
+
+#include "monger/db/catalog/refresh_materialized_view.h"
+
+#include "monger/db/catalog/collection.h"
+#include "monger/db/catalog/database.h"
+#include "monger/db/catalog_raii.h"
+#include "monger/db/concurrency/d_concurrency.h"
+#include "monger/db/concurrency/write_conflict_exception.h"
+#include "monger/db/dbdirectclient.h"
+#include "monger/db/ops/write_ops.h"
+#include "monger/db/query/collation/collation_spec.h"
+#include "monger/db/query/cursor_response.h"
+#include "monger/db/repl/replication_coordinator.h"
+#include "monger/db/views/materialized_view_maintainer.h"
+#include "monger/db/views/view_catalog.h"
+#include "monger/util/log.h"
+
+namespace monger {
+
+namespace {
+
+Status setStale(OperationContext* opCtx,
+                Database* db,
+                const NamespaceString& viewName,
+                bool stale) {
+    return writeConflictRetry(opCtx, "refreshMaterializedView", viewName.ns(), [&] {
+        WriteUnitOfWork wuow(opCtx);
+        Lock::CollectionLock viewLock(opCtx, viewName, MODE_IX);
+        // Operations all lock system.views in the end to prevent deadlock.
+        Lock::CollectionLock systemViewsLock(opCtx, db->getSystemViewsName(), MODE_X);
+        auto status = ViewCatalog::get(db)->setMaterializedViewStale(opCtx, viewName, stale);
+        if (status.isOK()) {
+            wuow.commit();
+        }
+        return status;
+    });
+}
+
+/**
+ * Deletes every document of the backing collection 'collection', a batch at a time. It is written
+ * through the Collection, rather than with the delete command, since clients may not write to it.
+ */
+void clearBackingCollection(OperationContext* opCtx, Collection* collection) {
+    while (true) {
+        bool done = false;
+        writeConflictRetry(opCtx, "refreshMaterializedView", collection->ns().ns(), [&] {
+            WriteUnitOfWork wuow(opCtx);
+            std::vector<RecordId> batch;
+            {
+                auto cursor = collection->getCursor(opCtx);
+                while (batch.size() < write_ops::kMaxWriteBatchSize) {
+                    auto record = cursor->next();
+                    if (!record) {
+                        break;
+                    }
+                    batch.push_back(record->id);
+                }
+            }
+            for (auto&& rid : batch) {
+                collection->deleteDocument(opCtx, kUninitializedStmtId, rid, nullptr);
+            }
+            wuow.commit();
+            done = batch.size() < write_ops::kMaxWriteBatchSize;
+        });
+        if (done) {
+            return;
+        }
+    }
+}
+
+/**
+ * Inserts 'docs' into the backing collection 'collection' in one unit of work, and clears them.
+ */
+Status insertBatch(OperationContext* opCtx,
+                   Collection* collection,
+                   std::vector<InsertStatement>* docs,
+                   int* batchBytes) {
+    if (docs->empty()) {
+        return Status::OK();
+    }
+
+    auto status =
+        writeConflictRetry(opCtx, "refreshMaterializedView", collection->ns().ns(), [&] {
+            WriteUnitOfWork wuow(opCtx);
+            auto status = collection->insertDocuments(opCtx, docs->begin(), docs->end(), nullptr);
+            if (status.isOK()) {
+                wuow.commit();
+            }
+            return status;
+        });
+    docs->clear();
+    *batchBytes = 0;
+    return status;
+}
+
+}  // namespace
+
+Status refreshMaterializedView(OperationContext* opCtx, const NamespaceString& viewName) {
+    AutoGetDb autoDb(opCtx, viewName.db(), MODE_IX);
+    Database* db = autoDb.getDb();
+    auto view = db ? ViewCatalog::get(db)->lookup(opCtx, viewName.ns()) : nullptr;
+    if (!view || !view->isMaterialized()) {
+        return {ErrorCodes::NamespaceNotFound,
+                str::stream() << "cannot find materialized view " << viewName.ns()};
+    }
+
+    // Writes to the source collection are blocked until the backing collection has caught up with
+    // them, as they are not applied to the backing collection of a stale view.
+    Lock::CollectionLock sourceLock(opCtx, view->viewOn(), MODE_S);
+    Lock::CollectionLock backingLock(opCtx, view->backingNss(), MODE_X);
+
+    if (!repl::ReplicationCoordinator::get(opCtx)->canAcceptWritesFor(opCtx, viewName)) {
+        return {ErrorCodes::NotMaster,
+                str::stream() << "Not primary while refreshing materialized view "
+                              << viewName.ns()};
+    }
+
+    auto status = setStale(opCtx, db, viewName, true);
+    if (!status.isOK()) {
+        return status;
+    }
+
+    const auto& backingNss = view->backingNss();
+    auto backingColl = db->getCollection(opCtx, backingNss);
+    if (!backingColl) {
+        return {ErrorCodes::NamespaceNotFound,
+                str::stream() << "cannot find backing collection " << backingNss.ns()
+                              << " of materialized view "
+                              << viewName.ns()};
+    }
+
+    clearBackingCollection(opCtx, backingColl);
+
+    // The view is computed with the simple collation, with which the writes to the collection it
+    // is defined on are applied to it, rather than with the default collation of that collection.
+    DBDirectClient client(opCtx);
+    const auto shape = MaterializedViewMaintainer::classify(view->pipeline());
+    BSONArrayBuilder pipeline;
+    for (auto&& stage : MaterializedViewMaintainer::makeRefreshPipeline(view->pipeline())) {
+        pipeline.append(stage);
+    }
+    BSONObj reply;
+    client.runCommand(viewName.db().toString(),
+                      BSON("aggregate" << view->viewOn().coll() << "pipeline" << pipeline.arr()
+                                       << "collation"
+                                       << CollationSpec::kSimpleSpec
+                                       << "cursor"
+                                       << BSONObj()),
+                      reply);
+    auto cursor = CursorResponse::parseFromBSON(reply);
+    if (!cursor.isOK()) {
+        return cursor.getStatus();
+    }
+
+    std::vector<InsertStatement> docs;
+    int batchBytes = 0;
+    long long position = 0;
+    while (true) {
+        for (auto&& result : cursor.getValue().getBatch()) {
+            BSONObj doc = result;
+            if (shape == MaterializedViewMaintainer::Shape::kRefreshOnly) {
+                doc = BSON("_id" << position++ << MaterializedViewMaintainer::kResultFieldName
+                                 << result);
+            } else if (shape == MaterializedViewMaintainer::Shape::kGroup) {
+                status = MaterializedViewMaintainer::validateBackingId(Value(result["_id"]));
+                if (!status.isOK()) {
+                    return status;
+                }
+            }
+
+            if (docs.size() == write_ops::kMaxWriteBatchSize ||
+                batchBytes + doc.objsize() > BSONObjMaxUserSize) {
+                status = insertBatch(opCtx, backingColl, &docs, &batchBytes);
+                if (!status.isOK()) {
+                    return status;
+                }
+            }
+            batchBytes += doc.objsize();
+            docs.emplace_back(doc.getOwned());
+        }
+
+        const auto cursorId = cursor.getValue().getCursorId();
+        if (cursorId == 0) {
+            break;
+        }
+        client.runCommand(viewName.db().toString(),
+                          BSON("getMore" << cursorId << "collection" << view->viewOn().coll()),
+                          reply);
+        cursor = CursorResponse::parseFromBSON(reply);
+        if (!cursor.isOK()) {
+            return cursor.getStatus();
+        }
+    }
+
+    status = insertBatch(opCtx, backingColl, &docs, &batchBytes);
+    if (!status.isOK()) {
+        return status;
+    }
+
+    LOG(1) << "refreshed materialized view " << viewName;
+    return setStale(opCtx, db, viewName, false);
+}
+
+}  // namespace monger
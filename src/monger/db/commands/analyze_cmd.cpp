@@ -0,0 +1,245 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::monger::logger::LogComponent::kCommand
+
+#include "monger/platform/basic.h"
+
+#include <string>
+#include <vector>
+
+#include "monger/db/background.h"
+#include "monger/db/catalog/collection.h"
+#include "monger/db/catalog/index_catalog.h"
+#include "monger/db/commands.h"
+#include "monger/db/db_raii.h"
+#include "monger/db/dbhelpers.h"
+#include "monger/db/exec/working_set_common.h"
+#include "monger/db/index/index_descriptor.h"
+#include "monger/db/index_builds_coordinator.h"
+#include "monger/db/index_names.h"
+#include "monger/db/keypattern.h"
+#include "monger/db/query/index_statistics.h"
+#include "monger/db/query/internal_plans.h"
+#include "monger/db/storage/durable_catalog.h"
+#include "monger/util/log.h"
+
+namespace monger {
+namespace {
+
+/**
+ * Gathers statistics on the keys of the ready btree and hashed indexes of a collection, for the
+ * query planner to estimate the cost of candidate plans with.
+ *
+ * { analyze: <collection>, index: <optional index name>, sampleSize: <optional number> }
+ *
+ * The statistics are stored in the local catalog only and are not replicated.
+ */
+class CmdAnalyze : public BasicCommand {
+public:
+    CmdAnalyze() : BasicCommand("analyze") {}
+
+    AllowedOnSecondary secondaryAllowed(ServiceContext*) const override {
+        return AllowedOnSecondary::kNever;
+    }
+
+    bool supportsWriteConcern(const BSONObj& cmd) const override {
+        return false;
+    }
+
+    std::string help() const override {
+        return "Gather statistics on the keys of a collection's indexes for query planning.\n"
+               "{ analyze: <collection>, index: <optional index name>, "
+               "sampleSize: <optional number> }";
+    }
+
+    void addRequiredPrivileges(const std::string& dbname,
+                               const BSONObj& cmdObj,
+                               std::vector<Privilege>* out) const override {
+        ActionSet actions;
+        actions.addAction(ActionType::planCacheWrite);
+        out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
+    }
+
+    bool run(OperationContext* opCtx,
+             const std::string& dbname,
+             const BSONObj& cmdObj,
+             BSONObjBuilder& result) override {
+        const NamespaceString nss(CommandHelpers::parseNsCollectionRequired(dbname, cmdObj));
+
+        long long sampleSize = IndexStatistics::kDefaultSampleSize;
+        if (auto elem = cmdObj["sampleSize"]) {
+            uassert(ErrorCodes::TypeMismatch, "'sampleSize' must be a number", elem.isNumber());
+            sampleSize = elem.safeNumberLong();
+            uassert(ErrorCodes::BadValue, "'sampleSize' must be positive", sampleSize > 0);
+        }
+
+        std::string indexName;
+        if (auto elem = cmdObj["index"]) {
+            uassert(ErrorCodes::TypeMismatch,
+                    "'index' must be an index name",
+                    elem.type() == BSONType::String);
+            indexName = elem.String();
+        }
+
+        const auto names = analyzableIndexNames(opCtx, nss, indexName);
+
+        // Scan each index with yielding, then persist all the statistics at once.
+        std::vector<std::shared_ptr<IndexStatistics>> statistics;
+        for (const auto& name : names) {
+            statistics.push_back(analyzeIndex(opCtx, nss, name, sampleSize));
+        }
+
+        AutoGetCollection autoColl(opCtx, nss, MODE_X);
+        Collection* collection = autoColl.getCollection();
+        uassert(ErrorCodes::NamespaceNotFound,
+                str::stream() << "collection " << nss.ns() << " was dropped during analyze",
+                collection);
+
+        // Refreshing an index entry is not allowed while an index build is in progress.
+        BackgroundOperation::assertNoBgOpInProgForNs(nss);
+        IndexBuildsCoordinator::get(opCtx)->assertNoIndexBuildInProgForCollection(
+            collection->uuid().get());
+
+        BSONArrayBuilder indexesBuilder(result.subarrayStart("indexes"));
+        WriteUnitOfWork wunit(opCtx);
+        auto indexCatalog = collection->getIndexCatalog();
+        for (size_t i = 0; i < names.size(); ++i) {
+            const IndexDescriptor* desc = indexCatalog->findIndexByName(opCtx, names[i]);
+            if (!desc) {
+                // The index was dropped while it was being scanned.
+                continue;
+            }
+
+            DurableCatalog::get(opCtx)->setIndexStatistics(
+                opCtx, nss, names[i], statistics[i]->toBSON());
+
+            // The new entry loads the statistics just persisted.
+            indexCatalog->refreshEntry(opCtx, desc);
+
+            BSONObjBuilder indexBuilder(indexesBuilder.subobjStart());
+            indexBuilder.append("name", names[i]);
+            indexBuilder.appendNumber("numKeys", statistics[i]->numKeys());
+            indexBuilder.appendNumber("numDistinctValues", statistics[i]->numDistinctValues());
+        }
+        wunit.commit();
+        indexesBuilder.doneFast();
+
+        // Cached plans were chosen without the new statistics.
+        collection->infoCache()->clearQueryCache();
+        return true;
+    }
+
+private:
+    /**
+     * Returns the names of the ready btree and hashed indexes of 'nss', or just 'indexName' if it
+     * is not empty.
+     */
+    static std::vector<std::string> analyzableIndexNames(OperationContext* opCtx,
+                                                         const NamespaceString& nss,
+                                                         const std::string& indexName) {
+        AutoGetCollectionForRead autoColl(opCtx, nss);
+        Collection* collection = autoColl.getCollection();
+        uassert(ErrorCodes::NamespaceNotFound,
+                str::stream() << "ns not found: " << nss.ns(),
+                collection);
+
+        std::vector<std::string> names;
+        auto it = collection->getIndexCatalog()->getIndexIterator(opCtx, false);
+        while (it->more()) {
+            const IndexDescriptor* desc = it->next()->descriptor();
+            if (!indexName.empty() && desc->indexName() != indexName) {
+                continue;
+            }
+
+            const IndexType type = IndexNames::nameToType(desc->getAccessMethodName());
+            uassert(ErrorCodes::InvalidOptions,
+                    str::stream() << "cannot analyze index " << desc->indexName()
+                                  << " of type " << desc->getAccessMethodName(),
+                    indexName.empty() || type == INDEX_BTREE || type == INDEX_HASHED);
+            if (type == INDEX_BTREE || type == INDEX_HASHED) {
+                names.push_back(desc->indexName());
+            }
+        }
+
+        uassert(ErrorCodes::IndexNotFound,
+                str::stream() << "index not found: " << indexName,
+                indexName.empty() || !names.empty());
+        return names;
+    }
+
+    /**
+     * Scans every key of the named index and returns their statistics.
+     */
+    static std::shared_ptr<IndexStatistics> analyzeIndex(OperationContext* opCtx,
+                                                         const NamespaceString& nss,
+                                                         const std::string& indexName,
+                                                         long long sampleSize) {
+        AutoGetCollectionForRead autoColl(opCtx, nss);
+        Collection* collection = autoColl.getCollection();
+        uassert(ErrorCodes::NamespaceNotFound,
+                str::stream() << "collection " << nss.ns() << " was dropped during analyze",
+                collection);
+
+        const IndexDescriptor* desc =
+            collection->getIndexCatalog()->findIndexByName(opCtx, indexName);
+        uassert(ErrorCodes::IndexNotFound,
+                str::stream() << "index " << indexName << " was dropped during analyze",
+                desc);
+
+        IndexStatistics::Builder builder(sampleSize,
+                                         IndexStatistics::kDefaultNumBuckets,
+                                         opCtx->getClient()->getPrng().nextInt64());
+
+        // Scan from (MinKey, MinKey, ...) to (MaxKey, MaxKey, ...) in index order.
+        const KeyPattern kp(desc->keyPattern());
+        auto exec = InternalPlanner::indexScan(opCtx,
+                                               collection,
+                                               desc,
+                                               Helpers::toKeyFormat(kp.extendRangeBound({}, false)),
+                                               Helpers::toKeyFormat(kp.extendRangeBound({}, true)),
+                                               BoundInclusion::kIncludeBothStartAndEndKeys,
+                                               PlanExecutor::YIELD_AUTO);
+        BSONObj key;
+        PlanExecutor::ExecState state;
+        while (PlanExecutor::ADVANCED == (state = exec->getNext(&key, nullptr))) {
+            builder.addKey(key);
+        }
+        if (PlanExecutor::FAILURE == state) {
+            uassertStatusOK(WorkingSetCommon::getMemberObjectStatus(key).withContext(
+                str::stream() << "failed to scan index " << indexName));
+        }
+
+        return builder.done(Date_t::now());
+    }
+} cmdAnalyze;
+
+}  // namespace
+}  // namespace monger
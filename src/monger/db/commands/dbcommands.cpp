@@ -52,6 +52,7 @@
 #include "monger/db/catalog/drop_collection.h"
 #include "monger/db/catalog/drop_database.h"
 #include "monger/db/catalog/index_key_validate.h"
+#include "monger/db/catalog/refresh_materialized_view.h"
 #include "monger/db/catalog_raii.h"
 #include "monger/db/clientcursor.h"
 #include "monger/db/commands.h"
@@ -285,6 +286,7 @@ public:
             << "  indexOptionDefaults: <document: default configuration for indexes>,\n"
             << "  viewOn: <string: name of source collection or view>,\n"
             << "  pipeline: <array<object>: aggregation pipeline stage>,\n"
+            << "  materialized: <bool: store the results of the view>,\n"
             << "  collation: <document: default collation for the collection or view>,\n"
             << "  writeConcern: <document: write concern expression for the operation>]\n"
             << "}";
@@ -387,6 +389,11 @@ public:
 
         BSONObj idIndexSpec;
         uassertStatusOK(createCollection(opCtx, dbname, cmdObj, idIndexSpec));
+
+        // A materialized view is read through its pipeline until it is first refreshed.
+        if (cmd.getMaterialized().value_or(false)) {
+            uassertStatusOK(refreshMaterializedView(opCtx, ns));
+        }
         return true;
     }
 } cmdCreate;
@@ -152,10 +152,17 @@ BSONObj buildViewBson(const ViewDefinition& view, bool nameOnly) {
     if (view.defaultCollator()) {
         optionsBuilder.append("collation", view.defaultCollator()->getSpec().toBSON());
     }
+    if (view.isMaterialized()) {
+        optionsBuilder.append("materialized", true);
+    }
     optionsBuilder.doneFast();
 
-    BSONObj info = BSON("readOnly" << true);
-    b.append("info", info);
+    BSONObjBuilder infoBuilder(b.subobjStart("info"));
+    infoBuilder.append("readOnly", true);
+    if (view.isMaterialized()) {
+        infoBuilder.append("stale", view.isStale());
+    }
+    infoBuilder.doneFast();
     return b.obj();
 }
 
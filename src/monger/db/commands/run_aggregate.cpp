@@ -48,8 +48,10 @@
 #include "monger/db/pipeline/accumulator.h"
 #include "monger/db/pipeline/document.h"
 #include "monger/db/pipeline/document_source.h"
+#include "monger/db/pipeline/document_source_cursor.h"
 #include "monger/db/pipeline/document_source_exchange.h"
 #include "monger/db/pipeline/document_source_geo_near.h"
+#include "monger/db/pipeline/document_source_local_exchange.h"
 #include "monger/db/pipeline/expression.h"
 #include "monger/db/pipeline/expression_context.h"
 #include "monger/db/pipeline/lite_parsed_pipeline.h"
@@ -382,6 +384,8 @@ boost::intrusive_ptr<ExpressionContext> makeExpressionContext(
     auto txnParticipant = TransactionParticipant::get(opCtx);
     expCtx->inMultiDocumentTransaction =
         txnParticipant && txnParticipant.inMultiDocumentTransaction();
+    expCtx->memoryTracker->reportPeakTo(
+        &CurOp::get(opCtx)->debug().additiveMetrics.peakMemoryUsageBytes);
 
     return expCtx;
 }
@@ -460,6 +464,41 @@ std::vector<std::unique_ptr<Pipeline, PipelineDeleter>> createExchangePipelinesI
     return pipelines;
 }
 
+/**
+ * If the aggregation 'request' asks for parallelism, try to rewrite 'pipeline' to run its leading
+ * stages on several threads. Returns 'pipeline' unchanged if the request or the pipeline does not
+ * allow it.
+ */
+std::unique_ptr<Pipeline, PipelineDeleter> parallelizePipelineIfNeeded(
+    OperationContext* opCtx,
+    const boost::intrusive_ptr<ExpressionContext>& expCtx,
+    const AggregationRequest& request,
+    std::unique_ptr<Pipeline, PipelineDeleter> pipeline) {
+    if (request.getParallelism() <= 1 || expCtx->explain || request.getExchangeSpec() ||
+        expCtx->tailableMode != TailableModeEnum::kNormal ||
+        !dynamic_cast<DocumentSourceCursor*>(pipeline->peekFront())) {
+        return pipeline;
+    }
+
+    // The consumer threads read under their own operation contexts and storage snapshots, as
+    // getMores on the cursors of an exchange would. This is only allowed for untimestamped reads
+    // outside of a multi-document transaction.
+    if (expCtx->inMultiDocumentTransaction ||
+        opCtx->recoveryUnit()->getTimestampReadSource() != RecoveryUnit::ReadSource::kUnset) {
+        return pipeline;
+    }
+
+    return DocumentSourceLocalExchange::parallelizePipeline(
+        std::move(pipeline), request.getParallelism(), [&] {
+            // As for the consumers of an exchange, every ExpressionContext needs its own process
+            // interface since they are used on different threads.
+            auto newExpCtx = expCtx->copyWith(expCtx->ns, expCtx->uuid);
+            newExpCtx->mongerProcessInterface = MongerProcessInterface::create(opCtx);
+            newExpCtx->inMultiDocumentTransaction = expCtx->inMultiDocumentTransaction;
+            return newExpCtx;
+        });
+}
+
 /**
  * Create a PlanExecutor to execute the given 'pipeline'.
  */
@@ -677,6 +716,8 @@ Status runAggregate(OperationContext* opCtx,
             // adding the initial cursor stage.
             pipeline->optimizePipeline();
 
+            pipeline = parallelizePipelineIfNeeded(opCtx, expCtx, request, std::move(pipeline));
+
             auto pipelines =
                 createExchangePipelinesIfNeeded(opCtx, expCtx, request, std::move(pipeline), uuid);
             for (auto&& pipelineIt : pipelines) {
@@ -579,6 +579,10 @@ void CurOp::reportState(BSONObjBuilder* builder, bool truncateOps) {
         builder->append("writeConflicts", n);
     }
 
+    if (auto n = _debug.additiveMetrics.peakMemoryUsageBytes.load(); n > 0) {
+        builder->append("peakMemoryUsageBytes", n);
+    }
+
     builder->append("numYields", _numYields);
 }
 
@@ -672,6 +676,7 @@ string OpDebug::report(Client* client,
     OPDEBUG_TOSTRING_HELP_BOOL(usedDisk);
     OPDEBUG_TOSTRING_HELP_BOOL(fromMultiPlanner);
     OPDEBUG_TOSTRING_HELP_BOOL(replanned);
+    OPDEBUG_TOSTRING_HELP(planningTimeMicros);
     OPDEBUG_TOSTRING_HELP_OPTIONAL("nMatched", additiveMetrics.nMatched);
     OPDEBUG_TOSTRING_HELP_OPTIONAL("nModified", additiveMetrics.nModified);
     OPDEBUG_TOSTRING_HELP_OPTIONAL("ninserted", additiveMetrics.ninserted);
@@ -683,6 +688,7 @@ string OpDebug::report(Client* client,
     OPDEBUG_TOSTRING_HELP_OPTIONAL("keysDeleted", additiveMetrics.keysDeleted);
     OPDEBUG_TOSTRING_HELP_ATOMIC("prepareReadConflicts", additiveMetrics.prepareReadConflicts);
     OPDEBUG_TOSTRING_HELP_ATOMIC("writeConflicts", additiveMetrics.writeConflicts);
+    OPDEBUG_TOSTRING_HELP_ATOMIC("peakMemoryUsageBytes", additiveMetrics.peakMemoryUsageBytes);
 
     s << " numYields:" << curop.numYields();
     OPDEBUG_TOSTRING_HELP(nreturned);
@@ -774,6 +780,7 @@ void OpDebug::append(const CurOp& curop,
     OPDEBUG_APPEND_BOOL(usedDisk);
     OPDEBUG_APPEND_BOOL(fromMultiPlanner);
     OPDEBUG_APPEND_BOOL(replanned);
+    OPDEBUG_APPEND_NUMBER(planningTimeMicros);
     OPDEBUG_APPEND_OPTIONAL("nMatched", additiveMetrics.nMatched);
     OPDEBUG_APPEND_OPTIONAL("nModified", additiveMetrics.nModified);
     OPDEBUG_APPEND_OPTIONAL("ninserted", additiveMetrics.ninserted);
@@ -785,6 +792,7 @@ void OpDebug::append(const CurOp& curop,
     OPDEBUG_APPEND_OPTIONAL("keysDeleted", additiveMetrics.keysDeleted);
     OPDEBUG_APPEND_ATOMIC("prepareReadConflicts", additiveMetrics.prepareReadConflicts);
     OPDEBUG_APPEND_ATOMIC("writeConflicts", additiveMetrics.writeConflicts);
+    OPDEBUG_APPEND_ATOMIC("peakMemoryUsageBytes", additiveMetrics.peakMemoryUsageBytes);
 
     b.appendNumber("numYield", curop.numYields());
     OPDEBUG_APPEND_NUMBER(nreturned);
@@ -841,6 +849,9 @@ void OpDebug::setPlanSummaryMetrics(const PlanSummaryStats& planSummaryStats) {
     usedDisk = planSummaryStats.usedDisk;
     fromMultiPlanner = planSummaryStats.fromMultiPlanner;
     replanned = planSummaryStats.replanned;
+    if (planSummaryStats.fromMultiPlanner) {
+        planningTimeMicros = planSummaryStats.planningTimeMicros;
+    }
 }
 
 BSONObj OpDebug::makeFlowControlObject(FlowControlTicketholder::CurOp stats) const {
@@ -898,6 +909,8 @@ void OpDebug::AdditiveMetrics::add(const AdditiveMetrics& otherMetrics) {
     keysDeleted = addOptionalLongs(keysDeleted, otherMetrics.keysDeleted);
     prepareReadConflicts.fetchAndAdd(otherMetrics.prepareReadConflicts.load());
     writeConflicts.fetchAndAdd(otherMetrics.writeConflicts.load());
+    peakMemoryUsageBytes.store(
+        std::max(peakMemoryUsageBytes.load(), otherMetrics.peakMemoryUsageBytes.load()));
 }
 
 void OpDebug::AdditiveMetrics::reset() {
@@ -911,6 +924,7 @@ void OpDebug::AdditiveMetrics::reset() {
     keysDeleted = boost::none;
     prepareReadConflicts.store(0);
     writeConflicts.store(0);
+    peakMemoryUsageBytes.store(0);
 }
 
 bool OpDebug::AdditiveMetrics::equals(const AdditiveMetrics& otherMetrics) const {
@@ -919,7 +933,8 @@ bool OpDebug::AdditiveMetrics::equals(const AdditiveMetrics& otherMetrics) const
         ninserted == otherMetrics.ninserted && ndeleted == otherMetrics.ndeleted &&
         keysInserted == otherMetrics.keysInserted && keysDeleted == otherMetrics.keysDeleted &&
         prepareReadConflicts.load() == otherMetrics.prepareReadConflicts.load() &&
-        writeConflicts.load() == otherMetrics.writeConflicts.load();
+        writeConflicts.load() == otherMetrics.writeConflicts.load() &&
+        peakMemoryUsageBytes.load() == otherMetrics.peakMemoryUsageBytes.load();
 }
 
 void OpDebug::AdditiveMetrics::incrementWriteConflicts(long long n) {
@@ -964,6 +979,7 @@ string OpDebug::AdditiveMetrics::report() const {
     OPDEBUG_TOSTRING_HELP_OPTIONAL("keysDeleted", keysDeleted);
     OPDEBUG_TOSTRING_HELP_ATOMIC("prepareReadConflicts", prepareReadConflicts);
     OPDEBUG_TOSTRING_HELP_ATOMIC("writeConflicts", writeConflicts);
+    OPDEBUG_TOSTRING_HELP_ATOMIC("peakMemoryUsageBytes", peakMemoryUsageBytes);
 
     return s.str();
 }
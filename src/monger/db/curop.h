@@ -138,6 +138,10 @@ public:
         // Number of read conflicts caused by a prepared transaction.
         AtomicWord<long long> prepareReadConflicts{0};
         AtomicWord<long long> writeConflicts{0};
+
+        // The most memory held at once by the blocking stages of an aggregation, updated as it
+        // runs. Unlike the other fields, add() keeps the larger of the two peaks.
+        AtomicWord<long long> peakMemoryUsageBytes{0};
     };
 
     OpDebug() = default;
@@ -205,6 +209,9 @@ public:
     // True if a replan was triggered during the execution of this operation.
     bool replanned{false};
 
+    // Time spent choosing a winner among the candidate plans of the multi-planner, if it ran.
+    long long planningTimeMicros{-1};
+
     bool upsert{false};  // true if the update actually did an insert
     bool cursorExhausted{
         false};  // true if the cursor has been closed at end a find/getMore operation
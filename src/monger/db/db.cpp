@@ -140,6 +140,7 @@
 #include "monger/db/system_index.h"
 #include "monger/db/transaction_participant.h"
 #include "monger/db/ttl.h"
+#include "monger/db/views/materialized_view_op_observer.h"
 #include "monger/db/wire_version.h"
 #include "monger/executor/network_connection_hook.h"
 #include "monger/executor/network_interface_factory.h"
@@ -274,6 +275,7 @@ ExitCode _initAndListen(int listenPort) {
     auto opObserverRegistry = std::make_unique<OpObserverRegistry>();
     opObserverRegistry->addObserver(std::make_unique<OpObserverShardingImpl>());
     opObserverRegistry->addObserver(std::make_unique<AuthOpObserver>());
+    opObserverRegistry->addObserver(std::make_unique<MaterializedViewOpObserver>());
 
     if (serverGlobalParams.clusterRole == ClusterRole::ShardServer) {
         opObserverRegistry->addObserver(std::make_unique<ShardServerOpObserver>());
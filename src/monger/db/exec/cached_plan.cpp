@@ -232,24 +232,28 @@ Status CachedPlanStage::replan(PlanYieldPolicy* yieldPolicy, bool shouldCache) {
     }
 
     // Many solutions. Create a MultiPlanStage to pick the best, update the cache,
-    // and so on. The working set will be shared by all candidate plans.
+    // and so on. The working set will be shared by all candidate plans, unless they may be
+    // worked concurrently during the trial period.
     auto cachingMode = shouldCache ? MultiPlanStage::CachingMode::AlwaysCache
                                    : MultiPlanStage::CachingMode::NeverCache;
     _children.emplace_back(
         new MultiPlanStage(getOpCtx(), collection(), _canonicalQuery, cachingMode));
     MultiPlanStage* multiPlanStage = static_cast<MultiPlanStage*>(child().get());
+    const bool parallelTrial =
+        MultiPlanStage::canRunTrialInParallel(getOpCtx(), *_canonicalQuery, solutions.size());
 
     for (size_t ix = 0; ix < solutions.size(); ++ix) {
         if (solutions[ix]->cacheData.get()) {
             solutions[ix]->cacheData->indexFilterApplied = _plannerParams.indexFiltersApplied;
         }
 
+        WorkingSet* planWs = parallelTrial ? multiPlanStage->makePrivateWorkingSet(_ws) : _ws;
         PlanStage* nextPlanRoot;
         verify(StageBuilder::build(
-            getOpCtx(), collection(), *_canonicalQuery, *solutions[ix], _ws, &nextPlanRoot));
+            getOpCtx(), collection(), *_canonicalQuery, *solutions[ix], planWs, &nextPlanRoot));
 
         // Takes ownership of 'nextPlanRoot'.
-        multiPlanStage->addPlan(std::move(solutions[ix]), nextPlanRoot, _ws);
+        multiPlanStage->addPlan(std::move(solutions[ix]), nextPlanRoot, planWs);
     }
 
     // Delegate to the MultiPlanStage's plan selection facility.
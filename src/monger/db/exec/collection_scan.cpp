@@ -41,6 +41,7 @@
 #include "monger/db/exec/scoped_timer.h"
 #include "monger/db/exec/working_set.h"
 #include "monger/db/exec/working_set_common.h"
+#include "monger/db/query/query_knobs_gen.h"
 #include "monger/db/repl/optime.h"
 #include "monger/util/fail_point_service.h"
 #include "monger/util/log.h"
@@ -64,6 +65,10 @@ CollectionScan::CollectionScan(OperationContext* opCtx,
       _workingSet(workingSet),
       _filter(filter),
       _params(params) {
+    if (internalQueryEnableCompiledMatcher.load()) {
+        _compiledFilter = CompiledMatchExpression::compile(_filter);
+    }
+
     // Explain reports the direction of the collection scan.
     _specificStats.direction = params.direction;
     _specificStats.maxTs = params.maxTs;
@@ -172,6 +177,21 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
     return returnIfMatches(member, id, out);
 }
 
+PlanStage::StageState CollectionScan::doWorkBatch(size_t maxBatchSize,
+                                                  std::vector<WorkingSetID>* results,
+                                                  WorkingSetID* out) {
+    // Tailable and oplog-tracking scans expose the position of the last record read via
+    // '_lastSeenId' and getLatestOplogTimestamp(), which must not run ahead of the results
+    // actually handed to the caller.
+    if (_params.tailable || _params.shouldTrackLatestOplogTimestamp) {
+        return PlanStage::doWorkBatch(maxBatchSize, results, out);
+    }
+
+    return workBatchByUnit(_workingSet, maxBatchSize, results, out, [this](WorkingSetID* out) {
+        return CollectionScan::doWork(out);
+    });
+}
+
 Status CollectionScan::setLatestOplogEntryTimestamp(const Record& record) {
     auto tsElem = record.data.toBson()[repl::OpTime::kTimestampFieldName];
     if (tsElem.type() != BSONType::bsonTimestamp) {
@@ -190,9 +210,10 @@ PlanStage::StageState CollectionScan::returnIfMatches(WorkingSetMember* member,
                                                       WorkingSetID* out) {
     ++_specificStats.docsTested;
 
-    if (Filter::passes(member, _filter)) {
+    if (Filter::passes(member, _filter, _compiledFilter.get())) {
         if (_params.stopApplyingFilterAfterFirstMatch) {
             _filter = nullptr;
+            _compiledFilter.reset();
         }
         *out = memberID;
         return PlanStage::ADVANCED;
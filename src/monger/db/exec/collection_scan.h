@@ -33,6 +33,7 @@
 
 #include "monger/db/exec/collection_scan_common.h"
 #include "monger/db/exec/requires_collection_stage.h"
+#include "monger/db/matcher/compiled_match_expression.h"
 #include "monger/db/matcher/expression_leaf.h"
 #include "monger/db/record_id.h"
 
@@ -60,6 +61,9 @@ public:
                    const MatchExpression* filter);
 
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(size_t maxBatchSize,
+                           std::vector<WorkingSetID>* results,
+                           WorkingSetID* out) final;
     bool isEOF() final;
 
     void doDetachFromOperationContext() final;
@@ -102,6 +106,10 @@ private:
     // The filter is not owned by us.
     const MatchExpression* _filter;
 
+    // '_filter' compiled for evaluation against whole documents, or null if it is not worth
+    // compiling.
+    std::unique_ptr<CompiledMatchExpression> _compiledFilter;
+
     // If a document does not pass '_filter' but passes '_endCondition', stop scanning and return
     // IS_EOF.
     BSONObj _endConditionBSON;
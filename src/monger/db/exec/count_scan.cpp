@@ -81,7 +81,8 @@ CountScan::CountScan(OperationContext* opCtx, CountScanParams params, WorkingSet
       _startKey(std::move(params.startKey)),
       _startKeyInclusive(params.startKeyInclusive),
       _endKey(std::move(params.endKey)),
-      _endKeyInclusive(params.endKeyInclusive) {
+      _endKeyInclusive(params.endKeyInclusive),
+      _bounds(std::move(params.bounds)) {
     _specificStats.indexName = params.name;
     _specificStats.keyPattern = _keyPattern;
     _specificStats.isMultiKey = params.isMultiKey;
@@ -94,6 +95,13 @@ CountScan::CountScan(OperationContext* opCtx, CountScanParams params, WorkingSet
                                    .getObjectField(IndexDescriptor::kCollationFieldName)
                                    .getOwned();
 
+    if (_bounds.size() > 0) {
+        _checker = std::make_unique<IndexBoundsChecker>(&_bounds, _keyPattern, 1);
+        _commonStats.isEOF = !_checker->getStartSeekPoint(&_seekPoint);
+        _needSeek = true;
+        return;
+    }
+
     // endKey must be after startKey in index order since we only do forward scans.
     dassert(_startKey.woCompare(_endKey,
                                 Ordering::make(_keyPattern),
@@ -107,17 +115,25 @@ PlanStage::StageState CountScan::doWork(WorkingSetID* out) {
     boost::optional<IndexKeyEntry> entry;
     const bool needInit = !_cursor;
     try {
-        // We don't care about the keys.
-        const auto kWantLoc = SortedDataInterface::Cursor::kWantLoc;
+        // We don't care about the keys, unless they have to be checked against the bounds.
+        const auto parts = _checker ? SortedDataInterface::Cursor::kKeyAndLoc
+                                    : SortedDataInterface::Cursor::kWantLoc;
 
         if (needInit) {
             // First call to work().  Perform cursor init.
             _cursor = indexAccessMethod()->newCursor(getOpCtx());
-            _cursor->setEndPosition(_endKey, _endKeyInclusive);
+        }
 
-            entry = _cursor->seek(_startKey, _startKeyInclusive, kWantLoc);
+        if (_checker && _needSeek) {
+            ++_specificStats.seeks;
+            entry = _cursor->seek(_seekPoint, parts);
+            _needSeek = false;
+        } else if (needInit) {
+            ++_specificStats.seeks;
+            _cursor->setEndPosition(_endKey, _endKeyInclusive);
+            entry = _cursor->seek(_startKey, _startKeyInclusive, parts);
         } else {
-            entry = _cursor->next(kWantLoc);
+            entry = _cursor->next(parts);
         }
     } catch (const WriteConflictException&) {
         if (needInit) {
@@ -130,6 +146,22 @@ PlanStage::StageState CountScan::doWork(WorkingSetID* out) {
 
     ++_specificStats.keysExamined;
 
+    if (entry && _checker) {
+        switch (_checker->checkKey(entry->key, &_seekPoint)) {
+            case IndexBoundsChecker::VALID:
+                break;
+
+            case IndexBoundsChecker::DONE:
+                entry = boost::none;
+                break;
+
+            case IndexBoundsChecker::MUST_ADVANCE:
+                // The checker has adjusted '_seekPoint' to the next key which may be in bounds.
+                _needSeek = true;
+                return PlanStage::NEED_TIME;
+        }
+    }
+
     if (!entry) {
         _commonStats.isEOF = true;
         _cursor.reset();
@@ -152,8 +184,15 @@ bool CountScan::isEOF() {
 }
 
 void CountScan::doSaveStateRequiresIndex() {
-    if (_cursor)
-        _cursor->save();
+    if (!_cursor)
+        return;
+
+    if (_needSeek) {
+        _cursor->saveUnpositioned();
+        return;
+    }
+
+    _cursor->save();
 }
 
 void CountScan::doRestoreStateRequiresIndex() {
@@ -178,10 +217,14 @@ unique_ptr<PlanStageStats> CountScan::getStats() {
     unique_ptr<CountScanStats> countStats = std::make_unique<CountScanStats>(_specificStats);
     countStats->keyPattern = _specificStats.keyPattern.getOwned();
 
-    countStats->startKey = replaceBSONFieldNames(_startKey, countStats->keyPattern);
-    countStats->startKeyInclusive = _startKeyInclusive;
-    countStats->endKey = replaceBSONFieldNames(_endKey, countStats->keyPattern);
-    countStats->endKeyInclusive = _endKeyInclusive;
+    if (_checker) {
+        countStats->indexBounds = _bounds.toBSON();
+    } else {
+        countStats->startKey = replaceBSONFieldNames(_startKey, countStats->keyPattern);
+        countStats->startKeyInclusive = _startKeyInclusive;
+        countStats->endKey = replaceBSONFieldNames(_endKey, countStats->keyPattern);
+        countStats->endKeyInclusive = _endKeyInclusive;
+    }
 
     ret->specific = std::move(countStats);
 
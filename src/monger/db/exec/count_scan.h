@@ -32,6 +32,7 @@
 #include "monger/db/exec/requires_index_stage.h"
 #include "monger/db/matcher/expression.h"
 #include "monger/db/operation_context.h"
+#include "monger/db/query/index_bounds.h"
 #include "monger/db/record_id.h"
 #include "monger/db/storage/sorted_data_interface.h"
 #include "monger/stdx/unordered_set.h"
@@ -74,13 +75,18 @@ struct CountScanParams {
 
     BSONObj endKey;
     bool endKeyInclusive{true};
+
+    // If these bounds have any fields, they are scanned in the forward direction instead of the
+    // single interval from 'startKey' to 'endKey'.
+    IndexBounds bounds;
 };
 
 /**
- * Used by the count command. Scans an index from a start key to an end key. Creates a
- * WorkingSetMember for each matching index key in RID_AND_OBJ state. It has a null record id and an
- * empty object with a null snapshot id rather than real data. Returning real data is unnecessary
- * since all we need is the count.
+ * Used by the count command. Scans an index from a start key to an end key, or over index bounds
+ * made of several intervals. In the latter case the keys between the intervals are skipped by
+ * seeking to the next key which may be in bounds. Creates a WorkingSetMember for each matching
+ * index key in RID_AND_OBJ state. It has a null record id and an empty object with a null snapshot
+ * id rather than real data. Returning real data is unnecessary since all we need is the count.
  *
  * Only created through the getExecutorCount() path, as count is the only operation that doesn't
  * care about its data.
@@ -123,8 +129,18 @@ private:
     const BSONObj _endKey;
     const bool _endKeyInclusive = true;
 
+    const IndexBounds _bounds;
+
     std::unique_ptr<SortedDataInterface::Cursor> _cursor;
 
+    // Only set if '_bounds' are scanned. Checks each key against the bounds and tells where to
+    // seek to next once a key is out of bounds.
+    std::unique_ptr<IndexBoundsChecker> _checker;
+    IndexSeekPoint _seekPoint;
+
+    // Whether the next key is found by seeking to '_seekPoint' rather than by advancing the cursor.
+    bool _needSeek = false;
+
     // The set of record ids we've returned so far. Used to avoid returning duplicates, if
     // '_shouldDedup' is set to true.
     stdx::unordered_set<RecordId, RecordId::Hasher> _returned;
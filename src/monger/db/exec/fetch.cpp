@@ -38,6 +38,7 @@
 #include "monger/db/exec/filter.h"
 #include "monger/db/exec/scoped_timer.h"
 #include "monger/db/exec/working_set_common.h"
+#include "monger/db/query/query_knobs_gen.h"
 #include "monger/util/fail_point_service.h"
 #include "monger/util/str.h"
 
@@ -59,6 +60,9 @@ FetchStage::FetchStage(OperationContext* opCtx,
       _filter(filter),
       _idRetrying(WorkingSet::INVALID_ID) {
     _children.emplace_back(child);
+    if (internalQueryEnableCompiledMatcher.load()) {
+        _compiledFilter = CompiledMatchExpression::compile(_filter);
+    }
 }
 
 FetchStage::~FetchStage() {}
@@ -131,6 +135,14 @@ PlanStage::StageState FetchStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState FetchStage::doWorkBatch(size_t maxBatchSize,
+                                              std::vector<WorkingSetID>* results,
+                                              WorkingSetID* out) {
+    return workBatchByUnit(_ws, maxBatchSize, results, out, [this](WorkingSetID* out) {
+        return FetchStage::doWork(out);
+    });
+}
+
 void FetchStage::doSaveStateRequiresCollection() {
     if (_cursor) {
         _cursor->saveUnpositioned();
@@ -173,7 +185,7 @@ PlanStage::StageState FetchStage::returnIfMatches(WorkingSetMember* member,
     // predicate.
     ++_specificStats.docsExamined;
 
-    if (Filter::passes(member, _filter)) {
+    if (Filter::passes(member, _filter, _compiledFilter.get())) {
         *out = memberID;
         return PlanStage::ADVANCED;
     } else {
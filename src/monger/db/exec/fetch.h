@@ -33,6 +33,7 @@
 
 #include "monger/db/exec/requires_collection_stage.h"
 #include "monger/db/jsobj.h"
+#include "monger/db/matcher/compiled_match_expression.h"
 #include "monger/db/matcher/expression.h"
 #include "monger/db/record_id.h"
 
@@ -60,6 +61,9 @@ public:
 
     bool isEOF() final;
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(size_t maxBatchSize,
+                           std::vector<WorkingSetID>* results,
+                           WorkingSetID* out) final;
 
     void doDetachFromOperationContext() final;
     void doReattachToOperationContext() final;
@@ -72,6 +76,13 @@ public:
 
     const SpecificStats* getSpecificStats() const final;
 
+    /**
+     * Records the number of documents the cost model expected this stage to fetch, for explain.
+     */
+    void setEstimatedDocsExamined(long long estimate) {
+        _specificStats.estimatedDocsExamined = estimate;
+    }
+
     static const char* kStageType;
 
 protected:
@@ -95,6 +106,10 @@ private:
     // The filter is not owned by us.
     const MatchExpression* _filter;
 
+    // '_filter' compiled for evaluation against whole documents, or null if it is not worth
+    // compiling.
+    std::unique_ptr<CompiledMatchExpression> _compiledFilter;
+
     // If not Null, we use this rather than asking our child what to do next.
     WorkingSetID _idRetrying;
 
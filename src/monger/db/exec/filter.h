@@ -30,6 +30,7 @@
 #pragma once
 
 #include "monger/db/exec/working_set.h"
+#include "monger/db/matcher/compiled_match_expression.h"
 #include "monger/db/matcher/expression.h"
 #include "monger/db/matcher/matchable.h"
 
@@ -158,6 +159,19 @@ public:
         return filter->matches(&doc, nullptr);
     }
 
+    /**
+     * Like passes() above, but evaluates 'compiled' instead of 'filter' when it is non-null and
+     * 'wsm' holds a full document. 'compiled' must have been compiled from 'filter'.
+     */
+    static bool passes(WorkingSetMember* wsm,
+                       const MatchExpression* filter,
+                       const CompiledMatchExpression* compiled) {
+        if (compiled && wsm->hasObj()) {
+            return compiled->matchesBSON(wsm->obj.value());
+        }
+        return passes(wsm, filter);
+    }
+
     static bool passes(const BSONObj& keyData,
                        const BSONObj& keyPattern,
                        const MatchExpression* filter) {
@@ -87,6 +87,8 @@ IndexScan::IndexScan(OperationContext* opCtx,
     _specificStats.collation = params.indexDescriptor->infoObj()
                                    .getObjectField(IndexDescriptor::kCollationFieldName)
                                    .getOwned();
+    _specificStats.estimatedKeysExamined = params.estimatedKeysExamined;
+    _specificStats.isSkipScan = params.isSkipScan;
 }
 
 boost::optional<IndexKeyEntry> IndexScan::initIndexScan() {
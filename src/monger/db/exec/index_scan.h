@@ -80,6 +80,12 @@ struct IndexScanParams {
 
     // Do we want to add the key as metadata?
     bool addKeyMetadata{false};
+
+    // The number of keys the cost model expected the scan to examine, if it could estimate it.
+    boost::optional<long long> estimatedKeysExamined;
+
+    // Whether the planner chose this scan as a skip scan over an unconstrained leading field.
+    bool isSkipScan{false};
 };
 
 /**
@@ -29,6 +29,7 @@
 
 #include "monger/db/exec/limit.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "monger/db/exec/scoped_timer.h"
@@ -79,6 +80,28 @@ PlanStage::StageState LimitStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState LimitStage::doWorkBatch(size_t maxBatchSize,
+                                              std::vector<WorkingSetID>* results,
+                                              WorkingSetID* out) {
+    if (0 == _numToReturn) {
+        // We've returned as many results as we're limited to.
+        recordWorks(1, 0, PlanStage::IS_EOF);
+        return PlanStage::IS_EOF;
+    }
+
+    // Never ask our child for more results than we are allowed to return. Each unit of work
+    // performed by the child corresponds to one unit of work performed by this stage.
+    const size_t numResultsBefore = results->size();
+    const size_t childWorksBefore = child()->getCommonStats()->works;
+    StageState status = child()->workBatch(
+        std::min(maxBatchSize, static_cast<size_t>(_numToReturn)), results, out);
+
+    const size_t numAdvanced = results->size() - numResultsBefore;
+    _numToReturn -= numAdvanced;
+    recordWorks(child()->getCommonStats()->works - childWorksBefore, numAdvanced, status);
+    return status;
+}
+
 unique_ptr<PlanStageStats> LimitStage::getStats() {
     _commonStats.isEOF = isEOF();
     unique_ptr<PlanStageStats> ret = std::make_unique<PlanStageStats>(_commonStats, STAGE_LIMIT);
@@ -50,6 +50,9 @@ public:
 
     bool isEOF() final;
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(size_t maxBatchSize,
+                           std::vector<WorkingSetID>* results,
+                           WorkingSetID* out) final;
 
     StageType stageType() const final {
         return STAGE_LIMIT;
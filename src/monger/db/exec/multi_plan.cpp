@@ -40,6 +40,7 @@
 #include "monger/base/owned_pointer_vector.h"
 #include "monger/db/catalog/collection.h"
 #include "monger/db/catalog/database.h"
+#include "monger/db/catalog_raii.h"
 #include "monger/db/client.h"
 #include "monger/db/concurrency/write_conflict_exception.h"
 #include "monger/db/exec/scoped_timer.h"
@@ -47,8 +48,18 @@
 #include "monger/db/query/explain.h"
 #include "monger/db/query/plan_cache.h"
 #include "monger/db/query/plan_ranker.h"
+#include "monger/db/query/query_knobs_gen.h"
+#include "monger/db/query/query_planner_common.h"
+#include "monger/db/service_context.h"
+#include "monger/db/transaction_participant.h"
+#include "monger/stdx/condition_variable.h"
+#include "monger/stdx/mutex.h"
+#include "monger/util/concurrency/thread_pool.h"
+#include "monger/util/elapsed_tracker.h"
 #include "monger/util/log.h"
+#include "monger/util/scopeguard.h"
 #include "monger/util/str.h"
+#include "monger/util/timer.h"
 
 namespace monger {
 
@@ -57,6 +68,233 @@ using std::list;
 using std::unique_ptr;
 using std::vector;
 
+namespace {
+
+// How long a worker step waits for its collection lock before giving up and being retried.
+const Milliseconds kLockTimeout(10);
+
+// How often the thread of the query checks for interrupt while candidate plans are worked on
+// worker threads.
+const Milliseconds kInterruptCheckPeriod(10);
+
+struct WorkerPool {
+    stdx::mutex mutex;
+    std::unique_ptr<ThreadPool> pool;
+};
+
+const auto getWorkerPool = ServiceContext::declareDecoration<WorkerPool>();
+
+ServiceContext::ConstructorActionRegisterer workerPoolRegisterer{
+    "PlanEvaluationWorkerPool",
+    [](ServiceContext* service) {},
+    [](ServiceContext* service) {
+        std::unique_ptr<ThreadPool> pool;
+        {
+            auto& workers = getWorkerPool(service);
+            stdx::lock_guard<stdx::mutex> lk(workers.mutex);
+            pool = std::move(workers.pool);
+        }
+        if (pool) {
+            pool->shutdown();
+            pool->join();
+        }
+    }};
+
+/**
+ * Returns the pool shared by all parallel trial periods, starting it on first use. Its size is
+ * taken from 'internalQueryPlanEvaluationThreads' at that time.
+ */
+ThreadPool* workerPool(ServiceContext* service) {
+    auto& workers = getWorkerPool(service);
+    stdx::lock_guard<stdx::mutex> lk(workers.mutex);
+    if (!workers.pool) {
+        ThreadPool::Options options;
+        options.poolName = "PlanEvaluation";
+        options.threadNamePrefix = "planEvaluation-";
+        options.minThreads = 0;
+        options.maxThreads =
+            static_cast<size_t>(std::max(1, internalQueryPlanEvaluationThreads.load()));
+        options.onCreateThread = [](const std::string& name) { Client::initThread(name); };
+        workers.pool = std::make_unique<ThreadPool>(options);
+        workers.pool->startup();
+    }
+    return workers.pool.get();
+}
+
+/**
+ * The state of a trial period whose candidate plans are worked on worker threads. Each worker step
+ * works one candidate for up to a yield period under its own operation context, collection lock
+ * and storage snapshot, and leaves the candidate saved and detached from any operation context.
+ */
+struct ParallelTrial : public std::enable_shared_from_this<ParallelTrial> {
+    struct Candidate {
+        CandidatePlan* plan;
+
+        // Only accessed by the step in progress for this candidate, if any.
+        size_t works = 0;
+        WorkingSetID failureId = WorkingSet::INVALID_ID;
+
+        // Protected by ParallelTrial::mutex.
+        bool stepScheduled = false;
+        bool finished = false;
+    };
+
+    ParallelTrial(NamespaceStringOrUUID nssOrUUID, size_t numWorks, size_t numResults)
+        : nssOrUUID(std::move(nssOrUUID)), numWorks(numWorks), numResults(numResults) {}
+
+    /**
+     * Works candidate 'index' on a worker thread. 'scheduleStatus' is the status the thread pool
+     * ran the task with; if it is not OK the trial fails with it.
+     */
+    void runStep(size_t index, Status scheduleStatus);
+
+    /**
+     * Schedules steps until the trial is over, and waits for all of them to finish. Called on the
+     * thread of the query, with the candidates detached from its operation context.
+     */
+    Status run(OperationContext* opCtx);
+
+    const NamespaceStringOrUUID nssOrUUID;
+    const size_t numWorks;
+    const size_t numResults;
+
+    std::vector<Candidate> candidates;
+
+    // Set once a candidate hits EOF or returns 'numResults' results, or the query is interrupted.
+    // Steps in progress stop working their candidate at the next opportunity.
+    AtomicWord<bool> over{false};
+
+    stdx::mutex mutex;
+
+    // Notified whenever a step finishes.
+    stdx::condition_variable stepFinished;
+
+    // The first error encountered by any step.
+    Status status = Status::OK();
+
+    // Number of steps scheduled which have not finished yet.
+    size_t stepsOutstanding = 0;
+};
+
+void ParallelTrial::runStep(size_t index, Status scheduleStatus) {
+    auto& candidate = candidates[index];
+    CandidatePlan& plan = *candidate.plan;
+    Status stepStatus = scheduleStatus;
+    bool finished = false;
+
+    if (stepStatus.isOK() && !over.load()) {
+        try {
+            auto opCtx = cc().makeOperationContext();
+            AutoGetCollection autoColl(opCtx.get(),
+                                       nssOrUUID,
+                                       MODE_IS,
+                                       AutoGetCollection::kViewsForbidden,
+                                       Date_t::now() + kLockTimeout);
+
+            plan.root->reattachToOperationContext(opCtx.get());
+            ON_BLOCK_EXIT([&] { plan.root->detachFromOperationContext(); });
+            plan.root->restoreState();
+            ON_BLOCK_EXIT([&] {
+                WorkingSetCommon::prepareForSnapshotChange(plan.ws);
+                plan.root->saveState();
+            });
+
+            ElapsedTracker yieldTracker(opCtx->getServiceContext()->getFastClockSource(),
+                                        internalQueryExecYieldIterations.load(),
+                                        Milliseconds(internalQueryExecYieldPeriodMS.load()));
+            while (!finished && !over.load() && !yieldTracker.intervalHasElapsed()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState state = plan.root->work(&id);
+                ++candidate.works;
+
+                if (PlanStage::ADVANCED == state) {
+                    plan.ws->get(id)->makeObjOwnedIfNeeded();
+                    plan.results.push(id);
+                    if (plan.results.size() >= numResults) {
+                        over.store(true);
+                        finished = true;
+                    }
+                } else if (PlanStage::IS_EOF == state) {
+                    over.store(true);
+                    finished = true;
+                } else if (PlanStage::NEED_YIELD == state) {
+                    // Retry from a new snapshot in the next step.
+                    break;
+                } else if (PlanStage::NEED_TIME != state) {
+                    invariant(state == PlanStage::FAILURE);
+                    plan.failed = true;
+                    candidate.failureId = id;
+                    finished = true;
+                }
+
+                finished = finished || candidate.works >= numWorks;
+            }
+        } catch (const WriteConflictException&) {
+            // The candidate is retried by the next step.
+        } catch (const ExceptionFor<ErrorCodes::LockTimeout>&) {
+            // The candidate is retried by the next step.
+        } catch (const DBException& ex) {
+            stepStatus = ex.toStatus();
+        }
+    }
+
+    stdx::lock_guard<stdx::mutex> lk(mutex);
+    candidate.stepScheduled = false;
+    candidate.finished = candidate.finished || finished;
+    if (!stepStatus.isOK() && status.isOK()) {
+        status = stepStatus;
+        over.store(true);
+    }
+    --stepsOutstanding;
+    stepFinished.notify_all();
+}
+
+Status ParallelTrial::run(OperationContext* opCtx) {
+    auto pool = workerPool(opCtx->getServiceContext());
+    Status interruptStatus = Status::OK();
+
+    stdx::unique_lock<stdx::mutex> lk(mutex);
+    while (true) {
+        std::vector<size_t> toSchedule;
+        if (!over.load()) {
+            for (size_t i = 0; i < candidates.size(); ++i) {
+                if (!candidates[i].finished && !candidates[i].stepScheduled) {
+                    candidates[i].stepScheduled = true;
+                    toSchedule.push_back(i);
+                }
+            }
+        }
+        stepsOutstanding += toSchedule.size();
+
+        if (stepsOutstanding == 0) {
+            break;
+        }
+
+        if (!toSchedule.empty()) {
+            // The pool may run a task inline if it cannot be scheduled, so do not hold the mutex.
+            lk.unlock();
+            for (auto index : toSchedule) {
+                pool->schedule([ trial = shared_from_this(), index ](Status status) {
+                    trial->runStep(index, std::move(status));
+                });
+            }
+            lk.lock();
+        }
+
+        stepFinished.wait_for(lk, kInterruptCheckPeriod.toSystemDuration());
+        if (interruptStatus.isOK()) {
+            interruptStatus = opCtx->checkForInterruptNoAssert();
+            if (!interruptStatus.isOK()) {
+                over.store(true);
+            }
+        }
+    }
+
+    return interruptStatus.isOK() ? status : interruptStatus;
+}
+
+}  // namespace
+
 // static
 const char* MultiPlanStage::kStageType = "MULTI_PLAN";
 
@@ -73,13 +311,80 @@ MultiPlanStage::MultiPlanStage(OperationContext* opCtx,
       _failureCount(0),
       _statusMemberId(WorkingSet::INVALID_ID) {}
 
+MultiPlanStage::~MultiPlanStage() {
+    // Destroy the candidate plans before the private working sets they use.
+    _children.clear();
+}
+
 void MultiPlanStage::addPlan(std::unique_ptr<QuerySolution> solution,
                              PlanStage* root,
                              WorkingSet* ws) {
+    const bool isPrivate = std::any_of(
+        _privateWorkingSets.begin(),
+        _privateWorkingSets.end(),
+        [ws](const std::unique_ptr<WorkingSet>& privateWs) { return privateWs.get() == ws; });
+    if (!isPrivate) {
+        invariant(!_sharedWs || _sharedWs == ws);
+        _sharedWs = ws;
+    }
+
     _candidates.push_back(CandidatePlan(std::move(solution), root, ws));
     _children.emplace_back(root);
 }
 
+WorkingSet* MultiPlanStage::makePrivateWorkingSet(WorkingSet* sharedWs) {
+    invariant(!_sharedWs || _sharedWs == sharedWs);
+    _sharedWs = sharedWs;
+    _privateWorkingSets.push_back(std::make_unique<WorkingSet>());
+    return _privateWorkingSets.back().get();
+}
+
+// static
+bool MultiPlanStage::canRunTrialInParallel(OperationContext* opCtx,
+                                           const CanonicalQuery& query,
+                                           size_t numCandidates) {
+    if (internalQueryPlanEvaluationThreads.load() <= 1 ||
+        numCandidates <
+            static_cast<size_t>(internalQueryPlanEvaluationParallelMinCandidates.load())) {
+        return false;
+    }
+
+    // Each candidate is worked by a separate operation under its own storage snapshot, so the
+    // trial can only offer the guarantees of an untimestamped read which yields.
+    if (opCtx->recoveryUnit()->getTimestampReadSource() != RecoveryUnit::ReadSource::kUnset) {
+        return false;
+    }
+    auto txnParticipant = TransactionParticipant::get(opCtx);
+    if (txnParticipant && txnParticipant.inMultiDocumentTransaction()) {
+        return false;
+    }
+
+    // The trial runs while the operation has yielded, which writes cannot do while planning.
+    if (opCtx->lockState()->isWriteLocked()) {
+        return false;
+    }
+
+    // $where and $expr are evaluated through the query's ExpressionContext, which can only refer
+    // to one operation context at a time.
+    const MatchExpression* root = query.root();
+    return !QueryPlannerCommon::hasNode(root, MatchExpression::WHERE) &&
+        !QueryPlannerCommon::hasNode(root, MatchExpression::EXPRESSION);
+}
+
+WorkingSetID MultiPlanStage::toSharedWorkingSet(const CandidatePlan& candidate, WorkingSetID id) {
+    if (candidate.ws == _sharedWs || WorkingSet::INVALID_ID == id) {
+        return id;
+    }
+    return _sharedWs->transferFrom(candidate.ws, id);
+}
+
+void MultiPlanStage::doSaveStateRequiresCollection() {
+    // The executor only prepares the shared working set for the snapshot to change.
+    for (auto&& ws : _privateWorkingSets) {
+        WorkingSetCommon::prepareForSnapshotChange(ws.get());
+    }
+}
+
 bool MultiPlanStage::isEOF() {
     if (_failure) {
         return true;
@@ -106,7 +411,7 @@ PlanStage::StageState MultiPlanStage::doWork(WorkingSetID* out) {
 
     // Look for an already produced result that provides the data the caller wants.
     if (!bestPlan.results.empty()) {
-        *out = bestPlan.results.front();
+        *out = toSharedWorkingSet(bestPlan, bestPlan.results.front());
         bestPlan.results.pop();
         return PlanStage::ADVANCED;
     }
@@ -114,6 +419,9 @@ PlanStage::StageState MultiPlanStage::doWork(WorkingSetID* out) {
     // best plan had no (or has no more) cached results
 
     StageState state = bestPlan.root->work(out);
+    if (PlanStage::ADVANCED == state || PlanStage::FAILURE == state) {
+        *out = toSharedWorkingSet(bestPlan, *out);
+    }
 
     if (PlanStage::FAILURE == state && hasBackupPlan()) {
         LOG(5) << "Best plan errored out switching to backup";
@@ -130,7 +438,12 @@ PlanStage::StageState MultiPlanStage::doWork(WorkingSetID* out) {
         _bestPlanIdx = _backupPlanIdx;
         _backupPlanIdx = kNoSuchPlan;
 
-        return _candidates[_bestPlanIdx].root->work(out);
+        CandidatePlan& backupPlan = _candidates[_bestPlanIdx];
+        StageState backupState = backupPlan.root->work(out);
+        if (PlanStage::ADVANCED == backupState || PlanStage::FAILURE == backupState) {
+            *out = toSharedWorkingSet(backupPlan, *out);
+        }
+        return backupState;
     }
 
     if (hasBackupPlan() && PlanStage::ADVANCED == state) {
@@ -152,8 +465,7 @@ Status MultiPlanStage::tryYield(PlanYieldPolicy* yieldPolicy) {
 
         if (!yieldStatus.isOK()) {
             _failure = true;
-            _statusMemberId =
-                WorkingSetCommon::allocateStatusMember(_candidates[0].ws, yieldStatus);
+            _statusMemberId = WorkingSetCommon::allocateStatusMember(_sharedWs, yieldStatus);
             return yieldStatus;
         }
     }
@@ -198,13 +510,22 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
     // execution work that happens here, so this is needed for the time accounting to
     // make sense.
     ScopedTimer timer(getClock(), &_commonStats.executionTimeMillis);
+    Timer planningTimer;
+    ON_BLOCK_EXIT([&] { _specificStats.planningTimeMicros = planningTimer.micros(); });
 
     size_t numWorks = getTrialPeriodWorks(getOpCtx(), collection());
     size_t numResults = getTrialPeriodNumToReturn(*_query);
 
-    // Work the plans, stopping when a plan hits EOF or returns some
+    // The candidates can only be worked on other threads if none of them shares the working set
+    // of the executor, and if the operation can release its locks for the duration of the trial.
+    if (_privateWorkingSets.size() == _candidates.size() &&
+        yieldPolicy->getPolicy() == PlanExecutor::YIELD_AUTO) {
+        _specificStats.parallelTrial = workAllPlansInParallel(numWorks, numResults, yieldPolicy);
+    }
+
+    // Otherwise work the plans in turn, stopping when a plan hits EOF or returns some
     // fixed number of results.
-    for (size_t ix = 0; ix < numWorks; ++ix) {
+    for (size_t ix = 0; ix < numWorks && !_specificStats.parallelTrial; ++ix) {
         bool moreToDo = workAllPlans(numResults, yieldPolicy);
         if (!moreToDo) {
             break;
@@ -213,7 +534,7 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
 
     if (_failure) {
         invariant(WorkingSet::INVALID_ID != _statusMemberId);
-        WorkingSetMember* member = _candidates[0].ws->get(_statusMemberId);
+        WorkingSetMember* member = _sharedWs->get(_statusMemberId);
         return WorkingSetCommon::getMemberStatus(*member);
     }
 
@@ -386,7 +707,7 @@ bool MultiPlanStage::workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolic
 
             // Propagate most recent seen failure to parent.
             invariant(state == PlanStage::FAILURE);
-            _statusMemberId = id;
+            _statusMemberId = toSharedWorkingSet(candidate, id);
 
 
             if (_failureCount == _candidates.size()) {
@@ -399,6 +720,59 @@ bool MultiPlanStage::workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolic
     return !doneWorking;
 }
 
+bool MultiPlanStage::workAllPlansInParallel(size_t numWorks,
+                                            size_t numResults,
+                                            PlanYieldPolicy* yieldPolicy) {
+    auto trial = std::make_shared<ParallelTrial>(
+        NamespaceStringOrUUID(collection()->ns().db().toString(), uuid()), numWorks, numResults);
+    for (auto&& candidate : _candidates) {
+        trial->candidates.push_back({&candidate});
+    }
+
+    // The yield saves every candidate and releases the locks of the operation, so that workers can
+    // take locks of their own without queueing behind a writer which waits for this operation.
+    // Restoring after the yield may be retried, but the trial only runs once.
+    bool ran = false;
+    Status trialStatus = Status::OK();
+    Status yieldStatus = yieldPolicy->yieldOrInterrupt([&] {
+        if (ran) {
+            return;
+        }
+        ran = true;
+
+        OperationContext* opCtx = getOpCtx();
+        for (auto&& candidate : _candidates) {
+            candidate.root->detachFromOperationContext();
+        }
+        trialStatus = trial->run(opCtx);
+        for (auto&& candidate : _candidates) {
+            candidate.root->reattachToOperationContext(opCtx);
+        }
+    });
+
+    if (!yieldStatus.isOK() || !trialStatus.isOK()) {
+        _failure = true;
+        _statusMemberId = WorkingSetCommon::allocateStatusMember(
+            _sharedWs, !yieldStatus.isOK() ? yieldStatus : trialStatus);
+        return true;
+    }
+
+    if (!ran) {
+        // The operation holds no locks it could yield, so its candidates cannot be restored on
+        // worker threads.
+        return false;
+    }
+
+    for (size_t ix = 0; ix < _candidates.size(); ++ix) {
+        if (_candidates[ix].failed) {
+            ++_failureCount;
+            _statusMemberId = toSharedWorkingSet(_candidates[ix], trial->candidates[ix].failureId);
+        }
+    }
+    _failure = _failureCount == _candidates.size();
+    return true;
+}
+
 bool MultiPlanStage::hasBackupPlan() const {
     return kNoSuchPlan != _backupPlanIdx;
 }
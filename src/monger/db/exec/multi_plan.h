@@ -94,11 +94,29 @@ public:
 
     const SpecificStats* getSpecificStats() const final;
 
+    ~MultiPlanStage();
+
     /**
      * Takes ownership of PlanStage. Does not take ownership of WorkingSet.
      */
     void addPlan(std::unique_ptr<QuerySolution> solution, PlanStage* root, WorkingSet* sharedWs);
 
+    /**
+     * Returns true if the trial period for 'numCandidates' candidate plans of 'query' may work the
+     * candidates concurrently on worker threads. Each candidate must then be built with its own
+     * working set from makePrivateWorkingSet().
+     */
+    static bool canRunTrialInParallel(OperationContext* opCtx,
+                                      const CanonicalQuery& query,
+                                      size_t numCandidates);
+
+    /**
+     * Returns a working set owned by this stage for a single candidate plan to be built with. The
+     * results of such a candidate are moved into 'sharedWs', the working set of the plan executor,
+     * as this stage returns them.
+     */
+    WorkingSet* makePrivateWorkingSet(WorkingSet* sharedWs);
+
     /**
      * Runs all plans added by addPlan, ranks them, and picks a best.
      * All further calls to work(...) will return results from the best plan.
@@ -153,7 +171,7 @@ public:
     static const char* kStageType;
 
 protected:
-    void doSaveStateRequiresCollection() final {}
+    void doSaveStateRequiresCollection() final;
 
     void doRestoreStateRequiresCollection() final {}
 
@@ -180,6 +198,21 @@ private:
      */
     Status tryYield(PlanYieldPolicy* yieldPolicy);
 
+    /**
+     * Works every candidate plan concurrently on the worker pool, each under an operation context
+     * and storage snapshot of its own, until one hits EOF or returns 'numResults' results, or each
+     * has been worked 'numWorks' times. Runs while this operation has yielded its locks.
+     *
+     * Returns false if the operation could not yield, in which case nothing was done.
+     */
+    bool workAllPlansInParallel(size_t numWorks, size_t numResults, PlanYieldPolicy* yieldPolicy);
+
+    /**
+     * Returns 'id', a member of the working set of 'candidate', as a member of the working set
+     * shared with the plan executor.
+     */
+    WorkingSetID toSharedWorkingSet(const CandidatePlan& candidate, WorkingSetID id);
+
     static const int kNoSuchPlan = -1;
 
     // Describes the cases in which we should write an entry for the winning plan to the plan cache.
@@ -223,6 +256,14 @@ private:
     // returned by ::work()
     WorkingSetID _statusMemberId;
 
+    // The working set of the plan executor. Candidates built with a private working set have
+    // their results moved into it.
+    WorkingSet* _sharedWs = nullptr;
+
+    // Working sets owned by individual candidate plans, which are needed to work the candidates
+    // concurrently.
+    std::vector<std::unique_ptr<WorkingSet>> _privateWorkingSets;
+
     // Stats
     MultiPlanStats _specificStats;
 };
@@ -0,0 +1,494 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::monger::logger::LogComponent::kQuery
+
+#include "monger/platform/basic.h"
+
+#include "monger/db/exec/parallel_collection_scan.h"
+
+#include <algorithm>
+#include <deque>
+
+#include "monger/db/catalog_raii.h"
+#include "monger/db/client.h"
+#include "monger/db/concurrency/write_conflict_exception.h"
+#include "monger/db/exec/working_set.h"
+#include "monger/db/exec/working_set_common.h"
+#include "monger/db/matcher/expression.h"
+#include "monger/db/query/query_knobs_gen.h"
+#include "monger/db/service_context.h"
+#include "monger/db/storage/record_store.h"
+#include "monger/stdx/condition_variable.h"
+#include "monger/stdx/mutex.h"
+#include "monger/util/concurrency/thread_pool.h"
+#include "monger/util/log.h"
+#include "monger/util/scopeguard.h"
+#include "monger/util/timer.h"
+
+namespace monger {
+
+namespace {
+
+// Number of random records sampled per requested partition when choosing partition boundaries.
+constexpr size_t kSamplesPerPartition = 32;
+
+// A single worker step stops after examining this many documents or buffering this many bytes of
+// matching documents, so that the collection lock and storage snapshot are released regularly.
+constexpr size_t kMaxDocsPerStep = 4096;
+constexpr size_t kMaxBytesPerStep = 1024 * 1024;
+
+// A partition is not scheduled again while this many bytes of its results are waiting to be
+// returned, which bounds the memory used by a consumer that is slower than its workers.
+constexpr size_t kMaxBufferedBytesPerPartition = 4 * 1024 * 1024;
+
+// How long a worker step waits for its collection lock before giving up and being retried.
+const Milliseconds kLockTimeout(10);
+
+// How long doWork() waits for a worker step to finish before returning NEED_TIME.
+const Milliseconds kResultsWaitTime(1);
+
+struct WorkerPool {
+    stdx::mutex mutex;
+    std::unique_ptr<ThreadPool> pool;
+};
+
+const auto getWorkerPool = ServiceContext::declareDecoration<WorkerPool>();
+
+ServiceContext::ConstructorActionRegisterer workerPoolRegisterer{
+    "ParallelCollectionScanWorkerPool",
+    [](ServiceContext* service) {},
+    [](ServiceContext* service) {
+        std::unique_ptr<ThreadPool> pool;
+        {
+            auto& workers = getWorkerPool(service);
+            stdx::lock_guard<stdx::mutex> lk(workers.mutex);
+            pool = std::move(workers.pool);
+        }
+        if (pool) {
+            pool->shutdown();
+            pool->join();
+        }
+    }};
+
+/**
+ * Returns the pool shared by all parallel collection scans, starting it on first use. Its size is
+ * taken from 'internalQueryParallelCollectionScanThreads' at that time.
+ */
+ThreadPool* workerPool(ServiceContext* service) {
+    auto& workers = getWorkerPool(service);
+    stdx::lock_guard<stdx::mutex> lk(workers.mutex);
+    if (!workers.pool) {
+        ThreadPool::Options options;
+        options.poolName = "ParallelCollectionScan";
+        options.threadNamePrefix = "parallelCollScan-";
+        options.minThreads = 0;
+        options.maxThreads =
+            static_cast<size_t>(std::max(1, internalQueryParallelCollectionScanThreads.load()));
+        options.onCreateThread = [](const std::string& name) { Client::initThread(name); };
+        workers.pool = std::make_unique<ThreadPool>(options);
+        workers.pool->startup();
+    }
+    return workers.pool.get();
+}
+
+}  // namespace
+
+struct ParallelCollectionScan::SharedState {
+    struct Result {
+        RecordId id;
+        BSONObj obj;
+    };
+
+    struct Partition {
+        // Only accessed by the step in progress for this partition, if any, and otherwise detached
+        // from any operation context.
+        std::unique_ptr<SeekableRecordCursor> cursor;
+
+        // The record the cursor was positioned at when the partition was set up, which has not
+        // been examined yet. Owned.
+        boost::optional<Record> first;
+
+        // The partition ends just before this record. Null for the last partition.
+        RecordId end;
+
+        // All members below are protected by SharedState::mutex.
+        std::deque<Result> results;
+        size_t bufferedBytes = 0;
+        bool exhausted = false;
+        bool stepScheduled = false;
+        ParallelCollectionScanStats::PartitionStats stats;
+    };
+
+    SharedState(NamespaceStringOrUUID nssOrUUID,
+                const MatchExpression* filter,
+                size_t numPartitions)
+        : nssOrUUID(std::move(nssOrUUID)), filter(filter), partitions(numPartitions) {}
+
+    /**
+     * Reads the next chunk of partition 'index' on a worker thread. 'scheduleStatus' is the status
+     * the thread pool ran the task with; if it is not OK the scan fails with it.
+     */
+    void runStep(size_t index, Status scheduleStatus);
+
+    const NamespaceStringOrUUID nssOrUUID;
+    const MatchExpression* const filter;
+
+    stdx::mutex mutex;
+
+    // Notified whenever a step finishes.
+    stdx::condition_variable stepFinished;
+
+    std::vector<Partition> partitions;
+
+    // The first error encountered by any step.
+    Status status = Status::OK();
+
+    // Once set, steps which have not started reading yet return without doing anything.
+    bool cancelled = false;
+
+    // Number of steps currently reading from a cursor.
+    size_t stepsRunning = 0;
+
+    size_t stepsCompleted = 0;
+    size_t docsTested = 0;
+};
+
+void ParallelCollectionScan::SharedState::runStep(size_t index, Status scheduleStatus) {
+    auto& partition = partitions[index];
+    {
+        stdx::lock_guard<stdx::mutex> lk(mutex);
+        if (cancelled) {
+            partition.stepScheduled = false;
+            return;
+        }
+        ++stepsRunning;
+    }
+
+    std::vector<Result> batch;
+    size_t docsTestedInStep = 0;
+    bool reachedEnd = false;
+    Status stepStatus = scheduleStatus;
+    Timer timer;
+
+    if (stepStatus.isOK()) {
+        try {
+            auto opCtx = cc().makeOperationContext();
+            AutoGetCollection autoColl(opCtx.get(),
+                                       nssOrUUID,
+                                       MODE_IS,
+                                       AutoGetCollection::kViewsForbidden,
+                                       Date_t::now() + kLockTimeout);
+
+            partition.cursor->reattachToOperationContext(opCtx.get());
+            ON_BLOCK_EXIT([&] {
+                partition.cursor->save();
+                partition.cursor->detachFromOperationContext();
+            });
+            uassert(ErrorCodes::CappedPositionLost,
+                    "ParallelCollectionScan failed to restore its position in a partition",
+                    partition.cursor->restore());
+
+            size_t bytes = 0;
+            while (docsTestedInStep < kMaxDocsPerStep && bytes < kMaxBytesPerStep) {
+                boost::optional<Record> record;
+                if (partition.first) {
+                    record = std::move(partition.first);
+                    partition.first = boost::none;
+                } else {
+                    record = partition.cursor->next();
+                }
+
+                if (!record || (!partition.end.isNull() && record->id >= partition.end)) {
+                    reachedEnd = true;
+                    break;
+                }
+
+                ++docsTestedInStep;
+                BSONObj obj = record->data.toBson();
+                if (!filter || filter->matchesBSON(obj)) {
+                    bytes += obj.objsize();
+                    batch.push_back({record->id, obj.getOwned()});
+                }
+            }
+        } catch (const WriteConflictException&) {
+            // Keep what was read so far. The cursor resumes after the last record it returned.
+        } catch (const ExceptionFor<ErrorCodes::LockTimeout>&) {
+            // The partition is scheduled again by the next call to doWork().
+        } catch (const DBException& ex) {
+            stepStatus = ex.toStatus();
+        }
+    }
+
+    stdx::lock_guard<stdx::mutex> lk(mutex);
+    partition.stats.docsTested += docsTestedInStep;
+    partition.stats.nReturned += batch.size();
+    partition.stats.steps++;
+    partition.stats.executionTime += Milliseconds(timer.millis());
+    docsTested += docsTestedInStep;
+
+    for (auto&& result : batch) {
+        partition.bufferedBytes += result.obj.objsize();
+        partition.results.push_back(std::move(result));
+    }
+    partition.exhausted = partition.exhausted || reachedEnd;
+    partition.stepScheduled = false;
+    if (!stepStatus.isOK() && status.isOK()) {
+        status = stepStatus;
+    }
+
+    --stepsRunning;
+    ++stepsCompleted;
+    stepFinished.notify_all();
+}
+
+// static
+const char* ParallelCollectionScan::kStageType = "PARALLEL_COLLSCAN";
+
+ParallelCollectionScan::ParallelCollectionScan(OperationContext* opCtx,
+                                               const Collection* collection,
+                                               WorkingSet* workingSet,
+                                               const MatchExpression* filter)
+    : RequiresCollectionStage(kStageType, opCtx, collection),
+      _workingSet(workingSet),
+      _filter(filter) {}
+
+ParallelCollectionScan::~ParallelCollectionScan() {
+    _cancelWorkers();
+}
+
+void ParallelCollectionScan::_setUpPartitions() {
+    auto opCtx = getOpCtx();
+    const size_t maxPartitions =
+        static_cast<size_t>(std::max(1, internalQueryParallelCollectionScanThreads.load()));
+
+    // Choose up to 'maxPartitions - 1' boundaries from a sorted random sample of the collection.
+    // Engines without random cursors get a single partition.
+    std::vector<RecordId> boundaries;
+    if (auto sampler = collection()->getRecordStore()->getRandomCursor(opCtx);
+        sampler && maxPartitions > 1) {
+        std::vector<RecordId> sample;
+        while (sample.size() < maxPartitions * kSamplesPerPartition) {
+            auto record = sampler->next();
+            if (!record) {
+                break;
+            }
+            sample.push_back(record->id);
+        }
+        std::sort(sample.begin(), sample.end());
+        sample.erase(std::unique(sample.begin(), sample.end()), sample.end());
+
+        for (size_t i = 1; i < maxPartitions && !sample.empty(); ++i) {
+            const auto& id = sample[i * sample.size() / maxPartitions];
+            if (boundaries.empty() || boundaries.back() < id) {
+                boundaries.push_back(id);
+            }
+        }
+    }
+
+    auto state = std::make_shared<SharedState>(
+        NamespaceStringOrUUID(collection()->ns().db().toString(), uuid()),
+        _filter,
+        boundaries.size() + 1);
+
+    for (size_t i = 0; i < state->partitions.size(); ++i) {
+        auto& partition = state->partitions[i];
+        partition.cursor = collection()->getCursor(opCtx);
+        if (i > 0) {
+            // The boundary was sampled from this snapshot, so it must exist.
+            auto record = partition.cursor->seekExact(boundaries[i - 1]);
+            invariant(record);
+            partition.first = Record{record->id, record->data.getOwned()};
+        }
+        if (i < boundaries.size()) {
+            partition.end = boundaries[i];
+        }
+
+        partition.cursor->save();
+        partition.cursor->detachFromOperationContext();
+    }
+
+    _specificStats.partitions.resize(state->partitions.size());
+    _state = std::move(state);
+}
+
+PlanStage::StageState ParallelCollectionScan::doWork(WorkingSetID* out) {
+    if (_commonStats.isEOF) {
+        return PlanStage::IS_EOF;
+    }
+
+    if (!_state) {
+        try {
+            _setUpPartitions();
+        } catch (const WriteConflictException&) {
+            *out = WorkingSet::INVALID_ID;
+            return PlanStage::NEED_YIELD;
+        }
+        return PlanStage::NEED_TIME;
+    }
+
+    boost::optional<SharedState::Result> result;
+    std::vector<size_t> toSchedule;
+    {
+        stdx::unique_lock<stdx::mutex> lk(_state->mutex);
+        if (!_state->status.isOK()) {
+            *out = WorkingSetCommon::allocateStatusMember(_workingSet, _state->status);
+            return PlanStage::FAILURE;
+        }
+
+        // Take results from the partitions in turn so that no partition's buffer is starved.
+        const size_t numPartitions = _state->partitions.size();
+        for (size_t i = 0; i < numPartitions; ++i) {
+            const size_t index = (_nextPartition + i) % numPartitions;
+            auto& partition = _state->partitions[index];
+            if (!partition.results.empty()) {
+                result = std::move(partition.results.front());
+                partition.results.pop_front();
+                partition.bufferedBytes -= result->obj.objsize();
+                _nextPartition = (index + 1) % numPartitions;
+                break;
+            }
+        }
+
+        bool done = !result;
+        for (size_t i = 0; i < numPartitions; ++i) {
+            auto& partition = _state->partitions[i];
+            if (!partition.exhausted && !partition.stepScheduled &&
+                partition.bufferedBytes < kMaxBufferedBytesPerPartition) {
+                partition.stepScheduled = true;
+                toSchedule.push_back(i);
+            }
+            done = done && partition.exhausted && !partition.stepScheduled &&
+                partition.results.empty();
+        }
+
+        if (_state->stepsCompleted != _stepsSynced) {
+            _syncStats_inlock();
+        }
+
+        if (done) {
+            _commonStats.isEOF = true;
+            return PlanStage::IS_EOF;
+        }
+
+        if (!result && toSchedule.empty()) {
+            // Every remaining partition has a step in progress. Wait briefly for one to finish
+            // rather than spinning.
+            _state->stepFinished.wait_for(lk, kResultsWaitTime.toSystemDuration());
+        }
+    }
+
+    // The pool may run a task inline if it cannot be scheduled, so do not hold the mutex here.
+    if (!toSchedule.empty()) {
+        auto pool = workerPool(getOpCtx()->getServiceContext());
+        for (auto index : toSchedule) {
+            pool->schedule([ state = _state, index ](Status status) {
+                state->runStep(index, std::move(status));
+            });
+        }
+    }
+
+    if (!result) {
+        return PlanStage::NEED_TIME;
+    }
+
+    WorkingSetID id = _workingSet->allocate();
+    WorkingSetMember* member = _workingSet->get(id);
+    member->recordId = result->id;
+    // The document was read under a worker's snapshot rather than this operation's.
+    member->obj = {SnapshotId(), std::move(result->obj)};
+    _workingSet->transitionToRecordIdAndObj(id);
+    *out = id;
+    return PlanStage::ADVANCED;
+}
+
+bool ParallelCollectionScan::isEOF() {
+    return _commonStats.isEOF;
+}
+
+void ParallelCollectionScan::doDispose() {
+    _cancelWorkers();
+}
+
+void ParallelCollectionScan::_cancelWorkers() {
+    if (!_state) {
+        return;
+    }
+
+    stdx::unique_lock<stdx::mutex> lk(_state->mutex);
+    _state->cancelled = true;
+    _state->stepFinished.wait(lk, [&] { return _state->stepsRunning == 0; });
+
+    // Steps which are still queued will not touch the cursors, so release them now rather than
+    // whenever the last queued step drops its reference to the shared state.
+    for (auto&& partition : _state->partitions) {
+        partition.cursor.reset();
+        partition.first = boost::none;
+        partition.results.clear();
+        partition.bufferedBytes = 0;
+    }
+    _syncStats_inlock();
+}
+
+void ParallelCollectionScan::_syncStats_inlock() const {
+    _specificStats.docsTested = _state->docsTested;
+    for (size_t i = 0; i < _state->partitions.size(); ++i) {
+        _specificStats.partitions[i] = _state->partitions[i].stats;
+    }
+    _stepsSynced = _state->stepsCompleted;
+}
+
+std::unique_ptr<PlanStageStats> ParallelCollectionScan::getStats() {
+    // Add a BSON representation of the filter to the stats tree, if there is one.
+    if (nullptr != _filter) {
+        BSONObjBuilder bob;
+        _filter->serialize(&bob);
+        _commonStats.filter = bob.obj();
+    }
+
+    if (_state) {
+        stdx::lock_guard<stdx::mutex> lk(_state->mutex);
+        _syncStats_inlock();
+    }
+
+    auto ret = std::make_unique<PlanStageStats>(_commonStats, STAGE_PARALLEL_COLLSCAN);
+    ret->specific = std::make_unique<ParallelCollectionScanStats>(_specificStats);
+    return ret;
+}
+
+const SpecificStats* ParallelCollectionScan::getSpecificStats() const {
+    if (_state) {
+        stdx::lock_guard<stdx::mutex> lk(_state->mutex);
+        _syncStats_inlock();
+    }
+    return &_specificStats;
+}
+
+}  // namespace monger
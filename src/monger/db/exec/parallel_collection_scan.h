@@ -0,0 +1,127 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "monger/db/exec/plan_stats.h"
+#include "monger/db/exec/requires_collection_stage.h"
+#include "monger/db/record_id.h"
+
+namespace monger {
+
+class MatchExpression;
+class WorkingSet;
+
+/**
+ * Scans over a collection by splitting it into RecordId ranges ("partitions") which are read
+ * concurrently by a process-wide pool of worker threads. Documents are returned in no particular
+ * order.
+ *
+ * Partition boundaries are chosen by sampling the collection with a random cursor the first time
+ * the stage is worked. Each worker step reads a bounded amount of one partition under its own
+ * operation context, collection lock and storage snapshot, applies the filter and buffers the
+ * owned matching documents for this stage to hand out. A document is therefore seen at most once,
+ * with the same isolation as a collection scan which yields between reads.
+ *
+ * This stage holds no storage engine state on behalf of its own operation, so yielding is a no-op
+ * for it. It must run under an executor which yields, since its workers may queue for locks behind
+ * a writer which is in turn waiting for the locks held by this stage's operation.
+ */
+class ParallelCollectionScan final : public RequiresCollectionStage {
+public:
+    static const char* kStageType;
+
+    ParallelCollectionScan(OperationContext* opCtx,
+                           const Collection* collection,
+                           WorkingSet* workingSet,
+                           const MatchExpression* filter);
+
+    ~ParallelCollectionScan();
+
+    StageState doWork(WorkingSetID* out) final;
+    bool isEOF() final;
+
+    void doDispose() final;
+
+    StageType stageType() const final {
+        return STAGE_PARALLEL_COLLSCAN;
+    }
+
+    std::unique_ptr<PlanStageStats> getStats() final;
+
+    const SpecificStats* getSpecificStats() const final;
+
+protected:
+    void doSaveStateRequiresCollection() final {}
+
+    void doRestoreStateRequiresCollection() final {}
+
+private:
+    struct SharedState;
+
+    /**
+     * Picks the partition boundaries and positions a detached cursor at the start of each
+     * partition. Throws WriteConflictException if the sample could not be read.
+     */
+    void _setUpPartitions();
+
+    /**
+     * Copies the per-partition statistics maintained by the workers into '_specificStats'.
+     */
+    void _syncStats_inlock() const;
+
+    /**
+     * Waits for all in-progress worker steps to finish and prevents any more from starting.
+     */
+    void _cancelWorkers();
+
+    // WorkingSet is not owned by us.
+    WorkingSet* _workingSet;
+
+    // The filter is not owned by us. It is evaluated on worker threads.
+    const MatchExpression* _filter;
+
+    // State shared with the worker steps. Null until the partitions have been set up.
+    std::shared_ptr<SharedState> _state;
+
+    // The partition which will be asked for a result first on the next call to doWork().
+    size_t _nextPartition = 0;
+
+    // Number of completed worker steps reflected in '_specificStats'.
+    mutable size_t _stepsSynced = 0;
+
+    // Stats
+    mutable ParallelCollectionScanStats _specificStats;
+};
+
+}  // namespace monger
@@ -57,6 +57,44 @@ PlanStage::StageState PlanStage::work(WorkingSetID* out) {
     return workResult;
 }
 
+PlanStage::StageState PlanStage::workBatch(size_t maxBatchSize,
+                                           std::vector<WorkingSetID>* results,
+                                           WorkingSetID* out) {
+    invariant(_opCtx);
+    invariant(maxBatchSize > 0);
+    ScopedTimer timer(getClock(), &_commonStats.executionTimeMillis);
+    return doWorkBatch(maxBatchSize, results, out);
+}
+
+PlanStage::StageState PlanStage::doWorkBatch(size_t maxBatchSize,
+                                             std::vector<WorkingSetID>* results,
+                                             WorkingSetID* out) {
+    StageState workResult = doWork(out);
+    if (StageState::ADVANCED == workResult) {
+        results->push_back(*out);
+    }
+
+    recordWorks(1, StageState::ADVANCED == workResult ? 1 : 0, workResult);
+    return workResult;
+}
+
+void PlanStage::recordWorks(size_t numWorks, size_t numAdvanced, StageState lastState) {
+    invariant(numAdvanced <= numWorks);
+    _commonStats.works += numWorks;
+    _commonStats.advanced += numAdvanced;
+
+    // Every unit of work other than the last one returned either ADVANCED or NEED_TIME.
+    size_t numNeedTime = numWorks - numAdvanced;
+    if (StageState::ADVANCED != lastState && StageState::NEED_TIME != lastState) {
+        invariant(numNeedTime > 0);
+        --numNeedTime;
+        if (StageState::NEED_YIELD == lastState) {
+            ++_commonStats.needYield;
+        }
+    }
+    _commonStats.needTime += numNeedTime;
+}
+
 void PlanStage::saveState() {
     ++_commonStats.yields;
     for (auto&& child : _children) {
@@ -193,6 +193,26 @@ public:
      */
     StageState work(WorkingSetID* out);
 
+    /**
+     * Perform up to 'maxBatchSize' units of work on the query, appending the id of every result
+     * that work() would have returned as ADVANCED to 'results'. This lets callers amortize the
+     * cost of driving the stage tree over many results.
+     *
+     * Returns the state of the last unit of work performed. A state other than ADVANCED or
+     * NEED_TIME ends the batch early, in which case *out is set exactly as it would have been by
+     * work(). Results appended before that point are still valid and must be consumed or freed by
+     * the caller.
+     *
+     * Every member appended to 'results' except the last is guaranteed to hold owned data, since
+     * the storage backing it may have been invalidated by the stage advancing. The last member
+     * obeys the same rules as a result returned by work().
+     *
+     * Stages which do not override doWorkBatch() perform a single unit of work per call.
+     */
+    StageState workBatch(size_t maxBatchSize,
+                         std::vector<WorkingSetID>* results,
+                         WorkingSetID* out);
+
     /**
      * Returns true if no more work can be done on the query / out of results.
      */
@@ -341,6 +361,60 @@ protected:
      */
     virtual StageState doWork(WorkingSetID* out) = 0;
 
+    /**
+     * Performs up to 'maxBatchSize' units of work.  See comment at workBatch() above.
+     *
+     * The default implementation performs a single unit of work using doWork(). Stages which
+     * override this are responsible for updating the work counters in '_commonStats' with
+     * recordWorks().
+     */
+    virtual StageState doWorkBatch(size_t maxBatchSize,
+                                   std::vector<WorkingSetID>* results,
+                                   WorkingSetID* out);
+
+    /**
+     * Updates the work counters in '_commonStats' as if work() had been called 'numWorks' times,
+     * 'numAdvanced' of which returned ADVANCED and the last of which returned 'lastState'.
+     */
+    void recordWorks(size_t numWorks, size_t numAdvanced, StageState lastState);
+
+    /**
+     * Helper for implementing doWorkBatch() in stages whose doWork() can safely be called again
+     * before the previous result is consumed. Calls 'workOne', which must behave like doWork(),
+     * until 'maxBatchSize' units of work have been performed or it returns a state other than
+     * ADVANCED or NEED_TIME.
+     *
+     * The most recently produced result is made owned before each unit of work, as the record it
+     * refers to may not survive the underlying cursor advancing.
+     */
+    template <typename WorkOneFn>
+    StageState workBatchByUnit(WorkingSet* ws,
+                               size_t maxBatchSize,
+                               std::vector<WorkingSetID>* results,
+                               WorkingSetID* out,
+                               WorkOneFn&& workOne) {
+        size_t numWorks = 0;
+        size_t numAdvanced = 0;
+        StageState state = NEED_TIME;
+        while (numWorks < maxBatchSize) {
+            if (!results->empty()) {
+                ws->get(results->back())->makeObjOwnedIfNeeded();
+            }
+
+            ++numWorks;
+            state = workOne(out);
+            if (ADVANCED == state) {
+                results->push_back(*out);
+                ++numAdvanced;
+            } else if (NEED_TIME != state) {
+                break;
+            }
+        }
+
+        recordWorks(numWorks, numAdvanced, state);
+        return state;
+    }
+
     /**
      * Saves any stage-specific state required to resume where it was if the underlying data
      * changes.
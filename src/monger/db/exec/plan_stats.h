@@ -202,6 +202,31 @@ struct CollectionScanStats : public SpecificStats {
     boost::optional<Timestamp> maxTs;
 };
 
+struct ParallelCollectionScanStats : public SpecificStats {
+    SpecificStats* clone() const final {
+        return new ParallelCollectionScanStats(*this);
+    }
+
+    struct PartitionStats {
+        // How many documents in this partition did we check against our filter?
+        size_t docsTested = 0;
+
+        // How many documents in this partition passed the filter?
+        size_t nReturned = 0;
+
+        // How many times was a worker scheduled to read from this partition?
+        size_t steps = 0;
+
+        // Total time spent reading from this partition, summed over all steps.
+        Milliseconds executionTime{0};
+    };
+
+    // How many documents did we check against our filter, over all partitions?
+    size_t docsTested = 0;
+
+    std::vector<PartitionStats> partitions;
+};
+
 struct CountStats : public SpecificStats {
     CountStats() : nCounted(0), nSkipped(0) {}
 
@@ -233,6 +258,7 @@ struct CountScanStats : public SpecificStats {
         specific->collation = collation.getOwned();
         specific->startKey = startKey.getOwned();
         specific->endKey = endKey.getOwned();
+        specific->indexBounds = indexBounds.getOwned();
         return specific;
     }
 
@@ -251,6 +277,10 @@ struct CountScanStats : public SpecificStats {
     bool startKeyInclusive;
     bool endKeyInclusive;
 
+    // The bounds of the scan if they consist of several intervals, in which case the start and end
+    // keys are not set.
+    BSONObj indexBounds;
+
     int indexVersion;
 
     // Set to true if the index used for the count scan is multikey.
@@ -264,6 +294,9 @@ struct CountScanStats : public SpecificStats {
     bool isUnique;
 
     size_t keysExamined;
+
+    // Number of times the index cursor was positioned by seeking.
+    size_t seeks = 0;
 };
 
 struct DeleteStats : public SpecificStats {
@@ -339,6 +372,9 @@ struct FetchStats : public SpecificStats {
 
     // The total number of full documents touched by the fetch stage.
     size_t docsExamined = 0u;
+
+    // The number of documents the cost model expected the stage to fetch, if it could estimate it.
+    boost::optional<long long> estimatedDocsExamined;
 };
 
 struct IDHackStats : public SpecificStats {
@@ -419,6 +455,12 @@ struct IndexScanStats : public SpecificStats {
 
     // Number of times the index cursor is re-positioned during the execution of the scan.
     size_t seeks;
+
+    // The number of keys the cost model expected the scan to examine, if it could estimate it.
+    boost::optional<long long> estimatedKeysExamined;
+
+    // Whether the scan seeks over the distinct values of an unconstrained leading field.
+    bool isSkipScan = false;
 };
 
 struct LimitStats : public SpecificStats {
@@ -446,6 +488,12 @@ struct MultiPlanStats : public SpecificStats {
     SpecificStats* clone() const final {
         return new MultiPlanStats(*this);
     }
+
+    // Time spent in the trial period and ranking of the candidate plans.
+    long long planningTimeMicros = 0;
+
+    // Whether the candidate plans were worked concurrently on worker threads.
+    bool parallelTrial = false;
 };
 
 struct OrStats : public SpecificStats {
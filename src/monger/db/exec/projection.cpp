@@ -149,10 +149,16 @@ void ProjectionStage::getSimpleInclusionFields(const BSONObj& projObj, FieldSet*
 }
 
 bool ProjectionStage::isEOF() {
-    return child()->isEOF();
+    return !_pendingFailure && child()->isEOF();
 }
 
 PlanStage::StageState ProjectionStage::doWork(WorkingSetID* out) {
+    if (_pendingFailure) {
+        *out = WorkingSetCommon::allocateStatusMember(&_ws, *_pendingFailure);
+        _pendingFailure = boost::none;
+        return PlanStage::FAILURE;
+    }
+
     WorkingSetID id = WorkingSet::INVALID_ID;
     StageState status = child()->work(&id);
 
@@ -181,6 +187,54 @@ PlanStage::StageState ProjectionStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState ProjectionStage::doWorkBatch(size_t maxBatchSize,
+                                                   std::vector<WorkingSetID>* results,
+                                                   WorkingSetID* out) {
+    if (_pendingFailure) {
+        *out = WorkingSetCommon::allocateStatusMember(&_ws, *_pendingFailure);
+        _pendingFailure = boost::none;
+        recordWorks(1, 0, PlanStage::FAILURE);
+        return PlanStage::FAILURE;
+    }
+
+    const size_t numResultsBefore = results->size();
+    const size_t childWorksBefore = child()->getCommonStats()->works;
+    StageState status = child()->workBatch(maxBatchSize, results, out);
+
+    for (auto it = results->begin() + numResultsBefore; it != results->end(); ++it) {
+        Status projStatus = transform(_ws.get(*it));
+        if (!projStatus.isOK()) {
+            warning() << "Couldn't execute projection, status = " << redact(projStatus);
+
+            // Results which were already projected are still handed to the caller, while the
+            // remainder of the batch is discarded along with whatever ended it.
+            for (auto unprojected = it; unprojected != results->end(); ++unprojected) {
+                _ws.free(*unprojected);
+            }
+            results->erase(it, results->end());
+
+            if (PlanStage::NEED_YIELD == status) {
+                // Hand the child's yield request up unchanged, as doWork() does, and report the
+                // failure on the next call.
+                _pendingFailure = projStatus;
+                break;
+            }
+
+            if (PlanStage::FAILURE == status) {
+                _ws.free(*out);
+            }
+            *out = WorkingSetCommon::allocateStatusMember(&_ws, projStatus);
+            status = PlanStage::FAILURE;
+            break;
+        }
+    }
+
+    recordWorks(child()->getCommonStats()->works - childWorksBefore,
+                results->size() - numResultsBefore,
+                status);
+    return status;
+}
+
 std::unique_ptr<PlanStageStats> ProjectionStage::getStats() {
     _commonStats.isEOF = isEOF();
     auto ret = std::make_unique<PlanStageStats>(_commonStats, stageType());
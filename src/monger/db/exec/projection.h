@@ -29,6 +29,8 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
+
 #include "monger/db/exec/plan_stage.h"
 #include "monger/db/exec/projection_exec.h"
 #include "monger/db/jsobj.h"
@@ -54,6 +56,9 @@ protected:
 public:
     bool isEOF() final;
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(size_t maxBatchSize,
+                           std::vector<WorkingSetID>* results,
+                           WorkingSetID* out) final;
 
     std::unique_ptr<PlanStageStats> getStats() final;
 
@@ -89,6 +94,10 @@ private:
     // Used to retrieve a WorkingSetMember as part of 'doWork()'.
     WorkingSet& _ws;
 
+    // A projection failure found by 'doWorkBatch()' in a batch which the child ended by asking to
+    // yield. It is reported by the next call, once the yield request has been handed up.
+    boost::optional<Status> _pendingFailure;
+
     // Populated by 'getStats()'.
     ProjectionStats _specificStats;
 };
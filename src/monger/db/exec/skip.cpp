@@ -83,6 +83,33 @@ PlanStage::StageState SkipStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState SkipStage::doWorkBatch(size_t maxBatchSize,
+                                             std::vector<WorkingSetID>* results,
+                                             WorkingSetID* out) {
+    const size_t numResultsBefore = results->size();
+    const size_t childWorksBefore = child()->getCommonStats()->works;
+    StageState status = child()->workBatch(maxBatchSize, results, out);
+
+    // Drop the leading results of the batch while we're still skipping.
+    auto firstNew = results->begin() + numResultsBefore;
+    auto firstKept = firstNew;
+    while (_toSkip > 0 && firstKept != results->end()) {
+        _ws->free(*firstKept);
+        --_toSkip;
+        ++firstKept;
+    }
+    results->erase(firstNew, firstKept);
+
+    const size_t numAdvanced = results->size() - numResultsBefore;
+    if (PlanStage::ADVANCED == status && 0 == numAdvanced) {
+        // The last result of the batch was skipped.
+        status = PlanStage::NEED_TIME;
+    }
+
+    recordWorks(child()->getCommonStats()->works - childWorksBefore, numAdvanced, status);
+    return status;
+}
+
 unique_ptr<PlanStageStats> SkipStage::getStats() {
     _commonStats.isEOF = isEOF();
     _specificStats.skip = _toSkip;
@@ -43,6 +43,7 @@
 #include "monger/db/query/find_common.h"
 #include "monger/db/query/query_knobs_gen.h"
 #include "monger/db/query/query_planner.h"
+#include "monger/db/sorter/radix_sort.h"
 #include "monger/util/log.h"
 
 namespace monger {
@@ -54,19 +55,6 @@ using std::vector;
 // static
 const char* SortStage::kStageType = "SORT";
 
-SortStage::WorkingSetComparator::WorkingSetComparator(BSONObj p) : pattern(p) {}
-
-bool SortStage::WorkingSetComparator::operator()(const SortableDataItem& lhs,
-                                                 const SortableDataItem& rhs) const {
-    // False means ignore field names.
-    int result = lhs.sortKey.woCompare(rhs.sortKey, pattern, false);
-    if (0 != result) {
-        return result < 0;
-    }
-    // Indices use RecordId as an additional sort key so we must as well.
-    return lhs.recordId < rhs.recordId;
-}
-
 SortStage::SortStage(OperationContext* opCtx,
                      const SortStageParams& params,
                      WorkingSet* ws,
@@ -74,21 +62,12 @@ SortStage::SortStage(OperationContext* opCtx,
     : PlanStage(kStageType, opCtx),
       _ws(ws),
       _pattern(params.pattern),
+      _sortKeyPattern(FindCommon::transformSortSpec(_pattern)),
       _limit(params.limit),
       _sorted(false),
       _resultIterator(_data.end()),
       _memUsage(0) {
     _children.emplace_back(child);
-
-    BSONObj sortComparator = FindCommon::transformSortSpec(_pattern);
-    _sortKeyComparator = std::make_unique<WorkingSetComparator>(sortComparator);
-
-    // If limit > 1, we need to initialize _dataSet here to maintain ordered set of data items while
-    // fetching from the child stage.
-    if (_limit > 1) {
-        const WorkingSetComparator& cmp = *_sortKeyComparator;
-        _dataSet.reset(new SortableDataItemSet(cmp));
-    }
 }
 
 SortStage::~SortStage() {}
@@ -122,21 +101,21 @@ PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
         if (PlanStage::ADVANCED == code) {
             WorkingSetMember* member = _ws->get(id);
 
-            SortableDataItem item;
-            item.wsid = id;
-
             // We extract the sort key from the WSM's computed data. This must have been generated
-            // by a SortKeyGeneratorStage descendent in the execution tree.
+            // by a SortKeyGeneratorStage descendent in the execution tree. The keys generated are
+            // already ordered with respect to the collation, so they are encoded without one.
             auto sortKeyComputedData =
                 static_cast<const SortKeyComputedData*>(member->getComputed(WSM_SORT_KEY));
-            item.sortKey = sortKeyComputedData->getSortKey();
 
-            if (member->hasRecordId()) {
-                // The RecordId breaks ties when sorting two WSMs with the same sort key.
-                item.recordId = member->recordId;
-            }
+            // The RecordId breaks ties when sorting two WSMs with the same sort key.
+            SortableDataItem item{id,
+                                  SortKeyString(sortKeyComputedData->getSortKey(),
+                                                _sortKeyPattern,
+                                                member->hasRecordId() ? member->recordId
+                                                                      : RecordId()),
+                                  0};
 
-            addToBuffer(item);
+            addToBuffer(std::move(item));
 
             return PlanStage::NEED_TIME;
         } else if (PlanStage::IS_EOF == code) {
@@ -186,106 +165,43 @@ const SpecificStats* SortStage::getSpecificStats() const {
     return &_specificStats;
 }
 
-/**
- * addToBuffer() and sortBuffer() work differently based on the
- * configured limit. addToBuffer() is also responsible for
- * performing some accounting on the overall memory usage to
- * make sure we're not using too much memory.
- *
- * limit == 0:
- *     addToBuffer() - Adds item to vector.
- *     sortBuffer() - Sorts vector.
- * limit == 1:
- *     addToBuffer() - Replaces first item in vector with max of
- *                     current and new item.
- *                     Updates memory usage if item was replaced.
- *     sortBuffer() - Does nothing.
- * limit > 1:
- *     addToBuffer() - Does not update vector. Adds item to set.
- *                     If size of set exceeds limit, remove item from set
- *                     with lowest key. Updates memory usage accordingly.
- *     sortBuffer() - Copies items from set to vectors.
- */
-void SortStage::addToBuffer(const SortableDataItem& item) {
-    // Holds ID of working set member to be freed at end of this function.
-    WorkingSetID wsidToFree = WorkingSet::INVALID_ID;
-
+void SortStage::addToBuffer(SortableDataItem item) {
     WorkingSetMember* member = _ws->get(item.wsid);
-    if (_limit == 0) {
-        // Ensure that the BSONObj underlying the WorkingSetMember is owned in case we yield.
-        member->makeObjOwnedIfNeeded();
-        _data.push_back(item);
-        _memUsage += member->getMemUsage();
-    } else if (_limit == 1) {
-        if (_data.empty()) {
-            member->makeObjOwnedIfNeeded();
-            _data.push_back(item);
-            _memUsage = member->getMemUsage();
-            return;
-        }
-        wsidToFree = item.wsid;
-        const WorkingSetComparator& cmp = *_sortKeyComparator;
-        // Compare new item with existing item in vector.
-        if (cmp(item, _data[0])) {
-            wsidToFree = _data[0].wsid;
-            member->makeObjOwnedIfNeeded();
-            _data[0] = item;
-            _memUsage = member->getMemUsage();
-        }
-    } else {
-        // Update data item set instead of vector
-        // Limit not reached - insert and return
-        vector<SortableDataItem>::size_type limit(_limit);
-        if (_dataSet->size() < limit) {
-            member->makeObjOwnedIfNeeded();
-            _dataSet->insert(item);
-            _memUsage += member->getMemUsage();
+
+    if (_limit != 0 && _data.size() == _limit) {
+        // The buffer is full. Unless the new item is better than the worst buffered item, which
+        // is at the top of the heap, it is known not to be in the top k set.
+        if (!(item < _data.front())) {
+            _ws->free(item.wsid);
             return;
         }
-        // Limit will be exceeded - compare with item with lowest key
-        // If new item does not have a lower key value than last item,
-        // do nothing.
-        wsidToFree = item.wsid;
-        SortableDataItemSet::const_iterator lastItemIt = --(_dataSet->end());
-        const SortableDataItem& lastItem = *lastItemIt;
-        const WorkingSetComparator& cmp = *_sortKeyComparator;
-        if (cmp(item, lastItem)) {
-            _memUsage -= _ws->get(lastItem.wsid)->getMemUsage();
-            _memUsage += member->getMemUsage();
-            wsidToFree = lastItem.wsid;
-            // According to std::set iterator validity rules,
-            // it does not matter which of erase()/insert() happens first.
-            // Here, we choose to erase first to release potential resources
-            // used by the last item and to keep the scope of the iterator to a minimum.
-            _dataSet->erase(lastItemIt);
-            member->makeObjOwnedIfNeeded();
-            _dataSet->insert(item);
-        }
+
+        std::pop_heap(_data.begin(), _data.end());
+        _memUsage -= _data.back().memUsage;
+        _ws->free(_data.back().wsid);
+        _data.pop_back();
     }
 
-    // There was a buffered result which we can throw out because we are executing a sort with a
-    // limit, and the result is now known not to be in the top k set. Free the working set member
-    // associated with 'wsidToFree'.
-    if (wsidToFree != WorkingSet::INVALID_ID) {
-        _ws->free(wsidToFree);
+    // Ensure that the BSONObj underlying the WorkingSetMember is owned in case we yield.
+    member->makeObjOwnedIfNeeded();
+    item.memUsage = member->getMemUsage() + item.sortKey.memUsageForSorter();
+    _memUsage += item.memUsage;
+    _data.push_back(std::move(item));
+
+    if (_limit != 0) {
+        std::push_heap(_data.begin(), _data.end());
     }
 }
 
 void SortStage::sortBuffer() {
-    if (_limit == 0) {
-        const WorkingSetComparator& cmp = *_sortKeyComparator;
-        std::sort(_data.begin(), _data.end(), cmp);
-    } else if (_limit == 1) {
-        // Buffer contains either 0 or 1 item so it is already in a sorted state.
+    if (_limit != 0) {
+        std::sort_heap(_data.begin(), _data.end());
         return;
-    } else {
-        // Set already contains items in sorted order, so we simply copy the items
-        // from the set to the vector.
-        // Release the memory for the set after the copy.
-        vector<SortableDataItem> newData(_dataSet->begin(), _dataSet->end());
-        _data.swap(newData);
-        _dataSet.reset();
     }
+
+    sorter::radixSort(_data.begin(), _data.end(), [](const SortableDataItem& item) {
+        return item.sortKey.getSortBytes();
+    });
 }
 
 }  // namespace monger
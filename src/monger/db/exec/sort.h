@@ -29,7 +29,6 @@
 
 #pragma once
 
-#include <set>
 #include <vector>
 
 #include "monger/db/exec/plan_stage.h"
@@ -38,6 +37,7 @@
 #include "monger/db/jsobj.h"
 #include "monger/db/query/index_bounds.h"
 #include "monger/db/record_id.h"
+#include "monger/db/sorter/sort_key_string.h"
 #include "monger/stdx/unordered_map.h"
 
 namespace monger {
@@ -57,7 +57,10 @@ public:
 };
 
 /**
- * Sorts the input received from the child according to the sort pattern provided.
+ * Sorts the input received from the child according to the sort pattern provided. Sort keys are
+ * encoded as KeyStrings, so that they compare bytewise. Without a limit, the buffered input is
+ * radix sorted once the child is exhausted; with a limit, only the best 'limit' results are kept,
+ * in a bounded heap.
  *
  * Preconditions:
  *   -- For each field in 'pattern', all inputs in the child must handle a getFieldDotted for that
@@ -86,79 +89,52 @@ public:
     static const char* kStageType;
 
 private:
-    //
-    // Query Stage
-    //
-
-    // Not owned by us.
-    WorkingSet* _ws;
-
-    // The raw sort _pattern as expressed by the user
-    BSONObj _pattern;
-
-    // Equal to 0 for no limit.
-    size_t _limit;
-
-    //
-    // Data storage
-    //
-
-    // Have we sorted our data? If so, we can access _resultIterator. If not,
-    // we're still populating _data.
-    bool _sorted;
-
-    // Collection of working set members to sort with their respective sort key.
+    // A buffered working set member and its sort key.
     struct SortableDataItem {
         WorkingSetID wsid;
-        BSONObj sortKey;
-        // Since we must replicate the behavior of a covered sort as much as possible we use the
-        // RecordId to break sortKey ties.
-        // See sorta.js.
-        RecordId recordId;
-    };
 
-    // Comparison object for data buffers (vector and set). Items are compared on (sortKey, loc).
-    // This is also how the items are ordered in the indices. Keys are compared using
-    // BSONObj::woCompare() with RecordId as a tie-breaker.
-    //
-    // We are comparing keys generated by the SortKeyGenerator, which are already ordered with
-    // respect the collation. Therefore, we explicitly avoid comparing using a collator here.
-    struct WorkingSetComparator {
-        explicit WorkingSetComparator(BSONObj p);
+        // Since we must replicate the behavior of a covered sort as much as possible, the sort key
+        // includes the RecordId of the member, if any, to break ties between equal sort keys.
+        // See sorta.js.
+        SortKeyString sortKey;
 
-        bool operator()(const SortableDataItem& lhs, const SortableDataItem& rhs) const;
+        // The memory accounted for the member when it was buffered.
+        size_t memUsage;
 
-        BSONObj pattern;
+        bool operator<(const SortableDataItem& other) const {
+            return sortKey < other.sortKey;
+        }
     };
 
     /**
-     * Inserts one item into data buffer (vector or set).
-     * If limit is exceeded, remove item with lowest key.
+     * Buffers 'item'. With a limit, the buffer is a max-heap of the best '_limit' items seen so
+     * far, and either 'item' or the worst buffered item is freed once the limit is reached.
      */
-    void addToBuffer(const SortableDataItem& item);
+    void addToBuffer(SortableDataItem item);
 
     /**
-     * Sorts data buffer.
-     * Assumes no more items will be added to buffer.
-     * If data is stored in set, copy set
-     * contents to vector and clear set.
+     * Sorts the buffer, once all items have been added to it.
      */
     void sortBuffer();
 
-    // Comparator for data buffer
-    // Initialization follows sort key generator
-    std::unique_ptr<WorkingSetComparator> _sortKeyComparator;
+    // Not owned by us.
+    WorkingSet* _ws;
+
+    // The raw sort _pattern as expressed by the user
+    BSONObj _pattern;
+
+    // The directions of '_pattern', which sort keys are encoded with.
+    SortKeyString::Pattern _sortKeyPattern;
+
+    // Equal to 0 for no limit.
+    size_t _limit;
+
+    // Have we sorted our data? If so, we can access _resultIterator. If not,
+    // we're still populating _data.
+    bool _sorted;
 
     // The data we buffer and sort.
-    // _data will contain sorted data when all data is gathered
-    // and sorted.
-    // When _limit is greater than 1 and not all data has been gathered from child stage,
-    // _dataSet is used instead to maintain an ordered set of the incomplete data set.
-    // When the data set is complete, we copy the items from _dataSet to _data which will
-    // be used to provide the results of this stage through _resultIterator.
     std::vector<SortableDataItem> _data;
-    typedef std::set<SortableDataItem, WorkingSetComparator> SortableDataItemSet;
-    std::unique_ptr<SortableDataItemSet> _dataSet;
 
     // Iterates through _data post-sort returning it.
     std::vector<SortableDataItem>::iterator _resultIterator;
@@ -93,6 +93,22 @@ void WorkingSet::clear() {
     _yieldSensitiveIds.clear();
 }
 
+WorkingSetID WorkingSet::transferFrom(WorkingSet* other, WorkingSetID id) {
+    invariant(other != this);
+    invariant(!other->isFree(id));
+
+    // Swap the member for the blank one in the newly allocated slot, so that freeing 'id' in
+    // 'other' only has to clear a member which holds nothing.
+    WorkingSetID newId = allocate();
+    std::swap(_data[newId].member, other->_data[id].member);
+    other->free(id);
+
+    if (_data[newId].member->getState() == WorkingSetMember::RID_AND_IDX) {
+        _yieldSensitiveIds.push_back(newId);
+    }
+    return newId;
+}
+
 void WorkingSet::transitionToRecordIdAndIdx(WorkingSetID id) {
     WorkingSetMember* member = get(id);
     member->_state = WorkingSetMember::RID_AND_IDX;
@@ -92,6 +92,12 @@ public:
      */
     void clear();
 
+    /**
+     * Moves the member 'id' of 'other' into a newly allocated member of this working set, and
+     * frees 'id' in 'other'. Returns the id of the new member. No data is copied.
+     */
+    WorkingSetID transferFrom(WorkingSet* other, WorkingSetID id);
+
     //
     // WorkingSetMember state transitions
     //
@@ -156,4 +156,37 @@ TEST_F(WorkingSetFixture, getDottedFieldFromIndex) {
     ASSERT_FALSE(member->getFieldDotted("y", &elt));
 }
 
+TEST_F(WorkingSetFixture, transferFromMovesMemberAndFreesSource) {
+    member->recordId = RecordId(42);
+    member->obj = Snapshotted<BSONObj>(SnapshotId(), BSON("x" << 1));
+    ws->transitionToRecordIdAndObj(id);
+
+    WorkingSet target;
+    WorkingSetID existing = target.allocate();
+    WorkingSetID moved = target.transferFrom(ws.get(), id);
+    ASSERT_NOT_EQUALS(moved, existing);
+    ASSERT_TRUE(ws->isFree(id));
+
+    WorkingSetMember* movedMember = target.get(moved);
+    ASSERT_EQUALS(WorkingSetMember::RID_AND_OBJ, movedMember->getState());
+    ASSERT_EQUALS(RecordId(42), movedMember->recordId);
+    ASSERT_BSONOBJ_EQ(BSON("x" << 1), movedMember->obj.value());
+
+    // The freed id is reused with a blank member.
+    WorkingSetID reused = ws->allocate();
+    ASSERT_EQUALS(id, reused);
+    ASSERT_EQUALS(WorkingSetMember::INVALID, ws->get(reused)->getState());
+}
+
+TEST_F(WorkingSetFixture, transferFromKeepsIndexKeyMembersYieldSensitive) {
+    member->keyData.push_back(IndexKeyDatum(BSON("a" << 1), BSON("" << 5), nullptr));
+    ws->transitionToRecordIdAndIdx(id);
+
+    WorkingSet target;
+    WorkingSetID moved = target.transferFrom(ws.get(), id);
+    std::vector<WorkingSetID> yieldSensitive = target.getAndClearYieldSensitiveIds();
+    ASSERT_EQUALS(1U, yieldSensitive.size());
+    ASSERT_EQUALS(moved, yieldSensitive[0]);
+}
+
 }  // namespace
@@ -43,14 +43,19 @@
 #include "monger/db/client.h"
 #include "monger/db/concurrency/write_conflict_exception.h"
 #include "monger/db/curop.h"
+#include "monger/db/index/index_access_method_gen.h"
 #include "monger/db/index/index_descriptor.h"
 #include "monger/db/jsobj.h"
 #include "monger/db/keypattern.h"
 #include "monger/db/operation_context.h"
 #include "monger/db/repl/replication_coordinator.h"
 #include "monger/db/repl/timestamp_block.h"
+#include "monger/db/service_context.h"
 #include "monger/db/storage/durable_catalog.h"
 #include "monger/db/storage/storage_options.h"
+#include "monger/stdx/condition_variable.h"
+#include "monger/stdx/mutex.h"
+#include "monger/util/concurrency/thread_pool.h"
 #include "monger/util/log.h"
 #include "monger/util/progress_meter.h"
 #include "monger/util/scopeguard.h"
@@ -85,6 +90,55 @@ std::vector<BSONObj> asVector(const BSONObjSet& objSet) {
     return {objSet.begin(), objSet.end()};
 }
 
+// When keys are generated in parallel, the documents of an index build are handed to the worker
+// pool in batches of at most this many documents or bytes.
+constexpr size_t kMaxDocsPerKeyGenerationBatch = 1024;
+constexpr size_t kMaxBytesPerKeyGenerationBatch = 4 * 1024 * 1024;
+
+struct KeyGenerationPool {
+    stdx::mutex mutex;
+    std::unique_ptr<ThreadPool> pool;
+};
+
+const auto getKeyGenerationPool = ServiceContext::declareDecoration<KeyGenerationPool>();
+
+ServiceContext::ConstructorActionRegisterer keyGenerationPoolRegisterer{
+    "IndexBuildKeyGenerationPool",
+    [](ServiceContext* service) {},
+    [](ServiceContext* service) {
+        std::unique_ptr<ThreadPool> pool;
+        {
+            auto& workers = getKeyGenerationPool(service);
+            stdx::lock_guard<stdx::mutex> lk(workers.mutex);
+            pool = std::move(workers.pool);
+        }
+        if (pool) {
+            pool->shutdown();
+            pool->join();
+        }
+    }};
+
+/**
+ * Returns the pool shared by all index builds which generate keys in parallel, starting it on
+ * first use. Its size is taken from 'maxIndexBuildKeyGenerationThreads' at that time.
+ */
+ThreadPool* keyGenerationPool(ServiceContext* service) {
+    auto& workers = getKeyGenerationPool(service);
+    stdx::lock_guard<stdx::mutex> lk(workers.mutex);
+    if (!workers.pool) {
+        ThreadPool::Options options;
+        options.poolName = "IndexBuildKeyGeneration";
+        options.threadNamePrefix = "indexKeyGen-";
+        options.minThreads = 0;
+        options.maxThreads =
+            static_cast<size_t>(std::max(1, maxIndexBuildKeyGenerationThreads.load()));
+        options.onCreateThread = [](const std::string& name) { Client::initThread(name); };
+        workers.pool = std::make_unique<ThreadPool>(options);
+        workers.pool->startup();
+    }
+    return workers.pool.get();
+}
+
 // TODO SERVER-36385: Remove this
 const int TempKeyMaxSize = 1024;
 
@@ -506,6 +560,8 @@ public:
                     const IndexDescriptor* descriptor,
                     size_t maxMemoryUsageBytes);
 
+    ~BulkBuilderImpl();
+
     Status insert(OperationContext* opCtx,
                   const BSONObj& obj,
                   const RecordId& loc,
@@ -524,21 +580,89 @@ public:
     int64_t getKeysInserted() const final;
 
 private:
-    std::unique_ptr<Sorter> _sorter;
-    const IndexAccessMethod* _real;
-    int64_t _keysInserted = 0;
+    /**
+     * The keys generated from a subset of the documents, sorted separately from the other subsets.
+     */
+    struct Partition {
+        Partition(const IndexAccessMethod* index,
+                  const IndexDescriptor* descriptor,
+                  size_t maxMemoryUsageBytes);
 
-    // Set to true if any document added to the BulkBuilder causes the index to become multikey.
-    bool _isMultiKey = false;
+        Status addKeys(const BSONObj& obj, const RecordId& loc, GetKeysMode mode);
 
-    // Holds the path components that cause this index to be multikey. The '_indexMultikeyPaths'
-    // vector remains empty if this index doesn't support path-level multikey tracking.
-    MultikeyPaths _indexMultikeyPaths;
+        std::unique_ptr<Sorter> sorter;
+        const IndexAccessMethod* real;
+        int64_t keysInserted = 0;
+
+        // Set to true if any document added to this partition causes the index to become
+        // multikey.
+        bool isMultiKey = false;
+
+        // Holds the path components that cause this index to be multikey. The
+        // 'indexMultikeyPaths' vector remains empty if this index doesn't support path-level
+        // multikey tracking.
+        MultikeyPaths indexMultikeyPaths;
+
+        // Caches the set of all multikey metadata keys generated from the documents of this
+        // partition. These are inserted into the sorter after all normal data keys have been
+        // added, just before the bulk build is committed.
+        BSONObjSet multikeyMetadataKeys{SimpleBSONObjComparator::kInstance.makeBSONObjSet()};
+    };
+
+    /**
+     * Owned documents whose keys are generated together by a worker.
+     */
+    struct Batch {
+        std::vector<std::pair<BSONObj, RecordId>> docs;
+        size_t bytes = 0;
+        GetKeysMode mode = GetKeysMode::kEnforceConstraints;
+    };
+
+    /**
+     * State shared with the batches in progress on the worker pool. Each partition processes at
+     * most one batch at a time.
+     */
+    struct SharedState {
+        std::vector<std::unique_ptr<Partition>> partitions;
+
+        stdx::mutex mutex;
+        stdx::condition_variable batchFinished;
 
-    // Caches the set of all multikey metadata keys generated during the bulk build process.
-    // These are inserted into the sorter after all normal data keys have been added, just
-    // before the bulk build is committed.
-    BSONObjSet _multikeyMetadataKeys{SimpleBSONObjComparator::kInstance.makeBSONObjSet()};
+        // The partitions which are not processing a batch.
+        std::vector<size_t> idlePartitions;
+
+        // The first error encountered by a worker, which fails the build.
+        Status status = Status::OK();
+
+        // Set when the builder is destroyed before done(), so that queued batches are skipped.
+        AtomicWord<bool> cancelled{false};
+    };
+
+    static void _processBatch(const std::shared_ptr<SharedState>& state,
+                              size_t partitionIndex,
+                              const Batch& batch,
+                              Status status);
+
+    /**
+     * Hands '_batch' to the next idle partition, waiting for one to become idle.
+     */
+    Status _submitBatch(OperationContext* opCtx);
+
+    /**
+     * Waits for the batches in progress to finish.
+     */
+    void _waitForIdlePartitions();
+
+    const IndexDescriptor* const _descriptor;
+    const std::shared_ptr<SharedState> _state = std::make_shared<SharedState>();
+
+    // The documents not yet handed to a partition when keys are generated in parallel.
+    Batch _batch;
+
+    // Combined from all the partitions by done().
+    int64_t _keysInserted = 0;
+    bool _isMultiKey = false;
+    MultikeyPaths _indexMultikeyPaths;
 };
 
 std::unique_ptr<IndexAccessMethod::BulkBuilder> AbstractIndexAccessMethod::initiateBulk(
@@ -546,55 +670,145 @@ std::unique_ptr<IndexAccessMethod::BulkBuilder> AbstractIndexAccessMethod::initi
     return std::make_unique<BulkBuilderImpl>(this, _descriptor, maxMemoryUsageBytes);
 }
 
-AbstractIndexAccessMethod::BulkBuilderImpl::BulkBuilderImpl(const IndexAccessMethod* index,
-                                                            const IndexDescriptor* descriptor,
-                                                            size_t maxMemoryUsageBytes)
-    : _sorter(Sorter::make(
+AbstractIndexAccessMethod::BulkBuilderImpl::Partition::Partition(
+    const IndexAccessMethod* index, const IndexDescriptor* descriptor, size_t maxMemoryUsageBytes)
+    : sorter(Sorter::make(
           SortOptions()
               .TempDir(storageGlobalParams.dbpath + "/_tmp")
               .ExtSortAllowed()
               .MaxMemoryUsageBytes(maxMemoryUsageBytes),
           BtreeExternalSortComparison(descriptor->keyPattern(), descriptor->version()))),
-      _real(index) {}
+      real(index) {}
 
-Status AbstractIndexAccessMethod::BulkBuilderImpl::insert(OperationContext* opCtx,
-                                                          const BSONObj& obj,
-                                                          const RecordId& loc,
-                                                          const InsertDeleteOptions& options) {
+Status AbstractIndexAccessMethod::BulkBuilderImpl::Partition::addKeys(const BSONObj& obj,
+                                                                      const RecordId& loc,
+                                                                      GetKeysMode mode) {
     BSONObjSet keys = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
     MultikeyPaths multikeyPaths;
 
     try {
-        _real->getKeys(obj, options.getKeysMode, &keys, &_multikeyMetadataKeys, &multikeyPaths);
+        real->getKeys(obj, mode, &keys, &multikeyMetadataKeys, &multikeyPaths);
     } catch (...) {
         return exceptionToStatus();
     }
 
     if (!multikeyPaths.empty()) {
-        if (_indexMultikeyPaths.empty()) {
-            _indexMultikeyPaths = multikeyPaths;
+        if (indexMultikeyPaths.empty()) {
+            indexMultikeyPaths = multikeyPaths;
         } else {
-            invariant(_indexMultikeyPaths.size() == multikeyPaths.size());
+            invariant(indexMultikeyPaths.size() == multikeyPaths.size());
             for (size_t i = 0; i < multikeyPaths.size(); ++i) {
-                _indexMultikeyPaths[i].insert(multikeyPaths[i].begin(), multikeyPaths[i].end());
+                indexMultikeyPaths[i].insert(multikeyPaths[i].begin(), multikeyPaths[i].end());
             }
         }
     }
 
     for (const auto& key : keys) {
-        _sorter->add(key, loc);
-        ++_keysInserted;
+        sorter->add(key, loc);
+        ++keysInserted;
     }
 
-    _isMultiKey = _isMultiKey ||
-        _real->shouldMarkIndexAsMultikey(
-            {keys.begin(), keys.end()},
-            {_multikeyMetadataKeys.begin(), _multikeyMetadataKeys.end()},
-            multikeyPaths);
+    isMultiKey = isMultiKey ||
+        real->shouldMarkIndexAsMultikey({keys.begin(), keys.end()},
+                                        {multikeyMetadataKeys.begin(), multikeyMetadataKeys.end()},
+                                        multikeyPaths);
 
     return Status::OK();
 }
 
+AbstractIndexAccessMethod::BulkBuilderImpl::BulkBuilderImpl(const IndexAccessMethod* index,
+                                                            const IndexDescriptor* descriptor,
+                                                            size_t maxMemoryUsageBytes)
+    : _descriptor(descriptor) {
+    // Each partition sorts its keys within an equal share of the memory of the build.
+    const size_t numPartitions =
+        static_cast<size_t>(std::max(1, maxIndexBuildKeyGenerationThreads.load()));
+    for (size_t i = 0; i < numPartitions; ++i) {
+        _state->partitions.push_back(
+            std::make_unique<Partition>(index, descriptor, maxMemoryUsageBytes / numPartitions));
+        _state->idlePartitions.push_back(numPartitions - 1 - i);
+    }
+}
+
+AbstractIndexAccessMethod::BulkBuilderImpl::~BulkBuilderImpl() {
+    _state->cancelled.store(true);
+    _waitForIdlePartitions();
+}
+
+Status AbstractIndexAccessMethod::BulkBuilderImpl::insert(OperationContext* opCtx,
+                                                          const BSONObj& obj,
+                                                          const RecordId& loc,
+                                                          const InsertDeleteOptions& options) {
+    if (_state->partitions.size() == 1) {
+        return _state->partitions.front()->addKeys(obj, loc, options.getKeysMode);
+    }
+
+    _batch.docs.emplace_back(obj.getOwned(), loc);
+    _batch.bytes += obj.objsize();
+    _batch.mode = options.getKeysMode;
+    if (_batch.docs.size() < kMaxDocsPerKeyGenerationBatch &&
+        _batch.bytes < kMaxBytesPerKeyGenerationBatch) {
+        return Status::OK();
+    }
+    return _submitBatch(opCtx);
+}
+
+void AbstractIndexAccessMethod::BulkBuilderImpl::_processBatch(
+    const std::shared_ptr<SharedState>& state,
+    size_t partitionIndex,
+    const Batch& batch,
+    Status status) {
+    auto& partition = *state->partitions[partitionIndex];
+    try {
+        for (auto it = batch.docs.begin();
+             status.isOK() && it != batch.docs.end() && !state->cancelled.load();
+             ++it) {
+            status = partition.addKeys(it->first, it->second, batch.mode);
+        }
+    } catch (...) {
+        // The sorter throws if it fails to spill.
+        status = exceptionToStatus();
+    }
+
+    stdx::lock_guard<stdx::mutex> lk(state->mutex);
+    if (!status.isOK() && state->status.isOK()) {
+        state->status = std::move(status);
+    }
+    state->idlePartitions.push_back(partitionIndex);
+    state->batchFinished.notify_all();
+}
+
+Status AbstractIndexAccessMethod::BulkBuilderImpl::_submitBatch(OperationContext* opCtx) {
+    size_t partitionIndex;
+    try {
+        stdx::unique_lock<stdx::mutex> lk(_state->mutex);
+        opCtx->waitForConditionOrInterrupt(_state->batchFinished, lk, [&] {
+            return !_state->idlePartitions.empty() || !_state->status.isOK();
+        });
+        if (!_state->status.isOK()) {
+            return _state->status;
+        }
+        partitionIndex = _state->idlePartitions.back();
+        _state->idlePartitions.pop_back();
+    } catch (...) {
+        return exceptionToStatus();
+    }
+
+    // The pool may run a task inline if it cannot be scheduled, so do not hold the mutex here.
+    keyGenerationPool(opCtx->getServiceContext())
+        ->schedule([ state = _state, partitionIndex, batch = std::move(_batch) ](Status status) {
+            _processBatch(state, partitionIndex, batch, std::move(status));
+        });
+    _batch = Batch();
+    return Status::OK();
+}
+
+void AbstractIndexAccessMethod::BulkBuilderImpl::_waitForIdlePartitions() {
+    stdx::unique_lock<stdx::mutex> lk(_state->mutex);
+    _state->batchFinished.wait(
+        lk, [&] { return _state->idlePartitions.size() == _state->partitions.size(); });
+}
+
 const MultikeyPaths& AbstractIndexAccessMethod::BulkBuilderImpl::getMultikeyPaths() const {
     return _indexMultikeyPaths;
 }
@@ -605,11 +819,53 @@ bool AbstractIndexAccessMethod::BulkBuilderImpl::isMultikey() const {
 
 IndexAccessMethod::BulkBuilder::Sorter::Iterator*
 AbstractIndexAccessMethod::BulkBuilderImpl::done() {
-    for (const auto& key : _multikeyMetadataKeys) {
-        _sorter->add(key, kMultikeyMetadataKeyId);
+    auto& partitions = _state->partitions;
+    _waitForIdlePartitions();
+    uassertStatusOK(_state->status);
+
+    // The documents of the last, partial batch are handled on this thread.
+    for (auto&& doc : _batch.docs) {
+        uassertStatusOK(partitions.front()->addKeys(doc.first, doc.second, _batch.mode));
+    }
+    _batch = Batch();
+
+    BSONObjSet multikeyMetadataKeys = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+    for (auto&& partition : partitions) {
+        _keysInserted += partition->keysInserted;
+        _isMultiKey = _isMultiKey || partition->isMultiKey;
+        multikeyMetadataKeys.insert(partition->multikeyMetadataKeys.begin(),
+                                    partition->multikeyMetadataKeys.end());
+
+        const auto& paths = partition->indexMultikeyPaths;
+        if (_indexMultikeyPaths.empty()) {
+            _indexMultikeyPaths = paths;
+        } else if (!paths.empty()) {
+            invariant(_indexMultikeyPaths.size() == paths.size());
+            for (size_t i = 0; i < paths.size(); ++i) {
+                _indexMultikeyPaths[i].insert(paths[i].begin(), paths[i].end());
+            }
+        }
+    }
+
+    for (const auto& key : multikeyMetadataKeys) {
+        partitions.front()->sorter->add(key, kMultikeyMetadataKeyId);
         ++_keysInserted;
     }
-    return _sorter->done();
+
+    if (partitions.size() == 1) {
+        return partitions.front()->sorter->done();
+    }
+
+    // Each partition holds sorted runs of its own keys. Merge them into a single sorted stream.
+    std::vector<std::shared_ptr<Sorter::Iterator>> iterators;
+    for (auto&& partition : partitions) {
+        iterators.emplace_back(partition->sorter->done());
+    }
+    return Sorter::Iterator::merge(
+        iterators,
+        "",
+        SortOptions(),
+        BtreeExternalSortComparison(_descriptor->keyPattern(), _descriptor->version()));
 }
 
 int64_t AbstractIndexAccessMethod::BulkBuilderImpl::getKeysInserted() const {
@@ -627,7 +883,12 @@ Status AbstractIndexAccessMethod::commitBulk(OperationContext* opCtx,
 
     Timer timer;
 
-    std::unique_ptr<BulkBuilder::Sorter::Iterator> it(bulk->done());
+    std::unique_ptr<BulkBuilder::Sorter::Iterator> it;
+    try {
+        it.reset(bulk->done());
+    } catch (...) {
+        return exceptionToStatus();
+    }
 
     static const char* message = "Index Build: inserting keys from external sorter into index";
     ProgressMeterHolder pm;
@@ -230,6 +230,8 @@ public:
         /**
          * Inserts all multikey metadata keys cached during the BulkBuilder's lifetime into the
          * underlying Sorter, finalizes it, and returns an iterator over the sorted dataset.
+         *
+         * Throws if generating the keys of any inserted document failed after insert() returned.
          */
         virtual Sorter::Iterator* done() = 0;
 
@@ -0,0 +1,302 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "monger/platform/basic.h"
+
+#include "monger/db/matcher/compiled_match_expression.h"
+
+#include <algorithm>
+
+#include "monger/db/matcher/expression.h"
+#include "monger/db/matcher/expression_path.h"
+#include "monger/db/matcher/path_internal.h"
+#include "monger/util/assert_util.h"
+
+namespace monger {
+
+namespace {
+
+/**
+ * Orders the children of a $and, $or or $nor for evaluation. Lower ranks are evaluated first:
+ * cheap and selective predicates, then progressively more expensive ones, then nodes which are
+ * always handed to the tree.
+ */
+int evaluationRank(const MatchExpression* expr) {
+    switch (expr->matchType()) {
+        case MatchExpression::ALWAYS_FALSE:
+        case MatchExpression::ALWAYS_TRUE:
+            return 0;
+        case MatchExpression::EQ:
+        case MatchExpression::INTERNAL_EXPR_EQ:
+            return 1;
+        case MatchExpression::LT:
+        case MatchExpression::LTE:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+        case MatchExpression::EXISTS:
+        case MatchExpression::TYPE_OPERATOR:
+        case MatchExpression::MOD:
+        case MatchExpression::BITS_ALL_SET:
+        case MatchExpression::BITS_ALL_CLEAR:
+        case MatchExpression::BITS_ANY_SET:
+        case MatchExpression::BITS_ANY_CLEAR:
+            return 2;
+        case MatchExpression::MATCH_IN:
+        case MatchExpression::SIZE:
+            return 3;
+        case MatchExpression::REGEX:
+            return 4;
+        case MatchExpression::AND:
+        case MatchExpression::OR:
+        case MatchExpression::NOR:
+        case MatchExpression::NOT:
+        case MatchExpression::ELEM_MATCH_OBJECT:
+        case MatchExpression::ELEM_MATCH_VALUE:
+            return 5;
+        default:
+            return 6;
+    }
+}
+
+/**
+ * Returns true if 'expr' can be evaluated by applying matchesSingleElement() to the element found
+ * at its path, whenever that element is not an array.
+ */
+bool isCompilableLeaf(const MatchExpression* expr) {
+    switch (expr->matchType()) {
+        case MatchExpression::WHERE:
+        case MatchExpression::EXPRESSION:
+        case MatchExpression::TEXT:
+        case MatchExpression::GEO:
+        case MatchExpression::GEO_NEAR:
+            return false;
+        default:
+            break;
+    }
+
+    // PathMatchExpression::matches() visits exactly the element returned by
+    // getFieldDottedOrArray() when that element is not an array.
+    return dynamic_cast<const PathMatchExpression*>(expr) && !expr->path().empty();
+}
+
+}  // namespace
+
+class CompiledMatchExpression::Compiler {
+public:
+    explicit Compiler(CompiledMatchExpression* out) : _out(out) {}
+
+    void emit(const MatchExpression* expr) {
+        using Op = Instruction::Op;
+
+        switch (expr->matchType()) {
+            case MatchExpression::AND:
+                _emitList(Op::kAnd, expr);
+                return;
+            case MatchExpression::OR:
+                _emitList(Op::kOr, expr);
+                return;
+            case MatchExpression::NOR:
+                _emitList(Op::kNor, expr);
+                return;
+            case MatchExpression::NOT: {
+                const size_t self = _push(Op::kNot, expr);
+                emit(expr->getChild(0));
+                _out->_program[self].end = _out->_program.size();
+                return;
+            }
+            case MatchExpression::ALWAYS_TRUE:
+                _push(Op::kAlwaysTrue, expr);
+                return;
+            case MatchExpression::ALWAYS_FALSE:
+                _push(Op::kAlwaysFalse, expr);
+                return;
+            default:
+                break;
+        }
+
+        if (isCompilableLeaf(expr)) {
+            const size_t self = _push(Op::kLeaf, expr);
+            _out->_program[self].pathIndex = _pathIndex(expr->path());
+            ++_numLeaves;
+        } else {
+            _push(Op::kTree, expr);
+        }
+    }
+
+    size_t numLeaves() const {
+        return _numLeaves;
+    }
+
+private:
+    size_t _push(Instruction::Op op, const MatchExpression* expr) {
+        Instruction instruction;
+        instruction.op = op;
+        instruction.expr = expr;
+        _out->_program.push_back(instruction);
+        _out->_program.back().end = _out->_program.size();
+        return _out->_program.size() - 1;
+    }
+
+    void _emitList(Instruction::Op op, const MatchExpression* expr) {
+        const size_t self = _push(op, expr);
+
+        // Matching has no side effects, so the children of a logical node may be evaluated in any
+        // order. Sorting by path as well keeps predicates on the same field together.
+        std::vector<const MatchExpression*> children;
+        children.reserve(expr->numChildren());
+        for (size_t i = 0; i < expr->numChildren(); ++i) {
+            children.push_back(expr->getChild(i));
+        }
+        std::stable_sort(children.begin(),
+                         children.end(),
+                         [](const MatchExpression* lhs, const MatchExpression* rhs) {
+                             const int lhsRank = evaluationRank(lhs);
+                             const int rhsRank = evaluationRank(rhs);
+                             if (lhsRank != rhsRank) {
+                                 return lhsRank < rhsRank;
+                             }
+                             return lhs->path() < rhs->path();
+                         });
+
+        for (auto child : children) {
+            emit(child);
+        }
+        _out->_program[self].end = _out->_program.size();
+    }
+
+    size_t _pathIndex(StringData path) {
+        auto& paths = _out->_paths;
+        for (size_t i = 0; i < paths.size(); ++i) {
+            if (paths[i].dottedField() == path) {
+                return i;
+            }
+        }
+        paths.emplace_back(path);
+        return paths.size() - 1;
+    }
+
+    CompiledMatchExpression* _out;
+    size_t _numLeaves = 0;
+};
+
+std::unique_ptr<CompiledMatchExpression> CompiledMatchExpression::compile(
+    const MatchExpression* root) {
+    if (!root) {
+        return nullptr;
+    }
+
+    std::unique_ptr<CompiledMatchExpression> compiled(new CompiledMatchExpression());
+    Compiler compiler(compiled.get());
+    compiler.emit(root);
+    if (compiler.numLeaves() == 0) {
+        return nullptr;
+    }
+    return compiled;
+}
+
+bool CompiledMatchExpression::matchesBSON(const BSONObj& doc) const {
+    // Paths are resolved lazily, so that those only referenced by predicates which are skipped
+    // are never looked up.
+    constexpr size_t kInlinePaths = 16;
+    size_t pc = 0;
+    if (_paths.size() <= kInlinePaths) {
+        BSONElement elements[kInlinePaths];
+        bool resolved[kInlinePaths] = {};
+        return _evaluate(&pc, doc, elements, resolved);
+    }
+
+    std::vector<BSONElement> elements(_paths.size());
+    std::unique_ptr<bool[]> resolved(new bool[_paths.size()]());
+    return _evaluate(&pc, doc, elements.data(), resolved.get());
+}
+
+bool CompiledMatchExpression::_evaluate(size_t* pc,
+                                        const BSONObj& doc,
+                                        BSONElement* elements,
+                                        bool* resolved) const {
+    using Op = Instruction::Op;
+
+    const Instruction& instruction = _program[*pc];
+    ++*pc;
+
+    switch (instruction.op) {
+        case Op::kAnd:
+            while (*pc < instruction.end) {
+                if (!_evaluate(pc, doc, elements, resolved)) {
+                    *pc = instruction.end;
+                    return false;
+                }
+            }
+            return true;
+        case Op::kOr:
+            while (*pc < instruction.end) {
+                if (_evaluate(pc, doc, elements, resolved)) {
+                    *pc = instruction.end;
+                    return true;
+                }
+            }
+            return false;
+        case Op::kNor:
+            while (*pc < instruction.end) {
+                if (_evaluate(pc, doc, elements, resolved)) {
+                    *pc = instruction.end;
+                    return false;
+                }
+            }
+            return true;
+        case Op::kNot:
+            return !_evaluate(pc, doc, elements, resolved);
+        case Op::kAlwaysTrue:
+            return true;
+        case Op::kAlwaysFalse:
+            return false;
+        case Op::kLeaf: {
+            const size_t i = instruction.pathIndex;
+            if (!resolved[i]) {
+                size_t idxPath;
+                elements[i] = getFieldDottedOrArray(doc, _paths[i], &idxPath);
+                resolved[i] = true;
+            }
+
+            // An array along the path may produce several candidate elements; let the tree
+            // traverse it.
+            if (elements[i].type() == BSONType::Array) {
+                return instruction.expr->matchesBSON(doc);
+            }
+            return instruction.expr->matchesSingleElement(elements[i]);
+        }
+        case Op::kTree:
+            return instruction.expr->matchesBSON(doc);
+    }
+
+    MONGO_UNREACHABLE;
+}
+
+}  // namespace monger
@@ -0,0 +1,122 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "monger/bson/bsonobj.h"
+#include "monger/db/field_ref.h"
+
+namespace monger {
+
+class MatchExpression;
+
+/**
+ * A MatchExpression tree lowered into a flat program for evaluating filters against whole
+ * documents.
+ *
+ * Compared with MatchExpression::matchesBSON(), the program
+ *  - resolves each distinct field path at most once per document, and only when a predicate
+ *    on it is reached, instead of once per leaf through an ElementIterator,
+ *  - evaluates the children of $and and $or cheapest and most selective first, keeping
+ *    predicates on the same path next to each other,
+ *  - skips the rest of a $and, $or or $nor as soon as its result is known.
+ *
+ * A leaf whose path runs into an array is evaluated by the tree for that document, since array
+ * traversal may produce several candidate elements. $where, $expr, $text, geo predicates and any
+ * other node without a compiled form are always evaluated by the tree, so the program returns the
+ * same results as the tree it was compiled from.
+ *
+ * The program refers to nodes of the tree, which must outlive it. It is immutable once compiled
+ * and may be evaluated from several threads at once.
+ */
+class CompiledMatchExpression {
+public:
+    /**
+     * Compiles the tree rooted at 'root'. Returns nullptr if 'root' is null, or if the program
+     * would have no compiled leaves and so could only defer to the tree.
+     */
+    static std::unique_ptr<CompiledMatchExpression> compile(const MatchExpression* root);
+
+    /**
+     * Returns true if 'doc' satisfies the filter this program was compiled from.
+     */
+    bool matchesBSON(const BSONObj& doc) const;
+
+    size_t numInstructions() const {
+        return _program.size();
+    }
+
+    size_t numPaths() const {
+        return _paths.size();
+    }
+
+private:
+    struct Instruction {
+        enum class Op {
+            kAnd,
+            kOr,
+            kNor,
+            kNot,
+            kAlwaysTrue,
+            kAlwaysFalse,
+            // A path predicate, evaluated with matchesSingleElement() against the element at
+            // '_paths[pathIndex]'.
+            kLeaf,
+            // Any other node, evaluated with matchesBSON().
+            kTree,
+        };
+
+        Op op;
+
+        // The node this instruction was compiled from.
+        const MatchExpression* expr;
+
+        size_t pathIndex = 0;
+
+        // Index of the first instruction after this instruction and all of its descendants.
+        size_t end = 0;
+    };
+
+    class Compiler;
+
+    CompiledMatchExpression() = default;
+
+    bool _evaluate(size_t* pc, const BSONObj& doc, BSONElement* elements, bool* resolved) const;
+
+    std::vector<Instruction> _program;
+
+    // The distinct field paths referenced by kLeaf instructions.
+    std::vector<FieldRef> _paths;
+};
+
+}  // namespace monger
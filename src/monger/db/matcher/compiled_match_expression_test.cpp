@@ -0,0 +1,157 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "monger/platform/basic.h"
+
+#include "monger/db/matcher/compiled_match_expression.h"
+
+#include "monger/db/json.h"
+#include "monger/db/matcher/expression.h"
+#include "monger/db/matcher/expression_parser.h"
+#include "monger/db/matcher/extensions_callback_noop.h"
+#include "monger/db/pipeline/expression_context_for_test.h"
+#include "monger/unittest/unittest.h"
+#include "monger/util/str.h"
+
+namespace monger {
+namespace {
+
+std::unique_ptr<MatchExpression> parse(const BSONObj& query) {
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    auto result = MatchExpressionParser::parse(query,
+                                               expCtx,
+                                               ExtensionsCallbackNoop(),
+                                               MatchExpressionParser::kAllowAllSpecialFeatures);
+    ASSERT_OK(result.getStatus());
+    return std::move(result.getValue());
+}
+
+const std::vector<BSONObj> kDocuments = {
+    fromjson("{}"),
+    fromjson("{a: 1}"),
+    fromjson("{a: 5, b: 'x'}"),
+    fromjson("{a: null, b: 'y'}"),
+    fromjson("{a: [1, 5, 9], b: 'x'}"),
+    fromjson("{a: [], b: []}"),
+    fromjson("{a: [[1], 2]}"),
+    fromjson("{a: {b: 1, c: [4, 5]}}"),
+    fromjson("{a: {b: 'x', c: 6}}"),
+    fromjson("{a: [{b: 1}, {b: 7}]}"),
+    fromjson("{a: [{b: [1, 2]}, {c: 1}]}"),
+    fromjson("{a: {'0': 3}, b: 2}"),
+    fromjson("{a: 'abc', b: NumberLong(2), c: 2.5}"),
+    fromjson("{a: 3, b: {$numberDecimal: '2'}, c: true}"),
+};
+
+/**
+ * Asserts that the program compiled from 'query' agrees with the tree on every document in
+ * 'kDocuments'.
+ */
+void assertMatchesLikeTree(const BSONObj& query) {
+    auto expr = parse(query);
+    auto compiled = CompiledMatchExpression::compile(expr.get());
+    ASSERT(compiled) << query;
+    for (auto&& doc : kDocuments) {
+        ASSERT_EQ(expr->matchesBSON(doc), compiled->matchesBSON(doc)) << query << " on " << doc;
+    }
+}
+
+TEST(CompiledMatchExpressionTest, ComparisonsMatchLikeTree) {
+    assertMatchesLikeTree(fromjson("{a: 1}"));
+    assertMatchesLikeTree(fromjson("{a: null}"));
+    assertMatchesLikeTree(fromjson("{a: {$gt: 1, $lte: 5}}"));
+    assertMatchesLikeTree(fromjson("{a: {$ne: 5}}"));
+    assertMatchesLikeTree(fromjson("{a: {$in: [1, 'abc', null]}}"));
+    assertMatchesLikeTree(fromjson("{a: {$nin: [1, 5]}}"));
+    assertMatchesLikeTree(fromjson("{a: {$exists: false}}"));
+    assertMatchesLikeTree(fromjson("{a: {$type: 'array'}}"));
+    assertMatchesLikeTree(fromjson("{a: {$regex: '^a'}}"));
+    assertMatchesLikeTree(fromjson("{a: {$size: 0}}"));
+    assertMatchesLikeTree(fromjson("{b: 2}"));
+    assertMatchesLikeTree(fromjson("{c: {$mod: [2, 0]}}"));
+}
+
+TEST(CompiledMatchExpressionTest, DottedPathsMatchLikeTree) {
+    assertMatchesLikeTree(fromjson("{'a.b': 1}"));
+    assertMatchesLikeTree(fromjson("{'a.b': null}"));
+    assertMatchesLikeTree(fromjson("{'a.c': {$gte: 5}}"));
+    assertMatchesLikeTree(fromjson("{'a.0': 3}"));
+    assertMatchesLikeTree(fromjson("{'a.b': {$exists: true}, 'a.c': 6}"));
+    assertMatchesLikeTree(fromjson("{a: {$elemMatch: {b: {$gt: 1}}}}"));
+}
+
+TEST(CompiledMatchExpressionTest, LogicalNodesMatchLikeTree) {
+    assertMatchesLikeTree(fromjson("{$or: [{a: 1}, {b: 'x'}]}"));
+    assertMatchesLikeTree(fromjson("{$nor: [{a: 1}, {b: 'x'}]}"));
+    assertMatchesLikeTree(fromjson("{a: {$not: {$gt: 2}}, b: {$exists: true}}"));
+    assertMatchesLikeTree(
+        fromjson("{$and: [{$or: [{a: 5}, {a: 1}]}, {$or: [{b: 'x'}, {c: true}]}]}"));
+    assertMatchesLikeTree(fromjson("{$alwaysFalse: 1, a: 1}"));
+    assertMatchesLikeTree(fromjson("{$or: [{$alwaysTrue: 1}, {a: 1}]}"));
+}
+
+TEST(CompiledMatchExpressionTest, UncompiledNodesAreEvaluatedByTree) {
+    assertMatchesLikeTree(fromjson("{a: {$gte: 1}, $expr: {$eq: ['$b', 'x']}}"));
+    assertMatchesLikeTree(fromjson("{$or: [{a: 1}, {$expr: {$gt: ['$c', 2]}}]}"));
+}
+
+TEST(CompiledMatchExpressionTest, DoesNotCompileWithoutCompilableLeaves) {
+    ASSERT_FALSE(CompiledMatchExpression::compile(nullptr));
+
+    auto expr = parse(fromjson("{$expr: {$eq: ['$a', 1]}}"));
+    ASSERT_FALSE(CompiledMatchExpression::compile(expr.get()));
+}
+
+TEST(CompiledMatchExpressionTest, ResolvesEachPathOnce) {
+    auto expr = parse(fromjson("{a: {$gt: 1, $lt: 9}, 'b.c': 1, $or: [{a: 5}, {'b.c': 2}]}"));
+    auto compiled = CompiledMatchExpression::compile(expr.get());
+    ASSERT(compiled);
+    ASSERT_EQ(2U, compiled->numPaths());
+}
+
+TEST(CompiledMatchExpressionTest, ManyPathsMatchLikeTree) {
+    BSONObjBuilder query;
+    BSONObjBuilder doc;
+    for (int i = 0; i < 40; ++i) {
+        query.append(str::stream() << "f" << i, i);
+        doc.append(str::stream() << "f" << i, i);
+    }
+    auto expr = parse(query.obj());
+    auto compiled = CompiledMatchExpression::compile(expr.get());
+    ASSERT(compiled);
+    ASSERT_EQ(40U, compiled->numPaths());
+
+    BSONObj matching = doc.obj();
+    ASSERT_TRUE(compiled->matchesBSON(matching));
+    ASSERT_FALSE(compiled->matchesBSON(matching.removeField("f39")));
+}
+
+}  // namespace
+}  // namespace monger
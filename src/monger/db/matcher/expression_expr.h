@@ -34,6 +34,7 @@
 #include "monger/db/matcher/expression.h"
 #include "monger/db/matcher/expression_tree.h"
 #include "monger/db/matcher/rewrite_expr.h"
+#include "monger/db/pipeline/compiled_expression.h"
 #include "monger/db/pipeline/expression.h"
 #include "monger/db/pipeline/expression_context.h"
 
@@ -106,6 +107,10 @@ private:
 
     boost::intrusive_ptr<Expression> _expression;
 
+    // The compiled form of '_expression', built once it has been optimized. Null if '_expression'
+    // is evaluated directly.
+    std::unique_ptr<CompiledExpression> _compiledExpression;
+
     boost::optional<RewriteExpr::RewriteResult> _rewriteResult;
 };
 
@@ -376,6 +376,9 @@ std::unique_ptr<MatchExpression> InMatchExpression::shallowClone() const {
     next->_hasEmptyArray = _hasEmptyArray;
     next->_equalitySet = _equalitySet;
     next->_originalEqualityVector = _originalEqualityVector;
+    next->_packedKind = _packedKind;
+    next->_packedIntegers = _packedIntegers;
+    next->_packedObjectIds = _packedObjectIds;
     for (auto&& regex : _regexes) {
         std::unique_ptr<RegexMatchExpression> clonedRegex(
             static_cast<RegexMatchExpression*>(regex->shallowClone().release()));
@@ -384,10 +387,74 @@ std::unique_ptr<MatchExpression> InMatchExpression::shallowClone() const {
     return std::move(next);
 }
 
+namespace {
+
+/**
+ * Returns true if the sorted range 'values' contains 'key'. The search does not branch on the
+ * outcome of each comparison, which lets the compiler use conditional moves and keeps the CPU from
+ * mispredicting half of the probes into a large array.
+ */
+template <typename T>
+bool packedContains(const std::vector<T>& values, const T& key) {
+    if (values.empty()) {
+        return false;
+    }
+
+    const T* base = values.data();
+    size_t n = values.size();
+    while (n > 1) {
+        const size_t half = n / 2;
+        base = (base[half] < key) ? base + half : base;
+        n -= half;
+    }
+    base += (*base < key);
+    return base != values.data() + values.size() && *base == key;
+}
+
+}  // namespace
+
 bool InMatchExpression::contains(const BSONElement& e) const {
+    switch (_packedKind) {
+        case PackedKind::kIntegral:
+            return _containsIntegral(e);
+        case PackedKind::kObjectId:
+            return e.type() == BSONType::jstOID && packedContains(_packedObjectIds, e.__oid());
+        case PackedKind::kNone:
+            break;
+    }
     return std::binary_search(_equalitySet.begin(), _equalitySet.end(), e, _eltCmp.makeLessThan());
 }
 
+bool InMatchExpression::_containsIntegral(const BSONElement& e) const {
+    long long value;
+    switch (e.type()) {
+        case BSONType::NumberInt:
+            value = e._numberInt();
+            break;
+        case BSONType::NumberLong:
+            value = e._numberLong();
+            break;
+        case BSONType::NumberDouble: {
+            // Only a double holding an integral value in the range of a long long can equal one of
+            // the equalities. This also rejects NaN.
+            const double d = e._numberDouble();
+            if (!(d >= -9223372036854775808.0 && d < 9223372036854775808.0) ||
+                d != std::trunc(d)) {
+                return false;
+            }
+            value = static_cast<long long>(d);
+            break;
+        }
+        case BSONType::NumberDecimal:
+            return std::binary_search(
+                _equalitySet.begin(), _equalitySet.end(), e, _eltCmp.makeLessThan());
+        default:
+            // No other type compares equal to a number.
+            return false;
+    }
+    return packedContains(_packedIntegers, value);
+}
+
 bool InMatchExpression::matchesSingleElement(const BSONElement& e, MatchDetails* details) const {
     if (_hasNull && e.eoo()) {
         return true;
@@ -482,6 +549,11 @@ void InMatchExpression::_doSetCollator(const CollatorInterface* collator) {
     _collator = collator;
     _eltCmp = BSONElementComparator(BSONElementComparator::FieldNamesMode::kIgnore, _collator);
 
+    // We need to re-compute '_equalitySet', since our set comparator has changed.
+    _buildEqualitySet();
+}
+
+void InMatchExpression::_buildEqualitySet() {
     if (!std::is_sorted(_originalEqualityVector.begin(),
                         _originalEqualityVector.end(),
                         _eltCmp.makeLessThan())) {
@@ -489,13 +561,42 @@ void InMatchExpression::_doSetCollator(const CollatorInterface* collator) {
             _originalEqualityVector.begin(), _originalEqualityVector.end(), _eltCmp.makeLessThan());
     }
 
-    // We need to re-compute '_equalitySet', since our set comparator has changed.
     _equalitySet.clear();
     _equalitySet.reserve(_originalEqualityVector.size());
     std::unique_copy(_originalEqualityVector.begin(),
                      _originalEqualityVector.end(),
                      std::back_inserter(_equalitySet),
                      _eltCmp.makeEqualTo());
+
+    const auto isIntegral = [](const BSONElement& elem) {
+        return elem.type() == BSONType::NumberInt || elem.type() == BSONType::NumberLong;
+    };
+    const auto isObjectId = [](const BSONElement& elem) {
+        return elem.type() == BSONType::jstOID;
+    };
+
+    _packedKind = PackedKind::kNone;
+    _packedIntegers.clear();
+    _packedObjectIds.clear();
+    if (_equalitySet.empty()) {
+        return;
+    }
+
+    // '_equalitySet' is sorted and deduplicated, and for integers and ObjectIds that order agrees
+    // with the natural order of the packed values.
+    if (std::all_of(_equalitySet.begin(), _equalitySet.end(), isIntegral)) {
+        _packedKind = PackedKind::kIntegral;
+        _packedIntegers.reserve(_equalitySet.size());
+        for (auto&& equality : _equalitySet) {
+            _packedIntegers.push_back(equality.numberLong());
+        }
+    } else if (std::all_of(_equalitySet.begin(), _equalitySet.end(), isObjectId)) {
+        _packedKind = PackedKind::kObjectId;
+        _packedObjectIds.reserve(_equalitySet.size());
+        for (auto&& equality : _equalitySet) {
+            _packedObjectIds.push_back(equality.__oid());
+        }
+    }
 }
 
 Status InMatchExpression::setEqualities(std::vector<BSONElement> equalities) {
@@ -515,20 +616,7 @@ Status InMatchExpression::setEqualities(std::vector<BSONElement> equalities) {
     }
 
     _originalEqualityVector = std::move(equalities);
-
-    if (!std::is_sorted(_originalEqualityVector.begin(),
-                        _originalEqualityVector.end(),
-                        _eltCmp.makeLessThan())) {
-        std::sort(
-            _originalEqualityVector.begin(), _originalEqualityVector.end(), _eltCmp.makeLessThan());
-    }
-
-    _equalitySet.clear();
-    _equalitySet.reserve(_originalEqualityVector.size());
-    std::unique_copy(_originalEqualityVector.begin(),
-                     _originalEqualityVector.end(),
-                     std::back_inserter(_equalitySet),
-                     _eltCmp.makeEqualTo());
+    _buildEqualitySet();
 
     return Status::OK();
 }
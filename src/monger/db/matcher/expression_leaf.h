@@ -449,9 +449,28 @@ public:
         return _hasEmptyArray;
     }
 
+    /**
+     * Returns true if the equalities are all integers (NumberInt or NumberLong) or are all
+     * ObjectIds. Such values compare the same under any collation, and contains() probes a packed
+     * array of them rather than comparing BSONElements.
+     */
+    bool hasPackedEqualities() const {
+        return _packedKind != PackedKind::kNone;
+    }
+
 private:
+    enum class PackedKind { kNone, kIntegral, kObjectId };
+
     ExpressionOptimizerFunc getOptimizer() const final;
 
+    /**
+     * Rebuilds '_equalitySet' from '_originalEqualityVector' using the current comparator, along
+     * with its packed form.
+     */
+    void _buildEqualitySet();
+
+    bool _containsIntegral(const BSONElement& e) const;
+
     // Whether or not '_equalities' has a jstNULL element in it.
     bool _hasNull = false;
 
@@ -479,6 +498,13 @@ private:
     // called "many" times.
     std::vector<BSONElement> _equalitySet;
 
+    // When every element of '_equalitySet' is an integer, or every element is an ObjectId, the
+    // same values in the same order as a packed array. Searching these avoids the type dispatch
+    // and indirection of comparing BSONElements, which dominates large $in lists.
+    PackedKind _packedKind = PackedKind::kNone;
+    std::vector<long long> _packedIntegers;
+    std::vector<OID> _packedObjectIds;
+
     // Container of regex elements this object owns.
     std::vector<std::unique_ptr<RegexMatchExpression>> _regexes;
 };
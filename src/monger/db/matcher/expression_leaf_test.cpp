@@ -31,6 +31,9 @@
 
 #include "monger/unittest/unittest.h"
 
+#include <cmath>
+#include <limits>
+
 #include "monger/db/jsobj.h"
 #include "monger/db/json.h"
 #include "monger/db/matcher/expression.h"
@@ -1370,6 +1373,72 @@ TEST(InMatchExpression, ChangingCollationAfterAddingEqualitiesPreservesEqualitie
     ASSERT(in.contains(obj2.firstElement()));
 }
 
+TEST(InMatchExpression, IntegerEqualitiesMatchAnyNumericTypeWithEqualValue) {
+    BSONArray operand = BSON_ARRAY(1 << 7LL << -3 << std::numeric_limits<long long>::max());
+    InMatchExpression in("");
+    std::vector<BSONElement> equalities(operand.begin(), operand.end());
+    ASSERT_OK(in.setEqualities(std::move(equalities)));
+    ASSERT(in.hasPackedEqualities());
+
+    ASSERT(in.matchesSingleElement(BSON("a" << 7)["a"]));
+    ASSERT(in.matchesSingleElement(BSON("a" << 1LL)["a"]));
+    ASSERT(in.matchesSingleElement(BSON("a" << -3.0)["a"]));
+    ASSERT(in.matchesSingleElement(BSON("a" << Decimal128("7.0"))["a"]));
+    ASSERT(in.matchesSingleElement(BSON("a" << std::numeric_limits<long long>::max())["a"]));
+
+    ASSERT(!in.matchesSingleElement(BSON("a" << 2)["a"]));
+    ASSERT(!in.matchesSingleElement(BSON("a" << 1.5)["a"]));
+    ASSERT(!in.matchesSingleElement(BSON("a" << std::nan(""))["a"]));
+    ASSERT(!in.matchesSingleElement(BSON("a" << 9223372036854775808.0)["a"]));
+    ASSERT(!in.matchesSingleElement(BSON("a" << Decimal128("2"))["a"]));
+    ASSERT(!in.matchesSingleElement(BSON("a"
+                                         << "7")["a"]));
+    ASSERT(!in.matchesSingleElement(BSON("a" << true)["a"]));
+}
+
+TEST(InMatchExpression, ObjectIdEqualitiesMatchOnlyObjectIds) {
+    std::vector<OID> oids;
+    BSONArrayBuilder operand;
+    for (int i = 0; i < 1000; ++i) {
+        oids.push_back(OID::gen());
+        operand.append(oids.back());
+    }
+    BSONArray operandArray = operand.arr();
+    InMatchExpression in("");
+    std::vector<BSONElement> equalities(operandArray.begin(), operandArray.end());
+    ASSERT_OK(in.setEqualities(std::move(equalities)));
+    ASSERT(in.hasPackedEqualities());
+
+    for (auto&& oid : oids) {
+        ASSERT(in.matchesSingleElement(BSON("a" << oid)["a"]));
+    }
+    ASSERT(!in.matchesSingleElement(BSON("a" << OID())["a"]));
+    ASSERT(!in.matchesSingleElement(BSON("a" << OID::max())["a"]));
+    ASSERT(!in.matchesSingleElement(BSON("a" << oids.front().toString())["a"]));
+}
+
+TEST(InMatchExpression, MixedEqualitiesAreNotPacked) {
+    BSONArray operand = BSON_ARRAY(1 << 2.5 << OID());
+    InMatchExpression in("");
+    std::vector<BSONElement> equalities(operand.begin(), operand.end());
+    ASSERT_OK(in.setEqualities(std::move(equalities)));
+    ASSERT(!in.hasPackedEqualities());
+    ASSERT(in.matchesSingleElement(BSON("a" << 2.5)["a"]));
+    ASSERT(in.matchesSingleElement(BSON("a" << 1LL)["a"]));
+    ASSERT(in.matchesSingleElement(BSON("a" << OID())["a"]));
+}
+
+TEST(InMatchExpression, PackedEqualitiesSurviveShallowClone) {
+    BSONArray operand = BSON_ARRAY(3 << 1 << 2);
+    InMatchExpression in("a");
+    std::vector<BSONElement> equalities(operand.begin(), operand.end());
+    ASSERT_OK(in.setEqualities(std::move(equalities)));
+    auto clone = in.shallowClone();
+    ASSERT(static_cast<InMatchExpression*>(clone.get())->hasPackedEqualities());
+    ASSERT(clone->matchesBSON(BSON("a" << 2)));
+    ASSERT(!clone->matchesBSON(BSON("a" << 4)));
+}
+
 std::vector<uint32_t> bsonArrayToBitPositions(const BSONArray& ba) {
     std::vector<uint32_t> bitPositions;
 
@@ -49,6 +49,7 @@ constexpr StringData NamespaceString::kAdminDb;
 constexpr StringData NamespaceString::kLocalDb;
 constexpr StringData NamespaceString::kConfigDb;
 constexpr StringData NamespaceString::kSystemDotViewsCollectionName;
+constexpr StringData NamespaceString::kSystemDotMaterializedPrefix;
 constexpr StringData NamespaceString::kOrphanCollectionPrefix;
 constexpr StringData NamespaceString::kOrphanCollectionDb;
 
@@ -115,6 +116,9 @@ bool NamespaceString::isLegalClientSystemNS() const {
     if (coll() == kSystemDotViewsCollectionName)
         return true;
 
+    if (isMaterializedViewBackingCollection())
+        return true;
+
     return false;
 }
 
@@ -61,6 +61,9 @@ public:
     // Name for the system views collection
     static constexpr StringData kSystemDotViewsCollectionName = "system.views"_sd;
 
+    // Prefix for the collections storing the results of materialized views
+    static constexpr StringData kSystemDotMaterializedPrefix = "system.materialized."_sd;
+
     // Prefix for orphan collections
     static constexpr StringData kOrphanCollectionPrefix = "orphan."_sd;
     static constexpr StringData kOrphanCollectionDb = "local"_sd;
@@ -215,6 +218,9 @@ public:
     bool isSystemDotViews() const {
         return coll() == kSystemDotViewsCollectionName;
     }
+    bool isMaterializedViewBackingCollection() const {
+        return coll().startsWith(kSystemDotMaterializedPrefix);
+    }
     bool isServerConfigurationCollection() const {
         return (db() == kAdminDb) && (coll() == "system.version");
     }
@@ -290,6 +290,10 @@ public:
     static boost::intrusive_ptr<Accumulator> create(
         const boost::intrusive_ptr<ExpressionContext>& expCtx);
 
+    bool isCommutative() const final {
+        return true;
+    }
+
 private:
     /**
      * The total of all values is partitioned between those that are decimals, and those that are
@@ -313,6 +317,10 @@ public:
     const char* getOpName() const final;
     void reset() final;
 
+    bool isCommutative() const final {
+        return true;
+    }
+
 private:
     const bool _isSamp;
     long long _count;
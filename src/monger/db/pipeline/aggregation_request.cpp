@@ -60,8 +60,10 @@ constexpr StringData AggregationRequest::kAllowDiskUseName;
 constexpr StringData AggregationRequest::kHintName;
 constexpr StringData AggregationRequest::kCommentName;
 constexpr StringData AggregationRequest::kExchangeName;
+constexpr StringData AggregationRequest::kParallelismName;
 
 constexpr long long AggregationRequest::kDefaultBatchSize;
+constexpr int AggregationRequest::kMaxParallelism;
 
 StatusWith<AggregationRequest> AggregationRequest::parseFromBSON(
     const std::string& dbName,
@@ -200,6 +202,23 @@ StatusWith<AggregationRequest> AggregationRequest::parseFromBSON(
             } catch (const DBException& ex) {
                 return ex.toStatus();
             }
+        } else if (kParallelismName == fieldName) {
+            if (!elem.isNumber()) {
+                return {ErrorCodes::TypeMismatch,
+                        str::stream() << kParallelismName << " must be a number, not a "
+                                      << typeName(elem.type())};
+            }
+
+            auto parallelism = elem.numberLong();
+            if (parallelism < 1 || parallelism > kMaxParallelism ||
+                elem.numberDouble() != static_cast<double>(parallelism)) {
+                return {ErrorCodes::BadValue,
+                        str::stream() << kParallelismName << " must be an integer between 1 and "
+                                      << kMaxParallelism
+                                      << ", not "
+                                      << elem.toString(false)};
+            }
+            request.setParallelism(static_cast<int>(parallelism));
         } else if (bypassDocumentValidationCommandOption() == fieldName) {
             request.setBypassDocumentValidation(elem.trueValue());
         } else if (WriteConcernOptions::kWriteConcernField == fieldName) {
@@ -324,6 +343,8 @@ Document AggregationRequest::serializeToCommandObj() const {
         {QueryRequest::cmdOptionMaxTimeMS,
          _maxTimeMS == 0 ? Value() : Value(static_cast<int>(_maxTimeMS))},
         {kExchangeName, _exchangeSpec ? Value(_exchangeSpec->toBSON()) : Value()},
+        // Only serialize parallelism if more than one thread was requested.
+        {kParallelismName, _parallelism > 1 ? Value(_parallelism) : Value()},
         {WriteConcernOptions::kWriteConcernField,
          _writeConcern ? Value(_writeConcern->toBSON()) : Value()},
         // Only serialize runtime constants if any were specified.
@@ -63,9 +63,11 @@ public:
     static constexpr StringData kHintName = "hint"_sd;
     static constexpr StringData kCommentName = "comment"_sd;
     static constexpr StringData kExchangeName = "exchange"_sd;
+    static constexpr StringData kParallelismName = "parallelism"_sd;
     static constexpr StringData kRuntimeConstants = "runtimeConstants"_sd;
 
     static constexpr long long kDefaultBatchSize = 101;
+    static constexpr int kMaxParallelism = 100;
 
     /**
      * Parse an aggregation pipeline definition from 'pipelineElem'. Returns a non-OK status if
@@ -213,6 +215,14 @@ public:
         return _exchangeSpec;
     }
 
+    /**
+     * Returns the number of threads which may be used to execute the pipeline on a mongerD, or 1
+     * if no parallelism was requested.
+     */
+    int getParallelism() const {
+        return _parallelism;
+    }
+
     boost::optional<WriteConcernOptions> getWriteConcern() const {
         return _writeConcern;
     }
@@ -281,6 +291,10 @@ public:
         _exchangeSpec = std::move(spec);
     }
 
+    void setParallelism(int parallelism) {
+        _parallelism = parallelism;
+    }
+
     void setWriteConcern(WriteConcernOptions writeConcern) {
         _writeConcern = writeConcern;
     }
@@ -335,6 +349,10 @@ private:
     // This is an internal option; we do not expect it to be set on requests from users or drivers.
     boost::optional<ExchangeSpec> _exchangeSpec;
 
+    // The number of threads the user allows the pipeline to run on. Pipelines which cannot be
+    // parallelized run on a single thread regardless.
+    int _parallelism = 1;
+
     // The explicit writeConcern for the operation or boost::none if the user did not specifiy one.
     boost::optional<WriteConcernOptions> _writeConcern;
 
@@ -61,7 +61,7 @@ TEST(AggregationRequestTest, ShouldParseAllKnownOptions) {
         "needsMerge: true, bypassDocumentValidation: true, collation: {locale: 'en_US'}, cursor: "
         "{batchSize: 10}, hint: {a: 1}, maxTimeMS: 100, readConcern: {level: 'linearizable'}, "
         "$queryOptions: {$readPreference: 'nearest'}, comment: 'agg_comment', exchange: {policy: "
-        "'roundrobin', consumers:NumberInt(2)}}");
+        "'roundrobin', consumers:NumberInt(2)}, parallelism: 4}");
     auto request = unittest::assertGet(AggregationRequest::parseFromBSON(nss, inputBson));
     ASSERT_FALSE(request.getExplain());
     ASSERT_TRUE(request.shouldAllowDiskUse());
@@ -82,6 +82,7 @@ TEST(AggregationRequestTest, ShouldParseAllKnownOptions) {
                       BSON("$readPreference"
                            << "nearest"));
     ASSERT_TRUE(request.getExchangeSpec().is_initialized());
+    ASSERT_EQ(request.getParallelism(), 4);
 }
 
 TEST(AggregationRequestTest, ShouldParseExplicitExplainTrue) {
@@ -161,6 +162,7 @@ TEST(AggregationRequestTest, ShouldNotSerializeOptionalValuesIfEquivalentToDefau
     request.setMaxTimeMS(0u);
     request.setUnwrappedReadPref(BSONObj());
     request.setReadConcern(BSONObj());
+    request.setParallelism(1);
 
     auto expectedSerialization =
         Document{{AggregationRequest::kCommandName, nss.coll()},
@@ -191,6 +193,7 @@ TEST(AggregationRequestTest, ShouldSerializeOptionalValuesIfSet) {
     const auto readConcernObj = BSON("level"
                                      << "linearizable");
     request.setReadConcern(readConcernObj);
+    request.setParallelism(8);
 
     auto expectedSerialization =
         Document{{AggregationRequest::kCommandName, nss.coll()},
@@ -206,7 +209,8 @@ TEST(AggregationRequestTest, ShouldSerializeOptionalValuesIfSet) {
                  {AggregationRequest::kCommentName, comment},
                  {repl::ReadConcernArgs::kReadConcernFieldName, readConcernObj},
                  {QueryRequest::kUnwrappedReadPrefField, readPrefObj},
-                 {QueryRequest::cmdOptionMaxTimeMS, 10}};
+                 {QueryRequest::cmdOptionMaxTimeMS, 10},
+                 {AggregationRequest::kParallelismName, 8}};
     ASSERT_DOCUMENT_EQ(request.serializeToCommandObj(), expectedSerialization);
 }
 
@@ -495,6 +499,23 @@ TEST(AggregationRequestTest, ShouldRejectExchangeInvalidSpec) {
     ASSERT_NOT_OK(AggregationRequest::parseFromBSON(nss, inputBson).getStatus());
 }
 
+TEST(AggregationRequestTest, ShouldRejectNonNumericParallelism) {
+    NamespaceString nss("a.collection");
+    const BSONObj inputBson = fromjson("{pipeline: [], cursor: {}, parallelism: '4'}");
+    ASSERT_EQ(AggregationRequest::parseFromBSON(nss, inputBson).getStatus(),
+              ErrorCodes::TypeMismatch);
+}
+
+TEST(AggregationRequestTest, ShouldRejectOutOfRangeOrFractionalParallelism) {
+    NamespaceString nss("a.collection");
+    for (auto&& parallelism : {"0", "-1", "101", "2.5"}) {
+        const BSONObj inputBson = fromjson(std::string("{pipeline: [], cursor: {}, parallelism: ") +
+                                           parallelism + "}");
+        ASSERT_EQ(AggregationRequest::parseFromBSON(nss, inputBson).getStatus(),
+                  ErrorCodes::BadValue);
+    }
+}
+
 TEST(AggregationRequestTest, ShouldRejectInvalidWriteConcern) {
     NamespaceString nss("a.collection");
     const BSONObj inputBson =
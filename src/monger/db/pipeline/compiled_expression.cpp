@@ -0,0 +1,588 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "monger/platform/basic.h"
+
+#include "monger/db/pipeline/compiled_expression.h"
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <type_traits>
+
+#include "monger/db/pipeline/expression_context.h"
+#include "monger/db/query/query_knobs_gen.h"
+#include "monger/platform/decimal128.h"
+#include "monger/platform/overflow_arithmetic.h"
+#include "monger/util/scopeguard.h"
+#include "monger/util/summation.h"
+
+namespace monger {
+
+namespace {
+
+bool isNumber(const Value& val) {
+    switch (val.getType()) {
+        case NumberInt:
+        case NumberLong:
+        case NumberDouble:
+        case NumberDecimal:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * ExpressionMultiply::evaluate() converts every non-decimal operand to a long as it goes, which
+ * fails for doubles outside the range of a long. Such operands are left to the tree evaluator so
+ * that the error is raised before any later operand is evaluated.
+ */
+bool isFactor(const Value& val) {
+    if (val.getType() != NumberDouble)
+        return isNumber(val);
+
+    double d = val.getDouble();
+    return d >= std::numeric_limits<long long>::min() &&
+        d < BSONElement::kLongLongMaxPlusOneAsDouble;
+}
+
+bool isIntegral(BSONType type) {
+    return type == NumberInt || type == NumberLong;
+}
+
+Value cmpResult(ExpressionCompare::CmpOp cmpOp, int cmp) {
+    switch (cmpOp) {
+        case ExpressionCompare::EQ:
+            return Value(cmp == 0);
+        case ExpressionCompare::NE:
+            return Value(cmp != 0);
+        case ExpressionCompare::GT:
+            return Value(cmp > 0);
+        case ExpressionCompare::GTE:
+            return Value(cmp >= 0);
+        case ExpressionCompare::LT:
+            return Value(cmp < 0);
+        case ExpressionCompare::LTE:
+            return Value(cmp <= 0);
+        case ExpressionCompare::CMP:
+            return Value(cmp);
+    }
+    MONGO_UNREACHABLE;
+}
+
+template <typename T>
+int threeWayCompare(T lhs, T rhs) {
+    return lhs < rhs ? -1 : (lhs > rhs ? 1 : 0);
+}
+
+/**
+ * Compares operands of the same integral type, or non-NaN doubles, without going through the
+ * ValueComparator. Returns false if the operands need the general comparison.
+ */
+bool tryFastCompare(const Value& lhs, const Value& rhs, int* cmp) {
+    if (lhs.getType() != rhs.getType())
+        return false;
+
+    switch (lhs.getType()) {
+        case NumberInt:
+            *cmp = threeWayCompare(lhs.getInt(), rhs.getInt());
+            return true;
+        case NumberLong:
+            *cmp = threeWayCompare(lhs.getLong(), rhs.getLong());
+            return true;
+        case NumberDouble: {
+            double l = lhs.getDouble();
+            double r = rhs.getDouble();
+            if (std::isnan(l) || std::isnan(r))
+                return false;
+            *cmp = threeWayCompare(l, r);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+/**
+ * Sums 'n' numeric operands exactly as ExpressionAdd::evaluate() does when none of its operands
+ * is a date or nullish. 'getOperand(i)' returns the i'th operand.
+ */
+template <typename GetOperand>
+Value addNumbers(size_t n, const GetOperand& getOperand) {
+    DoubleDoubleSummation nonDecimalTotal;
+    Decimal128 decimalTotal;
+    BSONType totalType = NumberInt;
+
+    for (size_t i = 0; i < n; ++i) {
+        const Value& val = getOperand(i);
+        switch (val.getType()) {
+            case NumberDecimal:
+                decimalTotal = decimalTotal.add(val.getDecimal());
+                totalType = NumberDecimal;
+                break;
+            case NumberDouble:
+                nonDecimalTotal.addDouble(val.getDouble());
+                if (totalType != NumberDecimal)
+                    totalType = NumberDouble;
+                break;
+            case NumberLong:
+                nonDecimalTotal.addLong(val.getLong());
+                if (totalType == NumberInt)
+                    totalType = NumberLong;
+                break;
+            case NumberInt:
+                nonDecimalTotal.addDouble(val.getInt());
+                break;
+            default:
+                MONGO_UNREACHABLE;
+        }
+    }
+
+    switch (totalType) {
+        case NumberDecimal:
+            return Value(decimalTotal.add(nonDecimalTotal.getDecimal()));
+        case NumberLong:
+            if (nonDecimalTotal.fitsLong())
+                return Value(nonDecimalTotal.getLong());
+        // Fallthrough.
+        case NumberInt:
+            if (nonDecimalTotal.fitsLong())
+                return Value::createIntOrLong(nonDecimalTotal.getLong());
+        // Fallthrough.
+        default:
+            return Value(nonDecimalTotal.getDouble());
+    }
+}
+
+/**
+ * Multiplies 'n' operands exactly as ExpressionMultiply::evaluate() does when each of them
+ * satisfies isFactor(). 'getOperand(i)' returns the i'th operand.
+ */
+template <typename GetOperand>
+Value multiplyNumbers(size_t n, const GetOperand& getOperand) {
+    double doubleProduct = 1;
+    long long longProduct = 1;
+    Decimal128 decimalProduct;
+    BSONType productType = NumberInt;
+
+    for (size_t i = 0; i < n; ++i) {
+        const Value& val = getOperand(i);
+        BSONType oldProductType = productType;
+        productType = Value::getWidestNumeric(productType, val.getType());
+        if (productType == NumberDecimal) {
+            if (oldProductType != NumberDecimal) {
+                decimalProduct = oldProductType == NumberDouble
+                    ? Decimal128(doubleProduct, Decimal128::kRoundTo15Digits)
+                    : Decimal128(static_cast<int64_t>(longProduct));
+            }
+            decimalProduct = decimalProduct.multiply(val.coerceToDecimal());
+        } else {
+            doubleProduct *= val.coerceToDouble();
+            if (mongerSignedMultiplyOverflow64(longProduct, val.coerceToLong(), &longProduct)) {
+                productType = NumberDouble;
+            }
+        }
+    }
+
+    switch (productType) {
+        case NumberDouble:
+            return Value(doubleProduct);
+        case NumberLong:
+            return Value(longProduct);
+        case NumberInt:
+            return Value::createIntOrLong(longProduct);
+        default:
+            return Value(decimalProduct);
+    }
+}
+
+Value subtract(const Value& lhs, const Value& rhs) {
+    if (lhs.getType() == NumberInt && rhs.getType() == NumberInt) {
+        return Value::createIntOrLong(static_cast<long long>(lhs.getInt()) - rhs.getInt());
+    }
+    if (lhs.getType() == NumberDouble && rhs.getType() == NumberDouble) {
+        return Value(lhs.getDouble() - rhs.getDouble());
+    }
+    return ExpressionSubtract::apply(lhs, rhs);
+}
+
+Value divide(const Value& lhs, const Value& rhs) {
+    auto isNonDecimal = [](BSONType type) { return isIntegral(type) || type == NumberDouble; };
+    if (isNonDecimal(lhs.getType()) && isNonDecimal(rhs.getType())) {
+        double denom = rhs.coerceToDouble();
+        if (denom != 0.0) {
+            return Value(lhs.coerceToDouble() / denom);
+        }
+    }
+    return ExpressionDivide::apply(lhs, rhs);
+}
+
+}  // namespace
+
+std::unique_ptr<CompiledExpression> CompiledExpression::compile(
+    boost::intrusive_ptr<Expression> expr) {
+    if (!expr || !internalQueryCompileAggregationExpressions.load())
+        return nullptr;
+
+    auto compiled = forceCompile(std::move(expr));
+    if (compiled->_code.size() == 1 && compiled->_code[0].op == OpCode::kEvaluate)
+        return nullptr;
+    return compiled;
+}
+
+std::unique_ptr<CompiledExpression> CompiledExpression::forceCompile(
+    boost::intrusive_ptr<Expression> expr) {
+    invariant(expr);
+    std::unique_ptr<CompiledExpression> compiled(new CompiledExpression(std::move(expr)));
+    uint32_t resultRegister = compiled->allocateRegister();
+    compiled->compileNode(compiled->_root.get(), resultRegister);
+    return compiled;
+}
+
+uint32_t CompiledExpression::compileOperand(const Expression* expr) {
+    if (auto constant = dynamic_cast<const ExpressionConstant*>(expr)) {
+        _constants.push_back(constant->getValue());
+        return static_cast<uint32_t>(_constants.size() - 1) | kConstantOperand;
+    }
+
+    uint32_t reg = allocateRegister();
+    compileNode(expr, reg);
+    return reg;
+}
+
+void CompiledExpression::compileNode(const Expression* expr, uint32_t dst) {
+    if (dynamic_cast<const ExpressionConstant*>(expr)) {
+        emit({OpCode::kLoadConstant, dst, compileOperand(expr)});
+        return;
+    }
+
+    if (auto fieldPath = dynamic_cast<const ExpressionFieldPath*>(expr)) {
+        Instruction instruction{OpCode::kEvaluate, dst};
+        instruction.expr = expr;
+        // A single-level path off of ROOT is just a lookup in the input document.
+        if (fieldPath->isRootFieldPath() && fieldPath->getFieldPath().getPathLength() == 2) {
+            instruction.op = OpCode::kLoadRootField;
+            instruction.fieldName = fieldPath->getFieldPath().getFieldName(1);
+        }
+        emit(std::move(instruction));
+        return;
+    }
+
+    // Registers holding operands are free again once the instruction using them is emitted.
+    const uint32_t firstTemporary = _nextRegister;
+    ON_BLOCK_EXIT([&] { _nextRegister = firstTemporary; });
+
+    if (auto compare = dynamic_cast<const ExpressionCompare*>(expr)) {
+        const auto& children = expr->getChildren();
+        uint32_t lhs = compileOperand(children[0].get());
+        uint32_t rhs = compileOperand(children[1].get());
+
+        Instruction instruction{OpCode::kCompare, dst, lhs, rhs};
+        instruction.cmpOp = compare->getOp();
+        instruction.expr = expr;
+        emit(std::move(instruction));
+        return;
+    }
+
+    if (dynamic_cast<const ExpressionCond*>(expr)) {
+        const auto& children = expr->getChildren();
+        uint32_t condition = compileOperand(children[0].get());
+        size_t jumpToElse = emit({OpCode::kJumpIfFalse, 0, condition});
+        _nextRegister = firstTemporary;
+        compileNode(children[1].get(), dst);
+        size_t jumpToEnd = emit({OpCode::kJump});
+        patchJumpToHere(jumpToElse);
+        compileNode(children[2].get(), dst);
+        patchJumpToHere(jumpToEnd);
+        return;
+    }
+
+    if (dynamic_cast<const ExpressionAnd*>(expr)) {
+        compileAndOr(expr, dst, true);
+        return;
+    }
+
+    if (dynamic_cast<const ExpressionOr*>(expr)) {
+        compileAndOr(expr, dst, false);
+        return;
+    }
+
+    if (dynamic_cast<const ExpressionNot*>(expr) ||
+        dynamic_cast<const ExpressionCoerceToBool*>(expr)) {
+        uint32_t operand = compileOperand(expr->getChildren()[0].get());
+        emit({dynamic_cast<const ExpressionNot*>(expr) ? OpCode::kNot : OpCode::kCoerceToBool,
+              dst,
+              operand});
+        return;
+    }
+
+    if (dynamic_cast<const ExpressionAdd*>(expr)) {
+        compileArithmetic(expr, dst, OpCode::kAdd);
+        return;
+    }
+
+    if (dynamic_cast<const ExpressionMultiply*>(expr)) {
+        compileArithmetic(expr, dst, OpCode::kMultiply);
+        return;
+    }
+
+    if (dynamic_cast<const ExpressionSubtract*>(expr)) {
+        compileArithmetic(expr, dst, OpCode::kSubtract);
+        return;
+    }
+
+    if (dynamic_cast<const ExpressionDivide*>(expr)) {
+        compileArithmetic(expr, dst, OpCode::kDivide);
+        return;
+    }
+
+    Instruction instruction{OpCode::kEvaluate, dst};
+    instruction.expr = expr;
+    emit(std::move(instruction));
+}
+
+void CompiledExpression::compileAndOr(const Expression* expr, uint32_t dst, bool isAnd) {
+    // The first operand which decides the result jumps straight to loading it.
+    const uint32_t firstTemporary = _nextRegister;
+    std::vector<size_t> shortCircuitJumps;
+    for (auto&& child : expr->getChildren()) {
+        uint32_t operand = compileOperand(child.get());
+        shortCircuitJumps.push_back(
+            emit({isAnd ? OpCode::kJumpIfFalse : OpCode::kJumpIfTrue, 0, operand}));
+        _nextRegister = firstTemporary;
+    }
+
+    emit({OpCode::kLoadBool, dst, isAnd});
+    size_t jumpToEnd = emit({OpCode::kJump});
+    for (size_t jump : shortCircuitJumps) {
+        patchJumpToHere(jump);
+    }
+    emit({OpCode::kLoadBool, dst, !isAnd});
+    patchJumpToHere(jumpToEnd);
+}
+
+void CompiledExpression::compileArithmetic(const Expression* expr, uint32_t dst, OpCode op) {
+    const auto& children = expr->getChildren();
+    if (op == OpCode::kSubtract || op == OpCode::kDivide) {
+        invariant(children.size() == 2);
+        uint32_t lhs = compileOperand(children[0].get());
+        uint32_t rhs = compileOperand(children[1].get());
+        emit({op, dst, lhs, rhs});
+        return;
+    }
+
+    // $add and $multiply stop at the first nullish operand, $add also accepts a date, and
+    // $multiply fails on some doubles, so any other operand hands the whole expression back to the
+    // tree evaluator. Operands are checked as soon as they are evaluated so that the tree
+    // evaluator sees the same operands fail first.
+    const OpCode check = op == OpCode::kAdd ? OpCode::kJumpIfNotNumber : OpCode::kJumpIfNotFactor;
+    std::vector<uint32_t> operands;
+    std::vector<size_t> bailoutJumps;
+    for (auto&& child : children) {
+        operands.push_back(compileOperand(child.get()));
+        if (operands.back() & kConstantOperand) {
+            const Value& constant = _constants[operands.back() & ~kConstantOperand];
+            if (op == OpCode::kAdd ? isNumber(constant) : isFactor(constant))
+                continue;
+        }
+        bailoutJumps.push_back(emit({check, 0, operands.back()}));
+    }
+
+    emit({op,
+          dst,
+          static_cast<uint32_t>(_operandLists.size()),
+          static_cast<uint32_t>(operands.size())});
+    _operandLists.insert(_operandLists.end(), operands.begin(), operands.end());
+    if (bailoutJumps.empty())
+        return;
+
+    size_t jumpToEnd = emit({OpCode::kJump});
+    for (size_t jump : bailoutJumps) {
+        patchJumpToHere(jump);
+    }
+    Instruction bailout{OpCode::kEvaluate, dst};
+    bailout.expr = expr;
+    emit(std::move(bailout));
+    patchJumpToHere(jumpToEnd);
+}
+
+Value CompiledExpression::evaluate(const Document& root, Variables* variables) const {
+    // Registers are per-evaluation so that a program can be shared between threads. Only the
+    // registers the program uses are constructed, since that is a large part of the cost of
+    // evaluating a small program.
+    if (_numRegisters > kMaxInlineRegisters) {
+        std::vector<Value> regs(_numRegisters);
+        return run(root, variables, regs.data());
+    }
+
+    std::aligned_storage_t<sizeof(Value), alignof(Value)> storage[kMaxInlineRegisters];
+    Value* regs = reinterpret_cast<Value*>(storage);
+    std::uninitialized_value_construct_n(regs, _numRegisters);
+    ON_BLOCK_EXIT([&] { std::destroy_n(regs, _numRegisters); });
+    return run(root, variables, regs);
+}
+
+Value CompiledExpression::add(const Value* regs, const Instruction& instruction) const {
+    const uint32_t* operands = &_operandLists[instruction.lhs];
+    const size_t n = instruction.rhs;
+
+    // Integral operands are summed directly unless the sum overflows, which gives the same result
+    // as the compensated sum for any integral total which fits in a long.
+    long long total = 0;
+    bool haveLong = false;
+    size_t i = 0;
+    for (; i < n; ++i) {
+        const Value& val = operand(regs, operands[i]);
+        if (val.getType() == NumberInt) {
+            if (mongerSignedAddOverflow64(total, val.getInt(), &total))
+                break;
+        } else if (val.getType() == NumberLong) {
+            haveLong = true;
+            if (mongerSignedAddOverflow64(total, val.getLong(), &total))
+                break;
+        } else {
+            break;
+        }
+    }
+    if (i == n) {
+        return haveLong ? Value(total) : Value::createIntOrLong(total);
+    }
+
+    return addNumbers(n, [&](size_t i) -> const Value& { return operand(regs, operands[i]); });
+}
+
+Value CompiledExpression::multiply(const Value* regs, const Instruction& instruction) const {
+    const uint32_t* operands = &_operandLists[instruction.lhs];
+    const size_t n = instruction.rhs;
+
+    long long product = 1;
+    bool haveLong = false;
+    size_t i = 0;
+    for (; i < n; ++i) {
+        const Value& val = operand(regs, operands[i]);
+        if (val.getType() == NumberInt) {
+            if (mongerSignedMultiplyOverflow64(product, val.getInt(), &product))
+                break;
+        } else if (val.getType() == NumberLong) {
+            haveLong = true;
+            if (mongerSignedMultiplyOverflow64(product, val.getLong(), &product))
+                break;
+        } else {
+            break;
+        }
+    }
+    if (i == n) {
+        return haveLong ? Value(product) : Value::createIntOrLong(product);
+    }
+
+    return multiplyNumbers(n, [&](size_t i) -> const Value& { return operand(regs, operands[i]); });
+}
+
+Value CompiledExpression::run(const Document& root, Variables* variables, Value* regs) const {
+    const size_t codeSize = _code.size();
+    size_t pc = 0;
+    while (pc < codeSize) {
+        const Instruction& instruction = _code[pc++];
+        switch (instruction.op) {
+            case OpCode::kLoadConstant:
+                regs[instruction.dst] = operand(regs, instruction.lhs);
+                break;
+            case OpCode::kLoadRootField:
+                regs[instruction.dst] = root[instruction.fieldName];
+                break;
+            case OpCode::kEvaluate:
+                regs[instruction.dst] = instruction.expr->evaluate(root, variables);
+                break;
+            case OpCode::kLoadBool:
+                regs[instruction.dst] = Value(instruction.lhs != 0);
+                break;
+            case OpCode::kCoerceToBool:
+                regs[instruction.dst] = Value(operand(regs, instruction.lhs).coerceToBool());
+                break;
+            case OpCode::kNot:
+                regs[instruction.dst] = Value(!operand(regs, instruction.lhs).coerceToBool());
+                break;
+            case OpCode::kJump:
+                pc = instruction.target;
+                break;
+            case OpCode::kJumpIfFalse:
+                if (!operand(regs, instruction.lhs).coerceToBool())
+                    pc = instruction.target;
+                break;
+            case OpCode::kJumpIfTrue:
+                if (operand(regs, instruction.lhs).coerceToBool())
+                    pc = instruction.target;
+                break;
+            case OpCode::kJumpIfNotNumber:
+                if (!isNumber(operand(regs, instruction.lhs)))
+                    pc = instruction.target;
+                break;
+            case OpCode::kJumpIfNotFactor:
+                if (!isFactor(operand(regs, instruction.lhs)))
+                    pc = instruction.target;
+                break;
+            case OpCode::kCompare: {
+                const Value& lhs = operand(regs, instruction.lhs);
+                const Value& rhs = operand(regs, instruction.rhs);
+                int cmp;
+                if (tryFastCompare(lhs, rhs, &cmp)) {
+                    regs[instruction.dst] = cmpResult(instruction.cmpOp, cmp);
+                } else {
+                    // The comparator is looked up on every evaluation since the collation of the
+                    // ExpressionContext may change after compilation.
+                    regs[instruction.dst] = ExpressionCompare::apply(
+                        instruction.cmpOp,
+                        lhs,
+                        rhs,
+                        instruction.expr->getExpressionContext()->getValueComparator());
+                }
+                break;
+            }
+            case OpCode::kAdd:
+                regs[instruction.dst] = add(regs, instruction);
+                break;
+            case OpCode::kMultiply:
+                regs[instruction.dst] = multiply(regs, instruction);
+                break;
+            case OpCode::kSubtract:
+                regs[instruction.dst] =
+                    subtract(operand(regs, instruction.lhs), operand(regs, instruction.rhs));
+                break;
+            case OpCode::kDivide:
+                regs[instruction.dst] =
+                    divide(operand(regs, instruction.lhs), operand(regs, instruction.rhs));
+                break;
+        }
+    }
+    return std::move(regs[0]);
+}
+
+}  // namespace monger
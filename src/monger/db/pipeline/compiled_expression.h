@@ -0,0 +1,176 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <boost/intrusive_ptr.hpp>
+#include <memory>
+#include <vector>
+
+#include "monger/db/pipeline/expression.h"
+
+namespace monger {
+
+/**
+ * A flattened form of an optimized Expression tree which is evaluated by a small register machine
+ * rather than by recursive virtual calls. Field paths, constants, arithmetic, comparisons and the
+ * boolean and conditional operators are translated into instructions with fast paths for the
+ * common numeric types. Any other sub-expression is evaluated by its own evaluate() method from a
+ * single instruction, so every expression can be compiled and gives the same result, and throws
+ * the same errors, as evaluating the tree.
+ *
+ * Instruction operands name either a register or, if 'kConstantOperand' is set, an entry in the
+ * constant pool, so constants are never copied into registers.
+ *
+ * The program refers to the nodes of the tree it was compiled from and keeps the root alive. It
+ * must be recompiled if the tree is modified or re-optimized.
+ */
+class CompiledExpression {
+public:
+    enum class OpCode {
+        kLoadConstant,     // regs[dst] = operand(lhs)
+        kLoadRootField,    // regs[dst] = root[fieldName]
+        kEvaluate,         // regs[dst] = expr->evaluate(root, variables)
+        kLoadBool,         // regs[dst] = Value(bool(lhs))
+        kCoerceToBool,     // regs[dst] = Value(operand(lhs).coerceToBool())
+        kNot,              // regs[dst] = Value(!operand(lhs).coerceToBool())
+        kJump,             // pc = target
+        kJumpIfFalse,      // if (!operand(lhs).coerceToBool()) pc = target
+        kJumpIfTrue,       // if (operand(lhs).coerceToBool()) pc = target
+        kJumpIfNotNumber,  // if operand(lhs) is not a number, pc = target
+        kJumpIfNotFactor,  // if operand(lhs) is not a number $multiply accepts as is, pc = target
+        kCompare,          // regs[dst] = cmpOp(operand(lhs), operand(rhs))
+        kAdd,              // regs[dst] = sum of the 'rhs' operands listed from operandList[lhs]
+        kMultiply,         // regs[dst] = product of the 'rhs' operands listed from operandList[lhs]
+        kSubtract,         // regs[dst] = operand(lhs) - operand(rhs)
+        kDivide,           // regs[dst] = operand(lhs) / operand(rhs)
+    };
+
+    struct Instruction {
+        OpCode op;
+        uint32_t dst = 0;
+        uint32_t lhs = 0;
+        uint32_t rhs = 0;
+        uint32_t target = 0;
+        ExpressionCompare::CmpOp cmpOp = ExpressionCompare::EQ;
+
+        // The expression evaluated by kEvaluate, or the expression whose ExpressionContext
+        // provides the comparator for kCompare.
+        const Expression* expr = nullptr;
+        StringData fieldName;
+    };
+
+    // Set in an operand which refers to the constant pool rather than to a register.
+    static constexpr uint32_t kConstantOperand = 1u << 31;
+
+    /**
+     * Compiles 'expr', which should already be optimized. Returns nullptr if compilation is
+     * disabled by 'internalQueryCompileAggregationExpressions', or if the whole expression would
+     * be evaluated by a single kEvaluate instruction, in which case callers should just use
+     * 'expr' directly.
+     */
+    static std::unique_ptr<CompiledExpression> compile(boost::intrusive_ptr<Expression> expr);
+
+    /**
+     * Same as compile(), but always returns a program, even when compilation gives no benefit.
+     */
+    static std::unique_ptr<CompiledExpression> forceCompile(boost::intrusive_ptr<Expression> expr);
+
+    /**
+     * Evaluates the program. Like Expression::evaluate(), this is thread-safe so long as
+     * 'variables' is not shared between threads.
+     */
+    Value evaluate(const Document& root, Variables* variables) const;
+
+    const std::vector<Instruction>& getInstructions() const {
+        return _code;
+    }
+
+    size_t getNumRegisters() const {
+        return _numRegisters;
+    }
+
+private:
+    // Programs which need no more than this many registers keep them on the stack.
+    static constexpr size_t kMaxInlineRegisters = 16;
+
+    explicit CompiledExpression(boost::intrusive_ptr<Expression> root) : _root(std::move(root)) {}
+
+    /**
+     * Emits instructions which leave the value of 'expr' in register 'dst'.
+     */
+    void compileNode(const Expression* expr, uint32_t dst);
+
+    /**
+     * Returns an operand holding the value of 'expr', which is either the constant itself or a
+     * new register that 'expr' is compiled into.
+     */
+    uint32_t compileOperand(const Expression* expr);
+
+    void compileAndOr(const Expression* expr, uint32_t dst, bool isAnd);
+    void compileArithmetic(const Expression* expr, uint32_t dst, OpCode op);
+
+    // Registers are allocated like a stack: compileNode() frees the registers allocated for the
+    // operands of an expression once it has emitted the instruction which consumes them.
+    uint32_t allocateRegister() {
+        _numRegisters = std::max(_numRegisters, _nextRegister + 1);
+        return _nextRegister++;
+    }
+
+    size_t emit(Instruction instruction) {
+        _code.push_back(std::move(instruction));
+        return _code.size() - 1;
+    }
+
+    // Points the jump at 'jumpIndex' to the next instruction to be emitted.
+    void patchJumpToHere(size_t jumpIndex) {
+        _code[jumpIndex].target = _code.size();
+    }
+
+    const Value& operand(const Value* regs, uint32_t index) const {
+        return (index & kConstantOperand) ? _constants[index & ~kConstantOperand] : regs[index];
+    }
+
+    Value run(const Document& root, Variables* variables, Value* regs) const;
+
+    Value add(const Value* regs, const Instruction& instruction) const;
+    Value multiply(const Value* regs, const Instruction& instruction) const;
+
+    boost::intrusive_ptr<Expression> _root;
+    std::vector<Instruction> _code;
+    std::vector<Value> _constants;
+    // The operands of kAdd and kMultiply instructions.
+    std::vector<uint32_t> _operandLists;
+    uint32_t _nextRegister = 0;
+    uint32_t _numRegisters = 0;
+};
+
+}  // namespace monger
@@ -0,0 +1,96 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+
+#include "monger/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "monger/db/json.h"
+#include "monger/db/pipeline/compiled_expression.h"
+#include "monger/db/pipeline/expression_context_for_test.h"
+
+namespace monger {
+namespace {
+
+const char* const kExpressions[] = {
+    // Arithmetic over top-level fields.
+    "{$add: ['$a', {$multiply: ['$b', 2]}, {$subtract: ['$a', '$b']}]}",
+    // A predicate, as evaluated by $expr.
+    "{$and: [{$gt: ['$a', 10]}, {$lte: ['$b', 1000]}, {$ne: ['$a', '$b']}]}",
+    // A conditional, as computed by a $project.
+    "{$cond: [{$gte: ['$a', '$b']}, {$divide: ['$a', '$b']}, {$multiply: ['$a', 1.5]}]}",
+};
+
+std::vector<Document> makeDocuments() {
+    std::vector<Document> docs;
+    for (int i = 0; i < 1000; ++i) {
+        docs.push_back(Document{{"a", i}, {"b", (i * 7) % 97 + 1}, {"c", "unused"_sd}});
+    }
+    return docs;
+}
+
+boost::intrusive_ptr<Expression> parseExpression(
+    const boost::intrusive_ptr<ExpressionContextForTest>& expCtx, const char* json) {
+    BSONObj spec = fromjson(std::string("{expr: ") + json + "}");
+    return Expression::parseOperand(expCtx, spec.firstElement(), expCtx->variablesParseState)
+        ->optimize();
+}
+
+void BM_EvaluateTree(benchmark::State& state) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    auto expr = parseExpression(expCtx, kExpressions[state.range(0)]);
+    const auto docs = makeDocuments();
+    for (auto _ : state) {
+        for (auto&& doc : docs) {
+            benchmark::DoNotOptimize(expr->evaluate(doc, &expCtx->variables));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * docs.size());
+}
+
+void BM_EvaluateCompiled(benchmark::State& state) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    auto compiled =
+        CompiledExpression::forceCompile(parseExpression(expCtx, kExpressions[state.range(0)]));
+    const auto docs = makeDocuments();
+    for (auto _ : state) {
+        for (auto&& doc : docs) {
+            benchmark::DoNotOptimize(compiled->evaluate(doc, &expCtx->variables));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * docs.size());
+}
+
+BENCHMARK(BM_EvaluateTree)->DenseRange(0, 2);
+BENCHMARK(BM_EvaluateCompiled)->DenseRange(0, 2);
+
+}  // namespace
+}  // namespace monger
@@ -0,0 +1,218 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "monger/platform/basic.h"
+
+#include "monger/db/jsobj.h"
+#include "monger/db/json.h"
+#include "monger/db/pipeline/compiled_expression.h"
+#include "monger/db/pipeline/document_value_test_util.h"
+#include "monger/db/pipeline/expression_context_for_test.h"
+#include "monger/db/query/collation/collator_interface_mock.h"
+#include "monger/db/query/query_knobs_gen.h"
+#include "monger/unittest/unittest.h"
+#include "monger/util/scopeguard.h"
+
+namespace monger {
+namespace {
+
+using OpCode = CompiledExpression::OpCode;
+
+boost::intrusive_ptr<Expression> parseAndOptimize(
+    const boost::intrusive_ptr<ExpressionContextForTest>& expCtx, const std::string& json) {
+    BSONObj spec = fromjson("{expr: " + json + "}");
+    auto expr =
+        Expression::parseOperand(expCtx, spec.firstElement(), expCtx->variablesParseState);
+    return expr->optimize();
+}
+
+bool containsOp(const CompiledExpression& compiled, OpCode op) {
+    for (auto&& instruction : compiled.getInstructions()) {
+        if (instruction.op == op)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Asserts that the compiled form of 'json' produces the same result, or fails with the same error
+ * code, as the expression tree for each of 'inputs'.
+ */
+void assertSameAsTree(const std::string& json, const std::vector<std::string>& inputs) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    auto expr = parseAndOptimize(expCtx, json);
+    auto compiled = CompiledExpression::forceCompile(expr);
+
+    for (auto&& input : inputs) {
+        Document doc(fromjson(input));
+        boost::optional<Value> treeResult;
+        boost::optional<ErrorCodes::Error> treeError;
+        try {
+            treeResult = expr->evaluate(doc, &expCtx->variables);
+        } catch (const DBException& ex) {
+            treeError = ex.code();
+        }
+
+        if (treeError) {
+            ASSERT_THROWS_CODE(
+                compiled->evaluate(doc, &expCtx->variables), DBException, *treeError);
+            continue;
+        }
+
+        Value compiledResult = compiled->evaluate(doc, &expCtx->variables);
+        ASSERT_VALUE_EQ(compiledResult, *treeResult);
+        ASSERT_EQ(compiledResult.getType(), treeResult->getType()) << json << " on " << input;
+    }
+}
+
+const std::vector<std::string> kNumericInputs = {
+    "{a: 1, b: 2}",
+    "{a: 5, b: -3}",
+    "{a: 1.5, b: 2}",
+    "{a: NumberLong(9223372036854775807), b: 1}",
+    "{a: NumberLong(4611686018427387904), b: 4}",
+    "{a: 2147483647, b: 1}",
+    "{a: NumberDecimal('1.1'), b: 2}",
+    "{a: NaN, b: 1}",
+    "{a: 0, b: 0}",
+    "{a: null, b: 1}",
+    "{b: 1}",
+    "{a: 'str', b: 1}",
+    "{a: new Date(1000), b: 1}",
+    "{a: new Date(1000), b: new Date(2000)}",
+    "{a: {c: 1}, b: [1, 2]}",
+};
+
+TEST(CompiledExpressionTest, ArithmeticMatchesTree) {
+    for (auto&& expr : {"{$add: ['$a', '$b']}",
+                        "{$add: ['$a', '$b', 1.5]}",
+                        "{$add: ['$a', '$missing', {$divide: ['$a', 0]}]}",
+                        "{$multiply: ['$a', '$b']}",
+                        "{$multiply: ['$a', '$b', '$b']}",
+                        "{$multiply: ['$a', null, {$divide: ['$a', 0]}]}",
+                        "{$subtract: ['$a', '$b']}",
+                        "{$subtract: ['$b', '$a']}",
+                        "{$divide: ['$a', '$b']}",
+                        "{$divide: ['$b', '$a']}",
+                        "{$add: [{$multiply: ['$a', 2]}, {$subtract: ['$b', 1]}]}"}) {
+        assertSameAsTree(expr, kNumericInputs);
+    }
+}
+
+TEST(CompiledExpressionTest, ComparisonsMatchTree) {
+    for (auto&& op : {"$eq", "$ne", "$gt", "$gte", "$lt", "$lte", "$cmp"}) {
+        assertSameAsTree(std::string("{") + op + ": ['$a', '$b']}", kNumericInputs);
+        assertSameAsTree(std::string("{") + op + ": ['$a', 1]}", kNumericInputs);
+    }
+}
+
+TEST(CompiledExpressionTest, BooleanAndConditionalOperatorsMatchTree) {
+    for (auto&& expr : {"{$and: ['$a', '$b']}",
+                        "{$and: [{$gt: ['$a', 1]}, {$lt: ['$b', 3]}]}",
+                        "{$or: [{$gt: ['$a', 1]}, {$lt: ['$b', 0]}]}",
+                        "{$or: ['$missing', '$a']}",
+                        "{$not: ['$a']}",
+                        "{$and: ['$a']}",
+                        "{$cond: [{$gte: ['$a', 2]}, {$add: ['$a', 1]}, '$b']}",
+                        "{$cond: {if: '$a', then: 'yes', else: {$divide: ['$a', '$b']}}}",
+                        "{$and: [{$gt: ['$a', 0]}, {$divide: ['$b', '$a']}]}"}) {
+        assertSameAsTree(expr, kNumericInputs);
+    }
+}
+
+TEST(CompiledExpressionTest, OtherOperatorsAndPathsMatchTree) {
+    for (auto&& expr : {"'$a.c'",
+                        "'$$ROOT'",
+                        "'$b'",
+                        "{$add: [{$size: {$ifNull: ['$b', []]}}, 1]}",
+                        "{$concat: ['$a', 'x']}",
+                        "{$let: {vars: {x: '$a'}, in: {$add: ['$$x', 1]}}}"}) {
+        assertSameAsTree(expr, kNumericInputs);
+    }
+}
+
+TEST(CompiledExpressionTest, ArithmeticOnTopLevelFieldsDoesNotUseTree) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    auto compiled = CompiledExpression::compile(
+        parseAndOptimize(expCtx, "{$cond: [{$gt: ['$a', 1]}, {$add: ['$a', '$b']}, 0]}"));
+    ASSERT(compiled);
+    ASSERT_TRUE(containsOp(*compiled, OpCode::kLoadRootField));
+    ASSERT_TRUE(containsOp(*compiled, OpCode::kAdd));
+
+    // The only tree evaluation is the bailout for a non-numeric $add operand.
+    size_t numEvaluates = 0;
+    for (auto&& instruction : compiled->getInstructions()) {
+        if (instruction.op == OpCode::kEvaluate) {
+            ++numEvaluates;
+            ASSERT(dynamic_cast<const ExpressionAdd*>(instruction.expr));
+        }
+    }
+    ASSERT_EQ(numEvaluates, 1U);
+}
+
+TEST(CompiledExpressionTest, ComparisonUsesCollationOfExpressionContext) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    auto compiled = CompiledExpression::compile(parseAndOptimize(expCtx, "{$eq: ['$a', '$b']}"));
+    ASSERT(compiled);
+    Document doc(fromjson("{a: 'abc', b: 'ABC'}"));
+    ASSERT_VALUE_EQ(compiled->evaluate(doc, &expCtx->variables), Value(false));
+
+    CollatorInterfaceMock collator(CollatorInterfaceMock::MockType::kAlwaysEqual);
+    expCtx->setCollator(&collator);
+    ASSERT_VALUE_EQ(compiled->evaluate(doc, &expCtx->variables), Value(true));
+}
+
+TEST(CompiledExpressionTest, ProgramWithManyRegistersMatchesTree) {
+    std::string json = "'$a'";
+    for (int i = 0; i < 20; ++i) {
+        json = "{$add: [{$multiply: ['$b', " + std::to_string(i) + "]}, " + json + "]}";
+    }
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    ASSERT_GT(CompiledExpression::forceCompile(parseAndOptimize(expCtx, json))->getNumRegisters(),
+              16U);
+    assertSameAsTree(json, kNumericInputs);
+}
+
+TEST(CompiledExpressionTest, CompileReturnsNullWhenThereIsNothingToCompile) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    ASSERT_FALSE(CompiledExpression::compile(parseAndOptimize(expCtx, "{$concat: ['$a', 'x']}")));
+    ASSERT_FALSE(CompiledExpression::compile(nullptr));
+}
+
+TEST(CompiledExpressionTest, CompileReturnsNullWhenDisabled) {
+    internalQueryCompileAggregationExpressions.store(false);
+    ON_BLOCK_EXIT([] { internalQueryCompileAggregationExpressions.store(true); });
+
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    ASSERT_FALSE(CompiledExpression::compile(parseAndOptimize(expCtx, "{$add: ['$a', 1]}")));
+}
+
+}  // namespace
+}  // namespace monger
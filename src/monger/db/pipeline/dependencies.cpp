@@ -216,70 +216,11 @@ std::vector<DepsTracker::MetadataType> DepsTracker::getAllRequiredMetadataTypes(
     return reqs;
 }
 
-namespace {
-// Mutually recursive with arrayHelper
-Document documentHelper(const BSONObj& bson, const Document& neededFields, int nFieldsNeeded = -1);
-
-// Handles array-typed values for ParsedDeps::extractFields
-Value arrayHelper(const BSONObj& bson, const Document& neededFields) {
-    BSONObjIterator it(bson);
-
-    std::vector<Value> values;
-    while (it.more()) {
-        BSONElement bsonElement(it.next());
-        if (bsonElement.type() == Object) {
-            Document sub = documentHelper(bsonElement.embeddedObject(), neededFields);
-            values.push_back(Value(sub));
-        }
-
-        if (bsonElement.type() == Array) {
-            values.push_back(arrayHelper(bsonElement.embeddedObject(), neededFields));
-        }
-    }
-
-    return Value(std::move(values));
-}
-
-// Handles object-typed values including the top-level for ParsedDeps::extractFields
-Document documentHelper(const BSONObj& bson, const Document& neededFields, int nFieldsNeeded) {
-    // We cache the number of top level fields, so don't need to re-compute it every time. For
-    // sub-documents, just scan for the number of fields.
-    if (nFieldsNeeded == -1) {
-        nFieldsNeeded = neededFields.size();
-    }
-    MutableDocument md(nFieldsNeeded);
-
-    BSONObjIterator it(bson);
-    while (it.more() && nFieldsNeeded > 0) {
-        auto bsonElement = it.next();
-        StringData fieldName = bsonElement.fieldNameStringData();
-        Value isNeeded = neededFields[fieldName];
-
-        if (isNeeded.missing())
-            continue;
-
-        --nFieldsNeeded;  // Found a needed field.
-        if (isNeeded.getType() == Bool) {
-            md.addField(fieldName, Value(bsonElement));
-        } else {
-            dassert(isNeeded.getType() == Object);
-
-            if (bsonElement.type() == BSONType::Object) {
-                md.addField(
-                    fieldName,
-                    Value(documentHelper(bsonElement.embeddedObject(), isNeeded.getDocument())));
-            } else if (bsonElement.type() == BSONType::Array) {
-                md.addField(fieldName,
-                            arrayHelper(bsonElement.embeddedObject(), isNeeded.getDocument()));
-            }
-        }
-    }
-
-    return md.freeze();
+Document ParsedDeps::extractFields(const BSONObj& input) const {
+    return Document::fromBsonWithNeededFields(input, _fields, _nFields);
 }
-}  // namespace
 
-Document ParsedDeps::extractFields(const BSONObj& input) const {
-    return documentHelper(input, _fields, _nFields);
+Document ParsedDeps::extractFieldsLazily(const BSONObj& input) const {
+    return Document::fromBsonLazily(input, _fields, _nFields);
 }
 }
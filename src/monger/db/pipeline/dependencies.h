@@ -198,6 +198,12 @@ class ParsedDeps {
 public:
     Document extractFields(const BSONObj& input) const;
 
+    /**
+     * Like extractFields(), but the needed fields are only converted from 'input' when they are
+     * first looked up. See Document::fromBsonLazily().
+     */
+    Document extractFieldsLazily(const BSONObj& input) const;
+
 private:
     friend struct DepsTracker;  // so it can call constructor
     explicit ParsedDeps(Document&& fields) : _fields(std::move(fields)), _nFields(_fields.size()) {}
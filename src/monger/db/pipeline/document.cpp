@@ -54,7 +54,136 @@ const std::vector<StringData> Document::allMetadataFieldNames = {
     Document::metaFieldSortKey,
     Document::metaFieldTextScore};
 
-Position DocumentStorage::findField(StringData requested) const {
+namespace {
+// Mutually recursive with arrayHelper
+Document documentHelper(const BSONObj& bson, const Document& neededFields, int nFieldsNeeded = -1);
+
+// Handles array-typed values for Document::fromBsonWithNeededFields
+Value arrayHelper(const BSONObj& bson, const Document& neededFields) {
+    BSONObjIterator it(bson);
+
+    std::vector<Value> values;
+    while (it.more()) {
+        BSONElement bsonElement(it.next());
+        if (bsonElement.type() == Object) {
+            Document sub = documentHelper(bsonElement.embeddedObject(), neededFields);
+            values.push_back(Value(sub));
+        }
+
+        if (bsonElement.type() == Array) {
+            values.push_back(arrayHelper(bsonElement.embeddedObject(), neededFields));
+        }
+    }
+
+    return Value(std::move(values));
+}
+
+/**
+ * Converts a top-level element for which 'isNeeded' is the entry in the needed fields document.
+ * Returns Value() if nothing under the element is needed.
+ */
+Value neededFieldHelper(const BSONElement& bsonElement, const Value& isNeeded) {
+    if (isNeeded.getType() == Bool) {
+        return Value(bsonElement);
+    }
+
+    dassert(isNeeded.getType() == Object);
+    if (bsonElement.type() == BSONType::Object) {
+        return Value(documentHelper(bsonElement.embeddedObject(), isNeeded.getDocument()));
+    } else if (bsonElement.type() == BSONType::Array) {
+        return arrayHelper(bsonElement.embeddedObject(), isNeeded.getDocument());
+    }
+    return Value();
+}
+
+// Handles object-typed values including the top-level for Document::fromBsonWithNeededFields
+Document documentHelper(const BSONObj& bson, const Document& neededFields, int nFieldsNeeded) {
+    // We cache the number of top level fields, so don't need to re-compute it every time. For
+    // sub-documents, just scan for the number of fields.
+    if (nFieldsNeeded == -1) {
+        nFieldsNeeded = neededFields.size();
+    }
+    MutableDocument md(nFieldsNeeded);
+
+    BSONObjIterator it(bson);
+    while (it.more() && nFieldsNeeded > 0) {
+        auto bsonElement = it.next();
+        StringData fieldName = bsonElement.fieldNameStringData();
+        Value isNeeded = neededFields[fieldName];
+
+        if (isNeeded.missing())
+            continue;
+
+        --nFieldsNeeded;  // Found a needed field.
+        Value value = neededFieldHelper(bsonElement, isNeeded);
+        if (!value.missing()) {
+            md.addField(fieldName, std::move(value));
+        }
+    }
+
+    return md.freeze();
+}
+}  // namespace
+
+DocumentStorage::DocumentStorage(BSONObj bson, Value neededFields, size_t nNeededFields)
+    : DocumentStorage() {
+    invariant(bson.isOwned());
+    _bson = std::move(bson);
+    _bsonNext = _bson.firstElement().rawdata();
+    _neededFields = std::move(neededFields);
+    _neededFieldsRemaining = nNeededFields;
+
+    if (_bson.isEmpty() || (!_neededFields.missing() && _neededFieldsRemaining == 0)) {
+        _bsonNext = nullptr;
+        _bson = BSONObj();
+        _neededFields = Value();
+    } else if (!_neededFields.missing()) {
+        reserveFields(_neededFieldsRemaining);
+    }
+}
+
+Position DocumentStorage::loadBsonFields(boost::optional<StringData> stopAt) {
+    Position found;
+    while (_bsonNext && !found.found()) {
+        BSONElement bsonElement(_bsonNext);
+        if (bsonElement.eoo()) {
+            _bsonNext = nullptr;
+            break;
+        }
+        _bsonNext += bsonElement.size();
+
+        StringData fieldName = bsonElement.fieldNameStringData();
+        Value value;
+        if (_neededFields.missing()) {
+            value = Value(bsonElement);
+        } else {
+            Value isNeeded = _neededFields.getDocument()[fieldName];
+            if (isNeeded.missing())
+                continue;
+
+            if (--_neededFieldsRemaining == 0)
+                _bsonNext = nullptr;
+
+            value = neededFieldHelper(bsonElement, isNeeded);
+            if (value.missing())
+                continue;
+        }
+
+        const Position pos = getNextPosition();
+        appendFieldToCache(fieldName) = std::move(value);
+        if (stopAt && fieldName == *stopAt)
+            found = pos;
+    }
+
+    if (!_bsonNext) {
+        // Everything visible has been converted, so the BSON is no longer needed.
+        _bson = BSONObj();
+        _neededFields = Value();
+    }
+    return found;
+}
+
+Position DocumentStorage::findFieldInCache(StringData requested) const {
     int reqSize = requested.size();  // get size calculation out of the way if needed
 
     if (_numFields >= HASH_TAB_MIN) {  // hash lookup
@@ -70,8 +199,8 @@ Position DocumentStorage::findField(StringData requested) const {
             // possible collision
             pos = elem.nextCollision;
         }
-    } else {  // linear scan
-        for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
+    } else {  // linear scan, without loading any more fields from the backing BSON
+        for (DocumentStorageIterator it = iteratorCacheOnly(); !it.atEnd(); it.advance()) {
             if (it->nameLen == reqSize && memcmp(requested.rawData(), it->_name, reqSize) == 0) {
                 return it.position();
             }
@@ -82,7 +211,7 @@ Position DocumentStorage::findField(StringData requested) const {
     return Position();
 }
 
-Value& DocumentStorage::appendField(StringData name) {
+Value& DocumentStorage::appendFieldToCache(StringData name) {
     Position pos = getNextPosition();
     const int nameSize = name.size();
 
@@ -209,7 +338,7 @@ intrusive_ptr<DocumentStorage> DocumentStorage::clone() const {
         dassert(out->allocatedBytes() == bufferBytes);
 
         // Tell values that they have been memcpyed (updates ref counts)
-        for (DocumentStorageIterator it = out->iteratorAll(); !it.atEnd(); it.advance()) {
+        for (DocumentStorageIterator it = out->iteratorCacheOnly(); !it.atEnd(); it.advance()) {
             it->val.memcpyed();
         }
     } else {
@@ -231,6 +360,14 @@ intrusive_ptr<DocumentStorage> DocumentStorage::clone() const {
         out->_searchHighlights = _searchHighlights;
     }
 
+    // Share the backing BSON so that fields which have not been loaded yet stay lazy.
+    if (_bsonNext) {
+        out->_bson = _bson;
+        out->_bsonNext = _bsonNext;
+        out->_neededFields = _neededFields;
+        out->_neededFieldsRemaining = _neededFieldsRemaining;
+    }
+
     return out;
 }
 
@@ -251,7 +388,7 @@ size_t DocumentStorage::getMetadataApproximateSize() const {
 DocumentStorage::~DocumentStorage() {
     std::unique_ptr<char[]> deleteBufferAtScopeEnd(_buffer);
 
-    for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
+    for (DocumentStorageIterator it = iteratorCacheOnly(); !it.atEnd(); it.advance()) {
         it->val.~Value();  // explicit destructor call
     }
 }
@@ -268,6 +405,23 @@ Document::Document(const BSONObj& bson) {
     *this = md.freeze();
 }
 
+Document Document::fromBsonLazily(const BSONObj& bson) {
+    return Document(make_intrusive<DocumentStorage>(bson.getOwned(), Value(), 0));
+}
+
+Document Document::fromBsonLazily(const BSONObj& bson,
+                                  const Document& neededFields,
+                                  size_t nNeededFields) {
+    return Document(
+        make_intrusive<DocumentStorage>(bson.getOwned(), Value(neededFields), nNeededFields));
+}
+
+Document Document::fromBsonWithNeededFields(const BSONObj& bson,
+                                            const Document& neededFields,
+                                            size_t nNeededFields) {
+    return documentHelper(bson, neededFields, static_cast<int>(nNeededFields));
+}
+
 Document::Document(std::initializer_list<std::pair<StringData, ImplicitValue>> initializerList) {
     MutableDocument mutableDoc(initializerList.size());
 
@@ -448,8 +602,12 @@ size_t Document::getApproximateSize() const {
 
     size_t size = sizeof(DocumentStorage);
     size += storage().allocatedBytes();
+    size += storage().getBackingBsonSize();
 
-    for (DocumentStorageIterator it = storage().iterator(); !it.atEnd(); it.advance()) {
+    // Fields which have not been loaded yet are accounted for by the backing BSON.
+    for (DocumentStorageIterator it = storage().iteratorCacheOnly(); !it.atEnd(); it.advance()) {
+        if (it->val.missing())
+            continue;
         size += it->val.getApproximateSize();
         size -= sizeof(Value);  // already accounted for above
     }
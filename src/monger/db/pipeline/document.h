@@ -152,6 +152,15 @@ public:
         return !_storage || storage().iterator().atEnd();
     }
 
+    /**
+     * Converts any fields of a Document created by fromBsonLazily() which have not been looked up
+     * yet. Looking up a field may otherwise modify the Document's storage, so this must be called
+     * before handing a Document to threads which may read it concurrently.
+     */
+    void fillCache() const {
+        storage().fillCache();
+    }
+
     /// Create a new FieldIterator that can be used to examine the Document's fields in order.
     FieldIterator fieldIterator() const;
 
@@ -233,6 +242,34 @@ public:
      */
     static Document fromBsonWithMetaData(const BSONObj& bson);
 
+    /**
+     * Like Document(BSONObj), but top-level fields are only converted when they are first looked
+     * up. A lookup converts fields in order until it reaches the requested one, and converted
+     * fields stay in the Document's hash table, so no field is converted or scanned for twice.
+     * Iterating, serializing or modifying the result converts the rest of the document. Metadata
+     * fields are not parsed. Keeps a copy of 'bson' until every field has been converted.
+     */
+    static Document fromBsonLazily(const BSONObj& bson);
+
+    /**
+     * Like fromBsonLazily(bson), but only the fields of 'bson' named in 'neededFields' are
+     * visible, with the same result as fromBsonWithNeededFields(). Conversion stops once all
+     * 'nNeededFields' top-level fields of 'neededFields' have been found.
+     */
+    static Document fromBsonLazily(const BSONObj& bson,
+                                   const Document& neededFields,
+                                   size_t nNeededFields);
+
+    /**
+     * Returns a Document containing only the parts of 'bson' named in 'neededFields', which maps
+     * each needed top-level field either to true or to a sub-document naming its needed subfields.
+     * 'nNeededFields' is the number of top-level fields in 'neededFields'. This is the format
+     * produced by DepsTracker::toParsedDeps().
+     */
+    static Document fromBsonWithNeededFields(const BSONObj& bson,
+                                             const Document& neededFields,
+                                             size_t nNeededFields);
+
     /**
      * Given a BSON object that may have metadata fields added as part of toBsonWithMetadata(),
      * returns the same object without any of the metadata fields.
@@ -631,7 +668,10 @@ private:
             return clonedStorage();
 
         // This function exists to ensure this is safe
-        return const_cast<DocumentStorage&>(*storagePtr());
+        DocumentStorage& storage = const_cast<DocumentStorage&>(*storagePtr());
+        // MutableValues refer into the field cache, so it must not grow behind their backs.
+        storage.fillCache();
+        return storage;
     }
     DocumentStorage& newStorage() {
         reset(make_intrusive<DocumentStorage>());
@@ -639,7 +679,9 @@ private:
     }
     DocumentStorage& clonedStorage() {
         reset(storagePtr()->clone());
-        return const_cast<DocumentStorage&>(*storagePtr());
+        DocumentStorage& storage = const_cast<DocumentStorage&>(*storagePtr());
+        storage.fillCache();
+        return storage;
     }
 
     // recursive helpers for same-named public methods
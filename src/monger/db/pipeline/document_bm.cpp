@@ -0,0 +1,173 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "monger/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "monger/bson/bsonobjbuilder.h"
+#include "monger/db/pipeline/document.h"
+
+namespace monger {
+namespace {
+
+/**
+ * Builds a document of 'nFields' fields alternating between ints, strings and small
+ * sub-documents, named "f0", "f1", etc.
+ */
+BSONObj makeWideObject(int nFields) {
+    BSONObjBuilder bob;
+    for (int i = 0; i < nFields; ++i) {
+        const std::string name = "f" + std::to_string(i);
+        switch (i % 3) {
+            case 0:
+                bob.append(name, i);
+                break;
+            case 1:
+                bob.append(name, "a moderately long string value " + std::to_string(i));
+                break;
+            case 2:
+                bob.append(name, BSON("x" << i << "y" << BSON_ARRAY(i << i + 1)));
+                break;
+        }
+    }
+    return bob.obj();
+}
+
+/**
+ * Returns the names of 'nAccessed' fields spread evenly over an object of 'nFields' fields, so
+ * that lookups on lazily converted documents cannot all be satisfied by the first few fields.
+ */
+std::vector<std::string> accessedFieldNames(int nFields, int nAccessed) {
+    std::vector<std::string> names;
+    for (int i = 0; i < nAccessed; ++i) {
+        names.push_back("f" + std::to_string((i * nFields) / nAccessed));
+    }
+    return names;
+}
+
+Document neededFieldsFor(const std::vector<std::string>& names) {
+    MutableDocument md;
+    for (auto&& name : names) {
+        md.addField(name, Value(true));
+    }
+    return md.freeze();
+}
+
+void runFieldAccess(benchmark::State& state, Document (*makeDocument)(const BSONObj&)) {
+    const BSONObj obj = makeWideObject(state.range(0));
+    const auto names = accessedFieldNames(state.range(0), state.range(1));
+    for (auto _ : state) {
+        Document doc = makeDocument(obj);
+        for (auto&& name : names) {
+            benchmark::DoNotOptimize(doc[name]);
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * obj.objsize());
+}
+
+void BM_FieldAccessEager(benchmark::State& state) {
+    runFieldAccess(state, [](const BSONObj& obj) { return Document(obj); });
+}
+
+void BM_FieldAccessLazy(benchmark::State& state) {
+    runFieldAccess(state, [](const BSONObj& obj) { return Document::fromBsonLazily(obj); });
+}
+
+void runNeededFieldAccess(benchmark::State& state, bool lazy) {
+    const BSONObj obj = makeWideObject(state.range(0));
+    const auto names = accessedFieldNames(state.range(0), state.range(1));
+    const Document neededFields = neededFieldsFor(names);
+    for (auto _ : state) {
+        Document doc = lazy ? Document::fromBsonLazily(obj, neededFields, names.size())
+                            : Document::fromBsonWithNeededFields(obj, neededFields, names.size());
+        for (auto&& name : names) {
+            benchmark::DoNotOptimize(doc[name]);
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * obj.objsize());
+}
+
+void BM_NeededFieldAccessEager(benchmark::State& state) {
+    runNeededFieldAccess(state, false);
+}
+
+void BM_NeededFieldAccessLazy(benchmark::State& state) {
+    runNeededFieldAccess(state, true);
+}
+
+/**
+ * Measures repeated lookups on one document, as a chain of $project and $addFields stages would
+ * perform them.
+ */
+void runRepeatedFieldAccess(benchmark::State& state, bool lazy) {
+    const BSONObj obj = makeWideObject(state.range(0));
+    const auto names = accessedFieldNames(state.range(0), state.range(1));
+    const Document doc = lazy ? Document::fromBsonLazily(obj) : Document(obj);
+    for (auto _ : state) {
+        for (auto&& name : names) {
+            benchmark::DoNotOptimize(doc[name]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * names.size());
+}
+
+void BM_RepeatedFieldAccessEager(benchmark::State& state) {
+    runRepeatedFieldAccess(state, false);
+}
+
+void BM_RepeatedFieldAccessLazy(benchmark::State& state) {
+    runRepeatedFieldAccess(state, true);
+}
+
+void BM_ToBson(benchmark::State& state) {
+    const BSONObj obj = makeWideObject(state.range(0));
+    const Document doc(obj);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(doc.toBson());
+    }
+    state.SetBytesProcessed(state.iterations() * obj.objsize());
+}
+
+// Arguments are {number of fields in the document, number of fields accessed}.
+void fieldAccessArgs(benchmark::internal::Benchmark* b) {
+    b->Args({10, 3})->Args({200, 3})->Args({200, 50})->Args({200, 200});
+}
+
+BENCHMARK(BM_FieldAccessEager)->Apply(fieldAccessArgs);
+BENCHMARK(BM_FieldAccessLazy)->Apply(fieldAccessArgs);
+BENCHMARK(BM_NeededFieldAccessEager)->Apply(fieldAccessArgs);
+BENCHMARK(BM_NeededFieldAccessLazy)->Apply(fieldAccessArgs);
+BENCHMARK(BM_RepeatedFieldAccessEager)->Apply(fieldAccessArgs);
+BENCHMARK(BM_RepeatedFieldAccessLazy)->Apply(fieldAccessArgs);
+BENCHMARK(BM_ToBson)->Arg(10)->Arg(200);
+
+}  // namespace
+}  // namespace monger
@@ -33,6 +33,7 @@
 
 #include <bitset>
 #include <boost/intrusive_ptr.hpp>
+#include <boost/optional.hpp>
 
 #include "monger/base/static_assert.h"
 #include "monger/db/pipeline/value.h"
@@ -193,7 +194,17 @@ public:
           _textScore(0),
           _randVal(0),
           _geoNearDistance(0),
-          _searchScore(0) {}
+          _searchScore(0),
+          _bsonNext(nullptr),
+          _neededFieldsRemaining(0) {}
+
+    /**
+     * Constructs a storage whose fields are converted from 'bson' the first time they are looked
+     * up, see Document::fromBsonLazily(). 'bson' must be owned. If 'neededFields' is not missing,
+     * it holds a Document in the format produced by DepsTracker::toParsedDeps() naming the
+     * 'nNeededFields' top-level fields which are visible.
+     */
+    DocumentStorage(BSONObj bson, Value neededFields, size_t nNeededFields);
 
     ~DocumentStorage();
 
@@ -227,8 +238,16 @@ public:
         return Position(_usedBytes);
     }
 
-    /// Returns the position of the named field (may be missing) or Position()
-    Position findField(StringData name) const;
+    /**
+     * Returns the position of the named field (may be missing) or Position(). If the field is not
+     * in the cache yet, loads fields from the backing BSON until it is found.
+     */
+    Position findField(StringData name) const {
+        Position pos = findFieldInCache(name);
+        if (pos.found() || MONGO_likely(!_bsonNext))
+            return pos;
+        return const_cast<DocumentStorage*>(this)->loadBsonFields(name);
+    }
 
     // Document uses these
     const ValueElement& getField(Position pos) const {
@@ -255,7 +274,10 @@ public:
     }
 
     /// Adds a new field with missing Value at the end of the document
-    Value& appendField(StringData name);
+    Value& appendField(StringData name) {
+        fillCache();
+        return appendFieldToCache(name);
+    }
 
     /** Preallocates space for fields. Use this to attempt to prevent buffer growth.
      *  This is only valid to call before anything is added to the document.
@@ -264,14 +286,35 @@ public:
 
     /// This skips missing values
     DocumentStorageIterator iterator() const {
+        fillCache();
         return DocumentStorageIterator(_firstElement, end(), false);
     }
 
     /// This includes missing values
     DocumentStorageIterator iteratorAll() const {
+        fillCache();
+        return DocumentStorageIterator(_firstElement, end(), true);
+    }
+
+    /**
+     * Like iteratorAll(), but only visits the fields which have already been loaded from the
+     * backing BSON and does not load any more.
+     */
+    DocumentStorageIterator iteratorCacheOnly() const {
         return DocumentStorageIterator(_firstElement, end(), true);
     }
 
+    /// Loads every field which has not yet been converted from the backing BSON.
+    void fillCache() const {
+        if (MONGO_unlikely(_bsonNext))
+            const_cast<DocumentStorage*>(this)->loadBsonFields(boost::none);
+    }
+
+    /// Size of the backing BSON while some of it is still waiting to be loaded, otherwise 0.
+    size_t getBackingBsonSize() const {
+        return _bsonNext ? _bson.objsize() : 0;
+    }
+
     /// Shallow copy of this. Caller owns memory.
     boost::intrusive_ptr<DocumentStorage> clone() const;
 
@@ -391,6 +434,19 @@ public:
     }
 
 private:
+    /// Returns the position of the named field if it has already been loaded, or Position().
+    Position findFieldInCache(StringData name) const;
+
+    /// Adds a new field with missing Value after the fields which have already been loaded.
+    Value& appendFieldToCache(StringData name);
+
+    /**
+     * Converts fields of the backing BSON into the cache until one named 'stopAt' has been
+     * loaded and returns its position. If 'stopAt' is boost::none or names no visible field,
+     * loads every remaining field and returns Position().
+     */
+    Position loadBsonFields(boost::optional<StringData> stopAt);
+
     /// Same as lastElement->next() or firstElement() if empty.
     const ValueElement* end() const {
         return _firstElement ? _firstElement->plusBytes(_usedBytes) : nullptr;
@@ -434,7 +490,7 @@ private:
     /// Adds all fields to the hash table
     void rehash() {
         hashTabInit();
-        for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance())
+        for (DocumentStorageIterator it = iteratorCacheOnly(); !it.atEnd(); it.advance())
             addFieldToHashTable(it.position());
     }
 
@@ -478,6 +534,17 @@ private:
     Value _searchHighlights;
     // When adding a field, make sure to update clone() and getMetadataApproximateSize() methods.
 
+    // Backing BSON of a lazily converted document. '_bsonNext' points at the first element which
+    // has not been loaded into the cache yet, or is null once every visible field is loaded. The
+    // cache always holds a prefix of the BSON, so field order is preserved.
+    BSONObj _bson;
+    const char* _bsonNext;
+
+    // If not missing, the Document of fields to keep (see ParsedDeps) and how many of them have
+    // not been found yet, which lets loading stop before the end of '_bson'.
+    Value _neededFields;
+    size_t _neededFieldsRemaining;
+
     // Defined in document.cpp
     static const DocumentStorage kEmptyDoc;
 };
@@ -314,6 +314,22 @@ public:
         return false;
     };
 
+    /**
+     * Returns the tracker charged with the memory this stage holds, whose peak is reported by
+     * explain, or nullptr if the stage holds no more than the document it is processing.
+     */
+    virtual const MemoryUsageTracker* getMemoryTracker() const {
+        return nullptr;
+    }
+
+    /**
+     * Returns the sort orders which the documents returned by this stage are known to follow, as
+     * sort patterns over the fields of those documents. Returns an empty set if there are none.
+     */
+    virtual BSONObjSet getOutputSorts() {
+        return SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+    }
+
     /**
      * Create a DocumentSource pipeline stage from 'stageObj'.
      */
@@ -148,6 +148,18 @@ DocumentSource::GetNextResult DocumentSourceBucketAuto::populateSorter() {
         auto nextDoc = next.releaseDocument();
         _sorter->add(extractKey(nextDoc), nextDoc);
         _nDocuments++;
+
+        // The sorter spills by itself past the limit of this stage, but must be made to spill when
+        // the operation as a whole is over its budget.
+        _memoryTracker.set(_sorter->memUsed());
+        if (!_memoryTracker.withinMemoryLimit()) {
+            uassert(ErrorCodes::ExceededMemoryLimit,
+                    "Exceeded the memory limit of the operation in $bucketAuto, but did not opt in "
+                    "to external sorting. Pass allowDiskUse:true to opt in.",
+                    pExpCtx->allowDiskUse && !pExpCtx->inMongers);
+            _sorter->spill();
+            _memoryTracker.set(_sorter->memUsed());
+        }
     }
     return next;
 }
@@ -198,6 +210,7 @@ void DocumentSourceBucketAuto::addDocumentToBucket(const pair<Value, Document>&
 void DocumentSourceBucketAuto::populateBuckets() {
     invariant(_sorter);
     _sortedInput.reset(_sorter->done());
+    _memoryTracker.set(_sorter->memUsed());
     _sorter.reset();
 
     // If there are no buckets, then we don't need to populate anything.
@@ -369,6 +382,7 @@ Document DocumentSourceBucketAuto::makeDocument(const Bucket& bucket) {
 void DocumentSourceBucketAuto::doDispose() {
     _sortedInput.reset();
     _bucketsIterator = _buckets.end();
+    _memoryTracker.set(0);
 }
 
 Value DocumentSourceBucketAuto::serialize(
@@ -429,6 +443,7 @@ DocumentSourceBucketAuto::DocumentSourceBucketAuto(
     : DocumentSource(pExpCtx),
       _nBuckets(numBuckets),
       _maxMemoryUsageBytes(maxMemoryUsageBytes),
+      _memoryTracker(pExpCtx->memoryTracker.get()),
       _groupByExpression(groupByExpression),
       _granularityRounder(granularityRounder) {
 
@@ -49,6 +49,10 @@ public:
     GetNextResult getNext() final;
     const char* getSourceName() const final;
 
+    const MemoryUsageTracker* getMemoryTracker() const final {
+        return &_memoryTracker;
+    }
+
     StageConstraints constraints(Pipeline::SplitState pipeState) const final {
         return {StreamType::kBlocking,
                 PositionRequirement::kNone,
@@ -155,6 +159,7 @@ private:
 
     int _nBuckets;
     uint64_t _maxMemoryUsageBytes;
+    MemoryUsageTracker _memoryTracker;
     bool _populated = false;
     std::vector<Bucket> _buckets;
     std::vector<Bucket>::iterator _bucketsIterator;
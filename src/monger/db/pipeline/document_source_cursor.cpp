@@ -38,6 +38,7 @@
 #include "monger/db/pipeline/document.h"
 #include "monger/db/query/explain.h"
 #include "monger/db/query/find_common.h"
+#include "monger/db/query/query_knobs_gen.h"
 #include "monger/db/storage/storage_options.h"
 #include "monger/util/fail_point_service.h"
 #include "monger/util/log.h"
@@ -75,7 +76,12 @@ DocumentSource::GetNextResult DocumentSourceCursor::getNext() {
 }
 
 Document DocumentSourceCursor::transformBSONObjToDocument(const BSONObj& obj) const {
-    return _dependencies ? _dependencies->extractFields(obj) : Document::fromBsonWithMetaData(obj);
+    if (!_dependencies) {
+        return Document::fromBsonWithMetaData(obj);
+    }
+    return internalDocumentSourceCursorLazyFieldExtraction.load()
+        ? _dependencies->extractFieldsLazily(obj)
+        : _dependencies->extractFields(obj);
 }
 
 void DocumentSourceCursor::loadBatch() {
@@ -308,6 +314,7 @@ DocumentSourceCursor::DocumentSourceCursor(
     : DocumentSource(pCtx),
       _docsAddedToBatches(0),
       _exec(std::move(exec)),
+      _outputSorts(_exec->getOutputSorts()),
       _trackOplogTS(trackOplogTimestamp) {
     // Later code in the DocumentSourceCursor lifecycle expects that '_exec' is in a saved state.
     _exec->saveState();
@@ -70,6 +70,10 @@ public:
         return boost::none;
     }
 
+    BSONObjSet getOutputSorts() final {
+        return _outputSorts;
+    }
+
     void detachFromOperationContext() final;
 
     void reattachToOperationContext(OperationContext* opCtx) final;
@@ -225,6 +229,9 @@ private:
     std::string _planSummary;
     PlanSummaryStats _planSummaryStats;
 
+    // The sort orders of the results of '_exec', as chosen by the query planner.
+    BSONObjSet _outputSorts;
+
     // Used only for explain() queries. Stores the stats of the winning plan when _exec's root
     // stage is a MultiPlanStage. When the query is executed (with exec->executePlan()), it will
     // wipe out its own copy of the winning plan's statistics, so they need to be saved here.
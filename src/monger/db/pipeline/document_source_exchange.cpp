@@ -335,6 +335,10 @@ DocumentSource::GetNextResult Exchange::getNext(OperationContext* opCtx,
             } catch (const DBException& ex) {
                 _errorInLoadNextBatch = ex.toStatus();
 
+                // The pipeline must not stay attached to this consumer's OperationContext, which
+                // does not outlive the getMore that failed.
+                _pipeline->detachFromOperationContext();
+
                 // We have to wake up all other blocked threads so they can detect the error and
                 // fail too. They can be woken up only after _errorInLoadNextBatch has been set.
                 _haveBufferSpace.notify_all();
@@ -359,7 +363,8 @@ size_t Exchange::loadNextBatch() {
         switch (_policy) {
             case ExchangePolicyEnum::kBroadcast: {
                 bool full = false;
-                // The document is sent to all consumers.
+                // The document is sent to all consumers, which may read it concurrently.
+                input.getDocument().fillCache();
                 for (auto& c : _consumers) {
                     full = c->appendDocument(input, _maxBufferSize);
                 }
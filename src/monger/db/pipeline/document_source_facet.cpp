@@ -58,8 +58,10 @@ using std::vector;
 DocumentSourceFacet::DocumentSourceFacet(std::vector<FacetPipeline> facetPipelines,
                                          const intrusive_ptr<ExpressionContext>& expCtx)
     : DocumentSource(expCtx),
+      _memoryTracker(pExpCtx->memoryTracker.get()),
       _teeBuffer(TeeBuffer::create(facetPipelines.size())),
       _facets(std::move(facetPipelines)) {
+    _teeBuffer->setMemoryTracker(&_memoryTracker);
     for (size_t facetId = 0; facetId < _facets.size(); ++facetId) {
         auto& facet = _facets[facetId];
         facet.pipeline->addInitialSource(
@@ -154,6 +154,14 @@ public:
     StageConstraints constraints(Pipeline::SplitState pipeState) const final;
     bool usedDisk() final;
 
+    /**
+     * Returns the tracker charged with the batch of input buffered for the sub-pipelines. Their own
+     * blocking stages are tracked, and reported, separately.
+     */
+    const MemoryUsageTracker* getMemoryTracker() const final {
+        return &_memoryTracker;
+    }
+
 protected:
     void doDispose() final;
 
@@ -163,6 +171,8 @@ private:
 
     Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final;
 
+    // Declared before '_teeBuffer', which charges it, so that it outlives the buffer.
+    MemoryUsageTracker _memoryTracker;
     boost::intrusive_ptr<TeeBuffer> _teeBuffer;
     std::vector<FacetPipeline> _facets;
 
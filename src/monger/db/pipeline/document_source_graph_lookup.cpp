@@ -31,6 +31,7 @@
 
 #include "monger/db/pipeline/document_source_graph_lookup.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "monger/base/init.h"
@@ -42,6 +43,7 @@
 #include "monger/db/pipeline/expression.h"
 #include "monger/db/pipeline/expression_context.h"
 #include "monger/db/pipeline/value.h"
+#include "monger/db/query/query_knobs_gen.h"
 #include "monger/db/query/query_planner_common.h"
 
 namespace monger {
@@ -104,20 +106,29 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::getNext() {
 
     performSearch();
 
+    // Results are removed one at a time to avoid consuming more memory. Unlike the search, the
+    // array they are gathered into cannot be spilled, so it must stay within the memory limit.
     std::vector<Value> results;
-    while (!_visited.empty()) {
-        // Remove elements one at a time to avoid consuming more memory.
-        auto it = _visited.begin();
-        results.push_back(Value(it->second));
-        _visited.erase(it);
+    while (auto result = nextResult()) {
+        _outputUsageBytes += result->getApproximateSize();
+        updateMemoryTracker();
+        uassert(40099,
+                "$graphLookup reached maximum memory consumption",
+                _visitedUsageBytes + _outputUsageBytes < _maxMemoryUsageBytes);
+        if (!_memoryTracker.withinMemoryLimit()) {
+            _cache.clear();
+            updateMemoryTracker();
+        }
+        uassert(ErrorCodes::ExceededMemoryLimit,
+                "$graphLookup exceeded the memory limit of the operation",
+                _memoryTracker.withinMemoryLimit());
+        results.push_back(Value(std::move(*result)));
     }
 
     MutableDocument output(*_input);
     output.setNestedField(_as, Value(std::move(results)));
 
-    _visitedUsageBytes = 0;
-
-    invariant(_visited.empty());
+    finishSearch();
 
     return output.freeze();
 }
@@ -128,43 +139,50 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::getNextUnwound() {
     // If the unwind is not preserving empty arrays, we might have to process multiple inputs before
     // we get one that will produce an output.
     while (true) {
-        if (_visited.empty()) {
-            // No results are left for the current input, so we should move on to the next one and
-            // perform a new search.
-
+        if (!_input) {
+            // No results are left for the previous input, so we should move on to the next one and
+            // start a new search.
             auto input = pSource->getNext();
             if (!input.isAdvanced()) {
                 return input;
             }
 
             _input = input.releaseDocument();
-            performSearch();
-            _visitedUsageBytes = 0;
+            startSearch();
             _outputIndex = 0;
         }
+
+        // Each level of the search is only performed once the nodes found by the previous one have
+        // been returned, so a deep search never holds more than one level of its results.
+        auto result = nextResult();
+        while (!result && _searchInProgress) {
+            expandNextLevel();
+            result = nextResult();
+        }
+
         MutableDocument unwound(*_input);
 
-        if (_visited.empty()) {
-            if ((*_unwind)->preserveNullAndEmptyArrays()) {
-                // Since "preserveNullAndEmptyArrays" was specified, output a document even though
-                // we had no result.
-                unwound.setNestedField(_as, Value());
-                if (indexPath) {
-                    unwound.setNestedField(*indexPath, Value(BSONNULL));
-                }
-            } else {
-                // $unwind would not output anything, since the '_as' field would not exist. We
-                // should loop until we have something to return.
+        if (!result) {
+            const bool hadResults = _outputIndex > 0;
+            finishSearch();
+            if (hadResults || !(*_unwind)->preserveNullAndEmptyArrays()) {
+                // $unwind would not output anything more for this input, since the '_as' field
+                // would not exist. We should loop until we have something to return.
                 continue;
             }
+
+            // Since "preserveNullAndEmptyArrays" was specified, output a document even though we
+            // had no result.
+            unwound.setNestedField(_as, Value());
+            if (indexPath) {
+                unwound.setNestedField(*indexPath, Value(BSONNULL));
+            }
         } else {
-            auto it = _visited.begin();
-            unwound.setNestedField(_as, Value(it->second));
+            unwound.setNestedField(_as, Value(std::move(*result)));
             if (indexPath) {
                 unwound.setNestedField(*indexPath, Value(_outputIndex));
-                ++_outputIndex;
             }
-            _visited.erase(it);
+            ++_outputIndex;
         }
 
         return unwound.freeze();
@@ -173,39 +191,106 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::getNextUnwound() {
 
 void DocumentSourceGraphLookUp::doDispose() {
     _cache.clear();
-    _frontier.clear();
-    _visited.clear();
+    finishSearch();
 }
 
-void DocumentSourceGraphLookUp::doBreadthFirstSearch() {
-    long long depth = 0;
-    bool shouldPerformAnotherQuery;
-    do {
-        shouldPerformAnotherQuery = false;
+void DocumentSourceGraphLookUp::startSearch() {
+    // Make sure _input is set before calling startSearch().
+    invariant(_input);
 
-        // Check whether each key in the frontier exists in the cache or needs to be queried.
-        auto cached = pExpCtx->getDocumentComparator().makeUnorderedDocumentSet();
-        auto matchStage = makeMatchStageFromFrontier(&cached);
+    Value startingValue = _startWith->evaluate(*_input, &pExpCtx->variables);
 
-        ValueUnorderedSet queried = pExpCtx->getValueComparator().makeUnorderedValueSet();
-        _frontier.swap(queried);
-        _frontierUsageBytes = 0;
+    // If _startWith evaluates to an array, treat each value as a separate starting point.
+    if (startingValue.isArray()) {
+        for (auto value : startingValue.getArray()) {
+            addToFrontier(value);
+        }
+    } else {
+        addToFrontier(startingValue);
+    }
+
+    _depth = 0;
+    _searchInProgress = true;
+}
+
+void DocumentSourceGraphLookUp::performSearch() {
+    startSearch();
+    while (_searchInProgress) {
+        expandNextLevel();
+    }
+}
 
-        // Process cached values, populating '_frontier' for the next iteration of search.
-        while (!cached.empty()) {
-            auto doc = *cached.begin();
-            cached.erase(cached.begin());
-            shouldPerformAnotherQuery =
-                addToVisitedAndFrontier(std::move(doc), depth) || shouldPerformAnotherQuery;
-            checkMemoryUsage();
+void DocumentSourceGraphLookUp::expandNextLevel() {
+    invariant(_searchInProgress);
+
+    // Take the frontier of this level, so that the nodes found populate that of the next one.
+    ValueUnorderedSet frontier = pExpCtx->getValueComparator().makeUnorderedValueSet();
+    frontier.swap(_frontier);
+    std::vector<RecordId> spilledFrontier;
+    spilledFrontier.swap(_spilledFrontier);
+    _frontierUsageBytes = 0;
+
+    // Look the frontier up in bounded batches rather than with a single query, which for a wide
+    // level could have an $in of millions of values.
+    const size_t batchSize = internalDocumentSourceGraphLookupFrontierBatchSize.load();
+    bool foundNewNodes = false;
+    ValueUnorderedSet batch = pExpCtx->getValueComparator().makeUnorderedValueSet();
+    auto queryBatch = [&] {
+        foundNewNodes = queryFrontierBatch(&batch) || foundNewNodes;
+        batch.clear();
+    };
+
+    for (auto it = frontier.begin(); it != frontier.end();) {
+        batch.insert(*it);
+        frontier.erase(it++);
+        if (batch.size() >= batchSize) {
+            queryBatch();
+        }
+    }
+    for (auto&& recordId : spilledFrontier) {
+        batch.insert(Value(_spillTable->find(pExpCtx->opCtx, recordId)["v"]));
+        if (batch.size() >= batchSize) {
+            queryBatch();
         }
+    }
+    if (!batch.empty()) {
+        queryBatch();
+    }
+
+    ++_depth;
+    _searchInProgress = foundNewNodes && _depth < std::numeric_limits<long long>::max() &&
+        (!_maxDepth || _depth <= *_maxDepth);
+
+    if (!_searchInProgress) {
+        _frontier.clear();
+        _spilledFrontier.clear();
+        _frontierUsageBytes = 0;
+        updateMemoryTracker();
+    }
+}
+
+bool DocumentSourceGraphLookUp::queryFrontierBatch(ValueUnorderedSet* batch) {
+    bool foundNewNodes = false;
+
+    // Check whether each key in the batch exists in the cache or needs to be queried.
+    auto cached = pExpCtx->getDocumentComparator().makeUnorderedDocumentSet();
+    auto matchStage = makeMatchStageFromFrontier(batch, &cached);
+
+    // Process cached values, populating '_frontier' for the next level of search.
+    while (!cached.empty()) {
+        auto doc = *cached.begin();
+        cached.erase(cached.begin());
+        foundNewNodes = addToVisitedAndFrontier(std::move(doc), _depth) || foundNewNodes;
+        checkMemoryUsage();
+    }
 
-        if (matchStage) {
-            // Query for all keys that were in the frontier and not in the cache, populating
-            // '_frontier' for the next iteration of search.
+    if (matchStage) {
+        // Query for all keys that were in the batch and not in the cache, populating '_frontier'
+        // for the next level of search.
 
-            // We've already allocated space for the trailing $match stage in '_fromPipeline'.
-            _fromPipeline.back() = *matchStage;
+        // We've already allocated space for the trailing $match stage in '_fromPipeline'.
+        _fromPipeline.back() = *matchStage;
+        {
             auto pipeline =
                 pExpCtx->mongerProcessInterface->makePipeline(_fromPipeline, _fromExpCtx);
             while (auto next = pipeline->getNext()) {
@@ -216,25 +301,95 @@ void DocumentSourceGraphLookUp::doBreadthFirstSearch() {
                             << "' namespace must contain an _id for de-duplication in $graphLookup",
                         !(*next)["_id"].missing());
 
-                shouldPerformAnotherQuery =
-                    addToVisitedAndFrontier(*next, depth) || shouldPerformAnotherQuery;
-                addToCache(std::move(*next), queried);
+                foundNewNodes = addToVisitedAndFrontier(*next, _depth) || foundNewNodes;
+                addToCache(std::move(*next), *batch);
             }
-            checkMemoryUsage();
         }
 
-        ++depth;
-    } while (shouldPerformAnotherQuery && depth < std::numeric_limits<long long>::max() &&
-             (!_maxDepth || depth <= *_maxDepth));
+        // The query is complete before spilling, so that the spill is not part of its snapshot.
+        checkMemoryUsage();
+    }
+
+    return foundNewNodes;
+}
+
+boost::optional<Document> DocumentSourceGraphLookUp::nextResult() {
+    if (!_visited.empty()) {
+        auto it = _visited.begin();
+        Document result = std::move(it->second);
+        _visitedUsageBytes -= std::min(_visitedUsageBytes, result.getApproximateSize());
+
+        // While the search is still in progress it must recognize this node if it finds it again.
+        // The size of its '_id' remains accounted for.
+        if (_searchInProgress) {
+            _returnedIds.insert(it->first);
+        } else {
+            _visitedUsageBytes -= std::min(_visitedUsageBytes, it->first.getApproximateSize());
+        }
+        _visited.erase(it);
+        return result;
+    }
+
+    if (!_spilledResults.empty()) {
+        auto spilled = _spillTable->find(pExpCtx->opCtx, _spilledResults.front());
+        _spilledResults.pop_front();
+        return Document(spilled["doc"].Obj());
+    }
+
+    return boost::none;
+}
 
+void DocumentSourceGraphLookUp::finishSearch() {
     _frontier.clear();
+    _visited.clear();
+    _returnedIds.clear();
+    _visitedUsageBytes = 0;
     _frontierUsageBytes = 0;
+    _outputUsageBytes = 0;
+    _searchInProgress = false;
+    _input = boost::none;
+
+    if (_spillTable) {
+        _spillTable->dispose(pExpCtx->opCtx);
+        _spillTable.reset();
+    }
+    _spilledIds.clear();
+    _spilledResults.clear();
+    _spilledFrontier.clear();
+
+    updateMemoryTracker();
+}
+
+bool DocumentSourceGraphLookUp::isVisited(const Value& id) {
+    if (_visited.find(id) != _visited.end() || _returnedIds.find(id) != _returnedIds.end()) {
+        return true;
+    }
+
+    // A spilled node is found by the hash of its '_id', which is then compared with the '_id' in
+    // its record in case of a collision.
+    const size_t hash = ValueComparator::kInstance.hash(id);
+    for (auto it = std::lower_bound(
+             _spilledIds.begin(), _spilledIds.end(), std::make_pair(hash, RecordId()));
+         it != _spilledIds.end() && it->first == hash;
+         ++it) {
+        auto spilled = _spillTable->find(pExpCtx->opCtx, it->second);
+        if (ValueComparator::kInstance.evaluate(Value(spilled["_id"]) == id)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DocumentSourceGraphLookUp::addToFrontier(const Value& value) {
+    if (_frontier.insert(value).second) {
+        _frontierUsageBytes += value.getApproximateSize();
+    }
 }
 
 bool DocumentSourceGraphLookUp::addToVisitedAndFrontier(Document result, long long depth) {
     auto id = result.getField("_id");
 
-    if (_visited.find(id) != _visited.end()) {
+    if (isVisited(id)) {
         // We've already seen this object, don't repeat any work.
         return false;
     }
@@ -252,8 +407,7 @@ bool DocumentSourceGraphLookUp::addToVisitedAndFrontier(Document result, long lo
     // '_frontier'.
     document_path_support::visitAllValuesAtPath(
         result, _connectFromField, [this](const Value& nextFrontierValue) {
-            _frontier.insert(nextFrontierValue);
-            _frontierUsageBytes += nextFrontierValue.getApproximateSize();
+            addToFrontier(nextFrontierValue);
         });
 
     // Add the object to our '_visited' list and update the size of '_visited' appropriately.
@@ -282,18 +436,12 @@ void DocumentSourceGraphLookUp::addToCache(const Document& result,
 }
 
 boost::optional<BSONObj> DocumentSourceGraphLookUp::makeMatchStageFromFrontier(
-    DocumentUnorderedSet* cached) {
-    // Add any cached values to 'cached' and remove them from '_frontier'.
-    for (auto it = _frontier.begin(); it != _frontier.end();) {
+    ValueUnorderedSet* frontier, DocumentUnorderedSet* cached) {
+    // Add any cached values to 'cached' and remove them from 'frontier'.
+    for (auto it = frontier->begin(); it != frontier->end();) {
         if (auto entry = _cache[*it]) {
             cached->insert(entry->begin(), entry->end());
-            size_t valueSize = it->getApproximateSize();
-            _frontier.erase(it++);
-
-            // If the cached value increased in size while in the cache, we don't want to underflow
-            // '_frontierUsageBytes'.
-            invariant(valueSize <= _frontierUsageBytes);
-            _frontierUsageBytes -= valueSize;
+            frontier->erase(it++);
         } else {
             ++it;
         }
@@ -318,7 +466,7 @@ boost::optional<BSONObj> DocumentSourceGraphLookUp::makeMatchStageFromFrontier(
                     BSONObjBuilder subObj(connectToObj.subobjStart(_connectToField.fullPath()));
                     {
                         BSONArrayBuilder in(subObj.subarrayStart("$in"));
-                        for (auto&& value : _frontier) {
+                        for (auto&& value : *frontier) {
                             in << value;
                         }
                     }
@@ -327,27 +475,7 @@ boost::optional<BSONObj> DocumentSourceGraphLookUp::makeMatchStageFromFrontier(
         }
     }
 
-    return _frontier.empty() ? boost::none : boost::optional<BSONObj>(match.obj());
-}
-
-void DocumentSourceGraphLookUp::performSearch() {
-    // Make sure _input is set before calling performSearch().
-    invariant(_input);
-
-    Value startingValue = _startWith->evaluate(*_input, &pExpCtx->variables);
-
-    // If _startWith evaluates to an array, treat each value as a separate starting point.
-    if (startingValue.isArray()) {
-        for (auto value : startingValue.getArray()) {
-            _frontier.insert(value);
-            _frontierUsageBytes += value.getApproximateSize();
-        }
-    } else {
-        _frontier.insert(startingValue);
-        _frontierUsageBytes += startingValue.getApproximateSize();
-    }
-
-    doBreadthFirstSearch();
+    return frontier->empty() ? boost::none : boost::optional<BSONObj>(match.obj());
 }
 
 DocumentSource::GetModPathsReturn DocumentSourceGraphLookUp::getModifiedPaths() const {
@@ -381,11 +509,130 @@ Pipeline::SourceContainer::iterator DocumentSourceGraphLookUp::doOptimizeAt(
 }
 
 void DocumentSourceGraphLookUp::checkMemoryUsage() {
-    // TODO SERVER-23980: Implement spilling to disk if allowDiskUse is specified.
+    if (_visitedUsageBytes + _frontierUsageBytes >= _maxMemoryUsageBytes) {
+        spill();
+    }
+    const size_t searchUsageBytes = _visitedUsageBytes + _frontierUsageBytes;
     uassert(40099,
             "$graphLookup reached maximum memory consumption",
-            (_visitedUsageBytes + _frontierUsageBytes) < _maxMemoryUsageBytes);
-    _cache.evictDownTo(_maxMemoryUsageBytes - _frontierUsageBytes - _visitedUsageBytes);
+            searchUsageBytes < _maxMemoryUsageBytes);
+    _cache.evictDownTo(_maxMemoryUsageBytes - searchUsageBytes);
+    updateMemoryTracker();
+
+    // When the operation as a whole is over its budget, the cache is given back first, and then
+    // the search itself if it can spill.
+    if (!_memoryTracker.withinMemoryLimit()) {
+        _cache.clear();
+        updateMemoryTracker();
+    }
+    if (!_memoryTracker.withinMemoryLimit() && spill()) {
+        updateMemoryTracker();
+    }
+    uassert(ErrorCodes::ExceededMemoryLimit,
+            "$graphLookup exceeded the memory limit of the operation",
+            _memoryTracker.withinMemoryLimit());
+}
+
+void DocumentSourceGraphLookUp::updateMemoryTracker() {
+    // The index of spilled nodes stays in memory. It is not subject to '_maxMemoryUsageBytes',
+    // since it cannot be spilled, but does count towards the memory limit of the operation.
+    _memoryTracker.set(_visitedUsageBytes + _frontierUsageBytes + _outputUsageBytes +
+                       _spilledIds.size() * sizeof(decltype(_spilledIds)::value_type) +
+                       _cache.getMemoryUsage());
+}
+
+bool DocumentSourceGraphLookUp::spill() {
+    if (!pExpCtx->allowDiskUse || pExpCtx->inMongers || pExpCtx->inMultiDocumentTransaction) {
+        return false;
+    }
+    if (!_spillTable) {
+        _spillTable = pExpCtx->mongerProcessInterface->makeSpillTable(pExpCtx);
+        if (!_spillTable) {
+            return false;
+        }
+    }
+
+    // Records are written in batches of bounded size rather than all in one storage transaction.
+    const size_t kMaxBatchBytes = BSONObjMaxUserSize;
+    std::vector<BSONObj> batch;
+    size_t batchBytes = 0;
+    auto addToBatch = [&](BSONObj obj) {
+        batchBytes += obj.objsize();
+        batch.push_back(std::move(obj));
+        return batchBytes >= kMaxBatchBytes;
+    };
+    auto writeBatch = [&] {
+        auto recordIds = _spillTable->insert(pExpCtx->opCtx, batch);
+        batch.clear();
+        batchBytes = 0;
+        return recordIds;
+    };
+
+    // Nodes which have not been returned keep their document, while those which have been only
+    // need their '_id' to be recognized if the search finds them again.
+    std::vector<std::pair<size_t, RecordId>> spilledIds;
+    std::vector<size_t> batchHashes;
+    auto writeNodes = [&](bool areResults) {
+        auto recordIds = writeBatch();
+        for (size_t i = 0; i < recordIds.size(); ++i) {
+            spilledIds.emplace_back(batchHashes[i], recordIds[i]);
+            if (areResults) {
+                _spilledResults.push_back(recordIds[i]);
+            }
+        }
+        batchHashes.clear();
+    };
+    for (auto&& node : _visited) {
+        BSONObjBuilder record;
+        node.first.addToBsonObj(&record, "_id");
+        record.append("doc", node.second.toBson());
+        batchHashes.push_back(ValueComparator::kInstance.hash(node.first));
+        if (addToBatch(record.obj())) {
+            writeNodes(true);
+        }
+    }
+    if (!batch.empty()) {
+        writeNodes(true);
+    }
+    for (auto&& id : _returnedIds) {
+        BSONObjBuilder record;
+        id.addToBsonObj(&record, "_id");
+        batchHashes.push_back(ValueComparator::kInstance.hash(id));
+        if (addToBatch(record.obj())) {
+            writeNodes(false);
+        }
+    }
+    if (!batch.empty()) {
+        writeNodes(false);
+    }
+    _visited.clear();
+    _returnedIds.clear();
+    _visitedUsageBytes = 0;
+
+    std::sort(spilledIds.begin(), spilledIds.end());
+    const auto numAlreadySpilled = _spilledIds.size();
+    _spilledIds.insert(_spilledIds.end(), spilledIds.begin(), spilledIds.end());
+    std::inplace_merge(
+        _spilledIds.begin(), _spilledIds.begin() + numAlreadySpilled, _spilledIds.end());
+
+    auto writeFrontier = [&] {
+        auto recordIds = writeBatch();
+        _spilledFrontier.insert(_spilledFrontier.end(), recordIds.begin(), recordIds.end());
+    };
+    for (auto&& value : _frontier) {
+        BSONObjBuilder record;
+        value.addToBsonObj(&record, "v");
+        if (addToBatch(record.obj())) {
+            writeFrontier();
+        }
+    }
+    if (!batch.empty()) {
+        writeFrontier();
+    }
+    _frontier.clear();
+    _frontierUsageBytes = 0;
+
+    return true;
 }
 
 void DocumentSourceGraphLookUp::serializeToArray(
@@ -457,8 +704,10 @@ DocumentSourceGraphLookUp::DocumentSourceGraphLookUp(
       _additionalFilter(additionalFilter),
       _depthField(depthField),
       _maxDepth(maxDepth),
+      _maxMemoryUsageBytes(internalDocumentSourceGraphLookupMaxMemoryBytes.load()),
       _frontier(pExpCtx->getValueComparator().makeUnorderedValueSet()),
       _visited(ValueComparator::kInstance.makeUnorderedValueMap<Document>()),
+      _returnedIds(ValueComparator::kInstance.makeUnorderedValueSet()),
       _cache(pExpCtx->getValueComparator()),
       _unwind(unwindSrc) {
     const auto& resolvedNamespace = pExpCtx->getResolvedNamespace(_from);
@@ -29,10 +29,13 @@
 
 #pragma once
 
+#include <deque>
+
 #include "monger/db/pipeline/document_source.h"
 #include "monger/db/pipeline/document_source_unwind.h"
 #include "monger/db/pipeline/expression.h"
 #include "monger/db/pipeline/lookup_set_cache.h"
+#include "monger/db/pipeline/spill_table.h"
 #include "monger/db/pipeline/value_comparator.h"
 
 namespace monger {
@@ -56,6 +59,10 @@ public:
 
     const char* getSourceName() const final;
 
+    const MemoryUsageTracker* getMemoryTracker() const final {
+        return &_memoryTracker;
+    }
+
     const FieldPath& getConnectFromField() const {
         return _connectFromField;
     }
@@ -158,14 +165,16 @@ private:
 
     /**
      * Prepares the query to execute on the 'from' collection wrapped in a $match by using the
-     * contents of '_frontier'.
+     * contents of 'frontier'.
      *
-     * Fills 'cached' with any values that were retrieved from the cache.
+     * Fills 'cached' with any values that were retrieved from the cache, and removes them from
+     * 'frontier'.
      *
      * Returns boost::none if no query is necessary, i.e., all values were retrieved from the cache.
      * Otherwise, returns a query object.
      */
-    boost::optional<BSONObj> makeMatchStageFromFrontier(DocumentUnorderedSet* cached);
+    boost::optional<BSONObj> makeMatchStageFromFrontier(ValueUnorderedSet* frontier,
+                                                        DocumentUnorderedSet* cached);
 
     /**
      * If we have internalized a $unwind, getNext() dispatches to this function.
@@ -173,18 +182,42 @@ private:
     GetNextResult getNextUnwound();
 
     /**
-     * Perform a breadth-first search of the 'from' collection. '_frontier' should already be
-     * populated with the values for the initial query. Populates '_discovered' with the result(s)
-     * of the query.
+     * Populates '_frontier' with the '_startWith' value(s) from '_input', ready for the first level
+     * of a breadth-first search. Caller should check that _input is not boost::none.
      */
-    void doBreadthFirstSearch();
+    void startSearch();
 
     /**
-     * Populates '_frontier' with the '_startWith' value(s) from '_input' and then performs a
-     * breadth-first search. Caller should check that _input is not boost::none.
+     * Starts a search for '_input' and performs every level of it, populating '_visited' (and, if
+     * the search spilled, '_spilledResults') with the result(s).
      */
     void performSearch();
 
+    /**
+     * Performs the next level of the breadth-first search: looks up the values of '_frontier' in
+     * batches of at most 'internalDocumentSourceGraphLookupFrontierBatchSize', and populates
+     * '_frontier' for the next level with the nodes found. Clears '_searchInProgress' once there is
+     * nothing left to search.
+     */
+    void expandNextLevel();
+
+    /**
+     * Looks up the values of 'batch', one level of the search, in the cache and then the 'from'
+     * collection. Returns whether any node which had not been visited was found.
+     */
+    bool queryFrontierBatch(ValueUnorderedSet* batch);
+
+    /**
+     * Returns the next node found by the search for the current input which has not been returned,
+     * or boost::none if there is none at the moment.
+     */
+    boost::optional<Document> nextResult();
+
+    /**
+     * Releases everything held for the search of the current input.
+     */
+    void finishSearch();
+
     /**
      * Updates '_cache' with 'result' appropriately, given that 'result' was retrieved when querying
      * for 'queried'.
@@ -192,11 +225,34 @@ private:
     void addToCache(const Document& result, const ValueUnorderedSet& queried);
 
     /**
-     * Assert that '_visited' and '_frontier' have not exceeded the maximum meory usage, and then
-     * evict from '_cache' until this source is using less than '_maxMemoryUsageBytes'.
+     * Spills the search to disk if '_visited' and '_frontier' have exceeded the maximum memory
+     * usage, asserts that they no longer do, and then evicts from '_cache' until this source is
+     * using less than '_maxMemoryUsageBytes'.
      */
     void checkMemoryUsage();
 
+    /**
+     * Sets '_memoryTracker' to what is held in memory by this stage.
+     */
+    void updateMemoryTracker();
+
+    /**
+     * Moves the nodes which have been visited and the values of '_frontier' to '_spillTable'.
+     * Returns false, having moved nothing, if this stage cannot spill.
+     */
+    bool spill();
+
+    /**
+     * Returns whether the node with the given '_id' has been visited by the search for the current
+     * input, whether it is still in memory or has been spilled.
+     */
+    bool isVisited(const Value& id);
+
+    /**
+     * Adds 'value' to '_frontier' and accounts for its size.
+     */
+    void addToFrontier(const Value& value);
+
     /**
      * Process 'result', adding it to '_visited' with the given 'depth', and updating '_frontier'
      * with the object's 'connectTo' values.
@@ -222,26 +278,60 @@ private:
     // The aggregation pipeline to perform against the '_from' namespace.
     std::vector<BSONObj> _fromPipeline;
 
-    size_t _maxMemoryUsageBytes = 100 * 1024 * 1024;
+    size_t _maxMemoryUsageBytes;
 
-    // Track memory usage to ensure we don't exceed '_maxMemoryUsageBytes'.
+    // Track memory usage to ensure we don't exceed '_maxMemoryUsageBytes'. '_visitedUsageBytes'
+    // covers both '_visited' and '_returnedIds'.
     size_t _visitedUsageBytes = 0;
     size_t _frontierUsageBytes = 0;
 
-    // Only used during the breadth-first search, tracks the set of values on the current frontier.
+    // The size of the results gathered into the '_as' array by getNext(), which are held in memory
+    // even if the search was spilled.
+    size_t _outputUsageBytes = 0;
+
+    // Charged with the sum of '_visitedUsageBytes', '_frontierUsageBytes', '_outputUsageBytes',
+    // the size of '_spilledIds' and the size of '_cache'.
+    MemoryUsageTracker _memoryTracker{pExpCtx->memoryTracker.get()};
+
+    // Only used during the breadth-first search, tracks the set of values on the frontier of the
+    // next level.
     ValueUnorderedSet _frontier;
 
-    // Tracks nodes that have been discovered for a given input. Keys are the '_id' value of the
-    // document from the foreign collection, value is the document itself.  The keys are compared
-    // using the simple collation.
+    // Tracks nodes that have been discovered for a given input and not yet returned. Keys are the
+    // '_id' value of the document from the foreign collection, value is the document itself. The
+    // keys are compared using the simple collation.
     ValueUnorderedMap<Document> _visited;
 
+    // The '_id's of nodes which were returned while the search for the current input was still in
+    // progress, which it must not find again. Compared using the simple collation.
+    ValueUnorderedSet _returnedIds;
+
+    // The depth of the next level of the search for the current input, and whether there is one.
+    long long _depth = 0;
+    bool _searchInProgress = false;
+
+    // Created once the search for an input no longer fits in memory, if disk use is allowed. It is
+    // dropped when that search finishes.
+    std::unique_ptr<SpillTable> _spillTable;
+
+    // Every node visited by the search for the current input which was spilled, as the hash of its
+    // '_id' and the record holding it, sorted by hash. The records are {_id: <_id>} for nodes which
+    // have been returned, and {_id: <_id>, doc: <document>} for the others.
+    std::vector<std::pair<size_t, RecordId>> _spilledIds;
+
+    // The records of the nodes in '_spilledIds' which have not been returned.
+    std::deque<RecordId> _spilledResults;
+
+    // Records of the form {v: <value>} holding the values of the frontier of the next level which
+    // were spilled.
+    std::vector<RecordId> _spilledFrontier;
+
     // Caches query results to avoid repeating any work. This structure is maintained across calls
     // to getNext().
     LookupSetCache _cache;
 
-    // When we have internalized a $unwind, we must keep track of the input document, since we will
-    // need it for multiple "getNext()" calls.
+    // The input document whose search is in progress or whose results are being returned. When we
+    // have internalized a $unwind, we will need it for multiple "getNext()" calls.
     boost::optional<Document> _input;
 
     // Keep track of a $unwind that was absorbed into this stage.
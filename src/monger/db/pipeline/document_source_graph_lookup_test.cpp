@@ -31,6 +31,7 @@
 
 #include <algorithm>
 #include <deque>
+#include <set>
 
 #include "monger/db/pipeline/aggregation_context_fixture.h"
 #include "monger/db/pipeline/document.h"
@@ -38,8 +39,10 @@
 #include "monger/db/pipeline/document_source_mock.h"
 #include "monger/db/pipeline/document_value_test_util.h"
 #include "monger/db/pipeline/stub_monger_process_interface.h"
+#include "monger/db/query/query_knobs_gen.h"
 #include "monger/unittest/unittest.h"
 #include "monger/util/assert_util.h"
+#include "monger/util/scopeguard.h"
 #include "monger/util/str.h"
 
 namespace monger {
@@ -53,9 +56,35 @@ using DocumentSourceGraphLookUpTest = AggregationContextFixture;
 // Evaluation.
 //
 
+/**
+ * A SpillTable which keeps its records in memory.
+ */
+class InMemorySpillTable final : public SpillTable {
+public:
+    std::vector<RecordId> insert(OperationContext* opCtx, const std::vector<BSONObj>& objs) final {
+        std::vector<RecordId> ids;
+        for (auto&& obj : objs) {
+            _records.push_back(obj.getOwned());
+            ids.emplace_back(static_cast<int64_t>(_records.size()));
+        }
+        return ids;
+    }
+
+    BSONObj find(OperationContext* opCtx, const RecordId& id) final {
+        return _records[id.repr() - 1];
+    }
+
+    void dispose(OperationContext* opCtx) final {
+        _records.clear();
+    }
+
+private:
+    std::vector<BSONObj> _records;
+};
+
 /**
  * A MongerProcessInterface use for testing that supports making pipelines with an initial
- * DocumentSourceMock source.
+ * DocumentSourceMock source, and spilling to tables in memory.
  */
 class MockMongerInterface final : public StubMongerProcessInterface {
 public:
@@ -66,6 +95,7 @@ public:
         const std::vector<BSONObj>& rawPipeline,
         const boost::intrusive_ptr<ExpressionContext>& expCtx,
         const MakePipelineOptions opts) final {
+        ++_numPipelines;
         auto pipeline = uassertStatusOK(Pipeline::parse(rawPipeline, expCtx));
 
         if (opts.optimize) {
@@ -87,10 +117,38 @@ public:
         return pipeline;
     }
 
+    std::unique_ptr<SpillTable> makeSpillTable(
+        const boost::intrusive_ptr<ExpressionContext>& expCtx) const final {
+        ++_numSpillTables;
+        return std::make_unique<InMemorySpillTable>();
+    }
+
+    int numPipelines() const {
+        return _numPipelines;
+    }
+
+    int numSpillTables() const {
+        return _numSpillTables;
+    }
+
 private:
     std::deque<DocumentSource::GetNextResult> _results;
+    int _numPipelines = 0;
+    mutable int _numSpillTables = 0;
 };
 
+/**
+ * Returns the contents of a 'from' collection in which each of the nodes 0 to 'numNodes' - 1
+ * connects to the next one, and the last connects back to the first.
+ */
+std::deque<DocumentSource::GetNextResult> makeCycle(int numNodes) {
+    std::deque<DocumentSource::GetNextResult> nodes;
+    for (int i = 0; i < numNodes; ++i) {
+        nodes.push_back(Document{{"_id", i}, {"to", i}, {"from", (i + 1) % numNodes}});
+    }
+    return nodes;
+}
+
 TEST_F(DocumentSourceGraphLookUpTest,
        ShouldErrorWhenDoingInitialMatchIfDocumentInFromCollectionIsMissingId) {
     auto expCtx = getExpCtx();
@@ -161,7 +219,10 @@ TEST_F(DocumentSourceGraphLookUpTest,
     expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
         {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
     expCtx->mongerProcessInterface = std::make_shared<MockMongerInterface>(std::move(fromContents));
-    auto unwindStage = DocumentSourceUnwind::create(expCtx, "results", false, boost::none);
+    const bool preserveNullAndEmptyArrays = false;
+    const boost::optional<std::string> includeArrayIndex = boost::none;
+    auto unwindStage = DocumentSourceUnwind::create(
+        expCtx, "results", preserveNullAndEmptyArrays, includeArrayIndex);
     auto graphLookupStage =
         DocumentSourceGraphLookUp::create(expCtx,
                                           fromNs,
@@ -628,5 +689,194 @@ TEST_F(DocumentSourceGraphLookUpTest, ShouldNotExpandArraysWithinArraysAtEndOfCo
     ASSERT(graphLookupStage->getNext().isEOF());
 }
 
+TEST_F(DocumentSourceGraphLookUpTest, ShouldLookUpFrontierInBatches) {
+    internalDocumentSourceGraphLookupFrontierBatchSize.store(2);
+    ON_BLOCK_EXIT([] { internalDocumentSourceGraphLookupFrontierBatchSize.store(1000); });
+
+    auto expCtx = getExpCtx();
+    auto inputMock = DocumentSourceMock::createForTest(Document{{"startPoint", 0}});
+
+    // The second level of the search has a frontier of three values.
+    std::deque<DocumentSource::GetNextResult> fromContents{
+        Document{{"_id", 0}, {"to", 0}, {"from", std::vector<Value>{Value(1), Value(2), Value(3)}}},
+        Document{{"_id", 1}, {"to", 1}},
+        Document{{"_id", 2}, {"to", 2}},
+        Document{{"_id", 3}, {"to", 3}}};
+
+    NamespaceString fromNs("test", "graph_lookup");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+    auto mongerInterface = std::make_shared<MockMongerInterface>(std::move(fromContents));
+    expCtx->mongerProcessInterface = mongerInterface;
+    auto graphLookupStage =
+        DocumentSourceGraphLookUp::create(expCtx,
+                                          fromNs,
+                                          "results",
+                                          "from",
+                                          "to",
+                                          ExpressionFieldPath::create(expCtx, "startPoint"),
+                                          boost::none,
+                                          boost::none,
+                                          boost::none,
+                                          boost::none);
+    graphLookupStage->setSource(inputMock.get());
+
+    auto next = graphLookupStage->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_EQ(next.getDocument().getField("results").getArrayLength(), 4U);
+    ASSERT_TRUE(graphLookupStage->getNext().isEOF());
+
+    // One query for the first level, and two for the second.
+    ASSERT_EQ(mongerInterface->numPipelines(), 3);
+}
+
+TEST_F(DocumentSourceGraphLookUpTest, ShouldSpillSearchWhenOverMemoryLimitIfDiskUseIsAllowed) {
+    internalDocumentSourceGraphLookupMaxMemoryBytes.store(1);
+    ON_BLOCK_EXIT(
+        [] { internalDocumentSourceGraphLookupMaxMemoryBytes.store(100 * 1024 * 1024); });
+
+    auto expCtx = getExpCtx();
+    expCtx->allowDiskUse = true;
+    auto inputMock = DocumentSourceMock::createForTest(Document{{"startPoint", 0}});
+
+    NamespaceString fromNs("test", "graph_lookup");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+    auto mongerInterface = std::make_shared<MockMongerInterface>(makeCycle(10));
+    expCtx->mongerProcessInterface = mongerInterface;
+
+    // The results are unwound, since an '_as' array over the memory limit could not be returned.
+    const bool preserveNullAndEmptyArrays = false;
+    const boost::optional<std::string> includeArrayIndex = boost::none;
+    auto unwindStage = DocumentSourceUnwind::create(
+        expCtx, "results", preserveNullAndEmptyArrays, includeArrayIndex);
+    auto graphLookupStage =
+        DocumentSourceGraphLookUp::create(expCtx,
+                                          fromNs,
+                                          "results",
+                                          "from",
+                                          "to",
+                                          ExpressionFieldPath::create(expCtx, "startPoint"),
+                                          boost::none,
+                                          boost::none,
+                                          boost::none,
+                                          unwindStage);
+    graphLookupStage->setSource(inputMock.get());
+
+    // Every node is returned once, even though the search finds the first one again once it had
+    // been spilled.
+    std::set<int> ids;
+    for (auto next = graphLookupStage->getNext(); next.isAdvanced();
+         next = graphLookupStage->getNext()) {
+        ASSERT_TRUE(ids.insert(next.getDocument().getNestedField("results._id").getInt()).second);
+    }
+    ASSERT_EQ(ids.size(), 10U);
+    ASSERT_EQ(mongerInterface->numSpillTables(), 1);
+}
+
+TEST_F(DocumentSourceGraphLookUpTest, ShouldFailWhenResultsArrayIsOverMemoryLimitEvenIfSpilled) {
+    internalDocumentSourceGraphLookupMaxMemoryBytes.store(1);
+    ON_BLOCK_EXIT(
+        [] { internalDocumentSourceGraphLookupMaxMemoryBytes.store(100 * 1024 * 1024); });
+
+    auto expCtx = getExpCtx();
+    expCtx->allowDiskUse = true;
+    auto inputMock = DocumentSourceMock::createForTest(Document{{"startPoint", 0}});
+
+    NamespaceString fromNs("test", "graph_lookup");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+    auto mongerInterface = std::make_shared<MockMongerInterface>(makeCycle(10));
+    expCtx->mongerProcessInterface = mongerInterface;
+    auto graphLookupStage =
+        DocumentSourceGraphLookUp::create(expCtx,
+                                          fromNs,
+                                          "results",
+                                          "from",
+                                          "to",
+                                          ExpressionFieldPath::create(expCtx, "startPoint"),
+                                          boost::none,
+                                          boost::none,
+                                          boost::none,
+                                          boost::none);
+    graphLookupStage->setSource(inputMock.get());
+
+    // The search itself fits in memory by spilling, but the array of its results cannot.
+    ASSERT_THROWS_CODE(graphLookupStage->getNext(), AssertionException, 40099);
+    ASSERT_EQ(mongerInterface->numSpillTables(), 1);
+}
+
+TEST_F(DocumentSourceGraphLookUpTest, ShouldFailWhenOverMemoryLimitIfDiskUseIsNotAllowed) {
+    internalDocumentSourceGraphLookupMaxMemoryBytes.store(1);
+    ON_BLOCK_EXIT(
+        [] { internalDocumentSourceGraphLookupMaxMemoryBytes.store(100 * 1024 * 1024); });
+
+    auto expCtx = getExpCtx();
+    auto inputMock = DocumentSourceMock::createForTest(Document{{"startPoint", 0}});
+
+    NamespaceString fromNs("test", "graph_lookup");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+    expCtx->mongerProcessInterface = std::make_shared<MockMongerInterface>(makeCycle(10));
+    auto graphLookupStage =
+        DocumentSourceGraphLookUp::create(expCtx,
+                                          fromNs,
+                                          "results",
+                                          "from",
+                                          "to",
+                                          ExpressionFieldPath::create(expCtx, "startPoint"),
+                                          boost::none,
+                                          boost::none,
+                                          boost::none,
+                                          boost::none);
+    graphLookupStage->setSource(inputMock.get());
+
+    ASSERT_THROWS_CODE(graphLookupStage->getNext(), AssertionException, 40099);
+}
+
+TEST_F(DocumentSourceGraphLookUpTest, ShouldReturnUnwoundResultsOneLevelAtATime) {
+    internalDocumentSourceGraphLookupMaxMemoryBytes.store(1);
+    ON_BLOCK_EXIT(
+        [] { internalDocumentSourceGraphLookupMaxMemoryBytes.store(100 * 1024 * 1024); });
+
+    auto expCtx = getExpCtx();
+    expCtx->allowDiskUse = true;
+    auto inputMock = DocumentSourceMock::createForTest(Document{{"startPoint", 0}});
+
+    NamespaceString fromNs("test", "graph_lookup");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+    auto mongerInterface = std::make_shared<MockMongerInterface>(makeCycle(5));
+    expCtx->mongerProcessInterface = mongerInterface;
+
+    const bool preserveNullAndEmptyArrays = false;
+    const boost::optional<std::string> includeArrayIndex = boost::none;
+    auto unwindStage = DocumentSourceUnwind::create(
+        expCtx, "results", preserveNullAndEmptyArrays, includeArrayIndex);
+    auto graphLookupStage =
+        DocumentSourceGraphLookUp::create(expCtx,
+                                          fromNs,
+                                          "results",
+                                          "from",
+                                          "to",
+                                          ExpressionFieldPath::create(expCtx, "startPoint"),
+                                          boost::none,
+                                          FieldPath("depth"),
+                                          boost::none,
+                                          unwindStage);
+    graphLookupStage->setSource(inputMock.get());
+
+    // Each node is returned before the next level is searched, and the first node is not returned
+    // again when the last one connects back to it.
+    for (int depth = 0; depth < 5; ++depth) {
+        auto next = graphLookupStage->getNext();
+        ASSERT_TRUE(next.isAdvanced());
+        ASSERT_EQ(mongerInterface->numPipelines(), depth + 1);
+        ASSERT_VALUE_EQ(next.getDocument().getNestedField("results.depth"),
+                        Value(static_cast<long long>(depth)));
+    }
+    ASSERT_TRUE(graphLookupStage->getNext().isEOF());
+}
+
 }  // namespace
 }  // namespace monger
@@ -29,8 +29,11 @@
 
 #include "monger/platform/basic.h"
 
+#include <algorithm>
 #include <boost/filesystem/operations.hpp>
 #include <memory>
+#include <numeric>
+#include <set>
 
 #include "monger/db/jsobj.h"
 #include "monger/db/pipeline/accumulation_statement.h"
@@ -42,6 +45,7 @@
 #include "monger/db/pipeline/lite_parsed_document_source.h"
 #include "monger/db/pipeline/value.h"
 #include "monger/db/pipeline/value_comparator.h"
+#include "monger/db/query/query_knobs_gen.h"
 #include "monger/util/destructor_guard.h"
 
 namespace monger {
@@ -62,6 +66,26 @@ std::string nextFileName() {
     return "extsort-doc-group." + std::to_string(documentSourceGroupFileCounter.fetchAndAdd(1));
 }
 
+Value evaluateExpression(const Expression& expr,
+                         const CompiledExpression* compiled,
+                         const Document& root,
+                         Variables* variables) {
+    return compiled ? compiled->evaluate(root, variables) : expr.evaluate(root, variables);
+}
+
+/**
+ * Mixes the bits of a hash of a group key, which '_groups' also uses to choose a bucket, so that
+ * every group of bits can select a partition independently of the others.
+ */
+uint64_t mixHash(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
 }  // namespace
 
 using boost::intrusive_ptr;
@@ -135,6 +159,16 @@ const char* DocumentSourceGroup::getSourceName() const {
 DocumentSource::GetNextResult DocumentSourceGroup::getNext() {
     pExpCtx->checkForInterrupt();
 
+    if (!_expressionsCompiled) {
+        // Nothing has been consumed yet, so this is also when to choose how to consume the input.
+        compileExpressions();
+        _streaming = canStreamInput();
+    }
+
+    if (_streaming) {
+        return getNextStreaming();
+    }
+
     if (!_initialized) {
         const auto initializationResult = initialize();
         if (initializationResult.isPaused()) {
@@ -143,68 +177,102 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNext() {
         invariant(initializationResult.isEOF());
     }
 
-    for (auto&& accum : _currentAccumulators) {
-        accum->reset();  // Prep accumulators for a new group.
-    }
+    return getNextStandard();
+}
 
-    if (_spilled) {
-        return getNextSpilled();
-    } else {
-        return getNextStandard();
+DocumentSource::GetNextResult DocumentSourceGroup::getNextStandard() {
+    // Not streaming. Each spilled partition is only read back once every group in memory has been
+    // returned.
+    while (groupsIterator == _groups->end()) {
+        if (_pendingPartitions.empty()) {
+            dispose();
+            return GetNextResult::makeEOF();
+        }
+        readSpilledPartition();
     }
+
+    Document out = makeDocument(groupsIterator->first, groupsIterator->second, pExpCtx->needsMerge);
+    ++groupsIterator;
+    return std::move(out);
 }
 
-DocumentSource::GetNextResult DocumentSourceGroup::getNextSpilled() {
-    // We aren't streaming, and we have spilled to disk.
-    if (!_sorterIterator)
-        return GetNextResult::makeEOF();
+DocumentSource::GetNextResult DocumentSourceGroup::getNextStreaming() {
+    GetNextResult input = pSource->getNext();
+    for (; input.isAdvanced(); input = pSource->getNext()) {
+        auto rootDocument = input.releaseDocument();
+        Value id = computeId(rootDocument);
+        if (!isAdjacentInSortedInput(id)) {
+            addToGroups(id, rootDocument);
+            continue;
+        }
 
-    _currentId = _firstPartOfNextGroup.first;
-    const size_t numAccumulators = _accumulatedFields.size();
-    while (pExpCtx->getValueComparator().evaluate(_currentId == _firstPartOfNextGroup.first)) {
-        // Inside of this loop, _firstPartOfNextGroup is the current data being processed.
-        // At loop exit, it is the first value to be processed in the next group.
-        switch (numAccumulators) {  // mirrors switch in spill()
-            case 1:                 // Single accumulators serialize as a single Value.
-                _currentAccumulators[0]->process(_firstPartOfNextGroup.second, true);
-            case 0:  // No accumulators so no Values.
-                break;
-            default: {  // Multiple accumulators serialize as an array of Values.
-                const vector<Value>& accumulatorStates = _firstPartOfNextGroup.second.getArray();
-                for (size_t i = 0; i < numAccumulators; i++) {
-                    _currentAccumulators[i]->process(accumulatorStates[i], true);
+        boost::optional<Document> out;
+        if (_currentGroupId && pExpCtx->getValueComparator().evaluate(*_currentGroupId != id)) {
+            out = makeDocument(*_currentGroupId, _currentGroup, pExpCtx->needsMerge);
+            _currentGroupId = boost::none;
+            _memoryTracker.add(-_currentGroupBytes);
+            _currentGroupBytes = 0;
+        }
+
+        if (!_currentGroupId) {
+            _currentGroupId = std::move(id);
+            if (_currentGroup.empty()) {
+                for (auto&& accumulatedField : _accumulatedFields) {
+                    _currentGroup.push_back(accumulatedField.makeAccumulator(pExpCtx));
+                }
+            } else {
+                for (auto&& accum : _currentGroup) {
+                    accum->reset();
                 }
             }
         }
+        accumulate(rootDocument, _currentGroup);
 
-        if (!_sorterIterator->more()) {
-            dispose();
-            break;
+        long long currentGroupBytes = _currentGroupId->getApproximateSize();
+        for (auto&& accum : _currentGroup) {
+            currentGroupBytes += accum->memUsageForSorter();
         }
+        _memoryTracker.add(currentGroupBytes - _currentGroupBytes);
+        _currentGroupBytes = currentGroupBytes;
 
-        _firstPartOfNextGroup = _sorterIterator->next();
+        if (out) {
+            return std::move(*out);
+        }
     }
 
-    return makeDocument(_currentId, _currentAccumulators, pExpCtx->needsMerge);
-}
-
-DocumentSource::GetNextResult DocumentSourceGroup::getNextStandard() {
-    // Not spilled, and not streaming.
-    if (_groups->empty())
-        return GetNextResult::makeEOF();
-
-    Document out = makeDocument(groupsIterator->first, groupsIterator->second, pExpCtx->needsMerge);
-
-    if (++groupsIterator == _groups->end())
-        dispose();
+    if (input.isPaused()) {
+        return input;
+    }
+    invariant(input.isEOF());
 
-    return std::move(out);
+    // Whatever was aggregated into '_groups' is returned after the last streamed group.
+    if (!_spilledPartitions.empty()) {
+        finishSpilling(0, &_spilledPartitions);
+    }
+    groupsIterator = _groups->begin();
+    _streaming = false;
+    _initialized = true;
+
+    if (_currentGroupId) {
+        Document out = makeDocument(*_currentGroupId, _currentGroup, pExpCtx->needsMerge);
+        _currentGroupId = boost::none;
+        _currentGroup.clear();
+        _memoryTracker.add(-_currentGroupBytes);
+        _currentGroupBytes = 0;
+        return std::move(out);
+    }
+    return getNextStandard();
 }
 
 void DocumentSourceGroup::doDispose() {
     // Free our resources.
     _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
-    _sorterIterator.reset();
+    _currentGroupId = boost::none;
+    _currentGroup.clear();
+    _currentGroupBytes = 0;
+    _spilledPartitions.clear();
+    _pendingPartitions.clear();
+    _memoryTracker.set(0);
 
     // Make us look done.
     groupsIterator = _groups->end();
@@ -333,9 +401,10 @@ DocumentSourceGroup::DocumentSourceGroup(const intrusive_ptr<ExpressionContext>&
       _doingMerge(false),
       _maxMemoryUsageBytes(maxMemoryUsageBytes ? *maxMemoryUsageBytes
                                                : internalDocumentSourceGroupMaxMemoryBytes.load()),
+      _memoryTracker(pExpCtx->memoryTracker.get(), _maxMemoryUsageBytes),
       _initialized(false),
       _groups(pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>()),
-      _spilled(false),
+      groupsIterator(_groups->end()),
       _allowDiskUse(pExpCtx->allowDiskUse && !pExpCtx->inMongers) {
     if (!pExpCtx->inMongers && (pExpCtx->allowDiskUse || kDebugBuild)) {
         // We spill to disk in debug mode, regardless of allowDiskUse, to stress the system.
@@ -344,7 +413,7 @@ DocumentSourceGroup::DocumentSourceGroup(const intrusive_ptr<ExpressionContext>&
 }
 
 DocumentSourceGroup::~DocumentSourceGroup() {
-    if (_ownsFileDeletion) {
+    if (!_fileName.empty()) {
         DESTRUCTOR_GUARD(boost::filesystem::remove(_fileName));
     }
 }
@@ -436,98 +505,24 @@ intrusive_ptr<DocumentSource> DocumentSourceGroup::createFromBson(
     return pGroup;
 }
 
-namespace {
-
-using GroupsMap = DocumentSourceGroup::GroupsMap;
-
-class SorterComparator {
-public:
-    typedef pair<Value, Value> Data;
-
-    SorterComparator(ValueComparator valueComparator) : _valueComparator(valueComparator) {}
-
-    int operator()(const Data& lhs, const Data& rhs) const {
-        return _valueComparator.compare(lhs.first, rhs.first);
-    }
-
-private:
-    ValueComparator _valueComparator;
-};
-
-class SpillSTLComparator {
-public:
-    SpillSTLComparator(ValueComparator valueComparator) : _valueComparator(valueComparator) {}
-
-    bool operator()(const GroupsMap::value_type* lhs, const GroupsMap::value_type* rhs) const {
-        return _valueComparator.evaluate(lhs->first < rhs->first);
-    }
-
-private:
-    ValueComparator _valueComparator;
-};
-}  // namespace
-
 DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
-    const size_t numAccumulators = _accumulatedFields.size();
-
     // Barring any pausing, this loop exhausts 'pSource' and populates '_groups'.
     GetNextResult input = pSource->getNext();
     for (; input.isAdvanced(); input = pSource->getNext()) {
-        if (_memoryUsageBytes > _maxMemoryUsageBytes) {
-            uassert(16945,
-                    "Exceeded memory limit for $group, but didn't allow external sort."
-                    " Pass allowDiskUse:true to opt in.",
-                    _allowDiskUse);
-            _sortedFiles.push_back(spill());
-            _memoryUsageBytes = 0;
-        }
-
         // We release the result document here so that it does not outlive the end of this loop
         // iteration. Not releasing could lead to an array copy when this group follows an unwind.
         auto rootDocument = input.releaseDocument();
-        Value id = computeId(rootDocument);
-
-        // Look for the _id value in the map. If it's not there, add a new entry with a blank
-        // accumulator. This is done in a somewhat odd way in order to avoid hashing 'id' and
-        // looking it up in '_groups' multiple times.
-        const size_t oldSize = _groups->size();
-        vector<intrusive_ptr<Accumulator>>& group = (*_groups)[id];
-        const bool inserted = _groups->size() != oldSize;
-
-        if (inserted) {
-            _memoryUsageBytes += id.getApproximateSize();
-
-            // Add the accumulators
-            group.reserve(numAccumulators);
-            for (auto&& accumulatedField : _accumulatedFields) {
-                group.push_back(accumulatedField.makeAccumulator(pExpCtx));
-            }
-        } else {
-            for (auto&& groupObj : group) {
-                // subtract old mem usage. New usage added back after processing.
-                _memoryUsageBytes -= groupObj->memUsageForSorter();
-            }
-        }
-
-        /* tickle all the accumulators for the group we found */
-        dassert(numAccumulators == group.size());
-
-        for (size_t i = 0; i < numAccumulators; i++) {
-            group[i]->process(
-                _accumulatedFields[i].expression->evaluate(rootDocument, &pExpCtx->variables),
-                _doingMerge);
-
-            _memoryUsageBytes += group[i]->memUsageForSorter();
-        }
+        const bool inserted = addToGroups(computeId(rootDocument), rootDocument);
 
         if (kDebugBuild && !storageGlobalParams.readOnly) {
             // In debug mode, spill every time we have a duplicate id to stress merge logic.
-            if (!inserted &&                 // is a dup
-                !pExpCtx->inMongers &&        // can't spill to disk in mongers
-                !_allowDiskUse &&            // don't change behavior when testing external sort
-                _sortedFiles.size() < 20) {  // don't open too many FDs
+            if (!inserted &&              // is a dup
+                !pExpCtx->inMongers &&     // can't spill to disk in mongers
+                !_allowDiskUse &&         // don't change behavior when testing external sort
+                _numDebugSpills < 20) {  // don't open too many FDs
 
-                _sortedFiles.push_back(spill());
+                ++_numDebugSpills;
+                spillGroups(0, &_spilledPartitions, SpillPolicy::kAll);
             }
         }
     }
@@ -540,36 +535,15 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
             return input;  // Propagate pause.
         }
         case DocumentSource::GetNextResult::ReturnStatus::kEOF: {
-            // Do any final steps necessary to prepare to output results.
-            if (!_sortedFiles.empty()) {
-                _spilled = true;
-                if (!_groups->empty()) {
-                    _sortedFiles.push_back(spill());
-                }
-
-                // We won't be using groups again so free its memory.
-                _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
-
-                _sorterIterator.reset(Sorter<Value, Value>::Iterator::merge(
-                    _sortedFiles,
-                    _fileName,
-                    SortOptions(),
-                    SorterComparator(pExpCtx->getValueComparator())));
-                _ownsFileDeletion = false;
-
-                // prepare current to accumulate data
-                _currentAccumulators.reserve(numAccumulators);
-                for (auto&& accumulatedField : _accumulatedFields) {
-                    _currentAccumulators.push_back(accumulatedField.makeAccumulator(pExpCtx));
-                }
-
-                verify(_sorterIterator->more());  // we put data in, we should get something out.
-                _firstPartOfNextGroup = _sorterIterator->next();
-            } else {
-                // start the group iterator
-                groupsIterator = _groups->begin();
+            // Do any final steps necessary to prepare to output results. The groups left in
+            // memory of partitions which were never spilled are complete, and are returned first.
+            if (!_spilledPartitions.empty()) {
+                finishSpilling(0, &_spilledPartitions);
             }
 
+            // start the group iterator
+            groupsIterator = _groups->begin();
+
             // This must happen last so that, unless control gets here, we will re-enter
             // initialization after getting a GetNextResult::ResultState::kPauseExecution.
             _initialized = true;
@@ -583,54 +557,317 @@ bool DocumentSourceGroup::usedDisk() {
     return _usedDisk;
 }
 
-shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
-    _usedDisk = true;
-    vector<const GroupsMap::value_type*> ptrs;  // using pointers to speed sorting
-    ptrs.reserve(_groups->size());
-    for (GroupsMap::const_iterator it = _groups->begin(), end = _groups->end(); it != end; ++it) {
-        ptrs.push_back(&*it);
+bool DocumentSourceGroup::canStreamInput() const {
+    if (!pSource || !internalDocumentSourceGroupEnableStreaming.load()) {
+        return false;
     }
 
-    stable_sort(ptrs.begin(), ptrs.end(), SpillSTLComparator(pExpCtx->getValueComparator()));
+    // Only field paths into the input document, and constants, are known to be equal wherever
+    // the fields which the input is sorted on are.
+    std::set<std::string> groupFields;
+    for (auto&& idExpression : _idExpressions) {
+        if (dynamic_cast<ExpressionConstant*>(idExpression.get())) {
+            continue;
+        }
+        auto fieldPath = dynamic_cast<ExpressionFieldPath*>(idExpression.get());
+        if (!fieldPath || !fieldPath->isRootFieldPath() ||
+            fieldPath->getFieldPath().getPathLength() < 2) {
+            return false;
+        }
+        groupFields.insert(fieldPath->getFieldPathWithoutCurrentPrefix().fullPath());
+    }
 
-    SortedFileWriter<Value, Value> writer(
-        SortOptions().TempDir(pExpCtx->tempDir), _fileName, _nextSortedFileWriterOffset);
-    switch (_accumulatedFields.size()) {  // same as ptrs[i]->second.size() for all i.
-        case 0:                           // no values, essentially a distinct
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first, Value());
+    if (groupFields.empty()) {
+        return false;
+    }
+
+    // Input sorted on {a: 1, b: 1, c: 1} has the documents with equal values of 'a' and 'b'
+    // adjacent, whichever order the group key lists them in.
+    for (auto&& sort : pSource->getOutputSorts()) {
+        std::set<std::string> sortPrefix;
+        BSONObjIterator it(sort);
+        while (it.more() && sortPrefix.size() < groupFields.size()) {
+            sortPrefix.insert(it.next().fieldName());
+        }
+        if (sortPrefix == groupFields) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DocumentSourceGroup::isAdjacentInSortedInput(const Value& id) const {
+    auto isAdjacent = [](const Value& value) {
+        return !value.nullish() && value.getType() != BSONType::Array;
+    };
+
+    // With more than one _id expression, the key is the array of their values.
+    if (_idExpressions.size() == 1) {
+        return isAdjacent(id);
+    }
+    const auto& values = id.getArray();
+    return std::all_of(values.begin(), values.end(), isAdjacent);
+}
+
+DocumentSourceGroup::Accumulators& DocumentSourceGroup::lookUpGroup(const Value& id,
+                                                                   bool* inserted) {
+    // Look for the _id value in the map. If it's not there, add a new entry with a blank
+    // accumulator. This is done in a somewhat odd way in order to avoid hashing 'id' and
+    // looking it up in '_groups' multiple times.
+    const size_t oldSize = _groups->size();
+    Accumulators& group = (*_groups)[id];
+    *inserted = _groups->size() != oldSize;
+
+    if (*inserted) {
+        _memoryTracker.add(id.getApproximateSize());
+
+        // Add the accumulators
+        group.reserve(_accumulatedFields.size());
+        for (auto&& accumulatedField : _accumulatedFields) {
+            group.push_back(accumulatedField.makeAccumulator(pExpCtx));
+        }
+    } else {
+        for (auto&& groupObj : group) {
+            // subtract old mem usage. New usage added back after processing.
+            _memoryTracker.add(-groupObj->memUsageForSorter());
+        }
+    }
+
+    return group;
+}
+
+bool DocumentSourceGroup::addToGroups(const Value& id, const Document& root) {
+    // Once other stages alone are over the operation's budget, spilling the groups would not help,
+    // so only the limit of this stage applies.
+    if (_memoryTracker.shouldReleaseMemory()) {
+        uassert(16945,
+                "Exceeded memory limit for $group, but didn't allow external sort."
+                " Pass allowDiskUse:true to opt in.",
+                _allowDiskUse);
+        spillGroups(0, &_spilledPartitions, SpillPolicy::kUntilHalfEmpty);
+    }
+
+    bool inserted;
+    Accumulators& group = lookUpGroup(id, &inserted);
+    accumulate(root, group);
+    for (auto&& accum : group) {
+        _memoryTracker.add(accum->memUsageForSorter());
+    }
+    return inserted;
+}
+
+void DocumentSourceGroup::accumulate(const Document& root, const Accumulators& group) {
+    const size_t numAccumulators = _accumulatedFields.size();
+    dassert(numAccumulators == group.size());
+
+    for (size_t i = 0; i < numAccumulators; i++) {
+        group[i]->process(evaluateExpression(*_accumulatedFields[i].expression,
+                                             _compiledAccumulatorArgs[i].get(),
+                                             root,
+                                             &pExpCtx->variables),
+                          _doingMerge);
+    }
+}
+
+size_t DocumentSourceGroup::partitionOf(const Value& id, int level) const {
+    const uint64_t hash = mixHash(pExpCtx->getValueComparator().hash(id));
+    return (hash >> (level * kPartitionBits)) & (kNumPartitions - 1);
+}
+
+void DocumentSourceGroup::spillGroups(int level,
+                                      vector<SpilledPartition>* partitions,
+                                      SpillPolicy policy) {
+    if (partitions->empty()) {
+        partitions->resize(kNumPartitions);
+        for (auto&& partition : *partitions) {
+            partition.level = level;
+        }
+    }
+
+    // Bucket the groups by partition in a single pass over '_groups', so that the groups of each
+    // partition written can be removed without searching for them.
+    vector<vector<GroupsMap::iterator>> groupsByPartition(kNumPartitions);
+    vector<size_t> partitionBytes(kNumPartitions, 0);
+    size_t totalBytes = 0;
+    for (auto it = _groups->begin(); it != _groups->end(); ++it) {
+        const size_t partition = partitionOf(it->first, level);
+        size_t bytes = it->first.getApproximateSize();
+        for (auto&& accum : it->second) {
+            bytes += accum->memUsageForSorter();
+        }
+        groupsByPartition[partition].push_back(it);
+        partitionBytes[partition] += bytes;
+        totalBytes += bytes;
+    }
+
+    vector<size_t> toSpill;
+    switch (policy) {
+        case SpillPolicy::kUntilHalfEmpty: {
+            // Writing the largest partitions first frees the most memory for the fewest writes, and
+            // leaves the smaller partitions to be aggregated entirely in memory. When the memory
+            // budget of the operation, rather than that of this stage, is exceeded, half of the
+            // memory of this stage is freed.
+            const size_t targetBytes = std::min(totalBytes, _maxMemoryUsageBytes) / 2;
+            vector<size_t> bySize(kNumPartitions);
+            std::iota(bySize.begin(), bySize.end(), 0);
+            std::sort(bySize.begin(), bySize.end(), [&](size_t lhs, size_t rhs) {
+                return partitionBytes[lhs] > partitionBytes[rhs];
+            });
+            size_t remainingBytes = totalBytes;
+            for (size_t partition : bySize) {
+                if (remainingBytes <= targetBytes || partitionBytes[partition] == 0) {
+                    break;
+                }
+                toSpill.push_back(partition);
+                remainingBytes -= partitionBytes[partition];
+            }
+            break;
+        }
+        case SpillPolicy::kPartitionsWithRuns: {
+            for (size_t partition = 0; partition < kNumPartitions; ++partition) {
+                if (!(*partitions)[partition].runs.empty()) {
+                    toSpill.push_back(partition);
+                }
             }
             break;
+        }
+        case SpillPolicy::kAll: {
+            toSpill.resize(kNumPartitions);
+            std::iota(toSpill.begin(), toSpill.end(), 0);
+            break;
+        }
+    }
+
+    for (size_t partition : toSpill) {
+        if (groupsByPartition[partition].empty()) {
+            continue;
+        }
+
+        SortedFileWriter<Value, Value> writer(
+            SortOptions().TempDir(pExpCtx->tempDir), _fileName, _nextSortedFileWriterOffset);
+        for (auto&& it : groupsByPartition[partition]) {
+            // Runs are never merged by key, so their groups need not be sorted.
+            writer.addAlreadySorted(it->first, getSpillableState(it->second));
+            _groups->erase(it);
+        }
+
+        (*partitions)[partition].runs.emplace_back(writer.done());
+        _nextSortedFileWriterOffset = writer.getFileEndOffset();
+        totalBytes -= partitionBytes[partition];
+        _usedDisk = true;
+    }
+
+    _memoryTracker.set(totalBytes + _currentGroupBytes);
+}
+
+void DocumentSourceGroup::finishSpilling(int level, vector<SpilledPartition>* partitions) {
+    // A group of a spilled partition may have states both on disk and in memory, so the states in
+    // memory are written as well and aggregated along with the rest once the partition is read.
+    spillGroups(level, partitions, SpillPolicy::kPartitionsWithRuns);
+
+    for (auto&& partition : *partitions) {
+        if (!partition.runs.empty()) {
+            _pendingPartitions.push_back(std::move(partition));
+        }
+    }
+    partitions->clear();
+}
+
+void DocumentSourceGroup::readSpilledPartition() {
+    SpilledPartition partition = std::move(_pendingPartitions.back());
+    _pendingPartitions.pop_back();
+
+    _groups->clear();
+    _memoryTracker.set(0);
+
+    // The runs are read in the order they were written, so that the states of each group are
+    // merged in the order of the input they were computed from, as $first and $push require. If
+    // the partition does not fit in memory, it is partitioned again on the next bits of the hash;
+    // past the last of them, every key left has the same hash and can only be aggregated here.
+    const int subLevel = partition.level + 1;
+    vector<SpilledPartition> subPartitions;
+    for (auto&& run : partition.runs) {
+        run->openSource();
+        while (run->more()) {
+            if (_memoryTracker.shouldReleaseMemory() && subLevel <= kMaxPartitionLevel) {
+                spillGroups(subLevel, &subPartitions, SpillPolicy::kUntilHalfEmpty);
+            }
+
+            auto spilledGroup = run->next();
+            bool inserted;
+            mergeSpilledState(spilledGroup.second, &lookUpGroup(spilledGroup.first, &inserted));
+        }
+        run->closeSource();
+    }
+
+    if (!subPartitions.empty()) {
+        finishSpilling(subLevel, &subPartitions);
+    }
+
+    groupsIterator = _groups->begin();
+}
+
+Value DocumentSourceGroup::getSpillableState(const Accumulators& accums) const {
+    switch (accums.size()) {  // same as _accumulatedFields.size()
+        case 0:               // no values, essentially a distinct
+            return Value();
 
         case 1:  // just one value, use optimized serialization as single Value
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first,
-                                        ptrs[i]->second[0]->getValue(/*toBeMerged=*/true));
+            return accums[0]->getValue(/*toBeMerged=*/true);
+
+        default: {  // multiple values, serialize as array-typed Value
+            vector<Value> states;
+            states.reserve(accums.size());
+            for (auto&& accum : accums) {
+                states.push_back(accum->getValue(/*toBeMerged=*/true));
             }
+            return Value(std::move(states));
+        }
+    }
+}
+
+void DocumentSourceGroup::mergeSpilledState(const Value& state, Accumulators* accums) {
+    switch (accums->size()) {  // mirrors switch in getSpillableState()
+        case 0:                // No accumulators so no Values.
             break;
 
-        default:  // multiple values, serialize as array-typed Value
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                vector<Value> accums;
-                for (size_t j = 0; j < ptrs[i]->second.size(); j++) {
-                    accums.push_back(ptrs[i]->second[j]->getValue(/*toBeMerged=*/true));
-                }
-                writer.addAlreadySorted(ptrs[i]->first, Value(std::move(accums)));
-            }
+        case 1:  // Single accumulators serialize as a single Value.
+            (*accums)[0]->process(state, true);
             break;
+
+        default: {  // Multiple accumulators serialize as an array of Values.
+            const vector<Value>& accumulatorStates = state.getArray();
+            for (size_t i = 0; i < accums->size(); i++) {
+                (*accums)[i]->process(accumulatorStates[i], true);
+            }
+        }
     }
 
-    _groups->clear();
+    for (auto&& accum : *accums) {
+        _memoryTracker.add(accum->memUsageForSorter());
+    }
+}
 
-    Sorter<Value, Value>::Iterator* iteratorPtr = writer.done();
-    _nextSortedFileWriterOffset = writer.getFileEndOffset();
-    return shared_ptr<Sorter<Value, Value>::Iterator>(iteratorPtr);
+void DocumentSourceGroup::compileExpressions() {
+    _compiledIdExpressions.clear();
+    for (auto&& idExpression : _idExpressions) {
+        _compiledIdExpressions.push_back(CompiledExpression::compile(idExpression));
+    }
+
+    _compiledAccumulatorArgs.clear();
+    for (auto&& accumulatedField : _accumulatedFields) {
+        _compiledAccumulatorArgs.push_back(CompiledExpression::compile(accumulatedField.expression));
+    }
+    _expressionsCompiled = true;
 }
 
 Value DocumentSourceGroup::computeId(const Document& root) {
+    dassert(_compiledIdExpressions.size() == _idExpressions.size());
+
     // If only one expression, return result directly
     if (_idExpressions.size() == 1) {
-        Value retValue = _idExpressions[0]->evaluate(root, &pExpCtx->variables);
+        Value retValue = evaluateExpression(
+            *_idExpressions[0], _compiledIdExpressions[0].get(), root, &pExpCtx->variables);
         return retValue.missing() ? Value(BSONNULL) : std::move(retValue);
     }
 
@@ -638,11 +875,26 @@ Value DocumentSourceGroup::computeId(const Document& root) {
     vector<Value> vals;
     vals.reserve(_idExpressions.size());
     for (size_t i = 0; i < _idExpressions.size(); i++) {
-        vals.push_back(_idExpressions[i]->evaluate(root, &pExpCtx->variables));
+        vals.push_back(evaluateExpression(
+            *_idExpressions[i], _compiledIdExpressions[i].get(), root, &pExpCtx->variables));
     }
     return Value(std::move(vals));
 }
 
+Document DocumentSourceGroup::groupSingleDocument(const Document& root) {
+    if (!_expressionsCompiled) {
+        compileExpressions();
+    }
+
+    Accumulators accumulators;
+    accumulators.reserve(_accumulatedFields.size());
+    for (auto&& accumulatedField : _accumulatedFields) {
+        accumulators.push_back(accumulatedField.makeAccumulator(pExpCtx));
+    }
+    accumulate(root, accumulators);
+    return makeDocument(computeId(root), accumulators, false);
+}
+
 Value DocumentSourceGroup::expandId(const Value& val) {
     // _id doesn't get wrapped in a document
     if (_idFieldNames.empty())
@@ -34,6 +34,7 @@
 
 #include "monger/db/pipeline/accumulation_statement.h"
 #include "monger/db/pipeline/accumulator.h"
+#include "monger/db/pipeline/compiled_expression.h"
 #include "monger/db/pipeline/document_source.h"
 #include "monger/db/pipeline/transformer_interface.h"
 #include "monger/db/sorter/sorter.h"
@@ -162,6 +163,10 @@ public:
      */
     bool usedDisk() final;
 
+    const MemoryUsageTracker* getMemoryTracker() const final {
+        return &_memoryTracker;
+    }
+
     boost::optional<DistributedPlanLogic> distributedPlanLogic() final;
     bool canRunInParallelBeforeWriteStage(
         const std::set<std::string>& nameOfShardKeyFieldsUponEntryToStage) const final;
@@ -178,6 +183,18 @@ public:
     std::unique_ptr<GroupFromFirstDocumentTransformation> rewriteGroupAsTransformOnFirstDocument()
         const;
 
+    /**
+     * Returns true if this $group can return each group as soon as its input moves on to the next
+     * one, because its source is known to be sorted on the fields of the group key.
+     */
+    bool canStreamInput() const;
+
+    /**
+     * Returns the document this stage would output for a group made of 'root' alone. This lets a
+     * caller maintain the output of the $group one input document at a time.
+     */
+    Document groupSingleDocument(const Document& root);
+
 protected:
     void doDispose() final;
 
@@ -188,18 +205,60 @@ private:
     ~DocumentSourceGroup();
 
     /**
-     * getNext() dispatches to one of these three depending on what type of $group it is. These
-     * methods expect '_currentAccumulators' to have been reset before being called, and also expect
-     * initialize() to have been called already.
+     * When spilling, groups are divided into partitions by the hash of their key, and only the
+     * largest partitions are written to disk. Once the input is exhausted, the groups of each
+     * spilled partition are read back and aggregated on their own. A partition whose groups still
+     * do not fit in memory is divided again, on other bits of the hash.
+     */
+    static constexpr int kPartitionBits = 4;
+    static constexpr size_t kNumPartitions = 1 << kPartitionBits;
+    static constexpr int kMaxPartitionLevel = 64 / kPartitionBits - 1;
+
+    struct SpilledPartition {
+        // The number of times the groups in this partition have been partitioned, less one.
+        int level = 0;
+
+        // Runs of partially aggregated groups, in the order they were written. A group may appear
+        // in more than one of them.
+        std::vector<std::shared_ptr<Sorter<Value, Value>::Iterator>> runs;
+    };
+
+    /**
+     * Which partitions spillGroups() writes to disk.
+     */
+    enum class SpillPolicy {
+        // The largest ones, until the groups left in memory use at most half the memory limit.
+        kUntilHalfEmpty,
+        // Those which already have runs on disk.
+        kPartitionsWithRuns,
+        // All of them.
+        kAll,
+    };
+
+    /**
+     * Returns the next group from '_groups', reading back spilled partitions once it is exhausted.
+     * Expects initialize() to have been called already.
      */
-    GetNextResult getNextSpilled();
     GetNextResult getNextStandard();
 
     /**
-     * Before returning anything, this source must prepare itself. In a streaming $group,
-     * initialize() requests the first document from the previous source, and uses it to prepare the
-     * accumulators. In an unsorted $group, initialize() exhausts the previous source before
-     * returning. The '_initialized' boolean indicates that initialize() has finished.
+     * Returns the next group of a streaming $group, consuming input until the group key changes.
+     * Documents whose key need not be adjacent to its equals in sorted input are aggregated into
+     * '_groups' instead, which getNextStandard() returns once the input is exhausted.
+     */
+    GetNextResult getNextStreaming();
+
+    /**
+     * Returns true if documents with the group key 'id' are adjacent in input sorted on the fields
+     * of the group key. Arrays sort by one of their elements, and missing, null and undefined
+     * values sort together, so documents with such keys may be interleaved with other groups.
+     */
+    bool isAdjacentInSortedInput(const Value& id) const;
+
+    /**
+     * Before returning anything, an unsorted $group must prepare itself. initialize() exhausts the
+     * previous source before returning. The '_initialized' boolean indicates that initialize() has
+     * finished.
      *
      * This method may not be able to finish initialization in a single call if 'pSource' returns a
      * DocumentSource::GetNextResult::kPauseExecution, so it returns the last GetNextResult
@@ -208,11 +267,50 @@ private:
     GetNextResult initialize();
 
     /**
-     * Spill groups map to disk and returns an iterator to the file. Note: Since a sorted $group
-     * does not exhaust the previous stage before returning, and thus does not maintain as large a
-     * store of documents at any one time, only an unsorted group can spill to disk.
+     * Returns the accumulators of the group 'id', adding the group if it is new. Their memory usage
+     * is no longer charged to '_memoryTracker', and must be added back once they have processed
+     * their input.
+     */
+    Accumulators& lookUpGroup(const Value& id, bool* inserted);
+
+    /**
+     * Adds 'root', whose group key is 'id', to its group in '_groups', spilling groups to disk
+     * first if they use too much memory. Returns whether the group is new.
      */
-    std::shared_ptr<Sorter<Value, Value>::Iterator> spill();
+    bool addToGroups(const Value& id, const Document& root);
+
+    /**
+     * Feeds the accumulator arguments evaluated against 'root' to the accumulators of 'group'.
+     */
+    void accumulate(const Document& root, const Accumulators& group);
+
+    /**
+     * Returns the index of the partition of the group 'id' when partitioning at 'level'.
+     */
+    size_t partitionOf(const Value& id, int level) const;
+
+    /**
+     * Writes the groups of the partitions chosen by 'policy' to disk, as a new run of each of
+     * 'partitions', and removes them from '_groups'.
+     */
+    void spillGroups(int level, std::vector<SpilledPartition>* partitions, SpillPolicy policy);
+
+    /**
+     * Writes the groups left in memory of the partitions which have been spilled, and queues those
+     * partitions to be read back.
+     */
+    void finishSpilling(int level, std::vector<SpilledPartition>* partitions);
+
+    /**
+     * Aggregates the groups of the next queued partition into '_groups'.
+     */
+    void readSpilledPartition();
+
+    /**
+     * Returns the state of 'accums' as written to disk, and merges such a state into 'accums'.
+     */
+    Value getSpillableState(const Accumulators& accums) const;
+    void mergeSpilledState(const Value& state, Accumulators* accums);
 
     Document makeDocument(const Value& id, const Accumulators& accums, bool mergeableOutput);
 
@@ -221,6 +319,11 @@ private:
      */
     Value computeId(const Document& root);
 
+    /**
+     * Compiles '_idExpressions' and the accumulator arguments, which must already be optimized.
+     */
+    void compileExpressions();
+
     /**
      * Converts the internal representation of the group key to the _id shape specified by the
      * user.
@@ -236,36 +339,48 @@ private:
 
     bool _usedDisk;  // Keeps track of whether this $group spilled to disk.
     bool _doingMerge;
-    size_t _memoryUsageBytes = 0;
     size_t _maxMemoryUsageBytes;
+    MemoryUsageTracker _memoryTracker;
     std::string _fileName;
-    unsigned int _nextSortedFileWriterOffset = 0;
-    bool _ownsFileDeletion = true;  // unless a MergeIterator is made that takes over.
+    std::streampos _nextSortedFileWriterOffset = 0;
+    int _numDebugSpills = 0;
 
     std::vector<std::string> _idFieldNames;  // used when id is a document
     std::vector<boost::intrusive_ptr<Expression>> _idExpressions;
 
+    // Compiled forms of '_idExpressions' and of the expressions in '_accumulatedFields', built on
+    // the first call to initialize(). A null entry is evaluated through the expression tree.
+    std::vector<std::unique_ptr<CompiledExpression>> _compiledIdExpressions;
+    std::vector<std::unique_ptr<CompiledExpression>> _compiledAccumulatorArgs;
+    bool _expressionsCompiled = false;
+
     bool _initialized;
 
-    Value _currentId;
-    Accumulators _currentAccumulators;
+    // Whether the input is sorted on the group key, in which case getNextStreaming() returns each
+    // group as soon as the next one begins. Decided on the first call to getNext().
+    bool _streaming = false;
+
+    // The key and accumulators of the group a streaming $group is consuming input for, if any. The
+    // accumulators are reset rather than reallocated for each group.
+    boost::optional<Value> _currentGroupId;
+    Accumulators _currentGroup;
+    long long _currentGroupBytes = 0;  // The part of '_memoryTracker' charged for '_currentGroup'.
 
     // We use boost::optional to defer initialization until the ExpressionContext containing the
     // correct comparator is injected, since the groups must be built using the comparator's
     // definition of equality.
     boost::optional<GroupsMap> _groups;
 
-    std::vector<std::shared_ptr<Sorter<Value, Value>::Iterator>> _sortedFiles;
-    bool _spilled;
+    // The partitions spilled while consuming the input, indexed by partition. Empty if nothing has
+    // been spilled.
+    std::vector<SpilledPartition> _spilledPartitions;
+
+    // Spilled partitions whose groups have yet to be read back and returned.
+    std::vector<SpilledPartition> _pendingPartitions;
 
-    // Only used when '_spilled' is false.
     GroupsMap::iterator groupsIterator;
 
-    // Only used when '_spilled' is true.
-    std::unique_ptr<Sorter<Value, Value>::Iterator> _sorterIterator;
     const bool _allowDiskUse;
-
-    std::pair<Value, Value> _firstPartOfNextGroup;
 };
 
 }  // namespace monger
@@ -49,11 +49,13 @@
 #include "monger/db/pipeline/expression.h"
 #include "monger/db/pipeline/expression_context_for_test.h"
 #include "monger/db/pipeline/value_comparator.h"
+#include "monger/db/query/query_knobs_gen.h"
 #include "monger/db/query/query_test_service_context.h"
 #include "monger/dbtests/dbtests.h"
 #include "monger/stdx/unordered_set.h"
 #include "monger/unittest/temp_dir.h"
 #include "monger/unittest/unittest.h"
+#include "monger/util/scopeguard.h"
 
 namespace monger {
 
@@ -142,6 +144,56 @@ TEST_F(DocumentSourceGroupTest, ShouldBeAbleToPauseLoadingWhileSpilled) {
     ASSERT_EQ(idSet.count(2), 1UL);
 }
 
+TEST_F(DocumentSourceGroupTest, ShouldAggregateManyGroupsAcrossSpilledPartitions) {
+    auto expCtx = getExpCtx();
+
+    // Allow the $group stage to spill to disk.
+    TempDir tempDir("DocumentSourceGroupTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+    const size_t maxMemoryUsageBytes = 2000;
+
+    VariablesParseState vps = expCtx->variablesParseState;
+    AccumulationStatement sumStatement{"total",
+                                       ExpressionFieldPath::parse(expCtx, "$x", vps),
+                                       AccumulationStatement::getFactory("$sum")};
+    AccumulationStatement pushStatement{"all",
+                                        ExpressionFieldPath::parse(expCtx, "$x", vps),
+                                        AccumulationStatement::getFactory("$push")};
+    auto groupByExpression = ExpressionFieldPath::parse(expCtx, "$k", vps);
+    auto group = DocumentSourceGroup::create(
+        expCtx, groupByExpression, {sumStatement, pushStatement}, maxMemoryUsageBytes);
+
+    const int numGroups = 500;
+    const int numDocsPerGroup = 4;
+    std::deque<DocumentSource::GetNextResult> inputs;
+    for (int x = 0; x < numGroups * numDocsPerGroup; ++x) {
+        inputs.emplace_back(Document{{"k", x % numGroups}, {"x", x}});
+    }
+    auto mock = DocumentSourceMock::createForTest(std::move(inputs));
+    group->setSource(mock.get());
+
+    // Every group is returned once, with its values pushed in the order they were read even though
+    // they were aggregated across several runs on disk.
+    stdx::unordered_set<int> idSet;
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        auto doc = result.releaseDocument();
+        const int k = doc["_id"].coerceToInt();
+        ASSERT_TRUE(idSet.insert(k).second);
+
+        std::vector<Value> expectedValues;
+        for (int i = 0; i < numDocsPerGroup; ++i) {
+            expectedValues.push_back(Value(k + i * numGroups));
+        }
+        ASSERT_VALUE_EQ(doc["all"], Value(expectedValues));
+        ASSERT_EQ(doc["total"].coerceToInt(), numDocsPerGroup * k + 6 * numGroups);
+    }
+    ASSERT_TRUE(group->getNext().isEOF());
+
+    ASSERT_EQ(idSet.size(), static_cast<size_t>(numGroups));
+    ASSERT_TRUE(group->usedDisk());
+}
+
 TEST_F(DocumentSourceGroupTest, ShouldErrorIfNotAllowedToSpillToDiskAndResultSetIsTooLarge) {
     auto expCtx = getExpCtx();
     const size_t maxMemoryUsageBytes = 1000;
@@ -193,6 +245,100 @@ TEST_F(DocumentSourceGroupTest, ShouldCorrectlyTrackMemoryUsageBetweenPauses) {
     ASSERT_THROWS_CODE(group->getNext(), AssertionException, 16945);
 }
 
+TEST_F(DocumentSourceGroupTest, ShouldSpillWhenTheOperationIsOverItsMemoryBudget) {
+    auto expCtx = getExpCtx();
+    TempDir tempDir("DocumentSourceGroupTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+
+    // The limit of the stage is never reached, but that of the operation is, as another stage
+    // holds most of it.
+    const long long maxOperationMemoryUsageBytes = 4000;
+    expCtx->memoryTracker =
+        std::make_shared<MemoryUsageTracker>(nullptr, maxOperationMemoryUsageBytes);
+    MemoryUsageTracker otherStage(expCtx->memoryTracker.get());
+    otherStage.add(maxOperationMemoryUsageBytes - 1000);
+
+    VariablesParseState vps = expCtx->variablesParseState;
+    AccumulationStatement pushStatement{"spaceHog",
+                                        ExpressionFieldPath::parse(expCtx, "$largeStr", vps),
+                                        AccumulationStatement::getFactory("$push")};
+    auto groupByExpression = ExpressionFieldPath::parse(expCtx, "$_id", vps);
+    auto group = DocumentSourceGroup::create(
+        expCtx, groupByExpression, {pushStatement}, 100 * 1024 * 1024);
+
+    string largeStr(1000, 'x');
+    auto mock = DocumentSourceMock::createForTest({Document{{"_id", 0}, {"largeStr", largeStr}},
+                                                   Document{{"_id", 1}, {"largeStr", largeStr}},
+                                                   Document{{"_id", 2}, {"largeStr", largeStr}}});
+    group->setSource(mock.get());
+
+    stdx::unordered_set<int> idSet;
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        idSet.insert(result.releaseDocument()["_id"].coerceToInt());
+    }
+    ASSERT_EQ(idSet.size(), 3UL);
+    ASSERT_TRUE(group->usedDisk());
+    ASSERT_GT(group->getMemoryTracker()->peakTrackedMemoryBytes(), 1000);
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldNotSpillWhenOtherStagesAloneAreOverTheBudget) {
+    auto expCtx = getExpCtx();
+    TempDir tempDir("DocumentSourceGroupTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+
+    // Spilling the groups cannot bring the operation back within its budget, so only the limit of
+    // the stage applies, and it is never reached.
+    const long long maxOperationMemoryUsageBytes = 4000;
+    expCtx->memoryTracker =
+        std::make_shared<MemoryUsageTracker>(nullptr, maxOperationMemoryUsageBytes);
+    MemoryUsageTracker otherStage(expCtx->memoryTracker.get());
+    otherStage.add(maxOperationMemoryUsageBytes + 1000);
+
+    VariablesParseState vps = expCtx->variablesParseState;
+    AccumulationStatement pushStatement{"spaceHog",
+                                        ExpressionFieldPath::parse(expCtx, "$largeStr", vps),
+                                        AccumulationStatement::getFactory("$push")};
+    auto groupByExpression = ExpressionFieldPath::parse(expCtx, "$_id", vps);
+    auto group = DocumentSourceGroup::create(
+        expCtx, groupByExpression, {pushStatement}, 100 * 1024 * 1024);
+
+    string largeStr(1000, 'x');
+    auto mock = DocumentSourceMock::createForTest({Document{{"_id", 0}, {"largeStr", largeStr}},
+                                                   Document{{"_id", 1}, {"largeStr", largeStr}},
+                                                   Document{{"_id", 2}, {"largeStr", largeStr}}});
+    group->setSource(mock.get());
+
+    stdx::unordered_set<int> idSet;
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        idSet.insert(result.releaseDocument()["_id"].coerceToInt());
+    }
+    ASSERT_EQ(idSet.size(), 3UL);
+    ASSERT_FALSE(group->usedDisk());
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldErrorIfTheOperationIsOverItsMemoryBudgetWithoutSpilling) {
+    auto expCtx = getExpCtx();
+    expCtx->inMongers = true;  // Disallow external sort.
+    expCtx->memoryTracker = std::make_shared<MemoryUsageTracker>(nullptr, 1000);
+
+    VariablesParseState vps = expCtx->variablesParseState;
+    AccumulationStatement pushStatement{"spaceHog",
+                                        ExpressionFieldPath::parse(expCtx, "$largeStr", vps),
+                                        AccumulationStatement::getFactory("$push")};
+    auto groupByExpression = ExpressionFieldPath::parse(expCtx, "$_id", vps);
+    auto group = DocumentSourceGroup::create(
+        expCtx, groupByExpression, {pushStatement}, 100 * 1024 * 1024);
+
+    string largeStr(1000, 'x');
+    auto mock = DocumentSourceMock::createForTest({Document{{"_id", 0}, {"largeStr", largeStr}},
+                                                   Document{{"_id", 1}, {"largeStr", largeStr}}});
+    group->setSource(mock.get());
+
+    ASSERT_THROWS_CODE(group->getNext(), AssertionException, 16945);
+}
+
 TEST_F(DocumentSourceGroupTest, ShouldReportSingleFieldGroupKeyAsARename) {
     auto expCtx = getExpCtx();
     VariablesParseState vps = expCtx->variablesParseState;
@@ -244,6 +390,94 @@ TEST_F(DocumentSourceGroupTest, ShouldNotReportDottedGroupKeyAsARename) {
     ASSERT_EQ(modifiedPathsRet.renames.size(), 0UL);
 }
 
+/**
+ * Returns a $group on '$a' counting its documents, which reads from 'mock'.
+ */
+intrusive_ptr<DocumentSourceGroup> makeCountByAGroup(
+    const intrusive_ptr<ExpressionContext>& expCtx, const intrusive_ptr<DocumentSourceMock>& mock) {
+    VariablesParseState vps = expCtx->variablesParseState;
+    AccumulationStatement countStatement{"count",
+                                         ExpressionConstant::create(expCtx, Value(1)),
+                                         AccumulationStatement::getFactory("$sum")};
+    auto group = DocumentSourceGroup::create(
+        expCtx, ExpressionFieldPath::parse(expCtx, "$a", vps), {countStatement});
+    group->setSource(mock.get());
+    return group;
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldReturnEachGroupAsSoonAsSortedInputMovesOn) {
+    auto expCtx = getExpCtx();
+    auto mock =
+        DocumentSourceMock::createForTest({Document{{"a", 1}},
+                                           Document{{"a", 1}},
+                                           Document{{"a", 2}},
+                                           DocumentSource::GetNextResult::makePauseExecution(),
+                                           Document{{"a", 3}}});
+    mock->sorts.insert(BSON("a" << 1 << "b" << 1));
+    auto group = makeCountByAGroup(expCtx, mock);
+    ASSERT_TRUE(group->canStreamInput());
+
+    // The group of 1 is complete before the pause in the input is reached.
+    auto result = group->getNext();
+    ASSERT_TRUE(result.isAdvanced());
+    ASSERT_DOCUMENT_EQ(result.releaseDocument(), (Document{{"_id", 1}, {"count", 2}}));
+    ASSERT_TRUE(group->getNext().isPaused());
+
+    result = group->getNext();
+    ASSERT_TRUE(result.isAdvanced());
+    ASSERT_DOCUMENT_EQ(result.releaseDocument(), (Document{{"_id", 2}, {"count", 1}}));
+    result = group->getNext();
+    ASSERT_TRUE(result.isAdvanced());
+    ASSERT_DOCUMENT_EQ(result.releaseDocument(), (Document{{"_id", 3}, {"count", 1}}));
+    ASSERT_TRUE(group->getNext().isEOF());
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldGroupKeysWhichSortAmongOthersWhenStreaming) {
+    auto expCtx = getExpCtx();
+    // This is the order in which a sort on 'a' may return these documents.
+    auto mock = DocumentSourceMock::createForTest({"{a: null}",
+                                                   "{}",
+                                                   "{a: null}",
+                                                   "{a: 1}",
+                                                   "{a: [1, 2]}",
+                                                   "{a: 1}",
+                                                   "{a: [1, 2]}",
+                                                   "{a: 2}"});
+    mock->sorts.insert(BSON("a" << 1));
+    auto group = makeCountByAGroup(expCtx, mock);
+
+    auto results = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+    for (auto next = group->getNext(); next.isAdvanced(); next = group->getNext()) {
+        results.insert(next.releaseDocument().toBson());
+    }
+    ASSERT_EQ(results.size(), 4U);
+    for (auto&& expected : {"{_id: null, count: 3}",
+                            "{_id: 1, count: 2}",
+                            "{_id: [1, 2], count: 2}",
+                            "{_id: 2, count: 1}"}) {
+        ASSERT_EQ(results.count(fromjson(expected)), 1U) << expected;
+    }
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldNotStreamUnlessInputIsSortedOnTheGroupKey) {
+    auto expCtx = getExpCtx();
+    auto mock = DocumentSourceMock::createForTest(
+        {Document{{"a", 1}}, DocumentSource::GetNextResult::makePauseExecution()});
+    auto group = makeCountByAGroup(expCtx, mock);
+    ASSERT_FALSE(group->canStreamInput());
+
+    mock->sorts.insert(BSON("b" << 1 << "a" << 1));
+    ASSERT_FALSE(group->canStreamInput());
+
+    mock->sorts.insert(BSON("a" << -1));
+    ASSERT_TRUE(group->canStreamInput());
+
+    internalDocumentSourceGroupEnableStreaming.store(false);
+    ON_BLOCK_EXIT([] { internalDocumentSourceGroupEnableStreaming.store(true); });
+    ASSERT_FALSE(group->canStreamInput());
+    ASSERT_TRUE(group->getNext().isPaused());
+}
+
 BSONObj toBson(const intrusive_ptr<DocumentSource>& source) {
     vector<Value> arr;
     source->serializeToArray(arr);
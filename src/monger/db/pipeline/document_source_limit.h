@@ -75,6 +75,11 @@ public:
         return DepsTracker::State::SEE_NEXT;  // This doesn't affect needed fields
     }
 
+    BSONObjSet getOutputSorts() final {
+        // This stage returns the documents of its source in the same order.
+        return pSource ? pSource->getOutputSorts() : DocumentSource::getOutputSorts();
+    }
+
     /**
      * Returns a DistributedPlanLogic with two identical $limit stages; one for the shards pipeline
      * and one for the merging pipeline.
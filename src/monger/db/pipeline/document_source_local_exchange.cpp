@@ -0,0 +1,412 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "monger/platform/basic.h"
+
+#include "monger/db/pipeline/document_source_local_exchange.h"
+
+#include <deque>
+
+#include "monger/db/client.h"
+#include "monger/db/pipeline/document_source_group.h"
+#include "monger/db/pipeline/document_source_match.h"
+#include "monger/db/pipeline/document_source_single_document_transformation.h"
+#include "monger/db/query/query_knobs_gen.h"
+#include "monger/db/service_context.h"
+#include "monger/stdx/condition_variable.h"
+#include "monger/stdx/mutex.h"
+#include "monger/util/concurrency/thread_pool.h"
+
+namespace monger {
+
+constexpr StringData DocumentSourceLocalExchange::kStageName;
+
+namespace {
+
+/**
+ * Returns true if 'stage' transforms each document independently of the others, so that copies of
+ * it may process disjoint parts of its input in parallel.
+ */
+bool isParallelizablePrefixStage(const DocumentSource* stage) {
+    if (auto match = dynamic_cast<const DocumentSourceMatch*>(stage)) {
+        // Subclasses of $match, such as change stream filters, are not cloned.
+        return match->getSourceName() == "$match"_sd && !match->isTextQuery();
+    }
+    if (auto transformation = dynamic_cast<const DocumentSourceSingleDocumentTransformation*>(stage)) {
+        return transformation->getType() !=
+            TransformerInterface::TransformerType::kGroupFromFirstDocument;
+    }
+    return false;
+}
+
+/**
+ * Returns true if the partial results of copies of 'group' over disjoint parts of its input can be
+ * merged into the result 'group' would produce over all of it, regardless of the order in which the
+ * input was divided.
+ */
+bool isParallelizableGroup(const DocumentSourceGroup& group) {
+    if (group.doingMerge()) {
+        return false;
+    }
+    const auto& expCtx = group.getContext();
+    for (auto&& accumulatedField : group.getAccumulatedFields()) {
+        if (!accumulatedField.makeAccumulator(expCtx)->isCommutative()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<BSONObj> toBSONPipeline(const std::vector<Value>& serializedStages) {
+    std::vector<BSONObj> stages;
+    for (auto&& stage : serializedStages) {
+        stages.push_back(stage.getDocument().toBson());
+    }
+    return stages;
+}
+
+}  // namespace
+
+struct DocumentSourceLocalExchange::SharedState {
+    SharedState(std::vector<std::unique_ptr<Pipeline, PipelineDeleter>> consumers,
+                size_t maxBufferedBytes)
+        : maxBufferedBytes(maxBufferedBytes),
+          pipelines(std::move(consumers)),
+          opCtxs(pipelines.size(), nullptr) {}
+
+    /**
+     * Runs consumer 'id' to completion on the calling thread, which must have a Client.
+     * 'scheduleStatus' is the status with which the thread pool ran the task.
+     */
+    void runConsumer(size_t id, Status scheduleStatus);
+
+    /**
+     * Interrupts every consumer which is currently running. Must not be called with 'mutex' held.
+     */
+    void killConsumers();
+
+    const size_t maxBufferedBytes;
+
+    // Protects the members below, up to 'pipelines'.
+    stdx::mutex mutex;
+
+    // Signalled when a result is added to or removed from 'results', when a consumer finishes and
+    // when the consumers are cancelled.
+    stdx::condition_variable cv;
+
+    std::deque<Document> results;
+    size_t bufferedBytes = 0;
+
+    size_t consumersDone = 0;
+
+    // The first error raised by a consumer. Once set, the other consumers are cancelled.
+    Status error = Status::OK();
+
+    bool cancelled = false;
+
+    // A consumer pipeline is used only by the thread running that consumer, which resets it once
+    // disposed of. Pipelines of consumers which did not run are disposed of by the parent stage
+    // after all consumers have stopped.
+    std::vector<std::unique_ptr<Pipeline, PipelineDeleter>> pipelines;
+
+    // Protects 'opCtxs'. A consumer removes its OperationContext from 'opCtxs' before destroying
+    // it, so that killConsumers() never sees a destroyed OperationContext.
+    stdx::mutex opCtxMutex;
+
+    // The OperationContext of each running consumer, or nullptr.
+    std::vector<OperationContext*> opCtxs;
+};
+
+void DocumentSourceLocalExchange::SharedState::runConsumer(size_t id, Status scheduleStatus) {
+    Status status = scheduleStatus;
+
+    if (status.isOK()) {
+        auto opCtx = cc().makeOperationContext();
+        {
+            stdx::lock_guard<stdx::mutex> lk(opCtxMutex);
+            opCtxs[id] = opCtx.get();
+        }
+
+        bool wasCancelled;
+        {
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            wasCancelled = cancelled;
+        }
+
+        // If the consumers were cancelled before this one started, its pipeline is left to be
+        // disposed of by the parent stage.
+        if (!wasCancelled) {
+            auto& pipeline = pipelines[id];
+            try {
+                pipeline->reattachToOperationContext(opCtx.get());
+                while (auto next = pipeline->getNext()) {
+                    stdx::unique_lock<stdx::mutex> lk(mutex);
+                    opCtx->waitForConditionOrInterrupt(
+                        cv, lk, [&] { return cancelled || bufferedBytes < maxBufferedBytes; });
+                    if (cancelled) {
+                        break;
+                    }
+
+                    bufferedBytes += next->getApproximateSize();
+                    results.push_back(std::move(*next));
+                    cv.notify_all();
+                }
+            } catch (const DBException& ex) {
+                status = ex.toStatus();
+            }
+
+            pipeline->dispose(opCtx.get());
+            pipeline.get_deleter().dismissDisposal();
+            pipeline.reset();
+        }
+
+        stdx::lock_guard<stdx::mutex> lk(opCtxMutex);
+        opCtxs[id] = nullptr;
+    }
+
+    bool failed = false;
+    {
+        stdx::lock_guard<stdx::mutex> lk(mutex);
+        ++consumersDone;
+        if (!status.isOK()) {
+            if (!cancelled) {
+                error = status;
+                cancelled = true;
+                failed = true;
+            } else if (error.code() == ErrorCodes::ExchangePassthrough &&
+                       status.code() != ErrorCodes::ExchangePassthrough) {
+                // The consumer which failed to load the Exchange reports the original error after
+                // the consumers it woke up report that the Exchange failed.
+                error = status;
+            }
+        }
+        cv.notify_all();
+    }
+
+    if (failed) {
+        killConsumers();
+    }
+}
+
+void DocumentSourceLocalExchange::SharedState::killConsumers() {
+    stdx::lock_guard<stdx::mutex> lk(opCtxMutex);
+    for (auto opCtx : opCtxs) {
+        if (opCtx) {
+            stdx::lock_guard<Client> clientLock(*opCtx->getClient());
+            opCtx->getServiceContext()->killOperation(clientLock, opCtx, ErrorCodes::Interrupted);
+        }
+    }
+}
+
+std::unique_ptr<Pipeline, PipelineDeleter> DocumentSourceLocalExchange::parallelizePipeline(
+    std::unique_ptr<Pipeline, PipelineDeleter> pipeline,
+    size_t nConsumers,
+    const ExpressionContextFactory& makeExpCtx) {
+    const auto& sources = pipeline->getSources();
+    if (nConsumers < 2 || sources.size() < 2) {
+        return pipeline;
+    }
+
+    // The first stage is the input to the Exchange. Find the $group which ends the stages to be
+    // cloned for every consumer.
+    auto groupIt = std::next(sources.begin());
+    while (groupIt != sources.end() && isParallelizablePrefixStage(groupIt->get())) {
+        ++groupIt;
+    }
+    if (groupIt == sources.end()) {
+        return pipeline;
+    }
+    auto group = dynamic_cast<DocumentSourceGroup*>(groupIt->get());
+    if (!group || !isParallelizableGroup(*group)) {
+        return pipeline;
+    }
+
+    // A $group over input sorted on its key already streams its groups with little memory, which
+    // the round-robin distribution of its input would prevent.
+    if (group->canStreamInput()) {
+        return pipeline;
+    }
+
+    // Each consumer and the merging half of the pipeline are re-parsed from their serialization
+    // under their own ExpressionContext.
+    std::vector<Value> serializedConsumer;
+    for (auto it = std::next(sources.begin()); it != std::next(groupIt); ++it) {
+        (*it)->serializeToArray(serializedConsumer);
+    }
+    std::vector<Value> serializedMerger;
+    group->distributedPlanLogic()->mergingStage->serializeToArray(serializedMerger);
+    for (auto it = std::next(groupIt); it != sources.end(); ++it) {
+        (*it)->serializeToArray(serializedMerger);
+    }
+
+    std::vector<boost::intrusive_ptr<ExpressionContext>> consumerExpCtxs;
+    std::vector<std::unique_ptr<Pipeline, PipelineDeleter>> consumers;
+    for (size_t id = 0; id < nConsumers; ++id) {
+        auto consumerExpCtx = makeExpCtx();
+        // The consumers' $group stages produce partial results for the merging $group.
+        consumerExpCtx->needsMerge = true;
+        consumers.push_back(uassertStatusOK(
+            Pipeline::parse(toBSONPipeline(serializedConsumer), consumerExpCtx)));
+        consumerExpCtxs.push_back(std::move(consumerExpCtx));
+    }
+
+    auto mergerExpCtx = makeExpCtx();
+    auto merger =
+        uassertStatusOK(Pipeline::parse(toBSONPipeline(serializedMerger), mergerExpCtx));
+
+    // Only the input stage remains in use. The other stages have been copied above.
+    auto input = pipeline->popFront();
+    auto inputExpCtx = pipeline->getContext();
+    pipeline.reset();
+
+    ExchangeSpec spec;
+    spec.setPolicy(ExchangePolicyEnum::kRoundRobin);
+    spec.setConsumers(nConsumers);
+    spec.setBufferSize(internalDocumentSourceLocalExchangeBufferSizeBytes.load());
+
+    boost::intrusive_ptr<Exchange> exchange =
+        new Exchange(std::move(spec), uassertStatusOK(Pipeline::create({input}, inputExpCtx)));
+
+    for (size_t id = 0; id < nConsumers; ++id) {
+        consumers[id]->addInitialSource(
+            new DocumentSourceExchange(consumerExpCtxs[id], exchange, id, nullptr));
+    }
+
+    merger->addInitialSource(
+        new DocumentSourceLocalExchange(mergerExpCtx, std::move(exchange), std::move(consumers)));
+    merger->optimizePipeline();
+    return merger;
+}
+
+DocumentSourceLocalExchange::DocumentSourceLocalExchange(
+    const boost::intrusive_ptr<ExpressionContext>& expCtx,
+    boost::intrusive_ptr<Exchange> exchange,
+    std::vector<std::unique_ptr<Pipeline, PipelineDeleter>> consumers)
+    : DocumentSource(expCtx),
+      _exchange(std::move(exchange)),
+      _serializedConsumer(consumers.front()->serialize()),
+      _state(std::make_shared<SharedState>(
+          std::move(consumers), internalDocumentSourceLocalExchangeBufferSizeBytes.load())) {
+    invariant(_state->pipelines.size() == _exchange->getConsumers());
+}
+
+DocumentSourceLocalExchange::~DocumentSourceLocalExchange() {
+    _stopConsumers();
+}
+
+const char* DocumentSourceLocalExchange::getSourceName() const {
+    return kStageName.rawData();
+}
+
+Value DocumentSourceLocalExchange::serialize(
+    boost::optional<ExplainOptions::Verbosity> explain) const {
+    return Value(DOC(getSourceName() << DOC("consumers" << static_cast<int>(getConsumers())
+                                                        << "consumerPipeline"
+                                                        << Value(_serializedConsumer))));
+}
+
+DocumentSource::GetNextResult DocumentSourceLocalExchange::getNext() {
+    pExpCtx->checkForInterrupt();
+
+    if (!_pool) {
+        _startConsumers();
+    }
+
+    const size_t nConsumers = getConsumers();
+    stdx::unique_lock<stdx::mutex> lk(_state->mutex);
+    pExpCtx->opCtx->waitForConditionOrInterrupt(_state->cv, lk, [&] {
+        return !_state->results.empty() || !_state->error.isOK() ||
+            _state->consumersDone == nConsumers;
+    });
+    uassertStatusOK(_state->error);
+
+    if (_state->results.empty()) {
+        return GetNextResult::makeEOF();
+    }
+
+    auto result = std::move(_state->results.front());
+    _state->results.pop_front();
+    _state->bufferedBytes -= result.getApproximateSize();
+    _state->cv.notify_all();
+    return std::move(result);
+}
+
+void DocumentSourceLocalExchange::_startConsumers() {
+    ThreadPool::Options options;
+    options.poolName = "LocalExchange";
+    options.threadNamePrefix = "localExchange-";
+    options.minThreads = 0;
+    options.maxThreads = getConsumers();
+    options.onCreateThread = [](const std::string& name) { Client::initThread(name); };
+    _pool = std::make_unique<ThreadPool>(options);
+    _pool->startup();
+
+    for (size_t id = 0; id < getConsumers(); ++id) {
+        _pool->schedule(
+            [ state = _state, id ](Status status) { state->runConsumer(id, std::move(status)); });
+    }
+}
+
+void DocumentSourceLocalExchange::_stopConsumers() {
+    if (_stopped) {
+        return;
+    }
+    _stopped = true;
+
+    if (!_pool) {
+        return;
+    }
+
+    {
+        stdx::lock_guard<stdx::mutex> lk(_state->mutex);
+        _state->cancelled = true;
+        _state->cv.notify_all();
+    }
+    _state->killConsumers();
+
+    _pool->shutdown();
+    _pool->join();
+}
+
+void DocumentSourceLocalExchange::doDispose() {
+    _stopConsumers();
+
+    // Every consumer must dispose of its pipeline, since the last one to do so disposes of the
+    // Exchange's input.
+    for (auto&& pipeline : _state->pipelines) {
+        if (pipeline) {
+            pipeline->dispose(pExpCtx->opCtx);
+            pipeline.get_deleter().dismissDisposal();
+            pipeline.reset();
+        }
+    }
+}
+
+}  // namespace monger
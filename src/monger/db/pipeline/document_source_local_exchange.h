@@ -0,0 +1,157 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "monger/db/pipeline/document_source.h"
+#include "monger/db/pipeline/document_source_exchange.h"
+
+namespace monger {
+
+class ThreadPool;
+
+/**
+ * Runs several copies of the leading part of a pipeline concurrently within one operation and
+ * returns their combined output in no particular order. Each copy is a consumer of a shared
+ * round-robin Exchange over the pipeline's input and runs on its own thread, under its own
+ * OperationContext and ExpressionContext.
+ *
+ * The consumer threads start on the first call to getNext() and keep running between getMores
+ * until their output is exhausted or this stage is disposed. Each thread and the combined output
+ * buffer hold at most 'internalDocumentSourceLocalExchangeBufferSizeBytes' of documents.
+ *
+ * This stage is created by parallelizePipeline(). It cannot be parsed or sent to another node.
+ */
+class DocumentSourceLocalExchange final : public DocumentSource {
+public:
+    static constexpr StringData kStageName = "$_internalLocalExchange"_sd;
+
+    using ExpressionContextFactory = std::function<boost::intrusive_ptr<ExpressionContext>()>;
+
+    /**
+     * Rewrites 'pipeline' to run on 'nConsumers' threads if, after its first stage, it consists of
+     * any number of $match and $project-like stages followed by a $group whose accumulators do not
+     * depend on the order of their input. The first stage feeds an Exchange. Each consumer runs a
+     * copy of the stages up to and including the $group, which produces partial results. A merging
+     * $group followed by the rest of the pipeline runs above the returned DocumentSourceLocalExchange.
+     *
+     * Every call to 'makeExpCtx' must return a new ExpressionContext equivalent to the pipeline's.
+     * One is used by each consumer and one by the returned pipeline, as an ExpressionContext cannot
+     * be shared between threads.
+     *
+     * Returns 'pipeline' unchanged if it is not eligible or 'nConsumers' is less than 2.
+     */
+    static std::unique_ptr<Pipeline, PipelineDeleter> parallelizePipeline(
+        std::unique_ptr<Pipeline, PipelineDeleter> pipeline,
+        size_t nConsumers,
+        const ExpressionContextFactory& makeExpCtx);
+
+    /**
+     * Creates a stage which runs 'consumers' on separate threads. Each consumer pipeline must begin
+     * with a DocumentSourceExchange reading from 'exchange'.
+     */
+    DocumentSourceLocalExchange(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                                boost::intrusive_ptr<Exchange> exchange,
+                                std::vector<std::unique_ptr<Pipeline, PipelineDeleter>> consumers);
+
+    ~DocumentSourceLocalExchange();
+
+    GetNextResult getNext() final;
+
+    const char* getSourceName() const final;
+
+    Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final;
+
+    StageConstraints constraints(Pipeline::SplitState pipeState) const final {
+        StageConstraints constraints(StreamType::kStreaming,
+                                     PositionRequirement::kFirst,
+                                     HostTypeRequirement::kLocalOnly,
+                                     DiskUseRequirement::kNoDiskUse,
+                                     FacetRequirement::kNotAllowed,
+                                     TransactionRequirement::kNotAllowed,
+                                     LookupRequirement::kNotAllowed);
+        constraints.requiresInputDocSource = false;
+        return constraints;
+    }
+
+    boost::optional<DistributedPlanLogic> distributedPlanLogic() final {
+        return boost::none;
+    }
+
+    /**
+     * DocumentSourceLocalExchange does not have a direct source (its consumers read through the
+     * shared Exchange pipeline).
+     */
+    void setSource(DocumentSource* source) final {
+        invariant(!source);
+    }
+
+    size_t getConsumers() const {
+        return _exchange->getConsumers();
+    }
+
+protected:
+    void doDispose() final;
+
+private:
+    struct SharedState;
+
+    /**
+     * Schedules a thread for every consumer pipeline.
+     */
+    void _startConsumers();
+
+    /**
+     * Stops and joins all consumer threads, then disposes of any consumer pipeline which did not
+     * get to dispose of itself.
+     */
+    void _stopConsumers();
+
+    boost::intrusive_ptr<Exchange> _exchange;
+
+    // The serialization of a consumer pipeline, kept for explain since the pipelines themselves
+    // are in use on other threads.
+    std::vector<Value> _serializedConsumer;
+
+    // State shared with the consumer threads, which also owns the consumer pipelines.
+    std::shared_ptr<SharedState> _state;
+
+    // Runs the consumer threads. Null until the first call to getNext().
+    std::unique_ptr<ThreadPool> _pool;
+
+    bool _stopped = false;
+};
+
+}  // namespace monger
@@ -0,0 +1,222 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "monger/platform/basic.h"
+
+#include "monger/bson/json.h"
+#include "monger/db/pipeline/aggregation_context_fixture.h"
+#include "monger/db/pipeline/document_source_local_exchange.h"
+#include "monger/db/pipeline/document_source_mock.h"
+#include "monger/db/pipeline/document_value_test_util.h"
+#include "monger/db/pipeline/memory_usage_tracker.h"
+#include "monger/db/pipeline/stub_mongo_process_interface.h"
+#include "monger/unittest/unittest.h"
+
+namespace monger {
+namespace {
+
+/**
+ * An implementation of the MongerProcessInterface that is okay with changing the OperationContext,
+ * but has no other parts of the interface implemented.
+ */
+class StubMongerProcessOkWithOpCtxChanges : public StubMongerProcessInterface {
+public:
+    void setOperationContext(OperationContext* opCtx) final {
+        return;
+    }
+};
+
+class DocumentSourceLocalExchangeTest : public AggregationContextFixture {
+protected:
+    void setUp() override {
+        getExpCtx()->mongerProcessInterface = std::make_shared<StubMongerProcessOkWithOpCtxChanges>();
+    }
+
+    /**
+     * Returns a pipeline reading 'nDocs' documents {a: i % 10, b: i} from a mock source, followed
+     * by the stages in 'json'.
+     */
+    std::unique_ptr<Pipeline, PipelineDeleter> makePipeline(size_t nDocs, const std::string& json) {
+        std::vector<BSONObj> stages;
+        for (auto&& stage : fromjson("{stages: " + json + "}")["stages"].Array()) {
+            stages.push_back(stage.Obj().getOwned());
+        }
+        auto pipeline = uassertStatusOK(Pipeline::parse(stages, getExpCtx()));
+
+        auto source = DocumentSourceMock::createForTest();
+        for (size_t i = 0; i < nDocs; ++i) {
+            source->emplace_back(Document{{"a", static_cast<int>(i % 10)},
+                                          {"b", static_cast<int>(i)}});
+        }
+        pipeline->addInitialSource(source);
+        return pipeline;
+    }
+
+    std::unique_ptr<Pipeline, PipelineDeleter> parallelize(
+        std::unique_ptr<Pipeline, PipelineDeleter> pipeline, size_t nConsumers) {
+        return DocumentSourceLocalExchange::parallelizePipeline(
+            std::move(pipeline), nConsumers, [this] {
+                auto expCtx = getExpCtx()->copyWith(getExpCtx()->ns);
+                expCtx->mongerProcessInterface =
+                    std::make_shared<StubMongerProcessOkWithOpCtxChanges>();
+                return expCtx;
+            });
+    }
+
+    static bool isParallel(const Pipeline& pipeline) {
+        return dynamic_cast<DocumentSourceLocalExchange*>(pipeline.peekFront());
+    }
+
+    /**
+     * Returns the results of 'pipeline', sorted by _id.
+     */
+    static std::vector<Document> getSortedResults(Pipeline* pipeline) {
+        std::vector<Document> results;
+        while (auto next = pipeline->getNext()) {
+            results.push_back(std::move(*next));
+        }
+        std::sort(results.begin(), results.end(), [](const Document& lhs, const Document& rhs) {
+            return ValueComparator().evaluate(lhs["_id"] < rhs["_id"]);
+        });
+        return results;
+    }
+};
+
+TEST_F(DocumentSourceLocalExchangeTest, ParallelGroupMatchesSerialGroup) {
+    const std::string stages =
+        "[{$match: {b: {$gte: 100}}}, {$project: {a: 1, b: 1, c: {$multiply: ['$b', 2]}}},"
+        " {$group: {_id: '$a', count: {$sum: 1}, total: {$sum: '$c'}, avg: {$avg: '$b'},"
+        " max: {$max: '$b'}, set: {$addToSet: {$mod: ['$b', 2]}}}}]";
+
+    auto serial = makePipeline(1000, stages);
+    auto expected = getSortedResults(serial.get());
+    ASSERT_EQ(expected.size(), 10u);
+
+    auto parallel = parallelize(makePipeline(1000, stages), 4);
+    ASSERT_TRUE(isParallel(*parallel));
+    auto results = getSortedResults(parallel.get());
+
+    ASSERT_EQ(results.size(), expected.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        for (auto&& field : {"_id", "count", "total", "avg", "max"}) {
+            ASSERT_VALUE_EQ(results[i][field], expected[i][field]);
+        }
+        // The order of the elements of a set depends on the order in which they were added.
+        ASSERT_EQ(results[i]["set"].getArrayLength(), expected[i]["set"].getArrayLength());
+    }
+}
+
+TEST_F(DocumentSourceLocalExchangeTest, ShouldRunStagesAfterTheGroupOnMergedResults) {
+    auto pipeline = parallelize(
+        makePipeline(1000, "[{$group: {_id: '$a', count: {$sum: 1}}}, {$match: {_id: {$lt: 3}}}]"),
+        3);
+    ASSERT_TRUE(isParallel(*pipeline));
+
+    auto results = getSortedResults(pipeline.get());
+    ASSERT_EQ(results.size(), 3u);
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_DOCUMENT_EQ(results[i], (Document{{"_id", i}, {"count", 100}}));
+    }
+}
+
+TEST_F(DocumentSourceLocalExchangeTest, ShouldReturnNothingForEmptyInput) {
+    auto pipeline = parallelize(makePipeline(0, "[{$group: {_id: '$a', count: {$sum: 1}}}]"), 4);
+    ASSERT_TRUE(isParallel(*pipeline));
+    ASSERT_FALSE(pipeline->getNext());
+}
+
+TEST_F(DocumentSourceLocalExchangeTest, ShouldNotParallelizeOrderSensitiveAccumulators) {
+    for (auto&& accumulator : {"$first", "$last", "$push", "$mergeObjects"}) {
+        auto pipeline = parallelize(
+            makePipeline(10,
+                         std::string("[{$group: {_id: '$a', x: {") + accumulator +
+                             ": '$$ROOT'}}}]"),
+            4);
+        ASSERT_FALSE(isParallel(*pipeline));
+    }
+}
+
+TEST_F(DocumentSourceLocalExchangeTest, ShouldNotParallelizeWithoutGroup) {
+    auto pipeline = parallelize(makePipeline(10, "[{$match: {a: 1}}, {$project: {b: 1}}]"), 4);
+    ASSERT_FALSE(isParallel(*pipeline));
+}
+
+TEST_F(DocumentSourceLocalExchangeTest, ShouldNotParallelizeBlockingStageBeforeGroup) {
+    auto pipeline = parallelize(
+        makePipeline(10, "[{$sort: {b: 1}}, {$group: {_id: '$a', count: {$sum: 1}}}]"), 4);
+    ASSERT_FALSE(isParallel(*pipeline));
+}
+
+TEST_F(DocumentSourceLocalExchangeTest, ShouldNotParallelizeForOneConsumer) {
+    auto pipeline = parallelize(makePipeline(10, "[{$group: {_id: '$a', count: {$sum: 1}}}]"), 1);
+    ASSERT_FALSE(isParallel(*pipeline));
+}
+
+TEST_F(DocumentSourceLocalExchangeTest, ShouldPropagateErrorFromConsumer) {
+    // Dividing by zero for the document with b = 500 fails one of the consumers.
+    auto pipeline = parallelize(
+        makePipeline(
+            1000,
+            "[{$project: {a: 1, c: {$divide: [1, {$subtract: ['$b', 500]}]}}},"
+            " {$group: {_id: '$a', total: {$sum: '$c'}}}]"),
+        4);
+    ASSERT_TRUE(isParallel(*pipeline));
+    ASSERT_THROWS_CODE(getSortedResults(pipeline.get()), AssertionException, 16608);
+}
+
+TEST_F(DocumentSourceLocalExchangeTest, ConsumersDoNotChangeWherePeakMemoryIsReported) {
+    AtomicWord<long long> peak{0};
+    getExpCtx()->memoryTracker->reportPeakTo(&peak);
+
+    // Grouping on a unique field keeps the consumers recording new peaks until the last of them
+    // is done, after the others have destroyed their own OperationContexts.
+    auto pipeline = parallelize(
+        makePipeline(10000, "[{$group: {_id: '$b', count: {$sum: 1}}}]"), 4);
+    ASSERT_TRUE(isParallel(*pipeline));
+    ASSERT_EQ(getSortedResults(pipeline.get()).size(), 10000u);
+
+    ASSERT_GT(peak.load(), 0);
+    ASSERT_EQ(peak.load(), getExpCtx()->memoryTracker->peakTrackedMemoryBytes());
+    getExpCtx()->memoryTracker->reportPeakTo(nullptr);
+}
+
+TEST_F(DocumentSourceLocalExchangeTest, ShouldStopConsumersWhenDisposedEarly) {
+    auto pipeline = parallelize(
+        makePipeline(10000, "[{$project: {a: 1, b: 1}}, {$group: {_id: '$b', count: {$sum: 1}}}]"),
+        4);
+    ASSERT_TRUE(isParallel(*pipeline));
+    ASSERT_TRUE(pipeline->getNext());
+
+    // Disposing of the pipeline must stop and join all consumer threads.
+    pipeline.reset();
+}
+
+}  // namespace
+}  // namespace monger
@@ -34,6 +34,7 @@
 #include <memory>
 
 #include "monger/base/init.h"
+#include "monger/db/field_ref.h"
 #include "monger/db/jsobj.h"
 #include "monger/db/matcher/expression_algo.h"
 #include "monger/db/pipeline/document.h"
@@ -206,6 +207,18 @@ StageConstraints DocumentSourceLookUp::constraints(Pipeline::SplitState) const {
 
 namespace {
 
+StringData strategyName(DocumentSourceLookUp::Strategy strategy) {
+    switch (strategy) {
+        case DocumentSourceLookUp::Strategy::kNestedLoop:
+            return "nestedLoop"_sd;
+        case DocumentSourceLookUp::Strategy::kBatchedNestedLoop:
+            return "batchedNestedLoop"_sd;
+        case DocumentSourceLookUp::Strategy::kHashJoin:
+            return "hashJoin"_sd;
+    }
+    MONGO_UNREACHABLE;
+}
+
 /**
  * Constructs a query of the following shape:
  *  {$or: [
@@ -230,10 +243,18 @@ BSONObj buildEqualityOrQuery(const std::string& fieldName, const BSONArray& valu
 DocumentSource::GetNextResult DocumentSourceLookUp::getNext() {
     pExpCtx->checkForInterrupt();
 
+    if (_strategy == Strategy::kHashJoin && !_hashJoin) {
+        buildHashJoin();
+    }
+
     if (_unwindSrc) {
         return unwindResult();
     }
 
+    if (joinsInBulk()) {
+        return joinedResult();
+    }
+
     auto nextInput = pSource->getNext();
     if (!nextInput.isAdvanced()) {
         return nextInput;
@@ -245,9 +266,19 @@ DocumentSource::GetNextResult DocumentSourceLookUp::getNext() {
     // '_unwindSrc' would be non-null, and we would not have made it here.
     invariant(!_matchSrc);
 
+    auto results = queryForeignResults(inputDoc);
+
+    MutableDocument output(std::move(inputDoc));
+    output.setNestedField(_as, Value(std::move(results)));
+    return output.freeze();
+}
+
+std::vector<Value> DocumentSourceLookUp::queryForeignResults(const Document& inputDoc) {
     if (!wasConstructedWithPipelineSyntax()) {
-        auto matchStage =
-            makeMatchStageFromInput(inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
+        auto matchStage = makeMatchStageFromInput(inputDoc,
+                                                  *_localField,
+                                                  _foreignField->fullPath(),
+                                                  _additionalFilter.value_or(BSONObj()));
         // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
         _resolvedPipeline.back() = matchStage;
     }
@@ -255,25 +286,240 @@ DocumentSource::GetNextResult DocumentSourceLookUp::getNext() {
     auto pipeline = buildPipeline(inputDoc);
 
     std::vector<Value> results;
-    int objsize = 0;
-    const auto maxBytes = internalLookupStageIntermediateDocumentMaxSizeBytes.load();
+    long long resultsSize = 0;
     while (auto result = pipeline->getNext()) {
-        objsize += result->getApproximateSize();
-        uassert(4568,
-                str::stream() << "Total size of documents in " << _fromNs.coll()
-                              << " matching pipeline's $lookup stage exceeds "
-                              << maxBytes
-                              << " bytes",
-
-                objsize <= maxBytes);
-        results.emplace_back(std::move(*result));
+        addResult(std::move(*result), &results, &resultsSize);
     }
     for (auto&& source : pipeline->getSources()) {
         if (source->usedDisk())
             _usedDisk = true;
     }
+    return results;
+}
 
-    MutableDocument output(std::move(inputDoc));
+void DocumentSourceLookUp::addResult(Document result,
+                                     std::vector<Value>* results,
+                                     long long* resultsSize) const {
+    const auto maxBytes = internalLookupStageIntermediateDocumentMaxSizeBytes.load();
+    *resultsSize += result.getApproximateSize();
+    uassert(4568,
+            str::stream() << "Total size of documents in " << _fromNs.coll()
+                          << " matching pipeline's $lookup stage exceeds "
+                          << maxBytes
+                          << " bytes",
+
+            *resultsSize <= maxBytes);
+    results->emplace_back(std::move(result));
+}
+
+boost::intrusive_ptr<DocumentSource> DocumentSourceLookUp::optimize() {
+    _strategy = chooseStrategy();
+    return this;
+}
+
+DocumentSourceLookUp::Strategy DocumentSourceLookUp::chooseStrategy() {
+    if (wasConstructedWithPipelineSyntax()) {
+        return Strategy::kNestedLoop;
+    }
+
+    // A query treats a numeric path component as an array index as well as a field name, which
+    // matching on the values at the path, as LookupHashJoin does, does not.
+    for (size_t i = 0; i < _foreignField->getPathLength(); ++i) {
+        if (FieldRef::isNumericPathComponentLenient(_foreignField->getFieldName(i))) {
+            return Strategy::kNestedLoop;
+        }
+    }
+
+    return shouldUseHashJoin() ? Strategy::kHashJoin : nestedLoopStrategy();
+}
+
+DocumentSourceLookUp::Strategy DocumentSourceLookUp::nestedLoopStrategy() const {
+    return internalDocumentSourceLookupBatchSize.load() > 1 ? Strategy::kBatchedNestedLoop
+                                                            : Strategy::kNestedLoop;
+}
+
+bool DocumentSourceLookUp::shouldUseHashJoin() {
+    // Only a top-level $lookup is considered, since the foreign collection would otherwise be
+    // hashed again for each execution of the enclosing sub-pipeline.
+    if (!internalDocumentSourceLookupEnableHashJoin.load() || pExpCtx->inMongers ||
+        pExpCtx->subPipelineDepth > 0 || !pExpCtx->opCtx) {
+        return false;
+    }
+
+    // The shards of a sharded foreign collection are queried through mongers, for each input
+    // document.
+    const auto& processInterface = pExpCtx->mongerProcessInterface;
+    if (processInterface->isSharded(pExpCtx->opCtx, _resolvedNs)) {
+        return false;
+    }
+
+    auto joinInfo = processInterface->getCollectionJoinInfo(pExpCtx, _resolvedNs, *_foreignField);
+
+    // The index cannot be used on the output of a view.
+    const bool isView = _resolvedPipeline.size() > 1;
+    return !joinInfo.joinFieldIsIndexed || isView ||
+        joinInfo.dataSizeBytes <= internalDocumentSourceLookupHashJoinMaxMemoryBytes.load();
+}
+
+void DocumentSourceLookUp::buildHashJoin() {
+    invariant(!_hashJoin);
+    _hashJoin = std::make_unique<LookupHashJoin>(
+        pExpCtx,
+        *_localField,
+        *_foreignField,
+        static_cast<size_t>(internalDocumentSourceLookupHashJoinMaxMemoryBytes.load()),
+        pExpCtx->allowDiskUse,
+        &_memoryTracker);
+
+    // Read the whole foreign collection, or view, through the filter absorbed from a following
+    // $match.
+    _resolvedPipeline.back() = BSON("$match" << _additionalFilter.value_or(BSONObj()));
+    auto pipeline = buildPipeline(Document());
+    while (auto foreignDoc = pipeline->getNext()) {
+        if (!_hashJoin->addForeign(*foreignDoc)) {
+            _hashJoin.reset();
+            _strategy = nestedLoopStrategy();
+            return;
+        }
+    }
+    _usedDisk = _usedDisk || pipeline->usedDisk();
+    _hashJoin->doneForeign();
+}
+
+DocumentSource::GetNextResult DocumentSourceLookUp::getNextJoined(LookupHashJoin::Joined* joined) {
+    if (_hashJoin) {
+        while (true) {
+            if (auto next = _hashJoin->getNext()) {
+                *joined = std::move(*next);
+                return GetNextResult(Document(joined->local));
+            }
+
+            if (_inputExhausted) {
+                return GetNextResult::makeEOF();
+            }
+
+            auto nextInput = pSource->getNext();
+            if (nextInput.isEOF()) {
+                _inputExhausted = true;
+                _hashJoin->doneLocal();
+                continue;
+            }
+            if (!nextInput.isAdvanced()) {
+                return nextInput;
+            }
+            _hashJoin->addLocal(nextInput.releaseDocument());
+        }
+    }
+
+    const size_t batchSize = internalDocumentSourceLookupBatchSize.load();
+    while (_batchResults.empty()) {
+        if (_inputExhausted) {
+            return GetNextResult::makeEOF();
+        }
+
+        while (_batch.size() < batchSize) {
+            auto nextInput = pSource->getNext();
+            if (nextInput.isEOF()) {
+                _inputExhausted = true;
+                break;
+            }
+            if (nextInput.isPaused()) {
+                // Rather than hold the documents read so far until the source resumes, join them
+                // now and return them after the pause.
+                joinBatch();
+                return nextInput;
+            }
+            _batch.push_back(nextInput.releaseDocument());
+        }
+        joinBatch();
+    }
+
+    *joined = std::move(_batchResults.front());
+    _batchResults.pop_front();
+    return GetNextResult(Document(joined->local));
+}
+
+void DocumentSourceLookUp::joinBatch() {
+    if (_batch.empty()) {
+        return;
+    }
+
+    // The matches of the batch are distributed with a LookupHashJoin of the query results, which
+    // must fit in its memory budget. The documents of a batch whose results do not fit, and those
+    // whose join keys it cannot look up, are queried for one at a time.
+    LookupHashJoin join(
+        pExpCtx,
+        *_localField,
+        *_foreignField,
+        static_cast<size_t>(internalDocumentSourceLookupHashJoinMaxMemoryBytes.load()),
+        false,
+        &_memoryTracker);
+
+    auto seenKeys = pExpCtx->getValueComparator().makeUnorderedValueSet();
+    std::vector<Value> keys;
+    for (auto&& doc : _batch) {
+        if (auto docKeys = join.localKeys(doc)) {
+            for (auto&& key : *docKeys) {
+                if (seenKeys.insert(key).second) {
+                    keys.push_back(key);
+                }
+            }
+        }
+    }
+
+    bool fits = true;
+    if (!keys.empty()) {
+        _resolvedPipeline.back() = makeMatchStageFromValues(
+            keys, _foreignField->fullPath(), _additionalFilter.value_or(BSONObj()));
+        auto pipeline = buildPipeline(Document());
+        while (fits) {
+            auto foreignDoc = pipeline->getNext();
+            if (!foreignDoc) {
+                break;
+            }
+            fits = join.addForeign(*foreignDoc);
+        }
+        _usedDisk = _usedDisk || pipeline->usedDisk();
+    }
+
+    if (fits) {
+        join.doneForeign();
+    }
+    for (auto&& doc : _batch) {
+        if (!fits) {
+            LookupHashJoin::Joined joined;
+            joined.local = std::move(doc);
+            joined.needsQuery = true;
+            _batchResults.push_back(std::move(joined));
+            continue;
+        }
+
+        join.addLocal(std::move(doc));
+        while (auto joined = join.getNext()) {
+            _batchResults.push_back(std::move(*joined));
+        }
+    }
+    _batch.clear();
+}
+
+DocumentSource::GetNextResult DocumentSourceLookUp::joinedResult() {
+    LookupHashJoin::Joined joined;
+    auto next = getNextJoined(&joined);
+    if (!next.isAdvanced()) {
+        return next;
+    }
+
+    std::vector<Value> results;
+    if (joined.needsQuery) {
+        results = queryForeignResults(joined.local);
+    } else {
+        long long resultsSize = 0;
+        for (auto&& match : joined.matches) {
+            addResult(std::move(match), &results, &resultsSize);
+        }
+    }
+
+    MutableDocument output(std::move(joined.local));
     output.setNestedField(_as, Value(std::move(results)));
     return output.freeze();
 }
@@ -456,6 +702,8 @@ Pipeline::SourceContainer::iterator DocumentSourceLookUp::doOptimizeAt(
 bool DocumentSourceLookUp::usedDisk() {
     if (_pipeline)
         _usedDisk = _usedDisk || _pipeline->usedDisk();
+    if (_hashJoin)
+        _usedDisk = _usedDisk || _hashJoin->spilled();
     return _usedDisk;
 }
 
@@ -465,27 +713,45 @@ void DocumentSourceLookUp::doDispose() {
         _pipeline->dispose(pExpCtx->opCtx);
         _pipeline.reset();
     }
+    if (_hashJoin) {
+        _usedDisk = _usedDisk || _hashJoin->spilled();
+        _hashJoin.reset();
+    }
+    _batch.clear();
+    _batchResults.clear();
 }
 
 BSONObj DocumentSourceLookUp::makeMatchStageFromInput(const Document& input,
                                                       const FieldPath& localFieldPath,
                                                       const std::string& foreignFieldName,
                                                       const BSONObj& additionalFilter) {
-    // Add the 'localFieldPath' of 'input' into 'localFieldList'. If 'localFieldPath' references a
+    // Add the 'localFieldPath' of 'input' into 'localFieldValues'. If 'localFieldPath' references a
     // field with an array in its path, we may need to join on multiple values, so we add each
-    // element to 'localFieldList'.
-    BSONArrayBuilder arrBuilder;
-    bool containsRegex = false;
+    // element to 'localFieldValues'.
+    std::vector<Value> localFieldValues;
     document_path_support::visitAllValuesAtPath(input, localFieldPath, [&](const Value& nextValue) {
-        arrBuilder << nextValue;
-        if (!containsRegex && nextValue.getType() == BSONType::RegEx) {
-            containsRegex = true;
-        }
+        localFieldValues.push_back(nextValue);
     });
 
-    if (arrBuilder.arrSize() == 0) {
+    if (localFieldValues.empty()) {
         // Missing values are treated as null.
-        arrBuilder << BSONNULL;
+        localFieldValues.push_back(Value(BSONNULL));
+    }
+
+    return makeMatchStageFromValues(localFieldValues, foreignFieldName, additionalFilter);
+}
+
+BSONObj DocumentSourceLookUp::makeMatchStageFromValues(const std::vector<Value>& localFieldValues,
+                                                       const std::string& foreignFieldName,
+                                                       const BSONObj& additionalFilter) {
+    invariant(!localFieldValues.empty());
+    BSONArrayBuilder arrBuilder;
+    bool containsRegex = false;
+    for (auto&& value : localFieldValues) {
+        arrBuilder << value;
+        if (!containsRegex && value.getType() == BSONType::RegEx) {
+            containsRegex = true;
+        }
     }
 
     const auto localFieldListSize = arrBuilder.arrSize();
@@ -557,36 +823,38 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
     // Loop until we get a document that has at least one match.
     // Note we may return early from this loop if our source stage is exhausted or if the unwind
     // source was asked to return empty arrays and we get a document without a match.
-    while (!_pipeline || !_nextValue) {
-        auto nextInput = pSource->getNext();
-        if (!nextInput.isAdvanced()) {
-            return nextInput;
-        }
-
-        _input = nextInput.releaseDocument();
+    while (!_nextValue) {
+        if (joinsInBulk()) {
+            LookupHashJoin::Joined joined;
+            auto next = getNextJoined(&joined);
+            if (!next.isAdvanced()) {
+                return next;
+            }
 
-        if (!wasConstructedWithPipelineSyntax()) {
-            BSONObj filter = _additionalFilter.value_or(BSONObj());
-            auto matchStage =
-                makeMatchStageFromInput(*_input, *_localField, _foreignField->fullPath(), filter);
-            // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
-            _resolvedPipeline.back() = matchStage;
-        }
+            _input = std::move(joined.local);
+            if (joined.needsQuery) {
+                buildUnwindPipeline();
+            } else {
+                if (_pipeline) {
+                    _usedDisk = _usedDisk || _pipeline->usedDisk();
+                    _pipeline->dispose(pExpCtx->opCtx);
+                    _pipeline.reset();
+                }
+                _unwoundMatches = std::move(joined.matches);
+                _unwoundMatchesPos = 0;
+            }
+        } else {
+            auto nextInput = pSource->getNext();
+            if (!nextInput.isAdvanced()) {
+                return nextInput;
+            }
 
-        if (_pipeline) {
-            _usedDisk = _usedDisk || _pipeline->usedDisk();
-            _pipeline->dispose(pExpCtx->opCtx);
+            _input = nextInput.releaseDocument();
+            buildUnwindPipeline();
         }
 
-        _pipeline = buildPipeline(*_input);
-
-        // The $lookup stage takes responsibility for disposing of its Pipeline, since it will
-        // potentially be used by multiple OperationContexts, and the $lookup stage is part of an
-        // outer Pipeline that will propagate dispose() calls before being destroyed.
-        _pipeline.get_deleter().dismissDisposal();
-
         _cursorIndex = 0;
-        _nextValue = _pipeline->getNext();
+        _nextValue = nextUnwoundMatch();
 
         if (_unwindSrc->preserveNullAndEmptyArrays() && !_nextValue) {
             // There were no results for this cursor, but the $unwind was asked to preserve empty
@@ -604,7 +872,7 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
 
     invariant(bool(_input) && bool(_nextValue));
     auto currentValue = *_nextValue;
-    _nextValue = _pipeline->getNext();
+    _nextValue = nextUnwoundMatch();
 
     // Move input document into output if this is the last or only result, otherwise perform a copy.
     MutableDocument output(_nextValue ? *_input : std::move(*_input));
@@ -618,6 +886,38 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
     return output.freeze();
 }
 
+void DocumentSourceLookUp::buildUnwindPipeline() {
+    if (!wasConstructedWithPipelineSyntax()) {
+        BSONObj filter = _additionalFilter.value_or(BSONObj());
+        auto matchStage =
+            makeMatchStageFromInput(*_input, *_localField, _foreignField->fullPath(), filter);
+        // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
+        _resolvedPipeline.back() = matchStage;
+    }
+
+    if (_pipeline) {
+        _usedDisk = _usedDisk || _pipeline->usedDisk();
+        _pipeline->dispose(pExpCtx->opCtx);
+    }
+
+    _pipeline = buildPipeline(*_input);
+
+    // The $lookup stage takes responsibility for disposing of its Pipeline, since it will
+    // potentially be used by multiple OperationContexts, and the $lookup stage is part of an
+    // outer Pipeline that will propagate dispose() calls before being destroyed.
+    _pipeline.get_deleter().dismissDisposal();
+}
+
+boost::optional<Document> DocumentSourceLookUp::nextUnwoundMatch() {
+    if (_pipeline) {
+        return _pipeline->getNext();
+    }
+    if (_unwoundMatchesPos < _unwoundMatches.size()) {
+        return std::move(_unwoundMatches[_unwoundMatchesPos++]);
+    }
+    return boost::none;
+}
+
 void DocumentSourceLookUp::copyVariablesToExpCtx(const Variables& vars,
                                                  const VariablesParseState& vps,
                                                  ExpressionContext* expCtx) {
@@ -701,6 +1001,10 @@ void DocumentSourceLookUp::serializeToArray(
             output[getSourceName()]["matching"] = Value(*_additionalFilter);
         }
 
+        if (!wasConstructedWithPipelineSyntax()) {
+            output[getSourceName()]["strategy"] = Value(strategyName(_strategy));
+        }
+
         array.push_back(Value(output.freeze()));
     } else {
         array.push_back(Value(output.freeze()));
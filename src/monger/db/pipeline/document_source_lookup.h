@@ -30,6 +30,7 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <deque>
 
 #include "monger/db/pipeline/document_source.h"
 #include "monger/db/pipeline/document_source_match.h"
@@ -37,6 +38,7 @@
 #include "monger/db/pipeline/document_source_unwind.h"
 #include "monger/db/pipeline/expression.h"
 #include "monger/db/pipeline/lite_parsed_pipeline.h"
+#include "monger/db/pipeline/lookup_hash_join.h"
 #include "monger/db/pipeline/lookup_set_cache.h"
 #include "monger/db/pipeline/value_comparator.h"
 
@@ -50,6 +52,15 @@ class DocumentSourceLookUp final : public DocumentSource {
 public:
     static constexpr size_t kMaxSubPipelineDepth = 20;
 
+    /**
+     * How a $lookup with localField/foreignField syntax finds the matches of its input documents.
+     * With a nested loop join, the foreign collection is queried once per input document. With a
+     * batched nested loop join, it is queried once for the join keys of a batch of input
+     * documents, and the results are distributed among them. With a hash join, it is read once
+     * into a LookupHashJoin.
+     */
+    enum class Strategy { kNestedLoop, kBatchedNestedLoop, kHashJoin };
+
     struct LetVariable {
         LetVariable(std::string name, boost::intrusive_ptr<Expression> expression, Variables::Id id)
             : name(std::move(name)), expression(std::move(expression)), id(id) {}
@@ -144,6 +155,23 @@ public:
 
     bool usedDisk() final;
 
+    /**
+     * Returns the tracker charged with the hash tables of the hash join and batched strategies.
+     */
+    const MemoryUsageTracker* getMemoryTracker() const final {
+        return _strategy == Strategy::kNestedLoop ? nullptr : &_memoryTracker;
+    }
+
+    /**
+     * Chooses the join strategy, which needs the optimized pipeline to know the final filter on
+     * the foreign collection.
+     */
+    boost::intrusive_ptr<DocumentSource> optimize() final;
+
+    Strategy getStrategy() const {
+        return _strategy;
+    }
+
     static boost::intrusive_ptr<DocumentSource> createFromBson(
         BSONElement elem, const boost::intrusive_ptr<ExpressionContext>& expCtx);
 
@@ -164,6 +192,14 @@ public:
                                            const std::string& foreignFieldName,
                                            const BSONObj& additionalFilter);
 
+    /**
+     * Builds the $match which queries the foreign collection for documents whose
+     * 'foreignFieldName' equals any of 'localFieldValues', which must not be empty.
+     */
+    static BSONObj makeMatchStageFromValues(const std::vector<Value>& localFieldValues,
+                                            const std::string& foreignFieldName,
+                                            const BSONObj& additionalFilter);
+
     /**
      * Helper to absorb an $unwind stage. Only used for testing this special behavior.
      */
@@ -267,6 +303,69 @@ private:
 
     GetNextResult unwindResult();
 
+    Strategy chooseStrategy();
+
+    /**
+     * Returns true if this $lookup is able to use a hash join, and it is expected to be cheaper
+     * than querying the foreign collection for each input document: if no index supports the
+     * foreign field, or if the foreign collection fits in the hash join's memory budget.
+     */
+    bool shouldUseHashJoin();
+
+    /**
+     * Returns the strategy which queries the foreign collection, batched unless disabled.
+     */
+    Strategy nestedLoopStrategy() const;
+
+    /**
+     * Returns true if input documents are joined through getNextJoined().
+     */
+    bool joinsInBulk() const {
+        return _hashJoin || _strategy == Strategy::kBatchedNestedLoop;
+    }
+
+    /**
+     * Reads the foreign collection into '_hashJoin'. Falls back to the nested loop join if it
+     * does not fit in memory and disk use is not allowed.
+     */
+    void buildHashJoin();
+
+    /**
+     * Adds input documents to the hash join, or to the current batch, until one of them comes back
+     * joined. Returns it, with its matches in 'joined', or else the pause or EOF from the source.
+     */
+    GetNextResult getNextJoined(LookupHashJoin::Joined* joined);
+
+    /**
+     * Queries the foreign collection for the join keys of the documents in '_batch', and moves
+     * them with their matches to '_batchResults'.
+     */
+    void joinBatch();
+
+    GetNextResult joinedResult();
+
+    /**
+     * Queries the foreign collection for the matches of 'inputDoc'.
+     */
+    std::vector<Value> queryForeignResults(const Document& inputDoc);
+
+    /**
+     * Appends 'result' to the matches of an input document, failing if their total size exceeds
+     * the limit on the intermediate document.
+     */
+    void addResult(Document result, std::vector<Value>* results, long long* resultsSize) const;
+
+    /**
+     * Builds '_pipeline' to query the foreign collection for the matches of '_input', to be
+     * unwound one at a time.
+     */
+    void buildUnwindPipeline();
+
+    /**
+     * Returns the next match of '_input' to unwind.
+     */
+    boost::optional<Document> nextUnwoundMatch();
+
     /**
      * Copies 'vars' and 'vps' to the Variables and VariablesParseState objects in 'expCtx'. These
      * copies provide access to 'let' defined variables in sub-pipeline execution.
@@ -349,6 +448,25 @@ private:
     std::unique_ptr<Pipeline, PipelineDeleter> _pipeline;
     boost::optional<Document> _input;
     boost::optional<Document> _nextValue;
+
+    Strategy _strategy = Strategy::kNestedLoop;
+
+    // The parent of the trackers of the LookupHashJoins, which outlives them.
+    MemoryUsageTracker _memoryTracker{pExpCtx->memoryTracker.get()};
+
+    // Set on the first call to getNext() if '_strategy' is kHashJoin.
+    std::unique_ptr<LookupHashJoin> _hashJoin;
+
+    // Used if '_strategy' is kBatchedNestedLoop.
+    std::vector<Document> _batch;
+    std::deque<LookupHashJoin::Joined> _batchResults;
+
+    // Set once the source is exhausted, when joining in bulk.
+    bool _inputExhausted = false;
+
+    // When unwinding the matches of '_input' from the hash join, rather than from '_pipeline'.
+    std::vector<Document> _unwoundMatches;
+    size_t _unwoundMatchesPos = 0;
 };
 
 }  // namespace monger
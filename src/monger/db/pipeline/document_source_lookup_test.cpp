@@ -504,10 +504,25 @@ public:
         return false;
     }
 
+    CollectionJoinInfo getCollectionJoinInfo(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                                             const NamespaceString& nss,
+                                             const FieldPath& joinField) const final {
+        return _joinInfo;
+    }
+
+    void setCollectionJoinInfo(CollectionJoinInfo joinInfo) {
+        _joinInfo = joinInfo;
+    }
+
+    int numPipelinesMade() const {
+        return _numPipelinesMade;
+    }
+
     std::unique_ptr<Pipeline, PipelineDeleter> makePipeline(
         const std::vector<BSONObj>& rawPipeline,
         const boost::intrusive_ptr<ExpressionContext>& expCtx,
         const MakePipelineOptions opts) final {
+        ++_numPipelinesMade;
         auto pipeline = uassertStatusOK(Pipeline::parse(rawPipeline, expCtx));
 
         if (opts.optimize) {
@@ -541,6 +556,8 @@ public:
 private:
     deque<DocumentSource::GetNextResult> _mockResults;
     bool _removeLeadingQueryStages = false;
+    CollectionJoinInfo _joinInfo;
+    int _numPipelinesMade = 0;
 };
 
 TEST_F(DocumentSourceLookUpTest, ShouldPropagatePauses) {
@@ -595,6 +612,125 @@ TEST_F(DocumentSourceLookUpTest, ShouldPropagatePauses) {
     lookup->dispose();
 }
 
+TEST_F(DocumentSourceLookUpTest, ShouldUseHashJoinOnUnindexedForeignField) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+
+    // Mock out the foreign collection. The stub process interface reports that no index supports
+    // the foreign field.
+    deque<DocumentSource::GetNextResult> mockForeignContents{
+        Document{{"_id", 0}, {"key", 0}}, Document{{"_id", 1}, {"key", 1}}, Document{{"_id", 2}}};
+    expCtx->mongerProcessInterface =
+        std::make_shared<MockMongerInterface>(std::move(mockForeignContents));
+
+    // Set up the $lookup stage.
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "foreignKey"_sd},
+                                         {"foreignField", "key"_sd},
+                                         {"as", "foreignDocs"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+    lookup->optimize();
+    ASSERT(lookup->getStrategy() == DocumentSourceLookUp::Strategy::kHashJoin);
+
+    vector<Value> explained;
+    lookup->serializeToArray(explained, ExplainOptions::Verbosity::kQueryPlanner);
+    ASSERT_EQ(explained.size(), 1UL);
+    ASSERT_VALUE_EQ(explained[0]["$lookup"]["strategy"], Value("hashJoin"_sd));
+
+    // Mock its input, pausing every other result. A null key is looked up with a query, which
+    // also matches the foreign document without the key.
+    auto mockLocalSource =
+        DocumentSourceMock::createForTest({Document{{"foreignKey", 1}},
+                                           DocumentSource::GetNextResult::makePauseExecution(),
+                                           Document{{"foreignKey", BSONNULL}}});
+    lookup->setSource(mockLocalSource.get());
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"foreignKey", 1},
+                                 {"foreignDocs",
+                                  vector<Value>{Value(Document{{"_id", 1}, {"key", 1}})}}}));
+
+    ASSERT_TRUE(lookup->getNext().isPaused());
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"foreignKey", BSONNULL},
+                                 {"foreignDocs", vector<Value>{Value(Document{{"_id", 2}})}}}));
+
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldQueryForBatchesOfInputOnIndexedForeignField) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+
+    // Mock out a foreign collection which is too large to hash, and is indexed on the foreign
+    // field.
+    deque<DocumentSource::GetNextResult> mockForeignContents{
+        Document{{"_id", 0}, {"key", 1}}, Document{{"_id", 1}, {"key", 2}}, Document{{"_id", 2}}};
+    auto mongerInterface = std::make_shared<MockMongerInterface>(std::move(mockForeignContents));
+    mongerInterface->setCollectionJoinInfo(
+        {internalDocumentSourceLookupHashJoinMaxMemoryBytes.load() + 1, true});
+    expCtx->mongerProcessInterface = mongerInterface;
+
+    // Set up the $lookup stage.
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "foreignKey"_sd},
+                                         {"foreignField", "key"_sd},
+                                         {"as", "foreignDocs"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+    lookup->optimize();
+    ASSERT(lookup->getStrategy() == DocumentSourceLookUp::Strategy::kBatchedNestedLoop);
+
+    // The documents read before a pause are joined as a batch, and returned after it.
+    auto mockLocalSource =
+        DocumentSourceMock::createForTest({Document{{"foreignKey", 1}},
+                                           DocumentSource::GetNextResult::makePauseExecution(),
+                                           Document{{"foreignKey", 2}},
+                                           Document{{"foreignKey", 3}},
+                                           Document{{"foreignKey", 1}},
+                                           Document{{"foreignKey", BSONNULL}}});
+    lookup->setSource(mockLocalSource.get());
+
+    ASSERT_TRUE(lookup->getNext().isPaused());
+    ASSERT_EQ(mongerInterface->numPipelinesMade(), 1);
+
+    const Document foreign0{{"_id", 0}, {"key", 1}};
+    const Document foreign1{{"_id", 1}, {"key", 2}};
+    const std::vector<Document> expected{
+        Document{{"foreignKey", 1}, {"foreignDocs", vector<Value>{Value(foreign0)}}},
+        Document{{"foreignKey", 2}, {"foreignDocs", vector<Value>{Value(foreign1)}}},
+        Document{{"foreignKey", 3}, {"foreignDocs", vector<Value>{}}},
+        Document{{"foreignKey", 1}, {"foreignDocs", vector<Value>{Value(foreign0)}}},
+        Document{{"foreignKey", BSONNULL},
+                 {"foreignDocs", vector<Value>{Value(Document{{"_id", 2}})}}}};
+    for (auto&& expectedDoc : expected) {
+        auto next = lookup->getNext();
+        ASSERT_TRUE(next.isAdvanced());
+        ASSERT_DOCUMENT_EQ(next.releaseDocument(), expectedDoc);
+    }
+    ASSERT_TRUE(lookup->getNext().isEOF());
+
+    // One query for each batch, and one for the null key.
+    ASSERT_EQ(mongerInterface->numPipelinesMade(), 3);
+    lookup->dispose();
+}
+
 TEST_F(DocumentSourceLookUpTest, ShouldPropagatePausesWhileUnwinding) {
     auto expCtx = getExpCtx();
     NamespaceString fromNs("test", "foreign");
@@ -111,6 +111,11 @@ public:
         return {GetModPathsReturn::Type::kFiniteSet, std::set<std::string>{}, {}};
     }
 
+    BSONObjSet getOutputSorts() final {
+        // This stage returns the documents of its source in the same order.
+        return pSource ? pSource->getOutputSorts() : DocumentSource::getOutputSorts();
+    }
+
     /**
      * Access the MatchExpression stored inside the DocumentSourceMatch. Does not release ownership.
      */
@@ -95,10 +95,17 @@ public:
         return boost::none;
     }
 
+    BSONObjSet getOutputSorts() override {
+        return sorts;
+    }
+
     bool isDisposed = false;
     bool isDetachedFromOpCtx = false;
     bool isOptimized = false;
 
+    // The sort orders this stage reports its documents to follow.
+    BSONObjSet sorts = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+
 protected:
     void doDispose() override {
         isDisposed = true;
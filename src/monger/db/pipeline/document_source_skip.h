@@ -82,6 +82,11 @@ public:
         return DepsTracker::State::SEE_NEXT;  // This doesn't affect needed fields
     }
 
+    BSONObjSet getOutputSorts() final {
+        // This stage returns the documents of its source in the same order.
+        return pSource ? pSource->getOutputSorts() : DocumentSource::getOutputSorts();
+    }
+
     /**
      * The $skip stage must run on the merging half of the pipeline.
      */
@@ -53,8 +53,8 @@ using std::vector;
 
 namespace {
 
-Value missingToNull(Value maybeMissing) {
-    return maybeMissing.missing() ? Value(BSONNULL) : maybeMissing;
+Value replaceMissing(Value maybeMissing, const Value& replacement) {
+    return maybeMissing.missing() ? replacement : maybeMissing;
 }
 
 /**
@@ -62,41 +62,22 @@ Value missingToNull(Value maybeMissing) {
  * key. If 'sortPatternSize' is 1, returns a BSON object with 'value' as it's only value - and an
  * empty field name. Otherwise asserts that 'value' is an array of length 'sortPatternSize', and
  * returns a BSONObj with one field for each value in the array, each field using the empty field
- * name.
+ * name. Missing values don't serialize in this format, so they are replaced by
+ * 'missingReplacement'.
  */
-BSONObj serializeSortKey(size_t sortPatternSize, Value value) {
-    // Missing values don't serialize correctly in this format, so use nulls instead, since they are
-    // considered equivalent with woCompare().
+BSONObj serializeSortKey(size_t sortPatternSize, Value value, const Value& missingReplacement) {
     if (sortPatternSize == 1) {
-        return BSON("" << missingToNull(value));
+        return BSON("" << replaceMissing(value, missingReplacement));
     }
     invariant(value.isArray());
     invariant(value.getArrayLength() == sortPatternSize);
     BSONObjBuilder bb;
     for (auto&& val : value.getArray()) {
-        bb << "" << missingToNull(val);
+        bb << "" << replaceMissing(val, missingReplacement);
     }
     return bb.obj();
 }
 
-/**
- * Converts a BSONObj representing a serialized sort key into a Value, which we use for in-memory
- * comparisons. BSONObj {'': 1, '': [2, 3]} becomes Value [1, [2, 3]].
- */
-Value deserializeSortKey(size_t sortPatternSize, BSONObj bsonSortKey) {
-    vector<Value> keys;
-    keys.reserve(sortPatternSize);
-    for (auto&& elt : bsonSortKey) {
-        keys.push_back(Value{elt});
-    }
-    invariant(keys.size() == sortPatternSize);
-    if (sortPatternSize == 1) {
-        // As a special case for a sort on a single field, we do not put the keys into an array.
-        return keys[0];
-    }
-    return Value{std::move(keys)};
-}
-
 /**
  * Generates a new file name on each call using a static, atomic and monotonically increasing
  * number.
@@ -117,7 +98,7 @@ std::string nextFileName() {
 constexpr StringData DocumentSourceSort::kStageName;
 
 DocumentSourceSort::DocumentSourceSort(const intrusive_ptr<ExpressionContext>& pExpCtx)
-    : DocumentSource(pExpCtx) {}
+    : DocumentSource(pExpCtx), _memoryTracker(pExpCtx->memoryTracker.get()) {}
 
 REGISTER_DOCUMENT_SOURCE(sort,
                          LiteParsedDocumentSourceDefault::parse,
@@ -139,7 +120,13 @@ DocumentSource::GetNextResult DocumentSourceSort::getNext() {
         return GetNextResult::makeEOF();
     }
 
-    return _output->next().second;
+    auto next = _output->next();
+    if (const long long held = _memoryTracker.currentMemoryBytes()) {
+        // The documents sorted in memory are released one by one as they are returned.
+        _memoryTracker.add(-std::min<long long>(
+            held, next.first.memUsageForSorter() + next.second.memUsageForSorter()));
+    }
+    return std::move(next.second);
 }
 
 void DocumentSourceSort::serializeToArray(
@@ -162,6 +149,7 @@ void DocumentSourceSort::serializeToArray(
 
 void DocumentSourceSort::doDispose() {
     _output.reset();
+    _memoryTracker.set(0);
 }
 
 long long DocumentSourceSort::getLimit() const {
@@ -198,6 +186,23 @@ Document DocumentSourceSort::serializeSortKeyPattern(SortKeySerialization serial
     return keyObj.freeze();
 }
 
+BSONObjSet DocumentSourceSort::getOutputSorts() {
+    // Only the fields before the first $meta sort form a sort pattern over the output documents.
+    BSONObjBuilder sortPattern;
+    for (auto&& part : _sortPattern) {
+        if (!part.fieldPath) {
+            break;
+        }
+        sortPattern.append(part.fieldPath->fullPath(), part.isAscending ? 1 : -1);
+    }
+
+    auto sorts = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+    if (!sortPattern.asTempObj().isEmpty()) {
+        sorts.insert(sortPattern.obj());
+    }
+    return sorts;
+}
+
 Pipeline::SourceContainer::iterator DocumentSourceSort::doOptimizeAt(
     Pipeline::SourceContainer::iterator itr, Pipeline::SourceContainer* container) {
     invariant(*itr == this);
@@ -311,6 +316,12 @@ intrusive_ptr<DocumentSourceSort> DocumentSourceSort::create(
 
     uassert(15976, "$sort stage must have at least one sort key", !pSort->_sortPattern.empty());
 
+    BSONObjBuilder directions;
+    for (auto&& patternPart : pSort->_sortPattern) {
+        directions.append("", patternPart.isAscending ? 1 : -1);
+    }
+    pSort->_sortKeyPattern.emplace(directions.obj());
+
     pSort->_sortKeyGen = SortKeyGenerator{
         // The SortKeyGenerator expects the expressions to be serialized in order to detect a sort
         // by a metadata field.
@@ -355,24 +366,41 @@ DocumentSource::GetNextResult DocumentSourceSort::populate() {
 void DocumentSourceSort::loadDocument(Document&& doc) {
     invariant(!_populated);
     if (!_sorter) {
-        _sorter.reset(MySorter::make(makeSortOptions(), Comparator(*this)));
+        _sorter.reset(MySorter::make(makeSortOptions(), SortKeyBytesComparator()));
     }
 
-    Value sortKey;
+    SortKeyString sortKey;
     Document docForSorter;
     // We always need to extract the sort key if we've reached this point. If the query system had
     // already computed the sort key we'd have split the pipeline there, would be merging presorted
     // documents, and wouldn't use this method.
     std::tie(sortKey, docForSorter) = extractSortKey(std::move(doc));
     _sorter->add(sortKey, docForSorter);
+
+    // The sorter spills by itself past the limit of this stage, but must be made to spill when the
+    // operation as a whole is over its budget, unless other stages alone are over it.
+    _memoryTracker.set(_sorter->memUsed());
+    if (_memoryTracker.shouldReleaseMemory()) {
+        uassert(ErrorCodes::ExceededMemoryLimit,
+                "Exceeded the memory limit of the operation in $sort, but did not opt in to "
+                "external sorting. Pass allowDiskUse:true to opt in.",
+                pExpCtx->allowDiskUse && !pExpCtx->inMongers);
+        _sorter->spill();
+        _memoryTracker.set(_sorter->memUsed());
+    }
 }
 
 void DocumentSourceSort::loadingDone() {
     if (!_sorter) {
-        _sorter.reset(MySorter::make(makeSortOptions(), Comparator(*this)));
+        _sorter.reset(MySorter::make(makeSortOptions(), SortKeyBytesComparator()));
     }
     _output.reset(_sorter->done());
-    _usedDisk = _sorter->usedDisk() || _usedDisk;
+    if (_sorter->usedDisk()) {
+        // The output is merged from disk, so the budget of the operation is released to the stages
+        // after this one. Otherwise '_output' still holds everything charged so far.
+        _usedDisk = true;
+        _memoryTracker.set(0);
+    }
     _sorter.reset();
     _populated = true;
 }
@@ -463,72 +491,38 @@ BSONObj DocumentSourceSort::extractKeyWithArray(const Document& doc) const {
     return uassertStatusOK(_sortKeyGen->getSortKey(std::move(bsonDoc), &metadata));
 }
 
-std::pair<Value, Document> DocumentSourceSort::extractSortKey(Document&& doc) const {
-    boost::optional<BSONObj> serializedSortKey;  // Only populated if we need to merge with other
-                                                 // sorted results later. Serialized in the standard
-                                                 // BSON sort key format with empty field names,
-                                                 // e.g. {'': 1, '': [2, 3]}.
-
-    Value inMemorySortKey;  // The Value we will use for comparisons within the sorter.
+std::pair<SortKeyString, Document> DocumentSourceSort::extractSortKey(Document&& doc) const {
+    BSONObj bsonSortKey;  // Serialized in the standard BSON sort key format with empty field names,
+                          // e.g. {'': 1, '': [2, 3]}.
+    SortKeyString sortKey;
 
+    // The sort keys hold collation comparison keys, so they are encoded without a collator.
     auto fastKey = extractKeyFast(doc);
     if (fastKey.isOK()) {
-        inMemorySortKey = std::move(fastKey.getValue());
+        // A missing value compares equal to undefined, and before null, so it is encoded as
+        // undefined. The serialized key which is merged with other sorted results keeps using null,
+        // which the merging side expects of a missing value.
+        sortKey = SortKeyString(
+            serializeSortKey(_sortPattern.size(), fastKey.getValue(), Value(BSONUndefined)),
+            *_sortKeyPattern);
         if (pExpCtx->needsMerge) {
-            serializedSortKey = serializeSortKey(_sortPattern.size(), inMemorySortKey);
+            bsonSortKey = serializeSortKey(
+                _sortPattern.size(), std::move(fastKey.getValue()), Value(BSONNULL));
         }
     } else {
         // We have to do it the slow way - through the sort key generator. This will generate a BSON
-        // sort key, which is an object with empty field names. We then need to convert this BSON
-        // representation into the corresponding array of keys as a Value. BSONObj {'': 1, '': [2,
-        // 3]} becomes Value [1, [2, 3]].
-        serializedSortKey = extractKeyWithArray(doc);
-        inMemorySortKey = deserializeSortKey(_sortPattern.size(), *serializedSortKey);
+        // sort key, which is an object with empty field names.
+        bsonSortKey = extractKeyWithArray(doc);
+        sortKey = SortKeyString(bsonSortKey, *_sortKeyPattern);
     }
 
     MutableDocument toBeSorted(std::move(doc));
     if (pExpCtx->needsMerge) {
         // We need to be merged, so will have to be serialized. Save the sort key here to avoid
         // re-computing it during the merge.
-        invariant(serializedSortKey);
-        toBeSorted.setSortKeyMetaField(*serializedSortKey);
+        toBeSorted.setSortKeyMetaField(bsonSortKey);
     }
-    return {inMemorySortKey, toBeSorted.freeze()};
-}
-
-int DocumentSourceSort::compare(const Value& lhs, const Value& rhs) const {
-    // DocumentSourceSort::populate() has already guaranteed that the sort key is non-empty.
-    // However, the tricky part is deciding what to do if none of the sort keys are present. In that
-    // case, consider the document "less".
-    //
-    // Note that 'comparator' must use binary comparisons here, as both 'lhs' and 'rhs' are
-    // collation comparison keys.
-    ValueComparator comparator;
-    const size_t n = _sortPattern.size();
-    if (n == 1) {  // simple fast case
-        if (_sortPattern[0].isAscending)
-            return comparator.compare(lhs, rhs);
-        else
-            return -comparator.compare(lhs, rhs);
-    }
-
-    // compound sort
-    for (size_t i = 0; i < n; i++) {
-        int cmp = comparator.compare(lhs[i], rhs[i]);
-        if (cmp) {
-            /* if necessary, adjust the return value by the key ordering */
-            if (!_sortPattern[i].isAscending)
-                cmp = -cmp;
-
-            return cmp;
-        }
-    }
-
-    /*
-      If we got here, everything matched (or didn't exist), so we'll
-      consider the documents equal for purposes of this sort.
-    */
-    return 0;
+    return {std::move(sortKey), toBeSorted.freeze()};
 }
 
 boost::optional<DocumentSource::DistributedPlanLogic> DocumentSourceSort::distributedPlanLogic() {
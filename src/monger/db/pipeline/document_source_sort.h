@@ -34,6 +34,7 @@
 #include "monger/db/pipeline/document_source_limit.h"
 #include "monger/db/pipeline/expression.h"
 #include "monger/db/query/query_knobs_gen.h"
+#include "monger/db/sorter/sort_key_string.h"
 #include "monger/db/sorter/sorter.h"
 
 namespace monger {
@@ -90,6 +91,8 @@ public:
 
     DepsTracker::State getDependencies(DepsTracker* deps) const final;
 
+    BSONObjSet getOutputSorts() final;
+
     boost::optional<DistributedPlanLogic> distributedPlanLogic() final;
     bool canRunInParallelBeforeWriteStage(
         const std::set<std::string>& nameOfShardKeyFieldsUponEntryToStage) const final;
@@ -145,6 +148,10 @@ public:
      */
     bool usedDisk() final;
 
+    const MemoryUsageTracker* getMemoryTracker() const final {
+        return &_memoryTracker;
+    }
+
     /**
      * Instructs the sort stage to use the given set of cursors as inputs, to merge documents that
      * have already been sorted.
@@ -168,19 +175,7 @@ protected:
     void doDispose() final;
 
 private:
-    using MySorter = Sorter<Value, Document>;
-
-    // For MySorter.
-    class Comparator {
-    public:
-        explicit Comparator(const DocumentSourceSort& source) : _source(source) {}
-        int operator()(const MySorter::Data& lhs, const MySorter::Data& rhs) const {
-            return _source.compare(lhs.first, rhs.first);
-        }
-
-    private:
-        const DocumentSourceSort& _source;
-    };
+    using MySorter = Sorter<SortKeyString, Document>;
 
     explicit DocumentSourceSort(const boost::intrusive_ptr<ExpressionContext>& pExpCtx);
 
@@ -201,15 +196,15 @@ private:
     SortOptions makeSortOptions() const;
 
     /**
-     * Returns the sort key for 'doc', as well as the document that should be entered into the
-     * sorter to eventually be returned. If we will need to later merge the sorted results with
-     * other results, this method adds the sort key as metadata onto 'doc' to speed up the merge
-     * later.
+     * Returns the sort key for 'doc', encoded for comparison by the sorter, as well as the document
+     * that should be entered into the sorter to eventually be returned. If we will need to later
+     * merge the sorted results with other results, this method adds the sort key as metadata onto
+     * 'doc' to speed up the merge later.
      *
      * Attempts to generate the key using a fast path that does not handle arrays. If an array is
      * encountered, falls back on extractKeyWithArray().
      */
-    std::pair<Value, Document> extractSortKey(Document&& doc) const;
+    std::pair<SortKeyString, Document> extractSortKey(Document&& doc) const;
 
     /**
      * Returns the sort key for 'doc' based on the SortPattern, or ErrorCodes::InternalError if an
@@ -236,8 +231,6 @@ private:
      */
     Value getCollationComparisonKey(const Value& val) const;
 
-    int compare(const Value& lhs, const Value& rhs) const;
-
     /**
      * Absorbs 'limit', enabling a top-k sort. It is safe to call this multiple times, it will keep
      * the smallest limit.
@@ -256,6 +249,9 @@ private:
 
     SortPattern _sortPattern;
 
+    // The directions of '_sortPattern', which sort keys are encoded with.
+    boost::optional<SortKeyString::Pattern> _sortKeyPattern;
+
     // The set of paths on which we're sorting.
     std::set<std::string> _paths;
 
@@ -266,6 +262,9 @@ private:
     std::unique_ptr<MySorter> _sorter;
     std::unique_ptr<MySorter::Iterator> _output;
     bool _usedDisk = false;
+
+    // Charged with the data held by '_sorter', and then by '_output' if it is sorted in memory.
+    MemoryUsageTracker _memoryTracker;
 };
 
 }  // namespace monger
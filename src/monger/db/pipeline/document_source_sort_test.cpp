@@ -183,6 +183,24 @@ TEST_F(DocumentSourceSortTest, ReportsNoPathsModified) {
     ASSERT_EQUALS(0U, modifiedPaths.paths.size());
 }
 
+TEST_F(DocumentSourceSortTest, ReportsSortPatternAsOutputSort) {
+    createSort(BSON("a" << 1 << "b.c" << -1));
+    auto sorts = sort()->getOutputSorts();
+    ASSERT_EQUALS(1U, sorts.size());
+    ASSERT_BSONOBJ_EQ(*sorts.begin(), BSON("a" << 1 << "b.c" << -1));
+}
+
+TEST_F(DocumentSourceSortTest, ReportsOnlyFieldsBeforeMetaSortAsOutputSort) {
+    auto sort = DocumentSourceSort::create(
+        getExpCtx(), BSON("a" << 1 << "score" << metaTextScore << "b" << 1));
+    auto sorts = sort->getOutputSorts();
+    ASSERT_EQUALS(1U, sorts.size());
+    ASSERT_BSONOBJ_EQ(*sorts.begin(), BSON("a" << 1));
+
+    sort = DocumentSourceSort::create(getExpCtx(), BSON("score" << metaTextScore));
+    ASSERT(sort->getOutputSorts().empty());
+}
+
 class DocumentSourceSortExecutionTest : public DocumentSourceSortTest {
 public:
     void checkResults(deque<DocumentSource::GetNextResult> inputDocs,
@@ -304,6 +322,24 @@ TEST_F(DocumentSourceSortExecutionTest, NullValue) {
                  "[{_id:1,a:null},{_id:0,a:1}]");
 }
 
+/** Missing and undefined values compare equal, and before null. */
+TEST_F(DocumentSourceSortExecutionTest, MissingNullAndUndefinedValues) {
+    deque<DocumentSource::GetNextResult> inputs = {Document{{"_id", 0}, {"a", BSONNULL}},
+                                                   Document{{"_id", 1}, {"a", BSONUndefined}},
+                                                   Document{{"_id", 2}},
+                                                   Document{{"_id", 3}, {"a", BSONNULL}},
+                                                   Document{{"_id", 4}, {"a", 1}}};
+    checkResults(inputs,
+                 BSON("a" << 1),
+                 "[{_id:1,a:undefined},{_id:2},{_id:0,a:null},{_id:3,a:null},{_id:4,a:1}]");
+    checkResults(inputs,
+                 BSON("a" << -1),
+                 "[{_id:4,a:1},{_id:0,a:null},{_id:3,a:null},{_id:1,a:undefined},{_id:2}]");
+    checkResults(inputs,
+                 BSON("a" << 1 << "_id" << -1),
+                 "[{_id:2},{_id:1,a:undefined},{_id:3,a:null},{_id:0,a:null},{_id:4,a:1}]");
+}
+
 /**
  * Order by text score.
  */
@@ -448,6 +484,118 @@ TEST_F(DocumentSourceSortExecutionTest,
     ASSERT_THROWS_CODE(sort->getNext(), AssertionException, 16819);
 }
 
+TEST_F(DocumentSourceSortExecutionTest, ShouldSpillWhenTheOperationIsOverItsMemoryBudget) {
+    auto expCtx = getExpCtx();
+    unittest::TempDir tempDir("DocumentSourceSortTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+    expCtx->memoryTracker = std::make_shared<MemoryUsageTracker>(nullptr, 1500);
+
+    auto sort = DocumentSourceSort::create(expCtx, BSON("_id" << -1), -1, 100 * 1024 * 1024);
+
+    string largeStr(1000, 'x');
+    auto mock = DocumentSourceMock::createForTest({Document{{"_id", 0}, {"largeStr", largeStr}},
+                                                   Document{{"_id", 1}, {"largeStr", largeStr}},
+                                                   Document{{"_id", 2}, {"largeStr", largeStr}}});
+    sort->setSource(mock.get());
+
+    for (int id = 2; id >= 0; --id) {
+        auto next = sort->getNext();
+        ASSERT_TRUE(next.isAdvanced());
+        ASSERT_VALUE_EQ(next.releaseDocument()["_id"], Value(id));
+    }
+    ASSERT_TRUE(sort->getNext().isEOF());
+    ASSERT_TRUE(sort->usedDisk());
+    ASSERT_GT(sort->getMemoryTracker()->peakTrackedMemoryBytes(), 1000);
+}
+
+TEST_F(DocumentSourceSortExecutionTest,
+       ShouldErrorIfTheOperationIsOverItsMemoryBudgetWithoutSpilling) {
+    auto expCtx = getExpCtx();
+    expCtx->allowDiskUse = false;
+    expCtx->memoryTracker = std::make_shared<MemoryUsageTracker>(nullptr, 1500);
+
+    auto sort = DocumentSourceSort::create(expCtx, BSON("_id" << -1), -1, 100 * 1024 * 1024);
+
+    string largeStr(1000, 'x');
+    auto mock = DocumentSourceMock::createForTest({Document{{"_id", 0}, {"largeStr", largeStr}},
+                                                   Document{{"_id", 1}, {"largeStr", largeStr}}});
+    sort->setSource(mock.get());
+
+    ASSERT_THROWS_CODE(sort->getNext(), AssertionException, ErrorCodes::ExceededMemoryLimit);
+}
+
+TEST_F(DocumentSourceSortExecutionTest, ShouldNotSpillWhenOtherStagesAloneAreOverTheBudget) {
+    auto expCtx = getExpCtx();
+    unittest::TempDir tempDir("DocumentSourceSortTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+    expCtx->memoryTracker = std::make_shared<MemoryUsageTracker>(nullptr, 1500);
+    MemoryUsageTracker otherStage(expCtx->memoryTracker.get());
+    otherStage.add(2000);
+
+    auto sort = DocumentSourceSort::create(expCtx, BSON("_id" << -1), -1, 100 * 1024 * 1024);
+
+    string largeStr(1000, 'x');
+    auto mock = DocumentSourceMock::createForTest({Document{{"_id", 0}, {"largeStr", largeStr}},
+                                                   Document{{"_id", 1}, {"largeStr", largeStr}},
+                                                   Document{{"_id", 2}, {"largeStr", largeStr}}});
+    sort->setSource(mock.get());
+
+    for (int id = 2; id >= 0; --id) {
+        auto next = sort->getNext();
+        ASSERT_TRUE(next.isAdvanced());
+        ASSERT_VALUE_EQ(next.releaseDocument()["_id"], Value(id));
+    }
+    ASSERT_TRUE(sort->getNext().isEOF());
+    ASSERT_FALSE(sort->usedDisk());
+}
+
+TEST_F(DocumentSourceSortExecutionTest, ShouldReleaseItsMemoryAsTheInMemoryOutputIsReturned) {
+    auto expCtx = getExpCtx();
+    expCtx->memoryTracker = std::make_shared<MemoryUsageTracker>(nullptr, 100 * 1024 * 1024);
+
+    auto sort = DocumentSourceSort::create(expCtx, BSON("_id" << -1), -1, 100 * 1024 * 1024);
+
+    string largeStr(1000, 'x');
+    auto mock = DocumentSourceMock::createForTest({Document{{"_id", 0}, {"largeStr", largeStr}},
+                                                   Document{{"_id", 1}, {"largeStr", largeStr}}});
+    sort->setSource(mock.get());
+
+    // The document which was not returned yet is still held, and charged, by the sort.
+    ASSERT_TRUE(sort->getNext().isAdvanced());
+    ASSERT_GT(sort->getMemoryTracker()->peakTrackedMemoryBytes(), 2000);
+    ASSERT_GT(sort->getMemoryTracker()->currentMemoryBytes(), 1000);
+    ASSERT_LT(sort->getMemoryTracker()->currentMemoryBytes(), 2000);
+    ASSERT_EQ(expCtx->memoryTracker->currentMemoryBytes(),
+              sort->getMemoryTracker()->currentMemoryBytes());
+
+    ASSERT_TRUE(sort->getNext().isAdvanced());
+    ASSERT_EQ(sort->getMemoryTracker()->currentMemoryBytes(), 0);
+    ASSERT_TRUE(sort->getNext().isEOF());
+    ASSERT_EQ(expCtx->memoryTracker->currentMemoryBytes(), 0);
+}
+
+TEST_F(DocumentSourceSortExecutionTest, ShouldReleaseItsMemoryOnceLoadingIsDoneIfItSpilled) {
+    auto expCtx = getExpCtx();
+    unittest::TempDir tempDir("DocumentSourceSortTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+
+    auto sort = DocumentSourceSort::create(expCtx, BSON("_id" << -1), -1, 1500);
+
+    string largeStr(1000, 'x');
+    auto mock = DocumentSourceMock::createForTest({Document{{"_id", 0}, {"largeStr", largeStr}},
+                                                   Document{{"_id", 1}, {"largeStr", largeStr}},
+                                                   Document{{"_id", 2}, {"largeStr", largeStr}}});
+    sort->setSource(mock.get());
+
+    ASSERT_TRUE(sort->getNext().isAdvanced());
+    ASSERT_TRUE(sort->usedDisk());
+    ASSERT_EQ(sort->getMemoryTracker()->currentMemoryBytes(), 0);
+    ASSERT_EQ(expCtx->memoryTracker->currentMemoryBytes(), 0);
+}
+
 TEST_F(DocumentSourceSortExecutionTest, ShouldCorrectlyTrackMemoryUsageBetweenPauses) {
     auto expCtx = getExpCtx();
     expCtx->allowDiskUse = false;
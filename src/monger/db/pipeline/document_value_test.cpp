@@ -156,6 +156,134 @@ TEST(DocumentSerialization, CannotSerializeDocumentThatExceedsDepthLimit) {
     throwaway.abandon();
 }
 
+TEST(DocumentLazyConstruction, LookupsMatchEagerConversion) {
+    BSONObj bson = BSON("a" << 1 << "b"
+                            << "q"
+                            << "c"
+                            << BSON("d" << 2)
+                            << "e"
+                            << BSON_ARRAY(1 << 2));
+    Document document = Document::fromBsonLazily(bson);
+    ASSERT_VALUE_EQ(Value("q"_sd), document["b"]);
+    ASSERT_VALUE_EQ(Value(1), document["a"]);
+    ASSERT_VALUE_EQ(Value(2), document.getNestedField(FieldPath("c.d")));
+    ASSERT(document["missing"].missing());
+    ASSERT_EQUALS(4U, document.size());
+    ASSERT_DOCUMENT_EQ(Document(bson), document);
+    assertRoundTrips(document);
+}
+
+TEST(DocumentLazyConstruction, LookupOfFirstFieldLeavesLaterFieldsUnloaded) {
+    BSONObj bson = BSON("a" << 1 << "b" << 2 << "c" << 3);
+    auto storage = make_intrusive<DocumentStorage>(bson, Value(), 0);
+    ASSERT_VALUE_EQ(Value(1), storage->getField("a"_sd));
+    ASSERT_GT(storage->getBackingBsonSize(), 0U);
+
+    size_t nCached = 0;
+    for (DocumentStorageIterator it = storage->iteratorCacheOnly(); !it.atEnd(); it.advance()) {
+        ASSERT_EQUALS("a", it->nameSD());
+        ++nCached;
+    }
+    ASSERT_EQUALS(1U, nCached);
+
+    // Looking up a field which was not loaded yet still finds it.
+    ASSERT_VALUE_EQ(Value(2), storage->getField("b"_sd));
+    ASSERT_GT(storage->getBackingBsonSize(), 0U);
+
+    storage->fillCache();
+    ASSERT_EQUALS(0U, storage->getBackingBsonSize());
+    ASSERT_EQUALS(3U, storage->size());
+}
+
+TEST(DocumentLazyConstruction, PreservesFieldOrderAfterOutOfOrderLookups) {
+    Document document = Document::fromBsonLazily(BSON("a" << 1 << "b" << 2 << "c" << 3));
+    ASSERT_VALUE_EQ(Value(3), document["c"]);
+    ASSERT_VALUE_EQ(Value(1), document["a"]);
+    ASSERT_EQUALS("a", getNthField(document, 0).first.toString());
+    ASSERT_EQUALS("b", getNthField(document, 1).first.toString());
+    ASSERT_EQUALS("c", getNthField(document, 2).first.toString());
+}
+
+TEST(DocumentLazyConstruction, DuplicateFieldNameReturnsFirstValue) {
+    BSONObj bson = BSON("a" << 1 << "b" << 2 << "a" << 3);
+    Document document = Document::fromBsonLazily(bson);
+    ASSERT_VALUE_EQ(Value(1), document["a"]);
+    ASSERT_VALUE_EQ(Value(2), document["b"]);
+    ASSERT_BSONOBJ_EQ(bson, document.toBson());
+}
+
+TEST(DocumentLazyConstruction, ModifyingPartiallyLoadedDocumentKeepsFieldOrder) {
+    Document document = Document::fromBsonLazily(BSON("a" << 1 << "b" << 2 << "c" << 3));
+    ASSERT_VALUE_EQ(Value(1), document["a"]);
+
+    MutableDocument md(document);
+    md.addField("d", Value(4));
+    md["b"] = Value(5);
+    ASSERT_BSONOBJ_EQ(BSON("a" << 1 << "b" << 5 << "c" << 3 << "d" << 4), md.freeze().toBson());
+
+    // The original document is unchanged.
+    ASSERT_BSONOBJ_EQ(BSON("a" << 1 << "b" << 2 << "c" << 3), document.toBson());
+}
+
+TEST(DocumentLazyConstruction, CloneOfPartiallyLoadedDocument) {
+    BSONObj bson = BSON("a" << 1 << "b" << 2 << "c" << 3);
+    Document document = Document::fromBsonLazily(bson);
+    ASSERT_VALUE_EQ(Value(2), document["b"]);
+
+    Document clone = document.clone();
+    ASSERT_VALUE_EQ(Value(3), clone["c"]);
+    ASSERT_DOCUMENT_EQ(Document(bson), clone);
+    ASSERT_DOCUMENT_EQ(Document(bson), document);
+}
+
+TEST(DocumentLazyConstruction, OutlivesUnownedBson) {
+    Document document;
+    {
+        BSONObjBuilder builder;
+        builder.append("a", 1);
+        builder.append("b", "a string which is long enough to be allocated"_sd);
+        BSONObj owner = builder.obj();
+        document = Document::fromBsonLazily(BSONObj(owner.objdata()));
+    }
+    ASSERT_VALUE_EQ(Value("a string which is long enough to be allocated"_sd), document["b"]);
+    ASSERT_VALUE_EQ(Value(1), document["a"]);
+}
+
+TEST(DocumentLazyConstruction, ApproximateSizeAccountsForUnloadedFields) {
+    BSONObj bson = BSON("a" << 1 << "b" << std::string(1000, 'x'));
+    Document document = Document::fromBsonLazily(bson);
+    ASSERT_GTE(document.getApproximateSize(), static_cast<size_t>(bson.objsize()));
+    ASSERT_VALUE_EQ(Value(1), document["a"]);
+    ASSERT_GTE(document.getApproximateSize(), static_cast<size_t>(bson.objsize()));
+}
+
+TEST(DocumentLazyConstruction, NeededFieldsMatchEagerExtraction) {
+    BSONObj bson = fromjson("{a: 1, b: 2, c: {d: 3, e: 4}, x: [{d: 1, e: 2}, 3], y: 5}");
+    Document neededFields = Document{{"a", true}, {"c", Document{{"d", true}}}, {"x", true}};
+
+    Document eager = Document::fromBsonWithNeededFields(bson, neededFields, 3);
+    ASSERT_DOCUMENT_EQ(Document(fromjson("{a: 1, c: {d: 3}, x: [{d: 1, e: 2}, 3]}")), eager);
+
+    Document lazy = Document::fromBsonLazily(bson, neededFields, 3);
+    ASSERT(lazy["b"].missing());
+    ASSERT(lazy["y"].missing());
+    ASSERT_VALUE_EQ(Value(1), lazy["a"]);
+    ASSERT_DOCUMENT_EQ(eager, lazy);
+
+    Document lazyNestedFirst = Document::fromBsonLazily(bson, neededFields, 3);
+    ASSERT_VALUE_EQ(Value(Document{{"d", 3}}), lazyNestedFirst["c"]);
+    ASSERT_DOCUMENT_EQ(eager, lazyNestedFirst);
+}
+
+TEST(DocumentLazyConstruction, NeededSubfieldsOfScalarAreOmitted) {
+    BSONObj bson = BSON("a" << 1 << "b" << 2);
+    Document neededFields = Document{{"a", Document{{"c", true}}}, {"b", true}};
+    Document lazy = Document::fromBsonLazily(bson, neededFields, 2);
+    ASSERT(lazy["a"].missing());
+    ASSERT_DOCUMENT_EQ(Document::fromBsonWithNeededFields(bson, neededFields, 2), lazy);
+    ASSERT_EQUALS(1U, lazy.size());
+}
+
 /** Add Document fields. */
 class AddField {
 public:
@@ -814,7 +814,14 @@ Value ExpressionCompare::evaluate(const Document& root, Variables* variables) co
     Value pLeft(_children[0]->evaluate(root, variables));
     Value pRight(_children[1]->evaluate(root, variables));
 
-    int cmp = getExpressionContext()->getValueComparator().compare(pLeft, pRight);
+    return apply(cmpOp, pLeft, pRight, getExpressionContext()->getValueComparator());
+}
+
+Value ExpressionCompare::apply(CmpOp cmpOp,
+                               const Value& lhs,
+                               const Value& rhs,
+                               const ValueComparator& comparator) {
+    int cmp = comparator.compare(lhs, rhs);
 
     // Make cmp one of 1, 0, or -1.
     if (cmp == 0) {
@@ -1812,7 +1819,10 @@ void ExpressionDateToString::_doAddDependencies(DepsTracker* deps) const {
 Value ExpressionDivide::evaluate(const Document& root, Variables* variables) const {
     Value lhs = _children[0]->evaluate(root, variables);
     Value rhs = _children[1]->evaluate(root, variables);
+    return apply(lhs, rhs);
+}
 
+Value ExpressionDivide::apply(const Value& lhs, const Value& rhs) {
     auto assertNonZero = [](bool nonZero) { uassert(16608, "can't $divide by zero", nonZero); };
 
     if (lhs.numeric() && rhs.numeric()) {
@@ -4399,7 +4409,10 @@ const char* ExpressionStrLenCP::getOpName() const {
 Value ExpressionSubtract::evaluate(const Document& root, Variables* variables) const {
     Value lhs = _children[0]->evaluate(root, variables);
     Value rhs = _children[1]->evaluate(root, variables);
+    return apply(lhs, rhs);
+}
 
+Value ExpressionSubtract::apply(const Value& lhs, const Value& rhs) {
     BSONType diffType = Value::getWidestNumeric(rhs.getType(), lhs.getType());
 
     if (diffType == NumberDecimal) {
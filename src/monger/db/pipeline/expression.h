@@ -945,6 +945,15 @@ public:
         return cmpOp;
     }
 
+    /**
+     * Applies 'cmpOp' to the already evaluated operands 'lhs' and 'rhs', comparing them with
+     * 'comparator'.
+     */
+    static Value apply(CmpOp cmpOp,
+                       const Value& lhs,
+                       const Value& rhs,
+                       const ValueComparator& comparator);
+
     static boost::intrusive_ptr<Expression> parse(
         const boost::intrusive_ptr<ExpressionContext>& expCtx,
         BSONElement bsonExpr,
@@ -1246,6 +1255,11 @@ public:
     Value evaluate(const Document& root, Variables* variables) const final;
     const char* getOpName() const final;
 
+    /**
+     * Computes the result for the already evaluated operands 'lhs' and 'rhs'.
+     */
+    static Value apply(const Value& lhs, const Value& rhs);
+
     void acceptVisitor(ExpressionVisitor* visitor) final {
         return visitor->visit(this);
     }
@@ -2198,6 +2212,11 @@ public:
     Value evaluate(const Document& root, Variables* variables) const final;
     const char* getOpName() const final;
 
+    /**
+     * Computes the result for the already evaluated operands 'lhs' and 'rhs'.
+     */
+    static Value apply(const Value& lhs, const Value& rhs);
+
     void acceptVisitor(ExpressionVisitor* visitor) final {
         return visitor->visit(this);
     }
@@ -33,11 +33,21 @@
 #include "monger/db/pipeline/stub_monger_process_interface.h"
 #include "monger/db/query/collation/collation_spec.h"
 #include "monger/db/query/collation/collator_factory_interface.h"
+#include "monger/db/query/query_knobs_gen.h"
 
 namespace monger {
 
 using boost::intrusive_ptr;
 
+namespace {
+
+std::shared_ptr<MemoryUsageTracker> makeOperationMemoryTracker() {
+    return std::make_shared<MemoryUsageTracker>(nullptr,
+                                                internalQueryMaxPipelineMemoryUsageBytes.load());
+}
+
+}  // namespace
+
 ExpressionContext::ResolvedNamespace::ResolvedNamespace(NamespaceString ns,
                                                         std::vector<BSONObj> pipeline)
     : ns(std::move(ns)), pipeline(std::move(pipeline)) {}
@@ -77,6 +87,7 @@ ExpressionContext::ExpressionContext(OperationContext* opCtx,
                            ? TimeZoneDatabase::get(opCtx->getServiceContext())
                            : nullptr),
       variablesParseState(variables.useIdGenerator()),
+      memoryTracker(makeOperationMemoryTracker()),
       _collator(collator),
       _documentComparator(_collator),
       _valueComparator(_collator) {
@@ -91,7 +102,8 @@ ExpressionContext::ExpressionContext(NamespaceString nss,
     : ns(std::move(nss)),
       mongerProcessInterface(std::move(processInterface)),
       timeZoneDatabase(tzDb),
-      variablesParseState(variables.useIdGenerator()) {}
+      variablesParseState(variables.useIdGenerator()),
+      memoryTracker(makeOperationMemoryTracker()) {}
 
 void ExpressionContext::checkForInterrupt() {
     // This check could be expensive, at least in relative terms, so don't check every time.
@@ -160,6 +172,8 @@ intrusive_ptr<ExpressionContext> ExpressionContext::copyWith(
     expCtx->bypassDocumentValidation = bypassDocumentValidation;
     expCtx->maxFeatureCompatibilityVersion = maxFeatureCompatibilityVersion;
     expCtx->subPipelineDepth = subPipelineDepth;
+    expCtx->memoryTracker = memoryTracker;
+    expCtx->reportsPeakMemoryUsage = false;
 
     expCtx->tempDir = tempDir;
 
@@ -40,6 +40,7 @@
 #include "monger/db/operation_context.h"
 #include "monger/db/pipeline/aggregation_request.h"
 #include "monger/db/pipeline/document_comparator.h"
+#include "monger/db/pipeline/memory_usage_tracker.h"
 #include "monger/db/pipeline/monger_process_interface.h"
 #include "monger/db/pipeline/value_comparator.h"
 #include "monger/db/pipeline/variables.h"
@@ -242,6 +243,17 @@ public:
     // Tracks the depth of nested aggregation sub-pipelines. Used to enforce depth limits.
     size_t subPipelineDepth = 0;
 
+    // Tracks the memory held by the blocking stages of the operation, each of which charges a child
+    // of this tracker. It is shared with the ExpressionContexts copied from this one, so that the
+    // stages of sub-pipelines are charged to the same operation. This pointer is always non-null.
+    std::shared_ptr<MemoryUsageTracker> memoryTracker;
+
+    // Whether attaching a pipeline to an OperationContext makes 'memoryTracker' report its peak to
+    // the CurOp of that operation. Only the ExpressionContext which created the tracker does so:
+    // the copies sharing it may be attached to other, shorter lived operations, e.g. on the
+    // consumer threads of a local exchange.
+    bool reportsPeakMemoryUsage = true;
+
     // If set, this will disallow use of features introduced in versions above the provided version.
     boost::optional<ServerGlobalParams::FeatureCompatibility::Version>
         maxFeatureCompatibilityVersion;
@@ -0,0 +1,347 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "monger/platform/basic.h"
+
+#include "monger/db/pipeline/lookup_hash_join.h"
+
+#include <algorithm>
+
+#include "monger/db/pipeline/document_path_support.h"
+#include "monger/platform/atomic_word.h"
+
+namespace monger {
+
+namespace {
+
+/**
+ * Generates a new file name on each call using a static, atomic and monotonically increasing
+ * number.
+ *
+ * Each user of the Sorter must implement this function to ensure that all temporary files that the
+ * Sorter instances produce are uniquely identified using a unique file name extension with separate
+ * atomic variable. This is necessary because the sorter.cpp code is separately included in multiple
+ * places, rather than compiled in one place and linked, and so cannot provide a globally unique ID.
+ */
+std::string nextFileName() {
+    static AtomicWord<unsigned> lookupHashJoinFileCounter;
+    return "extsort-lookup-hash-join." + std::to_string(lookupHashJoinFileCounter.fetchAndAdd(1));
+}
+
+// Field names of the documents written to the Sorters once the join has spilled.
+constexpr StringData kSeqField = "s"_sd;
+constexpr StringData kKeyField = "k"_sd;
+constexpr StringData kDocField = "d"_sd;
+constexpr StringData kNeedsQueryField = "q"_sd;
+
+/**
+ * Orders the Sorter's pairs by their keys, which are hashes, sequence numbers, or arrays of
+ * sequence numbers, so no collation applies.
+ */
+class SpillComparator {
+public:
+    template <typename Data>
+    int operator()(const Data& lhs, const Data& rhs) const {
+        return ValueComparator().compare(lhs.first, rhs.first);
+    }
+};
+
+/**
+ * Returns false if a join key may match foreign documents which do not have an equal value at the
+ * foreign field: null and undefined match documents without the field, and an array matches
+ * documents whose field holds the whole array as well as any of its elements.
+ */
+bool isHashable(const Value& key) {
+    return !key.nullish() && !key.isArray();
+}
+
+template <typename Iterator>
+boost::optional<typename Iterator::Data> nextOf(Iterator* iterator) {
+    if (!iterator->more()) {
+        return boost::none;
+    }
+    return iterator->next();
+}
+
+}  // namespace
+
+LookupHashJoin::LookupHashJoin(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                               FieldPath localField,
+                               FieldPath foreignField,
+                               size_t maxMemoryUsageBytes,
+                               bool allowDiskUse,
+                               MemoryUsageTracker* memoryTracker)
+    : _expCtx(expCtx),
+      _localField(std::move(localField)),
+      _foreignField(std::move(foreignField)),
+      _maxMemoryUsageBytes(maxMemoryUsageBytes),
+      _memoryTracker(memoryTracker ? memoryTracker : expCtx->memoryTracker.get(),
+                     maxMemoryUsageBytes),
+      _allowDiskUse(allowDiskUse),
+      _table(expCtx->getValueComparator().makeUnorderedValueMap<std::vector<size_t>>()) {}
+
+LookupHashJoin::~LookupHashJoin() = default;
+
+std::vector<Value> LookupHashJoin::foreignKeys(const Document& doc) const {
+    std::vector<Value> keys;
+    document_path_support::visitAllValuesAtPath(doc, _foreignField, [&](const Value& value) {
+        if (isHashable(value)) {
+            keys.push_back(value);
+        }
+    });
+    return keys;
+}
+
+boost::optional<std::vector<Value>> LookupHashJoin::localKeys(const Document& doc) const {
+    std::vector<Value> keys;
+    bool hashable = true;
+    document_path_support::visitAllValuesAtPath(doc, _localField, [&](const Value& value) {
+        hashable = hashable && isHashable(value);
+        keys.push_back(value);
+    });
+
+    // A missing local field joins as null.
+    if (keys.empty() || !hashable) {
+        return boost::none;
+    }
+    return keys;
+}
+
+long long LookupHashJoin::hashKey(const Value& key) const {
+    return static_cast<long long>(_expCtx->getValueComparator().hash(key));
+}
+
+bool LookupHashJoin::addForeign(const Document& doc) {
+    invariant(!_doneForeign);
+
+    // A document without a hashable key can only match a local document which is queried for.
+    auto keys = foreignKeys(doc);
+    if (keys.empty()) {
+        return true;
+    }
+
+    const long long seq = _nextForeignSeq++;
+    if (_spilled) {
+        for (auto&& key : keys) {
+            _foreignSorter->add(Value(hashKey(key)),
+                                Document{{kSeqField, seq}, {kKeyField, key}, {kDocField, doc}});
+        }
+        return true;
+    }
+
+    invariant(static_cast<size_t>(seq) == _foreignDocs.size());
+    _foreignDocs.push_back(doc);
+    _memoryTracker.add(doc.getApproximateSize());
+    for (auto&& key : keys) {
+        auto& positions = _table[key];
+        // The same value may appear more than once in an array.
+        if (positions.empty() || positions.back() != static_cast<size_t>(seq)) {
+            positions.push_back(seq);
+            _memoryTracker.add(key.getApproximateSize() + sizeof(size_t));
+        }
+    }
+
+    if (!_memoryTracker.withinMemoryLimit()) {
+        if (!_allowDiskUse) {
+            return false;
+        }
+        spill();
+    }
+    return true;
+}
+
+void LookupHashJoin::spill() {
+    invariant(!_spilled);
+    _spilled = true;
+
+    // Each Sorter gets a share of the memory budget, since all of them hold data at once.
+    const auto opts = SortOptions()
+                          .MaxMemoryUsageBytes(_maxMemoryUsageBytes / 4)
+                          .ExtSortAllowed()
+                          .TempDir(_expCtx->tempDir);
+    _foreignSorter.reset(DocumentSorter::make(opts, SpillComparator()));
+    _probeSorter.reset(DocumentSorter::make(opts, SpillComparator()));
+    _localSorter.reset(DocumentSorter::make(opts, SpillComparator()));
+    _matchSorter.reset(DocumentSorter::make(opts, SpillComparator()));
+
+    for (size_t seq = 0; seq < _foreignDocs.size(); ++seq) {
+        for (auto&& key : foreignKeys(_foreignDocs[seq])) {
+            _foreignSorter->add(Value(hashKey(key)),
+                                Document{{kSeqField, static_cast<long long>(seq)},
+                                         {kKeyField, key},
+                                         {kDocField, _foreignDocs[seq]}});
+        }
+    }
+
+    _foreignDocs.clear();
+    _table.clear();
+    _memoryTracker.set(0);
+}
+
+void LookupHashJoin::doneForeign() {
+    invariant(!_doneForeign);
+    _doneForeign = true;
+}
+
+void LookupHashJoin::addLocal(Document doc) {
+    invariant(_doneForeign && !_doneLocal);
+    auto keys = localKeys(doc);
+
+    if (!_spilled) {
+        Joined joined;
+        if (!keys) {
+            joined.needsQuery = true;
+        } else {
+            std::vector<size_t> positions;
+            for (auto&& key : *keys) {
+                auto it = _table.find(key);
+                if (it != _table.end()) {
+                    positions.insert(positions.end(), it->second.begin(), it->second.end());
+                }
+            }
+
+            // A foreign document matching several of the local values is only returned once.
+            std::sort(positions.begin(), positions.end());
+            positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+            joined.matches.reserve(positions.size());
+            for (auto position : positions) {
+                joined.matches.push_back(_foreignDocs[position]);
+            }
+        }
+        joined.local = std::move(doc);
+        _ready.push_back(std::move(joined));
+        return;
+    }
+
+    const long long seq = _nextLocalSeq++;
+    if (keys) {
+        for (auto&& key : *keys) {
+            _probeSorter->add(Value(hashKey(key)), Document{{kSeqField, seq}, {kKeyField, key}});
+        }
+    }
+    _localSorter->add(Value(seq), Document{{kDocField, doc}, {kNeedsQueryField, !keys}});
+}
+
+void LookupHashJoin::doneLocal() {
+    invariant(_doneForeign && !_doneLocal);
+    _doneLocal = true;
+    if (_spilled) {
+        mergeSpilledRuns();
+    }
+}
+
+void LookupHashJoin::mergeSpilledRuns() {
+    const auto& comparator = _expCtx->getValueComparator();
+
+    {
+        std::unique_ptr<DocumentSorter::Iterator> foreignIterator(_foreignSorter->done());
+        std::unique_ptr<DocumentSorter::Iterator> probeIterator(_probeSorter->done());
+
+        // Both runs are ordered by the hash of their keys. For each hash they share, compare the
+        // keys of all the foreign entries with all the probes, which are few unless the key is
+        // common.
+        auto foreign = nextOf(foreignIterator.get());
+        auto probe = nextOf(probeIterator.get());
+        std::vector<Document> foreignWithHash;
+        while (foreign && probe) {
+            const long long foreignHash = foreign->first.getLong();
+            const long long probeHash = probe->first.getLong();
+            if (foreignHash < probeHash) {
+                foreign = nextOf(foreignIterator.get());
+                continue;
+            }
+            if (probeHash < foreignHash) {
+                probe = nextOf(probeIterator.get());
+                continue;
+            }
+
+            foreignWithHash.clear();
+            while (foreign && foreign->first.getLong() == foreignHash) {
+                foreignWithHash.push_back(std::move(foreign->second));
+                foreign = nextOf(foreignIterator.get());
+            }
+            while (probe && probe->first.getLong() == probeHash) {
+                for (auto&& entry : foreignWithHash) {
+                    if (comparator.evaluate(entry[kKeyField] == probe->second[kKeyField])) {
+                        _matchSorter->add(
+                            Value(std::vector<Value>{probe->second[kSeqField], entry[kSeqField]}),
+                            entry[kDocField].getDocument());
+                    }
+                }
+                probe = nextOf(probeIterator.get());
+            }
+        }
+    }
+    _foreignSorter.reset();
+    _probeSorter.reset();
+
+    _localIterator.reset(_localSorter->done());
+    _matchIterator.reset(_matchSorter->done());
+    _nextMatch = nextOf(_matchIterator.get());
+}
+
+boost::optional<LookupHashJoin::Joined> LookupHashJoin::getNext() {
+    if (!_spilled) {
+        if (_ready.empty()) {
+            return boost::none;
+        }
+        auto joined = std::move(_ready.front());
+        _ready.pop_front();
+        return joined;
+    }
+
+    if (!_doneLocal || !_localIterator->more()) {
+        return boost::none;
+    }
+
+    auto local = _localIterator->next();
+    Joined joined;
+    joined.local = local.second[kDocField].getDocument();
+    joined.needsQuery = local.second[kNeedsQueryField].getBool();
+
+    // The matches are ordered by local and then foreign sequence number, and a foreign document
+    // which matched several of the local values appears once for each of them.
+    const long long localSeq = local.first.getLong();
+    boost::optional<long long> lastForeignSeq;
+    while (_nextMatch && _nextMatch->first[0].getLong() == localSeq) {
+        const long long foreignSeq = _nextMatch->first[1].getLong();
+        if (lastForeignSeq != foreignSeq) {
+            joined.matches.push_back(std::move(_nextMatch->second));
+            lastForeignSeq = foreignSeq;
+        }
+        _nextMatch = nextOf(_matchIterator.get());
+    }
+    return joined;
+}
+
+}  // namespace monger
+
+#include "monger/db/sorter/sorter.cpp"
+// Explicit instantiation unneeded since we aren't exposing Sorter outside of this file.
@@ -0,0 +1,174 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <boost/intrusive_ptr.hpp>
+#include <boost/optional.hpp>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "monger/db/pipeline/document.h"
+#include "monger/db/pipeline/expression_context.h"
+#include "monger/db/pipeline/field_path.h"
+#include "monger/db/pipeline/value.h"
+#include "monger/db/pipeline/value_comparator.h"
+#include "monger/db/sorter/sorter.h"
+
+namespace monger {
+
+/**
+ * Joins documents of a local and a foreign collection on the equality of a local and a foreign
+ * field, for a $lookup with localField/foreignField syntax.
+ *
+ * The foreign collection is added first, and is hashed on the values of the foreign field. Local
+ * documents are then streamed through, and each comes back with the foreign documents whose
+ * foreign field has a value equal to one of the local field's values, under the collation of the
+ * ExpressionContext. Matches are returned in the order in which the foreign documents were added.
+ *
+ * If the foreign documents do not fit in the memory budget and spilling is allowed, both sides are
+ * written to disk by the Sorter ordered by the hash of their join keys, joined by merging the two
+ * runs, and put back in local document order. In this mode the join is blocking: no local document
+ * comes back until all of them have been added.
+ *
+ * Null, missing and nested array join keys have query semantics that a hash lookup cannot
+ * reproduce, such as null matching documents that lack the foreign field. Local documents with
+ * such keys come back flagged, and the caller must find their matches with a query instead.
+ */
+class LookupHashJoin {
+    LookupHashJoin(const LookupHashJoin&) = delete;
+    LookupHashJoin& operator=(const LookupHashJoin&) = delete;
+
+public:
+    struct Joined {
+        Document local;
+
+        // The matching foreign documents. Always empty if 'needsQuery' is true.
+        std::vector<Document> matches;
+
+        // True if the join key of 'local' cannot be looked up in the hash table.
+        bool needsQuery = false;
+    };
+
+    /**
+     * The memory held by the join is charged to a child of 'memoryTracker', or of the tracker of
+     * 'expCtx' if it is null, and the join is over budget once either of them is.
+     */
+    LookupHashJoin(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                   FieldPath localField,
+                   FieldPath foreignField,
+                   size_t maxMemoryUsageBytes,
+                   bool allowDiskUse,
+                   MemoryUsageTracker* memoryTracker = nullptr);
+
+    ~LookupHashJoin();
+
+    /**
+     * Adds a document of the foreign collection. Returns false if the foreign documents no longer
+     * fit in memory and spilling is not allowed, in which case the join cannot be used.
+     */
+    bool addForeign(const Document& doc);
+
+    /**
+     * Must be called once all foreign documents have been added, and before any local document.
+     */
+    void doneForeign();
+
+    void addLocal(Document doc);
+
+    /**
+     * Must be called once all local documents have been added.
+     */
+    void doneLocal();
+
+    /**
+     * Returns the next local document with its matches, in the order in which the local documents
+     * were added, or boost::none if no local document is ready to come back yet.
+     */
+    boost::optional<Joined> getNext();
+
+    bool spilled() const {
+        return _spilled;
+    }
+
+    /**
+     * Returns the values of the local field in 'doc', or boost::none if any of them cannot be
+     * looked up in the hash table.
+     */
+    boost::optional<std::vector<Value>> localKeys(const Document& doc) const;
+
+private:
+    using DocumentSorter = Sorter<Value, Document>;
+
+    /**
+     * Returns the values of the foreign field in 'doc' which can be hashed.
+     */
+    std::vector<Value> foreignKeys(const Document& doc) const;
+
+    long long hashKey(const Value& key) const;
+
+    void spill();
+    void mergeSpilledRuns();
+
+    boost::intrusive_ptr<ExpressionContext> _expCtx;
+    const FieldPath _localField;
+    const FieldPath _foreignField;
+    const size_t _maxMemoryUsageBytes;
+    MemoryUsageTracker _memoryTracker;
+    const bool _allowDiskUse;
+
+    bool _doneForeign = false;
+    bool _doneLocal = false;
+    bool _spilled = false;
+
+    // The sequence numbers of the next foreign and local documents to be added.
+    long long _nextForeignSeq = 0;
+    long long _nextLocalSeq = 0;
+
+    // While the foreign documents fit in memory, the hash table maps each value of the foreign
+    // field to the positions in '_foreignDocs' of the documents which have it.
+    std::vector<Document> _foreignDocs;
+    ValueUnorderedMap<std::vector<size_t>> _table;
+    std::deque<Joined> _ready;
+
+    // Once spilled, the foreign documents and the local join keys are sorted by the hash of the
+    // key, the local documents by their sequence number, and the matches by the sequence numbers
+    // of their local and foreign documents.
+    std::unique_ptr<DocumentSorter> _foreignSorter;
+    std::unique_ptr<DocumentSorter> _probeSorter;
+    std::unique_ptr<DocumentSorter> _localSorter;
+    std::unique_ptr<DocumentSorter> _matchSorter;
+    std::unique_ptr<DocumentSorter::Iterator> _localIterator;
+    std::unique_ptr<DocumentSorter::Iterator> _matchIterator;
+    boost::optional<DocumentSorter::Data> _nextMatch;
+};
+
+}  // namespace monger
@@ -0,0 +1,172 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "monger/platform/basic.h"
+
+#include <string>
+#include <vector>
+
+#include "monger/db/pipeline/aggregation_context_fixture.h"
+#include "monger/db/pipeline/document_value_test_util.h"
+#include "monger/db/pipeline/lookup_hash_join.h"
+#include "monger/db/query/collation/collator_interface_mock.h"
+#include "monger/unittest/temp_dir.h"
+#include "monger/unittest/unittest.h"
+
+namespace monger {
+namespace {
+
+using LookupHashJoinTest = AggregationContextFixture;
+
+const size_t kLargeBudget = 100 * 1024 * 1024;
+
+std::vector<LookupHashJoin::Joined> joinAll(LookupHashJoin* join,
+                                            const std::vector<Document>& foreign,
+                                            const std::vector<Document>& local) {
+    for (auto&& doc : foreign) {
+        ASSERT_TRUE(join->addForeign(doc));
+    }
+    join->doneForeign();
+
+    std::vector<LookupHashJoin::Joined> results;
+    for (auto&& doc : local) {
+        join->addLocal(doc);
+        while (auto joined = join->getNext()) {
+            results.push_back(std::move(*joined));
+        }
+    }
+    join->doneLocal();
+    while (auto joined = join->getNext()) {
+        results.push_back(std::move(*joined));
+    }
+    return results;
+}
+
+TEST_F(LookupHashJoinTest, JoinsOnEqualValuesInForeignOrder) {
+    LookupHashJoin join(getExpCtx(), FieldPath("a"), FieldPath("b"), kLargeBudget, false);
+    auto results = joinAll(&join,
+                           {Document{{"_id", 0}, {"b", 1}},
+                            Document{{"_id", 1}, {"b", 2}},
+                            Document{{"_id", 2}, {"b", 1.0}}},
+                           {Document{{"a", 1}}, Document{{"a", 3}}});
+
+    ASSERT_EQ(results.size(), 2UL);
+    ASSERT_DOCUMENT_EQ(results[0].local, (Document{{"a", 1}}));
+    ASSERT_FALSE(results[0].needsQuery);
+    ASSERT_EQ(results[0].matches.size(), 2UL);
+    ASSERT_DOCUMENT_EQ(results[0].matches[0], (Document{{"_id", 0}, {"b", 1}}));
+    ASSERT_DOCUMENT_EQ(results[0].matches[1], (Document{{"_id", 2}, {"b", 1.0}}));
+    ASSERT_DOCUMENT_EQ(results[1].local, (Document{{"a", 3}}));
+    ASSERT_TRUE(results[1].matches.empty());
+    ASSERT_FALSE(join.spilled());
+}
+
+TEST_F(LookupHashJoinTest, ArrayValuesMatchOnEachElementOnce) {
+    LookupHashJoin join(getExpCtx(), FieldPath("a"), FieldPath("b"), kLargeBudget, false);
+    const Value oneTwo(std::vector<Value>{Value(1), Value(2)});
+    const Value twoOne(std::vector<Value>{Value(2), Value(1)});
+    auto results = joinAll(&join,
+                           {Document{{"_id", 0}, {"b", oneTwo}}, Document{{"_id", 1}, {"b", 2}}},
+                           {Document{{"a", twoOne}}});
+
+    ASSERT_EQ(results.size(), 1UL);
+    ASSERT_EQ(results[0].matches.size(), 2UL);
+    ASSERT_VALUE_EQ(results[0].matches[0]["_id"], Value(0));
+    ASSERT_VALUE_EQ(results[0].matches[1]["_id"], Value(1));
+}
+
+TEST_F(LookupHashJoinTest, NullishLocalValuesNeedQuery) {
+    LookupHashJoin join(getExpCtx(), FieldPath("a"), FieldPath("b"), kLargeBudget, false);
+    auto results = joinAll(&join,
+                           {Document{{"_id", 0}, {"b", BSONNULL}}, Document{{"_id", 1}}},
+                           {Document{{"a", BSONNULL}}, Document{{"c", 1}}});
+
+    ASSERT_EQ(results.size(), 2UL);
+    ASSERT_TRUE(results[0].needsQuery);
+    ASSERT_TRUE(results[0].matches.empty());
+    ASSERT_TRUE(results[1].needsQuery);
+    ASSERT_DOCUMENT_EQ(results[1].local, (Document{{"c", 1}}));
+}
+
+TEST_F(LookupHashJoinTest, ComparesValuesWithCollation) {
+    std::unique_ptr<CollatorInterface> collator =
+        std::make_unique<CollatorInterfaceMock>(CollatorInterfaceMock::MockType::kAlwaysEqual);
+    auto expCtx = getExpCtx()->copyWith(getExpCtx()->ns, boost::none, std::move(collator));
+    LookupHashJoin join(expCtx, FieldPath("a"), FieldPath("b"), kLargeBudget, false);
+    auto results = joinAll(&join, {Document{{"b", "foo"_sd}}}, {Document{{"a", "bar"_sd}}});
+
+    ASSERT_EQ(results.size(), 1UL);
+    ASSERT_EQ(results[0].matches.size(), 1UL);
+}
+
+TEST_F(LookupHashJoinTest, FailsToAddForeignOverBudgetWithoutDiskUse) {
+    LookupHashJoin join(getExpCtx(), FieldPath("a"), FieldPath("b"), 1000, false);
+    const std::string largeStr(1000, 'x');
+    ASSERT_FALSE(join.addForeign(Document{{"b", 1}, {"s", largeStr}}));
+}
+
+TEST_F(LookupHashJoinTest, SpilledJoinReturnsLocalDocumentsInOrder) {
+    auto expCtx = getExpCtx();
+    unittest::TempDir tempDir("LookupHashJoinTest");
+    expCtx->tempDir = tempDir.path();
+    LookupHashJoin join(expCtx, FieldPath("a"), FieldPath("b"), 1000, true);
+
+    const std::string largeStr(100, 'x');
+    std::vector<Document> foreign;
+    for (int i = 0; i < 100; ++i) {
+        foreign.push_back(Document{{"_id", i}, {"b", i % 10}, {"s", largeStr}});
+    }
+    std::vector<Document> local;
+    for (int i = 19; i >= 0; --i) {
+        local.push_back(Document{{"a", Value(std::vector<Value>{Value(i), Value(i)})}});
+    }
+    local.push_back(Document{{"a", BSONNULL}});
+
+    auto results = joinAll(&join, foreign, local);
+    ASSERT_TRUE(join.spilled());
+    ASSERT_EQ(results.size(), local.size());
+    for (size_t i = 0; i < 20; ++i) {
+        const int key = 19 - i;
+        ASSERT_DOCUMENT_EQ(results[i].local, local[i]);
+        ASSERT_FALSE(results[i].needsQuery);
+        if (key >= 10) {
+            ASSERT_TRUE(results[i].matches.empty());
+            continue;
+        }
+        ASSERT_EQ(results[i].matches.size(), 10UL);
+        for (size_t j = 0; j < 10; ++j) {
+            ASSERT_VALUE_EQ(results[i].matches[j]["_id"], Value(static_cast<int>(key + 10 * j)));
+        }
+    }
+    ASSERT_TRUE(results.back().needsQuery);
+}
+
+}  // namespace
+}  // namespace monger
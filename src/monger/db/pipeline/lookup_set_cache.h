@@ -160,6 +160,13 @@ public:
         return _container.size();
     }
 
+    /**
+     * Returns the approximate number of bytes held by the elements in the cache.
+     */
+    size_t getMemoryUsage() const {
+        return _memoryUsage;
+    }
+
     /**
      * Evict items in LRU order until the cache's size is less than or equal to "maximum".
      */
@@ -0,0 +1,99 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+
+#include "monger/platform/basic.h"
+
+#include "monger/db/pipeline/memory_usage_tracker.h"
+
+namespace monger {
+
+MemoryUsageTracker::MemoryUsageTracker(MemoryUsageTracker* parent, long long maxMemoryUsageBytes)
+    : _parent(parent), _maxMemoryUsageBytes(maxMemoryUsageBytes) {}
+
+MemoryUsageTracker::~MemoryUsageTracker() {
+    if (_parent) {
+        _parent->add(-currentMemoryBytes());
+    }
+}
+
+void MemoryUsageTracker::add(long long diff) {
+    for (auto tracker = this; tracker; tracker = tracker->_parent) {
+        const long long current = tracker->_currentMemoryBytes.addAndFetch(diff);
+
+        long long peak = tracker->_peakTrackedMemoryBytes.load();
+        while (current > peak) {
+            // On failure 'peak' is reloaded, so the loop ends once some thread has recorded a peak
+            // at least as high as 'current'.
+            if (tracker->_peakTrackedMemoryBytes.compareAndSwap(&peak, current)) {
+                stdx::lock_guard<stdx::mutex> lk(tracker->_peakReportMutex);
+                if (tracker->_peakReport) {
+                    tracker->_peakReport->store(current);
+                }
+                break;
+            }
+        }
+    }
+}
+
+bool MemoryUsageTracker::withinMemoryLimit() const {
+    for (auto tracker = this; tracker; tracker = tracker->_parent) {
+        if (tracker->_maxMemoryUsageBytes > 0 &&
+            tracker->currentMemoryBytes() > tracker->_maxMemoryUsageBytes) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MemoryUsageTracker::shouldReleaseMemory() const {
+    const long long held = currentMemoryBytes();
+    if (_maxMemoryUsageBytes > 0 && held > _maxMemoryUsageBytes) {
+        return true;
+    }
+    for (auto tracker = _parent; tracker; tracker = tracker->_parent) {
+        const long long limit = tracker->_maxMemoryUsageBytes;
+        const long long current = tracker->currentMemoryBytes();
+        if (limit > 0 && current > limit && current - held <= limit) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MemoryUsageTracker::reportPeakTo(AtomicWord<long long>* peak) {
+    stdx::lock_guard<stdx::mutex> lk(_peakReportMutex);
+    if (peak) {
+        peak->store(peakTrackedMemoryBytes());
+    }
+    _peakReport = peak;
+}
+
+}  // namespace monger
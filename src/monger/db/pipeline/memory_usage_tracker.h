@@ -0,0 +1,125 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+
+#pragma once
+
+#include "monger/platform/atomic_word.h"
+#include "monger/stdx/mutex.h"
+
+namespace monger {
+
+/**
+ * Tracks the memory held by the blocking stages of an aggregation. The ExpressionContext of an
+ * operation owns the root tracker, whose limit is the budget of the whole operation, and each stage
+ * which holds data in memory charges a child tracker whose limit is the budget of that stage. A
+ * charge to a tracker is also a charge to each of its ancestors, so the root knows how much memory
+ * the operation holds, and a stage can tell when either it or the operation is over budget.
+ *
+ * The pipelines of a local exchange share the root of their operation, so the counters may be
+ * updated by several threads at once. A tracker other than the root is charged by one thread.
+ * Only the owner of the root, see ExpressionContext::reportsPeakMemoryUsage, chooses where its peak
+ * is reported.
+ */
+class MemoryUsageTracker {
+    MemoryUsageTracker(const MemoryUsageTracker&) = delete;
+    MemoryUsageTracker& operator=(const MemoryUsageTracker&) = delete;
+
+public:
+    /**
+     * Creates a tracker which also charges 'parent', unless it is null, and which is over budget
+     * past 'maxMemoryUsageBytes', unless it is 0. 'parent' must outlive the tracker.
+     */
+    explicit MemoryUsageTracker(MemoryUsageTracker* parent = nullptr,
+                                long long maxMemoryUsageBytes = 0);
+
+    /**
+     * Releases the memory still charged to this tracker from its ancestors.
+     */
+    ~MemoryUsageTracker();
+
+    /**
+     * Charges 'diff' bytes, which may be negative, to this tracker and its ancestors.
+     */
+    void add(long long diff);
+
+    /**
+     * Charges this tracker with 'total' bytes in place of its current usage.
+     */
+    void set(long long total) {
+        add(total - currentMemoryBytes());
+    }
+
+    /**
+     * Returns whether neither this tracker nor any of its ancestors is over its limit.
+     */
+    bool withinMemoryLimit() const;
+
+    /**
+     * Returns whether the stage charging this tracker should release memory, e.g. by spilling to
+     * disk, because this tracker or one of its ancestors is over its limit. An ancestor which would
+     * still be over its limit without this tracker's memory is ignored: releasing would not bring
+     * it back within budget, so only the other limits apply.
+     */
+    bool shouldReleaseMemory() const;
+
+    /**
+     * From now on, also records the peak of this tracker in '*peak', e.g. a counter reported by
+     * currentOp, whenever it increases. Passing null stops the recording; once this returns, no
+     * thread charging the tracker writes to the previous '*peak' any more.
+     */
+    void reportPeakTo(AtomicWord<long long>* peak);
+
+    long long currentMemoryBytes() const {
+        return _currentMemoryBytes.load();
+    }
+
+    long long peakTrackedMemoryBytes() const {
+        return _peakTrackedMemoryBytes.load();
+    }
+
+    long long maxMemoryUsageBytes() const {
+        return _maxMemoryUsageBytes;
+    }
+
+private:
+    MemoryUsageTracker* const _parent;
+    const long long _maxMemoryUsageBytes;
+
+    AtomicWord<long long> _currentMemoryBytes{0};
+    AtomicWord<long long> _peakTrackedMemoryBytes{0};
+
+    // Guards '_peakReport', so that a thread recording a new peak cannot write to a counter which
+    // has been destroyed after the recording stopped.
+    stdx::mutex _peakReportMutex;
+    AtomicWord<long long>* _peakReport = nullptr;
+};
+
+}  // namespace monger
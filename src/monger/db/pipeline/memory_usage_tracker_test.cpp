@@ -0,0 +1,145 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+
+#include "monger/platform/basic.h"
+
+#include "monger/db/pipeline/memory_usage_tracker.h"
+#include "monger/unittest/unittest.h"
+
+namespace monger {
+namespace {
+
+TEST(MemoryUsageTrackerTest, ChargesAreAlsoChargedToAncestors) {
+    MemoryUsageTracker operation;
+    MemoryUsageTracker stage(&operation);
+    MemoryUsageTracker subStage(&stage);
+
+    subStage.add(100);
+    stage.add(50);
+    ASSERT_EQ(subStage.currentMemoryBytes(), 100);
+    ASSERT_EQ(stage.currentMemoryBytes(), 150);
+    ASSERT_EQ(operation.currentMemoryBytes(), 150);
+
+    subStage.set(30);
+    ASSERT_EQ(stage.currentMemoryBytes(), 80);
+    ASSERT_EQ(operation.currentMemoryBytes(), 80);
+}
+
+TEST(MemoryUsageTrackerTest, PeakIsKeptOnceMemoryIsReleased) {
+    MemoryUsageTracker operation;
+    MemoryUsageTracker first(&operation);
+    MemoryUsageTracker second(&operation);
+
+    first.add(100);
+    second.add(200);
+    first.set(0);
+    second.add(50);
+    ASSERT_EQ(first.peakTrackedMemoryBytes(), 100);
+    ASSERT_EQ(second.peakTrackedMemoryBytes(), 250);
+    ASSERT_EQ(operation.currentMemoryBytes(), 250);
+    ASSERT_EQ(operation.peakTrackedMemoryBytes(), 300);
+}
+
+TEST(MemoryUsageTrackerTest, StageIsOverBudgetOnceItOrTheOperationIs) {
+    MemoryUsageTracker operation(nullptr, 1000);
+    MemoryUsageTracker stage(&operation, 600);
+    MemoryUsageTracker unlimitedStage(&operation);
+
+    stage.add(600);
+    ASSERT_TRUE(stage.withinMemoryLimit());
+    stage.add(1);
+    ASSERT_FALSE(stage.withinMemoryLimit());
+    ASSERT_TRUE(unlimitedStage.withinMemoryLimit());
+
+    stage.set(500);
+    unlimitedStage.add(501);
+    ASSERT_FALSE(stage.withinMemoryLimit());
+    ASSERT_FALSE(unlimitedStage.withinMemoryLimit());
+
+    unlimitedStage.set(500);
+    ASSERT_TRUE(stage.withinMemoryLimit());
+    ASSERT_TRUE(unlimitedStage.withinMemoryLimit());
+}
+
+TEST(MemoryUsageTrackerTest, StageReleasesMemoryOnlyIfThatBringsTheOperationWithinBudget) {
+    MemoryUsageTracker operation(nullptr, 1000);
+    MemoryUsageTracker stage(&operation, 600);
+    MemoryUsageTracker otherStage(&operation);
+
+    stage.add(500);
+    otherStage.add(400);
+    ASSERT_FALSE(stage.shouldReleaseMemory());
+
+    // The operation is over budget, and releasing the memory of either stage would fix that.
+    otherStage.add(200);
+    ASSERT_TRUE(stage.shouldReleaseMemory());
+    ASSERT_TRUE(otherStage.shouldReleaseMemory());
+
+    // The other stage alone is over the operation's budget, so only the stage's own limit counts.
+    otherStage.set(1001);
+    ASSERT_FALSE(stage.shouldReleaseMemory());
+    ASSERT_TRUE(otherStage.shouldReleaseMemory());
+    stage.set(601);
+    ASSERT_TRUE(stage.shouldReleaseMemory());
+}
+
+TEST(MemoryUsageTrackerTest, DestroyedTrackerReleasesItsMemory) {
+    MemoryUsageTracker operation;
+    {
+        MemoryUsageTracker stage(&operation);
+        stage.add(100);
+        ASSERT_EQ(operation.currentMemoryBytes(), 100);
+    }
+    ASSERT_EQ(operation.currentMemoryBytes(), 0);
+    ASSERT_EQ(operation.peakTrackedMemoryBytes(), 100);
+}
+
+TEST(MemoryUsageTrackerTest, PeakIsReportedUntilReportingStops) {
+    MemoryUsageTracker operation;
+    MemoryUsageTracker stage(&operation);
+    stage.add(100);
+
+    AtomicWord<long long> peak{0};
+    operation.reportPeakTo(&peak);
+    ASSERT_EQ(peak.load(), 100);
+
+    stage.add(50);
+    ASSERT_EQ(peak.load(), 150);
+    stage.set(0);
+    ASSERT_EQ(peak.load(), 150);
+
+    operation.reportPeakTo(nullptr);
+    stage.add(500);
+    ASSERT_EQ(peak.load(), 150);
+}
+
+}  // namespace
+}  // namespace monger
@@ -47,6 +47,7 @@
 #include "monger/db/pipeline/document.h"
 #include "monger/db/pipeline/field_path.h"
 #include "monger/db/pipeline/lite_parsed_document_source.h"
+#include "monger/db/pipeline/spill_table.h"
 #include "monger/db/pipeline/value.h"
 #include "monger/db/query/explain_options.h"
 #include "monger/db/repl/oplog_entry.h"
@@ -116,6 +117,17 @@ public:
         int64_t nModified{0};
     };
 
+    /**
+     * What a $lookup needs to know about its foreign collection to choose how to join with it.
+     */
+    struct CollectionJoinInfo {
+        // The size of the documents in the collection, or zero if it does not exist.
+        long long dataSizeBytes{0};
+
+        // True if an index can be used to find the documents with a given value of the join field.
+        bool joinFieldIsIndexed{false};
+    };
+
     virtual ~MongerProcessInterface(){};
 
     /**
@@ -362,6 +374,23 @@ public:
         const NamespaceString& nss,
         const std::set<FieldPath>& fieldPaths) const = 0;
 
+    /**
+     * Returns the size of the collection 'nss', and whether an equality match on 'joinField' can
+     * be answered by one of its indexes: a ready, non-partial index whose leading field is
+     * 'joinField' and whose collation matches that of 'expCtx'.
+     */
+    virtual CollectionJoinInfo getCollectionJoinInfo(
+        const boost::intrusive_ptr<ExpressionContext>& expCtx,
+        const NamespaceString& nss,
+        const FieldPath& joinField) const = 0;
+
+    /**
+     * Creates a temporary table for an aggregation stage to spill to, or returns nullptr if this
+     * process has nowhere to keep one.
+     */
+    virtual std::unique_ptr<SpillTable> makeSpillTable(
+        const boost::intrusive_ptr<ExpressionContext>& expCtx) const = 0;
+
     /**
      * Refreshes the CatalogCache entry for the namespace 'nss', and returns the epoch associated
      * with that namespace, if any. Note that this refresh will not necessarily force a new
@@ -217,6 +217,17 @@ public:
                                          const NamespaceString&,
                                          const std::set<FieldPath>& fieldPaths) const;
 
+    CollectionJoinInfo getCollectionJoinInfo(const boost::intrusive_ptr<ExpressionContext>&,
+                                             const NamespaceString&,
+                                             const FieldPath&) const final {
+        MONGO_UNREACHABLE;
+    }
+
+    std::unique_ptr<SpillTable> makeSpillTable(
+        const boost::intrusive_ptr<ExpressionContext>&) const final {
+        return nullptr;
+    }
+
     void checkRoutingInfoEpochOrThrow(const boost::intrusive_ptr<ExpressionContext>&,
                                       const NamespaceString&,
                                       ChunkVersion) const final {
@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include "monger/db/pipeline/compiled_expression.h"
 #include "monger/db/pipeline/parsed_aggregation_projection.h"
 
 namespace monger {
@@ -152,6 +153,9 @@ protected:
     stdx::unordered_map<size_t, std::unique_ptr<ProjectionNode>> _arrayBranches;
 
     StringMap<boost::intrusive_ptr<Expression>> _expressions;
+    // Compiled forms of the optimized '_expressions', populated by optimize(). A field without an
+    // entry is evaluated through its expression tree.
+    StringMap<std::unique_ptr<CompiledExpression>> _compiledExpressions;
     stdx::unordered_set<std::string> _projectedFields;
 
     ProjectionPolicies _policies;
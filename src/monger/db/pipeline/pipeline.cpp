@@ -36,6 +36,7 @@
 #include "monger/base/error_codes.h"
 #include "monger/db/bson/dotted_path_support.h"
 #include "monger/db/catalog/document_validation.h"
+#include "monger/db/curop.h"
 #include "monger/db/jsobj.h"
 #include "monger/db/operation_context.h"
 #include "monger/db/pipeline/accumulator.h"
@@ -320,6 +321,9 @@ bool Pipeline::aggHasWriteStage(const BSONObj& cmd) {
 void Pipeline::detachFromOperationContext() {
     pCtx->opCtx = nullptr;
     pCtx->mongerProcessInterface->setOperationContext(nullptr);
+    if (pCtx->reportsPeakMemoryUsage) {
+        pCtx->memoryTracker->reportPeakTo(nullptr);
+    }
 
     for (auto&& source : _sources) {
         source->detachFromOperationContext();
@@ -329,6 +333,10 @@ void Pipeline::detachFromOperationContext() {
 void Pipeline::reattachToOperationContext(OperationContext* opCtx) {
     pCtx->opCtx = opCtx;
     pCtx->mongerProcessInterface->setOperationContext(opCtx);
+    if (pCtx->reportsPeakMemoryUsage) {
+        pCtx->memoryTracker->reportPeakTo(
+            &CurOp::get(opCtx)->debug().additiveMetrics.peakMemoryUsageBytes);
+    }
 
     for (auto&& source : _sources) {
         source->reattachToOperationContext(opCtx);
@@ -481,7 +489,17 @@ boost::optional<Document> Pipeline::getNext() {
 vector<Value> Pipeline::writeExplainOps(ExplainOptions::Verbosity verbosity) const {
     vector<Value> array;
     for (SourceContainer::const_iterator it = _sources.begin(); it != _sources.end(); ++it) {
+        const size_t stageIndex = array.size();
         (*it)->serializeToArray(array, verbosity);
+
+        // The peak memory of a stage is reported next to the first object it serializes to.
+        auto memoryTracker = (*it)->getMemoryTracker();
+        if (memoryTracker && verbosity >= ExplainOptions::Verbosity::kExecStats &&
+            array.size() > stageIndex) {
+            MutableDocument stage(array[stageIndex].getDocument());
+            stage["peakMemoryUsageBytes"] = Value(memoryTracker->peakTrackedMemoryBytes());
+            array[stageIndex] = stage.freezeToValue();
+        }
     }
     return array;
 }
@@ -3329,6 +3329,26 @@ TEST(InvolvedNamespacesTest, IncludesAllCollectionsWhenResolvingViews) {
     ASSERT(involvedNssSet.find(normalCollectionNss) != involvedNssSet.end());
 }
 
+TEST(PipelineExplainTest, ReportsPeakMemoryOfBlockingStagesWithExecutionStats) {
+    boost::intrusive_ptr<ExpressionContext> expCtx(new ExpressionContextForTest());
+    auto pipeline = unittest::assertGet(Pipeline::create(
+        {DocumentSourceMock::createForTest({"{_id: 1, x: 'abc'}", "{_id: 2, x: 'def'}"}),
+         DocumentSourceSort::create(expCtx, BSON("x" << -1)),
+         DocumentSourceProject::create(BSON("x" << 1), expCtx)},
+        expCtx));
+    while (pipeline->getNext()) {
+    }
+
+    auto stages = pipeline->writeExplainOps(ExplainOptions::Verbosity::kExecStats);
+    ASSERT_EQ(stages.size(), 3UL);
+    ASSERT_TRUE(stages[0]["peakMemoryUsageBytes"].missing());
+    ASSERT_GT(stages[1]["peakMemoryUsageBytes"].coerceToLong(), 0LL);
+    ASSERT_TRUE(stages[2]["peakMemoryUsageBytes"].missing());
+
+    stages = pipeline->writeExplainOps(ExplainOptions::Verbosity::kQueryPlanner);
+    ASSERT_TRUE(stages[1]["peakMemoryUsageBytes"].missing());
+}
+
 }  // namespace
 
 class All : public Suite {
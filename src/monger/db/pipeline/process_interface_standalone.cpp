@@ -44,6 +44,7 @@
 #include "monger/db/cursor_manager.h"
 #include "monger/db/db_raii.h"
 #include "monger/db/index/index_descriptor.h"
+#include "monger/db/index_names.h"
 #include "monger/db/pipeline/document_source_cursor.h"
 #include "monger/db/pipeline/lite_parsed_pipeline.h"
 #include "monger/db/pipeline/pipeline_d.h"
@@ -55,11 +56,13 @@
 #include "monger/db/stats/fill_locker_info.h"
 #include "monger/db/stats/storage_stats.h"
 #include "monger/db/storage/backup_cursor_hooks.h"
+#include "monger/db/storage/temporary_record_store.h"
 #include "monger/db/transaction_history_iterator.h"
 #include "monger/db/transaction_participant.h"
 #include "monger/s/cluster_commands_helpers.h"
 #include "monger/s/query/document_source_merge_cursors.h"
 #include "monger/util/log.h"
+#include "monger/util/scopeguard.h"
 
 namespace monger {
 
@@ -135,6 +138,92 @@ bool supportsUniqueKey(const boost::intrusive_ptr<ExpressionContext>& expCtx,
             CollatorInterface::collatorsMatch(index->getCollator(), expCtx->getCollator()));
 }
 
+/**
+ * Returns true if 'index' can find the documents whose 'joinField' equals a given value.
+ */
+bool supportsJoinField(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                       const IndexCatalogEntry* index,
+                       const FieldPath& joinField) {
+    const auto* descriptor = index->descriptor();
+    const auto& accessMethod = descriptor->getAccessMethodName();
+    return (accessMethod == IndexNames::BTREE || accessMethod == IndexNames::HASHED) &&
+        !descriptor->isPartial() &&
+        descriptor->keyPattern().firstElementFieldNameStringData() == joinField.fullPath() &&
+        CollatorInterface::collatorsMatch(index->getCollator(), expCtx->getCollator());
+}
+
+/**
+ * A SpillTable kept in a temporary RecordStore of the storage engine. The table is accessed through
+ * a recovery unit of its own, so spilling neither writes in the snapshot which the operation reads
+ * from nor keeps that snapshot open.
+ */
+class TemporaryRecordStoreSpillTable final : public SpillTable {
+public:
+    explicit TemporaryRecordStoreSpillTable(OperationContext* opCtx)
+        : _recoveryUnit(opCtx->getServiceContext()->getStorageEngine()->newRecoveryUnit()) {
+        Lock::GlobalLock lk(opCtx, MODE_IS);
+        _rs = opCtx->getServiceContext()->getStorageEngine()->makeTemporaryRecordStore(opCtx);
+    }
+
+    std::vector<RecordId> insert(OperationContext* opCtx,
+                                 const std::vector<BSONObj>& objs) final {
+        std::vector<Record> records;
+        records.reserve(objs.size());
+        for (auto&& obj : objs) {
+            records.emplace_back(Record{RecordId(), RecordData(obj.objdata(), obj.objsize())});
+        }
+        std::vector<Timestamp> timestamps(records.size());
+
+        withOwnRecoveryUnit(opCtx, [&] {
+            WriteUnitOfWork wuow(opCtx);
+            uassertStatusOK(_rs->rs()->insertRecords(opCtx, &records, timestamps));
+            wuow.commit();
+        });
+
+        std::vector<RecordId> ids;
+        ids.reserve(records.size());
+        for (auto&& record : records) {
+            ids.push_back(record.id);
+        }
+        return ids;
+    }
+
+    BSONObj find(OperationContext* opCtx, const RecordId& id) final {
+        BSONObj obj;
+        withOwnRecoveryUnit(opCtx, [&] {
+            RecordData data;
+            invariant(_rs->rs()->findRecord(opCtx, id, &data));
+            obj = data.toBson().getOwned();
+        });
+        return obj;
+    }
+
+    void dispose(OperationContext* opCtx) final {
+        Lock::GlobalLock lk(opCtx, MODE_IS);
+        _rs->deleteTemporaryTable(opCtx);
+    }
+
+private:
+    template <typename Fn>
+    void withOwnRecoveryUnit(OperationContext* opCtx, Fn&& fn) {
+        // The table is private to this operation, so only the storage engine itself needs to be
+        // protected while it is used.
+        Lock::GlobalLock lk(opCtx, MODE_IS);
+        auto operationRU = opCtx->releaseRecoveryUnit();
+        auto operationRUState = opCtx->setRecoveryUnit(
+            std::move(_recoveryUnit), WriteUnitOfWork::RecoveryUnitState::kNotInUnitOfWork);
+        ON_BLOCK_EXIT([&] {
+            opCtx->recoveryUnit()->abandonSnapshot();
+            _recoveryUnit = opCtx->releaseRecoveryUnit();
+            opCtx->setRecoveryUnit(std::move(operationRU), operationRUState);
+        });
+        fn();
+    }
+
+    std::unique_ptr<RecoveryUnit> _recoveryUnit;
+    std::unique_ptr<TemporaryRecordStore> _rs;
+};
+
 }  // namespace
 
 MongerInterfaceStandalone::MongerInterfaceStandalone(OperationContext* opCtx) : _client(opCtx) {}
@@ -538,6 +627,35 @@ bool MongerInterfaceStandalone::fieldsHaveSupportingUniqueIndex(
     return false;
 }
 
+MongerProcessInterface::CollectionJoinInfo MongerInterfaceStandalone::getCollectionJoinInfo(
+    const boost::intrusive_ptr<ExpressionContext>& expCtx,
+    const NamespaceString& nss,
+    const FieldPath& joinField) const {
+    auto* opCtx = expCtx->opCtx;
+    // As in fieldsHaveSupportingUniqueIndex(), only protect against concurrent modifications to
+    // the catalog.
+    Lock::DBLock dbLock(opCtx, nss.db(), MODE_IS);
+    Lock::CollectionLock collLock(opCtx, nss, MODE_IS);
+    auto databaseHolder = DatabaseHolder::get(opCtx);
+    auto db = databaseHolder->getDb(opCtx, nss.db());
+    auto collection = db ? db->getCollection(opCtx, nss) : nullptr;
+    if (!collection) {
+        return {};
+    }
+
+    CollectionJoinInfo info;
+    info.dataSizeBytes = collection->dataSize(opCtx);
+
+    auto indexIterator = collection->getIndexCatalog()->getIndexIterator(opCtx, false);
+    while (indexIterator->more()) {
+        if (supportsJoinField(expCtx, indexIterator->next(), joinField)) {
+            info.joinFieldIsIndexed = true;
+            break;
+        }
+    }
+    return info;
+}
+
 BSONObj MongerInterfaceStandalone::_reportCurrentOpForClient(
     OperationContext* opCtx, Client* client, CurrentOpTruncateMode truncateOps) const {
     BSONObjBuilder builder;
@@ -615,6 +733,11 @@ std::unique_ptr<CollatorInterface> MongerInterfaceStandalone::_getCollectionDefa
     return collator ? collator->clone() : nullptr;
 }
 
+std::unique_ptr<SpillTable> MongerInterfaceStandalone::makeSpillTable(
+    const boost::intrusive_ptr<ExpressionContext>& expCtx) const {
+    return std::make_unique<TemporaryRecordStoreSpillTable>(expCtx->opCtx);
+}
+
 std::unique_ptr<ResourceYielder> MongerInterfaceStandalone::getResourceYielder() const {
     return std::make_unique<MongerDResourceYielder>();
 }
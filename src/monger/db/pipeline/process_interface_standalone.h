@@ -136,6 +136,13 @@ public:
                                          const NamespaceString& nss,
                                          const std::set<FieldPath>& fieldPaths) const;
 
+    CollectionJoinInfo getCollectionJoinInfo(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                                             const NamespaceString& nss,
+                                             const FieldPath& joinField) const final;
+
+    std::unique_ptr<SpillTable> makeSpillTable(
+        const boost::intrusive_ptr<ExpressionContext>& expCtx) const final;
+
     virtual void checkRoutingInfoEpochOrThrow(const boost::intrusive_ptr<ExpressionContext>& expCtx,
                                               const NamespaceString& nss,
                                               ChunkVersion targetCollectionVersion) const override {
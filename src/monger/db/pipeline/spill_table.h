@@ -0,0 +1,68 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "monger/bson/bsonobj.h"
+#include "monger/db/record_id.h"
+
+namespace monger {
+
+class OperationContext;
+
+/**
+ * A temporary table in which an aggregation stage can keep data which does not fit in memory. Each
+ * object inserted is identified by the RecordId returned for it. A SpillTable is private to the
+ * stage which created it, and must be dropped with dispose() before it is destroyed.
+ */
+class SpillTable {
+public:
+    virtual ~SpillTable() = default;
+
+    /**
+     * Inserts 'objs', returning the id of each in the same order.
+     */
+    virtual std::vector<RecordId> insert(OperationContext* opCtx,
+                                         const std::vector<BSONObj>& objs) = 0;
+
+    /**
+     * Returns an owned copy of the object with id 'id', which must have been inserted into this
+     * table.
+     */
+    virtual BSONObj find(OperationContext* opCtx, const RecordId& id) = 0;
+
+    /**
+     * Drops the table. No other method may be called afterwards.
+     */
+    virtual void dispose(OperationContext* opCtx) = 0;
+};
+
+}  // namespace monger
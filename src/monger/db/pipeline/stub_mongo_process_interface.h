@@ -203,6 +203,17 @@ public:
         return true;
     }
 
+    CollectionJoinInfo getCollectionJoinInfo(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                                             const NamespaceString& nss,
+                                             const FieldPath& joinField) const override {
+        return {};
+    }
+
+    std::unique_ptr<SpillTable> makeSpillTable(
+        const boost::intrusive_ptr<ExpressionContext>& expCtx) const override {
+        return nullptr;
+    }
+
     boost::optional<ChunkVersion> refreshAndGetCollectionVersion(
         const boost::intrusive_ptr<ExpressionContext>& expCtx,
         const NamespaceString& nss) const override {
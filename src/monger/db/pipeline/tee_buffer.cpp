@@ -80,12 +80,21 @@ void TeeBuffer::loadNextBatch() {
     _buffer.clear();
     size_t bytesInBuffer = 0;
 
+    if (_memoryTracker) {
+        _memoryTracker->set(0);
+    }
+
     auto input = _source->getNext();
     for (; input.isAdvanced(); input = _source->getNext()) {
         bytesInBuffer += input.getDocument().getApproximateSize();
         _buffer.push_back(std::move(input));
 
-        if (bytesInBuffer >= _bufferSizeBytes) {
+        bool overBudget = bytesInBuffer >= _bufferSizeBytes;
+        if (_memoryTracker) {
+            _memoryTracker->set(bytesInBuffer);
+            overBudget = overBudget || !_memoryTracker->withinMemoryLimit();
+        }
+        if (overBudget) {
             break;  // Need to break here so we don't get the next input and accidentally ignore it.
         }
     }
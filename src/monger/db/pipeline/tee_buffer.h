@@ -35,6 +35,7 @@
 
 #include "monger/db/pipeline/document.h"
 #include "monger/db/pipeline/document_source.h"
+#include "monger/db/pipeline/memory_usage_tracker.h"
 #include "monger/db/query/query_knobs_gen.h"
 #include "monger/util/intrusive_counter.h"
 
@@ -59,6 +60,14 @@ public:
         _source = source;
     }
 
+    /**
+     * Makes the buffered documents be charged to 'memoryTracker', which must outlive this buffer. A
+     * batch is cut short, though never below one document, while the tracker is over its limit.
+     */
+    void setMemoryTracker(MemoryUsageTracker* memoryTracker) {
+        _memoryTracker = memoryTracker;
+    }
+
     /**
      * Removes 'consumerId' as a consumer of this buffer. This is required to be called if a
      * consumer will not consume all input.
@@ -70,6 +79,9 @@ public:
                 return info.stillInUse;
             })) {
             _buffer.clear();
+            if (_memoryTracker) {
+                _memoryTracker->set(0);
+            }
             if (_source) {
                 _source->dispose();
             }
@@ -94,6 +106,7 @@ private:
     void loadNextBatch();
 
     DocumentSource* _source = nullptr;
+    MemoryUsageTracker* _memoryTracker = nullptr;
 
     const size_t _bufferSizeBytes;
     std::vector<DocumentSource::GetNextResult> _buffer;
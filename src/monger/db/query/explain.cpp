@@ -175,6 +175,10 @@ size_t getDocsExamined(StageType type, const SpecificStats* specific) {
     if (STAGE_COLLSCAN == type) {
         const CollectionScanStats* spec = static_cast<const CollectionScanStats*>(specific);
         return spec->docsTested;
+    } else if (STAGE_PARALLEL_COLLSCAN == type) {
+        const ParallelCollectionScanStats* spec =
+            static_cast<const ParallelCollectionScanStats*>(specific);
+        return spec->docsTested;
     } else if (STAGE_FETCH == type) {
         const FetchStats* spec = static_cast<const FetchStats*>(specific);
         return spec->docsExamined;
@@ -364,6 +368,23 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("docsExamined", spec->docsTested);
         }
+    } else if (STAGE_PARALLEL_COLLSCAN == stats.stageType) {
+        ParallelCollectionScanStats* spec =
+            static_cast<ParallelCollectionScanStats*>(stats.specific.get());
+        bob->appendNumber("numPartitions", spec->partitions.size());
+        if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
+            bob->appendNumber("docsExamined", spec->docsTested);
+
+            BSONArrayBuilder partitionsBob(bob->subarrayStart("partitions"));
+            for (const auto& partition : spec->partitions) {
+                BSONObjBuilder partitionBob(partitionsBob.subobjStart());
+                partitionBob.appendNumber("docsExamined", partition.docsTested);
+                partitionBob.appendNumber("nReturned", partition.nReturned);
+                partitionBob.appendNumber("steps", partition.steps);
+                partitionBob.appendNumber("executionTimeMillis",
+                                          durationCount<Milliseconds>(partition.executionTime));
+            }
+        }
     } else if (STAGE_COUNT == stats.stageType) {
         CountStats* spec = static_cast<CountStats*>(stats.specific.get());
 
@@ -376,6 +397,7 @@ void Explain::statsToBSON(const PlanStageStats& stats,
 
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("keysExamined", spec->keysExamined);
+            bob->appendNumber("seeks", spec->seeks);
         }
 
         bob->append("keyPattern", spec->keyPattern);
@@ -392,12 +414,20 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         bob->appendBool("isPartial", spec->isPartial);
         bob->append("indexVersion", spec->indexVersion);
 
-        BSONObjBuilder indexBoundsBob;
-        indexBoundsBob.append("startKey", spec->startKey);
-        indexBoundsBob.append("startKeyInclusive", spec->startKeyInclusive);
-        indexBoundsBob.append("endKey", spec->endKey);
-        indexBoundsBob.append("endKeyInclusive", spec->endKeyInclusive);
-        bob->append("indexBounds", indexBoundsBob.obj());
+        if (!spec->indexBounds.isEmpty()) {
+            if ((topLevelBob->len() + spec->indexBounds.objsize()) > kMaxStatsBSONSize) {
+                bob->append("warning", "index bounds omitted due to BSON size limit");
+            } else {
+                bob->append("indexBounds", spec->indexBounds);
+            }
+        } else {
+            BSONObjBuilder indexBoundsBob;
+            indexBoundsBob.append("startKey", spec->startKey);
+            indexBoundsBob.append("startKeyInclusive", spec->startKeyInclusive);
+            indexBoundsBob.append("endKey", spec->endKey);
+            indexBoundsBob.append("endKeyInclusive", spec->endKeyInclusive);
+            bob->append("indexBounds", indexBoundsBob.obj());
+        }
     } else if (STAGE_DELETE == stats.stageType) {
         DeleteStats* spec = static_cast<DeleteStats*>(stats.specific.get());
 
@@ -439,6 +469,9 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         }
     } else if (STAGE_FETCH == stats.stageType) {
         FetchStats* spec = static_cast<FetchStats*>(stats.specific.get());
+        if (spec->estimatedDocsExamined) {
+            bob->appendNumber("estimatedDocsExamined", *spec->estimatedDocsExamined);
+        }
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("docsExamined", spec->docsExamined);
             bob->appendNumber("alreadyHasObj", spec->alreadyHasObj);
@@ -487,6 +520,9 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         bob->appendBool("isPartial", spec->isPartial);
         bob->append("indexVersion", spec->indexVersion);
         bob->append("direction", spec->direction > 0 ? "forward" : "backward");
+        if (spec->isSkipScan) {
+            bob->appendBool("isSkipScan", true);
+        }
 
         if ((topLevelBob->len() + spec->indexBounds.objsize()) > kMaxStatsBSONSize) {
             bob->append("warning", "index bounds omitted due to BSON size limit");
@@ -494,6 +530,10 @@ void Explain::statsToBSON(const PlanStageStats& stats,
             bob->append("indexBounds", spec->indexBounds);
         }
 
+        if (spec->estimatedKeysExamined) {
+            bob->appendNumber("estimatedKeysExamined", *spec->estimatedKeysExamined);
+        }
+
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("keysExamined", spec->keysExamined);
             bob->appendNumber("seeks", spec->seeks);
@@ -1010,7 +1050,11 @@ void Explain::getSummaryStats(const PlanExecutor& exec, PlanSummaryStats* statsO
                 static_cast<const CachedPlanStats*>(cachedPlan->getSpecificStats());
             statsOut->replanned = cachedStats->replanned;
         } else if (STAGE_MULTI_PLAN == stages[i]->stageType()) {
+            const MultiPlanStage* multiPlan = static_cast<const MultiPlanStage*>(stages[i]);
+            const MultiPlanStats* multiPlanStats =
+                static_cast<const MultiPlanStats*>(multiPlan->getSpecificStats());
             statsOut->fromMultiPlanner = true;
+            statsOut->planningTimeMicros += multiPlanStats->planningTimeMicros;
         }
     }
 }
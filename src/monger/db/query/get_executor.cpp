@@ -65,6 +65,7 @@
 #include "monger/db/query/index_bounds_builder.h"
 #include "monger/db/query/internal_plans.h"
 #include "monger/db/query/plan_cache.h"
+#include "monger/db/query/plan_cost_estimator.h"
 #include "monger/db/query/plan_executor.h"
 #include "monger/db/query/planner_access.h"
 #include "monger/db/query/planner_analysis.h"
@@ -83,6 +84,7 @@
 #include "monger/db/service_context.h"
 #include "monger/db/storage/oplog_hack.h"
 #include "monger/db/storage/storage_options.h"
+#include "monger/db/transaction_participant.h"
 #include "monger/scripting/engine.h"
 #include "monger/util/log.h"
 #include "monger/util/str.h"
@@ -186,23 +188,25 @@ IndexEntry indexEntryFromIndexCatalogEntry(OperationContext* opCtx,
         }
     }
 
-    return {desc->keyPattern(),
-            desc->getIndexType(),
-            isMultikey,
-            // The fixed-size vector of multikey paths stored in the index catalog.
-            ice.getMultikeyPaths(opCtx),
-            // The set of multikey paths from special metadata keys stored in the index itself.
-            // Indexes that have these metadata keys do not store a fixed-size vector of multikey
-            // metadata in the index catalog. Depending on the index type, an index uses one of
-            // these mechanisms (or neither), but not both.
-            multikeyPathSet,
-            desc->isSparse(),
-            desc->unique(),
-            IndexEntry::Identifier{desc->indexName()},
-            ice.getFilterExpression(),
-            desc->infoObj(),
-            ice.getCollator(),
-            projExec};
+    IndexEntry entry{desc->keyPattern(),
+                     desc->getIndexType(),
+                     isMultikey,
+                     // The fixed-size vector of multikey paths stored in the index catalog.
+                     ice.getMultikeyPaths(opCtx),
+                     // The set of multikey paths from special metadata keys stored in the index
+                     // itself. Indexes that have these metadata keys do not store a fixed-size
+                     // vector of multikey metadata in the index catalog. Depending on the index
+                     // type, an index uses one of these mechanisms (or neither), but not both.
+                     multikeyPathSet,
+                     desc->isSparse(),
+                     desc->unique(),
+                     IndexEntry::Identifier{desc->indexName()},
+                     ice.getFilterExpression(),
+                     desc->infoObj(),
+                     ice.getCollator(),
+                     projExec};
+    entry.statistics = ice.getStatistics();
+    return entry;
 }
 
 CoreIndexInfo indexInfoFromIndexCatalogEntry(const IndexCatalogEntry& ice) {
@@ -304,6 +308,36 @@ void fillOutPlannerParams(OperationContext* opCtx,
             opCtx, collection, canonicalQuery->getQueryRequest().isTailable())) {
         plannerParams->options |= QueryPlannerParams::OPLOG_SCAN_WAIT_FOR_VISIBLE;
     }
+
+    if ((plannerParams->options & QueryPlannerParams::PARALLEL_COLLSCAN) &&
+        !canScanCollectionInParallel(opCtx, collection)) {
+        plannerParams->options &= ~QueryPlannerParams::PARALLEL_COLLSCAN;
+    }
+}
+
+bool canScanCollectionInParallel(OperationContext* opCtx, Collection* collection) {
+    if (internalQueryParallelCollectionScanThreads.load() <= 1) {
+        return false;
+    }
+
+    // Each partition of a parallel scan is read by a separate operation under its own storage
+    // snapshot, so the scan can only offer the guarantees of an untimestamped read which yields.
+    if (opCtx->recoveryUnit()->getTimestampReadSource() != RecoveryUnit::ReadSource::kUnset) {
+        return false;
+    }
+    auto txnParticipant = TransactionParticipant::get(opCtx);
+    if (txnParticipant && txnParticipant.inMultiDocumentTransaction()) {
+        return false;
+    }
+
+    // Partitions are RecordId ranges, so insertion order must match RecordId order. Capped
+    // collections are excluded since documents can be deleted out from under a partition boundary.
+    auto rs = collection->getRecordStore();
+    if (collection->isCapped() || collection->ns().isOplog() || !rs->isInRecordIdOrder()) {
+        return false;
+    }
+
+    return rs->dataSize(opCtx) >= internalQueryParallelCollectionScanMinBytes.load();
 }
 
 bool shouldWaitForOplogVisibility(OperationContext* opCtx,
@@ -540,6 +574,15 @@ StatusWith<PrepareExecutionResult> prepareExecution(OperationContext* opCtx,
         }
     }
 
+    // Annotate the solutions with their estimated cost, and discard those which index statistics
+    // show to be far more expensive than another, so that the trial period only races plausible
+    // plans.
+    if (auto pruned = plan_cost_estimator::pruneByEstimatedCost(
+            &solutions, internalQueryPlannerCostBasedPruningRatio.load())) {
+        LOG(2) << "Pruned " << pruned << " candidate plans by estimated cost for query "
+               << redact(canonicalQuery->toStringShort());
+    }
+
     if (1 == solutions.size()) {
         // Only one possible plan.  Run it.  Build the stages from the solution.
         PlanStage* rawRoot;
@@ -555,22 +598,25 @@ StatusWith<PrepareExecutionResult> prepareExecution(OperationContext* opCtx,
             std::move(canonicalQuery), std::move(solutions[0]), std::move(root));
     } else {
         // Many solutions. Create a MultiPlanStage to pick the best, update the cache,
-        // and so on. The working set will be shared by all candidate plans.
+        // and so on. The working set will be shared by all candidate plans, unless they may be
+        // worked concurrently during the trial period.
         auto multiPlanStage =
             std::make_unique<MultiPlanStage>(opCtx, collection, canonicalQuery.get());
+        const bool parallelTrial =
+            MultiPlanStage::canRunTrialInParallel(opCtx, *canonicalQuery, solutions.size());
 
         for (size_t ix = 0; ix < solutions.size(); ++ix) {
             if (solutions[ix]->cacheData.get()) {
                 solutions[ix]->cacheData->indexFilterApplied = plannerParams.indexFiltersApplied;
             }
 
-            // version of StageBuild::build when WorkingSet is shared
+            WorkingSet* planWs = parallelTrial ? multiPlanStage->makePrivateWorkingSet(ws) : ws;
             PlanStage* nextPlanRoot;
             verify(StageBuilder::build(
-                opCtx, collection, *canonicalQuery, *solutions[ix], ws, &nextPlanRoot));
+                opCtx, collection, *canonicalQuery, *solutions[ix], planWs, &nextPlanRoot));
 
             // Takes ownership of 'nextPlanRoot'.
-            multiPlanStage->addPlan(std::move(solutions[ix]), nextPlanRoot, ws);
+            multiPlanStage->addPlan(std::move(solutions[ix]), nextPlanRoot, planWs);
         }
 
         root = std::move(multiPlanStage);
@@ -586,6 +632,12 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutor(
     unique_ptr<CanonicalQuery> canonicalQuery,
     PlanExecutor::YieldPolicy yieldPolicy,
     size_t plannerOptions) {
+    // A parallel collection scan relies on the executor yielding to release the locks its worker
+    // threads may be queued behind.
+    if (yieldPolicy == PlanExecutor::YIELD_AUTO) {
+        plannerOptions |= QueryPlannerParams::PARALLEL_COLLSCAN;
+    }
+
     unique_ptr<WorkingSet> ws = std::make_unique<WorkingSet>();
     StatusWith<PrepareExecutionResult> executionResult =
         prepareExecution(opCtx, collection, ws.get(), std::move(canonicalQuery), plannerOptions);
@@ -1148,23 +1200,25 @@ bool turnIxscanIntoCount(QuerySolution* soln) {
         return false;
     }
 
-    // Make sure the bounds are OK.
     BSONObj startKey;
     bool startKeyInclusive;
     BSONObj endKey;
     bool endKeyInclusive;
 
-    if (!IndexBoundsBuilder::isSingleInterval(
+    // Make the count node that we replace the fetch + ixscan with. A single interval is counted
+    // between a start and an end key. Other bounds are counted by checking each key against them,
+    // skipping over the keys between their intervals. The order of the keys does not matter to a
+    // count, so the bounds are always scanned forwards.
+    CountScanNode* csn = new CountScanNode(isn->index);
+    if (IndexBoundsBuilder::isSingleInterval(
             isn->bounds, &startKey, &startKeyInclusive, &endKey, &endKeyInclusive)) {
-        return false;
+        csn->startKey = startKey;
+        csn->startKeyInclusive = startKeyInclusive;
+        csn->endKey = endKey;
+        csn->endKeyInclusive = endKeyInclusive;
+    } else {
+        csn->bounds = isn->direction > 0 ? isn->bounds : isn->bounds.reverse();
     }
-
-    // Make the count node that we replace the fetch + ixscan with.
-    CountScanNode* csn = new CountScanNode(isn->index);
-    csn->startKey = startKey;
-    csn->startKeyInclusive = startKeyInclusive;
-    csn->endKey = endKey;
-    csn->endKeyInclusive = endKeyInclusive;
     // Takes ownership of 'cn' and deletes the old root.
     soln->root.reset(csn);
     return true;
@@ -1284,6 +1338,9 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorCount(
     }
 
     size_t plannerOptions = QueryPlannerParams::IS_COUNT;
+    if (yieldPolicy == PlanExecutor::YIELD_AUTO) {
+        plannerOptions |= QueryPlannerParams::PARALLEL_COLLSCAN;
+    }
     if (OperationShardingState::isOperationVersioned(opCtx)) {
         plannerOptions |= QueryPlannerParams::INCLUDE_SHARD_FILTER;
     }
@@ -105,6 +105,12 @@ bool shouldWaitForOplogVisibility(OperationContext* opCtx,
                                   const Collection* collection,
                                   bool tailable);
 
+/**
+ * Determines whether the operation and the collection allow a collection scan to be split into
+ * partitions which are read concurrently by worker threads.
+ */
+bool canScanCollectionInParallel(OperationContext* opCtx, Collection* collection);
+
 /**
  * Get a plan executor for a query.
  *
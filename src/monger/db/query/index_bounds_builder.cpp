@@ -672,6 +672,30 @@ void IndexBoundsBuilder::_translatePredicate(const MatchExpression* expr,
 
         *tightnessOut = IndexBoundsBuilder::EXACT;
 
+        if (ime->hasPackedEqualities() && !isHashed && ime->getRegexes().empty()) {
+            // Every equality is an integer or every equality is an ObjectId, so each one maps to a
+            // single exact point interval which is unaffected by the index collation. Copy all of
+            // the values into one buffer which the intervals share, rather than allocating a
+            // separate BSONObj per interval; this matters for $in lists with thousands of values.
+            // The equalities are already sorted and deduped, so the intervals need no unionize.
+            const auto& equalities = ime->getEqualities();
+            BSONObjBuilder bob;
+            for (auto&& equality : equalities) {
+                bob.appendAs(equality, "");
+            }
+            BSONObj points = bob.obj();
+
+            oilOut->intervals.reserve(oilOut->intervals.size() + equalities.size());
+            for (auto&& point : points) {
+                Interval interval;
+                interval._intervalData = points;
+                interval.startInclusive = interval.endInclusive = true;
+                interval.start = interval.end = point;
+                oilOut->intervals.push_back(std::move(interval));
+            }
+            return;
+        }
+
         // Create our various intervals.
 
         IndexBoundsBuilder::BoundsTightness tightness;
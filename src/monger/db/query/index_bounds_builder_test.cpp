@@ -947,6 +947,47 @@ TEST(IndexBoundsBuilderTest, TranslateIn) {
     ASSERT_EQUALS(tightness, IndexBoundsBuilder::EXACT);
 }
 
+TEST(IndexBoundsBuilderTest, TranslateInObjectIdsIsExactAndSorted) {
+    auto testIndex = buildSimpleIndexEntry();
+    BSONObj obj = fromjson(
+        "{a: {$in: [ObjectId('000000000000000000000003'), ObjectId('000000000000000000000001'), "
+        "ObjectId('000000000000000000000003'), ObjectId('000000000000000000000002')]}}");
+    auto expr = parseMatchExpression(obj);
+    BSONElement elt = obj.firstElement();
+    OrderedIntervalList oil;
+    IndexBoundsBuilder::BoundsTightness tightness;
+    IndexBoundsBuilder::translate(expr.get(), elt, testIndex, &oil, &tightness);
+    ASSERT_EQUALS(oil.name, "a");
+    ASSERT_EQUALS(oil.intervals.size(), 3U);
+    for (size_t i = 0; i < oil.intervals.size(); ++i) {
+        OID oid = OID("00000000000000000000000" + std::to_string(i + 1));
+        ASSERT_EQUALS(Interval::INTERVAL_EQUALS,
+                      oil.intervals[i].compare(Interval(BSON("" << oid << "" << oid), true, true)));
+    }
+    ASSERT_EQUALS(tightness, IndexBoundsBuilder::EXACT);
+}
+
+TEST(IndexBoundsBuilderTest, TranslateInIntegersIgnoresCollation) {
+    CollatorInterfaceMock collator(CollatorInterfaceMock::MockType::kReverseString);
+    auto testIndex = buildSimpleIndexEntry();
+    testIndex.collator = &collator;
+    BSONObj obj = fromjson("{a: {$in: [NumberLong(5), 2, NumberLong(-7)]}}");
+    auto expr = parseMatchExpression(obj);
+    BSONElement elt = obj.firstElement();
+    OrderedIntervalList oil;
+    IndexBoundsBuilder::BoundsTightness tightness;
+    IndexBoundsBuilder::translate(expr.get(), elt, testIndex, &oil, &tightness);
+    ASSERT_EQUALS(oil.name, "a");
+    ASSERT_EQUALS(oil.intervals.size(), 3U);
+    ASSERT_EQUALS(Interval::INTERVAL_EQUALS,
+                  oil.intervals[0].compare(Interval(fromjson("{'': -7, '': -7}"), true, true)));
+    ASSERT_EQUALS(Interval::INTERVAL_EQUALS,
+                  oil.intervals[1].compare(Interval(fromjson("{'': 2, '': 2}"), true, true)));
+    ASSERT_EQUALS(Interval::INTERVAL_EQUALS,
+                  oil.intervals[2].compare(Interval(fromjson("{'': 5, '': 5}"), true, true)));
+    ASSERT_EQUALS(tightness, IndexBoundsBuilder::EXACT);
+}
+
 TEST(IndexBoundsBuilderTest, TranslateInArray) {
     auto testIndex = buildSimpleIndexEntry();
     BSONObj obj = fromjson("{a: {$in: [[1], 2]}}");
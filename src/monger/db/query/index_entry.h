@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <memory>
 #include <set>
 #include <string>
 
@@ -42,6 +43,7 @@
 namespace monger {
 
 class CollatorInterface;
+class IndexStatistics;
 class MatchExpression;
 
 /**
@@ -219,6 +221,10 @@ struct IndexEntry : CoreIndexInfo {
 
     // Geo indices have extra parameters.  We need those available to plan correctly.
     BSONObj infoObj;
+
+    // Statistics on the distribution of the index's keys, or null if the index has not been
+    // analyzed. Used to estimate the cost of plans which scan this index.
+    std::shared_ptr<const IndexStatistics> statistics;
 };
 
 std::ostream& operator<<(std::ostream& stream, const IndexEntry::Identifier& ident);
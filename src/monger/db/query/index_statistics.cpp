@@ -0,0 +1,470 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "monger/platform/basic.h"
+
+#include "monger/db/query/index_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "monger/bson/bsonobjbuilder.h"
+#include "monger/db/query/index_bounds.h"
+#include "monger/db/query/interval.h"
+#include "monger/util/assert_util.h"
+#include "monger/util/str.h"
+
+namespace monger {
+
+namespace {
+
+constexpr int kFormatVersion = 1;
+
+BSONObj ownedValue(const BSONElement& elem) {
+    BSONObjBuilder bob;
+    bob.appendAs(elem, "");
+    return bob.obj();
+}
+
+int compareValues(const BSONElement& lhs, const BSONElement& rhs) {
+    return lhs.woCompare(rhs, false);
+}
+
+bool lessThanValue(const BSONObj& lhs, const BSONObj& rhs) {
+    return compareValues(lhs.firstElement(), rhs.firstElement()) < 0;
+}
+
+/**
+ * Returns the fraction of the keys of a bucket spanning ['bucketLow', 'bucketHigh'] which fall in
+ * the interval ['low', 'high'], with the given inclusivity. Both ranges are ascending.
+ */
+double overlapFraction(const BSONElement& bucketLow,
+                       bool bucketLowInclusive,
+                       const BSONElement& bucketHigh,
+                       const BSONElement& low,
+                       bool lowInclusive,
+                       const BSONElement& high,
+                       bool highInclusive) {
+    const int highVsBucketLow = compareValues(high, bucketLow);
+    const int lowVsBucketHigh = compareValues(low, bucketHigh);
+    if (highVsBucketLow < 0 || (highVsBucketLow == 0 && !(highInclusive && bucketLowInclusive))) {
+        return 0.0;
+    }
+    if (lowVsBucketHigh > 0 || (lowVsBucketHigh == 0 && !lowInclusive)) {
+        return 0.0;
+    }
+
+    const int lowVsBucketLow = compareValues(low, bucketLow);
+    const int highVsBucketHigh = compareValues(high, bucketHigh);
+    const bool coversLow =
+        lowVsBucketLow < 0 || (lowVsBucketLow == 0 && (lowInclusive || !bucketLowInclusive));
+    const bool coversHigh = highVsBucketHigh > 0 || (highVsBucketHigh == 0 && highInclusive);
+    if (coversLow && coversHigh) {
+        return 1.0;
+    }
+
+    // Interpolate within numeric buckets, treating the bucket's values as uniformly spread.
+    if (bucketLow.isNumber() && bucketHigh.isNumber()) {
+        const double bucketLowValue = bucketLow.numberDouble();
+        const double bucketHighValue = bucketHigh.numberDouble();
+        const double width = bucketHighValue - bucketLowValue;
+        if (width > 0) {
+            const double overlapLow =
+                (!coversLow && low.isNumber()) ? low.numberDouble() : bucketLowValue;
+            const double overlapHigh =
+                (!coversHigh && high.isNumber()) ? high.numberDouble() : bucketHighValue;
+            return std::min(1.0, std::max(0.0, (overlapHigh - overlapLow) / width));
+        }
+    }
+
+    // Nothing better is known about the distribution within the bucket.
+    return 0.5;
+}
+
+}  // namespace
+
+//
+// IndexStatistics::Builder
+//
+
+IndexStatistics::Builder::Builder(size_t sampleSize, size_t numBuckets, int64_t seed)
+    : _sampleSize(std::max(sampleSize, size_t{1})),
+      _numBuckets(std::max(numBuckets, size_t{1})),
+      _random(seed) {}
+
+void IndexStatistics::Builder::addKey(const BSONObj& key) {
+    const BSONElement value = key.firstElement();
+    invariant(!value.eoo());
+
+    // Keys arrive in index order, so equal leading values are adjacent.
+    if (_numKeys == 0 || compareValues(value, _lastValue.firstElement()) != 0) {
+        _lastValue = ownedValue(value);
+        ++_numDistinctValues;
+    }
+    ++_numKeys;
+
+    if (_sample.size() < _sampleSize) {
+        _sample.push_back(ownedValue(value));
+    } else {
+        const auto slot = _random.nextInt64(_numKeys);
+        if (slot < static_cast<int64_t>(_sampleSize)) {
+            _sample[slot] = ownedValue(value);
+        }
+    }
+}
+
+std::shared_ptr<IndexStatistics> IndexStatistics::Builder::done(Date_t now) {
+    std::sort(_sample.begin(), _sample.end(), lessThanValue);
+
+    // Collapse the sorted sample into runs of equal values.
+    struct Run {
+        BSONObj value;
+        size_t count;
+    };
+    std::vector<Run> runs;
+    for (auto&& value : _sample) {
+        if (runs.empty() ||
+            compareValues(runs.back().value.firstElement(), value.firstElement()) != 0) {
+            runs.push_back({value, 0});
+        }
+        ++runs.back().count;
+    }
+
+    const double scale = _sample.empty() ? 0.0 : static_cast<double>(_numKeys) / _sample.size();
+
+    // A value is a most common value if it would fill at least a whole bucket on its own. Such
+    // values are counted exactly rather than smeared across a bucket, which is what makes point
+    // estimates on skewed data accurate.
+    const size_t mcvThreshold = std::max(size_t{2}, _sample.size() / _numBuckets);
+    std::vector<size_t> mcvRuns;
+    for (size_t i = 0; i < runs.size(); ++i) {
+        if (runs[i].count >= mcvThreshold) {
+            mcvRuns.push_back(i);
+        }
+    }
+    if (mcvRuns.size() > kMaxMostCommonValues) {
+        std::partial_sort(mcvRuns.begin(),
+                          mcvRuns.begin() + kMaxMostCommonValues,
+                          mcvRuns.end(),
+                          [&](size_t lhs, size_t rhs) {
+                              return runs[lhs].count > runs[rhs].count;
+                          });
+        mcvRuns.resize(kMaxMostCommonValues);
+        std::sort(mcvRuns.begin(), mcvRuns.end());
+    }
+
+    std::vector<MostCommonValue> mostCommonValues;
+    std::vector<bool> isMostCommon(runs.size(), false);
+    size_t sampledMcvKeys = 0;
+    for (auto i : mcvRuns) {
+        isMostCommon[i] = true;
+        sampledMcvKeys += runs[i].count;
+        mostCommonValues.push_back(
+            {runs[i].value, static_cast<long long>(std::llround(runs[i].count * scale))});
+    }
+
+    // Distinct values seen in the sample under-represent those in the index, so scale the
+    // per-bucket counts of distinct values up to match the exact total.
+    const size_t sampledOtherValues = runs.size() - mostCommonValues.size();
+    const long long otherValues = std::max(
+        _numDistinctValues - static_cast<long long>(mostCommonValues.size()), 0LL);
+    const double ndvScale = sampledOtherValues == 0
+        ? 1.0
+        : std::max(1.0, static_cast<double>(otherValues) / sampledOtherValues);
+
+    // Divide the remaining sampled keys into buckets of roughly equal depth, never splitting a run
+    // of equal values across two buckets.
+    std::vector<Bucket> buckets;
+    const size_t sampledOtherKeys = _sample.size() - sampledMcvKeys;
+    const size_t bucketDepth =
+        std::max(size_t{1}, (sampledOtherKeys + _numBuckets - 1) / _numBuckets);
+    size_t bucketKeys = 0;
+    size_t bucketValues = 0;
+    for (size_t i = 0; i < runs.size(); ++i) {
+        if (isMostCommon[i]) {
+            continue;
+        }
+        bucketKeys += runs[i].count;
+        ++bucketValues;
+        if (bucketKeys >= bucketDepth) {
+            buckets.push_back({runs[i].value,
+                               static_cast<long long>(std::llround(bucketKeys * scale)),
+                               static_cast<long long>(std::llround(bucketValues * ndvScale))});
+            bucketKeys = 0;
+            bucketValues = 0;
+        }
+    }
+    if (bucketKeys > 0) {
+        auto lastOther = std::find(isMostCommon.rbegin(), isMostCommon.rend(), false);
+        invariant(lastOther != isMostCommon.rend());
+        const size_t lastOtherRun = runs.size() - 1 - (lastOther - isMostCommon.rbegin());
+        buckets.push_back({runs[lastOtherRun].value,
+                           static_cast<long long>(std::llround(bucketKeys * scale)),
+                           static_cast<long long>(std::llround(bucketValues * ndvScale))});
+    }
+
+    BSONObj minValue = runs.empty() ? BSONObj() : runs.front().value;
+    return std::shared_ptr<IndexStatistics>(new IndexStatistics(_numKeys,
+                                                                _numDistinctValues,
+                                                                std::move(minValue),
+                                                                std::move(mostCommonValues),
+                                                                std::move(buckets),
+                                                                now));
+}
+
+//
+// IndexStatistics
+//
+
+IndexStatistics::IndexStatistics(long long numKeys,
+                                 long long numDistinctValues,
+                                 BSONObj minValue,
+                                 std::vector<MostCommonValue> mostCommonValues,
+                                 std::vector<Bucket> buckets,
+                                 Date_t analyzedAt)
+    : _numKeys(numKeys),
+      _numDistinctValues(numDistinctValues),
+      _minValue(std::move(minValue)),
+      _mostCommonValues(std::move(mostCommonValues)),
+      _buckets(std::move(buckets)),
+      _analyzedAt(analyzedAt),
+      _mostCommonValueDeltas(_mostCommonValues.size()),
+      _bucketDeltas(_buckets.size()) {}
+
+StatusWith<std::shared_ptr<IndexStatistics>> IndexStatistics::parse(const BSONObj& obj) {
+    if (obj["version"].numberInt() != kFormatVersion) {
+        return {ErrorCodes::UnsupportedFormat,
+                str::stream() << "Unsupported index statistics version: " << obj["version"]};
+    }
+
+    const BSONElement numKeys = obj["numKeys"];
+    const BSONElement numDistinctValues = obj["numDistinctValues"];
+    const BSONElement analyzedAt = obj["analyzedAt"];
+    const BSONElement mostCommonValuesElem = obj["mostCommonValues"];
+    const BSONElement bucketsElem = obj["buckets"];
+    if (!numKeys.isNumber() || !numDistinctValues.isNumber() || analyzedAt.type() != Date ||
+        mostCommonValuesElem.type() != Array || bucketsElem.type() != Array) {
+        return {ErrorCodes::FailedToParse, str::stream() << "Malformed index statistics: " << obj};
+    }
+
+    BSONObj minValue;
+    if (const BSONElement min = obj["min"]) {
+        minValue = ownedValue(min);
+    }
+
+    std::vector<MostCommonValue> mostCommonValues;
+    for (auto&& elem : mostCommonValuesElem.Obj()) {
+        if (elem.type() != Object || elem.Obj()["value"].eoo() ||
+            !elem.Obj()["count"].isNumber()) {
+            return {ErrorCodes::FailedToParse,
+                    str::stream() << "Malformed most common value in index statistics: " << elem};
+        }
+        mostCommonValues.push_back(
+            {ownedValue(elem.Obj()["value"]), elem.Obj()["count"].safeNumberLong()});
+    }
+
+    std::vector<Bucket> buckets;
+    for (auto&& elem : bucketsElem.Obj()) {
+        if (elem.type() != Object || elem.Obj()["upperBound"].eoo() ||
+            !elem.Obj()["count"].isNumber() || !elem.Obj()["numDistinctValues"].isNumber()) {
+            return {ErrorCodes::FailedToParse,
+                    str::stream() << "Malformed bucket in index statistics: " << elem};
+        }
+        buckets.push_back({ownedValue(elem.Obj()["upperBound"]),
+                           elem.Obj()["count"].safeNumberLong(),
+                           elem.Obj()["numDistinctValues"].safeNumberLong()});
+    }
+
+    if (!buckets.empty() && minValue.isEmpty()) {
+        return {ErrorCodes::FailedToParse,
+                str::stream() << "Index statistics with buckets must have a minimum: " << obj};
+    }
+
+    return std::shared_ptr<IndexStatistics>(new IndexStatistics(numKeys.safeNumberLong(),
+                                                                numDistinctValues.safeNumberLong(),
+                                                                std::move(minValue),
+                                                                std::move(mostCommonValues),
+                                                                std::move(buckets),
+                                                                analyzedAt.date()));
+}
+
+BSONObj IndexStatistics::toBSON() const {
+    BSONObjBuilder bob;
+    bob.append("version", kFormatVersion);
+    bob.append("numKeys", numKeys());
+    bob.append("numDistinctValues", _numDistinctValues);
+    bob.appendDate("analyzedAt", _analyzedAt);
+    if (!_minValue.isEmpty()) {
+        bob.appendAs(_minValue.firstElement(), "min");
+    }
+
+    {
+        BSONArrayBuilder mostCommonValuesBuilder(bob.subarrayStart("mostCommonValues"));
+        for (size_t i = 0; i < _mostCommonValues.size(); ++i) {
+            BSONObjBuilder valueBuilder(mostCommonValuesBuilder.subobjStart());
+            valueBuilder.appendAs(_mostCommonValues[i].value.firstElement(), "value");
+            valueBuilder.append("count", mostCommonValueCount(i));
+        }
+    }
+
+    {
+        BSONArrayBuilder bucketsBuilder(bob.subarrayStart("buckets"));
+        for (size_t i = 0; i < _buckets.size(); ++i) {
+            BSONObjBuilder bucketBuilder(bucketsBuilder.subobjStart());
+            bucketBuilder.appendAs(_buckets[i].upperBound.firstElement(), "upperBound");
+            bucketBuilder.append("count", bucketCount(i));
+            bucketBuilder.append("numDistinctValues", _buckets[i].numDistinctValues);
+        }
+    }
+
+    return bob.obj();
+}
+
+long long IndexStatistics::numKeys() const {
+    return std::max(_numKeys + _numKeysDelta.load(), 0LL);
+}
+
+long long IndexStatistics::mostCommonValueCount(size_t index) const {
+    return std::max(_mostCommonValues[index].count + _mostCommonValueDeltas[index].load(), 0LL);
+}
+
+long long IndexStatistics::bucketCount(size_t index) const {
+    return std::max(_buckets[index].count + _bucketDeltas[index].load(), 0LL);
+}
+
+double IndexStatistics::estimateKeys(const OrderedIntervalList& oil) const {
+    double total = 0;
+    for (auto&& interval : oil.intervals) {
+        total += estimateKeys(interval);
+    }
+    return std::min(total, static_cast<double>(numKeys()));
+}
+
+double IndexStatistics::estimateKeys(const Interval& interval) const {
+    BSONElement low = interval.start;
+    bool lowInclusive = interval.startInclusive;
+    BSONElement high = interval.end;
+    bool highInclusive = interval.endInclusive;
+    if (compareValues(low, high) > 0) {
+        std::swap(low, high);
+        std::swap(lowInclusive, highInclusive);
+    }
+    const bool isPoint = compareValues(low, high) == 0 && lowInclusive && highInclusive;
+
+    double total = 0;
+    for (size_t i = 0; i < _mostCommonValues.size(); ++i) {
+        const BSONElement value = _mostCommonValues[i].value.firstElement();
+        const int vsLow = compareValues(value, low);
+        const int vsHigh = compareValues(value, high);
+        if ((vsLow > 0 || (vsLow == 0 && lowInclusive)) &&
+            (vsHigh < 0 || (vsHigh == 0 && highInclusive))) {
+            if (isPoint) {
+                return mostCommonValueCount(i);
+            }
+            total += mostCommonValueCount(i);
+        }
+    }
+
+    if (_buckets.empty()) {
+        return total;
+    }
+
+    BSONElement bucketLow = _minValue.firstElement();
+    bool bucketLowInclusive = true;
+    for (size_t i = 0; i < _buckets.size(); ++i) {
+        const BSONElement bucketHigh = _buckets[i].upperBound.firstElement();
+        if (isPoint) {
+            const int vsBucketLow = compareValues(low, bucketLow);
+            const int vsBucketHigh = compareValues(low, bucketHigh);
+            if ((vsBucketLow > 0 || (vsBucketLow == 0 && bucketLowInclusive)) &&
+                vsBucketHigh <= 0) {
+                // Assume the bucket's keys are spread evenly over its distinct values.
+                return static_cast<double>(bucketCount(i)) /
+                    std::max(_buckets[i].numDistinctValues, 1LL);
+            }
+        } else {
+            total += bucketCount(i) *
+                overlapFraction(bucketLow,
+                                bucketLowInclusive,
+                                bucketHigh,
+                                low,
+                                lowInclusive,
+                                high,
+                                highInclusive);
+        }
+        bucketLow = bucketHigh;
+        bucketLowInclusive = false;
+    }
+
+    return total;
+}
+
+void IndexStatistics::recordInsertedKeys(const std::vector<BSONObj>& keys) {
+    recordKeys(keys, 1);
+}
+
+void IndexStatistics::recordDeletedKeys(const std::vector<BSONObj>& keys) {
+    recordKeys(keys, -1);
+}
+
+void IndexStatistics::recordKeys(const std::vector<BSONObj>& keys, long long delta) {
+    for (auto&& key : keys) {
+        const BSONElement value = key.firstElement();
+        _numKeysDelta.fetchAndAdd(delta);
+
+        auto mcv = std::lower_bound(_mostCommonValues.begin(),
+                                    _mostCommonValues.end(),
+                                    value,
+                                    [](const MostCommonValue& entry, const BSONElement& value) {
+                                        return compareValues(entry.value.firstElement(), value) < 0;
+                                    });
+        if (mcv != _mostCommonValues.end() &&
+            compareValues(mcv->value.firstElement(), value) == 0) {
+            _mostCommonValueDeltas[mcv - _mostCommonValues.begin()].fetchAndAdd(delta);
+            continue;
+        }
+
+        if (_buckets.empty()) {
+            continue;
+        }
+        auto bucket = std::lower_bound(_buckets.begin(),
+                                       _buckets.end(),
+                                       value,
+                                       [](const Bucket& bucket, const BSONElement& value) {
+                                           return compareValues(bucket.upperBound.firstElement(),
+                                                                value) < 0;
+                                       });
+        if (bucket == _buckets.end()) {
+            --bucket;
+        }
+        _bucketDeltas[bucket - _buckets.begin()].fetchAndAdd(delta);
+    }
+}
+
+}  // namespace monger
@@ -0,0 +1,187 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "monger/base/status_with.h"
+#include "monger/bson/bsonobj.h"
+#include "monger/platform/atomic_word.h"
+#include "monger/platform/random.h"
+#include "monger/util/time_support.h"
+
+namespace monger {
+
+struct Interval;
+struct OrderedIntervalList;
+
+/**
+ * Summarizes the distribution of the values of an index's leading field, so that the planner can
+ * estimate how many keys an index scan over given bounds will examine without running it.
+ *
+ * The summary consists of the most common values with their key counts, and an equi-depth
+ * histogram over the remaining values in which each bucket records the number of keys and distinct
+ * values at or below its upper bound. Statistics are built by the analyze command, persisted in
+ * the index's catalog entry, and kept approximately fresh as keys are inserted and deleted.
+ *
+ * Values are compared in index key order, so for indexes with a collation the statistics describe
+ * collation keys, which is what index bounds contain as well.
+ */
+class IndexStatistics {
+    IndexStatistics(const IndexStatistics&) = delete;
+    IndexStatistics& operator=(const IndexStatistics&) = delete;
+
+public:
+    static constexpr size_t kDefaultSampleSize = 10000;
+    static constexpr size_t kDefaultNumBuckets = 64;
+    static constexpr size_t kMaxMostCommonValues = 32;
+
+    /**
+     * Accumulates the keys of an index, which must be added in index order, and produces their
+     * statistics. The number of keys and of distinct leading values are exact. The histogram is
+     * built from a uniform sample of at most 'sampleSize' keys.
+     */
+    class Builder {
+    public:
+        Builder(size_t sampleSize, size_t numBuckets, int64_t seed);
+
+        void addKey(const BSONObj& key);
+
+        std::shared_ptr<IndexStatistics> done(Date_t now);
+
+    private:
+        const size_t _sampleSize;
+        const size_t _numBuckets;
+        PseudoRandom _random;
+
+        long long _numKeys = 0;
+        long long _numDistinctValues = 0;
+
+        // The leading value of the last key added, for counting distinct values.
+        BSONObj _lastValue;
+
+        // The leading values of a uniform sample of the keys added so far.
+        std::vector<BSONObj> _sample;
+    };
+
+    /**
+     * Parses statistics serialized by toBSON().
+     */
+    static StatusWith<std::shared_ptr<IndexStatistics>> parse(const BSONObj& obj);
+
+    /**
+     * Serializes the statistics, including the adjustments made for keys inserted and deleted
+     * since they were built.
+     */
+    BSONObj toBSON() const;
+
+    /**
+     * Returns the estimated number of keys in the index.
+     */
+    long long numKeys() const;
+
+    long long numDistinctValues() const {
+        return _numDistinctValues;
+    }
+
+    Date_t analyzedAt() const {
+        return _analyzedAt;
+    }
+
+    /**
+     * Returns the estimated number of keys whose leading value falls in any interval of 'oil',
+     * which must be the bounds on the leading field of the index.
+     */
+    double estimateKeys(const OrderedIntervalList& oil) const;
+
+    /**
+     * Returns the estimated number of keys whose leading value falls in 'interval'. The interval
+     * may be in either direction.
+     */
+    double estimateKeys(const Interval& interval) const;
+
+    /**
+     * Adjust the statistics for keys inserted into and deleted from the index. The adjustment
+     * happens whether or not the surrounding storage transaction commits, which only makes the
+     * statistics approximate.
+     */
+    void recordInsertedKeys(const std::vector<BSONObj>& keys);
+    void recordDeletedKeys(const std::vector<BSONObj>& keys);
+
+private:
+    struct MostCommonValue {
+        // A single element with an empty field name.
+        BSONObj value;
+        long long count;
+    };
+
+    struct Bucket {
+        // A single element with an empty field name. A bucket holds the values greater than the
+        // previous bucket's upper bound, up to and including its own.
+        BSONObj upperBound;
+        long long count;
+        long long numDistinctValues;
+    };
+
+    IndexStatistics(long long numKeys,
+                    long long numDistinctValues,
+                    BSONObj minValue,
+                    std::vector<MostCommonValue> mostCommonValues,
+                    std::vector<Bucket> buckets,
+                    Date_t analyzedAt);
+
+    void recordKeys(const std::vector<BSONObj>& keys, long long delta);
+
+    long long mostCommonValueCount(size_t index) const;
+    long long bucketCount(size_t index) const;
+
+    const long long _numKeys;
+    const long long _numDistinctValues;
+
+    // A single element with an empty field name holding the lowest leading value seen.
+    const BSONObj _minValue;
+
+    // Ordered by value.
+    const std::vector<MostCommonValue> _mostCommonValues;
+
+    // Ordered by upper bound.
+    const std::vector<Bucket> _buckets;
+
+    const Date_t _analyzedAt;
+
+    // Net keys inserted since the statistics were built, in total and by most common value or
+    // bucket. Keys outside the histogram's range are attributed to its first or last bucket.
+    AtomicWord<long long> _numKeysDelta{0};
+    std::vector<AtomicWord<long long>> _mostCommonValueDeltas;
+    std::vector<AtomicWord<long long>> _bucketDeltas;
+};
+
+}  // namespace monger
@@ -0,0 +1,209 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "monger/platform/basic.h"
+
+#include "monger/db/query/index_statistics.h"
+
+#include "monger/db/jsobj.h"
+#include "monger/db/query/index_bounds.h"
+#include "monger/db/query/interval.h"
+#include "monger/unittest/unittest.h"
+
+namespace monger {
+namespace {
+
+Interval makeInterval(BSONObj low, BSONObj high, bool lowInclusive, bool highInclusive) {
+    BSONObjBuilder bob;
+    bob.appendAs(low.firstElement(), "");
+    bob.appendAs(high.firstElement(), "");
+    return Interval(bob.obj(), lowInclusive, highInclusive);
+}
+
+Interval makeRange(int low, int high) {
+    return makeInterval(BSON("" << low), BSON("" << high), true, true);
+}
+
+Interval makePoint(int value) {
+    return makeRange(value, value);
+}
+
+/**
+ * Builds statistics over the given leading values, which must be in ascending order.
+ */
+std::shared_ptr<IndexStatistics> buildStatistics(const std::vector<int>& values,
+                                                 size_t sampleSize = 10000) {
+    IndexStatistics::Builder builder(sampleSize, IndexStatistics::kDefaultNumBuckets, 1);
+    for (auto value : values) {
+        builder.addKey(BSON("" << value << "" << 0));
+    }
+    return builder.done(Date_t::fromMillisSinceEpoch(1000));
+}
+
+std::vector<int> uniformValues(int n) {
+    std::vector<int> values;
+    for (int i = 0; i < n; ++i) {
+        values.push_back(i);
+    }
+    return values;
+}
+
+TEST(IndexStatisticsTest, CountsKeysAndDistinctValuesExactly) {
+    auto stats = buildStatistics({1, 1, 2, 3, 3, 3, 4});
+    ASSERT_EQ(stats->numKeys(), 7);
+    ASSERT_EQ(stats->numDistinctValues(), 4);
+}
+
+TEST(IndexStatisticsTest, CountsDistinctValuesExactlyBeyondSampleSize) {
+    auto stats = buildStatistics(uniformValues(5000), 100);
+    ASSERT_EQ(stats->numKeys(), 5000);
+    ASSERT_EQ(stats->numDistinctValues(), 5000);
+}
+
+TEST(IndexStatisticsTest, EmptyIndexEstimatesNoKeys) {
+    auto stats = buildStatistics({});
+    ASSERT_EQ(stats->numKeys(), 0);
+    ASSERT_EQ(stats->estimateKeys(makeRange(0, 100)), 0.0);
+}
+
+TEST(IndexStatisticsTest, EstimatesRangeOnUniformData) {
+    auto stats = buildStatistics(uniformValues(1000));
+    ASSERT_APPROX_EQUAL(stats->estimateKeys(makeRange(0, 99)), 100.0, 20.0);
+    ASSERT_APPROX_EQUAL(stats->estimateKeys(makeRange(250, 749)), 500.0, 40.0);
+    ASSERT_APPROX_EQUAL(stats->estimateKeys(makeRange(-100, 2000)), 1000.0, 1.0);
+    ASSERT_EQ(stats->estimateKeys(makeRange(5000, 6000)), 0.0);
+}
+
+TEST(IndexStatisticsTest, EstimatesReversedIntervalLikeForwardInterval) {
+    auto stats = buildStatistics(uniformValues(1000));
+    ASSERT_EQ(stats->estimateKeys(makeRange(199, 100)), stats->estimateKeys(makeRange(100, 199)));
+}
+
+TEST(IndexStatisticsTest, EstimatesPointOnUniformData) {
+    auto stats = buildStatistics(uniformValues(1000));
+    ASSERT_APPROX_EQUAL(stats->estimateKeys(makePoint(500)), 1.0, 1.0);
+}
+
+TEST(IndexStatisticsTest, EstimatesMostCommonValueExactly) {
+    std::vector<int> values = uniformValues(500);
+    values.insert(values.begin() + 7, 500, 7);
+    auto stats = buildStatistics(values);
+    ASSERT_EQ(stats->numKeys(), 1000);
+    ASSERT_EQ(stats->numDistinctValues(), 500);
+    ASSERT_APPROX_EQUAL(stats->estimateKeys(makePoint(7)), 501.0, 1.0);
+    ASSERT_APPROX_EQUAL(stats->estimateKeys(makePoint(300)), 1.0, 1.0);
+}
+
+TEST(IndexStatisticsTest, SumsIntervalsOfOrderedIntervalList) {
+    auto stats = buildStatistics(uniformValues(1000));
+    OrderedIntervalList oil("a");
+    oil.intervals.push_back(makePoint(10));
+    oil.intervals.push_back(makePoint(20));
+    oil.intervals.push_back(makeRange(500, 599));
+    ASSERT_APPROX_EQUAL(stats->estimateKeys(oil), 102.0, 20.0);
+}
+
+TEST(IndexStatisticsTest, EstimateOfOrderedIntervalListNeverExceedsNumKeys) {
+    auto stats = buildStatistics(uniformValues(100));
+    OrderedIntervalList oil("a");
+    oil.intervals.push_back(makeRange(0, 99));
+    oil.intervals.push_back(makeRange(0, 99));
+    ASSERT_EQ(stats->estimateKeys(oil), 100.0);
+}
+
+TEST(IndexStatisticsTest, ExcludesMostCommonValueAtExclusiveBound) {
+    std::vector<int> values = uniformValues(500);
+    values.insert(values.begin() + 7, 500, 7);
+    auto stats = buildStatistics(values);
+    ASSERT_GTE(stats->estimateKeys(makeInterval(BSON("" << 7), BSON("" << 8), true, true)), 501.0);
+    ASSERT_LT(stats->estimateKeys(makeInterval(BSON("" << 7), BSON("" << 8), false, true)), 10.0);
+}
+
+TEST(IndexStatisticsTest, RoundTripsThroughBSON) {
+    std::vector<int> values = uniformValues(1000);
+    values.insert(values.begin() + 3, 200, 3);
+    auto stats = buildStatistics(values);
+
+    auto swParsed = IndexStatistics::parse(stats->toBSON());
+    ASSERT_OK(swParsed.getStatus());
+    auto parsed = swParsed.getValue();
+    ASSERT_BSONOBJ_EQ(parsed->toBSON(), stats->toBSON());
+    ASSERT_EQ(parsed->numKeys(), stats->numKeys());
+    ASSERT_EQ(parsed->numDistinctValues(), stats->numDistinctValues());
+    ASSERT_EQ(parsed->analyzedAt(), Date_t::fromMillisSinceEpoch(1000));
+    ASSERT_EQ(parsed->estimateKeys(makePoint(3)), stats->estimateKeys(makePoint(3)));
+    ASSERT_EQ(parsed->estimateKeys(makeRange(100, 400)), stats->estimateKeys(makeRange(100, 400)));
+}
+
+TEST(IndexStatisticsTest, ParseRejectsUnknownVersion) {
+    auto obj = buildStatistics(uniformValues(10))->toBSON();
+    BSONObjBuilder bob;
+    bob.append("version", 2);
+    bob.appendElementsUnique(obj);
+    ASSERT_EQ(IndexStatistics::parse(bob.obj()).getStatus(), ErrorCodes::UnsupportedFormat);
+}
+
+TEST(IndexStatisticsTest, ParseRejectsMalformedBuckets) {
+    auto obj = BSON("version" << 1 << "numKeys" << 10 << "numDistinctValues" << 10 << "analyzedAt"
+                              << Date_t() << "min" << 0 << "mostCommonValues" << BSONArray()
+                              << "buckets" << BSON_ARRAY(BSON("upperBound" << 9)));
+    ASSERT_EQ(IndexStatistics::parse(obj).getStatus(), ErrorCodes::FailedToParse);
+}
+
+TEST(IndexStatisticsTest, TracksInsertedAndDeletedKeys) {
+    std::vector<int> values = uniformValues(500);
+    values.insert(values.begin() + 7, 500, 7);
+    auto stats = buildStatistics(values);
+    const double before = stats->estimateKeys(makePoint(7));
+
+    stats->recordInsertedKeys({BSON("" << 7 << "" << 0), BSON("" << 7 << "" << 1)});
+    ASSERT_EQ(stats->numKeys(), 1002);
+    ASSERT_EQ(stats->estimateKeys(makePoint(7)), before + 2);
+
+    stats->recordDeletedKeys({BSON("" << 7 << "" << 0)});
+    ASSERT_EQ(stats->numKeys(), 1001);
+    ASSERT_EQ(stats->estimateKeys(makePoint(7)), before + 1);
+}
+
+TEST(IndexStatisticsTest, AttributesKeysBeyondHistogramToLastBucket) {
+    auto stats = buildStatistics(uniformValues(1000));
+    const double before = stats->estimateKeys(makeRange(0, 10000));
+
+    std::vector<BSONObj> keys;
+    for (int i = 0; i < 100; ++i) {
+        keys.push_back(BSON("" << 5000 + i));
+    }
+    stats->recordInsertedKeys(keys);
+    ASSERT_EQ(stats->numKeys(), 1100);
+    ASSERT_APPROX_EQUAL(stats->estimateKeys(makeRange(0, 10000)), before + 100, 1.0);
+}
+
+}  // namespace
+}  // namespace monger
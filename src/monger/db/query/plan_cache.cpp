@@ -40,6 +40,7 @@
 #include <memory>
 #include <vector>
 
+#include "monger/base/counter.h"
 #include "monger/base/owned_pointer_vector.h"
 #include "monger/base/string_data_comparator_interface.h"
 #include "monger/db/matcher/expression_array.h"
@@ -346,6 +347,10 @@ std::string SolutionCacheData::toString() const {
                                  << "tree=" << this->tree->toString() << ")";
         case COLLSCAN_SOLN:
             return "(collection scan)";
+        case SKIP_SCAN_SOLN:
+            verify(this->tree.get());
+            return str::stream() << "(skip scan solution: "
+                                 << "tree=" << this->tree->toString() << ")";
         case USE_INDEX_TAGS_SOLN:
             verify(this->tree.get());
             return str::stream() << "(index-tagged expression tree: "
@@ -358,14 +363,107 @@ std::string SolutionCacheData::toString() const {
 // PlanCache
 //
 
+namespace {
+
+struct PartitionMetrics {
+    // Lookups which found an entry, active or not, and lookups which did not.
+    Counter64 hits;
+    Counter64 misses;
+
+    // Acquisitions of the partition mutex, and those which had to wait for another thread.
+    Counter64 lockAcquisitions;
+    Counter64 contendedLockAcquisitions;
+};
+
+// Indexed by partition number. The plan caches of all collections share these counters.
+CacheAligned<PartitionMetrics> partitionMetrics[PlanCache::kMaxPartitions];
+
+}  // namespace
+
+void PlanCache::appendPartitionMetrics(BSONObjBuilder* builder) {
+    long long totalHits = 0;
+    long long totalMisses = 0;
+    long long totalLockAcquisitions = 0;
+    long long totalContendedLockAcquisitions = 0;
+
+    const size_t numPartitions = std::min(
+        kMaxPartitions, static_cast<size_t>(std::max(internalQueryCachePartitions.load(), 1)));
+    BSONArrayBuilder partitionsBuilder(builder->subarrayStart("partitions"));
+    for (size_t i = 0; i < numPartitions; ++i) {
+        const auto& metrics = partitionMetrics[i];
+        const long long hits = metrics.hits.get();
+        const long long misses = metrics.misses.get();
+        const long long lockAcquisitions = metrics.lockAcquisitions.get();
+        const long long contendedLockAcquisitions = metrics.contendedLockAcquisitions.get();
+
+        BSONObjBuilder partitionBuilder(partitionsBuilder.subobjStart());
+        partitionBuilder.append("hits", hits);
+        partitionBuilder.append("misses", misses);
+        partitionBuilder.append("lockAcquisitions", lockAcquisitions);
+        partitionBuilder.append("contendedLockAcquisitions", contendedLockAcquisitions);
+        partitionBuilder.doneFast();
+
+        totalHits += hits;
+        totalMisses += misses;
+        totalLockAcquisitions += lockAcquisitions;
+        totalContendedLockAcquisitions += contendedLockAcquisitions;
+    }
+    partitionsBuilder.doneFast();
+
+    builder->append("hits", totalHits);
+    builder->append("misses", totalMisses);
+    builder->append("lockAcquisitions", totalLockAcquisitions);
+    builder->append("contendedLockAcquisitions", totalContendedLockAcquisitions);
+}
+
+std::vector<PlanCache::PartitionPtr> PlanCache::makePartitions(size_t size) {
+    const size_t maxPartitions = std::min(
+        kMaxPartitions, static_cast<size_t>(std::max(internalQueryCachePartitions.load(), 1)));
+    const size_t numPartitions =
+        std::max(size_t{1}, std::min(maxPartitions, size / kMinEntriesPerPartition));
+
+    // Spread 'size' over the partitions so that their capacities sum to exactly 'size'.
+    std::vector<PartitionPtr> partitions;
+    partitions.reserve(numPartitions);
+    for (size_t i = 0; i < numPartitions; ++i) {
+        const size_t partitionSize = size / numPartitions + (i < size % numPartitions ? 1 : 0);
+        partitions.push_back(std::make_unique<CacheAligned<Partition>>(partitionSize));
+    }
+    return partitions;
+}
+
 PlanCache::PlanCache() : PlanCache(internalQueryCacheSize.load()) {}
 
-PlanCache::PlanCache(size_t size) : _cache(size) {}
+PlanCache::PlanCache(size_t size) : _partitions(makePartitions(size)) {}
 
-PlanCache::PlanCache(const std::string& ns) : _cache(internalQueryCacheSize.load()), _ns(ns) {}
+PlanCache::PlanCache(const std::string& ns)
+    : _partitions(makePartitions(internalQueryCacheSize.load())), _ns(ns) {}
 
 PlanCache::~PlanCache() {}
 
+size_t PlanCache::partitionOf(const PlanCacheKey& key) const {
+    if (_partitions.size() == 1) {
+        return 0;
+    }
+
+    // Each partition's LRUKeyValue buckets its entries by the low bits of the same hash, so mix
+    // the high bits in to avoid every key of a partition landing in a fraction of its buckets.
+    const uint64_t hash = PlanCacheKeyHasher{}(key);
+    return ((hash * 0x9E3779B97F4A7C15ULL) >> 32) % _partitions.size();
+}
+
+stdx::unique_lock<stdx::mutex> PlanCache::lockPartition(size_t partition) const {
+    auto& metrics = partitionMetrics[partition];
+    metrics.lockAcquisitions.increment();
+
+    stdx::unique_lock<stdx::mutex> lk(_partitions[partition]->mutex, stdx::try_to_lock);
+    if (!lk.owns_lock()) {
+        metrics.contendedLockAcquisitions.increment();
+        lk.lock();
+    }
+    return lk;
+}
+
 std::unique_ptr<CachedSolution> PlanCache::getCacheEntryIfActive(const PlanCacheKey& key) const {
 
     PlanCache::GetResult res = get(key);
@@ -483,7 +581,9 @@ Status PlanCache::set(const CanonicalQuery& query,
 
     const auto key = computeKey(query);
     const size_t newWorks = why->stats[0]->common.works;
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    const size_t partitionIndex = partitionOf(key);
+    auto& partition = *_partitions[partitionIndex];
+    auto cacheLock = lockPartition(partitionIndex);
     bool isNewEntryActive = false;
     uint32_t queryHash;
     uint32_t planCacheKey;
@@ -494,7 +594,7 @@ Status PlanCache::set(const CanonicalQuery& query,
         queryHash = canonical_query_encoder::computeHash(key.getStableKeyStringData());
     } else {
         PlanCacheEntry* oldEntry = nullptr;
-        Status cacheStatus = _cache.get(key, &oldEntry);
+        Status cacheStatus = partition.cache.get(key, &oldEntry);
         invariant(cacheStatus.isOK() || cacheStatus == ErrorCodes::NoSuchKey);
         if (oldEntry) {
             queryHash = oldEntry->queryHash;
@@ -540,7 +640,7 @@ Status PlanCache::set(const CanonicalQuery& query,
     }
     newEntry->projection = projBuilder.obj();
 
-    std::unique_ptr<PlanCacheEntry> evictedEntry = _cache.add(key, newEntry.release());
+    std::unique_ptr<PlanCacheEntry> evictedEntry = partition.cache.add(key, newEntry.release());
 
     if (nullptr != evictedEntry.get()) {
         LOG(1) << _ns << ": plan cache maximum size exceeded - "
@@ -557,9 +657,10 @@ void PlanCache::deactivate(const CanonicalQuery& query) {
     }
 
     PlanCacheKey key = computeKey(query);
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    const size_t partition = partitionOf(key);
+    auto cacheLock = lockPartition(partition);
     PlanCacheEntry* entry = nullptr;
-    Status cacheStatus = _cache.get(key, &entry);
+    Status cacheStatus = _partitions[partition]->cache.get(key, &entry);
     if (!cacheStatus.isOK()) {
         invariant(cacheStatus == ErrorCodes::NoSuchKey);
         return;
@@ -574,14 +675,17 @@ PlanCache::GetResult PlanCache::get(const CanonicalQuery& query) const {
 }
 
 PlanCache::GetResult PlanCache::get(const PlanCacheKey& key) const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    const size_t partition = partitionOf(key);
+    auto cacheLock = lockPartition(partition);
     PlanCacheEntry* entry = nullptr;
-    Status cacheStatus = _cache.get(key, &entry);
+    Status cacheStatus = _partitions[partition]->cache.get(key, &entry);
     if (!cacheStatus.isOK()) {
         invariant(cacheStatus == ErrorCodes::NoSuchKey);
+        partitionMetrics[partition].misses.increment();
         return {CacheEntryState::kNotPresent, nullptr};
     }
     invariant(entry);
+    partitionMetrics[partition].hits.increment();
 
     auto state =
         entry->isActive ? CacheEntryState::kPresentActive : CacheEntryState::kPresentInactive;
@@ -591,9 +695,10 @@ PlanCache::GetResult PlanCache::get(const PlanCacheKey& key) const {
 Status PlanCache::feedback(const CanonicalQuery& cq, double score) {
     PlanCacheKey ck = computeKey(cq);
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    const size_t partition = partitionOf(ck);
+    auto cacheLock = lockPartition(partition);
     PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(ck, &entry);
+    Status cacheStatus = _partitions[partition]->cache.get(ck, &entry);
     if (!cacheStatus.isOK()) {
         return cacheStatus;
     }
@@ -608,13 +713,17 @@ Status PlanCache::feedback(const CanonicalQuery& cq, double score) {
 }
 
 Status PlanCache::remove(const CanonicalQuery& canonicalQuery) {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    return _cache.remove(computeKey(canonicalQuery));
+    PlanCacheKey key = computeKey(canonicalQuery);
+    const size_t partition = partitionOf(key);
+    auto cacheLock = lockPartition(partition);
+    return _partitions[partition]->cache.remove(key);
 }
 
 void PlanCache::clear() {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    _cache.clear();
+    for (size_t partition = 0; partition < _partitions.size(); ++partition) {
+        auto cacheLock = lockPartition(partition);
+        _partitions[partition]->cache.clear();
+    }
 }
 
 PlanCacheKey PlanCache::computeKey(const CanonicalQuery& cq) const {
@@ -628,9 +737,10 @@ PlanCacheKey PlanCache::computeKey(const CanonicalQuery& cq) const {
 StatusWith<std::unique_ptr<PlanCacheEntry>> PlanCache::getEntry(const CanonicalQuery& query) const {
     PlanCacheKey key = computeKey(query);
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    const size_t partition = partitionOf(key);
+    auto cacheLock = lockPartition(partition);
     PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(key, &entry);
+    Status cacheStatus = _partitions[partition]->cache.get(key, &entry);
     if (!cacheStatus.isOK()) {
         return cacheStatus;
     }
@@ -640,20 +750,26 @@ StatusWith<std::unique_ptr<PlanCacheEntry>> PlanCache::getEntry(const CanonicalQ
 }
 
 std::vector<std::unique_ptr<PlanCacheEntry>> PlanCache::getAllEntries() const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
     std::vector<std::unique_ptr<PlanCacheEntry>> entries;
 
-    for (auto&& cacheEntry : _cache) {
-        auto entry = cacheEntry.second;
-        entries.push_back(std::unique_ptr<PlanCacheEntry>(entry->clone()));
+    for (size_t partition = 0; partition < _partitions.size(); ++partition) {
+        auto cacheLock = lockPartition(partition);
+        for (auto&& cacheEntry : _partitions[partition]->cache) {
+            auto entry = cacheEntry.second;
+            entries.push_back(std::unique_ptr<PlanCacheEntry>(entry->clone()));
+        }
     }
 
     return entries;
 }
 
 size_t PlanCache::size() const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    return _cache.size();
+    size_t total = 0;
+    for (size_t partition = 0; partition < _partitions.size(); ++partition) {
+        auto cacheLock = lockPartition(partition);
+        total += _partitions[partition]->cache.size();
+    }
+    return total;
 }
 
 void PlanCache::notifyOfIndexUpdates(const std::vector<CoreIndexInfo>& indexCores) {
@@ -664,13 +780,15 @@ std::vector<BSONObj> PlanCache::getMatchingStats(
     const std::function<BSONObj(const PlanCacheEntry&)>& serializationFunc,
     const std::function<bool(const BSONObj&)>& filterFunc) const {
     std::vector<BSONObj> results;
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
 
-    for (auto&& cacheEntry : _cache) {
-        const auto entry = cacheEntry.second;
-        auto serializedEntry = serializationFunc(*entry);
-        if (filterFunc(serializedEntry)) {
-            results.push_back(serializedEntry);
+    for (size_t partition = 0; partition < _partitions.size(); ++partition) {
+        auto cacheLock = lockPartition(partition);
+        for (auto&& cacheEntry : _partitions[partition]->cache) {
+            const auto entry = cacheEntry.second;
+            auto serializedEntry = serializationFunc(*entry);
+            if (filterFunc(serializedEntry)) {
+                results.push_back(serializedEntry);
+            }
         }
     }
 
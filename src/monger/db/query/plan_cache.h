@@ -40,6 +40,7 @@
 #include "monger/db/query/query_planner_params.h"
 #include "monger/platform/atomic_word.h"
 #include "monger/stdx/mutex.h"
+#include "monger/util/with_alignment.h"
 
 namespace monger {
 
@@ -207,7 +208,7 @@ struct SolutionCacheData {
 
     // Owned here. If 'wholeIXSoln' is false, then 'tree'
     // can be used to tag an isomorphic match expression. If 'wholeIXSoln'
-    // is true, then 'tree' is used to store the relevant IndexEntry.
+    // or 'skipScanSoln' is true, then 'tree' is used to store the relevant IndexEntry.
     // If 'collscanSoln' is true, then 'tree' should be NULL.
     std::unique_ptr<PlanCacheIndexTree> tree;
 
@@ -220,6 +221,10 @@ struct SolutionCacheData {
         // The cached plan is a collection scan.
         COLLSCAN_SOLN,
 
+        // The cached plan is a skip scan over the index
+        // stored in 'tree'.
+        SKIP_SCAN_SOLN,
+
         // Build the solution by using 'tree'
         // to tag the match expression.
         USE_INDEX_TAGS_SOLN
@@ -387,6 +392,24 @@ public:
         std::unique_ptr<CachedSolution> cachedSolution;
     };
 
+    /**
+     * The largest permitted value of 'internalQueryCachePartitions'.
+     */
+    static constexpr size_t kMaxPartitions = 64;
+
+    /**
+     * A cache is split into fewer partitions than 'internalQueryCachePartitions' if each partition
+     * would otherwise hold fewer than this many entries, so that small caches keep an LRU policy
+     * that is close to global.
+     */
+    static constexpr size_t kMinEntriesPerPartition = 64;
+
+    /**
+     * Appends the hit, miss and lock contention counters of each partition number, summed over
+     * the plan caches of all collections, to 'builder'.
+     */
+    static void appendPartitionMetrics(BSONObjBuilder* builder);
+
     /**
      * We don't want to cache every possible query. This function
      * encapsulates the criteria for what makes a canonical query
@@ -513,6 +536,13 @@ public:
      */
     size_t size() const;
 
+    /**
+     * Returns the number of partitions the cache is split into.
+     */
+    size_t numPartitions() const {
+        return _partitions.size();
+    }
+
     /**
      * Updates internal state kept about the collection's indexes.  Must be called when the set
      * of indexes on the associated collection have changed.
@@ -546,10 +576,36 @@ private:
                                    size_t newWorks,
                                    double growthCoefficient);
 
-    LRUKeyValue<PlanCacheKey, PlanCacheEntry, PlanCacheKeyHasher> _cache;
+    struct Partition {
+        explicit Partition(size_t size) : cache(size) {}
+
+        LRUKeyValue<PlanCacheKey, PlanCacheEntry, PlanCacheKeyHasher> cache;
+
+        // Protects 'cache'.
+        mutable stdx::mutex mutex;
+    };
+
+    using PartitionPtr = std::unique_ptr<CacheAligned<Partition>>;
+
+    /**
+     * Splits a cache of at most 'size' entries into partitions.
+     */
+    static std::vector<PartitionPtr> makePartitions(size_t size);
+
+    /**
+     * Returns the index of the partition holding the entry for 'key'.
+     */
+    size_t partitionOf(const PlanCacheKey& key) const;
+
+    /**
+     * Locks the partition at index 'partition', recording whether the lock was contended.
+     */
+    stdx::unique_lock<stdx::mutex> lockPartition(size_t partition) const;
 
-    // Protects _cache.
-    mutable stdx::mutex _cacheMutex;
+    // Entries are distributed over the partitions by the hash of their PlanCacheKey. Each
+    // partition has its own mutex and LRU policy, so that operations on different query shapes
+    // of the same collection do not serialize on a single mutex.
+    std::vector<PartitionPtr> _partitions;
 
     // Full namespace of collection.
     std::string _ns;
@@ -53,6 +53,7 @@
 #include "monger/unittest/unittest.h"
 #include "monger/util/assert_util.h"
 #include "monger/util/scopeguard.h"
+#include "monger/util/str.h"
 #include "monger/util/transitional_tools_do_not_use/vector_spooling.h"
 
 using namespace monger;
@@ -567,6 +568,83 @@ TEST(PlanCacheTest, PlanCacheLRUPolicyRemovesInactiveEntries) {
     ASSERT_EQ(planCache.get(*cqC).state, PlanCache::CacheEntryState::kPresentInactive);
 }
 
+TEST(PlanCacheTest, SmallCachesAreNotPartitioned) {
+    PlanCache planCache(PlanCache::kMinEntriesPerPartition * 2 - 1);
+    ASSERT_EQ(planCache.numPartitions(), 1U);
+}
+
+TEST(PlanCacheTest, PartitionCountIsBoundedByKnob) {
+    const auto oldPartitions = internalQueryCachePartitions.load();
+    ON_BLOCK_EXIT([&] { internalQueryCachePartitions.store(oldPartitions); });
+
+    internalQueryCachePartitions.store(4);
+    PlanCache fourPartitions(PlanCache::kMinEntriesPerPartition * 100);
+    ASSERT_EQ(fourPartitions.numPartitions(), 4U);
+
+    internalQueryCachePartitions.store(8);
+    PlanCache threePartitions(PlanCache::kMinEntriesPerPartition * 3);
+    ASSERT_EQ(threePartitions.numPartitions(), 3U);
+}
+
+TEST(PlanCacheTest, PartitionedCacheHoldsEntriesForManyShapes) {
+    const auto oldPartitions = internalQueryCachePartitions.load();
+    ON_BLOCK_EXIT([&] { internalQueryCachePartitions.store(oldPartitions); });
+    internalQueryCachePartitions.store(8);
+
+    PlanCache planCache(PlanCache::kMinEntriesPerPartition * 8);
+    ASSERT_EQ(planCache.numPartitions(), 8U);
+    QueryTestServiceContext serviceContext;
+
+    const int kNumShapes = 50;
+    std::vector<unique_ptr<CanonicalQuery>> queries;
+    for (int i = 0; i < kNumShapes; ++i) {
+        const std::string fieldName = str::stream() << "f" << i;
+        queries.push_back(canonicalize(BSON("a" << 1 << fieldName << 1)));
+        addCacheEntryForShape(*queries.back(), &planCache);
+    }
+    ASSERT_EQ(planCache.size(), static_cast<size_t>(kNumShapes));
+    ASSERT_EQ(planCache.getAllEntries().size(), static_cast<size_t>(kNumShapes));
+
+    for (auto&& cq : queries) {
+        ASSERT_EQ(planCache.get(*cq).state, PlanCache::CacheEntryState::kPresentInactive);
+    }
+
+    ASSERT_OK(planCache.remove(*queries.front()));
+    ASSERT_EQ(planCache.get(*queries.front()).state, PlanCache::CacheEntryState::kNotPresent);
+    ASSERT_EQ(planCache.size(), static_cast<size_t>(kNumShapes - 1));
+
+    planCache.clear();
+    ASSERT_EQ(planCache.size(), 0U);
+    for (auto&& cq : queries) {
+        ASSERT_EQ(planCache.get(*cq).state, PlanCache::CacheEntryState::kNotPresent);
+    }
+}
+
+TEST(PlanCacheTest, PartitionMetricsCountHitsAndMisses) {
+    auto totalsOf = [] {
+        BSONObjBuilder bob;
+        PlanCache::appendPartitionMetrics(&bob);
+        return bob.obj();
+    };
+
+    PlanCache planCache;
+    QueryTestServiceContext serviceContext;
+    unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+
+    const BSONObj before = totalsOf();
+    ASSERT_EQ(planCache.get(*cq).state, PlanCache::CacheEntryState::kNotPresent);
+    addCacheEntryForShape(*cq, &planCache);
+    ASSERT_EQ(planCache.get(*cq).state, PlanCache::CacheEntryState::kPresentInactive);
+    const BSONObj after = totalsOf();
+
+    ASSERT_EQ(after["hits"].numberLong() - before["hits"].numberLong(), 1);
+    ASSERT_EQ(after["misses"].numberLong() - before["misses"].numberLong(), 1);
+    ASSERT_GTE(after["lockAcquisitions"].numberLong() - before["lockAcquisitions"].numberLong(),
+               3);
+    ASSERT_EQ(after["partitions"].Array().size(),
+              static_cast<size_t>(internalQueryCachePartitions.load()));
+}
+
 TEST(PlanCacheTest, PlanCacheRemoveDeletesInactiveEntries) {
     PlanCache planCache;
     unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
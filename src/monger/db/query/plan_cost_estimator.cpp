@@ -0,0 +1,247 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::monger::logger::LogComponent::kQuery
+
+#include "monger/platform/basic.h"
+
+#include "monger/db/query/plan_cost_estimator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "monger/db/query/index_statistics.h"
+#include "monger/db/query/query_solution.h"
+#include "monger/util/log.h"
+
+namespace monger {
+namespace plan_cost_estimator {
+
+namespace {
+
+// Relative costs of the units of work a plan does. Fetching a document means a random read of the
+// record store, which is an order of magnitude more expensive than stepping an index cursor.
+constexpr double kKeyExaminedCost = 1.0;
+constexpr double kDocExaminedCost = 10.0;
+constexpr double kSortCostPerComparison = 0.5;
+
+// A seek descends the index from its root rather than stepping to the adjacent key, and a
+// collection scan reads each record sequentially, which is far cheaper than a random fetch.
+constexpr double kSeekCost = 4.0;
+constexpr double kCollscanDocCost = 1.0;
+
+/**
+ * Returns true if 'node' or a node below it must consume all of its input before producing
+ * results, so that a limit above it does not reduce the work it does.
+ */
+bool hasBlockingStage(const QuerySolutionNode* node) {
+    if (node->getType() == STAGE_SORT || node->getType() == STAGE_AND_HASH) {
+        return true;
+    }
+    return std::any_of(node->children.begin(), node->children.end(), hasBlockingStage);
+}
+
+/**
+ * Returns the number of results skipped by the $skip, if any, among the stages between a limit
+ * and the first stage below it which has more than one child.
+ */
+double numSkippedBelow(const QuerySolutionNode* node) {
+    double skipped = 0;
+    while (node->children.size() == 1) {
+        if (node->getType() == STAGE_SKIP) {
+            skipped += static_cast<const SkipNode*>(node)->skip;
+        }
+        node = node->children[0];
+    }
+    return skipped;
+}
+
+boost::optional<CostEstimate> estimateNode(QuerySolutionNode* node) {
+    switch (node->getType()) {
+        case STAGE_IXSCAN: {
+            auto ixscan = static_cast<IndexScanNode*>(node);
+            const auto& stats = ixscan->index.statistics;
+            // The statistics only describe the leading field, which a skip scan does not
+            // constrain, so they cannot tell how many keys it will examine.
+            if (!stats || ixscan->isSkipScan || ixscan->bounds.isSimpleRange ||
+                ixscan->bounds.fields.empty()) {
+                return boost::none;
+            }
+
+            CostEstimate estimate;
+            estimate.keysExamined = stats->estimateKeys(ixscan->bounds.fields[0]);
+            estimate.cost = estimate.keysExamined * kKeyExaminedCost;
+            estimate.worstCaseCost = estimate.cost;
+            estimate.nReturned = estimate.keysExamined;
+            ixscan->estimatedKeysExamined = std::llround(estimate.keysExamined);
+            return estimate;
+        }
+        case STAGE_FETCH: {
+            auto estimate = estimateNode(node->children[0]);
+            if (!estimate) {
+                return boost::none;
+            }
+            estimate->docsExamined += estimate->nReturned;
+            estimate->cost += estimate->nReturned * kDocExaminedCost;
+            estimate->worstCaseCost += estimate->nReturned * kDocExaminedCost;
+            static_cast<FetchNode*>(node)->estimatedDocsExamined =
+                std::llround(estimate->nReturned);
+            return estimate;
+        }
+        case STAGE_OR:
+        case STAGE_SORT_MERGE:
+        case STAGE_AND_HASH:
+        case STAGE_AND_SORTED: {
+            const bool isIntersection =
+                node->getType() == STAGE_AND_HASH || node->getType() == STAGE_AND_SORTED;
+            CostEstimate total;
+            total.nReturned = isIntersection ? std::numeric_limits<double>::max() : 0;
+            for (auto child : node->children) {
+                auto estimate = estimateNode(child);
+                if (!estimate) {
+                    return boost::none;
+                }
+                total.cost += estimate->cost;
+                total.worstCaseCost += estimate->worstCaseCost;
+                total.keysExamined += estimate->keysExamined;
+                total.docsExamined += estimate->docsExamined;
+                total.nReturned = isIntersection ? std::min(total.nReturned, estimate->nReturned)
+                                                 : total.nReturned + estimate->nReturned;
+            }
+            return total;
+        }
+        case STAGE_SORT: {
+            auto estimate = estimateNode(node->children[0]);
+            if (!estimate) {
+                return boost::none;
+            }
+            const double n = estimate->nReturned;
+            const double sortCost = n * std::log2(n + 1) * kSortCostPerComparison;
+            estimate->cost += sortCost;
+            estimate->worstCaseCost += sortCost;
+            const auto limit = static_cast<SortNode*>(node)->limit;
+            if (limit > 0) {
+                estimate->nReturned = std::min(n, static_cast<double>(limit));
+            }
+            return estimate;
+        }
+        case STAGE_LIMIT: {
+            auto child = node->children[0];
+            auto estimate = estimateNode(child);
+            if (!estimate) {
+                return boost::none;
+            }
+            const double limit = static_cast<LimitNode*>(node)->limit;
+            // Without a blocking stage below it, the plan stops once the limit is reached, and so
+            // only does the share of its work needed to produce the skipped and limited results.
+            if (!hasBlockingStage(child) && estimate->nReturned > 0) {
+                const double fraction =
+                    std::min(1.0, (limit + numSkippedBelow(child)) / estimate->nReturned);
+                estimate->cost *= fraction;
+                estimate->keysExamined *= fraction;
+                estimate->docsExamined *= fraction;
+            }
+            estimate->nReturned = std::min(estimate->nReturned, limit);
+            return estimate;
+        }
+        case STAGE_SKIP:
+        case STAGE_ENSURE_SORTED:
+        case STAGE_PROJECTION_DEFAULT:
+        case STAGE_PROJECTION_COVERED:
+        case STAGE_PROJECTION_SIMPLE:
+        case STAGE_SHARDING_FILTER:
+        case STAGE_SORT_KEY_GENERATOR:
+            return estimateNode(node->children[0]);
+        default:
+            return boost::none;
+    }
+}
+
+}  // namespace
+
+boost::optional<CostEstimate> estimate(QuerySolution* solution) {
+    invariant(solution->root);
+    return estimateNode(solution->root.get());
+}
+
+size_t pruneByEstimatedCost(std::vector<std::unique_ptr<QuerySolution>>* solutions,
+                            double maxRatio) {
+    std::vector<boost::optional<CostEstimate>> estimates;
+    estimates.reserve(solutions->size());
+    for (auto&& solution : *solutions) {
+        estimates.push_back(estimate(solution.get()));
+    }
+
+    if (maxRatio <= 0 || solutions->size() < 2 ||
+        std::any_of(estimates.begin(), estimates.end(), [](const auto& e) { return !e; })) {
+        return 0;
+    }
+
+    // Compare against the worst case of the cheapest plan, so that a plan which a limit is
+    // expected to stop early, but whose results may be rejected by residual filters, does not
+    // cause others to be pruned.
+    const auto cheapest = std::min_element(
+        estimates.begin(), estimates.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs->worstCaseCost < rhs->worstCaseCost;
+        });
+    // Never prune against a plan the model thinks is free; the estimate then says nothing about
+    // how much worse the alternatives are.
+    const double maxCost = std::max((*cheapest)->worstCaseCost, 1.0) * maxRatio;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < solutions->size(); ++i) {
+        if (estimates[i]->cost <= maxCost) {
+            if (kept != i) {
+                (*solutions)[kept] = std::move((*solutions)[i]);
+            }
+            ++kept;
+        } else {
+            LOG(2) << "Pruning candidate plan with estimated cost " << estimates[i]->cost
+                   << ", more than " << maxRatio << " times the cheapest worst-case estimate of "
+                   << (*cheapest)->worstCaseCost << ": " << redact((*solutions)[i]->toString());
+        }
+    }
+
+    const size_t pruned = solutions->size() - kept;
+    solutions->resize(kept);
+    return pruned;
+}
+
+bool skipScanCheaperThanCollscan(const IndexStatistics& stats) {
+    // For each distinct leading value the scan seeks to the start of the bounds on the later
+    // fields, and examines the first key past their end before seeking to the next value.
+    const double skipScanCost =
+        static_cast<double>(stats.numDistinctValues()) * (kSeekCost + kKeyExaminedCost);
+    const double collscanCost = static_cast<double>(stats.numKeys()) * kCollscanDocCost;
+    return skipScanCost < collscanCost;
+}
+
+}  // namespace plan_cost_estimator
+}  // namespace monger
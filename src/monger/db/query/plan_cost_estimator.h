@@ -0,0 +1,90 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <memory>
+#include <vector>
+
+namespace monger {
+
+class IndexStatistics;
+struct QuerySolution;
+
+/**
+ * A cost model over query solutions, driven by the statistics of the indexes they scan. It lets
+ * the planner discard candidate plans that are clearly worse than another before racing the rest
+ * in a MultiPlanStage trial period.
+ */
+namespace plan_cost_estimator {
+
+struct CostEstimate {
+    // An abstract cost, in units of index keys examined.
+    double cost = 0;
+
+    // The cost if no limit stops the plan early. A limit over a plan without blocking stages
+    // scales 'cost' down by the share of results it needs, which assumes that every result the
+    // plan produces passes the residual filters; this is the bound without that assumption.
+    double worstCaseCost = 0;
+
+    double keysExamined = 0;
+    double docsExamined = 0;
+
+    // The number of results the plan is expected to produce. This is an upper bound, since the
+    // model does not know the selectivity of residual filters.
+    double nReturned = 0;
+};
+
+/**
+ * Estimates the cost of 'solution', recording the estimated keys and documents examined on its
+ * index scan and fetch nodes for explain. Returns boost::none if the solution has a stage the
+ * model cannot cost or scans an index without statistics.
+ */
+boost::optional<CostEstimate> estimate(QuerySolution* solution);
+
+/**
+ * Estimates every solution in 'solutions', and if all of them could be estimated, removes those
+ * whose cost exceeds 'maxRatio' times the lowest worst-case cost. Does nothing if 'maxRatio' is not
+ * positive. Returns the number of solutions removed.
+ */
+size_t pruneByEstimatedCost(std::vector<std::unique_ptr<QuerySolution>>* solutions,
+                            double maxRatio);
+
+/**
+ * Returns true if a skip scan over an index with statistics 'stats', which seeks once for each
+ * distinct value of the index's leading field, is expected to cost less than a collection scan.
+ * The index must have one key per document, that is, it must be neither multikey, sparse nor
+ * partial. The cost of fetching the documents the skip scan matches is left out, since the model
+ * knows nothing about the selectivity of the later fields.
+ */
+bool skipScanCheaperThanCollscan(const IndexStatistics& stats);
+
+}  // namespace plan_cost_estimator
+}  // namespace monger
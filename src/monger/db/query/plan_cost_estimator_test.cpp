@@ -0,0 +1,241 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "monger/platform/basic.h"
+
+#include "monger/db/query/plan_cost_estimator.h"
+
+#include "monger/db/jsobj.h"
+#include "monger/db/query/index_statistics.h"
+#include "monger/db/query/query_solution.h"
+#include "monger/unittest/unittest.h"
+
+namespace monger {
+namespace {
+
+/**
+ * Returns statistics for an index with 1000 keys, 500 of which have the leading value 7 and the
+ * rest distinct values between 0 and 499.
+ */
+std::shared_ptr<const IndexStatistics> makeSkewedStatistics() {
+    IndexStatistics::Builder builder(
+        IndexStatistics::kDefaultSampleSize, IndexStatistics::kDefaultNumBuckets, 1);
+    for (int i = 0; i < 500; ++i) {
+        builder.addKey(BSON("" << i));
+        if (i == 7) {
+            for (int j = 0; j < 500; ++j) {
+                builder.addKey(BSON("" << i));
+            }
+        }
+    }
+    return builder.done(Date_t::now());
+}
+
+IndexEntry makeIndexEntry(const std::string& field,
+                          std::shared_ptr<const IndexStatistics> statistics) {
+    IndexEntry entry(BSON(field << 1),
+                     INDEX_BTREE,
+                     false,
+                     {},
+                     {},
+                     false,
+                     false,
+                     CoreIndexInfo::Identifier(field + "_1"),
+                     nullptr,
+                     {},
+                     nullptr,
+                     nullptr);
+    entry.statistics = std::move(statistics);
+    return entry;
+}
+
+/**
+ * Returns a FETCH => IXSCAN solution over the index on 'field' with the point bounds 'value'.
+ */
+std::unique_ptr<QuerySolution> makePointScan(const std::string& field,
+                                             int value,
+                                             std::shared_ptr<const IndexStatistics> statistics) {
+    auto ixscan = std::make_unique<IndexScanNode>(makeIndexEntry(field, std::move(statistics)));
+    OrderedIntervalList oil(field);
+    oil.intervals.push_back(Interval(BSON("" << value << "" << value), true, true));
+    ixscan->bounds.fields.push_back(oil);
+
+    auto fetch = std::make_unique<FetchNode>();
+    fetch->children.push_back(ixscan.release());
+
+    auto solution = std::make_unique<QuerySolution>();
+    solution->root = std::move(fetch);
+    return solution;
+}
+
+/**
+ * Returns a LIMIT => FETCH => IXSCAN solution over all of the index on 'field'.
+ */
+std::unique_ptr<QuerySolution> makeLimitedFullScan(
+    const std::string& field, long long limit, std::shared_ptr<const IndexStatistics> statistics) {
+    auto ixscan = std::make_unique<IndexScanNode>(makeIndexEntry(field, std::move(statistics)));
+    OrderedIntervalList oil(field);
+    oil.intervals.push_back(Interval(BSON("" << MINKEY << "" << MAXKEY), true, true));
+    ixscan->bounds.fields.push_back(oil);
+
+    auto fetch = std::make_unique<FetchNode>();
+    fetch->children.push_back(ixscan.release());
+
+    auto limitNode = std::make_unique<LimitNode>();
+    limitNode->limit = limit;
+    limitNode->children.push_back(fetch.release());
+
+    auto solution = std::make_unique<QuerySolution>();
+    solution->root = std::move(limitNode);
+    return solution;
+}
+
+TEST(PlanCostEstimatorTest, EstimatesFetchOverIndexScan) {
+    auto solution = makePointScan("a", 7, makeSkewedStatistics());
+    auto estimate = plan_cost_estimator::estimate(solution.get());
+    ASSERT(estimate);
+    ASSERT_APPROX_EQUAL(estimate->keysExamined, 501.0, 1.0);
+    ASSERT_APPROX_EQUAL(estimate->docsExamined, 501.0, 1.0);
+    ASSERT_GT(estimate->cost, estimate->keysExamined);
+
+    auto fetch = static_cast<FetchNode*>(solution->root.get());
+    auto ixscan = static_cast<IndexScanNode*>(fetch->children[0]);
+    ASSERT(fetch->estimatedDocsExamined);
+    ASSERT(ixscan->estimatedKeysExamined);
+    ASSERT_EQ(*ixscan->estimatedKeysExamined, 501);
+}
+
+TEST(PlanCostEstimatorTest, CannotEstimateIndexWithoutStatistics) {
+    auto solution = makePointScan("a", 7, nullptr);
+    ASSERT_FALSE(plan_cost_estimator::estimate(solution.get()));
+}
+
+TEST(PlanCostEstimatorTest, LimitScalesWorkOfPlanWithoutBlockingStages) {
+    auto solution = makePointScan("a", 7, makeSkewedStatistics());
+    auto limit = std::make_unique<LimitNode>();
+    limit->limit = 5;
+    limit->children.push_back(solution->root.release());
+    solution->root = std::move(limit);
+
+    auto estimate = plan_cost_estimator::estimate(solution.get());
+    ASSERT(estimate);
+    ASSERT_EQ(estimate->nReturned, 5.0);
+    ASSERT_APPROX_EQUAL(estimate->keysExamined, 5.0, 0.1);
+    ASSERT_APPROX_EQUAL(estimate->docsExamined, 5.0, 0.1);
+    ASSERT_LT(estimate->cost, estimate->worstCaseCost / 50);
+}
+
+TEST(PlanCostEstimatorTest, LimitedSortChargesTheWholeInput) {
+    auto solution = makePointScan("a", 7, makeSkewedStatistics());
+    auto sort = std::make_unique<SortNode>();
+    sort->pattern = BSON("b" << 1);
+    sort->limit = 5;
+    sort->children.push_back(solution->root.release());
+    solution->root = std::move(sort);
+
+    auto estimate = plan_cost_estimator::estimate(solution.get());
+    ASSERT(estimate);
+    ASSERT_EQ(estimate->nReturned, 5.0);
+    ASSERT_APPROX_EQUAL(estimate->keysExamined, 501.0, 1.0);
+    ASSERT_EQ(estimate->cost, estimate->worstCaseCost);
+}
+
+TEST(PlanCostEstimatorTest, DoesNotPruneIndexProvidedSortUnderLimitInFavourOfBlockingSort) {
+    // find({a: 300}).sort({b: 1}).limit(5), where {a: 1} matches one document and {b: 1} provides
+    // the sort but examines every key if it runs to completion.
+    std::vector<std::unique_ptr<QuerySolution>> solutions;
+
+    auto blockingSort = makePointScan("a", 300, makeSkewedStatistics());
+    auto sort = std::make_unique<SortNode>();
+    sort->pattern = BSON("b" << 1);
+    sort->limit = 5;
+    sort->children.push_back(blockingSort->root.release());
+    blockingSort->root = std::move(sort);
+    solutions.push_back(std::move(blockingSort));
+
+    solutions.push_back(makeLimitedFullScan("b", 5, makeSkewedStatistics()));
+
+    ASSERT_EQ(plan_cost_estimator::pruneByEstimatedCost(&solutions, 10.0), 0U);
+    ASSERT_EQ(solutions.size(), 2U);
+}
+
+TEST(PlanCostEstimatorTest, LimitedPlanDoesNotPruneOthersByItsOptimisticCost) {
+    // The limited full index scan is expected to stop after 5 keys, but its worst case is to
+    // examine all 1000, so a plan examining the 501 keys with a = 7 is kept.
+    std::vector<std::unique_ptr<QuerySolution>> solutions;
+    solutions.push_back(makePointScan("a", 7, makeSkewedStatistics()));
+
+    solutions.push_back(makeLimitedFullScan("b", 5, makeSkewedStatistics()));
+
+    ASSERT_EQ(plan_cost_estimator::pruneByEstimatedCost(&solutions, 10.0), 0U);
+    ASSERT_EQ(solutions.size(), 2U);
+}
+
+TEST(PlanCostEstimatorTest, PrunesPlansMuchCostlierThanTheCheapest) {
+    std::vector<std::unique_ptr<QuerySolution>> solutions;
+    solutions.push_back(makePointScan("a", 7, makeSkewedStatistics()));
+    solutions.push_back(makePointScan("b", 300, makeSkewedStatistics()));
+
+    ASSERT_EQ(plan_cost_estimator::pruneByEstimatedCost(&solutions, 10.0), 1U);
+    ASSERT_EQ(solutions.size(), 1U);
+    auto fetch = solutions[0]->root.get();
+    ASSERT_EQ(static_cast<IndexScanNode*>(fetch->children[0])->index.identifier.catalogName,
+              "b_1");
+}
+
+TEST(PlanCostEstimatorTest, KeepsPlansWithinRatio) {
+    std::vector<std::unique_ptr<QuerySolution>> solutions;
+    solutions.push_back(makePointScan("a", 100, makeSkewedStatistics()));
+    solutions.push_back(makePointScan("b", 300, makeSkewedStatistics()));
+
+    ASSERT_EQ(plan_cost_estimator::pruneByEstimatedCost(&solutions, 10.0), 0U);
+    ASSERT_EQ(solutions.size(), 2U);
+}
+
+TEST(PlanCostEstimatorTest, DoesNotPruneUnlessEveryPlanIsEstimated) {
+    std::vector<std::unique_ptr<QuerySolution>> solutions;
+    solutions.push_back(makePointScan("a", 7, makeSkewedStatistics()));
+    solutions.push_back(makePointScan("b", 300, nullptr));
+
+    ASSERT_EQ(plan_cost_estimator::pruneByEstimatedCost(&solutions, 10.0), 0U);
+    ASSERT_EQ(solutions.size(), 2U);
+}
+
+TEST(PlanCostEstimatorTest, NonPositiveRatioDisablesPruning) {
+    std::vector<std::unique_ptr<QuerySolution>> solutions;
+    solutions.push_back(makePointScan("a", 7, makeSkewedStatistics()));
+    solutions.push_back(makePointScan("b", 300, makeSkewedStatistics()));
+
+    ASSERT_EQ(plan_cost_estimator::pruneByEstimatedCost(&solutions, 0.0), 0U);
+    ASSERT_EQ(solutions.size(), 2U);
+}
+
+}  // namespace
+}  // namespace monger
@@ -283,6 +283,12 @@ public:
      */
     virtual CanonicalQuery* getCanonicalQuery() const = 0;
 
+    /**
+     * Returns the sort orders which the results of this executor are known to follow, or an empty
+     * set if they follow none. Must be called after plan selection.
+     */
+    virtual BSONObjSet getOutputSorts() const = 0;
+
     /**
      * Return the NS that the query is running over.
      */
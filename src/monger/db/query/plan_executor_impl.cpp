@@ -54,6 +54,7 @@
 #include "monger/db/query/find_common.h"
 #include "monger/db/query/mock_yield_policies.h"
 #include "monger/db/query/plan_yield_policy.h"
+#include "monger/db/query/query_knobs_gen.h"
 #include "monger/db/repl/replication_coordinator.h"
 #include "monger/db/service_context.h"
 #include "monger/util/fail_point_service.h"
@@ -312,6 +313,35 @@ CanonicalQuery* PlanExecutorImpl::getCanonicalQuery() const {
     return _cq.get();
 }
 
+BSONObjSet PlanExecutorImpl::getOutputSorts() const {
+    QuerySolution* solution = nullptr;
+    switch (_root->stageType()) {
+        case STAGE_CACHED_PLAN:
+            // A replanned cached plan no longer runs the solution we were given.
+            if (static_cast<const CachedPlanStats*>(_root->getSpecificStats())->replanned) {
+                return SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+            }
+            solution = _qs.get();
+            break;
+        case STAGE_MULTI_PLAN:
+            // If we needed a MultiPlanStage, the PlanExecutor does not own the QuerySolution.
+            solution = static_cast<MultiPlanStage*>(_root.get())->bestSolution();
+            break;
+        case STAGE_SUBPLAN:
+            solution = static_cast<SubplanStage*>(_root.get())->compositeSolution();
+            break;
+        default:
+            solution = _qs.get();
+            break;
+    }
+
+    if (!solution || !solution->root) {
+        return SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+    }
+    solution->root->computeProperties();
+    return solution->root->getSort();
+}
+
 const NamespaceString& PlanExecutorImpl::nss() const {
     return _nss;
 }
@@ -328,6 +358,12 @@ void PlanExecutorImpl::saveState() {
     // boundaries.
     WorkingSetCommon::prepareForSnapshotChange(_workingSet.get());
 
+    // Batched results which have not been returned yet must not refer to storage engine memory
+    // across the yield.
+    for (size_t i = _nextBatchedResult; i < _batchedResults.size(); ++i) {
+        _workingSet->get(_batchedResults[i])->makeObjOwnedIfNeeded();
+    }
+
     if (!isMarkedAsKilled()) {
         _root->saveState();
     }
@@ -470,6 +506,40 @@ PlanExecutor::ExecState PlanExecutorImpl::_waitForInserts(CappedInsertNotifierDa
     return FAILURE;
 }
 
+bool PlanExecutorImpl::_extractResult(WorkingSetID id,
+                                      Snapshotted<BSONObj>* objOut,
+                                      RecordId* dlOut) {
+    WorkingSetMember* member = _workingSet->get(id);
+    bool hasRequestedData = true;
+
+    if (nullptr != objOut) {
+        if (WorkingSetMember::RID_AND_IDX == member->getState()) {
+            if (1 != member->keyData.size()) {
+                hasRequestedData = false;
+            } else {
+                // TODO: currently snapshot ids are only associated with documents, and
+                // not with index keys.
+                *objOut = Snapshotted<BSONObj>(SnapshotId(), member->keyData[0].keyData);
+            }
+        } else if (member->hasObj()) {
+            *objOut = member->obj;
+        } else {
+            hasRequestedData = false;
+        }
+    }
+
+    if (nullptr != dlOut && hasRequestedData) {
+        if (member->hasRecordId()) {
+            *dlOut = member->recordId;
+        } else {
+            hasRequestedData = false;
+        }
+    }
+
+    _workingSet->free(id);
+    return hasRequestedData;
+}
+
 PlanExecutor::ExecState PlanExecutorImpl::_getNextImpl(Snapshotted<BSONObj>* objOut,
                                                        RecordId* dlOut) {
     if (MONGO_FAIL_POINT(planExecutorAlwaysFails)) {
@@ -509,6 +579,17 @@ PlanExecutor::ExecState PlanExecutorImpl::_getNextImpl(Snapshotted<BSONObj>* obj
         cappedInsertNotifierData.notifier = _getCappedInsertNotifier();
     }
     for (;;) {
+        // Return any results left over from the previous batch before doing more work.
+        if (_hasBatchedResults()) {
+            if (_extractResult(_batchedResults[_nextBatchedResult++], objOut, dlOut)) {
+                return PlanExecutor::ADVANCED;
+            }
+            // This result didn't have the data the caller wanted, try again.
+            continue;
+        }
+        _batchedResults.clear();
+        _nextBatchedResult = 0;
+
         // These are the conditions which can cause us to yield:
         //   1) The yield policy's timer elapsed, or
         //   2) some stage requested a yield, or
@@ -526,47 +607,19 @@ PlanExecutor::ExecState PlanExecutorImpl::_getNextImpl(Snapshotted<BSONObj>* obj
         }
 
         WorkingSetID id = WorkingSet::INVALID_ID;
-        PlanStage::StageState code = _root->work(&id);
+        const size_t worksBefore = _root->getCommonStats()->works;
+        PlanStage::StageState code = _root->workBatch(
+            static_cast<size_t>(internalQueryExecBatchSize.load()), &_batchedResults, &id);
+
+        // Every unit of work in the batch counts towards the next yield or interrupt check, as if
+        // the root had been worked one unit at a time.
+        _yieldPolicy->recordWorks(_root->getCommonStats()->works - worksBefore);
 
         if (code != PlanStage::NEED_YIELD)
             writeConflictsInARow = 0;
 
         if (PlanStage::ADVANCED == code) {
-            WorkingSetMember* member = _workingSet->get(id);
-            bool hasRequestedData = true;
-
-            if (nullptr != objOut) {
-                if (WorkingSetMember::RID_AND_IDX == member->getState()) {
-                    if (1 != member->keyData.size()) {
-                        _workingSet->free(id);
-                        hasRequestedData = false;
-                    } else {
-                        // TODO: currently snapshot ids are only associated with documents, and
-                        // not with index keys.
-                        *objOut = Snapshotted<BSONObj>(SnapshotId(), member->keyData[0].keyData);
-                    }
-                } else if (member->hasObj()) {
-                    *objOut = member->obj;
-                } else {
-                    _workingSet->free(id);
-                    hasRequestedData = false;
-                }
-            }
-
-            if (nullptr != dlOut) {
-                if (member->hasRecordId()) {
-                    *dlOut = member->recordId;
-                } else {
-                    _workingSet->free(id);
-                    hasRequestedData = false;
-                }
-            }
-
-            if (hasRequestedData) {
-                _workingSet->free(id);
-                return PlanExecutor::ADVANCED;
-            }
-            // This result didn't have the data the caller wanted, try again.
+            // The results are returned from the top of the loop.
         } else if (PlanStage::NEED_YIELD == code) {
             invariant(id == WorkingSet::INVALID_ID);
             if (!_yieldPolicy->canAutoYield() || MONGO_FAIL_POINT(skipWriteConflictRetries)) {
@@ -585,6 +638,11 @@ PlanExecutor::ExecState PlanExecutorImpl::_getNextImpl(Snapshotted<BSONObj>* obj
         } else if (PlanStage::NEED_TIME == code) {
             // Fall through to yield check at end of large conditional.
         } else if (PlanStage::IS_EOF == code) {
+            if (_hasBatchedResults()) {
+                // Hand out the remainder of the batch first. The root stage will report EOF
+                // again once we ask it for more work.
+                continue;
+            }
             if (MONGO_FAIL_POINT(planExecutorHangBeforeShouldWaitForInserts)) {
                 log() << "PlanExecutor - planExecutorHangBeforeShouldWaitForInserts fail point "
                          "enabled. Blocking until fail point is disabled.";
@@ -602,6 +660,14 @@ PlanExecutor::ExecState PlanExecutorImpl::_getNextImpl(Snapshotted<BSONObj>* obj
         } else {
             invariant(PlanStage::FAILURE == code);
 
+            // Results which preceded the failure in the batch are discarded along with the
+            // rest of the query.
+            for (size_t i = _nextBatchedResult; i < _batchedResults.size(); ++i) {
+                _workingSet->free(_batchedResults[i]);
+            }
+            _batchedResults.clear();
+            _nextBatchedResult = 0;
+
             if (nullptr != objOut) {
                 BSONObj statusObj;
                 invariant(WorkingSet::INVALID_ID != id);
@@ -616,7 +682,7 @@ PlanExecutor::ExecState PlanExecutorImpl::_getNextImpl(Snapshotted<BSONObj>* obj
 
 bool PlanExecutorImpl::isEOF() {
     invariant(_currentState == kUsable);
-    return isMarkedAsKilled() || (_stash.empty() && _root->isEOF());
+    return isMarkedAsKilled() || (_stash.empty() && !_hasBatchedResults() && _root->isEOF());
 }
 
 void PlanExecutorImpl::markAsKilled(Status killStatus) {
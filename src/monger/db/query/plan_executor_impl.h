@@ -31,7 +31,9 @@
 
 #include <boost/optional.hpp>
 #include <queue>
+#include <vector>
 
+#include "monger/db/exec/working_set.h"
 #include "monger/db/query/plan_executor.h"
 
 namespace monger {
@@ -58,6 +60,7 @@ public:
     WorkingSet* getWorkingSet() const final;
     PlanStage* getRootStage() const final;
     CanonicalQuery* getCanonicalQuery() const final;
+    BSONObjSet getOutputSorts() const final;
     const NamespaceString& nss() const final;
     OperationContext* getOpCtx() const final;
     void saveState() final;
@@ -147,6 +150,19 @@ private:
      */
     ExecState _getNextImpl(Snapshotted<BSONObj>* objOut, RecordId* dlOut);
 
+    /**
+     * Populates 'objOut' and 'dlOut' from the ADVANCED working set member 'id' and frees it.
+     * Returns false if the member did not have the data requested by the caller.
+     */
+    bool _extractResult(WorkingSetID id, Snapshotted<BSONObj>* objOut, RecordId* dlOut);
+
+    /**
+     * Returns true if results from the last batch are still waiting to be returned.
+     */
+    bool _hasBatchedResults() const {
+        return _nextBatchedResult < _batchedResults.size();
+    }
+
     // The OperationContext that we're executing within. This can be updated if necessary by using
     // detachFromOperationContext() and reattachToOperationContext().
     OperationContext* _opCtx;
@@ -173,6 +189,12 @@ private:
     // stages.
     std::queue<BSONObj> _stash;
 
+    // Results produced by the most recent call to workBatch() on the root stage which have not
+    // yet been returned to the caller. They are consumed in order starting at
+    // '_nextBatchedResult', after the stash and before any further work on the plan stages.
+    std::vector<WorkingSetID> _batchedResults;
+    size_t _nextBatchedResult = 0;
+
     enum { kUsable, kSaved, kDetached, kDisposed } _currentState = kUsable;
 
     bool _everDetachedFromOperationContext = false;
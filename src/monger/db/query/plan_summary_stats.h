@@ -65,6 +65,9 @@ struct PlanSummaryStats {
 
     // Was a replan triggered during the execution of this query?
     bool replanned = false;
+
+    // Time spent by the MultiPlanStage choosing a winner among the candidate plans.
+    long long planningTimeMicros = 0;
 };
 
 }  // namespace monger
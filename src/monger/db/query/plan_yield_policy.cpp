@@ -31,6 +31,8 @@
 
 #include "monger/db/query/plan_yield_policy.h"
 
+#include <algorithm>
+
 #include "monger/db/concurrency/write_conflict_exception.h"
 #include "monger/db/curop.h"
 #include "monger/db/curop_failpoint_helpers.h"
@@ -66,15 +68,19 @@ PlanYieldPolicy::PlanYieldPolicy(PlanExecutor::YieldPolicy policy, ClockSource*
       _planYielding(nullptr) {}
 
 bool PlanYieldPolicy::shouldYieldOrInterrupt() {
+    // A batch holds at most internalQueryExecBatchSize units of work, which fits in an int32_t.
+    const auto hits = static_cast<int32_t>(std::max<size_t>(_unrecordedWorks, 1));
+    _unrecordedWorks = 0;
+
     if (_policy == PlanExecutor::INTERRUPT_ONLY) {
-        return _elapsedTracker.intervalHasElapsed();
+        return _elapsedTracker.intervalHasElapsed(hits);
     }
     if (!canAutoYield())
         return false;
     invariant(!_planYielding->getOpCtx()->lockState()->inAWriteUnitOfWork());
     if (_forceYield)
         return true;
-    return _elapsedTracker.intervalHasElapsed();
+    return _elapsedTracker.intervalHasElapsed(hits);
 }
 
 void PlanYieldPolicy::resetTimer() {
@@ -59,6 +59,15 @@ public:
      */
     virtual bool shouldYieldOrInterrupt();
 
+    /**
+     * Counts 'numWorks' units of work, performed together since the last call to
+     * shouldYieldOrInterrupt(), towards the iterations between yields. The next call counts them
+     * in place of the single iteration it counts by itself.
+     */
+    void recordWorks(size_t numWorks) {
+        _unrecordedWorks += numWorks;
+    }
+
     /**
      * Resets the yield timer so that we wait for a while before yielding/interrupting again.
      */
@@ -141,6 +150,9 @@ private:
     bool _forceYield;
     ElapsedTracker _elapsedTracker;
 
+    // Units of work passed to recordWorks() since the last call to shouldYieldOrInterrupt().
+    size_t _unrecordedWorks = 0;
+
     // The plan executor which this yield policy is responsible for yielding. Must
     // not outlive the plan executor.
     PlanExecutor* const _planYielding;
@@ -43,6 +43,7 @@
 #include "monger/db/matcher/expression_array.h"
 #include "monger/db/matcher/expression_geo.h"
 #include "monger/db/matcher/expression_text.h"
+#include "monger/db/query/collation/collator_interface.h"
 #include "monger/db/query/index_bounds_builder.h"
 #include "monger/db/query/index_tag.h"
 #include "monger/db/query/indexability.h"
@@ -136,6 +137,44 @@ std::vector<bool> canProvideSortWithMergeSort(
     return shouldReverseScan;
 }
 
+/**
+ * Returns true if a collection scan answering 'query' may be split into partitions that are read
+ * concurrently. The caller must have asked for it, the scan must be free to return documents in any
+ * order and in full, and the filter must be safe to evaluate on threads other than the one that
+ * owns the query.
+ */
+bool canScanInParallel(const CanonicalQuery& query,
+                       bool tailable,
+                       const QueryPlannerParams& params) {
+    if (!(params.options & QueryPlannerParams::PARALLEL_COLLSCAN) ||
+        (params.options & QueryPlannerParams::INCLUDE_COLLSCAN) || tailable) {
+        return false;
+    }
+
+    const auto& qr = query.getQueryRequest();
+    if (!qr.getHint().isEmpty() || qr.getSkip() || qr.getLimit() || qr.getNToReturn() ||
+        qr.isOplogReplay()) {
+        return false;
+    }
+
+    // A sort on $natural asks for the scan order itself.
+    if (!dps::extractElementAtPath(qr.getSort(), "$natural").eoo()) {
+        return false;
+    }
+
+    // $where and $expr evaluate against per-operation state, and text and geoNear predicates need
+    // an index anyway.
+    for (auto type : {MatchExpression::WHERE,
+                      MatchExpression::EXPRESSION,
+                      MatchExpression::TEXT,
+                      MatchExpression::GEO_NEAR}) {
+        if (QueryPlannerCommon::hasNode(query.root(), type)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 }  // namespace
 
 namespace monger {
@@ -154,6 +193,7 @@ std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::makeCollectionScan(
         params.options & QueryPlannerParams::TRACK_LATEST_OPLOG_TS;
     csn->shouldWaitForOplogVisibility =
         params.options & QueryPlannerParams::OPLOG_SCAN_WAIT_FOR_VISIBLE;
+    csn->parallel = canScanInParallel(query, tailable, params);
 
     // If the hint is {$natural: +-1} this changes the direction of the collection scan.
     if (!query.getQueryRequest().getHint().isEmpty()) {
@@ -1419,4 +1459,105 @@ std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::makeIndexScan(
     return solnRoot;
 }
 
+namespace {
+
+/**
+ * Returns true if 'expr' is a predicate which the index bounds builder can translate into bounds
+ * on a field of a btree index that is not multikey.
+ */
+bool canBoundSkipScan(const MatchExpression* expr) {
+    switch (expr->matchType()) {
+        case MatchExpression::EQ:
+        case MatchExpression::LT:
+        case MatchExpression::LTE:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+        case MatchExpression::MATCH_IN:
+            return true;
+        default:
+            return false;
+    }
+}
+
+}  // namespace
+
+std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::makeSkipScan(
+    const IndexEntry& index, const CanonicalQuery& query, const QueryPlannerParams& params) {
+    invariant(INDEX_BTREE == index.type);
+    invariant(!index.multikey);
+
+    // The bounds on strings would be in the wrong order for the query's collation.
+    if (index.keyPattern.nFields() < 2 ||
+        !CollatorInterface::collatorsMatch(index.collator, query.getCollator())) {
+        return nullptr;
+    }
+
+    // Only the top-level conjuncts of the query can bound the scan.
+    std::vector<const MatchExpression*> predicates;
+    const MatchExpression* root = query.root();
+    if (MatchExpression::AND == root->matchType()) {
+        for (size_t i = 0; i < root->numChildren(); ++i) {
+            predicates.push_back(root->getChild(i));
+        }
+    } else {
+        predicates.push_back(root);
+    }
+
+    auto isn = std::make_unique<IndexScanNode>(index);
+    isn->direction = 1;
+    isn->addKeyMetadata = query.getQueryRequest().returnKey();
+    isn->queryCollator = query.getCollator();
+    isn->isSkipScan = true;
+    isn->bounds.fields.resize(index.keyPattern.nFields());
+
+    // The leading field takes all values. The fields after it are bounded by the predicates on
+    // them, up to the first field that has none, and take all values from there on. Since the
+    // index is not multikey, the bounds of several predicates on one field can be intersected.
+    bool stillBounding = true;
+    size_t fieldNo = 0;
+    for (auto&& keyElt : index.keyPattern) {
+        OrderedIntervalList* oil = &isn->bounds.fields[fieldNo];
+        bool bounded = false;
+        for (auto&& pred : predicates) {
+            if (pred->path() != keyElt.fieldNameStringData()) {
+                continue;
+            }
+            if (0 == fieldNo) {
+                // The enumerator already plans the ordinary scans of this index.
+                return nullptr;
+            }
+            if (!stillBounding || !canBoundSkipScan(pred)) {
+                continue;
+            }
+
+            IndexBoundsBuilder::BoundsTightness tightness;
+            if (bounded) {
+                IndexBoundsBuilder::translateAndIntersect(pred, keyElt, index, oil, &tightness);
+            } else {
+                IndexBoundsBuilder::translate(pred, keyElt, index, oil, &tightness);
+                bounded = true;
+            }
+        }
+
+        if (!bounded) {
+            if (1 == fieldNo) {
+                return nullptr;
+            }
+            IndexBoundsBuilder::allValuesForField(keyElt, oil);
+            stillBounding = stillBounding && 0 == fieldNo;
+        }
+        ++fieldNo;
+    }
+    IndexBoundsBuilder::alignBounds(&isn->bounds, index.keyPattern);
+
+    // The bounds may be looser than the predicates they came from, so the whole filter is applied
+    // to the fetched documents.
+    auto fetch = std::make_unique<FetchNode>();
+    fetch->filter = query.root()->shallowClone();
+    fetch->children.push_back(isn.release());
+
+    std::unique_ptr<QuerySolutionNode> solnRoot = std::move(fetch);
+    return solnRoot;
+}
+
 }  // namespace monger
@@ -119,6 +119,18 @@ public:
                                                             const BSONObj& startKey,
                                                             const BSONObj& endKey);
 
+    /**
+     * Return a plan that skip scans the provided index, which must be a btree index that is not
+     * multikey. The scan covers all values of the index's leading field, which 'query' must not
+     * constrain, and the bounds that the top-level predicates of 'query' put on the fields after
+     * it; the index scan stage seeks from one leading value to the next. Returns nullptr if the
+     * index cannot be skip scanned for 'query', in particular if no predicate bounds its second
+     * field.
+     */
+    static std::unique_ptr<QuerySolutionNode> makeSkipScan(const IndexEntry& index,
+                                                           const CanonicalQuery& query,
+                                                           const QueryPlannerParams& params);
+
     /**
      * Consructs a data access plan for 'query' which answers the predicate contained in 'root'.
      * Assumes the presence of the passed in indices. Planning behavior is controlled by the
@@ -47,11 +47,14 @@
 #include "monger/db/query/canonical_query.h"
 #include "monger/db/query/collation/collation_index_key.h"
 #include "monger/db/query/collation/collator_interface.h"
+#include "monger/db/query/index_statistics.h"
 #include "monger/db/query/plan_cache.h"
+#include "monger/db/query/plan_cost_estimator.h"
 #include "monger/db/query/plan_enumerator.h"
 #include "monger/db/query/planner_access.h"
 #include "monger/db/query/planner_analysis.h"
 #include "monger/db/query/planner_ixselect.h"
+#include "monger/db/query/query_knobs_gen.h"
 #include "monger/db/query/query_planner_common.h"
 #include "monger/db/query/query_solution.h"
 #include "monger/util/log.h"
@@ -290,6 +293,27 @@ std::unique_ptr<QuerySolution> buildWholeIXSoln(const IndexEntry& index,
     return QueryPlannerAnalysis::analyzeDataAccess(query, params, std::move(solnRoot));
 }
 
+std::unique_ptr<QuerySolution> buildSkipScanSoln(const IndexEntry& index,
+                                                 const CanonicalQuery& query,
+                                                 const QueryPlannerParams& params) {
+    std::unique_ptr<QuerySolutionNode> solnRoot(
+        QueryPlannerAccess::makeSkipScan(index, query, params));
+    if (!solnRoot) {
+        return nullptr;
+    }
+    return QueryPlannerAnalysis::analyzeDataAccess(query, params, std::move(solnRoot));
+}
+
+/**
+ * Returns true if 'index' could be skip scanned, and its statistics suggest that seeking over the
+ * distinct values of its leading field beats scanning the collection.
+ */
+bool shouldConsiderSkipScan(const IndexEntry& index) {
+    return INDEX_BTREE == index.type && !index.multikey && !index.sparse && !index.filterExpr &&
+        index.keyPattern.nFields() >= 2 && index.statistics &&
+        plan_cost_estimator::skipScanCheaperThanCollscan(*index.statistics);
+}
+
 bool providesSort(const CanonicalQuery& query, const BSONObj& kp) {
     return query.getQueryRequest().getSort().isPrefixOf(kp, SimpleBSONElementComparator::kInstance);
 }
@@ -468,6 +492,13 @@ StatusWith<std::unique_ptr<QuerySolution>> QueryPlanner::planFromCache(
         } else {
             return {std::move(soln)};
         }
+    } else if (SolutionCacheData::SKIP_SCAN_SOLN == winnerCacheData.solnType) {
+        auto soln = buildSkipScanSoln(*winnerCacheData.tree->entry, query, params);
+        if (!soln) {
+            return Status(ErrorCodes::BadValue, "plan cache error: skip scan soln");
+        } else {
+            return {std::move(soln)};
+        }
     }
 
     // SolutionCacheData::USE_TAGS_SOLN == cacheData->solnType
@@ -862,6 +893,42 @@ StatusWith<std::vector<std::unique_ptr<QuerySolution>>> QueryPlanner::plan(
         return {std::move(out)};
     }
 
+    // A compound index whose leading field the query does not constrain can still serve the
+    // predicates on its later fields, by seeking from each distinct leading value to the keys
+    // in bounds under it. When nothing else can use an index, such skip scans compete against a
+    // collection scan in the trial period, since the cost model cannot tell how many documents
+    // they will fetch.
+    const bool hadIndexedSolutions = !out.empty();
+    bool addedSkipScans = false;
+    if (internalQueryPlannerEnableSkipScan.load() && hintedIndex.isEmpty() &&
+        !QueryPlannerCommon::hasNode(query.root(), MatchExpression::GEO_NEAR) &&
+        !QueryPlannerCommon::hasNode(query.root(), MatchExpression::TEXT)) {
+        // The relevant indexes are those whose leading field the query constrains, which rules
+        // out a skip scan, so every index is a candidate.
+        for (auto&& index : fullIndexList) {
+            if (out.size() >= params.maxIndexedSolutions) {
+                break;
+            }
+            if (!shouldConsiderSkipScan(index)) {
+                continue;
+            }
+
+            auto soln = buildSkipScanSoln(index, query, params);
+            if (soln) {
+                LOG(5) << "Planner: outputting skip scan soln:" << endl << redact(soln->toString());
+                PlanCacheIndexTree* indexTree = new PlanCacheIndexTree();
+                indexTree->setIndexEntry(index);
+                SolutionCacheData* scd = new SolutionCacheData();
+                scd->tree.reset(indexTree);
+                scd->solnType = SolutionCacheData::SKIP_SCAN_SOLN;
+                soln->cacheData.reset(scd);
+
+                out.push_back(std::move(soln));
+                addedSkipScans = true;
+            }
+        }
+    }
+
     // If a sort order is requested, there may be an index that provides it, even if that
     // index is not over any predicates in the query.
     //
@@ -997,7 +1064,9 @@ StatusWith<std::vector<std::unique_ptr<QuerySolution>>> QueryPlanner::plan(
     bool collscanRequested = (params.options & QueryPlannerParams::INCLUDE_COLLSCAN);
 
     // No indexed plans?  We must provide a collscan if possible or else we can't run the query.
-    bool collscanNeeded = (0 == out.size() && canTableScan);
+    // Skip scans alone are never trusted over a collscan without racing it.
+    bool collscanNeeded =
+        ((0 == out.size() || (addedSkipScans && !hadIndexedSolutions)) && canTableScan);
 
     if (possibleToCollscan && (collscanRequested || collscanNeeded)) {
         auto collscan = buildCollscanSoln(query, isTailable, params);
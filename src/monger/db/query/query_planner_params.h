@@ -98,6 +98,11 @@ struct QueryPlannerParams {
         // return exactly one document per value of the distinct field. See the comments above the
         // declaration of getExecutorDistinct() for more detail.
         STRICT_DISTINCT_ONLY = 1 << 11,
+
+        // Set this to allow a collection scan to be split into partitions which are read by
+        // multiple threads. Results of such a scan are returned in no particular order, and the
+        // plan executor running it must be able to yield.
+        PARALLEL_COLLSCAN = 1 << 12,
     };
 
     // See Options enum above.
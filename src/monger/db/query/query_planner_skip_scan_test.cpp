@@ -0,0 +1,193 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "monger/platform/basic.h"
+
+#include "monger/db/query/index_statistics.h"
+#include "monger/db/query/query_knobs_gen.h"
+#include "monger/db/query/query_planner_test_fixture.h"
+#include "monger/util/scopeguard.h"
+
+namespace {
+
+using namespace monger;
+
+/**
+ * Returns statistics for an index whose leading field takes 'numDistinctValues' values, each in
+ * 'keysPerValue' keys.
+ */
+std::shared_ptr<const IndexStatistics> makeStatistics(int numDistinctValues, int keysPerValue) {
+    IndexStatistics::Builder builder(
+        IndexStatistics::kDefaultSampleSize, IndexStatistics::kDefaultNumBuckets, 1);
+    for (int i = 0; i < numDistinctValues; ++i) {
+        for (int j = 0; j < keysPerValue; ++j) {
+            builder.addKey(BSON("" << i << "" << j));
+        }
+    }
+    return builder.done(Date_t::now());
+}
+
+class QueryPlannerSkipScanTest : public QueryPlannerTest {
+protected:
+    void addIndexWithStatistics(BSONObj keyPattern,
+                                std::shared_ptr<const IndexStatistics> statistics,
+                                bool multikey = false) {
+        IndexEntry entry(keyPattern,
+                         INDEX_BTREE,
+                         multikey,
+                         {},
+                         {},
+                         false,  // sparse
+                         false,  // unique
+                         IndexEntry::Identifier{"skip_scan_index"},
+                         nullptr,  // filterExpr
+                         BSONObj(),
+                         nullptr,
+                         nullptr);
+        entry.statistics = std::move(statistics);
+        addIndex(entry);
+    }
+};
+
+TEST_F(QueryPlannerSkipScanTest, SkipScansIndexWithFewLeadingValues) {
+    addIndexWithStatistics(BSON("a" << 1 << "b" << 1), makeStatistics(10, 100));
+
+    runQuery(fromjson("{b: 5}"));
+
+    assertNumSolutions(2U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+    assertSolutionExists(
+        "{fetch: {filter: {b: 5}, node: {ixscan: {pattern: {a: 1, b: 1}, bounds: "
+        "{a: [['MinKey', 'MaxKey', true, true]], b: [[5, 5, true, true]]}}}}}");
+}
+
+TEST_F(QueryPlannerSkipScanTest, SkipScanBoundsStopAtFirstUnconstrainedField) {
+    addIndexWithStatistics(BSON("a" << 1 << "b" << -1 << "c" << 1 << "d" << 1),
+                           makeStatistics(10, 100));
+
+    runQuery(fromjson("{b: {$gt: 2, $lte: 8}, d: 3}"));
+
+    assertNumSolutions(2U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+    assertSolutionExists(
+        "{fetch: {filter: {b: {$gt: 2, $lte: 8}, d: 3}, node: {ixscan: "
+        "{pattern: {a: 1, b: -1, c: 1, d: 1}, bounds: {a: [['MinKey', 'MaxKey', true, true]], "
+        "b: [[8, 2, true, false]], c: [['MinKey', 'MaxKey', true, true]], "
+        "d: [['MinKey', 'MaxKey', true, true]]}}}}}");
+}
+
+TEST_F(QueryPlannerSkipScanTest, SkipScanCompetesWithOrdinaryIndexScans) {
+    addIndexWithStatistics(BSON("a" << 1 << "b" << 1), makeStatistics(10, 100));
+    addIndex(BSON("c" << 1));
+
+    runQuery(fromjson("{b: 5, c: 3}"));
+
+    assertNumSolutions(3U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+    assertSolutionExists(
+        "{fetch: {filter: {b: 5}, node: {ixscan: {pattern: {c: 1}, bounds: "
+        "{c: [[3, 3, true, true]]}}}}}");
+    assertSolutionExists(
+        "{fetch: {filter: {b: 5, c: 3}, node: {ixscan: {pattern: {a: 1, b: 1}, bounds: "
+        "{a: [['MinKey', 'MaxKey', true, true]], b: [[5, 5, true, true]]}}}}}");
+}
+
+TEST_F(QueryPlannerSkipScanTest, NoSkipScanOfIndexOtherThanTheHintedOne) {
+    addIndexWithStatistics(BSON("a" << 1 << "b" << 1), makeStatistics(10, 100));
+    addIndex(BSON("c" << 1));
+
+    runQueryHint(fromjson("{b: 5, c: 3}"), BSON("c" << 1));
+
+    assertNumSolutions(1U);
+    assertSolutionExists(
+        "{fetch: {filter: {b: 5}, node: {ixscan: {pattern: {c: 1}, bounds: "
+        "{c: [[3, 3, true, true]]}}}}}");
+}
+
+TEST_F(QueryPlannerSkipScanTest, NoSkipScanWhenLeadingFieldIsConstrained) {
+    addIndexWithStatistics(BSON("a" << 1 << "b" << 1), makeStatistics(10, 100));
+
+    runQuery(fromjson("{a: {$exists: true}, b: 5}"));
+
+    assertNumSolutions(2U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+    assertSolutionExists(
+        "{fetch: {node: {ixscan: {pattern: {a: 1, b: 1}, bounds: "
+        "{a: [['MinKey', 'MaxKey', true, true]], b: [[5, 5, true, true]]}}}}}");
+}
+
+TEST_F(QueryPlannerSkipScanTest, NoSkipScanWithoutStatistics) {
+    addIndexWithStatistics(BSON("a" << 1 << "b" << 1), nullptr);
+
+    runQuery(fromjson("{b: 5}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+}
+
+TEST_F(QueryPlannerSkipScanTest, NoSkipScanWhenLeadingValuesAreMostlyDistinct) {
+    addIndexWithStatistics(BSON("a" << 1 << "b" << 1), makeStatistics(1000, 1));
+
+    runQuery(fromjson("{b: 5}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+}
+
+TEST_F(QueryPlannerSkipScanTest, NoSkipScanOverMultikeyIndex) {
+    addIndexWithStatistics(BSON("a" << 1 << "b" << 1), makeStatistics(10, 100), true);
+
+    runQuery(fromjson("{b: 5}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+}
+
+TEST_F(QueryPlannerSkipScanTest, NoSkipScanWithoutPredicateOnSecondField) {
+    addIndexWithStatistics(BSON("a" << 1 << "b" << 1 << "c" << 1), makeStatistics(10, 100));
+
+    runQuery(fromjson("{c: 5}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+}
+
+TEST_F(QueryPlannerSkipScanTest, NoSkipScanWhenDisabled) {
+    addIndexWithStatistics(BSON("a" << 1 << "b" << 1), makeStatistics(10, 100));
+
+    internalQueryPlannerEnableSkipScan.store(false);
+    ON_BLOCK_EXIT([] { internalQueryPlannerEnableSkipScan.store(true); });
+    runQuery(fromjson("{b: 5}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+}
+
+}  // namespace
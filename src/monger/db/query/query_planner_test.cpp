@@ -2548,6 +2548,40 @@ TEST_F(QueryPlannerTest, NaturalHint) {
         "{cscan: {filter: {a: 1}, dir: 1}}}}}}");
 }
 
+TEST_F(QueryPlannerTest, ParallelCollscanWhenRequested) {
+    params.options = QueryPlannerParams::PARALLEL_COLLSCAN;
+    runQuery(BSON("a" << 1));
+
+    assertNumSolutions(1U);
+    assertSolutionExists("{cscan: {dir: 1, filter: {a: 1}, parallel: true}}");
+}
+
+TEST_F(QueryPlannerTest, NoParallelCollscanWhenScanOrderOrLengthMatters) {
+    params.options = QueryPlannerParams::PARALLEL_COLLSCAN;
+
+    runQuerySortHint(BSON("a" << 1), BSON("$natural" << 1), BSONObj());
+    assertNumSolutions(1U);
+    assertSolutionExists("{cscan: {dir: 1, filter: {a: 1}, parallel: false}}");
+
+    runQueryHint(BSON("a" << 1), BSON("$natural" << -1));
+    assertNumSolutions(1U);
+    assertSolutionExists("{cscan: {dir: -1, filter: {a: 1}, parallel: false}}");
+
+    runQuerySkipNToReturn(BSON("a" << 1), 0, 5);
+    assertNumSolutions(1U);
+    assertSolutionExists("{cscan: {dir: 1, filter: {a: 1}, parallel: false}}");
+}
+
+TEST_F(QueryPlannerTest, NoParallelCollscanWhenCompetingWithIndexedPlans) {
+    params.options = QueryPlannerParams::PARALLEL_COLLSCAN | QueryPlannerParams::INCLUDE_COLLSCAN;
+    addIndex(BSON("a" << 1));
+    runQuery(BSON("a" << 1));
+
+    assertNumSolutions(2U);
+    assertSolutionExists("{cscan: {dir: 1, filter: {a: 1}, parallel: false}}");
+    assertSolutionExists("{fetch: {filter: null, node: {ixscan: {pattern: {a: 1}}}}}");
+}
+
 // Test $natural sort and its interaction with $natural hint.
 TEST_F(QueryPlannerTest, NaturalSortAndHint) {
     addIndex(BSON("x" << 1));
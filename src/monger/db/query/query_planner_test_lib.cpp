@@ -253,7 +253,7 @@ bool QueryPlannerTestLib::solutionMatches(const BSONObj& testSoln,
             return false;
         }
         BSONObj csObj = el.Obj();
-        invariant(bsonObjFieldsAreInSet(csObj, {"dir", "filter", "collation"}));
+        invariant(bsonObjFieldsAreInSet(csObj, {"dir", "filter", "collation", "parallel"}));
 
         BSONElement dir = csObj["dir"];
         if (dir.eoo() || !dir.isNumber()) {
@@ -263,6 +263,11 @@ bool QueryPlannerTestLib::solutionMatches(const BSONObj& testSoln,
             return false;
         }
 
+        BSONElement parallel = csObj["parallel"];
+        if (!parallel.eoo() && parallel.trueValue() != csn->parallel) {
+            return false;
+        }
+
         BSONElement filter = csObj["filter"];
         if (filter.eoo()) {
             return true;
@@ -233,6 +233,10 @@ void CollectionScanNode::appendToString(str::stream* ss, int indent) const {
     *ss << "COLLSCAN\n";
     addIndent(ss, indent + 1);
     *ss << "ns = " << name << '\n';
+    if (parallel) {
+        addIndent(ss, indent + 1);
+        *ss << "parallel = true\n";
+    }
     if (nullptr != filter) {
         addIndent(ss, indent + 1);
         *ss << "filter = " << filter->debugString();
@@ -250,6 +254,7 @@ QuerySolutionNode* CollectionScanNode::clone() const {
     copy->direction = this->direction;
     copy->shouldTrackLatestOplogTimestamp = this->shouldTrackLatestOplogTimestamp;
     copy->shouldWaitForOplogVisibility = this->shouldWaitForOplogVisibility;
+    copy->parallel = this->parallel;
 
     return copy;
 }
@@ -507,6 +512,7 @@ QuerySolutionNode* FetchNode::clone() const {
     cloneBaseData(copy);
 
     copy->_sorts = this->_sorts;
+    copy->estimatedDocsExamined = this->estimatedDocsExamined;
 
     return copy;
 }
@@ -537,6 +543,10 @@ void IndexScanNode::appendToString(str::stream* ss, int indent) const {
     *ss << "direction = " << direction << '\n';
     addIndent(ss, indent + 1);
     *ss << "bounds = " << bounds.toString() << '\n';
+    if (isSkipScan) {
+        addIndent(ss, indent + 1);
+        *ss << "isSkipScan = true\n";
+    }
     addCommon(ss, indent);
 }
 
@@ -823,6 +833,8 @@ QuerySolutionNode* IndexScanNode::clone() const {
     copy->addKeyMetadata = this->addKeyMetadata;
     copy->bounds = this->bounds;
     copy->queryCollator = this->queryCollator;
+    copy->estimatedKeysExamined = this->estimatedKeysExamined;
+    copy->isSkipScan = this->isSkipScan;
 
     return copy;
 }
@@ -1169,6 +1181,11 @@ void CountScanNode::appendToString(str::stream* ss, int indent) const {
     *ss << "name = " << index.identifier.catalogName << '\n';
     addIndent(ss, indent + 1);
     *ss << "keyPattern = " << index.keyPattern << '\n';
+    if (bounds.size() > 0) {
+        addIndent(ss, indent + 1);
+        *ss << "bounds = " << bounds.toString() << '\n';
+        return;
+    }
     addIndent(ss, indent + 1);
     *ss << "startKey = " << startKey << '\n';
     addIndent(ss, indent + 1);
@@ -1184,6 +1201,7 @@ QuerySolutionNode* CountScanNode::clone() const {
     copy->startKeyInclusive = this->startKeyInclusive;
     copy->endKey = this->endKey;
     copy->endKeyInclusive = this->endKeyInclusive;
+    copy->bounds = this->bounds;
 
     return copy;
 }
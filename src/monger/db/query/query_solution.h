@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
 #include <memory>
 
 #include "monger/base/string_data.h"
@@ -331,6 +332,10 @@ struct CollectionScanNode : public QuerySolutionNode {
 
     // Whether or not to wait for oplog visibility on oplog collection scans.
     bool shouldWaitForOplogVisibility = false;
+
+    // Whether the scan may be split into partitions which are read concurrently. A parallel scan
+    // returns documents in no particular order.
+    bool parallel = false;
 };
 
 struct AndHashNode : public QuerySolutionNode {
@@ -471,6 +476,9 @@ struct FetchNode : public QuerySolutionNode {
     QuerySolutionNode* clone() const;
 
     BSONObjSet _sorts;
+
+    // The number of documents the cost model expects this stage to fetch, if it could estimate it.
+    boost::optional<long long> estimatedDocsExamined;
 };
 
 struct IndexScanNode : public QuerySolutionNode {
@@ -526,6 +534,13 @@ struct IndexScanNode : public QuerySolutionNode {
     //
     // The correct set of paths is computed and stored here by computeProperties().
     std::set<StringData> multikeyFields;
+
+    // The number of keys the cost model expects this scan to examine, if the index has statistics.
+    boost::optional<long long> estimatedKeysExamined;
+
+    // True if the query does not constrain the leading field of the index, and the scan instead
+    // seeks from each distinct leading value to the bounds on the fields after it.
+    bool isSkipScan = false;
 };
 
 /**
@@ -953,7 +968,7 @@ struct DistinctNode : public QuerySolutionNode {
 
 /**
  * Some count queries reduce to counting how many keys are between two entries in a
- * Btree.
+ * Btree, or within index bounds made of several intervals.
  */
 struct CountScanNode : public QuerySolutionNode {
     CountScanNode(IndexEntry index)
@@ -990,6 +1005,10 @@ struct CountScanNode : public QuerySolutionNode {
 
     BSONObj endKey;
     bool endKeyInclusive;
+
+    // Forward bounds to count the keys within, if they are not a single interval. The start and
+    // end keys are unset in that case.
+    IndexBounds bounds;
 };
 
 /**
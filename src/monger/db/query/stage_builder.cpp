@@ -51,6 +51,7 @@
 #include "monger/db/exec/limit.h"
 #include "monger/db/exec/merge_sort.h"
 #include "monger/db/exec/or.h"
+#include "monger/db/exec/parallel_collection_scan.h"
 #include "monger/db/exec/projection.h"
 #include "monger/db/exec/shard_filter.h"
 #include "monger/db/exec/skip.h"
@@ -75,6 +76,10 @@ PlanStage* buildStages(OperationContext* opCtx,
     switch (root->getType()) {
         case STAGE_COLLSCAN: {
             const CollectionScanNode* csn = static_cast<const CollectionScanNode*>(root);
+            if (csn->parallel) {
+                return new ParallelCollectionScan(opCtx, collection, ws, csn->filter.get());
+            }
+
             CollectionScanParams params;
             params.tailable = csn->tailable;
             params.shouldTrackLatestOplogTimestamp = csn->shouldTrackLatestOplogTimestamp;
@@ -110,6 +115,8 @@ PlanStage* buildStages(OperationContext* opCtx,
             params.direction = ixn->direction;
             params.addKeyMetadata = ixn->addKeyMetadata;
             params.shouldDedup = ixn->shouldDedup;
+            params.estimatedKeysExamined = ixn->estimatedKeysExamined;
+            params.isSkipScan = ixn->isSkipScan;
             return new IndexScan(opCtx, std::move(params), ws, ixn->filter.get());
         }
         case STAGE_FETCH: {
@@ -118,7 +125,11 @@ PlanStage* buildStages(OperationContext* opCtx,
             if (nullptr == childStage) {
                 return nullptr;
             }
-            return new FetchStage(opCtx, ws, childStage, fn->filter.get(), collection);
+            auto fetch = new FetchStage(opCtx, ws, childStage, fn->filter.get(), collection);
+            if (fn->estimatedDocsExamined) {
+                fetch->setEstimatedDocsExamined(*fn->estimatedDocsExamined);
+            }
+            return fetch;
         }
         case STAGE_SORT: {
             const SortNode* sn = static_cast<const SortNode*>(root);
@@ -360,6 +371,7 @@ PlanStage* buildStages(OperationContext* opCtx,
             params.startKeyInclusive = csn->startKeyInclusive;
             params.endKey = csn->endKey;
             params.endKeyInclusive = csn->endKeyInclusive;
+            params.bounds = csn->bounds;
             return new CountScan(opCtx, std::move(params), ws);
         }
         case STAGE_ENSURE_SORTED: {
@@ -378,6 +390,7 @@ PlanStage* buildStages(OperationContext* opCtx,
         case STAGE_IDHACK:
         case STAGE_MULTI_ITERATOR:
         case STAGE_MULTI_PLAN:
+        case STAGE_PARALLEL_COLLSCAN:
         case STAGE_PIPELINE_PROXY:
         case STAGE_QUEUED_DATA:
         case STAGE_RECORD_STORE_FAST_COUNT:
@@ -76,6 +76,9 @@ enum StageType {
     STAGE_MULTI_PLAN,
     STAGE_OR,
 
+    // A collection scan split into RecordId ranges which are scanned by a pool of worker threads.
+    STAGE_PARALLEL_COLLSCAN,
+
     // Projection has three alternate implementations.
     STAGE_PROJECTION_DEFAULT,
     STAGE_PROJECTION_COVERED,
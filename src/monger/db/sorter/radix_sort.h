@@ -0,0 +1,161 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <vector>
+
+#include "monger/base/string_data.h"
+
+namespace monger {
+namespace sorter {
+namespace radix_sort_detail {
+
+struct Entry {
+    const char* bytes;
+    size_t size;
+    size_t index;
+};
+
+// Buckets smaller than this are sorted by comparisons, which is cheaper than another pass over
+// 256 buckets.
+const size_t kSmallBucketSize = 64;
+
+/**
+ * Returns the bucket of 'entry' at byte 'depth': zero if it has no byte at 'depth', or one plus
+ * the value of that byte otherwise.
+ */
+inline size_t bucketAt(const Entry& entry, size_t depth) {
+    return depth < entry.size ? 1 + static_cast<unsigned char>(entry.bytes[depth]) : 0;
+}
+
+inline void sortEntries(std::vector<Entry>& entries) {
+    struct Bucket {
+        size_t begin;
+        size_t end;
+        size_t depth;
+    };
+
+    // Buckets are processed from an explicit stack rather than by recursion, since the depth is
+    // bounded only by the length of the longest common prefix.
+    std::vector<Bucket> buckets{{0, entries.size(), 0}};
+    std::vector<Entry> scratch;
+    while (!buckets.empty()) {
+        const Bucket bucket = buckets.back();
+        buckets.pop_back();
+
+        auto first = entries.begin() + bucket.begin;
+        auto last = entries.begin() + bucket.end;
+        const size_t depth = bucket.depth;
+
+        if (bucket.end - bucket.begin < kSmallBucketSize) {
+            std::stable_sort(first, last, [depth](const Entry& lhs, const Entry& rhs) {
+                return StringData(lhs.bytes + depth, lhs.size - depth) <
+                    StringData(rhs.bytes + depth, rhs.size - depth);
+            });
+            continue;
+        }
+
+        std::array<size_t, 257> counts{};
+        for (auto it = first; it != last; ++it) {
+            ++counts[bucketAt(*it, depth)];
+        }
+
+        // If every entry falls into the same bucket there is nothing to distribute. Entries which
+        // all end at 'depth' are equal, and are already in their original order.
+        const size_t commonBucket = bucketAt(*first, depth);
+        if (counts[commonBucket] == bucket.end - bucket.begin) {
+            if (commonBucket != 0) {
+                buckets.push_back({bucket.begin, bucket.end, depth + 1});
+            }
+            continue;
+        }
+
+        // Distribute the entries into 'scratch' in bucket order, keeping the relative order of
+        // entries within a bucket so that the sort is stable.
+        std::array<size_t, 257> offsets;
+        size_t offset = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            offsets[i] = offset;
+            offset += counts[i];
+        }
+        scratch.resize(bucket.end - bucket.begin);
+        for (auto it = first; it != last; ++it) {
+            scratch[offsets[bucketAt(*it, depth)]++] = *it;
+        }
+        std::copy(scratch.begin(), scratch.end(), first);
+
+        size_t begin = bucket.begin + counts[0];
+        for (size_t i = 1; i < counts.size(); ++i) {
+            if (counts[i] > 1) {
+                buckets.push_back({begin, begin + counts[i], depth + 1});
+            }
+            begin += counts[i];
+        }
+    }
+}
+
+}  // namespace radix_sort_detail
+
+/**
+ * Stably sorts the range [begin, end) by the bytes which 'getBytes' returns as a StringData for
+ * each element, in the order of StringData::compare(): bytewise, with a string ordered before the
+ * strings it is a prefix of. The bytes of an element must remain valid until the sort returns.
+ *
+ * This is a most-significant-digit radix sort, which falls back to comparisons for small buckets.
+ * It sorts positions rather than elements, so each element is moved exactly twice.
+ */
+template <typename RandomIt, typename GetBytes>
+void radixSort(RandomIt begin, RandomIt end, GetBytes getBytes) {
+    using radix_sort_detail::Entry;
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+
+    std::vector<Entry> entries;
+    entries.reserve(std::distance(begin, end));
+    for (auto it = begin; it != end; ++it) {
+        const StringData bytes = getBytes(*it);
+        entries.push_back({bytes.rawData(), bytes.size(), entries.size()});
+    }
+
+    radix_sort_detail::sortEntries(entries);
+
+    std::vector<T> sorted;
+    sorted.reserve(entries.size());
+    for (auto&& entry : entries) {
+        sorted.push_back(std::move(begin[entry.index]));
+    }
+    std::move(sorted.begin(), sorted.end(), begin);
+}
+
+}  // namespace sorter
+}  // namespace monger
@@ -0,0 +1,94 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "monger/platform/basic.h"
+
+#include "monger/db/sorter/radix_sort.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "monger/platform/random.h"
+#include "monger/unittest/unittest.h"
+
+namespace monger {
+namespace {
+
+using Item = std::pair<std::string, int>;
+
+void sortAndCheck(std::vector<Item> items) {
+    auto expected = items;
+    std::stable_sort(expected.begin(), expected.end(), [](const Item& lhs, const Item& rhs) {
+        return StringData(lhs.first) < StringData(rhs.first);
+    });
+
+    sorter::radixSort(
+        items.begin(), items.end(), [](const Item& item) { return StringData(item.first); });
+    ASSERT(items == expected);
+}
+
+TEST(RadixSortTest, SortsEmptyRange) {
+    sortAndCheck({});
+}
+
+TEST(RadixSortTest, OrdersPrefixesFirst) {
+    sortAndCheck({{"ab", 0}, {"a", 1}, {"", 2}, {"abc", 3}, {"b", 4}});
+}
+
+TEST(RadixSortTest, OrdersBytesAsUnsigned) {
+    sortAndCheck({{"\xff", 0}, {"\x7f", 1}, {std::string("\0", 1), 2}, {"\x80", 3}});
+}
+
+TEST(RadixSortTest, SortsLargeInputsStably) {
+    PseudoRandom random(1);
+    std::vector<Item> items;
+    for (int i = 0; i < 10000; ++i) {
+        // Few distinct short keys, so that there are many equal keys and shared prefixes.
+        std::string key(random.nextInt32(4), 'a');
+        for (auto&& c : key) {
+            c = 'a' + random.nextInt32(3);
+        }
+        items.emplace_back(std::move(key), i);
+    }
+    sortAndCheck(std::move(items));
+}
+
+TEST(RadixSortTest, SortsLongCommonPrefixes) {
+    const std::string prefix(10000, 'x');
+    std::vector<Item> items;
+    for (int i = 0; i < 1000; ++i) {
+        items.emplace_back(prefix + std::to_string(i % 100), i);
+    }
+    sortAndCheck(std::move(items));
+}
+
+}  // namespace
+}  // namespace monger
@@ -0,0 +1,100 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "monger/platform/basic.h"
+
+#include "monger/db/sorter/sort_key_string.h"
+
+#include <cstring>
+
+#include "monger/db/storage/key_string.h"
+
+namespace monger {
+
+SortKeyString::SortKeyString(const void* data, size_t size) : _size(size) {
+    auto buffer = SharedBuffer::allocate(size);
+    memcpy(buffer.get(), data, size);
+    _buffer = std::move(buffer);
+}
+
+SortKeyString::Pattern::Pattern(const BSONObj& sortPattern) {
+    BSONObjIterator it(sortPattern);
+    do {
+        BSONObjBuilder group;
+        for (size_t i = 0; i < Ordering::kMaxCompoundIndexKeys && it.more(); ++i) {
+            group.append(it.next());
+        }
+        _orderings.push_back(Ordering::make(group.obj()));
+    } while (it.more());
+}
+
+SortKeyString::SortKeyString(const BSONObj& sortKey, const Pattern& pattern, RecordId recordId) {
+    const auto version = KeyString::Version::kLatestVersion;
+
+    if (pattern._orderings.size() == 1) {
+        KeyString keyString(version, sortKey, pattern._orderings[0]);
+        if (recordId.isNormal()) {
+            keyString.appendRecordId(recordId);
+        }
+        *this = SortKeyString(keyString.getBuffer(), keyString.getSize());
+        return;
+    }
+
+    // Encode each group of components separately. Every encoded group is terminated, so no group
+    // is a prefix of another and the concatenation orders like the sequence of groups.
+    BufBuilder buf;
+    BSONObjIterator it(sortKey);
+    for (auto&& ordering : pattern._orderings) {
+        BSONObjBuilder group;
+        for (size_t i = 0; i < Ordering::kMaxCompoundIndexKeys && it.more(); ++i) {
+            group.append(it.next());
+        }
+        KeyString keyString(version, group.obj(), ordering);
+        buf.appendBuf(keyString.getBuffer(), keyString.getSize());
+    }
+    if (recordId.isNormal()) {
+        KeyString keyString(version, recordId);
+        buf.appendBuf(keyString.getBuffer(), keyString.getSize());
+    }
+    *this = SortKeyString(buf.buf(), buf.len());
+}
+
+void SortKeyString::serializeForSorter(BufBuilder& buf) const {
+    buf.appendNum(static_cast<int>(_size));
+    buf.appendBuf(_buffer.get(), _size);
+}
+
+SortKeyString SortKeyString::deserializeForSorter(BufReader& buf,
+                                                  const SorterDeserializeSettings&) {
+    const int size = buf.read<LittleEndian<int>>();
+    return SortKeyString(buf.skip(size), size);
+}
+
+}  // namespace monger
@@ -0,0 +1,114 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <vector>
+
+#include "monger/base/string_data.h"
+#include "monger/bson/ordering.h"
+#include "monger/db/jsobj.h"
+#include "monger/db/record_id.h"
+#include "monger/util/bufreader.h"
+#include "monger/util/shared_buffer.h"
+
+namespace monger {
+
+/**
+ * A sort key encoded in the KeyString format. Encoded keys compare bytewise in the same order as
+ * BSONObj::woCompare() compares the sort keys they were encoded from under the sort pattern, so
+ * sorting them needs neither the pattern nor type-aware comparisons, and can be done with a radix
+ * sort. Copies share the encoded bytes.
+ *
+ * Implements the interface which the Sorter requires of its keys.
+ */
+class SortKeyString {
+public:
+    struct SorterDeserializeSettings {};
+
+    /**
+     * The directions of the components of a sort pattern, which all keys of a sort are encoded
+     * with. Unlike an Ordering, a Pattern is not limited in its number of components.
+     */
+    class Pattern {
+    public:
+        /**
+         * 'sortPattern' has one numeric element per component, which is negative if the component
+         * is sorted in descending order.
+         */
+        explicit Pattern(const BSONObj& sortPattern);
+
+    private:
+        friend class SortKeyString;
+
+        // One Ordering for each group of up to Ordering::kMaxCompoundIndexKeys components.
+        std::vector<Ordering> _orderings;
+    };
+
+    SortKeyString() = default;
+
+    /**
+     * Encodes 'sortKey', an object with one element per component of 'pattern' and empty field
+     * names. If 'recordId' is a normal RecordId, it is appended to order documents with equal sort
+     * keys.
+     */
+    SortKeyString(const BSONObj& sortKey, const Pattern& pattern, RecordId recordId = RecordId());
+
+    StringData getSortBytes() const {
+        return StringData(_buffer.get(), _size);
+    }
+
+    int compare(const SortKeyString& other) const {
+        return getSortBytes().compare(other.getSortBytes());
+    }
+
+    void serializeForSorter(BufBuilder& buf) const;
+    static SortKeyString deserializeForSorter(BufReader& buf, const SorterDeserializeSettings&);
+
+    int memUsageForSorter() const {
+        return sizeof(SortKeyString) + _size;
+    }
+
+    SortKeyString getOwned() const {
+        return *this;
+    }
+
+private:
+    SortKeyString(const void* data, size_t size);
+
+    ConstSharedBuffer _buffer;
+    size_t _size = 0;
+};
+
+inline bool operator<(const SortKeyString& lhs, const SortKeyString& rhs) {
+    return lhs.compare(rhs) < 0;
+}
+
+}  // namespace monger
@@ -0,0 +1,110 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "monger/platform/basic.h"
+
+#include "monger/db/sorter/sort_key_string.h"
+
+#include "monger/unittest/unittest.h"
+
+namespace monger {
+namespace {
+
+int compare(const BSONObj& lhs, const BSONObj& rhs, const BSONObj& pattern) {
+    SortKeyString::Pattern sortKeyPattern(pattern);
+    return SortKeyString(lhs, sortKeyPattern).compare(SortKeyString(rhs, sortKeyPattern));
+}
+
+TEST(SortKeyStringTest, ComparesLikeBSON) {
+    const BSONObj pattern = BSON("a" << 1 << "b" << -1);
+    const std::vector<BSONObj> keys{BSON("" << MINKEY << "" << 1),
+                                    BSON("" << BSONNULL << "" << 1),
+                                    BSON("" << 1 << "" << 2.5),
+                                    BSON("" << 1 << "" << 2),
+                                    BSON("" << 1.5 << "" << 2),
+                                    BSON("" << "abc"
+                                            << ""
+                                            << 1),
+                                    BSON("" << BSON("x" << 1) << "" << 1),
+                                    BSON("" << BSON_ARRAY(1 << 2) << "" << 1),
+                                    BSON("" << MAXKEY << "" << 1)};
+    for (size_t i = 0; i < keys.size(); ++i) {
+        for (size_t j = 0; j < keys.size(); ++j) {
+            const int expected = keys[i].woCompare(keys[j], pattern, false);
+            const int actual = compare(keys[i], keys[j], pattern);
+            ASSERT_EQ(expected < 0, actual < 0) << keys[i] << " " << keys[j];
+            ASSERT_EQ(expected == 0, actual == 0) << keys[i] << " " << keys[j];
+        }
+    }
+}
+
+TEST(SortKeyStringTest, EqualNumbersOfDifferentTypesCompareEqual) {
+    const BSONObj pattern = BSON("a" << 1);
+    ASSERT_EQ(0, compare(BSON("" << 1), BSON("" << 1.0), pattern));
+    ASSERT_EQ(0, compare(BSON("" << 1), BSON("" << 1LL), pattern));
+}
+
+TEST(SortKeyStringTest, RecordIdBreaksTies) {
+    SortKeyString::Pattern pattern(BSON("a" << -1));
+    SortKeyString first(BSON("" << 5), pattern, RecordId(1));
+    SortKeyString second(BSON("" << 5), pattern, RecordId(200000));
+    SortKeyString smaller(BSON("" << 4), pattern, RecordId(1));
+    ASSERT_LT(first.compare(second), 0);
+    ASSERT_LT(second.compare(smaller), 0);
+}
+
+TEST(SortKeyStringTest, SupportsPatternsWithManyComponents) {
+    BSONObjBuilder pattern;
+    BSONObjBuilder lhs;
+    BSONObjBuilder rhs;
+    for (int i = 0; i < 40; ++i) {
+        pattern.append(std::to_string(i), i % 2 ? -1 : 1);
+        lhs.append("", 1);
+        rhs.append("", i == 35 ? 2 : 1);
+    }
+
+    // Component 35 is descending, so the larger value sorts first.
+    ASSERT_GT(compare(lhs.obj(), rhs.obj(), pattern.obj()), 0);
+}
+
+TEST(SortKeyStringTest, RoundTripsThroughSorterSerialization) {
+    SortKeyString key(BSON("" << "abc"), SortKeyString::Pattern(BSON("a" << 1)), RecordId(7));
+
+    BufBuilder buf;
+    key.serializeForSorter(buf);
+    BufReader reader(buf.buf(), buf.len());
+    auto deserialized = SortKeyString::deserializeForSorter(reader, {});
+
+    ASSERT_EQ(0, key.compare(deserialized));
+    ASSERT(reader.atEof());
+}
+
+}  // namespace
+}  // namespace monger
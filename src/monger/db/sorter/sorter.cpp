@@ -56,6 +56,7 @@
 #include "monger/config.h"
 #include "monger/db/jsobj.h"
 #include "monger/db/service_context.h"
+#include "monger/db/sorter/radix_sort.h"
 #include "monger/db/storage/encryption_hooks.h"
 #include "monger/db/storage/storage_options.h"
 #include "monger/platform/atomic_word.h"
@@ -104,6 +105,22 @@ void dassertCompIsSane(const Comparator& comp, const Data& lhs, const Data& rhs)
 #endif
 }
 
+/**
+ * Sorts the in-memory data of a Sorter stably, using 'less' to compare pairs.
+ */
+template <typename RandomIt, typename Comparator, typename Less>
+void sortInMemory(RandomIt begin, RandomIt end, const Comparator& comp, const Less& less) {
+    std::stable_sort(begin, end, less);
+}
+
+/**
+ * Pairs which are ordered by the bytes of their keys are radix sorted.
+ */
+template <typename RandomIt, typename Less>
+void sortInMemory(RandomIt begin, RandomIt end, const SortKeyBytesComparator& comp, const Less&) {
+    radixSort(begin, end, [](const auto& data) { return data.first.getSortBytes(); });
+}
+
 /**
  * Returns results from sorted in-memory storage.
  */
@@ -520,6 +537,10 @@ public:
         return mergeIt;
     }
 
+    size_t memUsed() const override {
+        return _memUsed;
+    }
+
 private:
     class STLComparator {
     public:
@@ -535,14 +556,10 @@ private:
 
     void sort() {
         STLComparator less(_comp);
-        std::stable_sort(_data.begin(), _data.end(), less);
-
-        // Does 2x more compares than stable_sort
-        // TODO test on windows
-        // std::sort(_data.begin(), _data.end(), comp);
+        sortInMemory(_data.begin(), _data.end(), _comp, less);
     }
 
-    void spill() {
+    void spill() override {
         invariant(!_done);
 
         this->_usedDisk = true;
@@ -623,6 +640,12 @@ public:
         }
     }
 
+    size_t memUsed() const override {
+        return _haveData ? _best.first.memUsageForSorter() + _best.second.memUsageForSorter() : 0;
+    }
+
+    void spill() override {}
+
 private:
     const Comparator _comp;
     Data _best;
@@ -729,6 +752,10 @@ public:
         return iterator;
     }
 
+    size_t memUsed() const override {
+        return _memUsed;
+    }
+
 private:
     class STLComparator {
     public:
@@ -748,7 +775,7 @@ private:
         if (_data.size() == _opts.limit) {
             std::sort_heap(_data.begin(), _data.end(), less);
         } else {
-            std::stable_sort(_data.begin(), _data.end(), less);
+            sortInMemory(_data.begin(), _data.end(), _comp, less);
         }
     }
 
@@ -830,7 +857,7 @@ private:
         }
     }
 
-    void spill() {
+    void spill() override {
         invariant(!_done);
 
         this->_usedDisk = true;
@@ -36,6 +36,7 @@
 #include <utility>
 #include <vector>
 
+#include "monger/base/string_data.h"
 #include "monger/bson/util/builder.h"
 
 /**
@@ -81,6 +82,14 @@
  *     }
  *     Ordering _ord;
  * };
+ *
+ * Keys which are ordered by their bytes alone can instead provide
+ *
+ * // The bytes which order this key, compared with memcmp() semantics.
+ * StringData getSortBytes() const;
+ *
+ * and be sorted with SortKeyBytesComparator, which lets the Sorter radix sort its in-memory data
+ * rather than compare pairs.
  */
 
 namespace monger {
@@ -128,6 +137,18 @@ struct SortOptions {
     }
 };
 
+/**
+ * Orders pairs by the bytes of their keys, as returned by Key::getSortBytes(). Pairs with equal
+ * keys keep the order in which they were added.
+ */
+class SortKeyBytesComparator {
+public:
+    template <typename Data>
+    int operator()(const Data& lhs, const Data& rhs) const {
+        return lhs.first.getSortBytes().compare(rhs.first.getSortBytes());
+    }
+};
+
 /**
  * This is the sorted output iterator from the sorting framework.
  */
@@ -205,6 +226,18 @@ public:
 
     virtual ~Sorter() {}
 
+    /**
+     * Returns the approximate number of bytes of data held in memory, which is written to disk once
+     * it exceeds the 'maxMemoryUsageBytes' of the SortOptions.
+     */
+    virtual size_t memUsed() const = 0;
+
+    /**
+     * Writes the data held in memory to disk before reaching 'maxMemoryUsageBytes', e.g. to free
+     * memory needed by the rest of the operation. Throws if external sorting is not allowed.
+     */
+    virtual void spill() = 0;
+
     bool usedDisk() {
         return _usedDisk;
     }
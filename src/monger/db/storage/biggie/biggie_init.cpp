@@ -29,9 +29,13 @@
 
 #include "monger/platform/basic.h"
 
+#include <boost/filesystem/path.hpp>
+
 #include "monger/base/init.h"
 #include "monger/db/service_context.h"
 #include "monger/db/storage/biggie/biggie_kv_engine.h"
+#include "monger/db/storage/biggie/biggie_parameters_gen.h"
+#include "monger/db/storage/biggie/biggie_server_status.h"
 #include "monger/db/storage/storage_engine_impl.h"
 #include "monger/db/storage/storage_engine_init.h"
 #include "monger/db/storage/storage_options.h"
@@ -47,7 +51,12 @@ public:
         StorageEngineOptions options;
         options.directoryPerDB = params.directoryperdb;
         options.forRepair = params.repair;
-        return new StorageEngineImpl(new KVEngine(), options);
+        auto engine = gBiggieEnableDurability
+            ? new KVEngine((boost::filesystem::path(params.dbpath) / "biggie").string())
+            : new KVEngine();
+        // Intentionally leaked.
+        new BiggieServerStatusSection(engine);
+        return new StorageEngineImpl(engine, options);
     }
 
     virtual StringData getCanonicalName() const {
@@ -0,0 +1,512 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::monger::logger::LogComponent::kStorage
+
+#include "monger/platform/basic.h"
+
+#include "monger/db/storage/biggie/biggie_journal.h"
+
+#include <algorithm>
+#include <boost/filesystem/operations.hpp>
+#include <cstring>
+
+#include "monger/base/data_view.h"
+#include "monger/db/storage/storage_file_util.h"
+#include "monger/util/assert_util.h"
+#include "monger/util/bufreader.h"
+#include "monger/util/checksum.h"
+#include "monger/util/log.h"
+
+namespace monger {
+namespace biggie {
+namespace {
+
+namespace fs = boost::filesystem;
+
+const char kCheckpointFileName[] = "checkpoint";
+const char kCheckpointTempFileName[] = "checkpoint.tmp";
+const char kJournalFilePrefix[] = "journal.";
+
+// Checkpoint data blocks are cut once their payload reaches this size.
+const size_t kCheckpointBlockBytes = 1024 * 1024;
+
+/**
+ * Both journal records and checkpoint blocks are framed as a little-endian uint32 payload length,
+ * a checksum of the payload and the payload itself. Every payload starts with its type.
+ */
+const size_t kBlockHeaderBytes = sizeof(uint32_t) + sizeof(Checksum);
+
+enum class BlockType : char {
+    kCommit = 1,
+    kCreateIdent = 2,
+    kDropIdent = 3,
+    kCheckpointHeader = 4,
+    kCheckpointData = 5,
+    kCheckpointEnd = 6,
+};
+
+void appendBlock(std::string* out, StringData payload) {
+    char header[kBlockHeaderBytes];
+    DataView(header).write<LittleEndian<uint32_t>>(payload.size());
+    Checksum checksum;
+    checksum.gen(payload.rawData(), payload.size());
+    std::memcpy(header + sizeof(uint32_t), checksum.bytes, sizeof(checksum.bytes));
+    out->append(header, sizeof(header));
+    out->append(payload.rawData(), payload.size());
+}
+
+/**
+ * Reads the block starting at '*offset' into 'payload' and advances '*offset' past it. Returns
+ * false if the block is truncated or its checksum does not match.
+ */
+bool readBlock(File* file, fileofs fileLength, fileofs* offset, std::string* payload) {
+    if (fileLength - *offset < kBlockHeaderBytes)
+        return false;
+
+    char header[kBlockHeaderBytes];
+    file->read(*offset, header, sizeof(header));
+    const uint32_t length = ConstDataView(header).read<LittleEndian<uint32_t>>();
+    if (file->bad() || length == 0 || fileLength - *offset - kBlockHeaderBytes < length)
+        return false;
+
+    payload->resize(length);
+    file->read(*offset + kBlockHeaderBytes, &(*payload)[0], length);
+
+    Checksum expected;
+    std::memcpy(expected.bytes, header + sizeof(uint32_t), sizeof(expected.bytes));
+    Checksum actual;
+    actual.gen(payload->data(), length);
+    if (file->bad() || actual != expected)
+        return false;
+
+    *offset += kBlockHeaderBytes + length;
+    return true;
+}
+
+// Records are built in a std::string rather than a BufBuilder, which is limited to 64MB while a
+// single unit of work can change far more than that.
+template <typename T>
+void appendNumber(std::string* out, T value) {
+    char buf[sizeof(T)];
+    DataView(buf).write<LittleEndian<T>>(value);
+    out->append(buf, sizeof(buf));
+}
+
+void appendString(std::string* out, StringData str) {
+    appendNumber<uint32_t>(out, str.size());
+    out->append(str.rawData(), str.size());
+}
+
+StringData readString(BufReader* reader) {
+    const uint32_t length = reader->read<LittleEndian<uint32_t>>();
+    return StringData(static_cast<const char*>(reader->skip(length)), length);
+}
+
+void upsert(StringStore* store, StringData key, StringData value) {
+    if (!store->update(StringStore::value_type(key.toString(), value.toString())).second)
+        store->insert(StringStore::value_type(key.toString(), value.toString()));
+}
+
+/**
+ * Returns the numbers of the journal files in 'path', in increasing order.
+ */
+std::vector<uint64_t> listJournalFiles(const std::string& path) {
+    std::vector<uint64_t> fileNumbers;
+    for (fs::directory_iterator it(path), end; it != end; ++it) {
+        const std::string name = it->path().filename().string();
+        const size_t prefixLength = std::strlen(kJournalFilePrefix);
+        if (name.compare(0, prefixLength, kJournalFilePrefix) != 0 || name.size() == prefixLength ||
+            name.find_first_not_of("0123456789", prefixLength) != std::string::npos)
+            continue;
+        fileNumbers.push_back(std::stoull(name.substr(prefixLength)));
+    }
+    std::sort(fileNumbers.begin(), fileNumbers.end());
+    return fileNumbers;
+}
+
+/**
+ * Loads the checkpoint file at 'path' and returns the LSN it was taken at. A checkpoint is only
+ * put in place once it has been completely written, so one that fails to load is fatal.
+ */
+uint64_t loadCheckpoint(const fs::path& path,
+                        StringStore* store,
+                        std::map<std::string, bool>* idents) {
+    File file;
+    file.open(path.string().c_str(), true /* readOnly */);
+    fassert(51240, !file.bad());
+
+    const fileofs fileLength = file.len();
+    fileofs offset = 0;
+    std::string payload;
+    uint64_t lsn = 0;
+    uint64_t numEntries = 0;
+    bool sawHeader = false;
+    while (readBlock(&file, fileLength, &offset, &payload)) {
+        BufReader reader(payload.data(), payload.size());
+        const auto type = static_cast<BlockType>(reader.read<char>());
+        if (type == BlockType::kCheckpointHeader && !sawHeader) {
+            sawHeader = true;
+            lsn = reader.read<LittleEndian<uint64_t>>();
+            const uint32_t numIdents = reader.read<LittleEndian<uint32_t>>();
+            for (uint32_t i = 0; i < numIdents; ++i) {
+                const bool isRecordStore = reader.read<char>();
+                (*idents)[readString(&reader).toString()] = isRecordStore;
+            }
+        } else if (type == BlockType::kCheckpointData && sawHeader) {
+            while (!reader.atEof()) {
+                StringData key = readString(&reader);
+                StringData value = readString(&reader);
+                store->insert(StringStore::value_type(key.toString(), value.toString()));
+                ++numEntries;
+            }
+        } else if (type == BlockType::kCheckpointEnd && sawHeader &&
+                   reader.read<LittleEndian<uint64_t>>() == numEntries && offset == fileLength) {
+            log() << "Loaded biggie checkpoint at journal LSN " << lsn << " with " << numEntries
+                  << " entries";
+            return lsn;
+        } else {
+            break;
+        }
+    }
+
+    severe() << "The biggie checkpoint " << path.string() << " is corrupt at offset " << offset;
+    fassertFailedNoTrace(51241);
+}
+
+}  // namespace
+
+Journal::Journal(std::string path) : _path(std::move(path)) {}
+
+Journal::~Journal() = default;
+
+std::string Journal::_fileName(uint64_t fileNumber) const {
+    return (fs::path(_path) / (kJournalFilePrefix + std::to_string(fileNumber))).string();
+}
+
+void Journal::recover(StringStore* store, std::map<std::string, bool>* idents) {
+    invariant(!_file);
+    fs::create_directories(_path);
+
+    uint64_t lsn = 0;
+    const fs::path checkpointPath = fs::path(_path) / kCheckpointFileName;
+    if (fs::exists(checkpointPath))
+        lsn = loadCheckpoint(checkpointPath, store, idents);
+
+    // Records at or below the checkpoint LSN are already reflected in the checkpoint. The rest
+    // must continue the LSN sequence without gaps; anything past the first record that does not
+    // is the torn tail of the journal, which is cut off so that later appends follow the last
+    // good record.
+    const std::vector<uint64_t> fileNumbers = listJournalFiles(_path);
+    uint64_t numReplayed = 0;
+    bool reachedEnd = false;
+    for (uint64_t fileNumber : fileNumbers) {
+        const std::string fileName = _fileName(fileNumber);
+        if (reachedEnd) {
+            warning() << "Removing biggie journal file " << fileName
+                      << " which follows a torn record";
+            fs::remove(fileName);
+            continue;
+        }
+
+        File file;
+        file.open(fileName.c_str());
+        fassert(51242, !file.bad());
+
+        const fileofs fileLength = file.len();
+        fileofs offset = 0;
+        fileofs recordOffset = 0;
+        std::string payload;
+        while (readBlock(&file, fileLength, &offset, &payload)) {
+            BufReader reader(payload.data(), payload.size());
+            const uint64_t recordLsn = reader.read<LittleEndian<uint64_t>>();
+            if (recordLsn > lsn && recordLsn != lsn + 1) {
+                offset = recordOffset;
+                break;
+            }
+
+            if (recordLsn == lsn + 1) {
+                const auto type = static_cast<BlockType>(reader.read<char>());
+                if (type == BlockType::kCommit) {
+                    const uint32_t numChanges = reader.read<LittleEndian<uint32_t>>();
+                    for (uint32_t i = 0; i < numChanges; ++i) {
+                        const bool erased = !reader.read<char>();
+                        StringData key = readString(&reader);
+                        if (erased)
+                            store->erase(key.toString());
+                        else
+                            upsert(store, key, readString(&reader));
+                    }
+                } else if (type == BlockType::kCreateIdent) {
+                    const bool isRecordStore = reader.read<char>();
+                    (*idents)[readString(&reader).toString()] = isRecordStore;
+                } else {
+                    invariant(type == BlockType::kDropIdent);
+                    idents->erase(readString(&reader).toString());
+                }
+                lsn = recordLsn;
+                ++numReplayed;
+            }
+            recordOffset = offset;
+        }
+
+        if (offset != fileLength) {
+            warning() << "Truncating biggie journal file " << fileName << " from " << fileLength
+                      << " to " << offset << " bytes after a torn or out of sequence record";
+            file.truncate(offset);
+            file.fsync();
+            reachedEnd = true;
+        }
+    }
+
+    log() << "Recovered biggie to journal LSN " << lsn << " after replaying " << numReplayed
+          << " journal records";
+
+    _lastAppendedLsn = lsn;
+    _durableLsn = lsn;
+    _fileNumber = fileNumbers.empty() ? 0 : fileNumbers.back() + 1;
+    _file = _openFile(_fileNumber);
+    _fileOffset = 0;
+}
+
+std::shared_ptr<File> Journal::_openFile(uint64_t fileNumber) const {
+    auto file = std::make_shared<File>();
+    file->open(_fileName(fileNumber).c_str());
+    fassert(51243, !file->bad());
+    fassert(51244, fsyncParentDirectory(_fileName(fileNumber)));
+    return file;
+}
+
+uint64_t Journal::logCommit(const std::vector<Change>& changes) {
+    // The LSN at the start of the record is filled in by _append().
+    std::string record(sizeof(uint64_t), '\0');
+    record.push_back(static_cast<char>(BlockType::kCommit));
+    appendNumber<uint32_t>(&record, changes.size());
+    for (const auto& change : changes) {
+        record.push_back(change.second ? 1 : 0);
+        appendString(&record, change.first);
+        if (change.second)
+            appendString(&record, *change.second);
+    }
+    return _append(&record);
+}
+
+uint64_t Journal::logCreateIdent(StringData ident, bool isRecordStore) {
+    std::string record(sizeof(uint64_t), '\0');
+    record.push_back(static_cast<char>(BlockType::kCreateIdent));
+    record.push_back(isRecordStore ? 1 : 0);
+    appendString(&record, ident);
+    return _append(&record);
+}
+
+uint64_t Journal::logDropIdent(StringData ident) {
+    std::string record(sizeof(uint64_t), '\0');
+    record.push_back(static_cast<char>(BlockType::kDropIdent));
+    appendString(&record, ident);
+    return _append(&record);
+}
+
+uint64_t Journal::_append(std::string* record) {
+    stdx::lock_guard<stdx::mutex> lock(_mutex);
+    invariant(_file);
+    const uint64_t lsn = ++_lastAppendedLsn;
+    DataView(&(*record)[0]).write<LittleEndian<uint64_t>>(lsn);
+    appendBlock(&_buffer, *record);
+    return lsn;
+}
+
+uint64_t Journal::getLastAppendedLsn() const {
+    stdx::lock_guard<stdx::mutex> lock(_mutex);
+    return _lastAppendedLsn;
+}
+
+void Journal::waitUntilDurable(uint64_t lsn) {
+    stdx::unique_lock<stdx::mutex> lock(_mutex);
+    while (_durableLsn < lsn) {
+        if (_flushing) {
+            _flushedCond.wait(lock);
+            continue;
+        }
+
+        // Become the leader of this group commit: take everything appended so far and write it
+        // without holding the mutex, so that more records can be appended in the meantime.
+        _flushing = true;
+        lock.unlock();
+
+        uint64_t flushedLsn;
+        {
+            // The token is taken before the buffer, so that every write it covers has been
+            // appended by the time the buffer is flushed.
+            stdx::lock_guard<stdx::mutex> listenerLock(_journalListenerMutex);
+            const JournalListener::Token token = _journalListener->getToken();
+
+            std::string buffer;
+            std::shared_ptr<File> file;
+            fileofs offset;
+            {
+                stdx::lock_guard<stdx::mutex> bufferLock(_mutex);
+                buffer.swap(_buffer);
+                flushedLsn = _lastAppendedLsn;
+                file = _file;
+                offset = _fileOffset;
+                _fileOffset += buffer.size();
+            }
+
+            if (!buffer.empty()) {
+                file->write(offset, buffer.data(), static_cast<unsigned>(buffer.size()));
+                file->fsync();
+            }
+            fassert(51245, !file->bad());
+            _journalListener->onDurable(token);
+        }
+
+        lock.lock();
+        _flushing = false;
+        _durableLsn = flushedLsn;
+        _flushedCond.notify_all();
+    }
+}
+
+void Journal::setJournalListener(JournalListener* jl) {
+    stdx::lock_guard<stdx::mutex> lock(_journalListenerMutex);
+    _journalListener = jl;
+}
+
+void Journal::prepareRotate() {
+    uint64_t fileNumber;
+    {
+        stdx::lock_guard<stdx::mutex> lock(_mutex);
+        if (_nextFile)
+            return;
+        fileNumber = _fileNumber + 1;
+    }
+
+    auto file = _openFile(fileNumber);
+    stdx::lock_guard<stdx::mutex> lock(_mutex);
+    _nextFile = std::move(file);
+}
+
+uint64_t Journal::rotate() {
+    stdx::lock_guard<stdx::mutex> lock(_mutex);
+    invariant(_nextFile);
+
+    // A flush in progress keeps writing to the previous file. The next one starts the new file
+    // with whatever has been appended since, so the journal stays a contiguous sequence of LSNs.
+    _file = std::move(_nextFile);
+    ++_fileNumber;
+    _fileOffset = 0;
+    _checkpointFileNumber = _fileNumber;
+    return _lastAppendedLsn;
+}
+
+Status Journal::checkpoint(const StringStore& store,
+                           const std::map<std::string, bool>& idents,
+                           uint64_t lsn) {
+    const fs::path tempPath = fs::path(_path) / kCheckpointTempFileName;
+    const fs::path checkpointPath = fs::path(_path) / kCheckpointFileName;
+
+    boost::system::error_code ec;
+    fs::remove(tempPath, ec);
+    File file;
+    file.open(tempPath.string().c_str());
+    if (file.bad())
+        return Status(ErrorCodes::FileOpenFailed, "Failed to open " + tempPath.string());
+
+    fileofs offset = 0;
+    std::string block;
+    auto writeBlock = [&](const std::string& payload) {
+        block.clear();
+        appendBlock(&block, payload);
+        file.write(offset, block.data(), static_cast<unsigned>(block.size()));
+        offset += block.size();
+    };
+
+    std::string payload;
+    payload.push_back(static_cast<char>(BlockType::kCheckpointHeader));
+    appendNumber<uint64_t>(&payload, lsn);
+    appendNumber<uint32_t>(&payload, idents.size());
+    for (const auto& ident : idents) {
+        payload.push_back(ident.second ? 1 : 0);
+        appendString(&payload, ident.first);
+    }
+    writeBlock(payload);
+
+    uint64_t numEntries = 0;
+    payload.clear();
+    for (const auto& entry : store) {
+        if (payload.empty())
+            payload.push_back(static_cast<char>(BlockType::kCheckpointData));
+        appendString(&payload, entry.first);
+        appendString(&payload, entry.second);
+        ++numEntries;
+        if (payload.size() >= kCheckpointBlockBytes) {
+            writeBlock(payload);
+            payload.clear();
+        }
+    }
+    if (!payload.empty())
+        writeBlock(payload);
+
+    payload.clear();
+    payload.push_back(static_cast<char>(BlockType::kCheckpointEnd));
+    appendNumber<uint64_t>(&payload, numEntries);
+    writeBlock(payload);
+
+    file.fsync();
+    if (file.bad())
+        return Status(ErrorCodes::FileStreamFailed, "Failed to write " + tempPath.string());
+
+    // Renaming over the previous checkpoint is atomic, so a crash leaves one or the other.
+    fs::rename(tempPath, checkpointPath, ec);
+    if (ec) {
+        return Status(ErrorCodes::FileRenameFailed,
+                      str::stream() << "Failed to rename " << tempPath.string() << " to "
+                                    << checkpointPath.string() << ": " << ec.message());
+    }
+    Status status = fsyncParentDirectory(checkpointPath);
+    if (!status.isOK())
+        return status;
+
+    uint64_t checkpointFileNumber;
+    {
+        stdx::lock_guard<stdx::mutex> lock(_mutex);
+        checkpointFileNumber = _checkpointFileNumber;
+    }
+    for (uint64_t fileNumber : listJournalFiles(_path)) {
+        if (fileNumber < checkpointFileNumber)
+            fs::remove(_fileName(fileNumber), ec);
+    }
+
+    LOG(1) << "Wrote biggie checkpoint at journal LSN " << lsn << " with " << numEntries
+           << " entries";
+    return Status::OK();
+}
+
+}  // namespace biggie
+}  // namespace monger
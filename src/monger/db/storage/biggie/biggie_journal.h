@@ -0,0 +1,170 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "monger/base/status.h"
+#include "monger/base/string_data.h"
+#include "monger/db/storage/biggie/store.h"
+#include "monger/db/storage/journal_listener.h"
+#include "monger/stdx/condition_variable.h"
+#include "monger/stdx/mutex.h"
+#include "monger/util/file.h"
+
+namespace monger {
+namespace biggie {
+
+/**
+ * Makes the contents of a biggie KVEngine survive restarts. Every change committed to the master
+ * tree is appended to a write-ahead journal, and the whole tree is periodically written out as a
+ * checkpoint, after which the journal files that precede it are removed. On startup the last
+ * checkpoint is loaded and the journal records that follow it are replayed on top.
+ *
+ * Appending a record only buffers it in memory. waitUntilDurable() writes and fsyncs everything
+ * appended so far, so concurrent committers waiting on the same fsync share it, and reports each
+ * such group commit to the JournalListener.
+ *
+ * The files live in a single directory:
+ *   checkpoint   - the ident list and every key and value of the tree, as of a journal LSN.
+ *   journal.<n>  - records appended after the checkpoint was taken, in increasing order of <n>.
+ */
+class Journal {
+public:
+    /**
+     * A key changed by a commit, with its new value or boost::none if the key was erased.
+     */
+    using Change = std::pair<std::string, boost::optional<std::string>>;
+
+    explicit Journal(std::string path);
+    ~Journal();
+
+    /**
+     * Loads the last checkpoint into 'store' and 'idents' and replays the journal on top of them.
+     * Replay stops at the first torn or corrupt record, which can only be the unflushed tail of
+     * the last journal file. Must be called exactly once, before anything is appended.
+     */
+    void recover(StringStore* store, std::map<std::string, bool>* idents);
+
+    /**
+     * Append a record and return its LSN. A record is only durable once waitUntilDurable() has
+     * been called with its LSN.
+     */
+    uint64_t logCommit(const std::vector<Change>& changes);
+    uint64_t logCreateIdent(StringData ident, bool isRecordStore);
+    uint64_t logDropIdent(StringData ident);
+
+    /**
+     * Blocks until every record up to and including 'lsn' has been written and fsynced.
+     */
+    void waitUntilDurable(uint64_t lsn);
+
+    /**
+     * Sets the listener told about the writes made durable by each group commit.
+     */
+    void setJournalListener(JournalListener* jl);
+
+    uint64_t getLastAppendedLsn() const;
+
+    /**
+     * Creates the journal file that the next rotate() switches to. This syncs the directory, so it
+     * is done before the caller blocks appends for rotate().
+     */
+    void prepareRotate();
+
+    /**
+     * Switches to the file created by prepareRotate(), returning the LSN of the last record
+     * appended so far. Records which have not been flushed yet are written to the new file, and
+     * skipped on recovery if a checkpoint covers them. Does no I/O, since the caller must prevent
+     * appends between taking the snapshot it will pass to checkpoint() and calling this.
+     */
+    uint64_t rotate();
+
+    /**
+     * Writes 'store' and 'idents', which must reflect exactly the records up to the 'lsn' returned
+     * by the preceding rotate(), as the new checkpoint, then removes the journal files that the
+     * checkpoint supersedes.
+     */
+    Status checkpoint(const StringStore& store,
+                      const std::map<std::string, bool>& idents,
+                      uint64_t lsn);
+
+private:
+    /**
+     * Assigns the next LSN to 'record', whose first eight bytes are reserved for it, and buffers
+     * the record for the next flush.
+     */
+    uint64_t _append(std::string* record);
+
+    /**
+     * Opens journal file 'fileNumber' for appending.
+     */
+    std::shared_ptr<File> _openFile(uint64_t fileNumber) const;
+
+    std::string _fileName(uint64_t fileNumber) const;
+
+    const std::string _path;
+
+    mutable stdx::mutex _mutex;
+    stdx::condition_variable _flushedCond;
+
+    // Records appended since the last flush, framed as they are written to the journal file.
+    std::string _buffer;
+    uint64_t _lastAppendedLsn = 0;
+    uint64_t _durableLsn = 0;
+
+    // Set while a thread writes and fsyncs '_file' with '_mutex' released. Other threads wait on
+    // '_flushedCond' instead of starting a flush of their own.
+    bool _flushing = false;
+
+    // Shared with a flush in progress, which may still be writing to a file that rotate() has
+    // switched away from.
+    std::shared_ptr<File> _file;
+    uint64_t _fileNumber = 0;
+    fileofs _fileOffset = 0;
+
+    // The file created by prepareRotate().
+    std::shared_ptr<File> _nextFile;
+
+    // Protects '_journalListener'. Held by the thread flushing a group commit, from taking the
+    // listener's token until reporting it durable, and acquired before '_mutex'.
+    stdx::mutex _journalListenerMutex;
+    JournalListener* _journalListener = &NoOpJournalListener::instance;
+
+    // Journal files numbered below this are superseded by the next checkpoint.
+    uint64_t _checkpointFileNumber = 0;
+};
+}  // namespace biggie
+}  // namespace monger
@@ -33,6 +33,7 @@
 
 #include "monger/db/storage/biggie/biggie_kv_engine.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "monger/db/index/index_descriptor.h"
@@ -41,10 +42,139 @@
 #include "monger/db/storage/key_string.h"
 #include "monger/db/storage/record_store.h"
 #include "monger/db/storage/sorted_data_interface.h"
+#include "monger/db/storage/storage_options.h"
+#include "monger/util/background.h"
+#include "monger/util/concurrency/idle_thread_block.h"
+#include "monger/util/log.h"
+#include "monger/util/time_support.h"
 
 namespace monger {
 namespace biggie {
 
+/**
+ * Makes the journal durable every 'journalCommitInterval' milliseconds, so that commits which do
+ * not wait for durability reach disk in bounded time, and checkpoints every 'syncdelay' seconds.
+ */
+class KVEngine::JournalThread : public BackgroundJob {
+public:
+    explicit JournalThread(KVEngine* engine)
+        : BackgroundJob(false /* deleteSelf */), _engine(engine) {}
+
+    virtual std::string name() const {
+        return "BiggieJournalThread";
+    }
+
+    virtual void run() {
+        LOG(1) << "starting " << name() << " thread";
+
+        Date_t lastCheckpoint = Date_t::now();
+        while (!_shuttingDown.load()) {
+            _engine->waitUntilDurable();
+
+            const double syncdelay = storageGlobalParams.syncdelay.load();
+            if (syncdelay > 0 &&
+                Date_t::now() - lastCheckpoint >= Milliseconds(static_cast<long long>(
+                                                       syncdelay * 1000))) {
+                _engine->_checkpoint();
+                lastCheckpoint = Date_t::now();
+            }
+
+            MONGO_IDLE_THREAD_BLOCK;
+            sleepmillis(std::max(1, storageGlobalParams.journalCommitIntervalMs.load()));
+        }
+        LOG(1) << "stopping " << name() << " thread";
+    }
+
+    void shutdown() {
+        _shuttingDown.store(true);
+        wait();
+    }
+
+private:
+    KVEngine* const _engine;
+    AtomicWord<bool> _shuttingDown{false};
+};
+
+KVEngine::KVEngine() : monger::KVEngine() {}
+
+KVEngine::KVEngine(const std::string& path)
+    : monger::KVEngine(), _journal(std::make_unique<Journal>(path)) {
+    log() << "Recovering biggie from " << path;
+    _journal->recover(&_master, &_idents);
+    _checkpointLsn = _journal->getLastAppendedLsn();
+
+    _journalThread = std::make_unique<JournalThread>(this);
+    _journalThread->go();
+}
+
+KVEngine::~KVEngine() {
+    if (_journalThread)
+        _journalThread->shutdown();
+}
+
+void KVEngine::cleanShutdown() {
+    if (!_journal)
+        return;
+
+    _journalThread->shutdown();
+    _journalThread.reset();
+    _checkpoint();
+}
+
+void KVEngine::_checkpoint() {
+    if (_journal->getLastAppendedLsn() == _checkpointLsn)
+        return;
+
+    // Whatever has been journaled so far is made durable, and the next journal file created,
+    // before appends are blocked, so that only the switch to that file happens under the locks.
+    waitUntilDurable();
+    _journal->prepareRotate();
+
+    StringStore master;
+    std::map<std::string, bool> idents;
+    uint64_t lsn;
+    {
+        // Appends to the journal happen under one of these locks, so the snapshot reflects
+        // exactly the records up to the LSN returned by rotate().
+        stdx::lock_guard<stdx::mutex> masterLock(_masterLock);
+        stdx::lock_guard<stdx::mutex> identsLock(_identsLock);
+        if (_journal->getLastAppendedLsn() == _checkpointLsn)
+            return;
+        master = _master;
+        idents = _idents;
+        lsn = _journal->rotate();
+    }
+
+    Status status = _journal->checkpoint(master, idents, lsn);
+    if (!status.isOK()) {
+        warning() << "Failed to write biggie checkpoint: " << status;
+        return;
+    }
+    _checkpointLsn = lsn;
+}
+
+void KVEngine::waitUntilDurable() {
+    if (_journal)
+        _journal->waitUntilDurable(_journal->getLastAppendedLsn());
+}
+
+void KVEngine::setJournalListener(monger::JournalListener* jl) {
+    // Without a journal, nothing is ever made durable.
+    if (_journal)
+        _journal->setJournalListener(jl);
+}
+
+void KVEngine::_setIdent(StringData ident, bool isRecordStore) {
+    stdx::lock_guard<stdx::mutex> lock(_identsLock);
+    auto it = _idents.find(ident.toString());
+    if (it != _idents.end() && it->second == isRecordStore)
+        return;
+
+    _idents[ident.toString()] = isRecordStore;
+    if (_journal)
+        _journal->logCreateIdent(ident, isRecordStore);
+}
+
 monger::RecoveryUnit* KVEngine::newRecoveryUnit() {
     return new RecoveryUnit(this, nullptr);
 }
@@ -57,7 +187,7 @@ Status KVEngine::createRecordStore(OperationContext* opCtx,
                                    StringData ns,
                                    StringData ident,
                                    const CollectionOptions& options) {
-    _idents[ident.toString()] = true;
+    _setIdent(ident, true);
     return Status::OK();
 }
 
@@ -65,7 +195,7 @@ std::unique_ptr<monger::RecordStore> KVEngine::makeTemporaryRecordStore(Operatio
                                                                        StringData ident) {
     std::unique_ptr<monger::RecordStore> recordStore =
         std::make_unique<RecordStore>("", ident, false);
-    _idents[ident.toString()] = true;
+    _setIdent(ident, true);
     return recordStore;
 };
 
@@ -89,15 +219,25 @@ std::unique_ptr<monger::RecordStore> KVEngine::getRecordStore(OperationContext*
     } else {
         recordStore = std::make_unique<RecordStore>(ns, ident, options.capped);
     }
-    _idents[ident.toString()] = true;
+    _setIdent(ident, true);
+
+    // The counters of a record store are only kept in memory, so they are rebuilt from the
+    // recovered data.
+    if (_journal)
+        checked_cast<RecordStore*>(recordStore.get())->initializeStats(getMasterInfo().second);
     return recordStore;
 }
 
-bool KVEngine::trySwapMaster(StringStore& newMaster, uint64_t version) {
+bool KVEngine::trySwapMaster(StringStore& newMaster,
+                             uint64_t version,
+                             const std::vector<Journal::Change>& changes) {
     stdx::lock_guard<stdx::mutex> lock(_masterLock);
     invariant(!newMaster.hasBranch() && !_master.hasBranch());
     if (_masterVersion != version)
         return false;
+    // Appending under the lock keeps the journal in the order the commits were applied.
+    if (_journal && !changes.empty())
+        _journal->logCommit(changes);
     _master = newMaster;
     _masterVersion++;
     return true;
@@ -108,33 +248,41 @@ Status KVEngine::createSortedDataInterface(OperationContext* opCtx,
                                            const CollectionOptions& collOptions,
                                            StringData ident,
                                            const IndexDescriptor* desc) {
-    _idents[ident.toString()] = false;
+    _setIdent(ident, false);
     return Status::OK();  // I don't think we actually need to do anything here
 }
 
 std::unique_ptr<monger::SortedDataInterface> KVEngine::getSortedDataInterface(
     OperationContext* opCtx, StringData ident, const IndexDescriptor* desc) {
-    _idents[ident.toString()] = false;
+    _setIdent(ident, false);
     return std::make_unique<SortedDataInterface>(opCtx, ident, desc);
 }
 
 Status KVEngine::dropIdent(OperationContext* opCtx, StringData ident) {
     Status dropStatus = Status::OK();
-    if (_idents.count(ident.toString()) > 0) {
+    boost::optional<bool> isRecordStore;
+    {
+        stdx::lock_guard<stdx::mutex> lock(_identsLock);
+        auto it = _idents.find(ident.toString());
+        if (it != _idents.end())
+            isRecordStore = it->second;
+    }
+    if (isRecordStore) {
         // Check if the ident is a RecordStore or a SortedDataInterface then call the corresponding
         // truncate. A true value in the map means it is a RecordStore, false a SortedDataInterface.
-        if (_idents[ident.toString()] == true) {  // ident is RecordStore.
-            CollectionOptions s;
-            auto rs = getRecordStore(opCtx, ""_sd, ident, s);
-            dropStatus = checked_cast<RecordStore*>(rs.get())
-                             ->truncateWithoutUpdatingCount(opCtx)
-                             .getStatus();
+        if (*isRecordStore) {  // ident is RecordStore.
+            auto rs = std::make_unique<RecordStore>(""_sd, ident, false);
+            dropStatus = rs->truncateWithoutUpdatingCount(opCtx).getStatus();
         } else {  // ident is SortedDataInterface.
             auto sdi =
                 std::make_unique<SortedDataInterface>(Ordering::make(BSONObj()), true, ident);
             dropStatus = sdi->truncate(opCtx);
         }
+
+        stdx::lock_guard<stdx::mutex> lock(_identsLock);
         _idents.erase(ident.toString());
+        if (_journal)
+            _journal->logDropIdent(ident);
     }
     return dropStatus;
 }
@@ -33,6 +33,7 @@
 #include <mutex>
 #include <set>
 
+#include "monger/db/storage/biggie/biggie_journal.h"
 #include "monger/db/storage/biggie/biggie_record_store.h"
 #include "monger/db/storage/biggie/biggie_sorted_impl.h"
 #include "monger/db/storage/biggie/store.h"
@@ -47,9 +48,15 @@ class JournalListener;
  */
 class KVEngine : public monger::KVEngine {
 public:
-    KVEngine() : monger::KVEngine() {}
+    KVEngine();
 
-    virtual ~KVEngine() {}
+    /**
+     * Constructs a durable engine which journals its commits and checkpoints its data in 'path',
+     * recovering whatever was there from a previous run.
+     */
+    explicit KVEngine(const std::string& path);
+
+    virtual ~KVEngine();
 
     virtual monger::RecoveryUnit* newRecoveryUnit();
 
@@ -95,14 +102,14 @@ public:
     }
 
     /**
-     * Biggie does not write to disk.
+     * Biggie only writes to disk when it was constructed with a path.
      */
     virtual bool isDurable() const {
-        return false;
+        return _journal != nullptr;
     }
 
     virtual bool isEphemeral() const {
-        return true;
+        return _journal == nullptr;
     }
 
     virtual int64_t getCacheOverflowTableInsertCount(OperationContext* opCtx) const override {
@@ -124,6 +131,7 @@ public:
     }
 
     std::vector<std::string> getAllIdents(OperationContext* opCtx) const {
+        stdx::lock_guard<stdx::mutex> lock(_identsLock);
         std::vector<std::string> idents;
         for (const auto& i : _idents) {
             idents.push_back(i.first);
@@ -131,9 +139,9 @@ public:
         return idents;
     }
 
-    virtual void cleanShutdown(){};
+    virtual void cleanShutdown();
 
-    void setJournalListener(monger::JournalListener* jl) final {}
+    void setJournalListener(monger::JournalListener* jl) final;
 
     virtual Timestamp getAllCommittedTimestamp() const override {
         RecordId id = _visibilityManager->getAllCommittedRecord();
@@ -160,19 +168,45 @@ public:
 
     /**
      * Returns true and swaps _master to newMaster if the version passed in is the same as the
-     * masters current version.
+     * masters current version. On a durable engine, 'changes' must hold the difference between
+     * the current master and 'newMaster'; they are journaled as part of the swap.
      */
-    bool trySwapMaster(StringStore& newMaster, uint64_t version);
+    bool trySwapMaster(StringStore& newMaster,
+                       uint64_t version,
+                       const std::vector<Journal::Change>& changes = {});
+
+    /**
+     * Blocks until every commit that has swapped the master so far is on disk.
+     */
+    void waitUntilDurable();
 
 private:
+    class JournalThread;
+
+    void _setIdent(StringData ident, bool isRecordStore);
+
+    /**
+     * Writes the current master as a checkpoint, unless nothing was journaled since the last one.
+     */
+    void _checkpoint();
+
     std::shared_ptr<void> _catalogInfo;
     int _cachePressureForTest = 0;
+
+    mutable stdx::mutex _identsLock;
     std::map<std::string, bool> _idents;  // TODO : replace with a query to _master.
+
     std::unique_ptr<VisibilityManager> _visibilityManager;
 
+    // Acquired before '_identsLock' when both are needed.
     mutable stdx::mutex _masterLock;
     StringStore _master;
     uint64_t _masterVersion = 0;
+
+    // Only set on a durable engine.
+    std::unique_ptr<Journal> _journal;
+    std::unique_ptr<JournalThread> _journalThread;
+    uint64_t _checkpointLsn = 0;
 };
 }  // namespace biggie
 }  // namespace monger
@@ -34,9 +34,15 @@
 #include <memory>
 
 #include "monger/base/init.h"
+#include "monger/db/catalog/collection_options.h"
+#include "monger/db/operation_context_noop.h"
 #include "monger/db/service_context.h"
 #include "monger/db/service_context_test_fixture.h"
 #include "monger/db/storage/biggie/biggie_kv_engine.h"
+#include "monger/db/storage/journal_listener.h"
+#include "monger/db/storage/write_unit_of_work.h"
+#include "monger/stdx/mutex.h"
+#include "monger/unittest/temp_dir.h"
 #include "monger/unittest/unittest.h"
 
 namespace monger {
@@ -70,5 +76,137 @@ MONGO_INITIALIZER(RegisterKVHarnessFactory)(InitializerContext*) {
     return Status::OK();
 }
 
+class BiggieDurableKVEngineTest : public unittest::Test, public ScopedGlobalServiceContextForTest {
+protected:
+    std::unique_ptr<OperationContext> makeOperationContext(KVEngine* engine) {
+        return std::make_unique<OperationContextNoop>(engine->newRecoveryUnit());
+    }
+
+    unittest::TempDir _dbpath{"biggie_kv_engine_test"};
+};
+
+TEST_F(BiggieDurableKVEngineTest, RecoversDurableCommitsAfterRestart) {
+    const std::string ns = "a.b";
+    RecordId kept;
+    RecordId deleted;
+    {
+        KVEngine engine(_dbpath.path());
+        ASSERT_TRUE(engine.isDurable());
+
+        auto opCtx = makeOperationContext(&engine);
+        ASSERT_OK(engine.createRecordStore(opCtx.get(), ns, ns, CollectionOptions()));
+        auto rs = engine.getRecordStore(opCtx.get(), ns, ns, CollectionOptions());
+        {
+            WriteUnitOfWork uow(opCtx.get());
+            kept = unittest::assertGet(rs->insertRecord(opCtx.get(), "abc", 4, Timestamp()));
+            deleted = unittest::assertGet(rs->insertRecord(opCtx.get(), "def", 4, Timestamp()));
+            uow.commit();
+        }
+        {
+            WriteUnitOfWork uow(opCtx.get());
+            rs->deleteRecord(opCtx.get(), deleted);
+            uow.commit();
+        }
+
+        // The engine is destroyed without a clean shutdown, so only durable commits survive.
+        ASSERT_TRUE(opCtx->recoveryUnit()->waitUntilDurable());
+    }
+
+    {
+        KVEngine engine(_dbpath.path());
+        auto opCtx = makeOperationContext(&engine);
+        auto idents = engine.getAllIdents(opCtx.get());
+        ASSERT_EQ(1U, idents.size());
+        ASSERT_EQ(ns, idents[0]);
+
+        auto rs = engine.getRecordStore(opCtx.get(), ns, ns, CollectionOptions());
+        ASSERT_EQ(1, rs->numRecords(opCtx.get()));
+        ASSERT_EQ(4, rs->dataSize(opCtx.get()));
+        ASSERT_EQ(std::string("abc"), rs->dataFor(opCtx.get(), kept).data());
+        RecordData data;
+        ASSERT_FALSE(rs->findRecord(opCtx.get(), deleted, &data));
+
+        // Record ids keep increasing past the recovered records.
+        WriteUnitOfWork uow(opCtx.get());
+        RecordId added = unittest::assertGet(rs->insertRecord(opCtx.get(), "ghi", 4, Timestamp()));
+        ASSERT_GT(added, deleted);
+        uow.commit();
+
+        // A clean shutdown checkpoints everything committed, durable or not.
+        engine.cleanShutdown();
+    }
+
+    {
+        KVEngine engine(_dbpath.path());
+        auto opCtx = makeOperationContext(&engine);
+        auto rs = engine.getRecordStore(opCtx.get(), ns, ns, CollectionOptions());
+        ASSERT_EQ(2, rs->numRecords(opCtx.get()));
+
+        {
+            WriteUnitOfWork uow(opCtx.get());
+            ASSERT_OK(engine.dropIdent(opCtx.get(), ns));
+            uow.commit();
+        }
+        ASSERT_TRUE(opCtx->recoveryUnit()->waitUntilDurable());
+    }
+
+    {
+        KVEngine engine(_dbpath.path());
+        auto opCtx = makeOperationContext(&engine);
+        ASSERT_TRUE(engine.getAllIdents(opCtx.get()).empty());
+    }
+}
+
+/**
+ * Hands out increasing tokens and records the last one reported durable. It is called from the
+ * journal thread as well as from the test.
+ */
+class CountingJournalListener : public monger::JournalListener {
+public:
+    Token getToken() override {
+        stdx::lock_guard<stdx::mutex> lock(_mutex);
+        ++_term;
+        return {repl::OpTime(Timestamp(1, _term), _term), Date_t()};
+    }
+
+    void onDurable(const Token& token) override {
+        stdx::lock_guard<stdx::mutex> lock(_mutex);
+        _lastDurable = token;
+    }
+
+    Token lastDurable() {
+        stdx::lock_guard<stdx::mutex> lock(_mutex);
+        return _lastDurable;
+    }
+
+private:
+    stdx::mutex _mutex;
+    unsigned _term = 0;
+    Token _lastDurable;
+};
+
+TEST_F(BiggieDurableKVEngineTest, ReportsGroupCommitsToTheJournalListener) {
+    const std::string ns = "a.b";
+    KVEngine engine(_dbpath.path());
+    CountingJournalListener listener;
+    engine.setJournalListener(&listener);
+
+    auto opCtx = makeOperationContext(&engine);
+    ASSERT_OK(engine.createRecordStore(opCtx.get(), ns, ns, CollectionOptions()));
+    auto rs = engine.getRecordStore(opCtx.get(), ns, ns, CollectionOptions());
+    {
+        WriteUnitOfWork uow(opCtx.get());
+        ASSERT_OK(rs->insertRecord(opCtx.get(), "abc", 4, Timestamp()).getStatus());
+        uow.commit();
+    }
+    ASSERT_TRUE(opCtx->recoveryUnit()->waitUntilDurable());
+
+    // The flush which made the commit durable reported the token it took beforehand.
+    ASSERT_FALSE(listener.lastDurable().opTime.isNull());
+
+    engine.setJournalListener(&NoOpJournalListener::instance);
+    engine.cleanShutdown();
+}
+
 }  // namespace biggie
 }  // namespace monger
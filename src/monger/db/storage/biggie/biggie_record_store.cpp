@@ -358,6 +358,23 @@ void RecordStore::updateStatsAfterRepair(OperationContext* opCtx,
     _dataSize.store(dataSize);
 }
 
+void RecordStore::initializeStats(const StringStore& store) {
+    long long numRecords = 0;
+    long long dataSize = 0;
+    boost::optional<std::string> lastKey;
+    StringStore::const_iterator end = store.upper_bound(_postfix);
+    for (auto it = store.lower_bound(_prefix); it != end; ++it) {
+        ++numRecords;
+        dataSize += it->second.size();
+        lastKey = it->first;
+    }
+
+    _numRecords.store(numRecords);
+    _dataSize.store(dataSize);
+    if (lastKey)
+        _highestRecordId.store(extractRecordId(*lastKey).repr() + 1);
+}
+
 void RecordStore::waitForAllEarlierOplogWritesToBeVisible(OperationContext* opCtx) const {
     _visibilityManager->waitForAllEarlierOplogWritesToBeVisible(opCtx);
 }
@@ -117,6 +117,12 @@ public:
                                         long long numRecords,
                                         long long dataSize);
 
+    /**
+     * Sets the record count, data size and next record id from the records of this store found in
+     * 'store', for a record store opened over data recovered from disk.
+     */
+    void initializeStats(const StringStore& store);
+
 private:
     friend class VisibilityManagerChange;
 
@@ -66,7 +66,18 @@ void RecoveryUnit::commitUnitOfWork() {
                 throw WriteConflictException();
             }
 
-            if (_KVEngine->trySwapMaster(_workingCopy, masterInfo.first)) {
+            // A durable engine journals exactly what this unit of work changes in the master.
+            std::vector<Journal::Change> changes;
+            if (_KVEngine->isDurable()) {
+                _workingCopy.diff(masterInfo.second,
+                                  [&](const std::string& key, const std::string* value) {
+                                      changes.emplace_back(
+                                          key,
+                                          value ? boost::make_optional(*value) : boost::none);
+                                  });
+            }
+
+            if (_KVEngine->trySwapMaster(_workingCopy, masterInfo.first, changes)) {
                 // Merged successfully
                 break;
             } else {
@@ -92,7 +103,8 @@ void RecoveryUnit::abortUnitOfWork() {
 
 bool RecoveryUnit::waitUntilDurable() {
     invariant(!_inUnitOfWork(), toString(_getState()));
-    return true;  // This is an in-memory storage engine.
+    _KVEngine->waitUntilDurable();
+    return true;
 }
 
 void RecoveryUnit::abandonSnapshot() {
@@ -0,0 +1,72 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "monger/platform/basic.h"
+
+#include "monger/db/storage/biggie/biggie_server_status.h"
+
+#include "monger/bson/bsonobjbuilder.h"
+#include "monger/db/storage/biggie/biggie_kv_engine.h"
+#include "monger/db/storage/biggie/store.h"
+
+namespace monger {
+namespace biggie {
+
+BiggieServerStatusSection::BiggieServerStatusSection(KVEngine* engine)
+    : ServerStatusSection("biggie"), _engine(engine) {}
+
+bool BiggieServerStatusSection::includeByDefault() const {
+    return true;
+}
+
+BSONObj BiggieServerStatusSection::generateSection(OperationContext* opCtx,
+                                                   const BSONElement& configElement) const {
+    BSONObjBuilder bob;
+
+    StringStore master = _engine->getMasterInfo().second;
+    bob.appendNumber("records", static_cast<long long>(master.size()));
+    bob.appendNumber("dataSize", static_cast<long long>(master.dataSize()));
+
+    // The nodes are counted across all versions of the tree which are still referenced, including
+    // the snapshots of open transactions.
+    auto& metrics = RadixStoreMetrics::get();
+    {
+        BSONObjBuilder nodes(bob.subobjStart("nodes"));
+        nodes.appendNumber("node4", metrics.node4.load());
+        nodes.appendNumber("node16", metrics.node16.load());
+        nodes.appendNumber("node48", metrics.node48.load());
+        nodes.appendNumber("node256", metrics.node256.load());
+    }
+    bob.appendNumber("childrenBytes", metrics.childrenBytes.load());
+
+    return bob.obj();
+}
+
+}  // namespace biggie
+}  // namespace monger
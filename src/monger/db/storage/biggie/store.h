@@ -29,7 +29,7 @@
 
 #pragma once
 
-#include <array>
+#include <algorithm>
 #include <boost/optional.hpp>
 #include <cstring>
 #include <exception>
@@ -38,6 +38,7 @@
 #include <string.h>
 #include <vector>
 
+#include "monger/platform/atomic_word.h"
 #include "monger/util/assert_util.h"
 
 namespace monger {
@@ -49,6 +50,23 @@ class merge_conflict_exception : std::exception {
     }
 };
 
+/**
+ * Process-wide counts of the nodes of all RadixStores by the layout of their children, and of the
+ * memory used for the children. Reported by the "biggie" serverStatus section.
+ */
+struct RadixStoreMetrics {
+    static RadixStoreMetrics& get() {
+        static RadixStoreMetrics metrics;
+        return metrics;
+    }
+
+    AtomicWord<long long> node4;
+    AtomicWord<long long> node16;
+    AtomicWord<long long> node48;
+    AtomicWord<long long> node256;
+    AtomicWord<long long> childrenBytes;
+};
+
 /**
  * RadixStore is a Trie data structure with the ability to share nodes among copies of trees to
  * minimize data duplication. Each node has a notion of ownership and if modifications are made to
@@ -190,26 +208,16 @@ public:
                 context.pop_back();
 
                 // Check the children right of the node that the iterator was at already. This way,
-                // there will be no backtracking in the traversal.
-                for (auto iter = oldKey + 1 + node->_children.begin();
-                     iter != node->_children.end();
-                     ++iter) {
-
-                    // If the node has a child, then the sub-tree must have a node with data that
-                    // has not yet been visited.
-                    if (*iter != nullptr) {
-
-                        // If the current node has data, return it and exit. If not, continue
-                        // following the nodes to find the next one with data. It is necessary to go
-                        // to the left-most node in this sub-tree.
-                        if ((*iter)->_data) {
-                            _current = iter->get();
-                            return;
-                        }
-                        _current = iter->get();
+                // there will be no backtracking in the traversal. If the node has such a child,
+                // then the sub-tree must have a node with data that has not yet been visited.
+                if (Node* next = node->_children.lowerBound(oldKey + 1)) {
+                    // If the current node has data, return it and exit. If not, continue following
+                    // the nodes to find the next one with data. It is necessary to go to the
+                    // left-most node in this sub-tree.
+                    _current = next;
+                    if (!_current->_data)
                         _traverseLeftSubtree();
-                        return;
-                    }
+                    return;
                 }
             }
             return;
@@ -220,12 +228,7 @@ public:
             // '_current' is root. However, it cannot return the root, and hence at least 1
             // iteration of the while loop is required.
             do {
-                for (auto child : _current->_children) {
-                    if (child != nullptr) {
-                        _current = child.get();
-                        break;
-                    }
-                }
+                _current = _current->_children.lowerBound(0);
             } while (!_current->_data);
         }
 
@@ -399,14 +402,12 @@ public:
 
                 // After moving up in the tree, continue searching for neighboring nodes to see if
                 // they have data, moving from right to left.
-                for (int i = oldKey - 1; i >= 0; i--) {
-                    if (node->_children[i] != nullptr) {
-                        // If there is a sub-tree found, it must have data, therefore it's necessary
-                        // to traverse to the right most node.
-                        _current = node->_children[i].get();
-                        _traverseRightSubtree();
-                        return;
-                    }
+                if (Node* prev = node->_children.lastBefore(oldKey)) {
+                    // If there is a sub-tree found, it must have data, therefore it's necessary to
+                    // traverse to the right most node.
+                    _current = prev;
+                    _traverseRightSubtree();
+                    return;
                 }
 
                 // If there were no sub-trees that contained data, and the 'current' node has data,
@@ -421,15 +422,9 @@ public:
         void _traverseRightSubtree() {
             // This function traverses the given tree to the right most leaf of the subtree where
             // 'current' is the root.
-            do {
-                for (auto iter = _current->_children.rbegin(); iter != _current->_children.rend();
-                     ++iter) {
-                    if (*iter != nullptr) {
-                        _current = iter->get();
-                        break;
-                    }
-                }
-            } while (!_current->isLeaf());
+            while (!_current->isLeaf()) {
+                _current = _current->_children.lastBefore(256);
+            }
         }
 
         void updateTreeView(bool stopIfMultipleCursors = false) {
@@ -610,7 +605,7 @@ public:
 
             uint8_t childFirstChar = child->_trieKey.front();
             if (!isUniquelyOwned) {
-                parent->_children[childFirstChar] = std::make_shared<Node>(*child);
+                parent->_children.set(childFirstChar, std::make_shared<Node>(*child));
                 child = parent->_children[childFirstChar].get();
             }
 
@@ -618,7 +613,7 @@ public:
         }
 
         // Handle the deleted node, as it is a leaf.
-        parent->_children[deleted->_trieKey.front()] = nullptr;
+        parent->_children.set(deleted->_trieKey.front(), nullptr);
 
         // 'parent' may only have one child, in which case we need to evaluate whether or not
         // this node is redundant.
@@ -641,6 +636,17 @@ public:
         _root->_dataSize = other._root->_dataSize + deltaDataSize;
     }
 
+    /**
+     * Calls 'func(key, value)' for every key whose value differs between 'base' and this tree,
+     * with a null 'value' for keys that are only present in 'base'. Subtrees that both trees still
+     * share are skipped, so the cost is proportional to the size of the change rather than to the
+     * size of the trees.
+     */
+    template <typename Func>
+    void diff(const RadixStore& base, Func&& func) const {
+        _diffHelper(_root.get(), 0, base._root.get(), 0, func);
+    }
+
     // Iterators
     const_iterator begin() const noexcept {
         if (_root->isLeaf() && !_root->_data)
@@ -734,18 +740,14 @@ public:
             std::tie(node, idx) = context.back();
             context.pop_back();
 
-            for (auto iter = idx + node->_children.begin(); iter != node->_children.end(); ++iter) {
-                if (!(*iter))
-                    continue;
-
+            if (Node* child = node->_children.lowerBound(idx)) {
                 // There exists a node with a key larger than the one given.
-                node = iter->get();
+                node = child;
                 if (node->_data)
                     return const_iterator(_root, node);
 
                 // Need to search this node's children for the next largest node.
                 context.push_back(std::make_pair(node, 0));
-                break;
             }
 
             if (node->_trieKey.empty() && context.empty()) {
@@ -783,6 +785,362 @@ public:
     }
 
 private:
+    /**
+     * The children of a node, keyed by the first byte of their trie keys. As in an adaptive radix
+     * tree, the layout grows and shrinks with the number of children: up to 4 or 16 children are
+     * kept in sorted arrays, up to 48 behind a 256 byte index, and beyond that in a direct array.
+     * Sparse levels do not pay for 256 pointers, and copying a node on write only copies the
+     * children it has.
+     */
+    class Children {
+    public:
+        enum class Layout : uint8_t { kNode4, kNode16, kNode48, kNode256 };
+
+        Children() {
+            _initLayout();
+            _track(1);
+        }
+
+        Children(const Children& other) : _layout(other._layout) {
+            _copyFrom(other);
+            _track(1);
+        }
+
+        Children(Children&& other) : Children() {
+            swap(*this, other);
+        }
+
+        ~Children() {
+            _track(-1);
+        }
+
+        friend void swap(Children& first, Children& second) {
+            first._track(-1);
+            second._track(-1);
+            std::swap(first._layout, second._layout);
+            std::swap(first._count, second._count);
+            std::swap(first._keys, second._keys);
+            std::swap(first._slots, second._slots);
+            first._track(1);
+            second._track(1);
+        }
+
+        Children& operator=(const Children& other) {
+            if (this != &other) {
+                _track(-1);
+                _layout = other._layout;
+                _copyFrom(other);
+                _track(1);
+            }
+            return *this;
+        }
+
+        Children& operator=(Children&& other) {
+            swap(*this, other);
+            return *this;
+        }
+
+        bool empty() const {
+            return _count == 0;
+        }
+
+        size_t size() const {
+            return _count;
+        }
+
+        Layout layout() const {
+            return _layout;
+        }
+
+        /**
+         * Returns the child whose trie key starts with 'key', or a null pointer.
+         */
+        const std::shared_ptr<Node>& operator[](uint8_t key) const {
+            switch (_layout) {
+                case Layout::kNode4:
+                case Layout::kNode16:
+                    for (size_t i = 0; i < _keys.size() && _keys[i] <= key; ++i) {
+                        if (_keys[i] == key)
+                            return _slots[i];
+                    }
+                    return _null();
+                case Layout::kNode48:
+                    return _keys[key] ? _slots[_keys[key] - 1] : _null();
+                case Layout::kNode256:
+                    return _slots[key];
+            }
+            MONGO_UNREACHABLE;
+        }
+
+        /**
+         * Sets the child whose trie key starts with 'key'. A null 'child' removes it.
+         */
+        void set(uint8_t key, std::shared_ptr<Node> child) {
+            if (!child) {
+                _erase(key);
+                return;
+            }
+
+            if (std::shared_ptr<Node>* slot = _find(key)) {
+                *slot = std::move(child);
+                return;
+            }
+
+            if (_count == _capacity(_layout))
+                _relayout(static_cast<Layout>(static_cast<uint8_t>(_layout) + 1));
+            _insert(key, std::move(child));
+        }
+
+        /**
+         * Returns the child with the smallest key that is at least 'from', or nullptr if there is
+         * none.
+         */
+        Node* lowerBound(unsigned from) const {
+            switch (_layout) {
+                case Layout::kNode4:
+                case Layout::kNode16: {
+                    auto it = std::lower_bound(_keys.begin(), _keys.end(), from);
+                    return it == _keys.end() ? nullptr : _slots[it - _keys.begin()].get();
+                }
+                case Layout::kNode48:
+                    for (unsigned key = from; key < 256; ++key) {
+                        if (_keys[key])
+                            return _slots[_keys[key] - 1].get();
+                    }
+                    return nullptr;
+                case Layout::kNode256:
+                    for (unsigned key = from; key < 256; ++key) {
+                        if (_slots[key])
+                            return _slots[key].get();
+                    }
+                    return nullptr;
+            }
+            MONGO_UNREACHABLE;
+        }
+
+        /**
+         * Returns the child with the largest key that is less than 'before', or nullptr if there
+         * is none.
+         */
+        Node* lastBefore(unsigned before) const {
+            switch (_layout) {
+                case Layout::kNode4:
+                case Layout::kNode16: {
+                    auto it = std::lower_bound(_keys.begin(), _keys.end(), before);
+                    return it == _keys.begin() ? nullptr : _slots[it - _keys.begin() - 1].get();
+                }
+                case Layout::kNode48:
+                    for (unsigned key = before; key-- > 0;) {
+                        if (_keys[key])
+                            return _slots[_keys[key] - 1].get();
+                    }
+                    return nullptr;
+                case Layout::kNode256:
+                    for (unsigned key = before; key-- > 0;) {
+                        if (_slots[key])
+                            return _slots[key].get();
+                    }
+                    return nullptr;
+            }
+            MONGO_UNREACHABLE;
+        }
+
+        /**
+         * Calls 'func' with the key and pointer of every child, in key order.
+         */
+        template <typename Func>
+        void forEach(Func&& func) const {
+            switch (_layout) {
+                case Layout::kNode4:
+                case Layout::kNode16:
+                    for (size_t i = 0; i < _keys.size(); ++i) {
+                        func(_keys[i], _slots[i]);
+                    }
+                    return;
+                case Layout::kNode48:
+                    for (unsigned key = 0; key < 256; ++key) {
+                        if (_keys[key])
+                            func(static_cast<uint8_t>(key), _slots[_keys[key] - 1]);
+                    }
+                    return;
+                case Layout::kNode256:
+                    for (unsigned key = 0; key < 256; ++key) {
+                        if (_slots[key])
+                            func(static_cast<uint8_t>(key), _slots[key]);
+                    }
+                    return;
+            }
+        }
+
+    private:
+        static const std::shared_ptr<Node>& _null() {
+            static const std::shared_ptr<Node> null;
+            return null;
+        }
+
+        static size_t _capacity(Layout layout) {
+            switch (layout) {
+                case Layout::kNode4:
+                    return 4;
+                case Layout::kNode16:
+                    return 16;
+                case Layout::kNode48:
+                    return 48;
+                case Layout::kNode256:
+                    return 256;
+            }
+            MONGO_UNREACHABLE;
+        }
+
+        std::shared_ptr<Node>* _find(uint8_t key) {
+            const auto& slot = static_cast<const Children&>(*this)[key];
+            return slot ? const_cast<std::shared_ptr<Node>*>(&slot) : nullptr;
+        }
+
+        void _initLayout() {
+            switch (_layout) {
+                case Layout::kNode4:
+                case Layout::kNode16:
+                    _keys.reserve(_capacity(_layout));
+                    _slots.reserve(_capacity(_layout));
+                    break;
+                case Layout::kNode48:
+                    _keys.assign(256, 0);
+                    _slots.reserve(_capacity(_layout));
+                    break;
+                case Layout::kNode256:
+                    _slots.resize(256);
+                    break;
+            }
+        }
+
+        void _copyFrom(const Children& other) {
+            _count = other._count;
+            _keys.clear();
+            _slots.clear();
+            _keys.shrink_to_fit();
+            _slots.shrink_to_fit();
+            _initLayout();
+            _keys.assign(other._keys.begin(), other._keys.end());
+            _slots.assign(other._slots.begin(), other._slots.end());
+        }
+
+        /**
+         * Adds a child for a key which has none. The layout must have room for it.
+         */
+        void _insert(uint8_t key, std::shared_ptr<Node> child) {
+            switch (_layout) {
+                case Layout::kNode4:
+                case Layout::kNode16: {
+                    auto it = std::lower_bound(_keys.begin(), _keys.end(), key);
+                    _slots.insert(_slots.begin() + (it - _keys.begin()), std::move(child));
+                    _keys.insert(it, key);
+                    break;
+                }
+                case Layout::kNode48: {
+                    size_t slot = 0;
+                    while (slot < _slots.size() && _slots[slot])
+                        ++slot;
+                    if (slot == _slots.size()) {
+                        _slots.push_back(std::move(child));
+                    } else {
+                        _slots[slot] = std::move(child);
+                    }
+                    _keys[key] = slot + 1;
+                    break;
+                }
+                case Layout::kNode256:
+                    _slots[key] = std::move(child);
+                    break;
+            }
+            ++_count;
+        }
+
+        void _erase(uint8_t key) {
+            switch (_layout) {
+                case Layout::kNode4:
+                case Layout::kNode16: {
+                    auto it = std::lower_bound(_keys.begin(), _keys.end(), key);
+                    if (it == _keys.end() || *it != key)
+                        return;
+                    _slots.erase(_slots.begin() + (it - _keys.begin()));
+                    _keys.erase(it);
+                    break;
+                }
+                case Layout::kNode48:
+                    if (!_keys[key])
+                        return;
+                    _slots[_keys[key] - 1].reset();
+                    _keys[key] = 0;
+                    break;
+                case Layout::kNode256:
+                    if (!_slots[key])
+                        return;
+                    _slots[key].reset();
+                    break;
+            }
+            --_count;
+
+            // Shrink once the children fit in the smaller layout with room to spare, so that a
+            // node does not change layouts back and forth on every insert and erase.
+            if (_layout != Layout::kNode4 &&
+                _count < _capacity(static_cast<Layout>(static_cast<uint8_t>(_layout) - 1)) * 3 / 4)
+                _relayout(static_cast<Layout>(static_cast<uint8_t>(_layout) - 1));
+        }
+
+        void _relayout(Layout layout) {
+            std::vector<std::pair<uint8_t, std::shared_ptr<Node>>> children;
+            children.reserve(_count);
+            forEach([&](uint8_t key, const std::shared_ptr<Node>& child) {
+                children.emplace_back(key, child);
+            });
+
+            _track(-1);
+            _layout = layout;
+            _count = 0;
+            std::vector<uint8_t>().swap(_keys);
+            std::vector<std::shared_ptr<Node>>().swap(_slots);
+            _initLayout();
+            for (auto& child : children) {
+                _insert(child.first, std::move(child.second));
+            }
+            _track(1);
+        }
+
+        void _track(int sign) const {
+            auto& metrics = RadixStoreMetrics::get();
+            switch (_layout) {
+                case Layout::kNode4:
+                    metrics.node4.fetchAndAdd(sign);
+                    break;
+                case Layout::kNode16:
+                    metrics.node16.fetchAndAdd(sign);
+                    break;
+                case Layout::kNode48:
+                    metrics.node48.fetchAndAdd(sign);
+                    break;
+                case Layout::kNode256:
+                    metrics.node256.fetchAndAdd(sign);
+                    break;
+            }
+            metrics.childrenBytes.fetchAndAdd(
+                sign *
+                static_cast<long long>(_keys.capacity() +
+                                       _slots.capacity() * sizeof(std::shared_ptr<Node>)));
+        }
+
+        Layout _layout = Layout::kNode4;
+        uint16_t _count = 0;
+
+        // The sorted keys of the children for kNode4 and kNode16, or for kNode48 the index into
+        // '_slots' plus one of the child for each key. Unused for kNode256.
+        std::vector<uint8_t> _keys;
+
+        // The children in the order of '_keys' for kNode4 and kNode16, in any order for kNode48 and
+        // indexed by key for kNode256.
+        std::vector<std::shared_ptr<Node>> _slots;
+    };
+
     class Node {
         friend class RadixStore;
 
@@ -822,18 +1180,14 @@ private:
         }
 
         bool isLeaf() const {
-            for (auto child : _children) {
-                if (child != nullptr)
-                    return false;
-            }
-            return true;
+            return _children.empty();
         }
 
     protected:
         unsigned int _depth = 0;
         std::vector<uint8_t> _trieKey;
         boost::optional<value_type> _data;
-        std::array<std::shared_ptr<Node>, 256> _children;
+        Children _children;
     };
 
     /**
@@ -910,14 +1264,100 @@ private:
         }
         ret.push_back('\n');
 
-        for (auto child : node->_children) {
-            if (child != nullptr) {
-                ret.append(_walkTree(child.get(), depth + 1));
-            }
-        }
+        node->_children.forEach([&](uint8_t, const std::shared_ptr<Node>& child) {
+            ret.append(_walkTree(child.get(), depth + 1));
+        });
         return ret;
     }
 
+    /**
+     * Reports every key in the subtree rooted at 'node' to 'func', as erased if 'erased' is true.
+     */
+    template <typename Func>
+    static void _diffReportAll(const Node* node, bool erased, Func& func) {
+        if (node->_data)
+            func(node->_data->first, erased ? nullptr : &node->_data->second);
+        node->_children.forEach([&](uint8_t, const std::shared_ptr<Node>& child) {
+            _diffReportAll(child.get(), erased, func);
+        });
+    }
+
+    /**
+     * Compares node 'a' of the new tree, starting 'aOffset' bytes into its trie key, with node 'b'
+     * of the base tree, starting 'bOffset' bytes into its trie key. Both positions correspond to
+     * the same key prefix; the offsets are needed because a split or a compression may have moved
+     * the node boundaries of one tree relative to the other.
+     */
+    template <typename Func>
+    static void _diffHelper(
+        const Node* a, size_t aOffset, const Node* b, size_t bOffset, Func& func) {
+        if (a == b && aOffset == bOffset)
+            return;
+
+        const size_t aLen = a->_trieKey.size() - aOffset;
+        const size_t bLen = b->_trieKey.size() - bOffset;
+        size_t common = 0;
+        while (common < aLen && common < bLen &&
+               a->_trieKey[aOffset + common] == b->_trieKey[bOffset + common]) {
+            ++common;
+        }
+
+        if (common < aLen && common < bLen) {
+            // The trie keys diverge, so the two subtrees hold disjoint sets of keys.
+            _diffReportAll(a, false, func);
+            _diffReportAll(b, true, func);
+            return;
+        }
+
+        if (common == aLen && common == bLen) {
+            if (a->_data && (!b->_data || a->_data->second != b->_data->second))
+                func(a->_data->first, &a->_data->second);
+            else if (!a->_data && b->_data)
+                func(b->_data->first, nullptr);
+
+            a->_children.forEach([&](uint8_t key, const std::shared_ptr<Node>& aChild) {
+                const std::shared_ptr<Node>& bChild = b->_children[key];
+                if (!bChild)
+                    _diffReportAll(aChild.get(), false, func);
+                else if (aChild != bChild)
+                    _diffHelper(aChild.get(), 0, bChild.get(), 0, func);
+            });
+            b->_children.forEach([&](uint8_t key, const std::shared_ptr<Node>& bChild) {
+                if (!a->_children[key])
+                    _diffReportAll(bChild.get(), true, func);
+            });
+            return;
+        }
+
+        // One node ends part way through the other's trie key. Only the child of the shorter node
+        // that continues along that trie key can hold keys in common with the longer node.
+        if (common == aLen) {
+            if (a->_data)
+                func(a->_data->first, &a->_data->second);
+            const uint8_t next = b->_trieKey[bOffset + common];
+            a->_children.forEach([&](uint8_t key, const std::shared_ptr<Node>& aChild) {
+                if (key == next)
+                    _diffHelper(aChild.get(), 0, b, bOffset + common, func);
+                else
+                    _diffReportAll(aChild.get(), false, func);
+            });
+            if (!a->_children[next])
+                _diffReportAll(b, true, func);
+        } else {
+            if (b->_data)
+                func(b->_data->first, nullptr);
+            const uint8_t next = a->_trieKey[aOffset + common];
+            b->_children.forEach([&](uint8_t key, const std::shared_ptr<Node>& bChild) {
+                if (key == next)
+                    _diffHelper(a, aOffset + common, bChild.get(), 0, func);
+                else
+                    _diffReportAll(bChild.get(), true, func);
+            });
+            if (!b->_children[next])
+                _diffReportAll(a, false, func);
+        }
+    }
+
     Node* _findNode(const Key& key) const {
         const char* charKey = key.data();
 
@@ -1012,7 +1452,7 @@ private:
             if (node.use_count() - 1 > 1) {
                 // Copy node on a modifying operation when it isn't owned uniquely.
                 node = std::make_shared<Node>(*node);
-                prev->_children[childFirstChar] = node;
+                prev->_children.set(childFirstChar, node);
             }
 
             // 'node' is uniquely owned at this point, so we are free to modify it.
@@ -1045,7 +1485,7 @@ private:
 
                 // Change the current node's trieKey and make a child of the new node.
                 newKey = _makeKey(node->_trieKey, mismatchIdx, node->_trieKey.size() - mismatchIdx);
-                newNode->_children[newKey.front()] = node;
+                newNode->_children.set(newKey.front(), node);
 
                 node->_trieKey = newKey;
                 node->_depth = newNode->_depth + newNode->_trieKey.size();
@@ -1125,7 +1565,7 @@ private:
         if (value) {
             newNode->_data.emplace(value->first, value->second);
         }
-        node->_children[key.front()] = newNode;
+        node->_children.set(key.front(), newNode);
         return newNode.get();
     }
 
@@ -1181,16 +1621,12 @@ private:
         }
 
         // Determine if this node has only one child.
-        std::shared_ptr<Node> onlyChild = nullptr;
-
-        for (size_t i = 0; i < node->_children.size(); ++i) {
-            if (node->_children[i] != nullptr) {
-                if (onlyChild != nullptr) {
-                    return;
-                }
-                onlyChild = node->_children[i];
-            }
+        if (node->_children.size() != 1) {
+            return;
         }
+        std::shared_ptr<Node> onlyChild;
+        node->_children.forEach(
+            [&](uint8_t, const std::shared_ptr<Node>& child) { onlyChild = child; });
 
         // Append the child's key onto the parent.
         for (char item : onlyChild->_trieKey) {
@@ -1240,7 +1676,7 @@ private:
 
             if (prev->_children[node->_trieKey.front()].use_count() > 1) {
                 std::shared_ptr<Node> nodeCopy = std::make_shared<Node>(*node);
-                prev->_children[nodeCopy->_trieKey.front()] = nodeCopy;
+                prev->_children.set(nodeCopy->_trieKey.front(), nodeCopy);
                 context[idx] = nodeCopy.get();
                 prev = nodeCopy.get();
             } else {
@@ -1379,7 +1815,7 @@ private:
                     // modifications that go on in _makeBranchUnique.
                     _rebuildContext(context, trieKeyIndex);
 
-                    current->_children[key] = other->_children[key];
+                    current->_children.set(key, other->_children[key]);
                 } else if (!otherNode || (baseNode && baseNode != otherNode)) {
                     // Either the master tree and working tree remove the same branch, or the master
                     // tree updated the branch while the working tree removed the branch, resulting
@@ -1392,12 +1828,12 @@ private:
 
                     current = _makeBranchUnique(context);
                     _rebuildContext(context, trieKeyIndex);
-                    current->_children[key] = nullptr;
+                    current->_children.set(key, nullptr);
                 } else if (baseNode && otherNode && baseNode == node) {
                     // If base and current point to the same node, then master changed.
                     current = _makeBranchUnique(context);
                     _rebuildContext(context, trieKeyIndex);
-                    current->_children[key] = other->_children[key];
+                    current->_children.set(key, other->_children[key]);
                 }
             } else if (baseNode && otherNode && baseNode != otherNode) {
                 // If all three are unique and leaf nodes, then it is a merge conflict.
@@ -1440,12 +1876,7 @@ private:
             if (node->_children.empty())
                 return nullptr;
 
-            for (auto child : node->_children) {
-                if (child != nullptr) {
-                    node = child.get();
-                    break;
-                }
-            }
+            node = node->_children.lowerBound(0);
         }
         return node;
     }
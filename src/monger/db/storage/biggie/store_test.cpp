@@ -29,6 +29,8 @@
 
 #include "monger/platform/basic.h"
 
+#include <map>
+
 #include "monger/db/storage/biggie/store.h"
 #include "monger/unittest/unittest.h"
 
@@ -2492,5 +2494,75 @@ TEST_F(RadixStoreTest, LowerBoundEndpoint) {
     ASSERT_TRUE(it == thisStore.end());
 }
 
+TEST_F(RadixStoreTest, ChildrenLayoutGrowsAndShrinks) {
+    auto& metrics = RadixStoreMetrics::get();
+    const long long node16 = metrics.node16.load();
+    const long long node48 = metrics.node48.load();
+    const long long node256 = metrics.node256.load();
+
+    // Every key starts with a different byte, so they are all children of the root.
+    for (int c = 1; c <= 100; ++c) {
+        thisStore.insert(value_type(std::string(1, static_cast<char>(c)) + "key", "data"));
+    }
+    ASSERT_EQ(metrics.node256.load(), node256 + 1);
+    ASSERT_EQ(thisStore.size(), 100u);
+
+    // A copy of the store has its own root, which shares the nodes below it.
+    otherStore = thisStore;
+    ASSERT_EQ(metrics.node256.load(), node256 + 2);
+    otherStore = StringStore();
+    ASSERT_EQ(metrics.node256.load(), node256 + 1);
+
+    for (int c = 100; c > 10; --c) {
+        ASSERT_TRUE(thisStore.erase(std::string(1, static_cast<char>(c)) + "key"));
+    }
+    ASSERT_EQ(metrics.node256.load(), node256);
+    ASSERT_EQ(metrics.node48.load(), node48);
+    ASSERT_EQ(metrics.node16.load(), node16 + 1);
+
+    int c = 1;
+    for (auto& item : thisStore) {
+        ASSERT_EQ(item.first, std::string(1, static_cast<char>(c++)) + "key");
+    }
+    ASSERT_EQ(c, 11);
+}
+
+TEST_F(RadixStoreTest, DiffReportsOnlyChangedKeys) {
+    thisStore.insert(value_type("food", "1"));
+    thisStore.insert(value_type("foo", "2"));
+    thisStore.insert(value_type("bar", "3"));
+    thisStore.insert(value_type("baz", "4"));
+    baseStore = thisStore;
+
+    // Splits the "foo" node, erases a key, updates a key and inserts below an unchanged node.
+    thisStore.insert(value_type("fod", "5"));
+    ASSERT_TRUE(thisStore.erase("bar"));
+    thisStore.update(value_type("food", "6"));
+    thisStore.insert(value_type("bazaar", "7"));
+
+    std::map<std::string, std::string> changes;
+    thisStore.diff(baseStore, [&](const std::string& key, const std::string* value) {
+        ASSERT_EQ(changes.count(key), 0u);
+        changes[key] = value ? *value : "<erased>";
+    });
+
+    std::map<std::string, std::string> expectedChanges{
+        {"bar", "<erased>"}, {"bazaar", "7"}, {"fod", "5"}, {"food", "6"}};
+    ASSERT(changes == expectedChanges);
+
+    // Applying the changes to the base reproduces the new tree, and the reverse diff undoes them.
+    for (const auto& change : changes) {
+        if (change.second == "<erased>")
+            baseStore.erase(change.first);
+        else if (!baseStore.update(value_type(change.first, change.second)).second)
+            baseStore.insert(value_type(change.first, change.second));
+    }
+    ASSERT_TRUE(baseStore == thisStore);
+
+    size_t numChanges = 0;
+    thisStore.diff(baseStore, [&](const std::string&, const std::string*) { ++numChanges; });
+    ASSERT_EQ(numChanges, 0u);
+}
+
 }  // biggie namespace
 }  // monger namespace
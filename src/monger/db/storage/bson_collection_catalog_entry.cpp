@@ -204,6 +204,9 @@ BSONObj BSONCollectionCatalogEntry::MetaData::toBSON() const {
             if (indexes[i].sideWritesIdent) {
                 sub.append("sideWritesIdent", *indexes[i].sideWritesIdent);
             }
+            if (!indexes[i].statistics.isEmpty()) {
+                sub.append("statistics", indexes[i].statistics);
+            }
             sub.doneFast();
         }
         arr.doneFast();
@@ -252,6 +255,9 @@ void BSONCollectionCatalogEntry::MetaData::parse(const BSONObj& obj) {
             if (idx["sideWritesIdent"]) {
                 imd.sideWritesIdent = idx["sideWritesIdent"].str();
             }
+            if (idx["statistics"].isABSONObj()) {
+                imd.statistics = idx["statistics"].Obj().getOwned();
+            }
             indexes.push_back(imd);
         }
     }
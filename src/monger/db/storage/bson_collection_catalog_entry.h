@@ -80,6 +80,10 @@ public:
         // (starting at 0) into the corresponding indexed field that represent what prefixes of the
         // indexed field cause the index to be multikey.
         MultikeyPaths multikeyPaths;
+
+        // The serialized IndexStatistics gathered by the analyze command, or empty if the index
+        // has not been analyzed.
+        BSONObj statistics;
     };
 
     struct MetaData {
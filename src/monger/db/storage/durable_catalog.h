@@ -133,6 +133,22 @@ public:
                                   StringData idxName,
                                   long long newExpireSeconds) = 0;
 
+    /**
+     * Persists the serialized IndexStatistics of the given index, replacing any it had.
+     */
+    virtual void setIndexStatistics(OperationContext* opCtx,
+                                    NamespaceString ns,
+                                    StringData idxName,
+                                    const BSONObj& statistics) = 0;
+
+    /**
+     * Returns the serialized IndexStatistics of the given index, or an empty object if it has
+     * none.
+     */
+    virtual BSONObj getIndexStatistics(OperationContext* opCtx,
+                                       NamespaceString ns,
+                                       StringData idxName) const = 0;
+
     /**
      * Compare the UUID argument to the UUID obtained from the metadata. Return true if they
      * are equal, false otherwise. uuid can become a CollectionUUID once MMAPv1 is removed.
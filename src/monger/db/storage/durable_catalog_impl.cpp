@@ -937,6 +937,26 @@ void DurableCatalogImpl::updateTTLSetting(OperationContext* opCtx,
     putMetaData(opCtx, ns, md);
 }
 
+void DurableCatalogImpl::setIndexStatistics(OperationContext* opCtx,
+                                            NamespaceString ns,
+                                            StringData idxName,
+                                            const BSONObj& statistics) {
+    BSONCollectionCatalogEntry::MetaData md = getMetaData(opCtx, ns);
+    int offset = md.findIndexOffset(idxName);
+    invariant(offset >= 0);
+    md.indexes[offset].statistics = statistics.getOwned();
+    putMetaData(opCtx, ns, md);
+}
+
+BSONObj DurableCatalogImpl::getIndexStatistics(OperationContext* opCtx,
+                                               NamespaceString ns,
+                                               StringData idxName) const {
+    BSONCollectionCatalogEntry::MetaData md = getMetaData(opCtx, ns);
+    int offset = md.findIndexOffset(idxName);
+    invariant(offset >= 0);
+    return md.indexes[offset].statistics;
+}
+
 bool DurableCatalogImpl::isEqualToMetadataUUID(OperationContext* opCtx,
                                                NamespaceString ns,
                                                OptionalCollectionUUID uuid) {
@@ -127,6 +127,15 @@ public:
                           StringData idxName,
                           long long newExpireSeconds);
 
+    void setIndexStatistics(OperationContext* opCtx,
+                            NamespaceString ns,
+                            StringData idxName,
+                            const BSONObj& statistics);
+
+    BSONObj getIndexStatistics(OperationContext* opCtx,
+                               NamespaceString ns,
+                               StringData idxName) const;
+
     bool isEqualToMetadataUUID(OperationContext* opCtx,
                                NamespaceString ns,
                                OptionalCollectionUUID uuid);
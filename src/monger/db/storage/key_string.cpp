@@ -233,6 +233,16 @@ void memcpy_flipBits(void* dst, const void* src, size_t bytes) {
     const char* input = static_cast<const char*>(src);
     char* output = static_cast<char*>(dst);
     const char* const end = input + bytes;
+
+    // Flip a word at a time, which the compiler can vectorize for long strings and binary data.
+    while (end - input >= static_cast<std::ptrdiff_t>(sizeof(uint64_t))) {
+        uint64_t word;
+        memcpy(&word, input, sizeof(word));
+        word = ~word;
+        memcpy(output, &word, sizeof(word));
+        input += sizeof(word);
+        output += sizeof(word);
+    }
     while (input != end) {
         *output++ = ~(*input++);
     }
@@ -284,10 +294,8 @@ string readInvertedCString(BufReader* reader) {
     const char* end = static_cast<const char*>(memchr(start, 0xFF, reader->remaining()));
     uassert(50817, "Failed to find '0xFF' in inverted string.", end);
     size_t actualBytes = end - start;
-    string s(start, actualBytes);
-    for (size_t i = 0; i < s.size(); i++) {
-        s[i] = ~s[i];
-    }
+    string s(actualBytes, '\0');
+    memcpy_flipBits(&s[0], start, actualBytes);
     reader->skip(1 + actualBytes);
     return s;
 }
@@ -314,9 +322,7 @@ string readInvertedCStringWithNuls(BufReader* reader) {
         reader->skip(1 + actualBytes);
     } while (reader->peek<unsigned char>() == 0x00);
 
-    for (size_t i = 0; i < out.size(); i++) {
-        out[i] = ~out[i];
-    }
+    memcpy_flipBits(&out[0], out.data(), out.size());
 
     return out;
 }
@@ -858,15 +864,23 @@ void KeyString::_appendBsonValue(const BSONElement& elem, bool invert, const Str
 
 void KeyString::_appendStringLike(StringData str, bool invert) {
     while (true) {
-        size_t firstNul = strnlen(str.rawData(), str.size());
-        // No NULs in string.
-        _appendBytes(str.rawData(), firstNul, invert);
-        if (firstNul == str.size() || firstNul == std::string::npos) {
-            _append(int8_t(0), invert);
+        const char* nul = static_cast<const char*>(memchr(str.rawData(), 0, str.size()));
+        if (!nul) {
+            // No NULs in the rest of the string, so append it and its terminator in one piece.
+            char* const base = _buffer.skip(str.size() + 1);
+            if (invert) {
+                memcpy_flipBits(base, str.rawData(), str.size());
+                base[str.size()] = static_cast<char>(0xFF);
+            } else {
+                memcpy(base, str.rawData(), str.size());
+                base[str.size()] = 0;
+            }
             break;
         }
 
         // replace "\x00" with "\x00\xFF"
+        const size_t firstNul = nul - str.rawData();
+        _appendBytes(str.rawData(), firstNul, invert);
         _appendBytes("\x00\xFF", 2, invert);
         str = str.substr(firstNul + 1);  // skip over the NUL byte
     }
@@ -1046,17 +1060,21 @@ void KeyString::_appendPreshiftedIntegerPortion(uint64_t value, bool isNegative,
 
     const size_t bytesNeeded = (64 - countLeadingZeros64(value) + 7) / 8;
 
-    // Append the low bytes of value in big endian order.
-    value = endian::nativeToBig(value);
-    const void* firstUsedByte = reinterpret_cast<const char*>((&value) + 1) - bytesNeeded;
-
+    // Append the type byte followed by the low bytes of value in big endian order. Integers are
+    // the most common keys, so both are written with a single append.
+    uint8_t ctype;
     if (isNegative) {
-        _append(uint8_t(CType::kNumericNegative1ByteInt - (bytesNeeded - 1)), invert);
-        _appendBytes(firstUsedByte, bytesNeeded, !invert);
+        ctype = uint8_t(CType::kNumericNegative1ByteInt - (bytesNeeded - 1));
+        value = ~value;
     } else {
-        _append(uint8_t(CType::kNumericPositive1ByteInt + (bytesNeeded - 1)), invert);
-        _appendBytes(firstUsedByte, bytesNeeded, invert);
+        ctype = uint8_t(CType::kNumericPositive1ByteInt + (bytesNeeded - 1));
     }
+    value = endian::nativeToBig(value);
+
+    char encoded[1 + sizeof(value)];
+    encoded[0] = ctype;
+    memcpy(encoded + 1, reinterpret_cast<const char*>((&value) + 1) - bytesNeeded, bytesNeeded);
+    _appendBytes(encoded, 1 + bytesNeeded, invert);
 }
 
 template <typename T>
@@ -2196,11 +2214,20 @@ void KeyString::TypeBits::resetFromBuffer(BufReader* reader) {
 void KeyString::TypeBits::appendBit(uint8_t oneOrZero) {
     dassert(oneOrZero == 0 || oneOrZero == 1);
 
-    if (oneOrZero == 1)
-        _isAllZeros = false;
-
     const uint32_t byte = _curBit / 8;
     const uint8_t offsetInByte = _curBit % 8;
+
+    if (_isAllZeros) {
+        // Most keys only have zero type bits, and those are not stored until a one is appended.
+        if (oneOrZero == 0) {
+            _curBit++;
+            return;
+        }
+        _isAllZeros = false;
+        setRawSize(byte + 1);
+        memset(getDataBuffer(), 0, byte + 1);
+    }
+
     if (offsetInByte == 0) {
         setRawSize(byte + 1);
         getDataBuffer()[byte] = oneOrZero;  // zeros bits 1-7
@@ -49,6 +49,7 @@ const int kStrLenMultiplier = 100;
 const int kArrLenMultiplier = 40;
 
 const Ordering ALL_ASCENDING = Ordering::make(BSONObj());
+const Ordering ALL_DESCENDING = Ordering::make(BSON("a" << -1 << "b" << -1 << "c" << -1));
 
 struct BsonsAndKeyStrings {
     int bsonSize = 0;
@@ -62,10 +63,15 @@ struct BsonsAndKeyStrings {
 
 enum BsonValueType {
     INT,
+    LONG,
     DOUBLE,
     STRING,
+    STRING_WITH_NULS,
+    OBJECTID,
+    DATE,
     ARRAY,
     DECIMAL,
+    COMPOUND,
 };
 
 BSONObj generateBson(BsonValueType bsonValueType) {
@@ -76,10 +82,23 @@ BSONObj generateBson(BsonValueType bsonValueType) {
     switch (bsonValueType) {
         case INT:
             return BSON("" << static_cast<int>(expReal(gen)));
+        case LONG:
+            return BSON("" << static_cast<long long>(gen()));
         case DOUBLE:
             return BSON("" << expReal(gen));
         case STRING:
             return BSON("" << std::string(expDist(gen) * kStrLenMultiplier, 'x'));
+        case STRING_WITH_NULS: {
+            std::string str(expDist(gen) * kStrLenMultiplier, 'x');
+            for (size_t i = 0; i < str.size(); i += 16) {
+                str[i] = '\0';
+            }
+            return BSON("" << str);
+        }
+        case OBJECTID:
+            return BSON("" << OID::gen());
+        case DATE:
+            return BSON("" << Date_t::fromMillisSinceEpoch(gen() % (1LL << 42)));
         case ARRAY: {
             const int arrLen = expDist(gen) * kArrLenMultiplier;
             BSONArrayBuilder bab;
@@ -93,18 +112,24 @@ BSONObj generateBson(BsonValueType bsonValueType) {
                                          Decimal128::kRoundTo34Digits,
                                          Decimal128::kRoundTiesToAway)
                                   .quantize(Decimal128("0.01", Decimal128::kRoundTiesToAway)));
+        case COMPOUND:
+            return BSON("" << static_cast<int>(expReal(gen)) << ""
+                           << std::string(expDist(gen) * kStrLenMultiplier, 'x')
+                           << ""
+                           << OID::gen());
     }
     MONGO_UNREACHABLE;
 }
 
 static BsonsAndKeyStrings generateBsonsAndKeyStrings(BsonValueType bsonValueType,
-                                                     KeyString::Version version) {
+                                                     KeyString::Version version,
+                                                     Ordering ord) {
     BsonsAndKeyStrings result;
     result.bsonSize = 0;
     result.keystringSize = 0;
     for (int i = 0; i < kSampleSize; i++) {
         BSONObj bson = generateBson(bsonValueType);
-        KeyString ks(version, bson, ALL_ASCENDING);
+        KeyString ks(version, bson, ord);
         result.bsonSize += bson.objsize();
         result.keystringSize += ks.getSize();
         result.bsons[i] = bson;
@@ -115,19 +140,21 @@ static BsonsAndKeyStrings generateBsonsAndKeyStrings(BsonValueType bsonValueType
 
         result.typebits[i] = SharedBuffer::allocate(ks.getTypeBits().getSize());
         memcpy(result.typebits[i].get(), ks.getTypeBits().getBuffer(), ks.getTypeBits().getSize());
-        result.typebitsLens[i] = ks.getSize();
+        result.typebitsLens[i] = ks.getTypeBits().getSize();
     }
     return result;
 }
 
 void BM_BSONToKeyString(benchmark::State& state,
                         const KeyString::Version version,
-                        BsonValueType bsonType) {
-    const BsonsAndKeyStrings bsonsAndKeyStrings = generateBsonsAndKeyStrings(bsonType, version);
+                        BsonValueType bsonType,
+                        Ordering ord = ALL_ASCENDING) {
+    const BsonsAndKeyStrings bsonsAndKeyStrings =
+        generateBsonsAndKeyStrings(bsonType, version, ord);
     for (auto _ : state) {
         benchmark::ClobberMemory();
         for (auto bson : bsonsAndKeyStrings.bsons) {
-            benchmark::DoNotOptimize(KeyString(version, bson, ALL_ASCENDING));
+            benchmark::DoNotOptimize(KeyString(version, bson, ord));
         }
     }
     state.SetBytesProcessed(state.iterations() * bsonsAndKeyStrings.bsonSize);
@@ -136,8 +163,10 @@ void BM_BSONToKeyString(benchmark::State& state,
 
 void BM_KeyStringToBSON(benchmark::State& state,
                         const KeyString::Version version,
-                        BsonValueType bsonType) {
-    const BsonsAndKeyStrings bsonsAndKeyStrings = generateBsonsAndKeyStrings(bsonType, version);
+                        BsonValueType bsonType,
+                        Ordering ord = ALL_ASCENDING) {
+    const BsonsAndKeyStrings bsonsAndKeyStrings =
+        generateBsonsAndKeyStrings(bsonType, version, ord);
     for (auto _ : state) {
         benchmark::ClobberMemory();
         for (size_t i = 0; i < kSampleSize; i++) {
@@ -145,7 +174,7 @@ void BM_KeyStringToBSON(benchmark::State& state,
             benchmark::DoNotOptimize(
                 KeyString::toBson(bsonsAndKeyStrings.keystrings[i].get(),
                                   bsonsAndKeyStrings.keystringLens[i],
-                                  ALL_ASCENDING,
+                                  ord,
                                   KeyString::TypeBits::fromBuffer(version, &buf)));
         }
     }
@@ -162,6 +191,16 @@ BENCHMARK_CAPTURE(BM_BSONToKeyString, V0_String, KeyString::Version::V0, STRING)
 BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_String, KeyString::Version::V1, STRING);
 BENCHMARK_CAPTURE(BM_BSONToKeyString, V0_Array, KeyString::Version::V0, ARRAY);
 BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_Array, KeyString::Version::V1, ARRAY);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_Long, KeyString::Version::V1, LONG);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_StringWithNuls, KeyString::Version::V1, STRING_WITH_NULS);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_OID, KeyString::Version::V1, OBJECTID);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_Date, KeyString::Version::V1, DATE);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_Compound, KeyString::Version::V1, COMPOUND);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_Int_Desc, KeyString::Version::V1, INT, ALL_DESCENDING);
+BENCHMARK_CAPTURE(
+    BM_BSONToKeyString, V1_String_Desc, KeyString::Version::V1, STRING, ALL_DESCENDING);
+BENCHMARK_CAPTURE(
+    BM_BSONToKeyString, V1_Compound_Desc, KeyString::Version::V1, COMPOUND, ALL_DESCENDING);
 
 BENCHMARK_CAPTURE(BM_KeyStringToBSON, V0_Int, KeyString::Version::V0, INT);
 BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_Int, KeyString::Version::V1, INT);
@@ -172,5 +211,15 @@ BENCHMARK_CAPTURE(BM_KeyStringToBSON, V0_String, KeyString::Version::V0, STRING)
 BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_String, KeyString::Version::V1, STRING);
 BENCHMARK_CAPTURE(BM_KeyStringToBSON, V0_Array, KeyString::Version::V0, ARRAY);
 BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_Array, KeyString::Version::V1, ARRAY);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_Long, KeyString::Version::V1, LONG);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_StringWithNuls, KeyString::Version::V1, STRING_WITH_NULS);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_OID, KeyString::Version::V1, OBJECTID);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_Date, KeyString::Version::V1, DATE);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_Compound, KeyString::Version::V1, COMPOUND);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_Int_Desc, KeyString::Version::V1, INT, ALL_DESCENDING);
+BENCHMARK_CAPTURE(
+    BM_KeyStringToBSON, V1_String_Desc, KeyString::Version::V1, STRING, ALL_DESCENDING);
+BENCHMARK_CAPTURE(
+    BM_KeyStringToBSON, V1_Compound_Desc, KeyString::Version::V1, COMPOUND, ALL_DESCENDING);
 }  // namespace
 }  // namespace monger
@@ -1351,6 +1351,34 @@ TEST_F(KeyStringTest, VeryLargeString) {
     ROUNDTRIP(version, obj);
 }
 
+TEST_F(KeyStringTest, StringsWithNulsAcrossWordBoundaries) {
+    for (size_t len = 0; len < 40; ++len) {
+        for (size_t nulPos : {size_t(0), len / 2, len - 1}) {
+            std::string str(len, 'x');
+            for (size_t i = 0; i < len; ++i) {
+                str[i] = static_cast<char>('a' + i % 26);
+            }
+            if (len > 0) {
+                str[nulPos] = '\0';
+            }
+            ROUNDTRIP(version, BSON("" << str));
+            ROUNDTRIP(version, BSON("" << BSONSymbol(str)));
+        }
+    }
+}
+
+TEST_F(KeyStringTest, TypeBitsWithLongRunOfZerosBeforeOne) {
+    // Every int appends zero type bits, so the trailing long is the first bit stored.
+    for (int numInts : {0, 3, 4, 63, 64, 65, 1000}) {
+        BSONArrayBuilder array;
+        for (int i = 0; i < numInts; ++i) {
+            array.append(i);
+        }
+        array.append(7LL);
+        ROUNDTRIP(version, BSON("" << array.arr()));
+    }
+}
+
 TEST_F(KeyStringTest, ToBsonSafeShouldNotTerminate) {
     KeyString::TypeBits typeBits(KeyString::Version::V1);
 
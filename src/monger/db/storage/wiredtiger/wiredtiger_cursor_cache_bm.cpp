@@ -0,0 +1,209 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "monger/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "monger/db/storage/wiredtiger/wiredtiger_parameters_gen.h"
+#include "monger/db/storage/wiredtiger/wiredtiger_session_cache.h"
+#include "monger/db/storage/wiredtiger/wiredtiger_util.h"
+#include "monger/platform/random.h"
+#include "monger/unittest/temp_dir.h"
+#include "monger/util/clock_source_mock.h"
+#include "monger/util/scopeguard.h"
+
+namespace monger {
+namespace {
+
+// Every collection has a record store table and an _id index table, as in a mongerd with this many
+// collections.
+const int kNumCollections = 10000;
+const int kDocsPerCollection = 10;
+
+class WiredTigerConnection {
+public:
+    WiredTigerConnection(StringData dbpath, StringData extraStrings) : _conn(nullptr) {
+        std::stringstream ss;
+        ss << "create,";
+        ss << extraStrings;
+        std::string config = ss.str();
+        int ret = wiredtiger_open(dbpath.toString().c_str(), nullptr, config.c_str(), &_conn);
+        invariant(wtRCToStatus(ret).isOK());
+    }
+    ~WiredTigerConnection() {
+        _conn->close(_conn, nullptr);
+    }
+    WT_CONNECTION* getConnection() const {
+        return _conn;
+    }
+
+private:
+    WT_CONNECTION* _conn;
+};
+
+struct CollectionTables {
+    std::string recordStoreUri;
+    uint64_t recordStoreId;
+    std::string idIndexUri;
+    uint64_t idIndexId;
+};
+
+/**
+ * Creates kNumCollections collections, each holding kDocsPerCollection documents. Creating the
+ * tables dominates the run time, so a single helper is shared by every benchmark.
+ */
+class WiredTigerCursorCacheTestHelper {
+public:
+    WiredTigerCursorCacheTestHelper()
+        : _dbpath("wt_test"),
+          _connection(_dbpath.path(), "file_manager=(close_idle_time=100000)"),
+          _sessionCache(_connection.getConnection(), &_clockSource) {
+        UniqueWiredTigerSession session = _sessionCache.getSession();
+        WT_SESSION* wtSession = session->getSession();
+        for (int i = 0; i < kNumCollections; ++i) {
+            std::string suffix = std::to_string(i);
+            CollectionTables tables{"table:collection-" + suffix,
+                                    WiredTigerSession::genTableId(),
+                                    "table:index-" + suffix,
+                                    WiredTigerSession::genTableId()};
+            _create(wtSession, tables.recordStoreUri, "key_format=q,value_format=S");
+            _create(wtSession, tables.idIndexUri, "key_format=q,value_format=q");
+
+            WT_CURSOR* records = session->getCursor(tables.recordStoreUri, 0, true);
+            WT_CURSOR* index = session->getCursor(tables.idIndexUri, 0, true);
+            for (int64_t doc = 0; doc < kDocsPerCollection; ++doc) {
+                int64_t recordId = doc + 1;
+                records->set_key(records, recordId);
+                records->set_value(records, "{_id: ...}");
+                invariantWTOK(records->insert(records));
+                index->set_key(index, doc);
+                index->set_value(index, recordId);
+                invariantWTOK(index->insert(index));
+            }
+            session->closeCursor(records);
+            session->closeCursor(index);
+
+            _collections.push_back(std::move(tables));
+        }
+    }
+
+    WiredTigerSessionCache* getSessionCache() {
+        return &_sessionCache;
+    }
+
+    const CollectionTables& getCollection(int i) const {
+        return _collections[i];
+    }
+
+private:
+    static void _create(WT_SESSION* session, const std::string& uri, const char* config) {
+        invariantWTOK(session->create(session, uri.c_str(), config));
+    }
+
+    unittest::TempDir _dbpath;
+    WiredTigerConnection _connection;
+    ClockSourceMock _clockSource;
+    WiredTigerSessionCache _sessionCache;
+    std::vector<CollectionTables> _collections;
+};
+
+WiredTigerCursorCacheTestHelper& getHelper() {
+    static WiredTigerCursorCacheTestHelper helper;
+    return helper;
+}
+
+/**
+ * Looks up a document by _id in a random collection out of the first 'state.range(0)', with the
+ * session cursor cache holding 'state.range(1)' cursors. Each lookup is its own operation, so it
+ * takes a session from the session cache and returns it afterwards, and only benefits from the
+ * cursor cache when a cursor survives from an earlier operation.
+ */
+void BM_WiredTigerFindById(benchmark::State& state) {
+    auto& helper = getHelper();
+    WiredTigerSessionCache* sessionCache = helper.getSessionCache();
+
+    const int oldCacheSize = gWiredTigerCursorCacheSize.load();
+    gWiredTigerCursorCacheSize.store(state.range(1));
+    ON_BLOCK_EXIT([&] { gWiredTigerCursorCacheSize.store(oldCacheSize); });
+
+    // Start every run with empty cursor caches so that earlier runs do not warm this one.
+    sessionCache->closeAllCursors("");
+    const auto statsBefore = sessionCache->getCursorCacheStats();
+
+    PseudoRandom random(1);
+    const int workingSet = state.range(0);
+    for (auto _ : state) {
+        const auto& tables = helper.getCollection(random.nextInt32(workingSet));
+        int64_t id = random.nextInt32(kDocsPerCollection);
+
+        UniqueWiredTigerSession session = sessionCache->getSession();
+
+        WT_CURSOR* index = session->getCursor(tables.idIndexUri, tables.idIndexId, false);
+        index->set_key(index, id);
+        invariantWTOK(index->search(index));
+        int64_t recordId;
+        invariantWTOK(index->get_value(index, &recordId));
+        session->releaseCursor(tables.idIndexId, index);
+
+        WT_CURSOR* records =
+            session->getCursor(tables.recordStoreUri, tables.recordStoreId, false);
+        records->set_key(records, recordId);
+        invariantWTOK(records->search(records));
+        const char* doc;
+        invariantWTOK(records->get_value(records, &doc));
+        benchmark::DoNotOptimize(doc);
+        session->releaseCursor(tables.recordStoreId, records);
+    }
+
+    const auto statsAfter = sessionCache->getCursorCacheStats();
+    const double hits = statsAfter.hits - statsBefore.hits;
+    const double misses = statsAfter.misses - statsBefore.misses;
+    state.counters["reuseRatio"] = hits + misses ? hits / (hits + misses) : 0;
+    state.counters["evictions"] = statsAfter.evictions - statsBefore.evictions;
+}
+
+// Working sets of 100, 1000 and all 10000 collections, with WiredTiger caching the cursors
+// (the default of -100), or the session caching 100 or 20000 cursors.
+BENCHMARK(BM_WiredTigerFindById)
+    ->ArgPair(100, -100)
+    ->ArgPair(100, 100)
+    ->ArgPair(100, 20000)
+    ->ArgPair(1000, -100)
+    ->ArgPair(1000, 100)
+    ->ArgPair(1000, 20000)
+    ->ArgPair(10000, -100)
+    ->ArgPair(10000, 100)
+    ->ArgPair(10000, 20000);
+
+}  // namespace
+}  // namespace monger
@@ -1379,26 +1379,16 @@ Status WiredTigerKVEngine::dropIdent(OperationContext* opCtx, StringData ident)
     return Status::OK();
 }
 
-std::list<WiredTigerCachedCursor> WiredTigerKVEngine::filterCursorsWithQueuedDrops(
-    std::list<WiredTigerCachedCursor>* cache) {
-    std::list<WiredTigerCachedCursor> toDrop;
-
+std::vector<WT_CURSOR*> WiredTigerKVEngine::filterCursorsWithQueuedDrops(
+    WiredTigerCursorCache* cache) {
     stdx::lock_guard<stdx::mutex> lk(_identToDropMutex);
     if (_identToDrop.empty())
-        return toDrop;
-
-    for (auto i = cache->begin(); i != cache->end();) {
-        if (!i->_cursor ||
-            std::find(_identToDrop.begin(), _identToDrop.end(), std::string(i->_cursor->uri)) ==
-                _identToDrop.end()) {
-            ++i;
-            continue;
-        }
-        toDrop.push_back(*i);
-        i = cache->erase(i);
-    }
+        return {};
 
-    return toDrop;
+    return cache->removeIf([&](WT_CURSOR* cursor) {
+        return std::find(_identToDrop.begin(), _identToDrop.end(), std::string(cursor->uri)) !=
+            _identToDrop.end();
+    });
 }
 
 bool WiredTigerKVEngine::haveDropsQueued() const {
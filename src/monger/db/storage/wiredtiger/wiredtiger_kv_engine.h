@@ -33,6 +33,7 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <boost/filesystem/path.hpp>
 #include <wiredtiger.h>
@@ -259,8 +260,7 @@ public:
         return _conn;
     }
     void dropSomeQueuedIdents();
-    std::list<WiredTigerCachedCursor> filterCursorsWithQueuedDrops(
-        std::list<WiredTigerCachedCursor>* cache);
+    std::vector<WT_CURSOR*> filterCursorsWithQueuedDrops(WiredTigerCursorCache* cache);
     bool haveDropsQueued() const;
 
     void syncSizeInfo(bool sync) const;
@@ -80,6 +80,8 @@ BSONObj WiredTigerServerStatusSection::generateSection(OperationContext* opCtx,
 
     WiredTigerKVEngine::appendGlobalStats(bob);
 
+    WiredTigerRecoveryUnit::get(opCtx)->getSessionCache()->appendCursorCacheStats(&bob);
+
     WiredTigerUtil::appendSnapshotWindowSettings(_engine, session, &bob);
 
     return bob.obj();
@@ -33,9 +33,12 @@
 
 #include "monger/db/storage/wiredtiger/wiredtiger_session_cache.h"
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
 
 #include "monger/base/error_codes.h"
+#include "monger/bson/bsonobjbuilder.h"
 #include "monger/db/concurrency/write_conflict_exception.h"
 #include "monger/db/global_settings.h"
 #include "monger/db/repl/repl_settings.h"
@@ -105,19 +108,55 @@ void _openCursor(WT_SESSION* session,
 }  // namespace
 
 
+boost::optional<WiredTigerCachedCursor> WiredTigerCursorCache::take(uint64_t id) {
+    auto tableIt = _byTable.find(id);
+    if (tableIt == _byTable.end())
+        return boost::none;
+
+    auto lruIt = tableIt->second.back();
+    WiredTigerCachedCursor cached = *lruIt;
+    tableIt->second.pop_back();
+    if (tableIt->second.empty())
+        _byTable.erase(tableIt);
+    _lru.erase(lruIt);
+    return cached;
+}
+
+void WiredTigerCursorCache::put(const WiredTigerCachedCursor& cursor) {
+    _lru.push_front(cursor);
+    _byTable[cursor._id].push_back(_lru.begin());
+}
+
+WT_CURSOR* WiredTigerCursorCache::evictOldest() {
+    invariant(!_lru.empty());
+    WT_CURSOR* cursor = _lru.back()._cursor;
+    _erase(std::prev(_lru.end()));
+    return cursor;
+}
+
+WiredTigerCursorCache::Lru::iterator WiredTigerCursorCache::_erase(Lru::iterator it) {
+    auto tableIt = _byTable.find(it->_id);
+    invariant(tableIt != _byTable.end());
+    auto& positions = tableIt->second;
+    positions.erase(std::find(positions.begin(), positions.end(), it));
+    if (positions.empty())
+        _byTable.erase(tableIt);
+    return _lru.erase(it);
+}
+
 WT_CURSOR* WiredTigerSession::getCursor(const std::string& uri, uint64_t id, bool allowOverwrite) {
     // Find the most recently used cursor
-    for (CursorCache::iterator i = _cursors.begin(); i != _cursors.end(); ++i) {
-        if (i->_id == id) {
-            WT_CURSOR* c = i->_cursor;
-            _cursors.erase(i);
-            _cursorsOut++;
-            return c;
-        }
+    if (auto cached = _cursors.take(id)) {
+        _cursorCacheStats.hits++;
+        if (cached->_gen != _cursorGen)
+            _cursorCacheStats.crossOperationHits++;
+        _cursorsOut++;
+        return cached->_cursor;
     }
 
     WT_CURSOR* cursor = nullptr;
     _openCursor(_session, uri, allowOverwrite ? "" : "overwrite=false", &cursor);
+    _cursorCacheStats.misses++;
     _cursorsOut++;
     return cursor;
 }
@@ -138,15 +177,15 @@ void WiredTigerSession::releaseCursor(uint64_t id, WT_CURSOR* cursor) {
 
     invariantWTOK(cursor->reset(cursor));
 
-    // Cursors are pushed to the front of the list and removed from the back
-    _cursors.push_front(WiredTigerCachedCursor(id, _cursorGen++, cursor));
+    _cursors.put(WiredTigerCachedCursor(id, _cursorGen, cursor));
 
     // A negative value for wiredTigercursorCacheSize means to use hybrid caching.
     std::uint32_t cacheSize = abs(gWiredTigerCursorCacheSize.load());
 
-    while (!_cursors.empty() && _cursorGen - _cursors.back()._gen > cacheSize) {
-        cursor = _cursors.back()._cursor;
-        _cursors.pop_back();
+    // Close the least recently released cursors beyond the configured capacity.
+    while (_cursors.size() > cacheSize) {
+        cursor = _cursors.evictOldest();
+        _cursorCacheStats.evictions++;
         invariantWTOK(cursor->close(cursor));
     }
 }
@@ -163,13 +202,9 @@ void WiredTigerSession::closeAllCursors(const std::string& uri) {
     invariant(_session);
 
     bool all = (uri == "");
-    for (auto i = _cursors.begin(); i != _cursors.end();) {
-        WT_CURSOR* cursor = i->_cursor;
-        if (cursor && (all || uri == cursor->uri)) {
-            invariantWTOK(cursor->close(cursor));
-            i = _cursors.erase(i);
-        } else
-            ++i;
+    auto toClose = _cursors.removeIf([&](WT_CURSOR* cursor) { return all || uri == cursor->uri; });
+    for (WT_CURSOR* cursor : toClose) {
+        invariantWTOK(cursor->close(cursor));
     }
 }
 
@@ -179,11 +214,8 @@ void WiredTigerSession::closeCursorsForQueuedDrops(WiredTigerKVEngine* engine) {
     _cursorEpoch = _cache->getCursorEpoch();
     auto toDrop = engine->filterCursorsWithQueuedDrops(&_cursors);
 
-    for (auto i = toDrop.begin(); i != toDrop.end(); i++) {
-        WT_CURSOR* cursor = i->_cursor;
-        if (cursor) {
-            invariantWTOK(cursor->close(cursor));
-        }
+    for (WT_CURSOR* cursor : toDrop) {
+        invariantWTOK(cursor->close(cursor));
     }
 }
 
@@ -411,6 +443,18 @@ void WiredTigerSessionCache::releaseSession(WiredTigerSession* session) {
     invariant(session);
     invariant(session->cursorsOut() == 0);
 
+    // Fold the session's cursor cache statistics into the totals, and start a new use of the
+    // session so that later hits on the cursors it has cached count as cross-operation reuse.
+    {
+        auto& stats = session->_cursorCacheStats;
+        _cursorCacheHits.fetchAndAdd(stats.hits);
+        _cursorCacheCrossOperationHits.fetchAndAdd(stats.crossOperationHits);
+        _cursorCacheMisses.fetchAndAdd(stats.misses);
+        _cursorCacheEvictions.fetchAndAdd(stats.evictions);
+        stats = WiredTigerCursorCacheStats();
+        session->_cursorGen++;
+    }
+
     const int shuttingDown = _shuttingDown.fetchAndAdd(1);
     ON_BLOCK_EXIT([this] { _shuttingDown.fetchAndSubtract(1); });
 
@@ -478,6 +522,28 @@ void WiredTigerSessionCache::setJournalListener(JournalListener* jl) {
     _journalListener = jl;
 }
 
+WiredTigerCursorCacheStats WiredTigerSessionCache::getCursorCacheStats() const {
+    WiredTigerCursorCacheStats stats;
+    stats.hits = _cursorCacheHits.load();
+    stats.crossOperationHits = _cursorCacheCrossOperationHits.load();
+    stats.misses = _cursorCacheMisses.load();
+    stats.evictions = _cursorCacheEvictions.load();
+    return stats;
+}
+
+void WiredTigerSessionCache::appendCursorCacheStats(BSONObjBuilder* builder) const {
+    auto stats = getCursorCacheStats();
+    long long requests = stats.hits + stats.misses;
+
+    BSONObjBuilder bob(builder->subobjStart("sessionCursorCache"));
+    bob.append("capacity", abs(gWiredTigerCursorCacheSize.load()));
+    bob.append("hits", stats.hits);
+    bob.append("crossOperationHits", stats.crossOperationHits);
+    bob.append("misses", stats.misses);
+    bob.append("evictions", stats.evictions);
+    bob.append("reuseRatio", requests ? static_cast<double>(stats.hits) / requests : 0.0);
+}
+
 bool WiredTigerSessionCache::isEngineCachingCursors() {
     return gWiredTigerCursorCacheSize.load() <= 0;
 }
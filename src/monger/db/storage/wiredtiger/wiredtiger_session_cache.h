@@ -29,8 +29,10 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
 #include <list>
 #include <string>
+#include <vector>
 
 #include <wiredtiger.h>
 
@@ -38,10 +40,12 @@
 #include "monger/db/storage/wiredtiger/wiredtiger_snapshot_manager.h"
 #include "monger/platform/atomic_word.h"
 #include "monger/stdx/mutex.h"
+#include "monger/stdx/unordered_map.h"
 #include "monger/util/concurrency/spin_lock.h"
 
 namespace monger {
 
+class BSONObjBuilder;
 class WiredTigerKVEngine;
 class WiredTigerSessionCache;
 
@@ -51,10 +55,81 @@ public:
         : _id(id), _gen(gen), _cursor(cursor) {}
 
     uint64_t _id;   // Source ID, assigned to each URI
-    uint64_t _gen;  // Generation, used to age out old cursors
+    uint64_t _gen;  // Use of the session in which the cursor was released
     WT_CURSOR* _cursor;
 };
 
+/**
+ * The cursors cached by one WiredTigerSession. Cursors are indexed by the id of their table, so
+ * finding one costs the same however many other tables have cursors cached, and the cache evicts
+ * the least recently released cursor first.
+ * NOT THREADSAFE
+ */
+class WiredTigerCursorCache {
+public:
+    /**
+     * Removes and returns the most recently released cursor on table 'id', if there is one.
+     */
+    boost::optional<WiredTigerCachedCursor> take(uint64_t id);
+
+    /**
+     * Caches 'cursor' as the most recently released one.
+     */
+    void put(const WiredTigerCachedCursor& cursor);
+
+    /**
+     * Removes and returns the least recently released cursor. The cache must not be empty.
+     */
+    WT_CURSOR* evictOldest();
+
+    /**
+     * Removes every cursor for which 'pred' returns true and returns them.
+     */
+    template <typename Pred>
+    std::vector<WT_CURSOR*> removeIf(Pred pred) {
+        std::vector<WT_CURSOR*> removed;
+        for (auto it = _lru.begin(); it != _lru.end();) {
+            if (it->_cursor && pred(it->_cursor)) {
+                removed.push_back(it->_cursor);
+                it = _erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return removed;
+    }
+
+    size_t size() const {
+        return _lru.size();
+    }
+
+private:
+    using Lru = std::list<WiredTigerCachedCursor>;
+
+    Lru::iterator _erase(Lru::iterator it);
+
+    // Every cached cursor, most recently released first.
+    Lru _lru;
+
+    // The cursors of each table, as positions in '_lru' ordered least recently released first.
+    // A session rarely caches more than one cursor per table.
+    stdx::unordered_map<uint64_t, std::vector<Lru::iterator>> _byTable;
+};
+
+/**
+ * Counts of how often sessions avoided opening a cursor by reusing a cached one.
+ */
+struct WiredTigerCursorCacheStats {
+    // getCursor() calls satisfied from the cursor cache.
+    long long hits = 0;
+    // The hits that reused a cursor released by an earlier user of the session.
+    long long crossOperationHits = 0;
+    // getCursor() calls that had to open a new cursor.
+    long long misses = 0;
+    // Cached cursors closed to keep the cache within wiredTigerCursorCacheSize.
+    long long evictions = 0;
+};
+
 /**
  * This is a structure that caches 1 cursor for each uri.
  * The idea is that there is a pool of these somewhere.
@@ -138,6 +213,13 @@ public:
         return _cursors.size();
     }
 
+    /**
+     * Cursor cache statistics accumulated since the session was last returned to its cache.
+     */
+    const WiredTigerCursorCacheStats& getCursorCacheStats() const {
+        return _cursorCacheStats;
+    }
+
     bool isDropQueuedIdentsAtSessionEndAllowed() const {
         return _dropQueuedIdentsAtSessionEnd;
     }
@@ -164,9 +246,6 @@ public:
 private:
     friend class WiredTigerSessionCache;
 
-    // The cursor cache is a list of pairs that contain an ID and cursor
-    typedef std::list<WiredTigerCachedCursor> CursorCache;
-
     // Used internally by WiredTigerSessionCache
     uint64_t _getEpoch() const {
         return _epoch;
@@ -181,9 +260,10 @@ private:
     uint64_t _cursorEpoch;
     WiredTigerSessionCache* _cache;  // not owned
     WT_SESSION* _session;            // owned
-    CursorCache _cursors;            // owned
-    uint64_t _cursorGen;
+    WiredTigerCursorCache _cursors;  // owned
+    uint64_t _cursorGen;             // bumped every time the session is returned to its cache
     int _cursorsOut;
+    WiredTigerCursorCacheStats _cursorCacheStats;
     bool _dropQueuedIdentsAtSessionEnd = true;
     Date_t _idleExpireTime;
 };
@@ -305,6 +385,17 @@ public:
         return _prepareCommitOrAbortCounter.loadRelaxed();
     }
 
+    /**
+     * Returns the cursor cache statistics of every session that has been returned to this cache.
+     */
+    WiredTigerCursorCacheStats getCursorCacheStats() const;
+
+    /**
+     * Appends the cursor cache statistics, and the ratio of cursor requests served from the
+     * cache, for serverStatus.
+     */
+    void appendCursorCacheStats(BSONObjBuilder* builder) const;
+
 private:
     WiredTigerKVEngine* _engine;      // not owned, might be NULL
     WT_CONNECTION* _conn;             // not owned
@@ -341,6 +432,12 @@ private:
     // Notified when we commit to the journal.
     JournalListener* _journalListener = &NoOpJournalListener::instance;
 
+    // Totals of the cursor cache statistics of released sessions.
+    AtomicWord<long long> _cursorCacheHits{0};
+    AtomicWord<long long> _cursorCacheCrossOperationHits{0};
+    AtomicWord<long long> _cursorCacheMisses{0};
+    AtomicWord<long long> _cursorCacheEvictions{0};
+
     WT_SESSION* _waitUntilDurableSession = nullptr;  // owned, and never explicitly closed
                                                      // (uses connection close to clean up)
 
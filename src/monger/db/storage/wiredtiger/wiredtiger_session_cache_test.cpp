@@ -33,10 +33,13 @@
 #include <string>
 
 #include "monger/base/string_data.h"
+#include "monger/bson/bsonobjbuilder.h"
+#include "monger/db/storage/wiredtiger/wiredtiger_parameters_gen.h"
 #include "monger/db/storage/wiredtiger/wiredtiger_session_cache.h"
 #include "monger/db/storage/wiredtiger/wiredtiger_util.h"
 #include "monger/unittest/temp_dir.h"
 #include "monger/unittest/unittest.h"
+#include "monger/util/scopeguard.h"
 #include "monger/util/system_clock_source.h"
 
 namespace monger {
@@ -113,4 +116,59 @@ TEST(WiredTigerSessionCacheTest, CheckSessionCacheCleanup) {
     ASSERT_EQUALS(sessionCache->getIdleSessionsCount(), 0U);
 }
 
+TEST(WiredTigerSessionCacheTest, CursorCacheEvictsLeastRecentlyReleasedCursors) {
+    WiredTigerSessionCacheHarnessHelper harnessHelper("");
+    WiredTigerSessionCache* sessionCache = harnessHelper.getSessionCache();
+
+    const int oldCacheSize = gWiredTigerCursorCacheSize.load();
+    gWiredTigerCursorCacheSize.store(2);
+    ON_BLOCK_EXIT([&] { gWiredTigerCursorCacheSize.store(oldCacheSize); });
+
+    const std::vector<std::string> uris = {"table:a", "table:b", "table:c"};
+    const std::vector<uint64_t> ids = {WiredTigerSession::genTableId(),
+                                       WiredTigerSession::genTableId(),
+                                       WiredTigerSession::genTableId()};
+    {
+        UniqueWiredTigerSession session = sessionCache->getSession();
+        WT_SESSION* wtSession = session->getSession();
+        for (auto&& uri : uris) {
+            ASSERT_OK(wtRCToStatus(wtSession->create(wtSession, uri.c_str(), nullptr)));
+        }
+
+        // Release cursors on 'a', 'b' and then 'c'. Only the two most recent stay cached.
+        for (size_t i = 0; i < uris.size(); ++i) {
+            session->releaseCursor(ids[i], session->getCursor(uris[i], ids[i], true));
+        }
+        ASSERT_EQ(session->cachedCursors(), 2);
+
+        const auto& stats = session->getCursorCacheStats();
+        ASSERT_EQ(stats.misses, 3);
+        ASSERT_EQ(stats.evictions, 1);
+
+        // 'c' is still cached, so this is a hit within the same use of the session.
+        session->releaseCursor(ids[2], session->getCursor(uris[2], ids[2], true));
+        ASSERT_EQ(stats.hits, 1);
+        ASSERT_EQ(stats.crossOperationHits, 0);
+    }
+
+    {
+        UniqueWiredTigerSession session = sessionCache->getSession();
+
+        // 'b' was cached by the previous user of the session and 'a' was evicted.
+        session->releaseCursor(ids[1], session->getCursor(uris[1], ids[1], true));
+        session->releaseCursor(ids[0], session->getCursor(uris[0], ids[0], true));
+        ASSERT_EQ(session->cachedCursors(), 2);
+    }
+
+    auto stats = sessionCache->getCursorCacheStats();
+    ASSERT_EQ(stats.hits, 2);
+    ASSERT_EQ(stats.crossOperationHits, 1);
+    ASSERT_EQ(stats.misses, 4);
+    ASSERT_EQ(stats.evictions, 2);
+
+    BSONObjBuilder builder;
+    sessionCache->appendCursorCacheStats(&builder);
+    ASSERT_EQ(builder.obj()["sessionCursorCache"]["reuseRatio"].numberDouble(), 2.0 / 6);
+}
+
 }  // namespace monger
@@ -0,0 +1,375 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "monger/platform/basic.h"
+
+#include "monger/db/views/materialized_view_maintainer.h"
+
+#include <cmath>
+#include <limits>
+
+#include "monger/bson/bsonobjbuilder.h"
+#include "monger/db/matcher/expression.h"
+
+namespace monger {
+
+using boost::intrusive_ptr;
+using ParsedAggregationProjection = parsed_aggregation_projection::ParsedAggregationProjection;
+
+constexpr StringData MaterializedViewMaintainer::kCountFieldName;
+constexpr StringData MaterializedViewMaintainer::kResultFieldName;
+
+namespace {
+
+/**
+ * Returns true if the $project specification 'spec' outputs the _id of its input unchanged.
+ */
+bool keepsIdUnchanged(const BSONObj& spec) {
+    for (auto&& elem : spec) {
+        const auto fieldName = elem.fieldNameStringData();
+        if (fieldName == "_id") {
+            const bool included =
+                elem.isBoolean() ? elem.boolean() : elem.isNumber() && elem.numberDouble() != 0;
+            if (!included) {
+                return false;
+            }
+        } else if (fieldName.startsWith("_id.")) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Returns true if each accumulated field of the $group specification 'spec' uses $sum, $min or
+ * $max.
+ */
+bool hasMaintainableAccumulators(const BSONObj& spec) {
+    for (auto&& elem : spec) {
+        const auto fieldName = elem.fieldNameStringData();
+        if (fieldName == "_id") {
+            continue;
+        }
+        if (fieldName == MaterializedViewMaintainer::kCountFieldName ||
+            elem.type() != BSONType::Object || elem.Obj().nFields() != 1) {
+            return false;
+        }
+        const auto accumulator = elem.Obj().firstElementFieldNameStringData();
+        if (accumulator != "$sum" && accumulator != "$min" && accumulator != "$max") {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Returns the value which $sum adds to cancel out 'value'.
+ */
+Value negate(const Value& value) {
+    switch (value.getType()) {
+        case NumberInt:
+            return Value::createIntOrLong(-static_cast<long long>(value.getInt()));
+        case NumberLong:
+            if (value.getLong() == std::numeric_limits<long long>::min()) {
+                return Value(-static_cast<double>(value.getLong()));
+            }
+            return Value(-value.getLong());
+        case NumberDouble:
+            return Value(-value.getDouble());
+        case NumberDecimal:
+            return Value(value.getDecimal().negate());
+        default:
+            // $sum ignores non-numeric values.
+            return value;
+    }
+}
+
+/**
+ * Returns whether 'sum', maintained by adding negate(removed) to the $sum of a group, has the value
+ * and the type which recomputing the $sum over the remaining members would give. Those members are
+ * not known, so this is only the case when no remaining member could make the sum narrower:
+ * 'removed' may have been the only double or decimal member, a double may also leave rounding
+ * error behind, and a long or an integral double may come from an overflow which the removal
+ * undid.
+ */
+bool sumAfterRemovalIsExact(const Value& removed, const Value& sum) {
+    if (removed.getType() == NumberDouble || removed.getType() == NumberDecimal) {
+        return false;
+    }
+    switch (sum.getType()) {
+        case NumberLong:
+            return sum.getLong() < std::numeric_limits<int>::min() ||
+                sum.getLong() > std::numeric_limits<int>::max();
+        case NumberDouble: {
+            const double value = sum.getDouble();
+            return std::trunc(value) != value ||
+                value < static_cast<double>(std::numeric_limits<long long>::min()) ||
+                value >= -static_cast<double>(std::numeric_limits<long long>::min());
+        }
+        default:
+            return true;
+    }
+}
+
+}  // namespace
+
+MaterializedViewMaintainer::Shape MaterializedViewMaintainer::classify(
+    const std::vector<BSONObj>& pipeline) {
+    auto stage = pipeline.begin();
+    while (stage != pipeline.end() && stage->firstElementFieldNameStringData() == "$match") {
+        ++stage;
+    }
+    if (stage == pipeline.end()) {
+        return Shape::kProjection;
+    }
+    if (std::next(stage) != pipeline.end()) {
+        return Shape::kRefreshOnly;
+    }
+
+    const auto spec = stage->firstElement();
+    if (spec.type() != BSONType::Object) {
+        return Shape::kRefreshOnly;
+    }
+    if (spec.fieldNameStringData() == "$project" && keepsIdUnchanged(spec.Obj())) {
+        return Shape::kProjection;
+    }
+    if (spec.fieldNameStringData() == "$group" && hasMaintainableAccumulators(spec.Obj())) {
+        return Shape::kGroup;
+    }
+    return Shape::kRefreshOnly;
+}
+
+std::vector<BSONObj> MaterializedViewMaintainer::makeRefreshPipeline(
+    const std::vector<BSONObj>& pipeline) {
+    if (classify(pipeline) != Shape::kGroup) {
+        return pipeline;
+    }
+
+    // Count the members of each group, so that a group can be removed once it becomes empty.
+    std::vector<BSONObj> refreshPipeline(pipeline.begin(), pipeline.end() - 1);
+    BSONObjBuilder groupSpec;
+    groupSpec.appendElements(pipeline.back().firstElement().Obj());
+    groupSpec.append(kCountFieldName, BSON("$sum" << 1));
+    refreshPipeline.push_back(BSON("$group" << groupSpec.obj()));
+    return refreshPipeline;
+}
+
+std::vector<BSONObj> MaterializedViewMaintainer::makeReadPipeline(
+    const std::vector<BSONObj>& pipeline) {
+    switch (classify(pipeline)) {
+        case Shape::kProjection:
+            return {};
+        case Shape::kGroup:
+            return {BSON("$project" << BSON(kCountFieldName << 0))};
+        case Shape::kRefreshOnly:
+            return {BSON("$sort" << BSON("_id" << 1)),
+                    BSON("$replaceRoot" << BSON("newRoot"
+                                                << ("$" + kResultFieldName.toString())))};
+    }
+    MONGO_UNREACHABLE;
+}
+
+Status MaterializedViewMaintainer::validateBackingId(const Value& id) {
+    switch (id.getType()) {
+        case EOO:
+            return {ErrorCodes::BadValue, "materialized view results must have an _id"};
+        case Array:
+            return {ErrorCodes::BadValue, "can't use an array for _id"};
+        case RegEx:
+            return {ErrorCodes::BadValue, "can't use a regex for _id"};
+        case Undefined:
+            return {ErrorCodes::BadValue, "can't use a undefined for _id"};
+        default:
+            return Status::OK();
+    }
+}
+
+MaterializedViewMaintainer::MaterializedViewMaintainer(
+    const intrusive_ptr<ExpressionContext>& expCtx, const std::vector<BSONObj>& pipeline)
+    : _expCtx(expCtx) {
+    invariant(classify(pipeline) != Shape::kRefreshOnly);
+
+    for (auto&& stage : pipeline) {
+        const auto spec = stage.firstElement();
+        if (spec.fieldNameStringData() == "$match") {
+            auto match = DocumentSourceMatch::create(spec.Obj(), _expCtx);
+            uassert(ErrorCodes::OptionNotSupportedOnView,
+                    "a $text query cannot be evaluated one document at a time",
+                    !match->isTextQuery());
+            _matches.push_back(std::move(match));
+        } else if (spec.fieldNameStringData() == "$project") {
+            _project = ParsedAggregationProjection::create(
+                _expCtx,
+                spec.Obj(),
+                {ParsedAggregationProjection::ProjectionPolicies::DefaultIdPolicy::kIncludeId,
+                 ParsedAggregationProjection::ProjectionPolicies::ArrayRecursionPolicy::
+                     kRecurseNestedArrays});
+        } else {
+            invariant(spec.fieldNameStringData() == "$group");
+            _group = static_cast<DocumentSourceGroup*>(
+                DocumentSourceGroup::createFromBson(spec, _expCtx).get());
+            for (auto&& accumulatedField : _group->getAccumulatedFields()) {
+                const StringData opName =
+                    accumulatedField.makeAccumulator(_expCtx)->getOpName();
+                _accumulatorKinds.push_back(opName == "$sum"
+                                                ? AccumulatorKind::kSum
+                                                : opName == "$min" ? AccumulatorKind::kMin
+                                                                   : AccumulatorKind::kMax);
+            }
+        }
+    }
+}
+
+boost::optional<Document> MaterializedViewMaintainer::filter(const BSONObj& doc) const {
+    for (auto&& match : _matches) {
+        if (!match->getMatchExpression()->matchesBSON(doc)) {
+            return boost::none;
+        }
+    }
+    return Document(doc);
+}
+
+bool MaterializedViewMaintainer::apply(const BSONObj& before,
+                                       const BSONObj& after,
+                                       BackingStore* store) {
+    return _group ? applyGroup(before, after, store) : applyProjection(before, after, store);
+}
+
+bool MaterializedViewMaintainer::applyProjection(const BSONObj& before,
+                                                 const BSONObj& after,
+                                                 BackingStore* store) {
+    if (after.isEmpty()) {
+        store->remove(Value(before["_id"]));
+        return true;
+    }
+
+    const Value id(after["_id"]);
+    auto doc = filter(after);
+    if (!doc) {
+        store->remove(id);
+        return true;
+    }
+
+    Document result = _project ? _project->applyTransformation(*doc) : std::move(*doc);
+    if (!validateBackingId(id).isOK() || Value::compare(result["_id"], id, nullptr) != 0) {
+        return false;
+    }
+    store->upsert(result.toBson());
+    return true;
+}
+
+bool MaterializedViewMaintainer::applyGroup(const BSONObj& before,
+                                            const BSONObj& after,
+                                            BackingStore* store) {
+    boost::optional<Document> removed;
+    boost::optional<Document> added;
+    if (!before.isEmpty()) {
+        if (auto doc = filter(before)) {
+            removed = _group->groupSingleDocument(*doc);
+        }
+    }
+    if (!after.isEmpty()) {
+        if (auto doc = filter(after)) {
+            added = _group->groupSingleDocument(*doc);
+        }
+    }
+
+    // An update which does not touch the fields the view depends on leaves the groups as they are.
+    if (removed && added && removed->toBson().binaryEqual(added->toBson())) {
+        return true;
+    }
+    if (removed && !mergeIntoGroup(*removed, true, store)) {
+        return false;
+    }
+    return !added || mergeIntoGroup(*added, false, store);
+}
+
+bool MaterializedViewMaintainer::mergeIntoGroup(const Document& single,
+                                                bool remove,
+                                                BackingStore* store) {
+    const Value id = single["_id"];
+    if (!validateBackingId(id).isOK()) {
+        return false;
+    }
+
+    auto stored = store->find(id);
+    if (!stored) {
+        if (remove) {
+            // The group should exist, so the backing collection is already out of date.
+            return false;
+        }
+        MutableDocument newGroup(single);
+        newGroup.addField(kCountFieldName, Value(1));
+        store->upsert(newGroup.freeze().toBson());
+        return true;
+    }
+
+    const Document current(*stored);
+    const long long count = current[kCountFieldName].coerceToLong() + (remove ? -1 : 1);
+    if (count < 0) {
+        return false;
+    }
+    if (count == 0) {
+        store->remove(id);
+        return true;
+    }
+
+    MutableDocument updated(current);
+    const auto& accumulatedFields = _group->getAccumulatedFields();
+    for (size_t i = 0; i < accumulatedFields.size(); ++i) {
+        const auto& fieldName = accumulatedFields[i].fieldName;
+        const Value currentValue = current[fieldName];
+        const Value singleValue = single[fieldName];
+
+        if (remove && _accumulatorKinds[i] != AccumulatorKind::kSum) {
+            // The remaining members of the group are not known, so the group cannot be maintained
+            // if it loses the member holding its $min or $max.
+            if (!singleValue.nullish() &&
+                _expCtx->getValueComparator().evaluate(singleValue == currentValue)) {
+                return false;
+            }
+            continue;
+        }
+
+        auto accumulator = accumulatedFields[i].makeAccumulator(_expCtx);
+        accumulator->process(currentValue, false);
+        accumulator->process(remove ? negate(singleValue) : singleValue, false);
+        Value sum = accumulator->getValue(false);
+        if (remove && !sumAfterRemovalIsExact(singleValue, sum)) {
+            return false;
+        }
+        updated.setField(fieldName, std::move(sum));
+    }
+    updated.setField(kCountFieldName, Value::createIntOrLong(count));
+    store->upsert(updated.freeze().toBson());
+    return true;
+}
+
+}  // namespace monger
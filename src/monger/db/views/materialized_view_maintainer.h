@@ -0,0 +1,157 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "monger/base/string_data.h"
+#include "monger/bson/bsonobj.h"
+#include "monger/db/pipeline/document.h"
+#include "monger/db/pipeline/document_source_group.h"
+#include "monger/db/pipeline/document_source_match.h"
+#include "monger/db/pipeline/expression_context.h"
+#include "monger/db/pipeline/parsed_aggregation_projection.h"
+#include "monger/db/pipeline/value.h"
+
+namespace monger {
+
+/**
+ * Keeps the backing collection of a materialized view up to date as single documents of the
+ * collection the view is defined on are inserted, updated and deleted.
+ *
+ * Only pipelines made of leading $match stages followed by at most one $project, or by a $group
+ * whose accumulators are all $sum, $min or $max, can be maintained this way. The backing
+ * collection of any other view is only brought up to date by a refresh.
+ */
+class MaterializedViewMaintainer {
+public:
+    /**
+     * How the results of a view are stored in its backing collection.
+     */
+    enum class Shape {
+        // Each result is stored as is, under the _id of the source document it was computed from.
+        kProjection,
+        // Each group is stored as is, along with the number of source documents in the group.
+        kGroup,
+        // Each result is stored under the field 'kResultFieldName' of a document whose _id is its
+        // position in the output of the view.
+        kRefreshOnly,
+    };
+
+    /**
+     * Read and write access to the backing collection of a view, by _id.
+     */
+    class BackingStore {
+    public:
+        virtual ~BackingStore() = default;
+
+        virtual boost::optional<BSONObj> find(const Value& id) = 0;
+        virtual void upsert(const BSONObj& doc) = 0;
+        virtual void remove(const Value& id) = 0;
+    };
+
+    // The field of a group document that counts the source documents in the group. It is hidden
+    // from readers of the view.
+    static constexpr StringData kCountFieldName = "__materializedViewCount"_sd;
+
+    // The field holding a result of a view with shape kRefreshOnly.
+    static constexpr StringData kResultFieldName = "result"_sd;
+
+    /**
+     * Returns how the results of a view defined by 'pipeline' are stored. This only looks at the
+     * names of the stages and accumulators, so it is cheap enough to call on every read.
+     */
+    static Shape classify(const std::vector<BSONObj>& pipeline);
+
+    /**
+     * Returns the pipeline which computes the contents of the backing collection from the
+     * collection the view is defined on.
+     */
+    static std::vector<BSONObj> makeRefreshPipeline(const std::vector<BSONObj>& pipeline);
+
+    /**
+     * Returns the pipeline which computes the results of the view from its backing collection.
+     */
+    static std::vector<BSONObj> makeReadPipeline(const std::vector<BSONObj>& pipeline);
+
+    /**
+     * Returns an error if 'id' is not allowed as the _id of a document in the backing collection.
+     */
+    static Status validateBackingId(const Value& id);
+
+    /**
+     * Parses 'pipeline', which must classify as kProjection or kGroup. Throws if the stages use a
+     * feature which cannot be evaluated one document at a time, such as $text.
+     */
+    MaterializedViewMaintainer(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                               const std::vector<BSONObj>& pipeline);
+
+    /**
+     * Applies the change of a single source document from 'before' to 'after' to 'store'. An
+     * insert has an empty 'before' and a delete an empty 'after'.
+     *
+     * Returns false if the change cannot be applied incrementally, for instance when the document
+     * holding the $min of a group is deleted. The backing collection is then out of date, and
+     * possibly partially updated, until the view is refreshed.
+     */
+    bool apply(const BSONObj& before, const BSONObj& after, BackingStore* store);
+
+private:
+    enum class AccumulatorKind { kSum, kMin, kMax };
+
+    /**
+     * Returns 'doc' as seen by the stage after the leading $match stages, or boost::none if one of
+     * them filters it out.
+     */
+    boost::optional<Document> filter(const BSONObj& doc) const;
+
+    bool applyProjection(const BSONObj& before, const BSONObj& after, BackingStore* store);
+    bool applyGroup(const BSONObj& before, const BSONObj& after, BackingStore* store);
+
+    /**
+     * Adds the group formed by a single source document, 'single', to the stored group it belongs
+     * to, or removes it from that group if 'remove' is true.
+     */
+    bool mergeIntoGroup(const Document& single, bool remove, BackingStore* store);
+
+    boost::intrusive_ptr<ExpressionContext> _expCtx;
+    std::vector<boost::intrusive_ptr<DocumentSourceMatch>> _matches;
+
+    // Set for the kProjection shape if the pipeline ends with a $project.
+    std::unique_ptr<parsed_aggregation_projection::ParsedAggregationProjection> _project;
+
+    // Set for the kGroup shape, along with the kind of each of its accumulated fields.
+    boost::intrusive_ptr<DocumentSourceGroup> _group;
+    std::vector<AccumulatorKind> _accumulatorKinds;
+};
+
+}  // namespace monger
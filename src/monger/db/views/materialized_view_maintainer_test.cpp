@@ -0,0 +1,326 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "monger/platform/basic.h"
+
+#include <limits>
+#include <map>
+
+#include "monger/bson/bsonmisc.h"
+#include "monger/bson/bsonobjbuilder.h"
+#include "monger/db/json.h"
+#include "monger/db/pipeline/document_source_mock.h"
+#include "monger/db/pipeline/document_value_test_util.h"
+#include "monger/db/pipeline/expression_context_for_test.h"
+#include "monger/db/pipeline/pipeline.h"
+#include "monger/db/views/materialized_view_maintainer.h"
+#include "monger/platform/random.h"
+#include "monger/unittest/unittest.h"
+
+namespace monger {
+namespace {
+
+using Shape = MaterializedViewMaintainer::Shape;
+
+/**
+ * A backing store which keeps its documents in memory, ordered by _id.
+ */
+class MapBackingStore final : public MaterializedViewMaintainer::BackingStore {
+public:
+    boost::optional<BSONObj> find(const Value& id) final {
+        auto it = _docs.find(id);
+        if (it == _docs.end()) {
+            return boost::none;
+        }
+        return it->second;
+    }
+
+    void upsert(const BSONObj& doc) final {
+        _docs[Value(doc["_id"])] = doc.getOwned();
+    }
+
+    void remove(const Value& id) final {
+        _docs.erase(id);
+    }
+
+    std::vector<Document> contents() const {
+        std::vector<Document> docs;
+        for (auto&& entry : _docs) {
+            docs.push_back(Document(entry.second));
+        }
+        return docs;
+    }
+
+private:
+    ValueMap<BSONObj> _docs = ValueComparator::kInstance.makeOrderedValueMap<BSONObj>();
+};
+
+std::vector<BSONObj> parsePipeline(const std::string& json) {
+    std::vector<BSONObj> pipeline;
+    for (auto&& stage : fromjson("{pipeline: " + json + "}")["pipeline"].Obj()) {
+        pipeline.push_back(stage.Obj().getOwned());
+    }
+    return pipeline;
+}
+
+/**
+ * Returns the contents of the backing collection of the view defined by 'pipeline' on a collection
+ * holding 'source', computed from scratch and ordered by _id.
+ */
+std::vector<Document> recompute(const boost::intrusive_ptr<ExpressionContextForTest>& expCtx,
+                                const std::vector<BSONObj>& pipeline,
+                                const std::map<int, BSONObj>& source) {
+    std::deque<DocumentSource::GetNextResult> inputs;
+    for (auto&& entry : source) {
+        inputs.emplace_back(Document(entry.second));
+    }
+    auto refreshPipeline = MaterializedViewMaintainer::makeRefreshPipeline(pipeline);
+    refreshPipeline.push_back(BSON("$sort" << BSON("_id" << 1)));
+    auto parsed = uassertStatusOK(Pipeline::parse(refreshPipeline, expCtx));
+    parsed->addInitialSource(DocumentSourceMock::createForTest(std::move(inputs)));
+
+    std::vector<Document> results;
+    while (auto next = parsed->getNext()) {
+        results.push_back(*next);
+    }
+    return results;
+}
+
+void assertSameContents(const std::vector<Document>& actual, const std::vector<Document>& expected) {
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+        ASSERT_DOCUMENT_EQ(actual[i], expected[i]);
+    }
+}
+
+TEST(MaterializedViewMaintainerTest, ClassifiesPipelines) {
+    ASSERT(MaterializedViewMaintainer::classify({}) == Shape::kProjection);
+    ASSERT(MaterializedViewMaintainer::classify(parsePipeline("[{$match: {a: 1}}]")) ==
+           Shape::kProjection);
+    ASSERT(MaterializedViewMaintainer::classify(
+               parsePipeline("[{$match: {a: 1}}, {$project: {a: 1, b: {$add: ['$a', 1]}}}]")) ==
+           Shape::kProjection);
+    ASSERT(MaterializedViewMaintainer::classify(
+               parsePipeline("[{$group: {_id: '$k', s: {$sum: '$v'}, m: {$min: '$v'}}}]")) ==
+           Shape::kGroup);
+
+    // The _id of a projected document must be the _id of its source document.
+    ASSERT(MaterializedViewMaintainer::classify(parsePipeline("[{$project: {_id: 0, a: 1}}]")) ==
+           Shape::kRefreshOnly);
+    ASSERT(MaterializedViewMaintainer::classify(
+               parsePipeline("[{$project: {'_id.x': 1}}]")) == Shape::kRefreshOnly);
+    ASSERT(MaterializedViewMaintainer::classify(
+               parsePipeline("[{$group: {_id: '$k', a: {$avg: '$v'}}}]")) == Shape::kRefreshOnly);
+    ASSERT(MaterializedViewMaintainer::classify(
+               parsePipeline("[{$group: {_id: '$k'}}, {$match: {_id: 1}}]")) ==
+           Shape::kRefreshOnly);
+    ASSERT(MaterializedViewMaintainer::classify(parsePipeline("[{$sort: {a: 1}}]")) ==
+           Shape::kRefreshOnly);
+}
+
+TEST(MaterializedViewMaintainerTest, GroupViewsCountTheMembersOfEachGroup) {
+    auto pipeline = parsePipeline("[{$match: {a: 1}}, {$group: {_id: '$k', s: {$sum: '$v'}}}]");
+    auto refreshPipeline = MaterializedViewMaintainer::makeRefreshPipeline(pipeline);
+    ASSERT_EQ(refreshPipeline.size(), 2U);
+    ASSERT_BSONOBJ_EQ(refreshPipeline[0], pipeline[0]);
+    ASSERT_BSONOBJ_EQ(refreshPipeline[1],
+                      fromjson("{$group: {_id: '$k', s: {$sum: '$v'}, "
+                               "__materializedViewCount: {$sum: 1}}}"));
+
+    auto readPipeline = MaterializedViewMaintainer::makeReadPipeline(pipeline);
+    ASSERT_EQ(readPipeline.size(), 1U);
+    ASSERT_BSONOBJ_EQ(readPipeline[0], fromjson("{$project: {__materializedViewCount: 0}}"));
+}
+
+TEST(MaterializedViewMaintainerTest, RefreshOnlyViewsAreReadInResultOrder) {
+    auto pipeline = parsePipeline("[{$sort: {a: -1}}, {$limit: 10}]");
+    ASSERT_EQ(MaterializedViewMaintainer::makeRefreshPipeline(pipeline).size(), 2U);
+    auto readPipeline = MaterializedViewMaintainer::makeReadPipeline(pipeline);
+    ASSERT_EQ(readPipeline.size(), 2U);
+    ASSERT_BSONOBJ_EQ(readPipeline[0], fromjson("{$sort: {_id: 1}}"));
+    ASSERT_BSONOBJ_EQ(readPipeline[1], fromjson("{$replaceRoot: {newRoot: '$result'}}"));
+}
+
+TEST(MaterializedViewMaintainerTest, ProjectionFollowsInsertsUpdatesAndDeletes) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    auto pipeline =
+        parsePipeline("[{$match: {a: {$gt: 0}}}, {$project: {b: {$multiply: ['$a', 2]}}}]");
+    MaterializedViewMaintainer maintainer(expCtx, pipeline);
+    MapBackingStore store;
+
+    ASSERT_TRUE(maintainer.apply(BSONObj(), fromjson("{_id: 1, a: 1}"), &store));
+    ASSERT_TRUE(maintainer.apply(BSONObj(), fromjson("{_id: 2, a: -1}"), &store));
+    assertSameContents(store.contents(), {Document(fromjson("{_id: 1, b: 2}"))});
+
+    // An update can move a document into or out of the view.
+    ASSERT_TRUE(maintainer.apply(fromjson("{_id: 2, a: -1}"), fromjson("{_id: 2, a: 3}"), &store));
+    ASSERT_TRUE(maintainer.apply(fromjson("{_id: 1, a: 1}"), fromjson("{_id: 1, a: 0}"), &store));
+    assertSameContents(store.contents(), {Document(fromjson("{_id: 2, b: 6}"))});
+
+    ASSERT_TRUE(maintainer.apply(fromjson("{_id: 2, a: 3}"), BSONObj(), &store));
+    ASSERT_TRUE(store.contents().empty());
+}
+
+TEST(MaterializedViewMaintainerTest, SumGroupsMatchRecomputationAfterRandomChanges) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    auto pipeline = parsePipeline(
+        "[{$match: {v: {$gte: 2}}}, {$group: {_id: '$k', total: {$sum: '$v'}, n: {$sum: 1}}}]");
+    MaterializedViewMaintainer maintainer(expCtx, pipeline);
+    MapBackingStore store;
+    std::map<int, BSONObj> source;
+
+    PseudoRandom random(17);
+    for (int i = 0; i < 500; ++i) {
+        const int id = random.nextInt32(40);
+        BSONObj after;
+        // Deletes are rarer than inserts and updates, so that the groups do not stay empty.
+        if (random.nextInt32(4) != 0) {
+            after = BSON("_id" << id << "k" << random.nextInt32(5) << "v" << random.nextInt32(10));
+        }
+
+        auto it = source.find(id);
+        BSONObj before = it == source.end() ? BSONObj() : it->second;
+        if (before.isEmpty() && after.isEmpty()) {
+            continue;
+        }
+        ASSERT_TRUE(maintainer.apply(before, after, &store));
+        if (after.isEmpty()) {
+            source.erase(id);
+        } else {
+            source[id] = after;
+        }
+
+        assertSameContents(store.contents(), recompute(expCtx, pipeline, source));
+    }
+}
+
+TEST(MaterializedViewMaintainerTest, UpdateOutsideTheGroupFieldsLeavesTheGroupsUnchanged) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    auto pipeline = parsePipeline("[{$group: {_id: '$k', lo: {$min: '$v'}}}]");
+    MaterializedViewMaintainer maintainer(expCtx, pipeline);
+    MapBackingStore store;
+
+    ASSERT_TRUE(maintainer.apply(BSONObj(), fromjson("{_id: 1, k: 1, v: 5}"), &store));
+    ASSERT_TRUE(maintainer.apply(
+        fromjson("{_id: 1, k: 1, v: 5}"), fromjson("{_id: 1, k: 1, v: 5, other: 1}"), &store));
+    assertSameContents(store.contents(),
+                       {Document(fromjson("{_id: 1, lo: 5, __materializedViewCount: 1}"))});
+}
+
+TEST(MaterializedViewMaintainerTest, RemovingTheExtremeOfAGroupCannotBeMaintained) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    auto pipeline = parsePipeline("[{$group: {_id: '$k', lo: {$min: '$v'}, hi: {$max: '$v'}}}]");
+    MaterializedViewMaintainer maintainer(expCtx, pipeline);
+    MapBackingStore store;
+
+    ASSERT_TRUE(maintainer.apply(BSONObj(), fromjson("{_id: 1, k: 1, v: 5}"), &store));
+    ASSERT_TRUE(maintainer.apply(BSONObj(), fromjson("{_id: 2, k: 1, v: 3}"), &store));
+    ASSERT_TRUE(maintainer.apply(BSONObj(), fromjson("{_id: 3, k: 1, v: 4}"), &store));
+    assertSameContents(
+        store.contents(),
+        {Document(fromjson("{_id: 1, lo: 3, hi: 5, __materializedViewCount: 3}"))});
+
+    // Removing a member which holds neither extreme only updates the count.
+    ASSERT_TRUE(maintainer.apply(fromjson("{_id: 3, k: 1, v: 4}"), BSONObj(), &store));
+    assertSameContents(
+        store.contents(),
+        {Document(fromjson("{_id: 1, lo: 3, hi: 5, __materializedViewCount: 2}"))});
+
+    ASSERT_FALSE(maintainer.apply(fromjson("{_id: 2, k: 1, v: 3}"), BSONObj(), &store));
+}
+
+TEST(MaterializedViewMaintainerTest, RemovingFromASumOnlyKeepsTypesARecomputationWouldGive) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    auto pipeline = parsePipeline("[{$group: {_id: '$k', s: {$sum: '$v'}}}]");
+    MaterializedViewMaintainer maintainer(expCtx, pipeline);
+    MapBackingStore store;
+    std::map<int, BSONObj> source;
+
+    auto apply = [&](int id, const BSONObj& after) {
+        auto it = source.find(id);
+        BSONObj before = it == source.end() ? BSONObj() : it->second;
+        const bool maintained = maintainer.apply(before, after, &store);
+        if (after.isEmpty()) {
+            source.erase(id);
+        } else {
+            source[id] = after;
+        }
+        return maintained;
+    };
+    auto assertMatchesRecomputation = [&] {
+        auto expected = recompute(expCtx, pipeline, source);
+        assertSameContents(store.contents(), expected);
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_EQ(store.contents()[i]["s"].getType(), expected[i]["s"].getType());
+        }
+    };
+
+    // Removing an int from a group of ints keeps an int.
+    ASSERT_TRUE(apply(1, BSON("_id" << 1 << "k" << 1 << "v" << 2)));
+    ASSERT_TRUE(apply(2, BSON("_id" << 2 << "k" << 1 << "v" << 3)));
+    ASSERT_TRUE(apply(3, BSON("_id" << 3 << "k" << 1 << "v" << 4)));
+    ASSERT_TRUE(apply(3, BSONObj()));
+    assertMatchesRecomputation();
+
+    // Removing a double, or a decimal, may leave a group with no member of that type.
+    ASSERT_TRUE(apply(3, BSON("_id" << 3 << "k" << 1 << "v" << 0.1)));
+    ASSERT_FALSE(apply(3, BSONObj()));
+    ASSERT_TRUE(apply(4, BSON("_id" << 4 << "k" << 2 << "v" << Decimal128("1"))));
+    ASSERT_TRUE(apply(5, BSON("_id" << 5 << "k" << 2 << "v" << 1)));
+    ASSERT_FALSE(apply(4, BSONObj()));
+
+    // Removing a long, or undoing an overflow, may leave a sum which fits in an int.
+    ASSERT_TRUE(apply(6, BSON("_id" << 6 << "k" << 3 << "v" << 5LL)));
+    ASSERT_TRUE(apply(7, BSON("_id" << 7 << "k" << 3 << "v" << 1)));
+    ASSERT_FALSE(apply(6, BSONObj()));
+    ASSERT_TRUE(apply(8, BSON("_id" << 8 << "k" << 4 << "v" << std::numeric_limits<int>::max())));
+    ASSERT_TRUE(apply(9, BSON("_id" << 9 << "k" << 4 << "v" << 1)));
+    ASSERT_FALSE(apply(9, BSONObj()));
+}
+
+TEST(MaterializedViewMaintainerTest, RemovingFromAMissingGroupCannotBeMaintained) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    MaterializedViewMaintainer maintainer(
+        expCtx, parsePipeline("[{$group: {_id: '$k', s: {$sum: '$v'}}}]"));
+    MapBackingStore store;
+    ASSERT_FALSE(maintainer.apply(fromjson("{_id: 1, k: 1, v: 5}"), BSONObj(), &store));
+}
+
+TEST(MaterializedViewMaintainerTest, ArrayGroupKeysCannotBeStored) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    MaterializedViewMaintainer maintainer(
+        expCtx, parsePipeline("[{$group: {_id: '$k', s: {$sum: '$v'}}}]"));
+    MapBackingStore store;
+    ASSERT_FALSE(maintainer.apply(BSONObj(), fromjson("{_id: 1, k: [1, 2], v: 5}"), &store));
+    ASSERT_TRUE(store.contents().empty());
+}
+
+}  // namespace
+}  // namespace monger
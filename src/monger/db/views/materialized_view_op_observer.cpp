@@ -0,0 +1,381 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongerdb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::monger::logger::LogComponent::kStorage
+
+#include "monger/platform/basic.h"
+
+#include "monger/db/views/materialized_view_op_observer.h"
+
+#include "monger/db/catalog/collection.h"
+#include "monger/db/catalog/database.h"
+#include "monger/db/catalog/database_holder.h"
+#include "monger/db/catalog_raii.h"
+#include "monger/db/client.h"
+#include "monger/db/concurrency/d_concurrency.h"
+#include "monger/db/concurrency/write_conflict_exception.h"
+#include "monger/db/dbhelpers.h"
+#include "monger/db/operation_context.h"
+#include "monger/db/pipeline/expression_context.h"
+#include "monger/db/repl/replication_coordinator.h"
+#include "monger/db/service_context.h"
+#include "monger/db/views/materialized_view_maintainer.h"
+#include "monger/db/views/view_catalog.h"
+#include "monger/util/concurrency/thread_pool.h"
+#include "monger/util/log.h"
+
+namespace monger {
+
+namespace {
+
+// The document about to be deleted, saved by aboutToDelete() for onDelete() when the collection it
+// is deleted from has materialized views.
+const auto documentToDelete = OperationContext::declareDecoration<boost::optional<BSONObj>>();
+
+/**
+ * Reads and writes the backing collection of a view by _id, in the unit of work of the observed
+ * write.
+ */
+class CollectionBackingStore final : public MaterializedViewMaintainer::BackingStore {
+public:
+    CollectionBackingStore(OperationContext* opCtx, Collection* collection)
+        : _opCtx(opCtx), _collection(collection) {}
+
+    boost::optional<BSONObj> find(const Value& id) final {
+        RecordId rid = Helpers::findById(_opCtx, _collection, BSON("_id" << id));
+        if (rid.isNull()) {
+            return boost::none;
+        }
+        return _collection->docFor(_opCtx, rid).value().getOwned();
+    }
+
+    void upsert(const BSONObj& doc) final {
+        BSONObj idQuery = doc["_id"].wrap();
+        RecordId rid = Helpers::findById(_opCtx, _collection, idQuery);
+        if (rid.isNull()) {
+            uassertStatusOK(_collection->insertDocument(_opCtx, InsertStatement(doc), nullptr));
+            return;
+        }
+
+        CollectionUpdateArgs args;
+        args.update = doc;
+        args.criteria = idQuery;
+        _collection->updateDocument(
+            _opCtx, rid, _collection->docFor(_opCtx, rid), doc, true, nullptr, &args);
+    }
+
+    void remove(const Value& id) final {
+        RecordId rid = Helpers::findById(_opCtx, _collection, BSON("_id" << id));
+        if (!rid.isNull()) {
+            _collection->deleteDocument(_opCtx, kUninitializedStmtId, rid, nullptr);
+        }
+    }
+
+private:
+    OperationContext* _opCtx;
+    Collection* _collection;
+};
+
+/**
+ * Returns the materialized views on 'nss' which are kept up to date by this node, which are those
+ * that are not stale on a node accepting writes.
+ */
+std::vector<std::shared_ptr<ViewDefinition>> lookupViews(OperationContext* opCtx,
+                                                         const NamespaceString& nss) {
+    if (!opCtx->writesAreReplicated() || nss.isSystem()) {
+        return {};
+    }
+    auto db = DatabaseHolder::get(opCtx)->getDb(opCtx, nss.db());
+    if (!db) {
+        return {};
+    }
+
+    auto views = ViewCatalog::get(db)->lookupMaterializedViewsOn(opCtx, nss);
+    views.erase(std::remove_if(views.begin(),
+                               views.end(),
+                               [](const std::shared_ptr<ViewDefinition>& view) {
+                                   return view->isStale();
+                               }),
+                views.end());
+    return views;
+}
+
+/**
+ * Records in system.views that the materialized views 'viewNames' are stale, each in its own unit
+ * of work. A view which has been dropped or refreshed meanwhile is skipped.
+ */
+void persistStaleViews(OperationContext* opCtx, const std::vector<NamespaceString>& viewNames) {
+    for (auto&& viewName : viewNames) {
+        try {
+            AutoGetDb autoDb(opCtx, viewName.db(), MODE_IX);
+            auto db = autoDb.getDb();
+            if (!db) {
+                continue;
+            }
+            writeConflictRetry(opCtx, "markMaterializedViewStale", viewName.ns(), [&] {
+                WriteUnitOfWork wuow(opCtx);
+                Lock::CollectionLock viewLock(opCtx, viewName, MODE_IX);
+                // Operations all lock system.views in the end to prevent deadlock.
+                Lock::CollectionLock systemViewsLock(opCtx, db->getSystemViewsName(), MODE_X);
+                uassert(ErrorCodes::NotMaster,
+                        "Not primary while marking a materialized view stale",
+                        repl::ReplicationCoordinator::get(opCtx)->canAcceptWritesFor(opCtx,
+                                                                                     viewName));
+
+                // A view which is no longer stale has been refreshed since, from a snapshot which
+                // includes the write that made it stale.
+                auto catalog = ViewCatalog::get(db);
+                auto view = catalog->lookup(opCtx, viewName.ns());
+                if (!view || !view->isMaterialized() || !view->isStale()) {
+                    return;
+                }
+                uassertStatusOK(catalog->setMaterializedViewStale(opCtx, viewName, true));
+                wuow.commit();
+            });
+        } catch (const DBException& ex) {
+            warning() << "could not record that materialized view " << viewName
+                      << " is stale: " << redact(ex);
+        }
+    }
+}
+
+struct StaleViewsExecutor {
+    StaleViewsExecutor()
+        : threadPool([] {
+              ThreadPool::Options options;
+              options.threadNamePrefix = "MaterializedViewStale";
+              options.minThreads = 0;
+              options.maxThreads = 1;
+              return options;
+          }()) {}
+
+    ThreadPool threadPool;
+};
+
+const auto staleViewsExecutor = ServiceContext::declareDecoration<StaleViewsExecutor>();
+const ServiceContext::ConstructorActionRegisterer staleViewsExecutorRegisterer{
+    "MaterializedViewStaleExecutor",
+    [](ServiceContext* service) { staleViewsExecutor(service).threadPool.startup(); },
+    [](ServiceContext* service) {
+        auto& pool = staleViewsExecutor(service).threadPool;
+        pool.shutdown();
+        pool.join();
+    }};
+
+/**
+ * Marks the materialized views 'viewNames' of 'catalog' stale once the write which could not be
+ * applied to them commits. They are read through their pipelines from then on. Their entries in
+ * system.views are written afterwards by another client, so that the write, which may be part of a
+ * transaction, neither writes system.views nor holds its exclusive lock.
+ */
+void markStale(OperationContext* opCtx,
+               ViewCatalog* catalog,
+               std::vector<NamespaceString> viewNames) {
+    if (viewNames.empty()) {
+        return;
+    }
+
+    opCtx->recoveryUnit()->onCommit([
+        service = opCtx->getServiceContext(),
+        catalog,
+        viewNames = std::move(viewNames)
+    ](boost::optional<Timestamp>) mutable {
+        for (auto&& viewName : viewNames) {
+            catalog->noteMaterializedViewStale(viewName);
+            LOG(1) << "materialized view " << viewName << " is stale until it is refreshed";
+        }
+
+        staleViewsExecutor(service).threadPool.schedule(
+            [ service, viewNames = std::move(viewNames) ](auto status) {
+                if (!status.isOK()) {
+                    return;
+                }
+                ThreadClient tc("MaterializedViewStale", service);
+                auto uniqueOpCtx = tc->makeOperationContext();
+                persistStaleViews(uniqueOpCtx.get(), viewNames);
+            });
+    });
+}
+
+/**
+ * Applies the changes of the documents of 'nss' from 'changes[i].first' to 'changes[i].second' to
+ * the backing collections of its materialized views. Views which cannot follow the changes are
+ * marked stale.
+ */
+void maintainViews(OperationContext* opCtx,
+                   const NamespaceString& nss,
+                   const std::vector<std::pair<BSONObj, BSONObj>>& changes) {
+    auto views = lookupViews(opCtx, nss);
+    if (views.empty()) {
+        return;
+    }
+
+    auto db = DatabaseHolder::get(opCtx)->getDb(opCtx, nss.db());
+    std::vector<NamespaceString> staleViews;
+    for (auto&& view : views) {
+        Lock::CollectionLock backingLock(opCtx, view->backingNss(), MODE_IX);
+        auto backingColl = db->getCollection(opCtx, view->backingNss());
+
+        bool applied = backingColl &&
+            MaterializedViewMaintainer::classify(view->pipeline()) !=
+                MaterializedViewMaintainer::Shape::kRefreshOnly;
+        if (applied) {
+            try {
+                boost::intrusive_ptr<ExpressionContext> expCtx(
+                    new ExpressionContext(opCtx, nullptr));
+                expCtx->ns = nss;
+                MaterializedViewMaintainer maintainer(expCtx, view->pipeline());
+                CollectionBackingStore store(opCtx, backingColl);
+                for (auto&& change : changes) {
+                    if (!(applied = maintainer.apply(change.first, change.second, &store))) {
+                        break;
+                    }
+                }
+            } catch (const WriteConflictException&) {
+                throw;
+            } catch (const DBException& ex) {
+                LOG(1) << "cannot maintain materialized view " << view->name() << ": "
+                       << redact(ex);
+                applied = false;
+            }
+        }
+        if (!applied) {
+            staleViews.push_back(view->name());
+        }
+    }
+
+    markStale(opCtx, ViewCatalog::get(db), std::move(staleViews));
+}
+
+/**
+ * Marks the materialized views on 'nss' stale after a change to the collection as a whole.
+ */
+void invalidateViews(OperationContext* opCtx, const NamespaceString& nss) {
+    std::vector<NamespaceString> staleViews;
+    for (auto&& view : lookupViews(opCtx, nss)) {
+        staleViews.push_back(view->name());
+    }
+    if (staleViews.empty()) {
+        return;
+    }
+    auto db = DatabaseHolder::get(opCtx)->getDb(opCtx, nss.db());
+    markStale(opCtx, ViewCatalog::get(db), std::move(staleViews));
+}
+
+}  // namespace
+
+bool MaterializedViewOpObserver::needsPreImages(OperationContext* opCtx,
+                                                const NamespaceString& nss) {
+    return !lookupViews(opCtx, nss).empty();
+}
+
+void MaterializedViewOpObserver::onInserts(OperationContext* opCtx,
+                                           const NamespaceString& nss,
+                                           OptionalCollectionUUID uuid,
+                                           std::vector<InsertStatement>::const_iterator first,
+                                           std::vector<InsertStatement>::const_iterator last,
+                                           bool fromMigrate) {
+    std::vector<std::pair<BSONObj, BSONObj>> changes;
+    for (auto it = first; it != last; ++it) {
+        changes.emplace_back(BSONObj(), it->doc);
+    }
+    maintainViews(opCtx, nss, changes);
+}
+
+void MaterializedViewOpObserver::onUpdate(OperationContext* opCtx,
+                                          const OplogUpdateEntryArgs& args) {
+    if (!args.updateArgs.preImageDoc) {
+        invalidateViews(opCtx, args.nss);
+        return;
+    }
+    maintainViews(opCtx, args.nss, {{*args.updateArgs.preImageDoc, args.updateArgs.updatedDoc}});
+}
+
+void MaterializedViewOpObserver::aboutToDelete(OperationContext* opCtx,
+                                               const NamespaceString& nss,
+                                               const BSONObj& doc) {
+    auto& saved = documentToDelete(opCtx);
+    saved = boost::none;
+    if (!lookupViews(opCtx, nss).empty()) {
+        saved = doc.getOwned();
+    }
+}
+
+void MaterializedViewOpObserver::onDelete(OperationContext* opCtx,
+                                          const NamespaceString& nss,
+                                          OptionalCollectionUUID uuid,
+                                          StmtId stmtId,
+                                          bool fromMigrate,
+                                          const boost::optional<BSONObj>& deletedDoc) {
+    auto& saved = documentToDelete(opCtx);
+    if (!saved) {
+        return;
+    }
+    BSONObj doc = std::move(*saved);
+    saved = boost::none;
+    maintainViews(opCtx, nss, {{doc, BSONObj()}});
+}
+
+repl::OpTime MaterializedViewOpObserver::onDropCollection(OperationContext* opCtx,
+                                                          const NamespaceString& collectionName,
+                                                          OptionalCollectionUUID uuid,
+                                                          std::uint64_t numRecords,
+                                                          CollectionDropType dropType) {
+    invalidateViews(opCtx, collectionName);
+    return {};
+}
+
+void MaterializedViewOpObserver::onRenameCollection(OperationContext* opCtx,
+                                                    const NamespaceString& fromCollection,
+                                                    const NamespaceString& toCollection,
+                                                    OptionalCollectionUUID uuid,
+                                                    OptionalCollectionUUID dropTargetUUID,
+                                                    std::uint64_t numRecords,
+                                                    bool stayTemp) {
+    postRenameCollection(opCtx, fromCollection, toCollection, uuid, dropTargetUUID, stayTemp);
+}
+
+void MaterializedViewOpObserver::postRenameCollection(OperationContext* opCtx,
+                                                      const NamespaceString& fromCollection,
+                                                      const NamespaceString& toCollection,
+                                                      OptionalCollectionUUID uuid,
+                                                      OptionalCollectionUUID dropTargetUUID,
+                                                      bool stayTemp) {
+    invalidateViews(opCtx, fromCollection);
+    invalidateViews(opCtx, toCollection);
+}
+
+void MaterializedViewOpObserver::onEmptyCapped(OperationContext* opCtx,
+                                               const NamespaceString& collectionName,
+                                               OptionalCollectionUUID uuid) {
+    invalidateViews(opCtx, collectionName);
+}
+
+}  // namespace monger
@@ -52,17 +52,29 @@ ViewDefinition::ViewDefinition(const ViewDefinition& other)
     : _viewNss(other._viewNss),
       _viewOnNss(other._viewOnNss),
       _collator(CollatorInterface::cloneCollator(other._collator.get())),
-      _pipeline(other._pipeline) {}
+      _pipeline(other._pipeline),
+      _materialized(other._materialized),
+      _stale(other._stale),
+      _backingNss(other._backingNss) {}
 
 ViewDefinition& ViewDefinition::operator=(const ViewDefinition& other) {
     _viewNss = other._viewNss;
     _viewOnNss = other._viewOnNss;
     _collator = CollatorInterface::cloneCollator(other._collator.get());
     _pipeline = other._pipeline;
+    _materialized = other._materialized;
+    _stale = other._stale;
+    _backingNss = other._backingNss;
 
     return *this;
 }
 
+NamespaceString ViewDefinition::makeBackingNss(const NamespaceString& viewNss) {
+    return NamespaceString(viewNss.db(),
+                           NamespaceString::kSystemDotMaterializedPrefix.toString() +
+                               viewNss.coll().toString());
+}
+
 void ViewDefinition::setViewOn(const NamespaceString& viewOnNss) {
     invariant(_viewNss.db() == viewOnNss.db());
     _viewOnNss = viewOnNss;
@@ -76,4 +88,10 @@ void ViewDefinition::setPipeline(const BSONElement& pipeline) {
         _pipeline.push_back(value.copy());
     }
 }
+
+void ViewDefinition::setMaterialized(bool stale) {
+    _materialized = true;
+    _stale = stale;
+    _backingNss = makeBackingNss(_viewNss);
+}
 }  // namespace monger
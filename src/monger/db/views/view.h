@@ -90,8 +90,45 @@ public:
         return _collator.get();
     }
 
+    /**
+     * Returns true if the results of this view are stored in the collection backingNss() instead
+     * of being computed on every read.
+     */
+    bool isMaterialized() const {
+        return _materialized;
+    }
+
+    /**
+     * Returns true if the backing collection of this materialized view may have missed changes to
+     * the collection the view is defined on. A stale view is read by running its pipeline until it
+     * is refreshed.
+     */
+    bool isStale() const {
+        return _stale;
+    }
+
+    /**
+     * @return The fully-qualified namespace of the collection storing the results of this
+     * materialized view.
+     */
+    const NamespaceString& backingNss() const {
+        return _backingNss;
+    }
+
+    /**
+     * Returns the namespace of the collection storing the results of the materialized view
+     * 'viewNss'.
+     */
+    static NamespaceString makeBackingNss(const NamespaceString& viewNss);
+
     void setViewOn(const NamespaceString& viewOnNss);
 
+    /**
+     * Makes this view a materialized view, whose backing collection is out of date if 'stale' is
+     * true.
+     */
+    void setMaterialized(bool stale);
+
     /**
      * Pipeline must be of type array.
      */
@@ -102,5 +139,8 @@ private:
     NamespaceString _viewOnNss;
     std::unique_ptr<CollatorInterface> _collator;
     std::vector<BSONObj> _pipeline;
+    bool _materialized = false;
+    bool _stale = false;
+    NamespaceString _backingNss;
 };
 }  // namespace monger
@@ -51,6 +51,7 @@
 #include "monger/db/pipeline/stub_monger_process_interface.h"
 #include "monger/db/query/collation/collator_factory_interface.h"
 #include "monger/db/storage/recovery_unit.h"
+#include "monger/db/views/materialized_view_maintainer.h"
 #include "monger/db/views/resolved_view.h"
 #include "monger/db/views/view.h"
 #include "monger/db/views/view_graph.h"
@@ -71,6 +72,28 @@ StatusWith<std::unique_ptr<CollatorInterface>> parseCollator(OperationContext* o
     }
     return CollatorFactoryInterface::get(opCtx->getServiceContext())->makeFromBSON(collationSpec);
 }
+
+/**
+ * Returns the document saving 'view' in the durable view catalog. If the collation is empty, it is
+ * omitted from the definition altogether.
+ */
+BSONObj makeDurableDefinition(const ViewDefinition& view) {
+    BSONObjBuilder viewDefBuilder;
+    viewDefBuilder.append("_id", view.name().ns());
+    viewDefBuilder.append("viewOn", view.viewOn().coll());
+    BSONArrayBuilder pipelineBuilder(viewDefBuilder.subarrayStart("pipeline"));
+    for (auto&& stage : view.pipeline()) {
+        pipelineBuilder.append(stage);
+    }
+    pipelineBuilder.doneFast();
+    if (view.defaultCollator()) {
+        viewDefBuilder.append("collation", view.defaultCollator()->getSpec().toBSON());
+    }
+    if (view.isMaterialized()) {
+        viewDefBuilder.append("materialized", BSON("stale" << view.isStale()));
+    }
+    return viewDefBuilder.obj();
+}
 }  // namespace
 
 ViewCatalog* ViewCatalog::get(const Database* db) {
@@ -100,6 +123,7 @@ Status ViewCatalog::_reloadIfNeeded(WithLock lk,
 
     // Need to reload, first clear our cache.
     _viewMap.clear();
+    _hasMaterializedViews.store(false);
 
     auto reloadCallback = [&](const BSONObj& view) -> Status {
         BSONObj collationSpec = view.hasField("collation") ? view["collation"].Obj() : BSONObj();
@@ -121,11 +145,16 @@ Status ViewCatalog::_reloadIfNeeded(WithLock lk,
             }
         }
 
-        _viewMap[viewName.ns()] = std::make_shared<ViewDefinition>(viewName.db(),
-                                                                   viewName.coll(),
-                                                                   view["viewOn"].str(),
-                                                                   pipeline,
-                                                                   std::move(collator.getValue()));
+        auto viewDef = std::make_shared<ViewDefinition>(viewName.db(),
+                                                        viewName.coll(),
+                                                        view["viewOn"].str(),
+                                                        pipeline,
+                                                        std::move(collator.getValue()));
+        if (auto materialized = view["materialized"]) {
+            viewDef->setMaterialized(materialized.Obj()["stale"].trueValue());
+            _hasMaterializedViews.store(true);
+        }
+        _viewMap[viewName.ns()] = std::move(viewDef);
         return Status::OK();
     };
 
@@ -165,7 +194,8 @@ Status ViewCatalog::_createOrUpdateView(WithLock lk,
                                         const NamespaceString& viewName,
                                         const NamespaceString& viewOn,
                                         const BSONArray& pipeline,
-                                        std::unique_ptr<CollatorInterface> collator) {
+                                        std::unique_ptr<CollatorInterface> collator,
+                                        bool materialized) {
     invariant(opCtx->lockState()->isDbLockedForMode(viewName.db(), MODE_IX));
     invariant(opCtx->lockState()->isCollectionLockedForMode(viewName, MODE_IX));
     invariant(opCtx->lockState()->isCollectionLockedForMode(
@@ -173,27 +203,24 @@ Status ViewCatalog::_createOrUpdateView(WithLock lk,
 
     _requireValidCatalog(lk, opCtx);
 
-    // Build the BSON definition for this view to be saved in the durable view catalog. If the
-    // collation is empty, omit it from the definition altogether.
-    BSONObjBuilder viewDefBuilder;
-    viewDefBuilder.append("_id", viewName.ns());
-    viewDefBuilder.append("viewOn", viewOn.coll());
-    viewDefBuilder.append("pipeline", pipeline);
-    if (collator) {
-        viewDefBuilder.append("collation", collator->getSpec().toBSON());
-    }
-
     BSONObj ownedPipeline = pipeline.getOwned();
     auto view = std::make_shared<ViewDefinition>(
         viewName.db(), viewName.coll(), viewOn.coll(), ownedPipeline, std::move(collator));
 
+    // The backing collection of a new or modified materialized view does not hold the results of
+    // its pipeline until it is refreshed.
+    if (materialized) {
+        view->setMaterialized(true);
+        _hasMaterializedViews.store(true);
+    }
+
     // Check that the resulting dependency graph is acyclic and within the maximum depth.
     Status graphStatus = _upsertIntoGraph(lk, opCtx, *(view.get()));
     if (!graphStatus.isOK()) {
         return graphStatus;
     }
 
-    _durable->upsert(opCtx, viewName, viewDefBuilder.obj());
+    _durable->upsert(opCtx, viewName, makeDurableDefinition(*view));
     _viewMap[viewName.ns()] = view;
     opCtx->recoveryUnit()->onRollback([this, viewName]() {
         this->_viewMap.erase(viewName.ns());
@@ -354,7 +381,8 @@ Status ViewCatalog::createView(OperationContext* opCtx,
                                const NamespaceString& viewName,
                                const NamespaceString& viewOn,
                                const BSONArray& pipeline,
-                               const BSONObj& collation) {
+                               const BSONObj& collation,
+                               bool materialized) {
 
     invariant(opCtx->lockState()->isDbLockedForMode(viewName.db(), MODE_IX));
     invariant(opCtx->lockState()->isCollectionLockedForMode(viewName, MODE_IX));
@@ -385,7 +413,7 @@ Status ViewCatalog::createView(OperationContext* opCtx,
         return collator.getStatus();
 
     return _createOrUpdateView(
-        lk, opCtx, viewName, viewOn, pipeline, std::move(collator.getValue()));
+        lk, opCtx, viewName, viewOn, pipeline, std::move(collator.getValue()), materialized);
 }
 
 Status ViewCatalog::modifyView(OperationContext* opCtx,
@@ -420,7 +448,78 @@ Status ViewCatalog::modifyView(OperationContext* opCtx,
                                viewName,
                                viewOn,
                                pipeline,
-                               CollatorInterface::cloneCollator(savedDefinition.defaultCollator()));
+                               CollatorInterface::cloneCollator(savedDefinition.defaultCollator()),
+                               savedDefinition.isMaterialized());
+}
+
+Status ViewCatalog::setMaterializedViewStale(OperationContext* opCtx,
+                                             const NamespaceString& viewName,
+                                             bool stale) {
+    invariant(opCtx->lockState()->isDbLockedForMode(viewName.db(), MODE_IX));
+    invariant(opCtx->lockState()->isCollectionLockedForMode(viewName, MODE_IX));
+    invariant(opCtx->lockState()->isCollectionLockedForMode(
+        NamespaceString(viewName.db(), NamespaceString::kSystemDotViewsCollectionName), MODE_X));
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _requireValidCatalog(lk, opCtx);
+
+    auto viewPtr =
+        _lookup(lk, opCtx, viewName.ns(), ViewCatalogLookupBehavior::kValidateDurableViews);
+    if (!viewPtr || !viewPtr->isMaterialized()) {
+        return {ErrorCodes::NamespaceNotFound,
+                str::stream() << "cannot find materialized view " << viewName.ns()};
+    }
+
+    // The durable definition is written even if the view is already stale in memory, since
+    // noteMaterializedViewStale() only changes the latter.
+    auto view = std::make_shared<ViewDefinition>(*viewPtr);
+    view->setMaterialized(stale);
+    _durable->upsert(opCtx, viewName, makeDurableDefinition(*view));
+    _viewMap[viewName.ns()] = view;
+    opCtx->recoveryUnit()->onRollback(
+        [this, viewName, viewPtr]() { this->_viewMap[viewName.ns()] = viewPtr; });
+
+    // We may get invalidated, but we're exclusively locked, so the change must be ours.
+    opCtx->recoveryUnit()->onCommit(
+        [this](boost::optional<Timestamp>) { this->_valid.store(true); });
+    return Status::OK();
+}
+
+void ViewCatalog::noteMaterializedViewStale(const NamespaceString& viewName) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    auto it = _viewMap.find(viewName.ns());
+    if (it == _viewMap.end() || !it->second->isMaterialized() || it->second->isStale()) {
+        return;
+    }
+
+    auto view = std::make_shared<ViewDefinition>(*it->second);
+    view->setMaterialized(true);
+    it->second = std::move(view);
+}
+
+std::vector<std::shared_ptr<ViewDefinition>> ViewCatalog::lookupMaterializedViewsOn(
+    OperationContext* opCtx, const NamespaceString& nss) {
+    if (_valid.load() && !_hasMaterializedViews.load()) {
+        return {};
+    }
+
+    Lock::CollectionLock systemViewsLock(
+        opCtx,
+        NamespaceString(_durable->getName(), NamespaceString::kSystemDotViewsCollectionName),
+        MODE_IS);
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+
+    std::vector<std::shared_ptr<ViewDefinition>> views;
+    // A write must not fail because of an invalid view definition. The error has been logged.
+    if (!_reloadIfNeeded(lk, opCtx, ViewCatalogLookupBehavior::kValidateDurableViews).isOK()) {
+        return views;
+    }
+    for (auto&& view : _viewMap) {
+        if (view.second->isMaterialized() && view.second->viewOn() == nss) {
+            views.push_back(view.second);
+        }
+    }
+    return views;
 }
 
 Status ViewCatalog::dropView(OperationContext* opCtx, const NamespaceString& viewName) {
@@ -555,14 +654,23 @@ StatusWith<ResolvedView> ViewCatalog::resolveView(OperationContext* opCtx,
                      collation ? std::move(collation.get()) : CollationSpec::kSimpleSpec});
             }
 
-            resolvedNss = &view->viewOn();
+            // A materialized view which is not stale is read from its backing collection instead
+            // of running its pipeline.
+            const bool readFromBackingNss = view->isMaterialized() && !view->isStale();
+            std::vector<BSONObj> readPipeline;
+            if (readFromBackingNss) {
+                readPipeline = MaterializedViewMaintainer::makeReadPipeline(view->pipeline());
+            }
+
+            resolvedNss = readFromBackingNss ? &view->backingNss() : &view->viewOn();
             if (!collation) {
                 collation = view->defaultCollator() ? view->defaultCollator()->getSpec().toBSON()
                                                     : CollationSpec::kSimpleSpec;
             }
 
             // Prepend the underlying view's pipeline to the current working pipeline.
-            const std::vector<BSONObj>& toPrepend = view->pipeline();
+            const std::vector<BSONObj>& toPrepend =
+                readFromBackingNss ? readPipeline : view->pipeline();
             resolvedPipeline.insert(resolvedPipeline.begin(), toPrepend.begin(), toPrepend.end());
 
             // If the first stage is a $collStats, then we return early with the viewOn namespace.
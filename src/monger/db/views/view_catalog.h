@@ -87,13 +87,18 @@ public:
      * database's catalog, so the check for an existing collection with the same name must be done
      * before calling createView.
      *
+     * If 'materialized' is true, the results of the view are stored in the collection
+     * ViewDefinition::makeBackingNss(viewName), which the caller must create. The view is stale
+     * until it is first refreshed.
+     *
      * Must be in WriteUnitOfWork. View creation rolls back if the unit of work aborts.
      */
     Status createView(OperationContext* opCtx,
                       const NamespaceString& viewName,
                       const NamespaceString& viewOn,
                       const BSONArray& pipeline,
-                      const BSONObj& collation);
+                      const BSONObj& collation,
+                      bool materialized = false);
 
     /**
      * Drop the view named 'viewName'.
@@ -103,7 +108,8 @@ public:
     Status dropView(OperationContext* opCtx, const NamespaceString& viewName);
 
     /**
-     * Modify the view named 'viewName' to have the new 'viewOn' and 'pipeline'.
+     * Modify the view named 'viewName' to have the new 'viewOn' and 'pipeline'. A materialized view
+     * becomes stale.
      *
      * Must be in WriteUnitOfWork. The modification rolls back if the unit of work aborts.
      */
@@ -112,6 +118,33 @@ public:
                       const NamespaceString& viewOn,
                       const BSONArray& pipeline);
 
+    /**
+     * Record whether the backing collection of the materialized view 'viewName' is stale. Requires
+     * the same locks as createView.
+     *
+     * Must be in WriteUnitOfWork. The change rolls back if the unit of work aborts.
+     */
+    Status setMaterializedViewStale(OperationContext* opCtx,
+                                    const NamespaceString& viewName,
+                                    bool stale);
+
+    /**
+     * Marks the materialized view 'viewName' stale in memory only, so that it is read through its
+     * pipeline from now on. The caller records it with setMaterializedViewStale() afterwards. Does
+     * nothing if there is no such view.
+     *
+     * Takes no database or collection locks, so that it may be called once a unit of work has
+     * committed.
+     */
+    void noteMaterializedViewStale(const NamespaceString& viewName);
+
+    /**
+     * Returns the materialized views defined directly on the collection 'nss'. This is called for
+     * every write, so it takes no locks when the database has no materialized views.
+     */
+    std::vector<std::shared_ptr<ViewDefinition>> lookupMaterializedViewsOn(
+        OperationContext* opCtx, const NamespaceString& nss);
+
     /**
      * Look up the 'nss' in the view catalog, returning a shared pointer to a View definition, or
      * nullptr if it doesn't exist.
@@ -128,7 +161,8 @@ public:
     /**
      * Resolve the views on 'nss', transforming the pipeline appropriately. This function returns a
      * fully-resolved view definition containing the backing namespace, the resolved pipeline and
-     * the collation to use for the operation.
+     * the collation to use for the operation. Resolution stops at a materialized view which is not
+     * stale, which is read from its backing collection.
      */
     StatusWith<ResolvedView> resolveView(OperationContext* opCtx, const NamespaceString& nss);
 
@@ -156,7 +190,8 @@ private:
                                const NamespaceString& viewName,
                                const NamespaceString& viewOn,
                                const BSONArray& pipeline,
-                               std::unique_ptr<CollatorInterface> collator);
+                               std::unique_ptr<CollatorInterface> collator,
+                               bool materialized);
     /**
      * Parses the view definition pipeline, attempts to upsert into the view graph, and refreshes
      * the graph if necessary. Returns an error status if the resulting graph would be invalid.
@@ -197,6 +232,8 @@ private:
     ViewMap _viewMap;
     std::unique_ptr<DurableViewCatalog> _durable;
     AtomicWord<bool> _valid;
+    // False only if a reload found no materialized view and none has been created since.
+    AtomicWord<bool> _hasMaterializedViews;
     ViewGraph _viewGraph;
     bool _viewGraphNeedsRefresh = true;  // Defers initializing the graph until the first insert.
 };
@@ -582,6 +582,77 @@ TEST_F(ViewCatalogFixture, ResolveViewCorrectlyExtractsDefaultCollation) {
                       expectedCollation.getValue()->getSpec().toBSON());
 }
 
+TEST_F(ViewCatalogFixture, ResolveMaterializedViewReadsBackingCollectionOnceRefreshed) {
+    const NamespaceString materializedView("db.totals");
+    const NamespaceString outerView("db.bigTotals");
+    const NamespaceString viewOn("db.coll");
+    BSONArrayBuilder groupPipeline;
+    BSONArrayBuilder matchPipeline;
+
+    groupPipeline << BSON("$group" << BSON("_id"
+                                           << "$k"
+                                           << "total"
+                                           << BSON("$sum"
+                                                   << "$v")));
+    matchPipeline << BSON("$match" << BSON("total" << BSON("$gt" << 10)));
+
+    ASSERT_OK(viewCatalog.createView(
+        opCtx.get(), materializedView, viewOn, groupPipeline.arr(), emptyCollation, true));
+    ASSERT_OK(
+        viewCatalog.createView(opCtx.get(), outerView, materializedView, matchPipeline.arr(), {}));
+    ASSERT_EQ(viewCatalog.lookupMaterializedViewsOn(opCtx.get(), viewOn).size(), 1U);
+    ASSERT(viewCatalog.lookupMaterializedViewsOn(opCtx.get(), materializedView).empty());
+
+    // A stale view is resolved through its pipeline.
+    auto resolvedView = uassertStatusOK(viewCatalog.resolveView(opCtx.get(), outerView));
+    ASSERT_EQ(resolvedView.getNamespace(), viewOn);
+    ASSERT_EQ(resolvedView.getPipeline().size(), 2U);
+
+    ASSERT_OK(viewCatalog.setMaterializedViewStale(opCtx.get(), materializedView, false));
+    resolvedView = uassertStatusOK(viewCatalog.resolveView(opCtx.get(), outerView));
+    ASSERT_EQ(resolvedView.getNamespace(), NamespaceString("db.system.materialized.totals"));
+
+    std::vector<BSONObj> expected = {BSON("$project" << BSON("__materializedViewCount" << 0)),
+                                     BSON("$match" << BSON("total" << BSON("$gt" << 10)))};
+    std::vector<BSONObj> result = resolvedView.getPipeline();
+    ASSERT_EQ(expected.size(), result.size());
+    for (uint32_t i = 0; i < expected.size(); i++) {
+        ASSERT_BSONOBJ_EQ(expected[i], result[i]);
+    }
+}
+
+TEST_F(ViewCatalogFixture, SetStaleRequiresMaterializedView) {
+    const NamespaceString viewName("db.view");
+    const NamespaceString viewOn("db.coll");
+
+    ASSERT_OK(viewCatalog.createView(opCtx.get(), viewName, viewOn, emptyPipeline, emptyCollation));
+    ASSERT_EQ(ErrorCodes::NamespaceNotFound,
+              viewCatalog.setMaterializedViewStale(opCtx.get(), viewName, false));
+    ASSERT(viewCatalog.lookupMaterializedViewsOn(opCtx.get(), viewOn).empty());
+}
+
+TEST_F(ViewCatalogFixture, NoteStaleChangesOnlyTheInMemoryDefinitionUntilItIsRecorded) {
+    const NamespaceString viewName("db.totals");
+    const NamespaceString viewOn("db.coll");
+    BSONArrayBuilder pipeline;
+    pipeline << BSON("$group" << BSON("_id"
+                                      << "$k"));
+
+    ASSERT_OK(viewCatalog.createView(
+        opCtx.get(), viewName, viewOn, pipeline.arr(), emptyCollation, true));
+    ASSERT_OK(viewCatalog.setMaterializedViewStale(opCtx.get(), viewName, false));
+    const int upsertCount = durableViewCatalog->getUpsertCount();
+
+    viewCatalog.noteMaterializedViewStale(viewName);
+    ASSERT(viewCatalog.lookup(opCtx.get(), viewName.ns())->isStale());
+    ASSERT_EQ(upsertCount, durableViewCatalog->getUpsertCount());
+
+    // Recording the view as stale writes its durable definition, although it already is in memory.
+    ASSERT_OK(viewCatalog.setMaterializedViewStale(opCtx.get(), viewName, true));
+    ASSERT(viewCatalog.lookup(opCtx.get(), viewName.ns())->isStale());
+    ASSERT_EQ(upsertCount + 1, durableViewCatalog->getUpsertCount());
+}
+
 TEST_F(ViewCatalogFixture, InvalidateThenReload) {
     const NamespaceString viewName("db.view");
     const NamespaceString viewOn("db.coll");
@@ -89,6 +89,23 @@ TEST(ViewDefinitionTest, CopyAssignmentOperatorProperlyClonesAllFields) {
                                              copiedView.defaultCollator()));
 }
 
+TEST(ViewDefinitionTest, CopyPreservesMaterializedState) {
+    ViewDefinition originalView(
+        viewNss.db(), viewNss.coll(), backingNss.coll(), samplePipeline, nullptr);
+    ASSERT_FALSE(originalView.isMaterialized());
+
+    originalView.setMaterialized(true);
+    ViewDefinition copiedView(originalView);
+    ASSERT_TRUE(copiedView.isMaterialized());
+    ASSERT_TRUE(copiedView.isStale());
+    ASSERT_EQ(copiedView.backingNss(), NamespaceString("testdb.system.materialized.testview"));
+    ASSERT_TRUE(copiedView.backingNss().isMaterializedViewBackingCollection());
+
+    copiedView.setMaterialized(false);
+    ASSERT_FALSE(copiedView.isStale());
+    ASSERT_TRUE(originalView.isStale());
+}
+
 DEATH_TEST(ViewDefinitionTest,
            SetViewOnFailsIfNewViewOnNotInSameDatabaseAsView,
            "Invariant failure _viewNss.db() == viewOnNss.db()") {
@@ -37,6 +37,7 @@
 #include "monger/db/client.h"
 #include "monger/db/db_raii.h"
 #include "monger/db/dbdirectclient.h"
+#include "monger/db/index/index_access_method_gen.h"
 #include "monger/db/index/index_descriptor.h"
 #include "monger/db/service_context.h"
 #include "monger/db/storage/storage_engine_init.h"
@@ -324,6 +325,47 @@ Status IndexBuildBase::createIndex(const std::string& dbname, const BSONObj& ind
     return Status::OK();
 }
 
+/** An index build which generates keys on the worker pool produces a complete, sorted index. */
+class InsertBuildParallelKeyGeneration : public IndexBuildBase {
+public:
+    void run() {
+        const int numDocs = 5000;
+        for (int i = 0; i < numDocs; ++i) {
+            // Every tenth document makes the index multikey on 'b'.
+            BSONObj doc = i % 10 ? BSON("_id" << i << "a" << (i * 7919) % numDocs << "b" << i)
+                                 : BSON("_id" << i << "a" << (i * 7919) % numDocs << "b"
+                                              << BSON_ARRAY(i << -i));
+            _client.insert(_ns, doc);
+        }
+
+        const int originalThreads = maxIndexBuildKeyGenerationThreads.load();
+        maxIndexBuildKeyGenerationThreads.store(4);
+        ON_BLOCK_EXIT([&] { maxIndexBuildKeyGenerationThreads.store(originalThreads); });
+
+        ASSERT_OK(createIndex("unittest",
+                              BSON("name"
+                                   << "a_1_b_1"
+                                   << "ns"
+                                   << _ns
+                                   << "key"
+                                   << BSON("a" << 1 << "b" << 1)
+                                   << "v"
+                                   << static_cast<int>(kIndexVersion))));
+
+        auto desc = collection()->getIndexCatalog()->findIndexByName(&_opCtx, "a_1_b_1");
+        ASSERT(desc);
+        ASSERT_TRUE(collection()->getIndexCatalog()->getEntry(desc)->isMultikey(&_opCtx));
+
+        auto cursor = _client.query(_nss, Query().hint(BSON("a" << 1 << "b" << 1)));
+        int expected = 0;
+        while (cursor->more()) {
+            ASSERT_EQ(cursor->next()["a"].numberInt(), expected);
+            ++expected;
+        }
+        ASSERT_EQ(expected, numDocs);
+    }
+};
+
 /**
  * Fixture class that has a basic compound index.
  */
@@ -732,6 +774,7 @@ public:
         }
         add<InsertBuildIndexInterrupt>();
         add<InsertBuildIdIndexInterrupt>();
+        add<InsertBuildParallelKeyGeneration>();
         add<SameSpecDifferentOption>();
         add<SameSpecSameOptions>();
         add<DifferentSpecSameName>();
@@ -52,8 +52,11 @@
 #include "monger/db/pipeline/expression_context_for_test.h"
 #include "monger/db/pipeline/pipeline.h"
 #include "monger/db/query/plan_executor.h"
+#include "monger/db/query/plan_yield_policy.h"
+#include "monger/db/query/query_knobs_gen.h"
 #include "monger/db/query/query_solution.h"
 #include "monger/dbtests/dbtests.h"
+#include "monger/util/clock_source_mock.h"
 
 namespace monger {
 namespace {
@@ -299,6 +302,23 @@ TEST_F(PlanExecutorTest, ShouldReportErrorIfKilledDuringYield) {
     ASSERT_EQ(ErrorCodes::QueryPlanKilled, WorkingSetCommon::getMemberObjectStatus(resultObj));
 }
 
+TEST(PlanYieldPolicyTest, CountsEveryUnitOfWorkOfABatchTowardsTheNextCheck) {
+    ClockSourceMock clock;
+    PlanYieldPolicy policy(PlanExecutor::INTERRUPT_ONLY, &clock);
+    const int iterations = internalQueryExecYieldIterations.load();
+    ASSERT_GT(iterations, 1);
+
+    policy.recordWorks(iterations - 1);
+    ASSERT_FALSE(policy.shouldYieldOrInterrupt());
+    ASSERT_TRUE(policy.shouldYieldOrInterrupt());
+
+    // Without a batch, each check counts as a single unit of work.
+    for (int i = 1; i < iterations; ++i) {
+        ASSERT_FALSE(policy.shouldYieldOrInterrupt());
+    }
+    ASSERT_TRUE(policy.shouldYieldOrInterrupt());
+}
+
 class PlanExecutorSnapshotTest : public PlanExecutorTest {
 protected:
     void setupCollection() {
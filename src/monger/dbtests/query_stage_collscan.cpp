@@ -34,6 +34,7 @@
 #include "monger/platform/basic.h"
 
 #include <memory>
+#include <set>
 
 #include "monger/client/dbclient_cursor.h"
 #include "monger/db/catalog/collection.h"
@@ -42,15 +43,18 @@
 #include "monger/db/db_raii.h"
 #include "monger/db/dbdirectclient.h"
 #include "monger/db/exec/collection_scan.h"
+#include "monger/db/exec/parallel_collection_scan.h"
 #include "monger/db/exec/plan_stage.h"
 #include "monger/db/json.h"
 #include "monger/db/matcher/expression_parser.h"
 #include "monger/db/namespace_string.h"
 #include "monger/db/query/plan_executor.h"
+#include "monger/db/query/query_knobs_gen.h"
 #include "monger/db/storage/record_store.h"
 #include "monger/dbtests/dbtests.h"
 #include "monger/unittest/unittest.h"
 #include "monger/util/fail_point_service.h"
+#include "monger/util/scopeguard.h"
 
 namespace query_stage_collection_scan {
 
@@ -345,4 +349,94 @@ TEST_F(QueryStageCollectionScanTest, QueryStageCollscanDeleteUpcomingObjectBackw
     ASSERT_EQUALS(numObj(), count);
 }
 
+// Scan in batches and check that every member of a batch still holds the right document once the
+// scan has moved past it.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanBatchedObjectsInOrder) {
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    auto collection = ctx.getCollection();
+
+    CollectionScanParams params;
+    params.direction = CollectionScanParams::FORWARD;
+    params.tailable = false;
+
+    WorkingSet ws;
+    unique_ptr<PlanStage> scan(new CollectionScan(&_opCtx, collection, params, &ws, nullptr));
+
+    int count = 0;
+    vector<WorkingSetID> results;
+    while (!scan->isEOF()) {
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        results.clear();
+        PlanStage::StageState state = scan->workBatch(7, &results, &id);
+        ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+        ASSERT_LTE(results.size(), 7U);
+
+        for (size_t i = 0; i < results.size(); ++i) {
+            WorkingSetMember* member = ws.get(results[i]);
+            if (i + 1 < results.size()) {
+                ASSERT_TRUE(member->hasOwnedObj());
+            }
+            ASSERT_EQUALS(count, member->obj.value()["foo"].numberInt());
+            ws.free(results[i]);
+            ++count;
+        }
+    }
+
+    ASSERT_EQUALS(numObj(), count);
+    ASSERT_EQUALS(static_cast<size_t>(numObj()), scan->getCommonStats()->advanced);
+}
+
+// A parallel scan returns each matching document exactly once, in any order, and its per-partition
+// statistics add up to the totals.
+TEST_F(QueryStageCollectionScanTest, QueryStageParallelCollscanReturnsEachMatchOnce) {
+    const int originalThreads = internalQueryParallelCollectionScanThreads.load();
+    internalQueryParallelCollectionScanThreads.store(4);
+    ON_BLOCK_EXIT([&] { internalQueryParallelCollectionScanThreads.store(originalThreads); });
+
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    auto collection = ctx.getCollection();
+
+    const boost::intrusive_ptr<ExpressionContext> expCtx(new ExpressionContext(&_opCtx, nullptr));
+    auto statusWithMatcher =
+        MatchExpressionParser::parse(BSON("foo" << BSON("$gte" << 10)), expCtx);
+    ASSERT_OK(statusWithMatcher.getStatus());
+    unique_ptr<MatchExpression> filterExpr = std::move(statusWithMatcher.getValue());
+
+    WorkingSet ws;
+    unique_ptr<PlanStage> scan(
+        new ParallelCollectionScan(&_opCtx, collection, &ws, filterExpr.get()));
+
+    std::set<int> seen;
+    PlanStage::StageState state = PlanStage::NEED_TIME;
+    while (PlanStage::IS_EOF != state) {
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        state = scan->work(&id);
+        ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+        if (PlanStage::ADVANCED == state) {
+            WorkingSetMember* member = ws.get(id);
+            ASSERT_TRUE(member->hasRecordId());
+            ASSERT_TRUE(seen.insert(member->obj.value()["foo"].numberInt()).second);
+            ws.free(id);
+        }
+    }
+
+    ASSERT_EQUALS(static_cast<size_t>(numObj() - 10), seen.size());
+    ASSERT_EQUALS(10, *seen.begin());
+    ASSERT_EQUALS(numObj() - 1, *seen.rbegin());
+
+    auto stats = static_cast<const ParallelCollectionScanStats*>(scan->getSpecificStats());
+    ASSERT_EQUALS(static_cast<size_t>(numObj()), stats->docsTested);
+    ASSERT_GTE(stats->partitions.size(), 1U);
+    ASSERT_LTE(stats->partitions.size(), 4U);
+
+    size_t docsTested = 0;
+    size_t nReturned = 0;
+    for (const auto& partition : stats->partitions) {
+        docsTested += partition.docsTested;
+        nReturned += partition.nReturned;
+    }
+    ASSERT_EQUALS(stats->docsTested, docsTested);
+    ASSERT_EQUALS(seen.size(), nReturned);
+}
+
 }  // namespace query_stage_collection_scan
@@ -577,6 +577,82 @@ public:
     }
 };
 
+//
+// Check that keys are counted over bounds made of several intervals
+//
+class QueryStageCountScanMultipleIntervals : public CountBase {
+public:
+    void run() {
+        dbtests::WriteContextForTests ctx(&_opCtx, ns());
+
+        // Insert some docs
+        for (int i = 0; i < 10; ++i) {
+            insert(BSON("a" << i));
+        }
+        insert(BSON("a" << BSON_ARRAY(1 << 4)));
+
+        // Add an index
+        addIndex(BSON("a" << 1));
+
+        // Set up the count stage over the intervals [1, 1] and [4, 6)
+        auto params = makeCountScanParams(&_opCtx, getIndex(ctx.db(), BSON("a" << 1)));
+        OrderedIntervalList oil("a");
+        oil.intervals.push_back(Interval(BSON("" << 1 << "" << 1), true, true));
+        oil.intervals.push_back(Interval(BSON("" << 4 << "" << 6), true, false));
+        params.bounds.fields.push_back(oil);
+
+        WorkingSet ws;
+        CountScan count(&_opCtx, params, &ws);
+
+        // The array is counted once, although it has a key in each interval.
+        int numCounted = runCount(&count);
+        ASSERT_EQUALS(4, numCounted);
+    }
+};
+
+//
+// Check that counting a range on one field and a point on the next seeks past the keys which are
+// not in bounds
+//
+class QueryStageCountScanSeeksToNextPrefix : public CountBase {
+public:
+    void run() {
+        dbtests::WriteContextForTests ctx(&_opCtx, ns());
+
+        // Insert some docs
+        for (int i = 0; i < 10; ++i) {
+            for (int j = 0; j < 10; ++j) {
+                insert(BSON("a" << i << "b" << j));
+            }
+        }
+
+        // Add an index
+        addIndex(BSON("a" << 1 << "b" << 1));
+
+        // Set up the count stage for {a: {$gte: 2, $lte: 7}, b: 5}
+        auto params =
+            makeCountScanParams(&_opCtx, getIndex(ctx.db(), BSON("a" << 1 << "b" << 1)));
+        OrderedIntervalList oilA("a");
+        oilA.intervals.push_back(Interval(BSON("" << 2 << "" << 7), true, true));
+        OrderedIntervalList oilB("b");
+        oilB.intervals.push_back(Interval(BSON("" << 5 << "" << 5), true, true));
+        params.bounds.fields.push_back(oilA);
+        params.bounds.fields.push_back(oilB);
+
+        WorkingSet ws;
+        CountScan count(&_opCtx, params, &ws);
+
+        int numCounted = runCount(&count);
+        ASSERT_EQUALS(6, numCounted);
+
+        // Each value of 'a' in bounds takes a seek to its key with b == 5, and examines that key
+        // and the key after it.
+        auto stats = static_cast<const CountScanStats*>(count.getSpecificStats());
+        ASSERT_LTE(stats->keysExamined, 13U);
+        ASSERT_GTE(stats->seeks, 6U);
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("query_stage_count_scan") {}
@@ -592,6 +668,8 @@ public:
         add<QueryStageCountScanDeleteDuringYield>();
         add<QueryStageCountScanInsertNewDocsDuringYield>();
         add<QueryStageCountScanUnusedKeys>();
+        add<QueryStageCountScanMultipleIntervals>();
+        add<QueryStageCountScanSeeksToNextPrefix>();
     }
 };
 
@@ -35,6 +35,7 @@
 #include "monger/platform/basic.h"
 
 #include <memory>
+#include <vector>
 
 #include "monger/client/dbclient_cursor.h"
 #include "monger/db/client.h"
@@ -88,6 +89,23 @@ int countResults(PlanStage* stage) {
     return count;
 }
 
+int countResultsBatched(PlanStage* stage, WorkingSet* ws, size_t batchSize) {
+    int count = 0;
+    std::vector<WorkingSetID> results;
+    while (!stage->isEOF()) {
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        results.clear();
+        PlanStage::StageState status = stage->workBatch(batchSize, &results, &id);
+        ASSERT_LTE(results.size(), batchSize);
+        ASSERT_NOT_EQUALS(PlanStage::FAILURE, status);
+        for (auto&& result : results) {
+            ws->free(result);
+        }
+        count += results.size();
+    }
+    return count;
+}
+
 //
 // Insert 50 objects.  Filter/skip 0, 1, 2, ..., 100 objects and expect the right # of results.
 //
@@ -112,12 +130,50 @@ protected:
     OperationContext* const _opCtx = _uniqOpCtx.get();
 };
 
+//
+// Same as above, but drive the stages with workBatch() and check that the work counters match
+// those obtained by calling work() one result at a time.
+//
+class QueryStageLimitSkipBatchedTest : public QueryStageLimitSkipBasicTest {
+public:
+    void run() {
+        for (size_t batchSize : {1, 3, 64}) {
+            for (int i = 0; i < 2 * N; ++i) {
+                WorkingSet ws;
+
+                unique_ptr<PlanStage> skip =
+                    std::make_unique<SkipStage>(_opCtx, i, &ws, getMS(_opCtx, &ws));
+                ASSERT_EQUALS(max(0, N - i), countResultsBatched(skip.get(), &ws, batchSize));
+
+                unique_ptr<PlanStage> skipUnbatched =
+                    std::make_unique<SkipStage>(_opCtx, i, &ws, getMS(_opCtx, &ws));
+                countResults(skipUnbatched.get());
+                assertSameWorkCounters(skip.get(), skipUnbatched.get());
+
+                unique_ptr<PlanStage> limit =
+                    std::make_unique<LimitStage>(_opCtx, i, &ws, getMS(_opCtx, &ws));
+                ASSERT_EQUALS(min(N, i), countResultsBatched(limit.get(), &ws, batchSize));
+            }
+        }
+    }
+
+private:
+    static void assertSameWorkCounters(PlanStage* batched, PlanStage* unbatched) {
+        const CommonStats* batchedStats = batched->getCommonStats();
+        const CommonStats* unbatchedStats = unbatched->getCommonStats();
+        ASSERT_EQUALS(unbatchedStats->advanced, batchedStats->advanced);
+        ASSERT_EQUALS(unbatchedStats->needTime, batchedStats->needTime);
+        ASSERT_EQUALS(unbatchedStats->needYield, batchedStats->needYield);
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("query_stage_limit_skip") {}
 
     void setupTests() {
         add<QueryStageLimitSkipBasicTest>();
+        add<QueryStageLimitSkipBatchedTest>();
     }
 };
 
@@ -44,8 +44,9 @@ ElapsedTracker::ElapsedTracker(ClockSource* cs,
       _pings(0),
       _last(cs->now()) {}
 
-bool ElapsedTracker::intervalHasElapsed() {
-    if (++_pings >= _hitsBetweenMarks) {
+bool ElapsedTracker::intervalHasElapsed(int32_t hits) {
+    _pings += hits;
+    if (_pings >= _hitsBetweenMarks) {
         _pings = 0;
         _last = _clock->now();
         return true;
@@ -46,7 +46,14 @@ public:
      * Call this for every iteration.
      * @return true if one of the triggers has gone off.
      */
-    bool intervalHasElapsed();
+    bool intervalHasElapsed() {
+        return intervalHasElapsed(1);
+    }
+
+    /**
+     * Like intervalHasElapsed(), but counts 'hits' iterations at once.
+     */
+    bool intervalHasElapsed(int32_t hits);
 
     void resetLastTime();
 